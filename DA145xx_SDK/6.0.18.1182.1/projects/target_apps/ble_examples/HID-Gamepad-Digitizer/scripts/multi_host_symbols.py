@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""
+DA14531 ROM symbol files of the CFG_MULTI_HOST build of the HID example.
+
+CFG_MULTI_HOST raises APP_EASY_MAX_ACTIVE_CONNECTION and defines
+__EXCLUDE_ROM_APP_TASK__, so app.c, app_task.c and app_entry_point.c are compiled from
+the SDK instead of being taken from the ROM. The ROM symbols of these files must then
+not be given to the linker, or the ROM versions, built for a single connection, would
+be linked. They are the sections of the SDK symbol files whose heading names
+__EXCLUDE_ROM_APP_TASK__.
+
+This script copies sdk/common_project_files/misc/da14531_symbols.txt (Keil) and
+da14531_symbols.lds (GCC) to project_environment/da14531_multi_host_symbols.txt and .lds
+with these sections commented out. The shared files are left as they are for the other
+projects. Point the DA14531 target to the project file when CFG_MULTI_HOST is defined:
+in Keil, Options for Target, Linker, Misc controls, replace
+..\\sdk\\common_project_files\\misc\\da14531_symbols.txt with
+project_environment\\da14531_multi_host_symbols.txt; for GCC, link with
+da14531_multi_host_symbols.lds instead of da14531_symbols.lds.
+
+Run it again after an SDK update. --check fails if the files of the project are not the
+ones the SDK files give.
+
+    multi_host_symbols.py
+    multi_host_symbols.py --check
+"""
+
+import argparse
+import os
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+PROJECT = os.path.normpath(os.path.join(HERE, ".."))
+SDK = os.path.normpath(os.path.join(PROJECT, "..", "..", "..", ".."))
+MISC = os.path.join(SDK, "sdk", "common_project_files", "misc")
+OUT = os.path.join(PROJECT, "project_environment")
+
+MARKER = "__EXCLUDE_ROM_APP_TASK__"
+
+# Comment syntax of each symbol file: line comment prefix and suffix
+FORMATS = {
+    ".txt": ("; ", ""),
+    ".lds": ("/* ", " */"),
+}
+
+
+def is_heading(line, ext):
+    stripped = line.strip()
+    return stripped.startswith(";") if ext == ".txt" else stripped.startswith("/*")
+
+
+def exclude(text, ext):
+    """Comments out the symbols of the sections controlled by __EXCLUDE_ROM_APP_TASK__.
+
+    Returns the new text and the names of the symbols commented out.
+    """
+    prefix, suffix = FORMATS[ext]
+    out = []
+    names = []
+    excluded = False
+    for line in text.splitlines(True):
+        body = line.rstrip("\r\n")
+        eol = line[len(body):]
+        if not body.strip():
+            excluded = False
+        elif is_heading(body, ext):
+            excluded = MARKER in body
+        elif excluded:
+            # Keil: "0x07f234c1 T app_db_init", GCC: "app_db_init = 0x07f234c1;"
+            fields = body.split()
+            names.append(fields[2] if ext == ".txt" else fields[0])
+            body = prefix + body.rstrip() + suffix
+        out.append(body + eol)
+    return "".join(out), names
+
+
+def generate(ext):
+    src = os.path.join(MISC, "da14531_symbols" + ext)
+    with open(src, newline="") as f:
+        text, names = exclude(f.read(), ext)
+    header = ("%sGenerated by scripts/multi_host_symbols.py from da14531_symbols%s for CFG_MULTI_HOST,%s\n"
+              "%sthe symbols of the sections controlled by %s are commented out.%s\n\n"
+              % (FORMATS[ext][0], ext, FORMATS[ext][1], FORMATS[ext][0], MARKER, FORMATS[ext][1]))
+    return header + text, names
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("--check", action="store_true", help="only compare with the files of the project")
+    args = parser.parse_args()
+
+    stale = []
+    for ext in sorted(FORMATS):
+        text, names = generate(ext)
+        if not names:
+            sys.exit("no section controlled by %s in da14531_symbols%s" % (MARKER, ext))
+        out = os.path.join(OUT, "da14531_multi_host_symbols" + ext)
+        if args.check:
+            try:
+                with open(out, newline="") as f:
+                    current = f.read()
+            except IOError:
+                current = None
+            if current != text:
+                stale.append(out)
+            continue
+        with open(out, "w", newline="") as f:
+            f.write(text)
+        print("%s: %d symbols excluded (%s)" % (os.path.relpath(out, PROJECT), len(names), ", ".join(names)))
+
+    for out in stale:
+        print("out of date: %s, run scripts/multi_host_symbols.py" % os.path.relpath(out, PROJECT))
+    return 1 if stale else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,807 @@
+#!/usr/bin/env python3
+"""
+Retained RAM report of a DA14531 or DA14585/586 build, from the linker map (armlink or
+GNU ld) and the image (.axf of Keil, .elf of the GCC build).
+
+In extended sleep only the RAM blocks selected by CFG_RETAIN_RAM_<n>_BLOCK keep their
+content, and each retained block adds to the sleep current. A block must be retained if
+it holds code or initialized data (the code runs from RAM), the stack, the retained data
+(retention_mem_area0, retention_mem_area_uninit), the retained heaps, or zero initialized
+data that is used after a wake-up. The last block holds the BLE state and the ROM data
+and is always retained. The non retained heap, the production test and the hibernation
+areas may be lost.
+
+The report lists:
+
+    regions     the execution regions or output sections and their class
+    blocks      the bytes of each RAM block that must be retained, and what they are
+    modules     retained and zero initialized bytes per object file
+    variables   the largest retained variables, and the flagged ones:
+                  init-only     only referred to by functions that do not run after a
+                                wake-up, the value is not needed in sleep
+                  unreferenced  no function or table of the image refers to it
+    config      the CFG_RETAIN_RAM_<n>_BLOCK and CFG_RET_DATA_SIZE the build needs
+
+The references come from the Thumb code of the image: a function refers to a variable
+when its literal pool holds an address inside it. The functions that run after a wake-up
+are the ones reached through BL or B from the interrupt handlers of the vector table, from
+the scheduler loop (--root), or from any function whose address is stored in the image,
+callbacks and kernel handler tables, unless its name matches --init-re. This is a static
+approximation: a variable only reached through a pointer computed at run time, or from
+the ROM code, looks unreferenced. Without --elf the variables are not analysed and all
+the zero initialized data counts as needed.
+
+--json writes the report, --baseline compares it with a previous one and fails when the
+retained data or the number of retained blocks grows by more than --allow bytes.
+
+    retention_map.py out_DA14531/Objects/ble_hid_gamepad_531.map --elf out_DA14531/Objects/ble_hid_gamepad_531.axf
+    retention_map.py build/app.map --elf build/app.elf --chip 585
+    retention_map.py app.map --elf app.axf --json ret.json --baseline ret_master.json --allow 64
+    retention_map.py --self-test
+"""
+
+import argparse
+import bisect
+import json
+import os
+import re
+import struct
+import sys
+import tempfile
+
+CHIPS = {
+    "531": [("RAM1", 0x07FC0000, 0x4000), ("RAM2", 0x07FC4000, 0x3000), ("RAM3", 0x07FC7000, 0x5000)],
+    "585": [("RAM1", 0x07FC0000, 0x8000), ("RAM2", 0x07FC8000, 0x4000), ("RAM3", 0x07FCC000, 0x4000),
+            ("RAM4", 0x07FD0000, 0x8000)],
+}
+
+DEFAULT_ROOTS = ["rwip_schedule", "schedule_while_ble_on", "arch_goto_sleep", "arch_resume_from_sleep",
+                 "app_asynch_trm", "app_asynch_proc", "app_asynch_sleep_proc", "app_sleep_prepare_proc",
+                 "app_sleep_exit_proc", "ke_schedule"]
+DEFAULT_INIT_RE = r"(^|_)(init|reset|create_db|setup)(_|$)|^Reset_Handler$|^main$|^SystemInit$|^__main$"
+
+# Classes of the regions and input sections
+RETAINED = "retained"   # retention_mem_area*, retained heaps
+CODE = "code"           # code, constants and initialized data
+STACK = "stack"
+ZI = "zi"               # zero initialized data, needed if used after a wake-up
+FREE = "free"           # may be lost in sleep
+
+RETAINED_SECTIONS = ("retention_mem_area0", "retention_mem_area_uninit", "heap_env_area", "heap_db_area",
+                     "heap_msg_area", "trng_state", "chacha20_state")
+FREE_SECTIONS = ("heap_mem_area_not_ret", "prodtest_uninit", "stateful_hibernation", "free_area")
+FREE_REGIONS = ("ER_NZI", ".heap", "ER_PRODTEST", "ER_STATEFUL_HIBERNATION", "ER_FREE_AREA", "LR_FREE_AREA")
+
+
+def region_class(name):
+    if name.startswith("RET_") or name.startswith("LR_RETAINED"):
+        return RETAINED
+    if name in FREE_REGIONS:
+        return FREE
+    if name in ("ER_ZI", ".bss"):
+        return ZI
+    if name in (".stack_dummy", ".stack"):
+        return STACK
+    return CODE
+
+
+def section_class(region_cls, name):
+    base = name.lstrip(".")
+    if base in RETAINED_SECTIONS:
+        return RETAINED
+    if base in FREE_SECTIONS:
+        return FREE
+    if base.upper() == "STACK" or base.startswith("stack"):
+        return STACK
+    return region_cls
+
+
+class Region:
+    def __init__(self, name, base, size, limit=None):
+        self.name = name
+        self.base = base
+        self.size = size
+        self.limit = limit
+        self.cls = region_class(name)
+
+
+class InputSection:
+    def __init__(self, addr, size, name, obj, region):
+        self.addr = addr
+        self.size = size
+        self.name = name
+        self.obj = obj
+        self.region = region
+        self.cls = section_class(region.cls if region else CODE, name)
+
+
+class Symbol:
+    def __init__(self, name, addr, size, kind, obj=None):
+        self.name = name
+        self.addr = addr
+        self.size = size
+        self.kind = kind        # "func" or "data"
+        self.obj = obj
+        self.refs = set()       # functions referring to a variable
+        self.data_ref = False   # address stored in a table
+        self.section = None
+
+
+class LinkMap:
+    def __init__(self):
+        self.regions = []
+        self.sections = []
+        self.symbols = []       # armlink symbol table only
+
+
+def parse_armlink(lines, lm):
+    region = None
+    in_symbols = False
+    for line in lines:
+        if "Image Symbol Table" in line:
+            in_symbols = True
+            continue
+        if "Memory Map of the image" in line:
+            in_symbols = False
+        m = re.match(r"\s*Execution Region (\S+) \((?:Exec base|Base): (0x[0-9a-fA-F]+),.*?Size: (0x[0-9a-fA-F]+)"
+                     r"(?:, Max: (0x[0-9a-fA-F]+))?", line)
+        if m:
+            limit = int(m.group(4), 16) if m.group(4) else None
+            region = Region(m.group(1), int(m.group(2), 16), int(m.group(3), 16),
+                            None if limit == 0xFFFFFFFF else limit)
+            lm.regions.append(region)
+            continue
+        if in_symbols:
+            m = re.match(r"\s+(\S+)\s+(0x[0-9a-fA-F]+)\s+(Data|Thumb Code|ARM Code)\s+(\d+)\s+(\S+?)\((\S+)\)\s*$",
+                         line)
+            if m and not m.group(1).startswith("$"):
+                kind = "data" if m.group(3) == "Data" else "func"
+                lm.symbols.append(Symbol(m.group(1), int(m.group(2), 16) & ~1, int(m.group(4)), kind, m.group(5)))
+            continue
+        toks = line.split()
+        if region is None or len(toks) < 4 or not re.match(r"0x[0-9a-fA-F]{8}$", toks[0]):
+            continue
+        if re.match(r"(0x[0-9a-fA-F]{8}|-)$", toks[1]) and re.match(r"0x[0-9a-fA-F]+$", toks[2]):
+            size, rest = int(toks[2], 16), toks[3:]
+        elif re.match(r"0x[0-9a-fA-F]+$", toks[1]):
+            size, rest = int(toks[1], 16), toks[2:]
+        else:
+            continue
+        if not rest or rest[0] not in ("Code", "Data", "Zero") or len(rest) < 3:
+            continue
+        lm.sections.append(InputSection(int(toks[0], 16), size, rest[-2], rest[-1], region))
+
+
+def parse_gnu(lines, lm):
+    region = None
+    pending = None
+    started = False
+    for line in lines:
+        if line.startswith("Linker script and memory map"):
+            started = True
+            continue
+        if not started:
+            continue
+        m = re.match(r"^([A-Za-z_.][\w.$]*)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)", line)
+        if m:
+            region = Region(m.group(1), int(m.group(2), 16), int(m.group(3), 16))
+            lm.regions.append(region)
+            pending = None
+            continue
+        m = re.match(r"^([A-Za-z_.][\w.$]*)\s*$", line)
+        if m:
+            pending = ("region", m.group(1))
+            continue
+        m = re.match(r"^ (\S+)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\S.*)$", line)
+        if m and region is not None:
+            lm.sections.append(InputSection(int(m.group(2), 16), int(m.group(3), 16), m.group(1),
+                                            m.group(4).strip(), region))
+            pending = None
+            continue
+        m = re.match(r"^ (\S+)\s*$", line)
+        if m:
+            pending = ("section", m.group(1))
+            continue
+        m = re.match(r"^\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s*(\S.*)?$", line)
+        if m and pending is not None:
+            if pending[0] == "region":
+                region = Region(pending[1], int(m.group(1), 16), int(m.group(2), 16))
+                lm.regions.append(region)
+            elif region is not None and m.group(3):
+                lm.sections.append(InputSection(int(m.group(1), 16), int(m.group(2), 16), pending[1],
+                                                m.group(3).strip(), region))
+            pending = None
+
+
+def parse_map(path):
+    with open(path, errors="replace") as f:
+        lines = f.read().splitlines()
+    lm = LinkMap()
+    if any("Memory Map of the image" in line for line in lines[:2000]) or \
+            any("Execution Region" in line for line in lines):
+        parse_armlink(lines, lm)
+    else:
+        parse_gnu(lines, lm)
+    for s in lm.sections:
+        if s.name.startswith("*fill*") or s.obj.startswith("*fill*"):
+            s.cls = FREE
+    return lm
+
+
+class Elf:
+    """ELF32 little endian reader: allocated sections and the symbol table."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        d = self.data
+        if d[:4] != b"\x7fELF" or d[4] != 1 or d[5] != 1:
+            raise ValueError("%s: not a 32-bit little endian ELF" % path)
+        shoff, = struct.unpack_from("<I", d, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from("<HHH", d, 0x2E)
+        raw = [struct.unpack_from("<IIIIIIIIII", d, shoff + i * shentsize) for i in range(shnum)]
+        names = raw[shstrndx][4]
+        self.sections = []
+        for name, stype, flags, addr, offset, size, link, _, _, _ in raw:
+            self.sections.append({"name": self._str(names, name), "type": stype, "flags": flags, "addr": addr,
+                                  "offset": offset, "size": size, "link": link})
+        self.symbols = []
+        for sec in self.sections:
+            if sec["type"] != 2:
+                continue
+            strtab = self.sections[sec["link"]]["offset"]
+            for off in range(sec["offset"], sec["offset"] + sec["size"], 16):
+                name, value, size, info, _, shndx = struct.unpack_from("<IIIBBH", d, off)
+                self.symbols.append((self._str(strtab, name), value, size, info & 0xF, shndx))
+
+    def _str(self, base, off):
+        end = self.data.index(b"\0", base + off)
+        return self.data[base + off:end].decode("latin-1")
+
+    def progbits(self):
+        """Allocated sections with content, (addr, bytes)."""
+        for sec in self.sections:
+            if sec["type"] == 1 and sec["flags"] & 2 and sec["size"]:
+                yield sec["addr"], self.data[sec["offset"]:sec["offset"] + sec["size"]]
+
+
+def bl_target(addr, hw1, hw2):
+    s = (hw1 >> 10) & 1
+    i1 = 1 ^ (((hw2 >> 13) & 1) ^ s)
+    i2 = 1 ^ (((hw2 >> 11) & 1) ^ s)
+    off = (s << 24) | (i1 << 23) | (i2 << 22) | ((hw1 & 0x3FF) << 12) | ((hw2 & 0x7FF) << 1)
+    if s:
+        off -= 1 << 25
+    return addr + 4 + off
+
+
+class Image:
+    """Functions and variables of the image, and who refers to what."""
+
+    def __init__(self, elf, lm, ram_lo, ram_hi):
+        self.funcs = {}
+        self.vars = []
+        self.mapping = []
+        for name, value, size, stype, shndx in elf.symbols:
+            if name[:2] in ("$t", "$d", "$a") and (len(name) == 2 or name[2] == "."):
+                self.mapping.append((value & ~1, name[1]))
+            elif stype == 2 and size and shndx:
+                self.funcs.setdefault(value & ~1, Symbol(name, value & ~1, size, "func"))
+            elif stype == 1 and size and ram_lo <= value < ram_hi:
+                self.vars.append(Symbol(name, value, size, "data"))
+        self.mapping.sort()
+        self.vars.sort(key=lambda v: v.addr)
+        self.var_addrs = [v.addr for v in self.vars]
+        self.franges = sorted((f.addr, f.addr + f.size, f) for f in self.funcs.values())
+        self.fstarts = [r[0] for r in self.franges]
+        self.calls = {f: set() for f in self.funcs.values()}
+        self.address_taken = set()
+
+        sections = sorted((s for s in lm.sections if s.size), key=lambda s: s.addr)
+        sec_addrs = [s.addr for s in sections]
+        for v in self.vars:
+            i = bisect.bisect_right(sec_addrs, v.addr) - 1
+            if i >= 0 and v.addr < sections[i].addr + sections[i].size:
+                v.section = sections[i]
+                v.obj = sections[i].obj
+        self.by_section = {}
+        for v in self.vars:
+            if v.section is not None:
+                self.by_section.setdefault(v.section.addr, []).append(v)
+
+        for addr, blob in elf.progbits():
+            self._scan(addr, blob)
+
+    def kind_at(self, addr):
+        i = bisect.bisect_right(self.mapping, (addr, "~")) - 1
+        return self.mapping[i][1] if i >= 0 else None
+
+    def func_at(self, addr):
+        i = bisect.bisect_right(self.fstarts, addr) - 1
+        if i >= 0 and addr < self.franges[i][1]:
+            return self.franges[i][2]
+        return None
+
+    def vars_at(self, addr):
+        """Variables an address points to; a section base stands for all its variables."""
+        i = bisect.bisect_right(self.var_addrs, addr) - 1
+        if i < 0 or addr >= self.vars[i].addr + self.vars[i].size:
+            return []
+        v = self.vars[i]
+        if v.section is not None and v.section.addr == addr:
+            return self.by_section.get(addr, [v])
+        return [v]
+
+    def _scan(self, base, blob):
+        n = len(blob)
+        # Data words: literal pools, tables, vectors
+        for off in range(0, n - 3, 4):
+            addr = base + off
+            if self.mapping and self.kind_at(addr) in ("t", "a"):
+                continue
+            w, = struct.unpack_from("<I", blob, off)
+            owner = self.func_at(addr)
+            if w & 1 and (w & ~1) in self.funcs:
+                self.address_taken.add(self.funcs[w & ~1])
+            for v in self.vars_at(w):
+                if owner is not None:
+                    v.refs.add(owner)
+                else:
+                    v.data_ref = True
+        # Calls and tail calls
+        for f in self.funcs.values():
+            if not base <= f.addr < base + n:
+                continue
+            off = f.addr - base
+            end = min(off + f.size, n)
+            while off + 2 <= end:
+                addr = base + off
+                if self.mapping and self.kind_at(addr) == "d":
+                    off += 2
+                    continue
+                hw, = struct.unpack_from("<H", blob, off)
+                if (hw & 0xF800) == 0xF000 and off + 4 <= end:
+                    hw2, = struct.unpack_from("<H", blob, off + 2)
+                    if (hw2 & 0xD000) == 0xD000:
+                        target = self.funcs.get(bl_target(addr, hw, hw2))
+                        if target is not None:
+                            self.calls[f].add(target)
+                        off += 4
+                        continue
+                if (hw & 0xF800) == 0xE000:
+                    imm = (hw & 0x7FF) << 1
+                    if imm & 0x800:
+                        imm -= 0x1000
+                    target = self.funcs.get(addr + 4 + imm)
+                    if target is not None and target is not f:
+                        self.calls[f].add(target)
+                off += 2
+
+    def runtime(self, roots, init_re):
+        """Functions that may run after a wake-up."""
+        init = re.compile(init_re)
+        start = [f for f in self.funcs.values() if f.name in roots]
+        start += [f for f in self.address_taken if not init.search(f.name)]
+        seen = set(start)
+        todo = list(start)
+        while todo:
+            for g in self.calls[todo.pop()]:
+                if g not in seen:
+                    seen.add(g)
+                    todo.append(g)
+        return seen
+
+
+def analyse(lm, image, chip, roots, init_re):
+    blocks = CHIPS[chip]
+    ram_lo, ram_hi = blocks[0][1], blocks[-1][1] + blocks[-1][2]
+    rep = {"chip": chip, "regions": [], "blocks": {}, "modules": {}, "variables": [], "flags": {}}
+
+    for r in lm.regions:
+        if ram_lo <= r.base < ram_hi:
+            rep["regions"].append({"name": r.name, "base": r.base, "size": r.size, "limit": r.limit,
+                                   "class": r.cls})
+
+    runtime = image.runtime(roots, init_re) if image else set()
+    flagged = {}
+    if image:
+        for v in image.vars:
+            cls = v.section.cls if v.section else ZI
+            if cls not in (RETAINED, ZI):
+                continue
+            if not v.refs and not v.data_ref:
+                flag = "unreferenced"
+            elif not v.data_ref and not (v.refs & runtime):
+                flag = "init-only"
+            else:
+                flag = None
+            if flag:
+                flagged[v.addr] = flag
+            rep["variables"].append({"name": v.name, "addr": v.addr, "size": v.size, "obj": v.obj, "class": cls,
+                                     "flag": flag, "refs": sorted(f.name for f in v.refs)})
+
+    # Bytes that must be kept, per block
+    needs = []
+    for s in lm.sections:
+        if not s.size or not ram_lo <= s.addr < ram_hi or s.cls == FREE:
+            continue
+        mod = rep["modules"].setdefault(s.obj, {"retained": 0, "zi": 0, "zi_needed": 0})
+        if s.cls == RETAINED:
+            mod["retained"] += s.size
+        if s.cls != ZI:
+            needs.append((s.addr, s.size, s.cls, s.obj + "(" + s.name + ")"))
+            continue
+        mod["zi"] += s.size
+        if image is None:
+            needs.append((s.addr, s.size, ZI, s.obj + "(" + s.name + ")"))
+            mod["zi_needed"] += s.size
+            continue
+        # Only the variables used after a wake-up, and the bytes no symbol explains
+        covered = 0
+        for v in image.by_section.get(s.addr, []):
+            covered += v.size
+            if v.addr not in flagged:
+                needs.append((v.addr, v.size, ZI, v.name))
+                mod["zi_needed"] += v.size
+        if s.size > covered and not image.by_section.get(s.addr):
+            needs.append((s.addr, s.size, ZI, s.obj + "(" + s.name + ")"))
+            mod["zi_needed"] += s.size
+
+    for i, (name, base, size) in enumerate(blocks):
+        items = {}
+        total = 0
+        for addr, n, cls, what in needs:
+            lo, hi = max(addr, base), min(addr + n, base + size)
+            if lo < hi:
+                total += hi - lo
+                key = cls if cls in (CODE, STACK) else what
+                items[key] = items.get(key, 0) + hi - lo
+        last = i == len(blocks) - 1
+        rep["blocks"][name] = {"required": total, "needed": bool(total) or last, "always": last,
+                               "items": sorted(items.items(), key=lambda kv: -kv[1])}
+
+    rep["retained_data"] = sum(m["retained"] for m in rep["modules"].values())
+    rep["flags"] = {
+        "init-only": sum(v["size"] for v in rep["variables"] if v["flag"] == "init-only" and v["class"] == RETAINED),
+        "unreferenced": sum(v["size"] for v in rep["variables"]
+                            if v["flag"] == "unreferenced" and v["class"] == RETAINED),
+    }
+    ret_data = [r for r in lm.regions if r.name == "RET_DATA"]
+    if ret_data:
+        used = sum(s.size for s in lm.sections if s.region is ret_data[0] and s.cls == RETAINED)
+        rep["ret_data"] = {"used": used, "limit": ret_data[0].limit}
+    return rep
+
+
+def print_report(rep, args):
+    print("Regions")
+    for r in rep["regions"]:
+        limit = "" if r["limit"] is None else " of %6d" % r["limit"]
+        print("  %-30s 0x%08x %6d%s  %s" % (r["name"], r["base"], r["size"], limit, r["class"]))
+
+    print()
+    print("Blocks")
+    for name, b in rep["blocks"].items():
+        state = "always retained" if b["always"] else ("must be retained" if b["needed"] else "may be lost")
+        print("  %-5s %6d bytes to keep, %s" % (name, b["required"], state))
+        for what, n in b["items"][:args.top]:
+            print("          %6d  %s" % (n, what))
+
+    print()
+    print("Modules (retained / zero initialized used after wake-up / zero initialized)")
+    mods = sorted(rep["modules"].items(), key=lambda kv: -(kv[1]["retained"] + kv[1]["zi_needed"]))
+    for obj, m in mods[:args.top * 3]:
+        if m["retained"] or m["zi"]:
+            print("  %-40s %6d %6d %6d" % (obj, m["retained"], m["zi_needed"], m["zi"]))
+
+    if rep["variables"]:
+        print()
+        print("Retained variables")
+        ret = sorted((v for v in rep["variables"] if v["class"] == RETAINED), key=lambda v: -v["size"])
+        for v in ret[:args.top * 2]:
+            print("  %-36s %6d  %-28s %s" % (v["name"], v["size"], v["obj"] or "?", v["flag"] or ""))
+        print()
+        print("Flagged variables")
+        for v in sorted(rep["variables"], key=lambda v: (v["class"], -v["size"])):
+            if v["flag"]:
+                print("  %-10s %-36s %6d  %-28s %s" % (v["class"], v["name"], v["size"], v["obj"] or "?", v["flag"]))
+
+    print()
+    print("Configuration")
+    for i, (name, b) in enumerate(rep["blocks"].items()):
+        macro = "CFG_RETAIN_RAM_%d_BLOCK" % (i + 1)
+        if b["needed"]:
+            print("  #define %s" % macro)
+        else:
+            print("  #undef  %s                (holds nothing needed in sleep)" % macro)
+    for name, b in rep["blocks"].items():
+        if b["needed"] and not b["always"] and b["required"] <= args.small:
+            print("  %s is retained for %d bytes only: %s" %
+                  (name, b["required"], ", ".join(w for w, _ in b["items"][:4])))
+    if "ret_data" in rep and rep["ret_data"]["limit"]:
+        used, limit = rep["ret_data"]["used"], rep["ret_data"]["limit"]
+        size = ((used + 3) & ~3) + args.margin
+        if size < limit:
+            print("  #define CFG_RET_DATA_SIZE (%d)   (%d used of %d)" % (size, used, limit))
+    if rep["flags"]["init-only"] or rep["flags"]["unreferenced"]:
+        print("  %d retained bytes are init-only and %d unreferenced, see the flagged variables" %
+              (rep["flags"]["init-only"], rep["flags"]["unreferenced"]))
+
+
+def compare(rep, base, allow):
+    failures = []
+    grow = rep["retained_data"] - base["retained_data"]
+    print()
+    print("Baseline: retained data %d -> %d bytes (%+d)" % (base["retained_data"], rep["retained_data"], grow))
+    old = set(base["modules"])
+    for obj, m in sorted(rep["modules"].items()):
+        prev = base["modules"].get(obj, {"retained": 0})["retained"]
+        if m["retained"] != prev:
+            print("  %-40s %6d -> %6d" % (obj, prev, m["retained"]))
+    for obj in sorted(old - set(rep["modules"])):
+        print("  %-40s %6d -> %6d" % (obj, base["modules"][obj]["retained"], 0))
+    if grow > allow:
+        failures.append("retained data grew by %d bytes, more than %d" % (grow, allow))
+    blocks = sum(b["needed"] for b in rep["blocks"].values())
+    prev = sum(b["needed"] for b in base["blocks"].values())
+    if blocks > prev:
+        failures.append("retained RAM blocks grew from %d to %d" % (prev, blocks))
+    return failures
+
+
+def run(args):
+    lm = parse_map(args.map)
+    blocks = CHIPS[args.chip]
+    image = None
+    if args.elf:
+        image = Image(Elf(args.elf), lm, blocks[0][1], blocks[-1][1] + blocks[-1][2])
+    elif lm.symbols:
+        print("no --elf: variables from the map only, references not analysed")
+    roots = set(DEFAULT_ROOTS + (args.root or []))
+    rep = analyse(lm, image, args.chip, roots, args.init_re)
+    print_report(rep, args)
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(rep, f, indent=1)
+    failures = []
+    if args.baseline:
+        with open(args.baseline) as f:
+            failures = compare(rep, json.load(f), args.allow)
+        for failure in failures:
+            print("FAILED: " + failure)
+        print("ok" if not failures else "FAILED")
+    return rep, failures
+
+
+# Self test: a small DA14531 image written here, with the map in both formats
+
+def thumb_bl(addr, target):
+    off = target - (addr + 4)
+    s = 1 if off < 0 else 0
+    off &= (1 << 25) - 1
+    i1, i2 = (off >> 23) & 1, (off >> 22) & 1
+    j1, j2 = (1 ^ i1) ^ s, (1 ^ i2) ^ s
+    return struct.pack("<HH", 0xF000 | (s << 10) | ((off >> 12) & 0x3FF),
+                       0xD000 | (j1 << 13) | (j2 << 11) | ((off >> 1) & 0x7FF))
+
+
+def build_test_image(path, extra_var=False):
+    """Vector table, six functions with literal pools, a callback table and the variables."""
+    text = 0x07FC0000
+    funcs = ["Reset_Handler", "main", "app_init", "rwip_schedule", "BLE_Handler", "user_cb", "helper"]
+    # (name, addr, size, section)
+    ret = 0x07FCA000
+    bss = 0x07FC4100
+    variables = [("var_init_only", ret, 16, "retention_mem_area0", "app.o"),
+                 ("var_both", ret + 16, 8, "retention_mem_area0", "app.o"),
+                 ("var_irq", ret + 24, 4, "retention_mem_area0", "rwip.o"),
+                 ("var_cb", ret + 28, 4, "retention_mem_area0", "user.o"),
+                 ("var_unused", ret + 32, 32, "retention_mem_area0", "spare.o"),
+                 ("bss_runtime", bss, 64, ".bss", "rwip.o"),
+                 ("bss_init", bss + 64, 512, ".bss", "app.o")]
+    if extra_var:
+        variables.append(("var_new", ret + 64, 128, "retention_mem_area0", "user.o"))
+    va = {v[0]: v[1] for v in variables}
+
+    fsize = 32
+    fa = {name: text + 0x100 + i * fsize for i, name in enumerate(funcs)}
+    body = {
+        "Reset_Handler": ([("bl", "main")], []),
+        "main": ([("bl", "app_init"), ("b", "rwip_schedule")], []),
+        "app_init": ([("bl", "helper")], ["var_init_only", "var_both", "bss_init"]),
+        "rwip_schedule": ([], ["var_both", "bss_runtime"]),
+        "BLE_Handler": ([], ["var_irq"]),
+        "user_cb": ([], ["var_cb"]),
+        "helper": ([], []),
+    }
+    blob = bytearray(0x100 + len(funcs) * fsize + 16)
+    mapping = [(text, "$d"), (text + 0x100, "$t")]
+    # Vector table: stack, Reset_Handler, NMI, ..., BLE_Handler
+    struct.pack_into("<II", blob, 0, 0x07FC8000, fa["Reset_Handler"] | 1)
+    struct.pack_into("<I", blob, 16 * 4, fa["BLE_Handler"] | 1)
+    for name in funcs:
+        off = fa[name] - text
+        calls, refs = body[name]
+        pos = off
+        for kind, target in calls:
+            if kind == "bl":
+                blob[pos:pos + 4] = thumb_bl(text + pos, fa[target])
+                pos += 4
+            else:
+                imm = (fa[target] - (text + pos + 4)) >> 1
+                struct.pack_into("<H", blob, pos, 0xE000 | (imm & 0x7FF))
+                pos += 2
+        struct.pack_into("<H", blob, pos, 0x4770)     # bx lr
+        pool = off + 16
+        mapping.append((text + pool, "$d"))
+        for i, v in enumerate(refs):
+            struct.pack_into("<I", blob, pool + 4 * i, va[v])
+        if name != funcs[-1]:
+            mapping.append((text + off + fsize, "$t"))
+    # Callback table in the constants
+    table = 0x100 + len(funcs) * fsize
+    mapping.append((text + table, "$d"))
+    struct.pack_into("<I", blob, table, fa["user_cb"] | 1)
+
+    shstr = b"\0.text\0RET_DATA\0.bss\0.symtab\0.strtab\0.shstrtab\0"
+    strtab = bytearray(b"\0")
+    syms = [struct.pack("<IIIBBH", 0, 0, 0, 0, 0, 0)]
+
+    def sym(name, value, size, stype, shndx):
+        syms.append(struct.pack("<IIIBBH", len(strtab), value, size, stype, 0, shndx))
+        strtab.extend(name.encode() + b"\0")
+
+    for addr, name in mapping:
+        sym(name, addr, 0, 0, 1)
+    for name in funcs:
+        sym(name, fa[name] | 1, fsize, 0x12, 1)
+    for name, addr, size, sec, _ in variables:
+        sym(name, addr, size, 0x11, 2 if sec != ".bss" else 3)
+    symtab = b"".join(syms)
+
+    off_text = 52
+    off_sym = off_text + len(blob)
+    off_str = off_sym + len(symtab)
+    off_shstr = off_str + len(strtab)
+    off_sh = (off_shstr + len(shstr) + 3) & ~3
+    sh = [struct.pack("<IIIIIIIIII", 0, 0, 0, 0, 0, 0, 0, 0, 0, 0),
+          struct.pack("<IIIIIIIIII", 1, 1, 6, text, off_text, len(blob), 0, 0, 4, 0),
+          struct.pack("<IIIIIIIIII", 7, 8, 3, ret, off_sym, 0x200, 0, 0, 4, 0),
+          struct.pack("<IIIIIIIIII", 16, 8, 3, bss, off_sym, 0x400, 0, 0, 4, 0),
+          struct.pack("<IIIIIIIIII", 21, 2, 0, 0, off_sym, len(symtab), 5, 1, 4, 16),
+          struct.pack("<IIIIIIIIII", 29, 3, 0, 0, off_str, len(strtab), 0, 0, 1, 0),
+          struct.pack("<IIIIIIIIII", 37, 3, 0, 0, off_shstr, len(shstr), 0, 0, 1, 0)]
+    hdr = b"\x7fELF\x01\x01\x01" + b"\0" * 9 + struct.pack("<HHIIIIIHHHHHH", 2, 40, 1, fa["Reset_Handler"] | 1,
+                                                              0, off_sh, 0x05000200, 52, 0, 0, 40, len(sh), 6)
+    out = bytearray(hdr) + blob + symtab + strtab + shstr
+    out += b"\0" * (off_sh - len(out))
+    out += b"".join(sh)
+    with open(path, "wb") as f:
+        f.write(out)
+
+    # The same layout as seen by both linkers
+    code_end = text + len(blob)
+    ret_used = sum(v[2] for v in variables if v[3] != ".bss")
+    by_obj = {}
+    for name, addr, size, sec, obj in variables:
+        if sec != ".bss":
+            by_obj.setdefault(obj, [addr, 0])[1] += size
+    layout = [("ER_IROM3", text, len(blob), None, [(text, len(blob), ".text", "startup_DA14531.o")]),
+              ("ER_ZI", bss, 0x400 + 0x200, None,
+               [(bss, 64, ".bss", "rwip.o"), (bss + 64, 512, ".bss", "app.o"), (bss + 0x400, 0x200, "STACK",
+                                                                                 "startup_DA14531.o")]),
+              ("ER_NZI", 0x07FC4800, 0x1000, None,
+               [(0x07FC4800, 0x1000, "heap_mem_area_not_ret", "jump_table.o")]),
+              ("RET_DATA", ret, ret_used, 0x800,
+               [(a, n, "retention_mem_area0", obj) for obj, (a, n) in sorted(by_obj.items(), key=lambda kv: kv[1])]),
+              ("RET_HEAP", 0x07FCA800, 0x600, None, [(0x07FCA800, 0x600, "heap_env_area", "jump_table.o")])]
+    arm = ["Memory Map of the image", ""]
+    gnu = ["Linker script and memory map", ""]
+    for name, base, size, limit, secs in layout:
+        arm.append("    Execution Region %s (Exec base: 0x%08x, Load base: 0x%08x, Size: 0x%08x, Max: 0x%08x, "
+                   "ABSOLUTE)" % (name, base, base, size, limit or 0xFFFFFFFF))
+        arm.append("")
+        arm.append("    Exec Addr    Load Addr    Size         Type   Attr      Idx    E Section Name        Object")
+        arm.append("")
+        gnu.append("%-16s0x%08x %8s" % (name, base, "0x%x" % size) if len(name) < 15 else name)
+        if len(name) >= 15:
+            gnu.append("%16s0x%08x %8s" % ("", base, "0x%x" % size))
+        for addr, n, sec, obj in secs:
+            kind = "Code" if name.startswith("ER_IROM") else "Zero"
+            arm.append("    0x%08x   -            0x%08x   %s   RW         %4d    %-19s %s" % (addr, n, kind, 7, sec, obj))
+            if len(sec) < 14:
+                gnu.append(" %-14s 0x%08x %8s %s" % (sec, addr, "0x%x" % n, obj))
+            else:
+                gnu.append(" %s" % sec)
+                gnu.append("                0x%08x %8s %s" % (addr, "0x%x" % n, obj))
+        arm.append("")
+        gnu.append("")
+    assert code_end < 0x07FC4000
+    return "\n".join(arm) + "\n", "\n".join(gnu) + "\n"
+
+
+def self_test():
+    failures = []
+    tmp = tempfile.mkdtemp(prefix="retention_map_")
+
+    def check(cond, what):
+        if not cond:
+            failures.append(what)
+
+    reports = {}
+    for fmt in ("armlink", "gnu"):
+        elf = os.path.join(tmp, "app.elf")
+        arm, gnu = build_test_image(elf)
+        path = os.path.join(tmp, fmt + ".map")
+        with open(path, "w") as f:
+            f.write(arm if fmt == "armlink" else gnu)
+        print("==== %s map" % fmt)
+        args = argparse.Namespace(map=path, elf=elf, chip="531", root=None, init_re=DEFAULT_INIT_RE, json=None,
+                                  baseline=None, allow=0, top=8, small=1024, margin=16)
+        rep, _ = run(args)
+        print()
+        reports[fmt] = rep
+        flags = {v["name"]: v["flag"] for v in rep["variables"]}
+        check(flags.get("var_init_only") == "init-only", fmt + ": var_init_only not init-only")
+        check(flags.get("var_unused") == "unreferenced", fmt + ": var_unused not unreferenced")
+        check(flags.get("bss_init") == "init-only", fmt + ": bss_init not init-only")
+        for name in ("var_both", "var_irq", "var_cb", "bss_runtime"):
+            check(name in flags and flags[name] is None, "%s: %s flagged %s" % (fmt, name, flags.get(name)))
+        check(rep["retained_data"] == 64 + 0x600, fmt + ": retained data %d" % rep["retained_data"])
+        check(rep["modules"]["user.o"]["retained"] == 4, fmt + ": user.o retained bytes")
+        b = rep["blocks"]
+        check(b["RAM1"]["needed"] and b["RAM2"]["needed"] and b["RAM3"]["needed"], fmt + ": blocks")
+        # RAM2: the stack and bss_runtime, not the non retained heap nor bss_init
+        check(b["RAM2"]["required"] == 0x200 + 64, fmt + ": RAM2 required %d" % b["RAM2"]["required"])
+
+    # Regression: a new retained variable fails the check against the first report
+    base = os.path.join(tmp, "base.json")
+    with open(base, "w") as f:
+        json.dump(reports["gnu"], f)
+    elf = os.path.join(tmp, "app2.elf")
+    _, gnu = build_test_image(elf, extra_var=True)
+    path = os.path.join(tmp, "app2.map")
+    with open(path, "w") as f:
+        f.write(gnu)
+    print("==== regression, a growth of 128 bytes must fail")
+    args = argparse.Namespace(map=path, elf=elf, chip="531", root=None, init_re=DEFAULT_INIT_RE, json=None,
+                              baseline=base, allow=64, top=4, small=1024, margin=16)
+    _, fails = run(args)
+    check(len(fails) == 1 and "grew by 128" in fails[0], "regression not detected: %s" % fails)
+    args.allow = 128
+    _, fails = run(args)
+    check(not fails, "growth within --allow reported")
+
+    print()
+    for failure in failures:
+        print("FAILED: " + failure)
+    print("self test " + ("ok" if not failures else "FAILED"))
+    return 1 if failures else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("map", nargs="?", help="linker map, armlink or GNU ld")
+    parser.add_argument("--elf", help="linked image, .axf or .elf")
+    parser.add_argument("--chip", choices=sorted(CHIPS), default="531")
+    parser.add_argument("--root", action="append", help="more functions that run after a wake-up")
+    parser.add_argument("--init-re", default=DEFAULT_INIT_RE,
+                        help="functions stored as callbacks that only run at start-up")
+    parser.add_argument("--json", help="write the report")
+    parser.add_argument("--baseline", help="report of a previous build to compare with")
+    parser.add_argument("--allow", type=int, default=0, help="retained bytes the build may grow by")
+    parser.add_argument("--top", type=int, default=8, help="lines per table")
+    parser.add_argument("--small", type=int, default=1024, help="report the blocks retained for fewer bytes")
+    parser.add_argument("--margin", type=int, default=16, help="margin of the suggested CFG_RET_DATA_SIZE")
+    parser.add_argument("--self-test", action="store_true", help="check the tool on a generated image")
+    args = parser.parse_args()
+    if args.self_test:
+        return self_test()
+    if not args.map:
+        parser.error("the map is required")
+    _, failures = run(args)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,250 @@
+#!/usr/bin/env python3
+"""
+Decoder for the "Latency Stats", "Heap Stats", "Stream Stats" and "Audio Stats"
+characteristics of the HID-Gamepad-Digitizer example (see user_trace.h,
+user_heap_mon.h, user_stream.h and user_audio.h).
+
+The value is either passed as a hex string, as shown by generic GATT clients
+(e.g. "01-04-0A-05-..." or "01040a05..."), or read from the device when --address
+is given and the bleak package is installed.
+
+    trace_stats_decode.py 01040a05000000...
+    trace_stats_decode.py --address 80:EA:CA:70:00:01 [--reset]
+    trace_stats_decode.py --heap --address 80:EA:CA:70:00:01
+    trace_stats_decode.py --stream --address 80:EA:CA:70:00:01
+    trace_stats_decode.py --audio --address 80:EA:CA:70:00:01
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+STATS_UUID = "0783b03e-8535-b5a0-7140-a304d2495cbb"
+HEAP_STATS_UUID = "0783b03e-8535-b5a0-7140-a304d2495cbc"
+STREAM_STATS_UUID = "0783b03e-8535-b5a0-7140-a304d2495cbd"
+AUDIO_STATS_UUID = "0783b03e-8535-b5a0-7140-a304d2495cbf"
+
+STAGES = ["RX", "DISPATCH", "REPORT", "FRAME"]
+ERRORS = ["ntf_disabled", "req_disallowed", "queue_full", "other", "unsynced", "woken"]
+# Error counters of each layout version
+NB_ERRORS = {1: 5, 2: 5, 3: 6}
+BOOT = ["db_init", "first_adv"]
+
+HEAPS = ["ENV", "DB", "MSG", "NON_RET"]
+ALLOC_SITES = ["hogpd_report", "custs1_rsp", "stream_ntf", "audio_ntf", "lecb_sdu"]
+
+SLOT_US = 625
+
+
+def bucket_labels(nb_buckets, bucket0_us):
+    labels = []
+    for i in range(nb_buckets - 1):
+        labels.append("< %g ms" % ((bucket0_us << i) / 1000.0))
+    labels.append(">= %g ms" % ((bucket0_us << (nb_buckets - 2)) / 1000.0))
+    return labels
+
+
+def decode(data):
+    if len(data) < 4:
+        raise ValueError("value too short (%d bytes)" % len(data))
+
+    version, nb_stages, nb_buckets, bucket0 = struct.unpack_from("<BBBB", data, 0)
+    if version not in NB_ERRORS:
+        raise ValueError("unsupported layout version %d" % version)
+
+    bucket0_us = bucket0 * 50
+    offset = 4
+    nb_errors = NB_ERRORS[version]
+    errors = struct.unpack_from("<%dH" % nb_errors, data, offset)
+    offset += 2 * nb_errors
+    (frames,) = struct.unpack_from("<I", data, offset)
+    offset += 4
+
+    stages = []
+    for i in range(nb_stages):
+        (max_us,) = struct.unpack_from("<I", data, offset)
+        offset += 4
+        buckets = struct.unpack_from("<%dH" % nb_buckets, data, offset)
+        offset += 2 * nb_buckets
+        name = STAGES[i] if i < len(STAGES) else "STAGE%d" % i
+        stages.append((name, max_us, buckets))
+
+    boot = {}
+    if version >= 2:
+        values = struct.unpack_from("<%dI" % len(BOOT), data, offset)
+        boot = dict((name, None if value == 0xFFFFFFFF else value) for name, value in zip(BOOT, values))
+
+    return {
+        "frames": frames,
+        "boot": boot,
+        "errors": dict(zip(ERRORS, errors)),
+        "labels": bucket_labels(nb_buckets, bucket0_us),
+        "stages": stages,
+    }
+
+
+def percentile(buckets, labels, pct):
+    total = sum(buckets)
+    if total == 0:
+        return "-"
+    limit = total * pct / 100.0
+    acc = 0
+    for count, label in zip(buckets, labels):
+        acc += count
+        if acc >= limit:
+            return label
+    return labels[-1]
+
+
+def print_stats(stats):
+    print("frames: %d" % stats["frames"])
+    print("errors: " + ", ".join("%s=%d" % kv for kv in stats["errors"].items()))
+    if stats["boot"]:
+        print("boot: " + ", ".join("%s=%s" % (name, "-" if us is None else "%.3f ms" % (us / 1000.0))
+                                   for name, us in stats["boot"].items()))
+    labels = stats["labels"]
+    for name, max_us, buckets in stats["stages"]:
+        print()
+        print("%-8s samples=%d max=%.3f ms p50 %s p99 %s"
+              % (name, sum(buckets), max_us / 1000.0,
+                 percentile(buckets, labels, 50), percentile(buckets, labels, 99)))
+        for count, label in zip(buckets, labels):
+            if count:
+                print("    %-10s %6d" % (label, count))
+
+
+def decode_heap(data):
+    version, nb_heaps, samples, peak = struct.unpack_from("<BBHI", data, 0)
+    if version != 1:
+        raise ValueError("unsupported layout version %d" % version)
+
+    offset = 8
+    heaps = []
+    for i in range(nb_heaps):
+        fields = struct.unpack_from("<5H", data, offset)
+        offset += 10
+        heaps.append((HEAPS[i] if i < len(HEAPS) else "HEAP%d" % i,) + fields)
+
+    (nb_sites,) = struct.unpack_from("<B", data, offset)
+    offset += 1
+    failures = struct.unpack_from("<%dH" % nb_sites, data, offset)
+    sites = [ALLOC_SITES[i] if i < len(ALLOC_SITES) else "site%d" % i for i in range(nb_sites)]
+
+    return {"samples": samples, "peak": peak, "heaps": heaps, "failures": dict(zip(sites, failures))}
+
+
+def print_heap_stats(stats):
+    print("samples: %d, peak use of all heaps: %d bytes" % (stats["samples"], stats["peak"]))
+    print()
+    print("%-8s %6s %6s %6s %8s %12s" % ("heap", "size", "used", "max", "largest", "min_largest"))
+    for name, size, used, max_used, largest, min_largest in stats["heaps"]:
+        print("%-8s %6d %6d %6d %8d %12d" % (name, size, used, max_used, largest, min_largest))
+    print()
+    print("alloc failures: " + ", ".join("%s=%d" % kv for kv in stats["failures"].items()))
+
+
+def decode_stream(data):
+    fields = struct.unpack_from("<BBHHHIIIIHH", data, 0)
+    if fields[0] != 1:
+        raise ValueError("unsupported layout version %d" % fields[0])
+
+    names = ["version", "max_queued", "mtu", "tx_octets", "con_interval", "bytes", "ntf",
+             "active_slots", "dropped", "full_ntf", "ntf_errors"]
+    return dict(zip(names, fields))
+
+
+def print_stream_stats(stats):
+    active_s = stats["active_slots"] * SLOT_US / 1e6
+    interval_ms = stats["con_interval"] * 1.25
+    print("mtu: %d, tx_octets: %d, connection interval: %.2f ms, max queued: %d"
+          % (stats["mtu"], stats["tx_octets"], interval_ms, stats["max_queued"]))
+    print("bytes: %d in %d notifications (%d full), %d dropped, %d errors"
+          % (stats["bytes"], stats["ntf"], stats["full_ntf"], stats["dropped"], stats["ntf_errors"]))
+    if stats["ntf"]:
+        print("average payload: %.1f bytes" % (stats["bytes"] / float(stats["ntf"])))
+    if active_s > 0:
+        print("active: %.3f s, throughput: %.0f bytes/s" % (active_s, stats["bytes"] / active_s))
+        if interval_ms > 0:
+            events = active_s * 1000.0 / interval_ms
+            print("per connection event: %.1f bytes, %.2f notifications"
+                  % (stats["bytes"] / events, stats["ntf"] / events))
+
+
+def decode_audio(data):
+    fields = struct.unpack_from("<BBBBHHIIIHHI", data, 0)
+    if fields[0] != 1:
+        raise ValueError("unsupported layout version %d" % fields[0])
+
+    names = ["version", "max_depth", "slots", "max_queued", "frame_len", "sample_rate", "frames",
+             "sent", "dropped", "overruns", "ntf_errors", "ntf_done"]
+    return dict(zip(names, fields))
+
+
+def print_audio_stats(stats):
+    samples = (stats["frame_len"] - 4) * 2
+    print("frame: %d bytes, %d samples at %d Hz, FIFO of %d frames"
+          % (stats["frame_len"], samples, stats["sample_rate"], stats["slots"]))
+    print("frames: %d encoded, %d sent, %d dropped, %d blocks overrun"
+          % (stats["frames"], stats["sent"], stats["dropped"], stats["overruns"]))
+    print("notifications: %d done, %d errors, max queued %d, max FIFO depth %d"
+          % (stats["ntf_done"], stats["ntf_errors"], stats["max_queued"], stats["max_depth"]))
+    if stats["frames"]:
+        print("loss: %.2f %%" % (100.0 * stats["dropped"] / stats["frames"]))
+    if stats["sample_rate"]:
+        print("audio: %.1f s, %.0f bytes/s on air"
+              % (stats["frames"] * samples / float(stats["sample_rate"]),
+                 stats["frame_len"] * stats["sample_rate"] / float(samples)))
+
+
+def read_device(address, uuid, reset):
+    import asyncio
+    from bleak import BleakClient
+
+    async def run():
+        async with BleakClient(address) as client:
+            value = await client.read_gatt_char(uuid)
+            if reset:
+                await client.write_gatt_char(uuid, b"\x00", response=True)
+            return bytes(value)
+
+    return asyncio.run(run())
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("value", nargs="?", help="characteristic value as hex, read from stdin if omitted")
+    parser.add_argument("--address", help="read the value from this device (needs bleak)")
+    parser.add_argument("--reset", action="store_true", help="clear the statistics after reading")
+    parser.add_argument("--heap", action="store_true", help="decode the Heap Stats characteristic")
+    parser.add_argument("--stream", action="store_true", help="decode the Stream Stats characteristic")
+    parser.add_argument("--audio", action="store_true", help="decode the Audio Stats characteristic")
+    args = parser.parse_args()
+
+    if args.address:
+        if args.heap:
+            uuid = HEAP_STATS_UUID
+        elif args.stream:
+            uuid = STREAM_STATS_UUID
+        elif args.audio:
+            uuid = AUDIO_STATS_UUID
+        else:
+            uuid = STATS_UUID
+        data = read_device(args.address, uuid, args.reset)
+    else:
+        text = args.value if args.value is not None else sys.stdin.read()
+        text = re.sub(r"0x|[^0-9a-fA-F]", "", text)
+        data = bytes.fromhex(text)
+
+    if args.heap:
+        print_heap_stats(decode_heap(data))
+    elif args.stream:
+        print_stream_stats(decode_stream(data))
+    elif args.audio:
+        print_audio_stats(decode_audio(data))
+    else:
+        print_stats(decode(data))
+
+
+if __name__ == "__main__":
+    main()
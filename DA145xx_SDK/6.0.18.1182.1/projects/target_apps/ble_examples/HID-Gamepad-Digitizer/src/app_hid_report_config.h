@@ -66,6 +66,15 @@
  */
 #define HID_REPORT_MAX_REPORT_SIZE 8
 
+/**
+ ****************************************************************************************
+ * \brief Number of reports of a host link that can be pending in HOGPD when several
+ * hosts may connect (CFG_MULTI_HOST). Further reports wait in the report FIFO of the link,
+ * so that a slow host does not delay the reports of the other hosts.
+ ****************************************************************************************
+ */
+#define HID_REPORT_LINK_IN_FLIGHT_MAX 2
+
 /**
  ****************************************************************************************
  * \brief Set the size of the rollover buffer. It must be greater or equal to the number
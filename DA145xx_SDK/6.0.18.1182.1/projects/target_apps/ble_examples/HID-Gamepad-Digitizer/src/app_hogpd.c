@@ -49,13 +49,15 @@
 
 #include <user_hogpd_config.h>
 #include "app_hogpd.h"
+#include "app_hid_report_config.h"
+#include "app.h"
 #include "prf_utils.h"
 //#include "port_platform.h"
 #include "app_prf_perm_types.h"
 #include "arch_console.h"
-
-uint16_t report_ntf;
-uint8_t hogpd_conidx;
+#include "user_trace.h"
+#include "user_heap_mon.h"
+#include "user_conn_ctrl.h"
 
 #define REPORT_TO_MASK(index) (HOGPD_CFG_REPORT_NTF_EN << index)
 
@@ -63,6 +65,196 @@ uint8_t hogpd_conidx;
     #error "Maximum munber of HID reports exceeded. Please increase HOGPD_NB_REPORT_INST_MAX"
 #endif
 
+/// Report waiting in the FIFO of a host link
+struct app_hogpd_fifo_entry
+{
+    /// Report index
+    uint8_t report_idx;
+    /// Report type (@see enum hogpd_report_type)
+    uint8_t type;
+    /// Report length
+    uint8_t length;
+    /// Report data
+    uint8_t data[HID_REPORT_MAX_REPORT_SIZE];
+};
+
+/// HID host link, one per connection
+struct app_hogpd_link
+{
+    /// True once HOGPD has been enabled on the connection
+    bool enabled;
+    /// Reports sent to HOGPD and not answered yet
+    uint8_t in_flight;
+    /// Oldest report of the FIFO
+    uint8_t fifo_head;
+    /// Number of reports in the FIFO
+    uint8_t fifo_cnt;
+    /// Notification configuration of the reports
+    uint16_t report_ntf;
+    /// Reports waiting to be sent to HOGPD
+    struct app_hogpd_fifo_entry fifo[HID_REPORT_FIFO_SIZE];
+};
+
+static struct app_hogpd_link app_hogpd_links[APP_EASY_MAX_ACTIVE_CONNECTION] __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/// Connection index of the active host
+static uint8_t app_hogpd_active_host                                        __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/**
+ ****************************************************************************************
+ * \brief Checks whether a host link can take reports.
+ *
+ * \param[in] conidx    Connection index
+ *
+ * \return true if HOGPD is enabled on the connection and the connection is up
+ ****************************************************************************************
+ */
+static bool app_hogpd_link_up(uint8_t conidx)
+{
+    return (conidx < APP_EASY_MAX_ACTIVE_CONNECTION) && app_hogpd_links[conidx].enabled &&
+           app_env[conidx].connection_active;
+}
+
+/**
+ ****************************************************************************************
+ * \brief Checks whether a host link may add a request to HOGPD.
+ *
+ * \param[in] conidx    Connection index
+ *
+ * \return true if the link is below its limit of pending requests
+ ****************************************************************************************
+ */
+static bool app_hogpd_link_may_send(uint8_t conidx)
+{
+#if (APP_EASY_MAX_ACTIVE_CONNECTION > 1)
+    // HOGPD serves one request at a time. A link is limited even while it is the only one,
+    // so that the reports of a host that connects or is selected next do not wait behind
+    // a backlog of the previous host. The next report is sent as soon as one is answered.
+    return app_hogpd_links[conidx].in_flight < HID_REPORT_LINK_IN_FLIGHT_MAX;
+#else
+    return true;
+#endif
+}
+
+/**
+ ****************************************************************************************
+ * \brief Checks whether a report can be sent to HOGPD on a host link right away.
+ *
+ * \param[in] conidx    Connection index
+ *
+ * \return true if the FIFO of the link is empty and the link may add a request to HOGPD
+ ****************************************************************************************
+ */
+static bool app_hogpd_link_ready(uint8_t conidx)
+{
+    return (app_hogpd_links[conidx].fifo_cnt == 0) && app_hogpd_link_may_send(conidx);
+}
+
+/**
+ ****************************************************************************************
+ * \brief Sends a HOGPD_REPORT_UPD_REQ for a host link.
+ *
+ * \return false if the message could not be allocated
+ ****************************************************************************************
+ */
+static bool app_hogpd_report_upd_req(uint8_t conidx, uint8_t report_idx, const uint8_t *data, uint16_t length, enum hogpd_report_type type)
+{
+    struct hogpd_report_upd_req *req;
+    
+    // Allocate the message
+    req = KE_MSG_ALLOC_DYN(HOGPD_REPORT_UPD_REQ, 
+                           prf_get_task_from_id(TASK_ID_HOGPD), 
+                           TASK_APP, 
+                           hogpd_report_upd_req, 
+                           length);
+    
+    
+    if (!req) {
+        user_heap_mon_alloc_failed(USER_HEAP_MON_SITE_HOGPD_REPORT);
+        return false;
+    }
+
+    req->conidx = conidx;
+
+    struct hogpd_report_info *report = &req->report;
+    
+    // Fill in the parameter structure
+    // TODO: find the index from the report number
+    report->hid_idx = 0;
+    
+    report->type = type;
+    report->idx =  report_idx;
+    
+    report->length = length;
+    memcpy(report->value, data, length);            
+    
+    ke_msg_send(req);    
+    user_trace_report_queued(true);
+    app_hogpd_links[conidx].in_flight++;
+    
+    return true;
+}
+
+/**
+ ****************************************************************************************
+ * \brief Sends the reports waiting in the FIFO of a host link, as far as the link may.
+ *
+ * \param[in] conidx    Connection index
+ ****************************************************************************************
+ */
+static void app_hogpd_link_drain(uint8_t conidx)
+{
+    struct app_hogpd_link *link = &app_hogpd_links[conidx];
+    struct app_hogpd_fifo_entry *entry;
+
+    while ((link->fifo_cnt != 0) && app_hogpd_link_may_send(conidx))
+    {
+        entry = &link->fifo[link->fifo_head];
+        if (!app_hogpd_report_upd_req(conidx, entry->report_idx, entry->data, entry->length,
+                                      (enum hogpd_report_type)entry->type))
+        {
+            break;
+        }
+
+        link->fifo_head = (link->fifo_head + 1) % HID_REPORT_FIFO_SIZE;
+        link->fifo_cnt--;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * \brief Selects the host links a report is sent to.
+ *
+ * \param[in] report_idx    Report index
+ * \param[in] type          Report type
+ *
+ * \return Bit mask of the connection indices
+ ****************************************************************************************
+ */
+static uint8_t app_hogpd_route(uint8_t report_idx, enum hogpd_report_type type)
+{
+    uint8_t mask = 0;
+    uint8_t conidx;
+
+    if (hogpd_params.host_routing != APP_HOGPD_ROUTE_BROADCAST)
+    {
+        conidx = app_hogpd_get_active_host();
+        return (conidx != GAP_INVALID_CONIDX) ? (1 << conidx) : 0;
+    }
+
+    for (conidx = 0; conidx < APP_EASY_MAX_ACTIVE_CONNECTION; conidx++)
+    {
+        // Skip the hosts that have not enabled the notifications of the report
+        if (app_hogpd_link_up(conidx) &&
+            ((type != HOGPD_REPORT) || (app_hogpd_links[conidx].report_ntf & REPORT_TO_MASK(report_idx))))
+        {
+            mask |= 1 << conidx;
+        }
+    }
+
+    return mask;
+}
+
 /**
  ****************************************************************************************
  * @brief Enables the HOGPD profile 
@@ -80,27 +272,36 @@ void app_hogpd_enable(uint8_t conidx)
     struct hogpd_enable_req * req = KE_MSG_ALLOC(HOGPD_ENABLE_REQ, prf_get_task_from_id(TASK_ID_HOGPD), 
                                                  TASK_APP,
                                                  hogpd_enable_req);
+    struct app_hogpd_link *link = &app_hogpd_links[conidx];
     
-    hogpd_conidx = conidx;
-    // Fill in the parameter structure
-    req->conidx = hogpd_conidx;
+    ASSERT_WARNING(conidx < APP_EASY_MAX_ACTIVE_CONNECTION);
 
+    // Fill in the parameter structure
+    req->conidx = conidx;
 
-    report_ntf = 0;
-	//report_ntf = 1;
+    // The reports left from a previous connection are dropped
+    memset(link, 0, sizeof(struct app_hogpd_link));
+    link->enabled = true;
 
 
 //#ifdef ALWAYS_ENALBE_REPORTS   
     int i;
     for (i=0; i<HID_NUM_OF_REPORTS; i++) {
         if((hogpd_reports[i].cfg & HOGPD_CFG_REPORT_IN) == HOGPD_CFG_REPORT_IN) {
-            report_ntf |= REPORT_TO_MASK(i); 
+            link->report_ntf |= REPORT_TO_MASK(i); 
         }
     }        
 //#endif
 
 
-    req->ntf_cfg[0] = report_ntf;
+    req->ntf_cfg[0] = link->report_ntf;
+
+    // A new host takes over, unless the host is selected by hotkey and the active host is
+    // still connected
+    if ((hogpd_params.host_routing == APP_HOGPD_ROUTE_ACTIVE_HOST) || !app_hogpd_link_up(app_hogpd_active_host))
+    {
+        app_hogpd_active_host = conidx;
+    }
 
     // Send the message
     ke_msg_send(req);    
@@ -166,47 +367,126 @@ void app_hogpd_create_db(void)
 
 bool app_hogpd_send_report(uint8_t report_idx, uint8_t *data, uint16_t length, enum hogpd_report_type type)
 {
-    struct hogpd_report_upd_req *req;
-    
-    // Allocate the message
-    req = KE_MSG_ALLOC_DYN(HOGPD_REPORT_UPD_REQ, 
-                           prf_get_task_from_id(TASK_ID_HOGPD), 
-                           TASK_APP, 
-                           hogpd_report_upd_req, 
-                           length);
+    uint8_t mask;
+    uint8_t conidx;
     
-    
-    if (!req) {
+    ASSERT_ERROR((type != HOGPD_BOOT_KEYBOARD_INPUT_REPORT && type != HOGPD_BOOT_MOUSE_INPUT_REPORT) || report_idx == 0 );
+    ASSERT_ERROR((type != HOGPD_BOOT_KEYBOARD_INPUT_REPORT && type != HOGPD_BOOT_MOUSE_INPUT_REPORT) || length <= HOGPD_BOOT_REPORT_MAX_LEN);
+    ASSERT_ERROR((type == HOGPD_BOOT_KEYBOARD_INPUT_REPORT || type == HOGPD_BOOT_MOUSE_INPUT_REPORT) || length <= HOGPD_REPORT_MAX_LEN);
+    ASSERT_ERROR(length <= HID_REPORT_MAX_REPORT_SIZE);
+
+    // Retry the reports left over by an allocation failure first, to keep the order
+    for (conidx = 0; conidx < APP_EASY_MAX_ACTIVE_CONNECTION; conidx++) {
+        if (app_hogpd_link_up(conidx)) {
+            app_hogpd_link_drain(conidx);
+        }
+    }
+
+    mask = app_hogpd_route(report_idx, type);
+    if (mask == 0) {
         return false;
     }
 
-    req->conidx = hogpd_conidx;
+    // Reports keep the link on the low latency parameters
+    user_conn_ctrl_traffic_ind();
 
-    struct hogpd_report_info *report = &req->report;
-    
-    // Fill in the parameter structure
-    // TODO: find the index from the report number
-    report->hid_idx = 0;
-    
-    ASSERT_ERROR((type != HOGPD_BOOT_KEYBOARD_INPUT_REPORT && type != HOGPD_BOOT_MOUSE_INPUT_REPORT) || report_idx == 0 );
-    ASSERT_ERROR((type != HOGPD_BOOT_KEYBOARD_INPUT_REPORT && type != HOGPD_BOOT_MOUSE_INPUT_REPORT) || length <= HOGPD_BOOT_REPORT_MAX_LEN);
-    ASSERT_ERROR((type == HOGPD_BOOT_KEYBOARD_INPUT_REPORT || type == HOGPD_BOOT_MOUSE_INPUT_REPORT) || length <= HOGPD_REPORT_MAX_LEN);
+    // The report is taken by all the selected hosts or by none of them
+    for (conidx = 0; conidx < APP_EASY_MAX_ACTIVE_CONNECTION; conidx++) {
+        if ((mask & (1 << conidx)) && !app_hogpd_link_ready(conidx) &&
+            (app_hogpd_links[conidx].fifo_cnt == HID_REPORT_FIFO_SIZE)) {
+#ifdef HID_REPORT_FULL_WARNING
+            ASSERT_WARNING(0);
+#endif
+            user_trace_report_queued(false);
+            return false;
+        }
+    }
 
-    report->type = type;
-    report->idx =  report_idx;
-    
-    report->length = length;
-    memcpy(report->value, data, length);            
-    
-    ke_msg_send(req);    
+    for (conidx = 0; conidx < APP_EASY_MAX_ACTIVE_CONNECTION; conidx++) {
+        struct app_hogpd_link *link = &app_hogpd_links[conidx];
+        struct app_hogpd_fifo_entry *entry;
+
+        if (!(mask & (1 << conidx))) {
+            continue;
+        }
+
+        if (app_hogpd_link_ready(conidx) && app_hogpd_report_upd_req(conidx, report_idx, data, length, type)) {
+            continue;
+        }
+
+        entry = &link->fifo[(link->fifo_head + link->fifo_cnt) % HID_REPORT_FIFO_SIZE];
+        entry->report_idx = report_idx;
+        entry->type = type;
+        entry->length = length;
+        memcpy(entry->data, data, length);
+        link->fifo_cnt++;
+    }
     
     return true;
 }
 
-uint8_t app_hogpd_get_protocol_mode(void)
+void app_hogpd_report_upd_rsp(uint8_t conidx)
+{
+    if (conidx >= APP_EASY_MAX_ACTIVE_CONNECTION) {
+        return;
+    }
+
+    if (app_hogpd_links[conidx].in_flight != 0) {
+        app_hogpd_links[conidx].in_flight--;
+    }
+
+    // A report that could not be allocated before is retried here as well
+    if (app_hogpd_link_up(conidx)) {
+        app_hogpd_link_drain(conidx);
+    }
+}
+
+uint8_t app_hogpd_get_active_host(void)
+{
+    uint8_t conidx;
+
+    if (app_hogpd_link_up(app_hogpd_active_host)) {
+        return app_hogpd_active_host;
+    }
+
+    // The active host has disconnected, the next connected host takes over
+    for (conidx = 0; conidx < APP_EASY_MAX_ACTIVE_CONNECTION; conidx++) {
+        if (app_hogpd_link_up(conidx)) {
+            app_hogpd_active_host = conidx;
+            return conidx;
+        }
+    }
+
+    return GAP_INVALID_CONIDX;
+}
+
+bool app_hogpd_set_active_host(uint8_t conidx)
+{
+    if (!app_hogpd_link_up(conidx)) {
+        return false;
+    }
+
+    // Reports already queued for the previous host are still sent to it
+    app_hogpd_active_host = conidx;
+    return true;
+}
+
+uint16_t app_hogpd_get_report_ntf(uint8_t conidx)
+{
+    ASSERT_WARNING(conidx < APP_EASY_MAX_ACTIVE_CONNECTION);
+    return app_hogpd_links[conidx].report_ntf;
+}
+
+void app_hogpd_set_report_ntf(uint8_t conidx, uint16_t ntf)
+{
+    ASSERT_WARNING(conidx < APP_EASY_MAX_ACTIVE_CONNECTION);
+    app_hogpd_links[conidx].report_ntf = ntf;
+}
+
+uint8_t app_hogpd_get_protocol_mode(uint8_t conidx)
 {
     struct hogpd_env_tag* hogpd_env = PRF_ENV_GET(HOGPD, hogpd);
-    return hogpd_env->svcs[0].proto_mode;
+    return hogpd_env->svcs[0].proto_mode[conidx];
 }
 
 uint16_t app_hogpd_report_handle(uint8_t report_nb)
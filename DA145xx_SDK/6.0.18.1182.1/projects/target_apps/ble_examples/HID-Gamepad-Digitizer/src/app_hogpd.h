@@ -67,17 +67,60 @@ void app_hogpd_create_db(void);
 
 /**
  ****************************************************************************************
- * \brief    
+ * \brief Sends an input report to the hosts selected by hogpd_params.host_routing.
+ *        Each host link has its own report FIFO, the report is taken by all selected
+ *        hosts or by none of them.
+ *
+ * \return false if no host is selected or the FIFO of a selected host is full
  ****************************************************************************************
  */
 bool app_hogpd_send_report(uint8_t report_idx, uint8_t *data, uint16_t length, enum hogpd_report_type type);
 
 /**
  ****************************************************************************************
- * \brief   
+ * \brief Handles the HOGPD_REPORT_UPD_RSP of a host link, sends its next queued report.
+ *
+ * \param   conidx
+ ****************************************************************************************
+ */
+void app_hogpd_report_upd_rsp(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * \brief Returns the active host. Falls back to another connected host if the active
+ *        host has disconnected.
+ *
+ * \return Connection index of the active host, GAP_INVALID_CONIDX if none is connected
+ ****************************************************************************************
+ */
+uint8_t app_hogpd_get_active_host(void);
+
+/**
+ ****************************************************************************************
+ * \brief Selects the host the reports are sent to. The next report goes to the new host.
+ *
+ * \param   conidx
+ *
+ * \return false if HOGPD is not enabled on the connection
+ ****************************************************************************************
+ */
+bool app_hogpd_set_active_host(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * \brief Notification configuration of the reports of a host link
+ ****************************************************************************************
+ */
+uint16_t app_hogpd_get_report_ntf(uint8_t conidx);
+
+void app_hogpd_set_report_ntf(uint8_t conidx, uint16_t ntf);
+
+/**
+ ****************************************************************************************
+ * \brief Protocol mode of a host link
  ****************************************************************************************
  */
-uint8_t app_hogpd_get_protocol_mode(void);
+uint8_t app_hogpd_get_protocol_mode(uint8_t conidx);
 
 uint16_t app_hogpd_report_handle(uint8_t report_nb);
 
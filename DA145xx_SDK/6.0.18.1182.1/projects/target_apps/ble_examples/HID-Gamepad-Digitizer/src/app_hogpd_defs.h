@@ -37,11 +37,23 @@
 
 typedef void (*store_attribute_callback_t)(uint16_t uuid, int attr_num, int value);
 
+/// Routing of the input reports when several hosts are connected
+enum app_hogpd_routing
+{
+    /// Every report is sent to all connected hosts
+    APP_HOGPD_ROUTE_BROADCAST,
+    /// Reports are sent to the active host, the host that connected last
+    APP_HOGPD_ROUTE_ACTIVE_HOST,
+    /// Reports are sent to the active host, selected with app_hogpd_set_active_host()
+    APP_HOGPD_ROUTE_HOTKEY,
+};
+
 typedef struct {
     bool boot_protocol_mode;
     bool batt_external_report;
     bool remote_wakeup;
     bool normally_connectable;
+    uint8_t host_routing;
     store_attribute_callback_t store_attribute_callback;
 } hogpd_params_t;
 
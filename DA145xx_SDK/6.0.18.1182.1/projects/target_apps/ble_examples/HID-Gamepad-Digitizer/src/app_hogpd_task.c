@@ -48,10 +48,11 @@
 #if (BLE_HID_DEVICE)
 
 #include "app_hogpd_task.h"
+#include "app_hogpd.h"
 #include <user_hogpd_config.h>
 #include "app_entry_point.h"
-
-extern uint16_t report_ntf;
+#include "user_trace.h"
+#include "user_encoder.h"
 
 #define REPORT_MAP_LEN sizeof(report_map)
     
@@ -65,6 +66,10 @@ static void app_hogpd_report_upd_rsp_handler(void const *param)
 {
     struct hogpd_report_upd_rsp *par = (struct hogpd_report_upd_rsp *)param;
     
+    user_trace_report_rsp(par->status);
+    app_hogpd_report_upd_rsp(par->conidx);
+    user_encoder_report_rsp();
+
     //Clear pending ack's for param->report_nb == 0 (normal key report) and == 2 (ext. key report)
     switch (par->status) {
         case PRF_ERR_UNEXPECTED_LEN:
@@ -125,7 +130,7 @@ static void app_hogpd_ntf_config_ind_handler(void const *param)
     uint16_t i;
     
     uint16_t new_ntf = ind->ntf_cfg[0];
-    uint16_t ntf_xor = new_ntf ^ report_ntf;
+    uint16_t ntf_xor = new_ntf ^ app_hogpd_get_report_ntf(ind->conidx);
     
     
     if(ntf_xor & 0x01) {
@@ -140,7 +145,7 @@ static void app_hogpd_ntf_config_ind_handler(void const *param)
         }
         index--;
     }
-    report_ntf = new_ntf;
+    app_hogpd_set_report_ntf(ind->conidx, new_ntf);
 }
 
 /**
@@ -135,6 +135,16 @@
 #define CFG_NVDS_TAG_BLE_CA_NB_PKT          100
 #define CFG_NVDS_TAG_BLE_CA_NB_BAD_PKT      50
 
+/****************************************************************************************************************/
+/* NVDS flash store. When defined, nvds_put() and nvds_del() persist tags in two SPI flash sectors starting at  */
+/* CFG_NVDS_FLASH_OFFSET and nvds_get() returns a stored value in place of the default above. The values are    */
+/* picked up by the stack at boot. A put blocks for at most one sector erase.                                   */
+/* Check the store on a host with utilities/host_tests/nvds_store_test.py.                                      */
+/* NOTE: On DA14531 __EXCLUDE_ROM_NVDS__ must be defined so that the NVDS functions are taken from the SDK.     */
+/****************************************************************************************************************/
+#undef CFG_NVDS_FLASH_STORE
+#define CFG_NVDS_FLASH_OFFSET               (0x1C000)
+
 /****************************************************************************************************************/
 /* Enables the logging of heap memories usage. The feature can be used in development/debug mode.               */
 /* Application must be executed in Keil debugger environment and "da14585_586.lib" must be replaced with        */
@@ -359,6 +369,16 @@
 #define CFG_NVDS_TAG_BLE_CA_NB_PKT          100
 #define CFG_NVDS_TAG_BLE_CA_NB_BAD_PKT      50
 
+/****************************************************************************************************************/
+/* NVDS flash store. When defined, nvds_put() and nvds_del() persist tags in two SPI flash sectors starting at  */
+/* CFG_NVDS_FLASH_OFFSET and nvds_get() returns a stored value in place of the default above. The values are    */
+/* picked up by the stack at boot. A put blocks for at most one sector erase.                                   */
+/* Check the store on a host with utilities/host_tests/nvds_store_test.py.                                      */
+/* NOTE: On DA14531 __EXCLUDE_ROM_NVDS__ must be defined so that the NVDS functions are taken from the SDK.     */
+/****************************************************************************************************************/
+#undef CFG_NVDS_FLASH_STORE
+#define CFG_NVDS_FLASH_OFFSET               (0x1C000)
+
 /****************************************************************************************************************/
 /* Enables the logging of heap memories usage. The feature can be used in development/debug mode.               */
 /* Application must be executed in Keil debugger environment and "da14531.lib" must be replaced with            */
@@ -485,6 +505,16 @@
 /****************************************************************************************************************/
 #define CFG_DISABLE_QUADEC_ON_START_UP
 
+/****************************************************************************************************************/
+/* RF calibration scheduler. The die temperature is sampled every 1 to 8 s, more often as the drift from        */
+/* the last RF calibration nears the threshold (RF_CAL_SCHED_THRESHOLD, 8 degrees Celsius), and a calibration   */
+/* also runs when the temperature slope predicts that the drift reaches the threshold before the next sample.   */
+/* A calibration only runs when the next event leaves enough time for it, see arch_rf_cal_get_stats() for       */
+/* the calibrations, the time spent in them and the deferrals. When undefined, the temperature is sampled       */
+/* every 2 s and a calibration runs when the drift reaches 8 degrees Celsius.                                   */
+/****************************************************************************************************************/
+#undef CFG_RF_CAL_SCHED
+
 #endif
 
 #endif // _DA1458X_CONFIG_ADVANCED_H_
@@ -63,6 +63,20 @@
 /****************************************************************************************************************/
 #define CFG_MAX_CONNECTIONS     (1)
 
+/****************************************************************************************************************/
+/* Multi-host HID. If CFG_MULTI_HOST is defined, up to CFG_MAX_CONNECTIONS hosts are connected at the same      */
+/* time and the HID reports are routed as set by host_routing in user_hogpd_config.h. The application task      */
+/* is then taken from the SDK: on the DA14531 link with project_environment/da14531_multi_host_symbols.txt      */
+/* (.lds for GCC) instead of da14531_symbols.txt, see scripts/multi_host_symbols.py.                            */
+/****************************************************************************************************************/
+#undef CFG_MULTI_HOST
+#if defined (CFG_MULTI_HOST)
+#undef CFG_MAX_CONNECTIONS
+#define CFG_MAX_CONNECTIONS     (2)
+#define APP_EASY_MAX_ACTIVE_CONNECTION  (CFG_MAX_CONNECTIONS)
+#define __EXCLUDE_ROM_APP_TASK__
+#endif
+
 /****************************************************************************************************************/
 /* Enables development/debug mode. For production mode builds it must be disabled.                              */
 /* When enabled the following debugging features are enabled                                                    */
@@ -111,6 +125,82 @@
 #undef CFG_SPI_DMA_SUPPORT
 #undef CFG_I2C_DMA_SUPPORT
 
+/****************************************************************************************************************/
+/* Wake-on-UART. If CFG_UART2_WAKEUP is defined, the system runs in extended sleep between the UART2 frames and */
+/* the wake-up pin of user_periph_setup.h wakes it up, see user_uart_wakeup.h. It takes the wakeup interrupt,   */
+/* which on the DA14585/586 is also used by CFG_APP_KEY_MATRIX and CFG_APP_ENCODER. Undefined, the system does  */
+/* not sleep so that UART2 keeps receiving.                                                                     */
+/****************************************************************************************************************/
+#undef CFG_UART2_WAKEUP
+
+/****************************************************************************************************************/
+/* Key matrix. If CFG_APP_KEY_MATRIX is defined, the key matrix listed in user_periph_setup.h is scanned by     */
+/* app_key_matrix: the rows wake the system from extended sleep, the keys are debounced during a short burst of */
+/* scans and sent in the keyboard report, see user_key_matrix.h. On the DA14531 it needs the SWD pins, so       */
+/* DEBUGGING must be undefined in user_periph_setup.h.                                                          */
+/****************************************************************************************************************/
+#undef CFG_APP_KEY_MATRIX
+
+/****************************************************************************************************************/
+/* Quadrature encoder. If CFG_APP_ENCODER is defined, the scroll wheel encoder listed in user_periph_setup.h is */
+/* counted by app_encoder and sent in the mouse report, at most one report per connection event with the motion */
+/* gathered meanwhile, see user_encoder.h. The decoder is released after a second without motion and its pins   */
+/* then wake the system up. It shares the wakeup interrupt with CFG_APP_KEY_MATRIX.                             */
+/****************************************************************************************************************/
+#undef CFG_APP_ENCODER
+
+/****************************************************************************************************************/
+/* Keystroke pacing. If CFG_KBD_PACING is defined, the UART2 keyboard frames are buffered and typed at the pace  */
+/* of the connection events of the active host, one report per character with releases and modifier changes   */
+/* only where the host needs them, see user_kbd.h. A frame waits on the UART while the buffer is full.          */
+/****************************************************************************************************************/
+#undef CFG_KBD_PACING
+
+/****************************************************************************************************************/
+/* Batched database initialization. If CFG_APP_DB_INIT_BATCH is defined, the databases of all the profiles      */
+/* are requested from GAPM at once when the device is configured, instead of one per GAPM_PROFILE_ADDED_IND, so */
+/* advertising starts earlier after reset. See app_db_init_next() in app.c.                                     */
+/****************************************************************************************************************/
+#undef CFG_APP_DB_INIT_BATCH
+
+/****************************************************************************************************************/
+/* RPA resolution cache. If CFG_APP_SEC_RPA_CACHE is defined, the Resolvable Private Address of a bonded host   */
+/* is resolved in software when it connects, from a cache of recently resolved addresses or by trying the IRKs  */
+/* of the most recently used bonds first, so the encryption request is answered without a GAPM_RESOLV_ADDR_CMD. */
+/* See app_easy_security_rpa_prefetch() in app_easy_security.h.                                                 */
+/****************************************************************************************************************/
+#undef CFG_APP_SEC_RPA_CACHE
+
+/****************************************************************************************************************/
+/* PDM microphone audio. If CFG_APP_AUDIO is defined, the PDM microphone listed in user_periph_setup.h is       */
+/* recorded by app_audio while a host subscribes to the Audio characteristic: 16kHz samples are encoded to      */
+/* IMA-ADPCM and notified in frames sized to the ATT MTU, see user_audio.h. DA14585/586 only, the DA14531 has   */
+/* no PDM interface.                                                                                            */
+/****************************************************************************************************************/
+#undef CFG_APP_AUDIO
+
+/****************************************************************************************************************/
+/* Custom service streaming. If CFG_CUSTS1_STREAM is defined, the UART2 frames starting with STREAM_CHAR are    */
+/* notified to the active host through the Server TX characteristic in payloads sized to the negotiated ATT MTU */
+/* and LE Data Length, see user_stream.h. The maximal MTU in user_config.h is then raised to 247 bytes.         */
+/****************************************************************************************************************/
+#undef CFG_CUSTS1_STREAM
+
+/****************************************************************************************************************/
+/* LE credit based channel. If CFG_APP_LECB is defined, the LE_PSM 0x0080 is registered on every connection and */
+/* the SDUs the host sends on the channel are echoed back through app_lecb, which returns the credits of the    */
+/* host as the echoes go out, see user_lecb.h.                                                                  */
+/* It is a demo open to any connected host, without authentication (USER_LECB_SEC_LVL), so it is undefined      */
+/* by default; define CFG_APP_LECB to try the channel.                                                          */
+/****************************************************************************************************************/
+#undef CFG_APP_LECB
+
+/****************************************************************************************************************/
+/* Adaptive battery polling. If CFG_APP_BASS_ADAPTIVE_POLL is defined, the battery level of the Battery Service */
+/* is filtered, converted between the connection events and polled less often while it is stable, see         */
+/* app_bass.h. Undefined, the battery is converted every APP_BASS_POLL_INTERVAL of user_profiles_config.h.     */
+/****************************************************************************************************************/
+#undef CFG_APP_BASS_ADAPTIVE_POLL
 
 
 #else
@@ -144,6 +234,20 @@
 /****************************************************************************************************************/
 #define CFG_MAX_CONNECTIONS     (1)
 
+/****************************************************************************************************************/
+/* Multi-host HID. If CFG_MULTI_HOST is defined, up to CFG_MAX_CONNECTIONS hosts are connected at the same      */
+/* time and the HID reports are routed as set by host_routing in user_hogpd_config.h. The application task      */
+/* is then taken from the SDK: on the DA14531 link with project_environment/da14531_multi_host_symbols.txt      */
+/* (.lds for GCC) instead of da14531_symbols.txt, see scripts/multi_host_symbols.py.                            */
+/****************************************************************************************************************/
+#undef CFG_MULTI_HOST
+#if defined (CFG_MULTI_HOST)
+#undef CFG_MAX_CONNECTIONS
+#define CFG_MAX_CONNECTIONS     (2)
+#define APP_EASY_MAX_ACTIVE_CONNECTION  (CFG_MAX_CONNECTIONS)
+#define __EXCLUDE_ROM_APP_TASK__
+#endif
+
 /****************************************************************************************************************/
 /* Enables development/debug mode. For production mode builds it must be disabled.                              */
 /* When enabled the following debugging features are enabled                                                    */
@@ -194,6 +298,95 @@
 #undef CFG_I2C_DMA_SUPPORT
 #undef CFG_ADC_DMA_SUPPORT
 
+/****************************************************************************************************************/
+/* Wake-on-UART. If CFG_UART2_WAKEUP is defined, the system runs in extended sleep between the UART2 frames and */
+/* the wake-up pin of user_periph_setup.h wakes it up, see user_uart_wakeup.h. It takes the wakeup interrupt,   */
+/* which on the DA14585/586 is also used by CFG_APP_KEY_MATRIX and CFG_APP_ENCODER. Undefined, the system does  */
+/* not sleep so that UART2 keeps receiving.                                                                     */
+/****************************************************************************************************************/
+#undef CFG_UART2_WAKEUP
+
+/****************************************************************************************************************/
+/* Analog axes. If CFG_ADC_AXES is defined, the ADC inputs listed in user_adc_axes.h are sampled continuously   */
+/* through DMA, decimated and sent in a gamepad report of their own, next to the keyboard report of the UART2   */
+/* frames. Requires CFG_ADC_DMA_SUPPORT, defined below.                                                         */
+/****************************************************************************************************************/
+#undef CFG_ADC_AXES
+#if defined (CFG_ADC_AXES)
+#define CFG_ADC_DMA_SUPPORT
+#endif
+
+/****************************************************************************************************************/
+/* Key matrix. If CFG_APP_KEY_MATRIX is defined, the key matrix listed in user_periph_setup.h is scanned by     */
+/* app_key_matrix: the rows wake the system from extended sleep, the keys are debounced during a short burst of */
+/* scans and sent in the keyboard report, see user_key_matrix.h. On the DA14531 it needs the SWD pins, so       */
+/* DEBUGGING must be undefined in user_periph_setup.h.                                                          */
+/****************************************************************************************************************/
+#undef CFG_APP_KEY_MATRIX
+
+/****************************************************************************************************************/
+/* Quadrature encoder. If CFG_APP_ENCODER is defined, the scroll wheel encoder listed in user_periph_setup.h is */
+/* counted by app_encoder and sent in the mouse report, at most one report per connection event with the motion */
+/* gathered meanwhile, see user_encoder.h. The decoder is released after a second without motion and its pins   */
+/* then wake the system up. It shares the wakeup interrupt with CFG_APP_KEY_MATRIX.                             */
+/****************************************************************************************************************/
+#undef CFG_APP_ENCODER
+
+/****************************************************************************************************************/
+/* Keystroke pacing. If CFG_KBD_PACING is defined, the UART2 keyboard frames are buffered and typed at the pace  */
+/* of the connection events of the active host, one report per character with releases and modifier changes   */
+/* only where the host needs them, see user_kbd.h. A frame waits on the UART while the buffer is full.          */
+/****************************************************************************************************************/
+#undef CFG_KBD_PACING
+
+/****************************************************************************************************************/
+/* Batched database initialization. If CFG_APP_DB_INIT_BATCH is defined, the databases of all the profiles      */
+/* are requested from GAPM at once when the device is configured, instead of one per GAPM_PROFILE_ADDED_IND, so */
+/* advertising starts earlier after reset. See app_db_init_next() in app.c.                                     */
+/****************************************************************************************************************/
+#undef CFG_APP_DB_INIT_BATCH
+
+/****************************************************************************************************************/
+/* RPA resolution cache. If CFG_APP_SEC_RPA_CACHE is defined, the Resolvable Private Address of a bonded host   */
+/* is resolved in software when it connects, from a cache of recently resolved addresses or by trying the IRKs  */
+/* of the most recently used bonds first, so the encryption request is answered without a GAPM_RESOLV_ADDR_CMD. */
+/* See app_easy_security_rpa_prefetch() in app_easy_security.h.                                                 */
+/****************************************************************************************************************/
+#undef CFG_APP_SEC_RPA_CACHE
+
+/****************************************************************************************************************/
+/* Custom service streaming. If CFG_CUSTS1_STREAM is defined, the UART2 frames starting with STREAM_CHAR are    */
+/* notified to the active host through the Server TX characteristic in payloads sized to the negotiated ATT MTU */
+/* and LE Data Length, see user_stream.h. The maximal MTU in user_config.h is then raised to 247 bytes.         */
+/****************************************************************************************************************/
+#undef CFG_CUSTS1_STREAM
+
+/****************************************************************************************************************/
+/* LE credit based channel. If CFG_APP_LECB is defined, the LE_PSM 0x0080 is registered on every connection and */
+/* the SDUs the host sends on the channel are echoed back through app_lecb, which returns the credits of the    */
+/* host as the echoes go out, see user_lecb.h.                                                                  */
+/* It is a demo open to any connected host, without authentication (USER_LECB_SEC_LVL), so it is undefined      */
+/* by default; define CFG_APP_LECB to try the channel.                                                          */
+/****************************************************************************************************************/
+#undef CFG_APP_LECB
+
+/****************************************************************************************************************/
+/* Adaptive battery polling. If CFG_APP_BASS_ADAPTIVE_POLL is defined, the battery level of the Battery Service */
+/* is filtered, converted between the connection events and polled less often while it is stable, see         */
+/* app_bass.h. Undefined, the battery is converted every APP_BASS_POLL_INTERVAL of user_profiles_config.h.     */
+/****************************************************************************************************************/
+#undef CFG_APP_BASS_ADAPTIVE_POLL
+
+/****************************************************************************************************************/
+/* Drift compensated time. If CFG_APP_TIME is defined, app_time keeps the local time on the RTC, corrected for  */
+/* the error of the RCX20 divider and the drift learned from the writes of the Current Time Service client,     */
+/* which is added to the database as CFG_PRF_CTSS, see app_time.h. DA14531 only, the DA14585/586 have no RTC.   */
+/****************************************************************************************************************/
+#undef CFG_APP_TIME
+#if defined (CFG_APP_TIME)
+#define CFG_PRF_CTSS
+#endif
+
 /****************************************************************************************************************/
 /* Notify the SDK about the fixed power mode (currently used only for Bypass):                                  */
 /*     - CFG_POWER_MODE_BYPASS = Bypass mode                                                                    */
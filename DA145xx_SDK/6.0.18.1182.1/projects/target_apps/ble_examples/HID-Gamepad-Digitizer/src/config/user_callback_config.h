@@ -48,7 +48,20 @@
 #if (BLE_HID_DEVICE)
 #include "app_hogpd.h"
 #endif
+#if (BLE_BATT_SERVER)
+#include "app_bass.h"
+#endif
+#if (BLE_CTS_SERVER)
+#include "app_ctss.h"
+#include "app_time.h"
+#endif
 #include "user_peripheral.h"
+#include "user_conn_ctrl.h"
+#include "user_uart_wakeup.h"
+#include "user_heap_mon.h"
+#include "user_adc_axes.h"
+#include "user_stream.h"
+#include "user_lecb.h"
 
 /*
  * LOCAL VARIABLE DEFINITIONS
@@ -58,8 +71,8 @@
 static const struct app_callbacks user_app_callbacks = {
     .app_on_connection                  = user_app_connection,
     .app_on_disconnect                  = user_app_disconnect,
-    .app_on_update_params_rejected      = NULL,
-    .app_on_update_params_complete      = NULL,
+    .app_on_update_params_rejected      = user_conn_ctrl_on_update_rejected,
+    .app_on_update_params_complete      = user_conn_ctrl_on_update_complete,
     .app_on_set_dev_config_complete     = default_app_on_set_dev_config_complete,
     .app_on_adv_nonconn_complete        = NULL,
     .app_on_adv_undirect_complete       = user_app_adv_undirect_complete,
@@ -71,7 +84,11 @@ static const struct app_callbacks user_app_callbacks = {
     .app_on_get_dev_appearance          = default_app_on_get_dev_appearance,
     .app_on_get_dev_slv_pref_params     = default_app_on_get_dev_slv_pref_params,
     .app_on_set_dev_info                = default_app_on_set_dev_info,
+#if defined (CFG_CUSTS1_STREAM)
+    .app_on_data_length_change          = user_stream_data_length_changed,
+#else
     .app_on_data_length_change          = NULL,
+#endif
     .app_on_update_params_request       = default_app_update_params_request,
     .app_on_generate_static_random_addr = default_app_generate_static_random_addr,
     .app_on_svc_changed_cfg_ind         = NULL,
@@ -86,8 +103,8 @@ static const struct app_callbacks user_app_callbacks = {
     .app_on_encrypt_ind                 = NULL,
     .app_on_encrypt_req_ind             = default_app_on_encrypt_req_ind,
     .app_on_security_req_ind            = NULL,
-    .app_on_addr_solved_ind             = NULL,
-    .app_on_addr_resolve_failed         = NULL,
+    .app_on_addr_solved_ind             = default_app_on_addr_solved_ind,
+    .app_on_addr_resolve_failed         = default_app_on_addr_resolve_failed,
     .app_on_ral_cmp_evt                 = NULL,
     .app_on_ral_size_ind                = NULL,
     .app_on_ral_addr_ind                = NULL,
@@ -107,6 +124,33 @@ static const struct app_bond_db_callbacks user_app_bond_db_callbacks = {
 };
 #endif // (BLE_APP_SEC)
 
+#if (BLE_BATT_SERVER)
+static const struct app_bass_cb user_app_bass_cb = {
+    .on_batt_level_upd_rsp              = NULL,
+    .on_batt_level_ntf_cfg_ind          = NULL,
+};
+#endif // (BLE_BATT_SERVER)
+
+#if (BLE_CTS_SERVER)
+static const struct app_ctss_cb user_app_ctss_cb = {
+    .on_cur_time_read_req               = app_time_ctss_read,
+    .on_cur_time_write_req              = app_time_ctss_write,
+    .on_cur_time_notified               = NULL,
+    .on_loc_time_info_write_req         = NULL,
+    .on_ref_time_info_read_req          = app_time_ctss_ref_info,
+};
+#endif // (BLE_CTS_SERVER)
+
+#if (BLE_APP_LECB)
+static const struct app_lecb_cb user_app_lecb_cb = {
+    .on_lecb_connect_req                = user_lecb_connect_req,
+    .on_lecb_connected                  = NULL,
+    .on_lecb_disconnected               = user_lecb_disconnected,
+    .on_lecb_sdu_received               = user_lecb_sdu_received,
+    .on_lecb_sdu_sent                   = user_lecb_sdu_sent,
+};
+#endif // (BLE_APP_LECB)
+
 
 /*
  * "app_process_catch_rest_cb" symbol handling:
@@ -123,7 +167,7 @@ static const struct arch_main_loop_callbacks user_app_main_loop_callbacks = {
     // The user has to take into account the watchdog timer handling (keep it running,
     // freeze it, reload it, resume it, etc), when the app_on_ble_powered() is being
     // called and may potentially affect the main loop.
-    .app_on_ble_powered     = NULL,
+    .app_on_ble_powered     = user_app_on_ble_powered,
 
     // By default the watchdog timer is reloaded and resumed when the system wakes up.
     // The user has to take into account the watchdog timer handling (keep it running,
@@ -132,9 +176,17 @@ static const struct arch_main_loop_callbacks user_app_main_loop_callbacks = {
     .app_on_system_powered  = NULL,
 
     .app_before_sleep       = NULL,
+#if defined (CFG_ADC_AXES)
+    .app_validate_sleep     = user_adc_axes_validate_sleep,
+#else
     .app_validate_sleep     = NULL,
+#endif
     .app_going_to_sleep     = NULL,
+#if defined (CFG_UART2_WAKEUP)
+    .app_resume_from_sleep  = user_uart_wakeup_resume,
+#else
     .app_resume_from_sleep  = NULL,
+#endif
 };
 
 // Default Handler Operations
@@ -93,7 +93,11 @@
  *
  ******************************************
  */
+#if defined (CFG_UART2_WAKEUP)
+static const sleep_state_t app_default_sleep_mode = ARCH_EXT_SLEEP_ON;
+#else
 static const sleep_state_t app_default_sleep_mode = ARCH_SLEEP_OFF;
+#endif
 
 /*
  ****************************************************************************************
@@ -224,7 +228,11 @@ static const struct gapm_configuration user_gapm_conf = {
 
     /// Maximal MTU. Shall be set to 23 if Legacy Pairing is used, 65 if Secure Connection is used,
     /// more if required by the application
+#if defined (CFG_CUSTS1_STREAM)
+    .max_mtu = 247,
+#else
     .max_mtu = 23,
+#endif
 
     /// Device Address Type
     .addr_type = APP_CFG_ADDR_TYPE(USER_CFG_ADDRESS_MODE),
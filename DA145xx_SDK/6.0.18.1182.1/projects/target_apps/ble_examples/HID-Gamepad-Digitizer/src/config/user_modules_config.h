@@ -60,16 +60,18 @@
 /***************************************************************************************/
 #define EXCLUDE_DLG_GAP             (0)
 #define EXCLUDE_DLG_TIMER           (0)
-#define EXCLUDE_DLG_MSG             (1)
+#define EXCLUDE_DLG_MSG             (0)
 #define EXCLUDE_DLG_SEC             (0)
 #define EXCLUDE_DLG_DISS            (0)
 #define EXCLUDE_DLG_PROXR           (1)
-#define EXCLUDE_DLG_BASS            (1)
+#define EXCLUDE_DLG_BASS            (0)
+#define EXCLUDE_DLG_CTSS            (0)
 #define EXCLUDE_DLG_FINDL           (1)
 #define EXCLUDE_DLG_FINDT           (1)
 #define EXCLUDE_DLG_SUOTAR          (1)
 #define EXCLUDE_DLG_CUSTS1          (0)
 #define EXCLUDE_DLG_CUSTS2          (1)
+#define EXCLUDE_DLG_LECB            (0)
 
 /// @} APP
 
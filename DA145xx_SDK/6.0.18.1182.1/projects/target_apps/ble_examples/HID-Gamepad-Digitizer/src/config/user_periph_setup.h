@@ -64,6 +64,24 @@
     #define UART2_TX_PIN            GPIO_PIN_4
 #endif
 
+// Define UART2 wake-up pin. Defaults to the RX pin: the start bit of the first byte wakes
+// the system. Point it to a separate pin if the host drives a dedicated wake line.
+#if defined (__DA14531__)
+    #define UART2_WAKEUP_PORT       UART2_RX_PORT
+    #define UART2_WAKEUP_PIN        UART2_RX_PIN
+#else
+    #define UART2_WAKEUP_PORT       GPIO_PORT_0
+    #define UART2_WAKEUP_PIN        GPIO_PIN_5
+#endif
+
+// Wake-up pin debounce time in ms (0 - 63)
+#define UART2_WAKEUP_DEB_TIME       (0)
+
+// Byte sent by the host in front of a frame to wake the system. It is discarded when it
+// starts a frame. The host waits UART2_WAKEUP_HOST_DELAY_MS before sending the frame.
+#define UART2_WAKEUP_PREAMBLE       (0x00)
+#define UART2_WAKEUP_HOST_DELAY_MS  (5)
+
 
 /****************************************************************************************/
 /* Debug define                                                                         */
@@ -73,6 +91,21 @@
 // If this is defined, both joysticks will share the same x axis input. And SWD is not disabled  
 #define DEBUGGING
 
+// Analog axes inputs, sampled when CFG_ADC_AXES is defined. P0_1 and P0_6 are taken by the
+// SPI flash and UART2, so the Y axis uses the SWD clock pin P0_2.
+#define ADC_AXIS_X_PORT             GPIO_PORT_0
+#define ADC_AXIS_X_PIN              GPIO_PIN_7
+#define ADC_AXIS_X_INPUT            ADC_INPUT_SE_P0_7
+#if defined (DEBUGGING)
+    #define ADC_AXIS_Y_PORT         ADC_AXIS_X_PORT
+    #define ADC_AXIS_Y_PIN          ADC_AXIS_X_PIN
+    #define ADC_AXIS_Y_INPUT        ADC_AXIS_X_INPUT
+#else
+    #define ADC_AXIS_Y_PORT         GPIO_PORT_0
+    #define ADC_AXIS_Y_PIN          GPIO_PIN_2
+    #define ADC_AXIS_Y_INPUT        ADC_INPUT_SE_P0_2
+#endif
+
 // Define UART2 Settings
 #define UART2_BAUDRATE              UART_BAUDRATE_115200
 #define UART2_DATABITS              UART_DATABITS_8
@@ -95,6 +128,15 @@
     #define GPIO_LED_PIN            GPIO_PIN_0
 #endif
 
+/****************************************************************************************/
+/* Battery level alert configuration                                                    */
+/****************************************************************************************/
+// app_bass blinks the LED while the battery level is low if USE_BAT_LEVEL_ALERT is 1. The
+// LED belongs to the application, so the alert is left off.
+#define USE_BAT_LEVEL_ALERT         (0)
+#define GPIO_BAT_LED_PORT           GPIO_LED_PORT
+#define GPIO_BAT_LED_PIN            GPIO_LED_PIN
+
 /****************************************************************************************/
 /* SPI configuration                                                                    */
 /****************************************************************************************/
@@ -143,6 +185,67 @@
     #define GAMEPAD_BUTTON_SEL_PIN  GPIO_PIN_6
 #endif
 
+/****************************************************************************************/
+/* Key matrix configuration                                                             */
+/****************************************************************************************/
+// Scanned when CFG_APP_KEY_MATRIX is defined, see user_key_matrix.c. The rows are armed on
+// the wakeup controller. On the DA14531 the columns take the SWD data pin and the pin of
+// the production debug output, so the debugger is disabled by periph_init().
+#if defined (__DA14531__)
+    #define KEY_MATRIX_ROW0_PORT    GPIO_PORT_0
+    #define KEY_MATRIX_ROW0_PIN     GPIO_PIN_8
+    #define KEY_MATRIX_ROW1_PORT    GPIO_PORT_0
+    #define KEY_MATRIX_ROW1_PIN     GPIO_PIN_9
+    #define KEY_MATRIX_COL0_PORT    GPIO_PORT_0
+    #define KEY_MATRIX_COL0_PIN     GPIO_PIN_10
+    #define KEY_MATRIX_COL1_PORT    GPIO_PORT_0
+    #define KEY_MATRIX_COL1_PIN     GPIO_PIN_11
+#if defined (CFG_APP_KEY_MATRIX) && (defined (DEBUGGING) || PRODUCTION_DEBUG_OUTPUT)
+    #error "The key matrix uses the SWD and production debug pins, undefine DEBUGGING"
+#endif
+#else
+    #define KEY_MATRIX_ROW0_PORT    GPIO_PORT_1
+    #define KEY_MATRIX_ROW0_PIN     GPIO_PIN_2
+    #define KEY_MATRIX_ROW1_PORT    GPIO_PORT_1
+    #define KEY_MATRIX_ROW1_PIN     GPIO_PIN_3
+    #define KEY_MATRIX_COL0_PORT    GPIO_PORT_2
+    #define KEY_MATRIX_COL0_PIN     GPIO_PIN_6
+    #define KEY_MATRIX_COL1_PORT    GPIO_PORT_2
+    #define KEY_MATRIX_COL1_PIN     GPIO_PIN_7
+#endif
+
+/****************************************************************************************/
+/* Quadrature encoder configuration                                                     */
+/****************************************************************************************/
+// Counted when CFG_APP_ENCODER is defined, see user_encoder.c. The scroll wheel encoder is
+// on the Z channel of the quadrature decoder, the X and Y channels are not connected. The
+// pins are armed on the wakeup controller while the encoder is idle.
+#if defined (__DA14531__)
+    #define ENCODER_A_PORT          GPIO_PORT_0
+    #define ENCODER_A_PIN           GPIO_PIN_8
+    #define ENCODER_B_PORT          GPIO_PORT_0
+    #define ENCODER_B_PIN           GPIO_PIN_9
+    #define ENCODER_Z_PORT_SEL      QUAD_DEC_CHZA_P08_AND_CHZB_P09
+#else
+    #define ENCODER_A_PORT          GPIO_PORT_1
+    #define ENCODER_A_PIN           GPIO_PIN_2
+    #define ENCODER_B_PORT          GPIO_PORT_1
+    #define ENCODER_B_PIN           GPIO_PIN_3
+    #define ENCODER_Z_PORT_SEL      QUAD_DEC_CHZA_P12_AND_CHZB_P13
+#endif
+
+/****************************************************************************************/
+/* PDM microphone configuration                                                         */
+/****************************************************************************************/
+// Recorded when CFG_APP_AUDIO is defined, see user_audio.c. The PDM interface drives the
+// clock pin, the microphone answers on the data pin. The DA14531 has no PDM interface.
+#if !defined (__DA14531__)
+    #define AUDIO_PDM_CLK_PORT      GPIO_PORT_0
+    #define AUDIO_PDM_CLK_PIN       GPIO_PIN_2
+    #define AUDIO_PDM_DATA_PORT     GPIO_PORT_0
+    #define AUDIO_PDM_DATA_PIN      GPIO_PIN_3
+#endif
+
 /****************************************************************************************/
 /* Gamepad joysticks configuration                                                      */
 /****************************************************************************************/
@@ -54,7 +54,9 @@
 
 #define CFG_PRF_HOGPD
 #define CFG_PRF_DISS
+#define CFG_PRF_BASS
 #define CFG_PRF_CUST1
+// CFG_PRF_CTSS is defined with CFG_APP_TIME in da1458x_config_basic.h
 
 /***************************************************************************************/
 /* Profile application configuration section                                           */
@@ -131,6 +133,24 @@
 #define APP_DIS_PNP_ID                  ("\x01\xD2\x00\x80\x05\x00\x01")
 #define APP_DIS_PNP_ID_LEN              (7)
 
+/*
+ ****************************************************************************************
+ * BASS application profile configuration
+ ****************************************************************************************
+ */
+
+/// Battery poll period in 10ms units, the shortest one with CFG_APP_BASS_ADAPTIVE_POLL
+#define APP_BASS_POLL_INTERVAL          (6000)
+
+/*
+ ****************************************************************************************
+ * CTSS application profile configuration
+ ****************************************************************************************
+ */
+
+/// The client writes the Current Time, app_time reports the time since it last did
+#define APP_CTS_FEATURES                (CTSS_CURRENT_TIME_WRITE_SUP | CTSS_REF_TIME_INFO_SUP)
+
 /*
  ****************************************************************************************
  * CUST1 application profile configuration
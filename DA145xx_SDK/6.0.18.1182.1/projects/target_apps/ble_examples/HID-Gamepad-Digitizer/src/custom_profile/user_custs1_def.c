@@ -59,6 +59,15 @@ static const att_svc_desc128_t custs1_svc1                      = DEF_SVC1_UUID_
 
 static const uint8_t CUST1_SERVER_TX_UUID_128[ATT_UUID_128_LEN]       = DEF_CUST1_SERVER_TX_UUID_128;
 static const uint8_t CUST1_SERVER_RX_UUID_128[ATT_UUID_128_LEN]        = DEF_CUST1_SERVER_RX_UUID_128;
+static const uint8_t CUST1_TRACE_STATS_UUID_128[ATT_UUID_128_LEN]      = DEF_CUST1_TRACE_STATS_UUID_128;
+static const uint8_t CUST1_HEAP_STATS_UUID_128[ATT_UUID_128_LEN]       = DEF_CUST1_HEAP_STATS_UUID_128;
+#if defined (CFG_CUSTS1_STREAM)
+static const uint8_t CUST1_STREAM_STATS_UUID_128[ATT_UUID_128_LEN]     = DEF_CUST1_STREAM_STATS_UUID_128;
+#endif
+#if defined (CFG_APP_AUDIO)
+static const uint8_t CUST1_AUDIO_UUID_128[ATT_UUID_128_LEN]            = DEF_CUST1_AUDIO_UUID_128;
+static const uint8_t CUST1_AUDIO_STATS_UUID_128[ATT_UUID_128_LEN]      = DEF_CUST1_AUDIO_STATS_UUID_128;
+#endif
 
 static struct att_char128_desc custs1_server_rx_char        = {ATT_CHAR_PROP_WR_NO_RESP,
                                                               {0, 0},
@@ -68,6 +77,30 @@ static struct att_char128_desc custs1_server_tx_char        = {ATT_CHAR_PROP_NTF
                                                               {0, 0},
                                                               DEF_CUST1_SERVER_TX_UUID_128};
 
+static struct att_char128_desc custs1_trace_stats_char      = {ATT_CHAR_PROP_RD | ATT_CHAR_PROP_WR,
+                                                              {0, 0},
+                                                              DEF_CUST1_TRACE_STATS_UUID_128};
+
+static struct att_char128_desc custs1_heap_stats_char       = {ATT_CHAR_PROP_RD | ATT_CHAR_PROP_WR,
+                                                              {0, 0},
+                                                              DEF_CUST1_HEAP_STATS_UUID_128};
+
+#if defined (CFG_CUSTS1_STREAM)
+static struct att_char128_desc custs1_stream_stats_char     = {ATT_CHAR_PROP_RD | ATT_CHAR_PROP_WR,
+                                                              {0, 0},
+                                                              DEF_CUST1_STREAM_STATS_UUID_128};
+#endif
+
+#if defined (CFG_APP_AUDIO)
+static struct att_char128_desc custs1_audio_char            = {ATT_CHAR_PROP_NTF,
+                                                              {0, 0},
+                                                              DEF_CUST1_AUDIO_UUID_128};
+
+static struct att_char128_desc custs1_audio_stats_char      = {ATT_CHAR_PROP_RD | ATT_CHAR_PROP_WR,
+                                                              {0, 0},
+                                                              DEF_CUST1_AUDIO_STATS_UUID_128};
+#endif
+
 // Attribute specifications
 static const uint16_t att_decl_svc       = ATT_DECL_PRIMARY_SERVICE;
 static const uint16_t att_decl_char      = ATT_DECL_CHARACTERISTIC;
@@ -122,6 +155,74 @@ const struct attm_desc_128 custs1_att_db[CUSTS1_IDX_NB] =
     // Server TX Characteristic User Description
     [CUST1_IDX_SERVER_TX_USER_DESC]     = {(uint8_t*)&att_desc_user_desc, ATT_UUID_16_LEN, PERM(RD, ENABLE),
                                             sizeof(CUST1_SERVER_TX_USER_DESC) - 1, sizeof(CUST1_SERVER_TX_USER_DESC) - 1, (uint8_t *)CUST1_SERVER_TX_USER_DESC},
+
+    // Latency Stats Characteristic Declaration
+    [CUST1_IDX_TRACE_STATS_CHAR]        = {(uint8_t*)&att_decl_char, ATT_UUID_16_LEN, PERM(RD, ENABLE),
+                                            sizeof(custs1_trace_stats_char), sizeof(custs1_trace_stats_char), (uint8_t*)&custs1_trace_stats_char},
+
+    // Latency Stats Characteristic Value, read from the application, any write clears the statistics
+    [CUST1_IDX_TRACE_STATS_VAL]         = {CUST1_TRACE_STATS_UUID_128, ATT_UUID_128_LEN, PERM(RD, ENABLE) | PERM(WR, ENABLE) | PERM(WRITE_REQ, ENABLE),
+                                            DEF_CUST1_TRACE_STATS_CHAR_LEN | PERM(RI, ENABLE), 0, NULL},
+
+    // Latency Stats Characteristic User Description
+    [CUST1_IDX_TRACE_STATS_USER_DESC]   = {(uint8_t*)&att_desc_user_desc, ATT_UUID_16_LEN, PERM(RD, ENABLE),
+                                            sizeof(CUST1_TRACE_STATS_USER_DESC) - 1, sizeof(CUST1_TRACE_STATS_USER_DESC) - 1, (uint8_t *)CUST1_TRACE_STATS_USER_DESC},
+
+    // Heap Stats Characteristic Declaration
+    [CUST1_IDX_HEAP_STATS_CHAR]         = {(uint8_t*)&att_decl_char, ATT_UUID_16_LEN, PERM(RD, ENABLE),
+                                            sizeof(custs1_heap_stats_char), sizeof(custs1_heap_stats_char), (uint8_t*)&custs1_heap_stats_char},
+
+    // Heap Stats Characteristic Value, read from the application, any write clears the statistics
+    [CUST1_IDX_HEAP_STATS_VAL]          = {CUST1_HEAP_STATS_UUID_128, ATT_UUID_128_LEN, PERM(RD, ENABLE) | PERM(WR, ENABLE) | PERM(WRITE_REQ, ENABLE),
+                                            DEF_CUST1_HEAP_STATS_CHAR_LEN | PERM(RI, ENABLE), 0, NULL},
+
+    // Heap Stats Characteristic User Description
+    [CUST1_IDX_HEAP_STATS_USER_DESC]    = {(uint8_t*)&att_desc_user_desc, ATT_UUID_16_LEN, PERM(RD, ENABLE),
+                                            sizeof(CUST1_HEAP_STATS_USER_DESC) - 1, sizeof(CUST1_HEAP_STATS_USER_DESC) - 1, (uint8_t *)CUST1_HEAP_STATS_USER_DESC},
+
+#if defined (CFG_CUSTS1_STREAM)
+    // Stream Stats Characteristic Declaration
+    [CUST1_IDX_STREAM_STATS_CHAR]       = {(uint8_t*)&att_decl_char, ATT_UUID_16_LEN, PERM(RD, ENABLE),
+                                            sizeof(custs1_stream_stats_char), sizeof(custs1_stream_stats_char), (uint8_t*)&custs1_stream_stats_char},
+
+    // Stream Stats Characteristic Value, read from the application, any write clears the statistics
+    [CUST1_IDX_STREAM_STATS_VAL]        = {CUST1_STREAM_STATS_UUID_128, ATT_UUID_128_LEN, PERM(RD, ENABLE) | PERM(WR, ENABLE) | PERM(WRITE_REQ, ENABLE),
+                                            DEF_CUST1_STREAM_STATS_CHAR_LEN | PERM(RI, ENABLE), 0, NULL},
+
+    // Stream Stats Characteristic User Description
+    [CUST1_IDX_STREAM_STATS_USER_DESC]  = {(uint8_t*)&att_desc_user_desc, ATT_UUID_16_LEN, PERM(RD, ENABLE),
+                                            sizeof(CUST1_STREAM_STATS_USER_DESC) - 1, sizeof(CUST1_STREAM_STATS_USER_DESC) - 1, (uint8_t *)CUST1_STREAM_STATS_USER_DESC},
+#endif
+
+#if defined (CFG_APP_AUDIO)
+    // Audio Characteristic Declaration
+    [CUST1_IDX_AUDIO_CHAR]              = {(uint8_t*)&att_decl_char, ATT_UUID_16_LEN, PERM(RD, ENABLE),
+                                            sizeof(custs1_audio_char), sizeof(custs1_audio_char), (uint8_t*)&custs1_audio_char},
+
+    // Audio Characteristic Value, frames notified by user_audio.c
+    [CUST1_IDX_AUDIO_VAL]               = {CUST1_AUDIO_UUID_128, ATT_UUID_128_LEN, PERM(NTF, ENABLE),
+                                            DEF_CUST1_AUDIO_CHAR_LEN, 0, NULL},
+
+    // Audio Client Characteristic Configuration Descriptor, starts and stops the microphone
+    [CUST1_IDX_AUDIO_NTF_CFG]           = {(uint8_t*)&att_desc_cfg, ATT_UUID_16_LEN, PERM(RD, ENABLE) | PERM(WR, ENABLE) | PERM(WRITE_REQ, ENABLE) | PERM(WRITE_COMMAND, ENABLE),
+                                            sizeof(uint16_t), 0, NULL},
+
+    // Audio Characteristic User Description
+    [CUST1_IDX_AUDIO_USER_DESC]         = {(uint8_t*)&att_desc_user_desc, ATT_UUID_16_LEN, PERM(RD, ENABLE),
+                                            sizeof(CUST1_AUDIO_USER_DESC) - 1, sizeof(CUST1_AUDIO_USER_DESC) - 1, (uint8_t *)CUST1_AUDIO_USER_DESC},
+
+    // Audio Stats Characteristic Declaration
+    [CUST1_IDX_AUDIO_STATS_CHAR]        = {(uint8_t*)&att_decl_char, ATT_UUID_16_LEN, PERM(RD, ENABLE),
+                                            sizeof(custs1_audio_stats_char), sizeof(custs1_audio_stats_char), (uint8_t*)&custs1_audio_stats_char},
+
+    // Audio Stats Characteristic Value, read from the application, any write clears the statistics
+    [CUST1_IDX_AUDIO_STATS_VAL]         = {CUST1_AUDIO_STATS_UUID_128, ATT_UUID_128_LEN, PERM(RD, ENABLE) | PERM(WR, ENABLE) | PERM(WRITE_REQ, ENABLE),
+                                            DEF_CUST1_AUDIO_STATS_CHAR_LEN | PERM(RI, ENABLE), 0, NULL},
+
+    // Audio Stats Characteristic User Description
+    [CUST1_IDX_AUDIO_STATS_USER_DESC]   = {(uint8_t*)&att_desc_user_desc, ATT_UUID_16_LEN, PERM(RD, ENABLE),
+                                            sizeof(CUST1_AUDIO_STATS_USER_DESC) - 1, sizeof(CUST1_AUDIO_STATS_USER_DESC) - 1, (uint8_t *)CUST1_AUDIO_STATS_USER_DESC},
+#endif
 };
 
 /// @} USER_CONFIG
@@ -58,13 +58,33 @@
 
 #define DEF_CUST1_SERVER_TX_UUID_128      {0xb8, 0x5c, 0x49, 0xd2, 0x04, 0xa3, 0x40, 0x71, 0xa0, 0xb5, 0x35, 0x85, 0x3e, 0xb0, 0x83, 0x07}
 #define DEF_CUST1_SERVER_RX_UUID_128      {0xba, 0x5c, 0x49, 0xd2, 0x04, 0xa3, 0x40, 0x71, 0xa0, 0xb5, 0x35, 0x85, 0x3e, 0xb0, 0x83, 0x07}
+#define DEF_CUST1_TRACE_STATS_UUID_128    {0xbb, 0x5c, 0x49, 0xd2, 0x04, 0xa3, 0x40, 0x71, 0xa0, 0xb5, 0x35, 0x85, 0x3e, 0xb0, 0x83, 0x07}
+#define DEF_CUST1_HEAP_STATS_UUID_128     {0xbc, 0x5c, 0x49, 0xd2, 0x04, 0xa3, 0x40, 0x71, 0xa0, 0xb5, 0x35, 0x85, 0x3e, 0xb0, 0x83, 0x07}
+#define DEF_CUST1_STREAM_STATS_UUID_128   {0xbd, 0x5c, 0x49, 0xd2, 0x04, 0xa3, 0x40, 0x71, 0xa0, 0xb5, 0x35, 0x85, 0x3e, 0xb0, 0x83, 0x07}
+#define DEF_CUST1_AUDIO_UUID_128          {0xbe, 0x5c, 0x49, 0xd2, 0x04, 0xa3, 0x40, 0x71, 0xa0, 0xb5, 0x35, 0x85, 0x3e, 0xb0, 0x83, 0x07}
+#define DEF_CUST1_AUDIO_STATS_UUID_128    {0xbf, 0x5c, 0x49, 0xd2, 0x04, 0xa3, 0x40, 0x71, 0xa0, 0xb5, 0x35, 0x85, 0x3e, 0xb0, 0x83, 0x07}
 
 //length = MTU - 3, change it when increasing MTU or use DLE
 #define DEF_CUST1_SERVER_TX_CHAR_LEN      (247 - 3)
 #define DEF_CUST1_SERVER_RX_CHAR_LEN      (247 - 3)
+//value is built on read, see user_trace_stats_pack()
+#define DEF_CUST1_TRACE_STATS_CHAR_LEN    (128)
+//value is built on read, see user_heap_mon_stats_pack()
+#define DEF_CUST1_HEAP_STATS_CHAR_LEN     (64)
+//value is built on read, see user_stream_stats_pack()
+#define DEF_CUST1_STREAM_STATS_CHAR_LEN   (32)
+//one app_audio frame per notification, see user_audio.h
+#define DEF_CUST1_AUDIO_CHAR_LEN          (247 - 3)
+//value is built on read, see user_audio_stats_pack()
+#define DEF_CUST1_AUDIO_STATS_CHAR_LEN    (32)
 
 #define CUST1_SERVER_TX_USER_DESC     "Server TX Data"
 #define CUST1_SERVER_RX_USER_DESC     "Server RX Data"
+#define CUST1_TRACE_STATS_USER_DESC   "Latency Stats"
+#define CUST1_HEAP_STATS_USER_DESC    "Heap Stats"
+#define CUST1_STREAM_STATS_USER_DESC  "Stream Stats"
+#define CUST1_AUDIO_USER_DESC         "Audio"
+#define CUST1_AUDIO_STATS_USER_DESC   "Audio Stats"
 
 /// Custom1 Service Data Base Characteristic enum
 enum
@@ -81,6 +101,31 @@ enum
     CUST1_IDX_SERVER_TX_NTF_CFG,
     CUST1_IDX_SERVER_TX_USER_DESC,
 
+    CUST1_IDX_TRACE_STATS_CHAR,
+    CUST1_IDX_TRACE_STATS_VAL,
+    CUST1_IDX_TRACE_STATS_USER_DESC,
+
+    CUST1_IDX_HEAP_STATS_CHAR,
+    CUST1_IDX_HEAP_STATS_VAL,
+    CUST1_IDX_HEAP_STATS_USER_DESC,
+
+#if defined (CFG_CUSTS1_STREAM)
+    CUST1_IDX_STREAM_STATS_CHAR,
+    CUST1_IDX_STREAM_STATS_VAL,
+    CUST1_IDX_STREAM_STATS_USER_DESC,
+#endif
+
+#if defined (CFG_APP_AUDIO)
+    CUST1_IDX_AUDIO_CHAR,
+    CUST1_IDX_AUDIO_VAL,
+    CUST1_IDX_AUDIO_NTF_CFG,
+    CUST1_IDX_AUDIO_USER_DESC,
+
+    CUST1_IDX_AUDIO_STATS_CHAR,
+    CUST1_IDX_AUDIO_STATS_VAL,
+    CUST1_IDX_AUDIO_STATS_USER_DESC,
+#endif
+
     CUSTS1_IDX_NB
 };
 
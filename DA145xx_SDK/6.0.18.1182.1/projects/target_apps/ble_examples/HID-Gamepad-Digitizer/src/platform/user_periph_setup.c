@@ -44,6 +44,8 @@
 #include "uart.h"
 #include "syscntl.h"
 #include "arch_console.h"
+#include "app_key_matrix.h"
+#include "app_encoder.h"
 
 /*
  * GLOBAL VARIABLE DEFINITIONS
@@ -92,6 +94,26 @@ void GPIO_reservations(void)
 		RESERVE_GPIO(SPI_CLK, SPI_CLK_PORT, SPI_CLK_PIN, PID_SPI_CLK);
 		RESERVE_GPIO(SPI_DO, SPI_DO_PORT, SPI_DO_PIN, PID_SPI_DO);
 		RESERVE_GPIO(SPI_DI, SPI_DI_PORT, SPI_DI_PIN, PID_SPI_DI);
+#if defined (CFG_ADC_AXES)
+    RESERVE_GPIO(ADC_AXIS_X, ADC_AXIS_X_PORT, ADC_AXIS_X_PIN, PID_ADC);
+#if !defined (DEBUGGING)
+    RESERVE_GPIO(ADC_AXIS_Y, ADC_AXIS_Y_PORT, ADC_AXIS_Y_PIN, PID_ADC);
+#endif
+#endif
+#if defined (CFG_APP_KEY_MATRIX)
+    RESERVE_GPIO(KEY_MATRIX_ROW0, KEY_MATRIX_ROW0_PORT, KEY_MATRIX_ROW0_PIN, PID_GPIO);
+    RESERVE_GPIO(KEY_MATRIX_ROW1, KEY_MATRIX_ROW1_PORT, KEY_MATRIX_ROW1_PIN, PID_GPIO);
+    RESERVE_GPIO(KEY_MATRIX_COL0, KEY_MATRIX_COL0_PORT, KEY_MATRIX_COL0_PIN, PID_GPIO);
+    RESERVE_GPIO(KEY_MATRIX_COL1, KEY_MATRIX_COL1_PORT, KEY_MATRIX_COL1_PIN, PID_GPIO);
+#endif
+#if defined (CFG_APP_ENCODER)
+    RESERVE_GPIO(ENCODER_A, ENCODER_A_PORT, ENCODER_A_PIN, PID_GPIO);
+    RESERVE_GPIO(ENCODER_B, ENCODER_B_PORT, ENCODER_B_PIN, PID_GPIO);
+#endif
+#if defined (CFG_APP_AUDIO)
+    RESERVE_GPIO(AUDIO_PDM_CLK, AUDIO_PDM_CLK_PORT, AUDIO_PDM_CLK_PIN, PID_PDM_CLK);
+    RESERVE_GPIO(AUDIO_PDM_DATA, AUDIO_PDM_DATA_PORT, AUDIO_PDM_DATA_PIN, PID_PDM_DATA);
+#endif
 }
 
 #endif
@@ -111,6 +133,19 @@ void set_pad_functions(void)
 		GPIO_ConfigurePin(SPI_DO_PORT, SPI_DO_PIN, OUTPUT, PID_SPI_DO, false);
 		GPIO_ConfigurePin(SPI_DI_PORT, SPI_DI_PIN, INPUT, PID_SPI_DI, false);
 		GPIO_ConfigurePin(SPI_CLK_PORT, SPI_CLK_PIN, OUTPUT, PID_SPI_CLK, false);
+
+#if defined (CFG_ADC_AXES)
+    GPIO_ConfigurePin(ADC_AXIS_X_PORT, ADC_AXIS_X_PIN, INPUT, PID_ADC, false);
+    GPIO_ConfigurePin(ADC_AXIS_Y_PORT, ADC_AXIS_Y_PIN, INPUT, PID_ADC, false);
+#endif
+
+#if defined (CFG_APP_KEY_MATRIX)
+    app_key_matrix_set_pads();
+#endif
+
+#if defined (CFG_APP_ENCODER)
+    app_encoder_set_pads();
+#endif
 }
 
 //#if defined (CFG_PRINTF_UART2)
@@ -143,6 +178,11 @@ void periph_init(void)
     SetBits16(CLK_16M_REG, XTAL16_BIAS_SH_ENABLE, 1);
 #endif
 
+#if defined (__DA14531__) && defined (CFG_APP_KEY_MATRIX)
+    // The key matrix takes the SWD data pin
+    SetBits16(SYS_CTRL_REG, DEBUGGER_ENABLE, 0);
+#endif
+
     // ROM patch
     patch_func();
 		// uart config
@@ -0,0 +1,297 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_adc_axes.c
+ *
+ * @brief Continuous DMA sampling of the analog axes source code.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "rwip_config.h"             // SW configuration
+#include "user_adc_axes.h"
+
+#if defined (CFG_ADC_AXES)
+
+#include <string.h>
+#include "ll.h"
+#include "adc.h"
+#include "dma.h"
+#include "user_periph_setup.h"
+#include "user_gamepad.h"
+
+#if !defined (CFG_ADC_DMA_SUPPORT)
+#error "CFG_ADC_AXES requires CFG_ADC_DMA_SUPPORT"
+#endif
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// DMA channel of the ADC
+#define ADC_AXES_DMA_CHANNEL        (DMA_CHANNEL_0)
+
+/// Half width of the dead-zone around the center
+#define ADC_AXES_DEADZONE           (USER_ADC_AXES_CENTER * R_DEADZONE / 100)
+
+/// Length of the moving average
+#define ADC_AXES_AVG_LEN            (1 << USER_ADC_AXES_AVG_SHIFT)
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Analog axes environment
+struct adc_axes_env_tag
+{
+    /// True while sampling
+    bool running;
+    /// Set when a published value changes, cleared by user_adc_axes_get()
+    bool changed;
+    /// Axis converted in each half of the ring buffer
+    uint8_t half_axis[2];
+    /// Moving average history
+    uint8_t avg_hist[USER_ADC_AXES_NUM][ADC_AXES_AVG_LEN];
+    /// Oldest moving average entry
+    uint8_t avg_idx[USER_ADC_AXES_NUM];
+    /// Sum of the moving average history
+    uint16_t avg_sum[USER_ADC_AXES_NUM];
+    /// Published axis values
+    uint8_t value[USER_ADC_AXES_NUM];
+};
+
+/// ADC input of each axis
+static const adc_input_se_t adc_axes_inputs[USER_ADC_AXES_NUM] = {ADC_AXIS_X_INPUT, ADC_AXIS_Y_INPUT};
+
+static struct adc_axes_env_tag adc_axes_env     __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/// Conversions stored by the DMA, two halves of USER_ADC_AXES_BLOCK samples
+static uint16_t adc_axes_ring[2 * USER_ADC_AXES_BLOCK];
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Filters a decimated sample of an axis and publishes the result if it moved.
+ * @param[in] axis      Axis index
+ * @param[in] sample    Corrected 16-bit ADC sample
+ * @return void
+ ****************************************************************************************
+ */
+static void adc_axes_update(uint8_t axis, uint16_t sample)
+{
+    uint8_t level = user_sample_conv(sample >> 4, ADC_SAMPLE_MAX);
+    uint8_t *idx = &adc_axes_env.avg_idx[axis];
+    uint8_t value;
+    int16_t offset;
+    int16_t diff;
+
+    // Moving average over the last decimated values
+    adc_axes_env.avg_sum[axis] += level;
+    adc_axes_env.avg_sum[axis] -= adc_axes_env.avg_hist[axis][*idx];
+    adc_axes_env.avg_hist[axis][*idx] = level;
+    *idx = (*idx + 1) & (ADC_AXES_AVG_LEN - 1);
+    value = adc_axes_env.avg_sum[axis] >> USER_ADC_AXES_AVG_SHIFT;
+
+    // Dead-zone around the center, the range outside of it is stretched to 0 - 255
+    offset = value - USER_ADC_AXES_CENTER;
+    if (offset > ADC_AXES_DEADZONE)
+    {
+        value = USER_ADC_AXES_CENTER + (offset - ADC_AXES_DEADZONE) * 127 / (127 - ADC_AXES_DEADZONE);
+    }
+    else if (offset < -ADC_AXES_DEADZONE)
+    {
+        value = USER_ADC_AXES_CENTER - (-offset - ADC_AXES_DEADZONE) * 128 / (128 - ADC_AXES_DEADZONE);
+    }
+    else
+    {
+        value = USER_ADC_AXES_CENTER;
+    }
+
+    // Publish on a real move, or when reaching the center or an end
+    diff = value - adc_axes_env.value[axis];
+    if ((diff >= USER_ADC_AXES_HYST) || (diff <= -USER_ADC_AXES_HYST) ||
+        ((diff != 0) && ((value == USER_ADC_AXES_CENTER) || (value == 0) || (value == 0xFF))))
+    {
+        adc_axes_env.value[axis] = value;
+        adc_axes_env.changed = true;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief DMA interrupt callback, called when a half of the ring buffer is full.
+ * @param[in] user_data Unused
+ * @param[in] len       Number of transfers at the interrupt
+ * @return void
+ ****************************************************************************************
+ */
+static void adc_axes_dma_cb(void *user_data, uint16_t len)
+{
+    uint8_t half = (len == USER_ADC_AXES_BLOCK) ? 0 : 1;
+    uint8_t axis = adc_axes_env.half_axis[half];
+    uint8_t next = (axis + 1 < USER_ADC_AXES_NUM) ? axis + 1 : 0;
+    const uint16_t *smp = &adc_axes_ring[half * USER_ADC_AXES_BLOCK + USER_ADC_AXES_SETTLE];
+    uint32_t sum = 0;
+    uint8_t i;
+
+    // The DMA fills the other half now, convert it on the next axis. The conversions
+    // started before the switch are dropped as USER_ADC_AXES_SETTLE.
+    adc_set_se_input(adc_axes_inputs[next]);
+    adc_axes_env.half_axis[half ^ 1] = next;
+    dma_set_int(ADC_AXES_DMA_CHANNEL, half ? USER_ADC_AXES_BLOCK : 2 * USER_ADC_AXES_BLOCK);
+
+    // Decimate, then apply the OTP correction once per decimated value
+    for (i = 0; i < (1 << USER_ADC_AXES_DECIM_SHIFT); i++)
+    {
+        sum += smp[i];
+    }
+
+    adc_axes_update(axis, adc_correct_sample(sum >> USER_ADC_AXES_DECIM_SHIFT));
+}
+
+void user_adc_axes_start(void)
+{
+    adc_config_t adc_cfg =
+    {
+        .input_mode       = ADC_INPUT_MODE_SINGLE_ENDED,
+        .input            = adc_axes_inputs[0],
+        .smpl_time_mult   = 2,
+        .continuous       = true,
+        .interval_mult    = USER_ADC_AXES_INTERVAL,
+        .input_attenuator = ADC_INPUT_ATTN_4X,
+        .chopping         = false,
+        .oversampling     = USER_ADC_AXES_OVERSAMPLING,
+        .dst_addr         = (uint32_t) adc_axes_ring,
+        .len              = 2 * USER_ADC_AXES_BLOCK,
+        .rx_cb            = adc_axes_dma_cb,
+        .user_data        = NULL,
+        .dma_channel      = ADC_DMA_CHANNEL_01,
+        .dma_priority     = DMA_PRIO_0,
+    };
+
+    // Same channel as set up by adc_init(), but circular with an interrupt per half
+    dma_cfg_t dma_cfg =
+    {
+        .bus_width       = DMA_BW_HALFWORD,
+        .irq_enable      = DMA_IRQ_STATE_ENABLED,
+        .dreq_mode       = DMA_DREQ_TRIGGERED,
+        .src_inc         = DMA_INC_FALSE,
+        .dst_inc         = DMA_INC_TRUE,
+        .circular        = DMA_MODE_CIRCULAR,
+        .dma_prio        = DMA_PRIO_0,
+        .dma_idle        = DMA_IDLE_BLOCKING_MODE,
+        .dma_init        = DMA_INIT_AX_BX_AY_BY,
+        .dma_sense       = DMA_SENSE_LEVEL_SENSITIVE,
+        .dma_req_mux     = DMA_TRIG_ADC_RX,
+        .src_address     = (uint32_t) GP_ADC_RESULT_REG,
+        .dst_address     = (uint32_t) adc_axes_ring,
+        .irq_nr_of_trans = USER_ADC_AXES_BLOCK,
+        .length          = 2 * USER_ADC_AXES_BLOCK,
+        .cb              = adc_axes_dma_cb,
+        .user_data       = NULL
+    };
+    uint8_t axis;
+
+    if (adc_axes_env.running)
+    {
+        return;
+    }
+
+    memset(&adc_axes_env, 0, sizeof(adc_axes_env));
+    for (axis = 0; axis < USER_ADC_AXES_NUM; axis++)
+    {
+        memset(adc_axes_env.avg_hist[axis], USER_ADC_AXES_CENTER, ADC_AXES_AVG_LEN);
+        adc_axes_env.avg_sum[axis] = USER_ADC_AXES_CENTER << USER_ADC_AXES_AVG_SHIFT;
+        adc_axes_env.value[axis] = USER_ADC_AXES_CENTER;
+    }
+
+    adc_init(&adc_cfg);
+    adc_dma_enable();
+    dma_initialize(ADC_AXES_DMA_CHANNEL, &dma_cfg);
+    dma_channel_start(ADC_AXES_DMA_CHANNEL, DMA_IRQ_STATE_ENABLED);
+
+    adc_axes_env.running = true;
+    adc_start();
+}
+
+void user_adc_axes_stop(void)
+{
+    if (!adc_axes_env.running)
+    {
+        return;
+    }
+
+    adc_continuous_disable();
+    while (adc_in_progress());
+    dma_channel_stop(ADC_AXES_DMA_CHANNEL);
+    adc_dma_disable();
+    adc_disable();
+
+    adc_axes_env.running = false;
+}
+
+bool user_adc_axes_get(uint8_t *axes)
+{
+    bool changed;
+
+    GLOBAL_INT_DISABLE();
+    memcpy(axes, adc_axes_env.value, USER_ADC_AXES_NUM);
+    changed = adc_axes_env.changed;
+    adc_axes_env.changed = false;
+    GLOBAL_INT_RESTORE();
+
+    return changed;
+}
+
+sleep_mode_t user_adc_axes_validate_sleep(sleep_mode_t sleep_mode)
+{
+    // The ADC and the DMA keep running in idle mode only
+    if (adc_axes_env.running && (sleep_mode != mode_active))
+    {
+        return mode_idle;
+    }
+
+    return sleep_mode;
+}
+
+#endif // CFG_ADC_AXES
+
+/// @} APP
@@ -0,0 +1,142 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_adc_axes.h
+ *
+ * @brief Continuous DMA sampling of the analog axes header file.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+#ifndef _USER_ADC_AXES_H_
+#define _USER_ADC_AXES_H_
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @ingroup RICOW
+ *
+ * @brief Samples the analog axes without CPU involvement per conversion.
+ *
+ * The ADC runs in continuous mode and a circular DMA transfer stores the conversions in
+ * a ring buffer made of two halves. Each half holds the conversions of one axis, the
+ * input is switched to the next axis when a half completes. The DMA interrupt of the
+ * completed half averages its samples (first order CIC decimation), applies the OTP
+ * correction once, smooths the result with a moving average over the last decimated
+ * values, applies the dead-zone around the center and publishes the axis if it moved.
+ *
+ * The system only enters the idle mode while sampling, since the ADC and the DMA stop
+ * in extended sleep.
+ *
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "arch.h"
+
+#if defined (CFG_ADC_AXES)
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/* Number of sampled axes, the ADC inputs are set in user_periph_setup.h */
+#define USER_ADC_AXES_NUM                   (2)
+
+/* Interval between two conversions */
+#define USER_ADC_AXES_INTERVAL              (1)      // 1*1.024ms
+
+/* Hardware oversampling, 2^n conversions are averaged per sample */
+#define USER_ADC_AXES_OVERSAMPLING          (3)
+
+/* Samples averaged per decimated value, 2^n */
+#define USER_ADC_AXES_DECIM_SHIFT           (3)
+
+/* Samples discarded after the input switch */
+#define USER_ADC_AXES_SETTLE                (1)
+
+/* Samples per half of the ring buffer */
+#define USER_ADC_AXES_BLOCK                 ((1 << USER_ADC_AXES_DECIM_SHIFT) + USER_ADC_AXES_SETTLE)
+
+/* Moving average over 2^n decimated values */
+#define USER_ADC_AXES_AVG_SHIFT             (2)
+
+/* Minimum change of a published axis value, filters the LSB noise */
+#define USER_ADC_AXES_HYST                  (2)
+
+/* Axis value at the center of the dead-zone */
+#define USER_ADC_AXES_CENTER                (0x80)
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Configures the ADC and the DMA and starts sampling the axes.
+ * @return void
+ ****************************************************************************************
+*/
+void user_adc_axes_start(void);
+
+/**
+ ****************************************************************************************
+ * @brief Stops sampling the axes.
+ * @return void
+ ****************************************************************************************
+*/
+void user_adc_axes_stop(void);
+
+/**
+ ****************************************************************************************
+ * @brief Reads the published axis values.
+ * @param[out] axes     USER_ADC_AXES_NUM axis values, 0 to 255
+ * @return true if an axis has changed since the previous call
+ ****************************************************************************************
+*/
+bool user_adc_axes_get(uint8_t *axes);
+
+/**
+ ****************************************************************************************
+ * @brief Keeps the system out of extended sleep while sampling. To be registered as
+ *        app_validate_sleep callback.
+ * @param[in] sleep_mode    Selected sleep mode
+ * @return Sleep mode to use
+ ****************************************************************************************
+*/
+sleep_mode_t user_adc_axes_validate_sleep(sleep_mode_t sleep_mode);
+
+#endif // CFG_ADC_AXES
+
+/// @} APP
+
+#endif // _USER_ADC_AXES_H_
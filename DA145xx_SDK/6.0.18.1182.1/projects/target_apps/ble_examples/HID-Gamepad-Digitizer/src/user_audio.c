@@ -0,0 +1,278 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_audio.c
+ *
+ * @brief PDM microphone streaming over the custom service source code.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <string.h>
+#include "rwip_config.h"             // SW configuration
+#include "arch.h"
+#include "gattc.h"
+#include "gattc_task.h"
+#include "co_math.h"
+#include "co_utils.h"
+#include "app.h"
+#include "app_audio.h"
+#include "custom_common.h"
+#include "user_custs1_def.h"
+#include "user_periph_setup.h"
+#include "user_heap_mon.h"
+#include "user_audio.h"
+
+#if defined (CFG_APP_AUDIO)
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/* ATT notification header, opcode and handle */
+#define AUDIO_ATT_HDR_LEN                   (3)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Audio environment
+struct user_audio_env_tag
+{
+    /// Connection index of the host of the audio
+    uint8_t conidx;
+    /// Notifications enabled in the Audio CCC of that host
+    bool enabled;
+    /// Notifications handed to GATTC and not yet completed
+    uint8_t in_flight;
+    /// Highest number of notifications in flight
+    uint8_t max_queued;
+    /// Notifications not sent, either not allocated or completed with an error
+    uint16_t ntf_errors;
+    /// Notifications completed
+    uint32_t ntf_done;
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static struct user_audio_env_tag user_audio_env         __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+static bool audio_send(const uint8_t *frame, uint16_t len);
+
+static const struct app_audio_cfg audio_cfg =
+{
+    .clk_gpio       = {AUDIO_PDM_CLK_PORT, AUDIO_PDM_CLK_PIN},
+    .data_gpio      = {AUDIO_PDM_DATA_PORT, AUDIO_PDM_DATA_PIN},
+    .send           = audio_send,
+};
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Computes the frame length that fills a notification.
+ * @param[in] conidx Connection index
+ * @return Frame length in bytes
+ ****************************************************************************************
+ */
+static uint16_t audio_frame_len(uint8_t conidx)
+{
+    return co_min(gattc_get_mtu(conidx) - AUDIO_ATT_HDR_LEN, DEF_CUST1_AUDIO_CHAR_LEN);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Sends a frame of app_audio in a notification of the Audio characteristic.
+ * @param[in] frame   Frame
+ * @param[in] len     Frame length
+ * @return false if the frame must be retried
+ ****************************************************************************************
+ */
+static bool audio_send(const uint8_t *frame, uint16_t len)
+{
+    struct gattc_send_evt_cmd *cmd;
+
+    if (!user_audio_env.enabled)
+    {
+        return true;
+    }
+
+    if (user_audio_env.in_flight >= USER_AUDIO_NTF_QUEUED)
+    {
+        return false;
+    }
+
+    cmd = KE_MSG_ALLOC_DYN(GATTC_SEND_EVT_CMD,
+                           KE_BUILD_ID(TASK_GATTC, user_audio_env.conidx),
+                           TASK_APP,
+                           gattc_send_evt_cmd,
+                           len);
+
+    if (cmd == NULL)
+    {
+        // Retried with the next frame
+        user_heap_mon_alloc_failed(USER_HEAP_MON_SITE_AUDIO_NTF);
+        if (user_audio_env.ntf_errors != 0xFFFF)
+        {
+            user_audio_env.ntf_errors++;
+        }
+        return false;
+    }
+
+    cmd->operation = GATTC_NOTIFY;
+    cmd->seq_num = USER_AUDIO_NTF_SEQ;
+    cmd->handle = custs1_get_att_handle(CUST1_IDX_AUDIO_VAL);
+    cmd->length = len;
+    memcpy(cmd->value, frame, len);
+
+    ke_msg_send(cmd);
+
+    user_audio_env.in_flight++;
+    if (user_audio_env.in_flight > user_audio_env.max_queued)
+    {
+        user_audio_env.max_queued = user_audio_env.in_flight;
+    }
+
+    return true;
+}
+
+void user_audio_connected(uint8_t conidx)
+{
+#if !defined (CFG_CUSTS1_STREAM)
+    struct gattc_exc_mtu_cmd *cmd = KE_MSG_ALLOC(GATTC_EXC_MTU_CMD,
+                                                 KE_BUILD_ID(TASK_GATTC, conidx),
+                                                 TASK_APP,
+                                                 gattc_exc_mtu_cmd);
+
+    cmd->operation = GATTC_MTU_EXCH;
+    cmd->seq_num = 0;
+    ke_msg_send(cmd);
+#endif
+}
+
+void user_audio_disconnected(uint8_t conidx)
+{
+    if (user_audio_env.enabled && (user_audio_env.conidx == conidx))
+    {
+        user_audio_ntf_cfg(conidx, false);
+    }
+}
+
+void user_audio_ntf_cfg(uint8_t conidx, bool enable)
+{
+    if (enable)
+    {
+        // One host at a time
+        if (user_audio_env.enabled)
+        {
+            return;
+        }
+
+        user_audio_env.conidx = conidx;
+        user_audio_env.enabled = true;
+        user_audio_env.in_flight = 0;
+        app_audio_start(&audio_cfg, audio_frame_len(conidx));
+    }
+    else if (user_audio_env.enabled && (user_audio_env.conidx == conidx))
+    {
+        user_audio_env.enabled = false;
+        app_audio_stop();
+    }
+}
+
+void user_audio_ntf_cmp(uint8_t conidx, uint8_t status)
+{
+    if (user_audio_env.in_flight != 0)
+    {
+        user_audio_env.in_flight--;
+    }
+
+    user_audio_env.ntf_done++;
+    if ((status != GAP_ERR_NO_ERROR) && (user_audio_env.ntf_errors != 0xFFFF))
+    {
+        user_audio_env.ntf_errors++;
+    }
+
+    if (user_audio_env.enabled && (user_audio_env.conidx == conidx))
+    {
+        // Follow the MTU exchange, done after the host has subscribed
+        app_audio_set_frame_len(audio_frame_len(conidx));
+        app_audio_sent();
+    }
+}
+
+void user_audio_reset(void)
+{
+    app_audio_reset_stats();
+    user_audio_env.max_queued = user_audio_env.in_flight;
+    user_audio_env.ntf_errors = 0;
+    user_audio_env.ntf_done = 0;
+}
+
+uint16_t user_audio_stats_pack(uint8_t *buf)
+{
+    const struct app_audio_stats *stats = app_audio_get_stats();
+    uint8_t *p = buf;
+
+    *p++ = USER_AUDIO_STATS_VERSION;
+    *p++ = stats->max_depth;
+    *p++ = stats->slots;
+    *p++ = user_audio_env.max_queued;
+    co_write16p(p, stats->frame_len);
+    co_write16p(p + 2, APP_AUDIO_SAMPLE_RATE);
+    p += 4;
+    co_write32p(p, stats->frames);
+    co_write32p(p + 4, stats->sent);
+    co_write32p(p + 8, stats->dropped);
+    p += 12;
+    co_write16p(p, stats->overruns);
+    co_write16p(p + 2, user_audio_env.ntf_errors);
+    co_write32p(p + 4, user_audio_env.ntf_done);
+    p += 8;
+
+    return (uint16_t)(p - buf);
+}
+
+#endif // CFG_APP_AUDIO
+
+/// @} APP
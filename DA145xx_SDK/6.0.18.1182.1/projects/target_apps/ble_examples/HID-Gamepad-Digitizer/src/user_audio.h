@@ -0,0 +1,159 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_audio.h
+ *
+ * @brief PDM microphone streaming over the custom service header file.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+#ifndef _USER_AUDIO_H_
+#define _USER_AUDIO_H_
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @ingroup RICOW
+ *
+ * @brief Streams the PDM microphone, encoded by app_audio, through notifications of the
+ * Audio characteristic.
+ *
+ * The microphone records while a host has enabled the notifications in the Audio CCC,
+ * one host at a time. A frame of app_audio fills one notification: its length follows
+ * gattc_get_mtu() - 3 and is updated when the ATT MTU changes. Up to
+ * USER_AUDIO_NTF_QUEUED frames are handed to GATTC at a time, the next ones wait in the
+ * FIFO of app_audio, which drops frames when the link falls behind. The host finds the
+ * dropped frames from the gaps in the sequence numbers, see app_audio.h for the frame
+ * layout. With a 20 byte frame, before the MTU exchange, 16kHz audio needs 500
+ * notifications per second, so the exchange requested at connection time matters.
+ *
+ * The counters of app_audio are exported through the CUST1_IDX_AUDIO_STATS_VAL
+ * characteristic, see user_audio_stats_pack() for the layout. Writing the
+ * characteristic clears them.
+ *
+ * The microphone pins are listed in user_periph_setup.h. The DA14531 has no PDM
+ * interface.
+ *
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined (CFG_APP_AUDIO)
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/* Notifications handed to GATTC and not yet completed */
+#define USER_AUDIO_NTF_QUEUED               (4)
+
+/* Sequence number of the audio notifications, tells their GATTC_CMP_EVT apart */
+#define USER_AUDIO_NTF_SEQ                  (0xA0D1)
+
+/* Layout version of the exported statistics */
+#define USER_AUDIO_STATS_VERSION            (1)
+
+/* Size of the exported statistics */
+#define USER_AUDIO_STATS_LEN                (28)
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Requests the ATT MTU exchange on a new connection, unless user_stream.c does.
+ * @param[in] conidx        Connection index
+ * @return void
+ ****************************************************************************************
+*/
+void user_audio_connected(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Stops the microphone if its host is gone.
+ * @param[in] conidx        Connection index
+ * @return void
+ ****************************************************************************************
+*/
+void user_audio_disconnected(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Starts or stops the microphone, as set in the Audio CCC.
+ * @param[in] conidx    Connection index
+ * @param[in] enable    True if notifications are enabled
+ * @return void
+ ****************************************************************************************
+*/
+void user_audio_ntf_cfg(uint8_t conidx, bool enable);
+
+/**
+ ****************************************************************************************
+ * @brief Handles the completion of an audio notification (GATTC_CMP_EVT with
+ *        USER_AUDIO_NTF_SEQ).
+ * @param[in] conidx    Connection index
+ * @param[in] status    Status of the notification
+ * @return void
+ ****************************************************************************************
+*/
+void user_audio_ntf_cmp(uint8_t conidx, uint8_t status);
+
+/**
+ ****************************************************************************************
+ * @brief Clears the statistics.
+ * @return void
+ ****************************************************************************************
+*/
+void user_audio_reset(void);
+
+/**
+ ****************************************************************************************
+ * @brief Serializes the statistics, little endian:
+ *        u8 version, u8 max_depth, u8 slots, u8 max_queued, u16 frame_len,
+ *        u16 sample_rate, u32 frames, u32 sent, u32 dropped, u16 overruns,
+ *        u16 ntf_errors, u32 ntf_done.
+ *        max_depth and slots count frames of the app_audio FIFO, max_queued the
+ *        notifications in flight, ntf_done the notifications completed.
+ * @param[out] buf Buffer of at least USER_AUDIO_STATS_LEN bytes
+ * @return Number of bytes written
+ ****************************************************************************************
+*/
+uint16_t user_audio_stats_pack(uint8_t *buf);
+
+#endif // CFG_APP_AUDIO
+
+/// @} APP
+
+#endif // _USER_AUDIO_H_
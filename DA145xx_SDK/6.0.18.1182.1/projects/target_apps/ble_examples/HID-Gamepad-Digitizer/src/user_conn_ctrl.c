@@ -0,0 +1,351 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_conn_ctrl.c
+ *
+ * @brief Traffic-adaptive connection parameter controller source code.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <string.h>
+#include "rwip_config.h"             // SW configuration
+#include "app_easy_timer.h"
+#include "app_easy_gap.h"
+#include "user_conn_ctrl.h"
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Connection parameter set
+struct user_conn_ctrl_params
+{
+    uint16_t intv_min;
+    uint16_t intv_max;
+    uint16_t latency;
+    uint16_t time_out;
+};
+
+/// Controller environment
+struct user_conn_ctrl_env_tag
+{
+    /// Connection index of the controlled link
+    uint8_t conidx;
+    /// True while a link is controlled
+    bool connected;
+    /// True while a parameter update request is in flight
+    bool req_pending;
+    /// Profile wanted for the current traffic conditions
+    uint8_t target;
+    /// Profile of the last request sent
+    uint8_t requested;
+    /// Current connection interval in 1.25ms units
+    uint16_t con_interval;
+    /// Current slave latency
+    uint16_t con_latency;
+    /// Current supervision timeout in 10ms units
+    uint16_t sup_to;
+    /// Current minimum distance between two requests in 10ms units
+    uint16_t req_interval;
+    /// Idle timeout timer
+    timer_hnd idle_timer;
+    /// Rate limit timer, no request is sent while it runs
+    timer_hnd guard_timer;
+    /// Statistics
+    struct user_conn_ctrl_stats stats;
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static const struct user_conn_ctrl_params conn_ctrl_params[] =
+{
+    [USER_CONN_CTRL_ACTIVE] = {
+        .intv_min = USER_CONN_CTRL_ACTIVE_INTV_MIN,
+        .intv_max = USER_CONN_CTRL_ACTIVE_INTV_MAX,
+        .latency  = USER_CONN_CTRL_ACTIVE_LATENCY,
+        .time_out = USER_CONN_CTRL_ACTIVE_TIME_OUT,
+    },
+    [USER_CONN_CTRL_IDLE] = {
+        .intv_min = USER_CONN_CTRL_IDLE_INTV_MIN,
+        .intv_max = USER_CONN_CTRL_IDLE_INTV_MAX,
+        .latency  = USER_CONN_CTRL_IDLE_LATENCY,
+        .time_out = USER_CONN_CTRL_IDLE_TIME_OUT,
+    },
+};
+
+static struct user_conn_ctrl_env_tag conn_ctrl_env      __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Checks if the current connection parameters belong to a profile.
+ * @param[in] profile Profile to check against
+ * @return true if the current parameters satisfy the profile
+ ****************************************************************************************
+ */
+static bool conn_ctrl_params_match(uint8_t profile)
+{
+    struct user_conn_ctrl_params const *p = &conn_ctrl_params[profile];
+
+    return ((conn_ctrl_env.con_interval >= p->intv_min) &&
+            (conn_ctrl_env.con_interval <= p->intv_max) &&
+            (conn_ctrl_env.con_latency == p->latency));
+}
+
+static void conn_ctrl_evaluate(void);
+
+/**
+ ****************************************************************************************
+ * @brief Rate limit timer callback. Re-evaluates postponed profile changes.
+ * @return void
+ ****************************************************************************************
+ */
+static void conn_ctrl_guard_timer_cb(void)
+{
+    conn_ctrl_env.guard_timer = EASY_TIMER_INVALID_TIMER;
+    conn_ctrl_evaluate();
+}
+
+/**
+ ****************************************************************************************
+ * @brief Doubles the distance to the next request, up to USER_CONN_CTRL_MAX_REQ_INTERVAL,
+ *        so that a peer refusing the parameters is not flooded with requests.
+ * @return void
+ ****************************************************************************************
+ */
+static void conn_ctrl_back_off(void)
+{
+    if (conn_ctrl_env.req_interval < (USER_CONN_CTRL_MAX_REQ_INTERVAL / 2))
+    {
+        conn_ctrl_env.req_interval <<= 1;
+    }
+    else
+    {
+        conn_ctrl_env.req_interval = USER_CONN_CTRL_MAX_REQ_INTERVAL;
+    }
+
+    if (conn_ctrl_env.guard_timer != EASY_TIMER_INVALID_TIMER)
+    {
+        conn_ctrl_env.guard_timer = app_easy_timer_modify(conn_ctrl_env.guard_timer, conn_ctrl_env.req_interval);
+    }
+    else if (conn_ctrl_env.connected)
+    {
+        conn_ctrl_env.guard_timer = app_easy_timer(conn_ctrl_env.req_interval, conn_ctrl_guard_timer_cb);
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Idle timeout callback. Steps back to the low power profile.
+ * @return void
+ ****************************************************************************************
+ */
+static void conn_ctrl_idle_timer_cb(void)
+{
+    conn_ctrl_env.idle_timer = EASY_TIMER_INVALID_TIMER;
+    conn_ctrl_env.target = USER_CONN_CTRL_IDLE;
+    conn_ctrl_evaluate();
+}
+
+/**
+ ****************************************************************************************
+ * @brief Sends a parameter update request for the target profile when the current
+ *        parameters do not match it and the rate limit allows it.
+ * @return void
+ ****************************************************************************************
+ */
+static void conn_ctrl_evaluate(void)
+{
+    struct gapc_param_update_cmd *cmd;
+    struct user_conn_ctrl_params const *p;
+
+    if (!conn_ctrl_env.connected || (conn_ctrl_env.target == USER_CONN_CTRL_NONE))
+    {
+        return;
+    }
+
+    if (conn_ctrl_params_match(conn_ctrl_env.target))
+    {
+        return;
+    }
+
+    if (conn_ctrl_env.req_pending || (conn_ctrl_env.guard_timer != EASY_TIMER_INVALID_TIMER))
+    {
+        // Re-evaluated from the guard timer or the request completion
+        conn_ctrl_env.stats.deferred++;
+        return;
+    }
+
+    p = &conn_ctrl_params[conn_ctrl_env.target];
+
+    cmd = app_easy_gap_param_update_get_active(conn_ctrl_env.conidx);
+    cmd->intv_min = p->intv_min;
+    cmd->intv_max = p->intv_max;
+    cmd->latency = p->latency;
+    cmd->time_out = p->time_out;
+    app_easy_gap_param_update_start(conn_ctrl_env.conidx);
+
+    conn_ctrl_env.requested = conn_ctrl_env.target;
+    conn_ctrl_env.req_pending = true;
+    conn_ctrl_env.stats.requests++;
+    conn_ctrl_env.guard_timer = app_easy_timer(conn_ctrl_env.req_interval, conn_ctrl_guard_timer_cb);
+}
+
+void user_conn_ctrl_start(uint8_t conidx, struct gapc_connection_req_ind const *param)
+{
+    user_conn_ctrl_stop();
+
+    conn_ctrl_env.conidx = conidx;
+    conn_ctrl_env.connected = true;
+    conn_ctrl_env.req_pending = false;
+    conn_ctrl_env.target = USER_CONN_CTRL_IDLE;
+    conn_ctrl_env.con_interval = param->con_interval;
+    conn_ctrl_env.con_latency = param->con_latency;
+    conn_ctrl_env.sup_to = param->sup_to;
+    conn_ctrl_env.req_interval = USER_CONN_CTRL_MIN_REQ_INTERVAL;
+    memset(&conn_ctrl_env.stats, 0, sizeof(conn_ctrl_env.stats));
+
+    // Give the host time to complete discovery and pairing before the first request
+    conn_ctrl_env.guard_timer = app_easy_timer(USER_CONN_CTRL_START_DELAY, conn_ctrl_guard_timer_cb);
+}
+
+void user_conn_ctrl_stop(void)
+{
+    if (conn_ctrl_env.idle_timer != EASY_TIMER_INVALID_TIMER)
+    {
+        app_easy_timer_cancel(conn_ctrl_env.idle_timer);
+        conn_ctrl_env.idle_timer = EASY_TIMER_INVALID_TIMER;
+    }
+
+    if (conn_ctrl_env.guard_timer != EASY_TIMER_INVALID_TIMER)
+    {
+        app_easy_timer_cancel(conn_ctrl_env.guard_timer);
+        conn_ctrl_env.guard_timer = EASY_TIMER_INVALID_TIMER;
+    }
+
+    conn_ctrl_env.connected = false;
+    conn_ctrl_env.target = USER_CONN_CTRL_NONE;
+}
+
+void user_conn_ctrl_traffic_ind(void)
+{
+    if (!conn_ctrl_env.connected)
+    {
+        return;
+    }
+
+    if (conn_ctrl_env.idle_timer != EASY_TIMER_INVALID_TIMER)
+    {
+        conn_ctrl_env.idle_timer = app_easy_timer_modify(conn_ctrl_env.idle_timer, USER_CONN_CTRL_IDLE_TO);
+    }
+    else
+    {
+        conn_ctrl_env.idle_timer = app_easy_timer(USER_CONN_CTRL_IDLE_TO, conn_ctrl_idle_timer_cb);
+    }
+
+    if (conn_ctrl_env.target != USER_CONN_CTRL_ACTIVE)
+    {
+        conn_ctrl_env.target = USER_CONN_CTRL_ACTIVE;
+        conn_ctrl_evaluate();
+    }
+}
+
+void user_conn_ctrl_param_updated(struct gapc_param_updated_ind const *param)
+{
+    conn_ctrl_env.con_interval = param->con_interval;
+    conn_ctrl_env.con_latency = param->con_latency;
+    conn_ctrl_env.sup_to = param->sup_to;
+    conn_ctrl_env.stats.updated++;
+}
+
+void user_conn_ctrl_on_update_complete(void)
+{
+    conn_ctrl_env.req_pending = false;
+    conn_ctrl_env.stats.accepted++;
+
+    if (!conn_ctrl_params_match(conn_ctrl_env.requested))
+    {
+        // The master applied parameters outside the requested range, asking again at
+        // once would get the same answer
+        conn_ctrl_env.stats.mismatched++;
+        conn_ctrl_back_off();
+        return;
+    }
+
+    conn_ctrl_env.req_interval = USER_CONN_CTRL_MIN_REQ_INTERVAL;
+
+    // Traffic conditions may have changed while the request was in flight
+    conn_ctrl_evaluate();
+}
+
+void user_conn_ctrl_on_update_rejected(const uint8_t status)
+{
+    conn_ctrl_env.req_pending = false;
+    conn_ctrl_env.stats.rejected++;
+    conn_ctrl_env.stats.last_reject_status = status;
+
+    conn_ctrl_back_off();
+}
+
+enum user_conn_ctrl_profile user_conn_ctrl_get_profile(void)
+{
+    if (conn_ctrl_params_match(USER_CONN_CTRL_ACTIVE))
+    {
+        return USER_CONN_CTRL_ACTIVE;
+    }
+
+    if (conn_ctrl_params_match(USER_CONN_CTRL_IDLE))
+    {
+        return USER_CONN_CTRL_IDLE;
+    }
+
+    return USER_CONN_CTRL_NONE;
+}
+
+struct user_conn_ctrl_stats const *user_conn_ctrl_get_stats(void)
+{
+    return &conn_ctrl_env.stats;
+}
+
+/// @} APP
@@ -0,0 +1,197 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_conn_ctrl.h
+ *
+ * @brief Traffic-adaptive connection parameter controller header file.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+#ifndef _USER_CONN_CTRL_H_
+#define _USER_CONN_CTRL_H_
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @ingroup RICOW
+ *
+ * @brief Switches the link between a low latency and a low power parameter set
+ *        depending on the UART/HID traffic.
+ *
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gapc_task.h"
+#include "app_user_config.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/* Hold-off after connection before the first parameter update request */
+#define USER_CONN_CTRL_START_DELAY          (1000)   // 1000*10ms = 10sec
+
+/* Time without traffic before stepping back to the idle parameter set */
+#define USER_CONN_CTRL_IDLE_TO              (300)    // 300*10ms = 3sec
+
+/* Minimum time between two parameter update requests */
+#define USER_CONN_CTRL_MIN_REQ_INTERVAL     (100)    // 100*10ms = 1sec
+
+/* Upper limit of the request interval after consecutive rejections, or requests completed
+   with parameters outside the requested profile */
+#define USER_CONN_CTRL_MAX_REQ_INTERVAL     (6000)   // 6000*10ms = 60sec
+
+/* Active (burst) parameter set: minimum interval, no slave latency */
+#define USER_CONN_CTRL_ACTIVE_INTV_MIN      MS_TO_DOUBLESLOTS(7.5)
+#define USER_CONN_CTRL_ACTIVE_INTV_MAX      MS_TO_DOUBLESLOTS(10)
+#define USER_CONN_CTRL_ACTIVE_LATENCY       (0)
+#define USER_CONN_CTRL_ACTIVE_TIME_OUT      MS_TO_TIMERUNITS(1250)
+
+/* Idle parameter set: long interval with slave latency */
+#define USER_CONN_CTRL_IDLE_INTV_MIN        MS_TO_DOUBLESLOTS(60)
+#define USER_CONN_CTRL_IDLE_INTV_MAX        MS_TO_DOUBLESLOTS(75)
+#define USER_CONN_CTRL_IDLE_LATENCY         (4)
+#define USER_CONN_CTRL_IDLE_TIME_OUT        MS_TO_TIMERUNITS(4000)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Connection parameter profiles handled by the controller
+enum user_conn_ctrl_profile
+{
+    /// No profile requested yet
+    USER_CONN_CTRL_NONE = 0,
+    /// Low latency profile used while traffic is flowing
+    USER_CONN_CTRL_ACTIVE,
+    /// Low power profile used while the link is idle
+    USER_CONN_CTRL_IDLE,
+};
+
+/// Controller statistics
+struct user_conn_ctrl_stats
+{
+    /// Number of parameter update requests sent
+    uint16_t requests;
+    /// Number of requests completed successfully
+    uint16_t accepted;
+    /// Number of requests rejected by the peer
+    uint16_t rejected;
+    /// Number of completed requests whose parameters are outside the requested profile
+    uint16_t mismatched;
+    /// Number of evaluations postponed because of the rate limit
+    uint16_t deferred;
+    /// Number of GAPC_PARAM_UPDATED_IND received
+    uint16_t updated;
+    /// Status of the last rejected request
+    uint8_t last_reject_status;
+};
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Starts the controller on a new connection.
+ * @param[in] conidx Connection index
+ * @param[in] param  Pointer to GAPC_CONNECTION_REQ_IND message
+ * @return void
+ ****************************************************************************************
+*/
+void user_conn_ctrl_start(uint8_t conidx, struct gapc_connection_req_ind const *param);
+
+/**
+ ****************************************************************************************
+ * @brief Stops the controller and cancels its timers.
+ * @return void
+ ****************************************************************************************
+*/
+void user_conn_ctrl_stop(void);
+
+/**
+ ****************************************************************************************
+ * @brief Reports UART/HID traffic. Switches to the active profile if needed and
+ *        restarts the idle timeout. Must not be called from interrupt context.
+ * @return void
+ ****************************************************************************************
+*/
+void user_conn_ctrl_traffic_ind(void);
+
+/**
+ ****************************************************************************************
+ * @brief Records the parameters reported by GAPC_PARAM_UPDATED_IND.
+ * @param[in] param Pointer to GAPC_PARAM_UPDATED_IND message
+ * @return void
+ ****************************************************************************************
+*/
+void user_conn_ctrl_param_updated(struct gapc_param_updated_ind const *param);
+
+/**
+ ****************************************************************************************
+ * @brief Parameter update request completion callback.
+ * @return void
+ ****************************************************************************************
+*/
+void user_conn_ctrl_on_update_complete(void);
+
+/**
+ ****************************************************************************************
+ * @brief Parameter update request rejection callback.
+ * @param[in] status Status of the GAPC_UPDATE_PARAMS operation
+ * @return void
+ ****************************************************************************************
+*/
+void user_conn_ctrl_on_update_rejected(const uint8_t status);
+
+/**
+ ****************************************************************************************
+ * @brief Returns the profile the current connection parameters belong to.
+ * @return enum user_conn_ctrl_profile
+ ****************************************************************************************
+*/
+enum user_conn_ctrl_profile user_conn_ctrl_get_profile(void);
+
+/**
+ ****************************************************************************************
+ * @brief Returns the controller statistics.
+ * @return Pointer to the statistics
+ ****************************************************************************************
+*/
+struct user_conn_ctrl_stats const *user_conn_ctrl_get_stats(void);
+
+/// @} APP
+
+#endif // _USER_CONN_CTRL_H_
@@ -0,0 +1,166 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_encoder.c
+ *
+ * @brief Quadrature encoder to HID mouse report source code.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "rwip_config.h"             // SW configuration
+#include "app_encoder.h"
+#include "app_hogpd.h"
+#include "user_hogpd_config.h"
+#include "user_periph_setup.h"
+#include "user_encoder.h"
+
+#if defined (CFG_APP_ENCODER)
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+#define ENCODER_NB_PINS                     (2)
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static const struct app_encoder_pin encoder_pins[ENCODER_NB_PINS] =
+{
+    {ENCODER_A_PORT, ENCODER_A_PIN},
+    {ENCODER_B_PORT, ENCODER_B_PIN},
+};
+
+/// Pointer acceleration: 1x up to 2 counts per report, 4x from 24 counts per report
+static const struct app_encoder_accel encoder_xy_points[] =
+{
+    {2,  APP_ENCODER_GAIN_ONE},
+    {8,  2 * APP_ENCODER_GAIN_ONE},
+    {24, 4 * APP_ENCODER_GAIN_ONE},
+};
+
+/// Wheel acceleration: one line per detent when turned slowly, up to 3 lines when spun
+static const struct app_encoder_accel encoder_z_points[] =
+{
+    {2,  APP_ENCODER_GAIN_ONE},
+    {8,  3 * APP_ENCODER_GAIN_ONE},
+};
+
+static const struct app_encoder_curve encoder_xy_curve =
+{
+    .points         = encoder_xy_points,
+    .nb_points      = sizeof(encoder_xy_points) / sizeof(encoder_xy_points[0]),
+};
+
+static const struct app_encoder_curve encoder_z_curve =
+{
+    .points         = encoder_z_points,
+    .nb_points      = sizeof(encoder_z_points) / sizeof(encoder_z_points[0]),
+};
+
+static bool encoder_send(int16_t x, int16_t y, int8_t z);
+
+static const struct app_encoder_cfg encoder_cfg =
+{
+    .qdec =
+    {
+#if defined (__DA14531__)
+        .chx_event_mode = QUAD_DEC_CHX_NORMAL_COUNTING,
+        .chy_event_mode = QUAD_DEC_CHY_NORMAL_COUNTING,
+        .chz_event_mode = QUAD_DEC_CHZ_NORMAL_COUNTING,
+#endif
+        .chx_port_sel   = QUAD_DEC_CHXA_NONE_AND_CHXB_NONE,
+        .chy_port_sel   = QUAD_DEC_CHYA_NONE_AND_CHYB_NONE,
+        .chz_port_sel   = ENCODER_Z_PORT_SEL,
+        .qdec_clockdiv  = USER_ENCODER_CLOCKDIV,
+        .qdec_events_count_to_trigger_interrupt = APP_ENCODER_IRQ_EVENTS,
+    },
+    .pins           = encoder_pins,
+    .nb_pins        = ENCODER_NB_PINS,
+    .xy_curve       = &encoder_xy_curve,
+    .z_curve        = &encoder_z_curve,
+    .send           = encoder_send,
+};
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Sends the mouse report: X, Y (16 bits, little endian) and wheel.
+ * @param[in] x       Horizontal motion
+ * @param[in] y       Vertical motion
+ * @param[in] z       Wheel motion
+ * @return false if the report must be retried
+ ****************************************************************************************
+ */
+static bool encoder_send(int16_t x, int16_t y, int8_t z)
+{
+    uint8_t report[HID_MOUSE_MOTION_REPORT_SIZE] = {0};
+
+    report[0] = (uint8_t)x;
+    report[1] = (uint8_t)((uint16_t)x >> 8);
+    report[2] = (uint8_t)y;
+    report[3] = (uint8_t)((uint16_t)y >> 8);
+    report[4] = (uint8_t)z;
+
+    if (app_hogpd_send_report(HID_MOUSE_MOTION_REPORT_IDX, report, HID_MOUSE_MOTION_REPORT_SIZE, HOGPD_REPORT))
+    {
+        return true;
+    }
+
+    // Without a host the motion is dropped
+    return (app_hogpd_get_active_host() == GAP_INVALID_CONIDX);
+}
+
+void user_encoder_init(void)
+{
+    app_encoder_init(&encoder_cfg);
+}
+
+void user_encoder_report_rsp(void)
+{
+    app_encoder_report_done();
+}
+
+#endif // CFG_APP_ENCODER
+
+/// @} APP
@@ -0,0 +1,97 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_encoder.h
+ *
+ * @brief Quadrature encoder to HID mouse report header file.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+#ifndef _USER_ENCODER_H_
+#define _USER_ENCODER_H_
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @ingroup RICOW
+ *
+ * @brief Sends the motion of a quadrature encoder counted by app_encoder in the mouse report.
+ *
+ * The encoder pins are listed in user_periph_setup.h and the acceleration curves in
+ * user_encoder.c. The mouse report is sent when the encoder moves and then once per
+ * HOGPD_REPORT_UPD_RSP while it keeps moving, with the motion gathered meanwhile. The
+ * motion is dropped while no host is connected.
+ *
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/* Clock divider of the quadrature decoder, the inputs are sampled at 16MHz/(div+1) */
+#define USER_ENCODER_CLOCKDIV               (999)    // 16kHz
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+#if defined (CFG_APP_ENCODER)
+
+/**
+ ****************************************************************************************
+ * @brief Starts the encoder.
+ * @return void
+ ****************************************************************************************
+*/
+void user_encoder_init(void);
+
+/**
+ ****************************************************************************************
+ * @brief Sends the motion gathered since the last report. Called on HOGPD_REPORT_UPD_RSP.
+ * @return void
+ ****************************************************************************************
+*/
+void user_encoder_report_rsp(void);
+
+#else
+
+#define user_encoder_report_rsp()
+
+#endif // CFG_APP_ENCODER
+
+/// @} APP
+
+#endif // _USER_ENCODER_H_
@@ -42,7 +42,14 @@
  #include "app_entry_point.h"
  #include "adc.h"
  #include "app_easy_security.h"
+ #include "app_prf_perm_types.h"
  #include "app_bond_db.h"
+ #include "user_conn_ctrl.h"
+#include "user_uart_wakeup.h"
+#include "user_trace.h"
+#include "user_adc_axes.h"
+#include "user_stream.h"
+#include "user_kbd.h"
  
  struct keyboard_report_t
 {
@@ -57,11 +64,18 @@
 
  bool    axis_polling_on														__SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
  timer_hnd axis_update_timer_used										__SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+#if defined (CFG_ADC_AXES)
+/// Axis report not sent yet, retried on the next polling period
+static bool axes_report_pending                 __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+#endif
  
 uint8_t rx_data;
 uint8_t rx_buffer[100];
 uint8_t rx_cnt = 0;
 uint8_t rx_flag = 0;
+// Frame received, waits to be forwarded while UART2 receives the next one
+static uint8_t rx_frame[sizeof(rx_buffer)];
+static uint8_t rx_frame_len = 0;
 
 int scan_cvt=1;
 void kbd_send_ch(uint8_t ch);
@@ -70,13 +84,41 @@ void kbd_send_str(const char* text);
  * FUNCTION DEFINITIONS
  ****************************************************************************************
  */
+/**
+ ****************************************************************************************
+ * Move the frame received to the frame buffer and receive the next one. Only when the
+ * frame buffer is free and UART2 reception is stopped, rx_flag set.
+ ****************************************************************************************
+ */
+static void uart_rx_frame_move(void)
+{
+	memcpy(rx_frame, rx_buffer, rx_cnt);
+	rx_frame_len = rx_cnt;
+	rx_cnt = 0;
+	rx_flag = 0;
+	uart_receive(UART2,&rx_data,1,UART_OP_INTR);
+}
+
 // this function is called every byte received
 static void uart_rx_callback(uint16_t cnt)
 {
 	// rx_cnt = 0;
+	if((rx_cnt == 0) && (rx_data == UART2_WAKEUP_PREAMBLE)){
+		// wake-up byte in front of a frame, not part of the frame
+		uart_receive(UART2,&rx_data,1,UART_OP_INTR);
+		return;
+	}
+	if(rx_cnt == 0)
+		user_trace_rx_start();
 	rx_buffer[rx_cnt] = rx_data;
 	rx_cnt++;
-	if(rx_data == '!')		rx_flag = 1;
+	if(rx_data == '!'){
+		user_trace_rx_end();
+		rx_flag = 1;
+		// Reception stops only while the previous frame still waits
+		if(rx_frame_len == 0)
+			uart_rx_frame_move();
+	}
 	else uart_receive(UART2,&rx_data,1,UART_OP_INTR);
 }
 
@@ -87,12 +129,32 @@ static void uart_rx_callback(uint16_t cnt)
  ****************************************************************************************
  */
 void user_gamepad_init(void){
-	uart_register_rx_cb(UART2,uart_rx_callback);
-	uart_receive(UART2,&rx_data,1,UART_OP_INTR);
+	user_gamepad_uart_rx_resume();
+	user_uart_wakeup_init();
 	app_set_prf_srv_perm(TASK_ID_CUSTS1, SRV_PERM_UNAUTH);
 	app_easy_security_bdb_init();
 }
 
+/**
+ ****************************************************************************************
+ * (Re)arm UART2 reception, uart_initialize() drops the rx callback on every wake-up
+ ****************************************************************************************
+ */
+void user_gamepad_uart_rx_resume(void){
+	uart_register_rx_cb(UART2,uart_rx_callback);
+	if(rx_flag == 0)
+		uart_receive(UART2,&rx_data,1,UART_OP_INTR);
+}
+
+/**
+ ****************************************************************************************
+ * True while a frame is being received, waits to be forwarded or is echoed on UART2
+ ****************************************************************************************
+ */
+bool user_gamepad_uart_busy(void){
+	return (rx_cnt != 0) || (rx_frame_len != 0) || (uart_tx_empty_getf(UART2) == 0);
+}
+
 /**
  ****************************************************************************************
  * @brief Introduces a variable microsend delay for use with ADC peripheral.
@@ -266,17 +328,20 @@ const uint8_t _asciimap[128] =
     0               // DEL
 };
 
-void kbd_send_ch(uint8_t ch){
-    int code;
-    int i;
+uint8_t kbd_code(uint8_t ch){
     if( scan_cvt ){
-        if( ch > 128 ){
+        if( ch >= 128 ){
             ch -=128;
         }
-        code = _asciimap[ch];
+        return _asciimap[ch];
     }
-    else
-        code = ch;
+    return ch;
+}
+
+void kbd_send_ch(uint8_t ch){
+    int code;
+    int i;
+    code = kbd_code(ch);
 
     kbd_report.keycode[0]=code&0x7F;
     kbd_report.keycode[1]=0;
@@ -297,24 +362,80 @@ void kbd_send_ch(uint8_t ch){
 }
 
 void kbd_send_str(const char *str){
+#if defined (CFG_KBD_PACING)
+    // Typed at the pace of the connection, see user_kbd.h
+    user_kbd_send_str(str);
+#else
     while( *str){
         kbd_send_ch(*str);
         str++;
     }
 		// do you think we have such issue when we are clinking fast?
+#endif
 }
 
 void user_gamepad_update_joystick(void){
 
-	if(rx_flag == 1){
-		uart_send(UART2,rx_buffer,rx_cnt,UART_OP_INTR);
-		rx_buffer[rx_cnt-1] = 0;// remove last character "!"
-		kbd_send_str((char*)rx_buffer); // BLE connection and it is treated as keyboard input
-		rx_cnt = 0;
-		rx_flag = 0; 
-		uart_receive(UART2,&rx_data,1,UART_OP_INTR); // 
+	// Bytes pending on UART2 mark the start of a burst, switch the link to low latency
+	if((rx_cnt != 0) || (rx_frame_len != 0)){
+		user_conn_ctrl_traffic_ind();
+		user_uart_wakeup_keep_awake();
 	}
+
+	if(rx_frame_len != 0){
+#if defined (CFG_KBD_PACING)
+		// A keyboard frame waits for room in the pacing buffer, unless no host would type it.
+		// UART2 keeps receiving the next frame meanwhile.
+		if((rx_frame[0] != HOST_SWITCH_CHAR) &&
+#if defined (CFG_CUSTS1_STREAM)
+		   (rx_frame[0] != STREAM_CHAR) &&
+#endif
+		   !user_kbd_has_room(rx_frame_len - 1) && (app_hogpd_get_active_host() != GAP_INVALID_CONIDX))
+			return;
+#endif
+		// The echo tells the host the frame has been taken
+		uart_send(UART2,rx_frame,rx_frame_len,UART_OP_INTR);
+		rx_frame[rx_frame_len-1] = 0;// remove last character "!"
+		user_trace_frame_dispatch();
+		if(rx_frame[0] == HOST_SWITCH_CHAR){
+			// Host hotkey, the host number counts from 1
+			if(app_hogpd_set_active_host(rx_frame[1] - '1')){
+#if defined (CFG_ADC_AXES)
+				axes_report_pending = true; // the new host gets the current axes
+#endif
+			}
+		}
+#if defined (CFG_CUSTS1_STREAM)
+		else if(rx_frame[0] == STREAM_CHAR){
+			// Neither the STX nor the "!" are part of the data
+			user_stream_write(app_hogpd_get_active_host(), &rx_frame[1], rx_frame_len - 2);
+		}
+#endif
+		else
+			kbd_send_str((char*)rx_frame); // BLE connection and it is treated as keyboard input
+		user_trace_frame_done();
+		// A frame received meanwhile stopped the reception, it is next
+		GLOBAL_INT_DISABLE();
+		rx_frame_len = 0;
+		if(rx_flag == 1)
+			uart_rx_frame_move();
+		GLOBAL_INT_RESTORE();
+	}
+}
+
+#if defined (CFG_ADC_AXES)
+/**
+ ****************************************************************************************
+ * Send the axis report when the sampled axes have moved
+ ****************************************************************************************
+ */
+static void user_gamepad_send_axes(void){
+	uint8_t report[HID_GAMEPAD_ADC_AXES_REPORT_SIZE];
+
+	if(user_adc_axes_get(report) || axes_report_pending)
+		axes_report_pending = !app_hogpd_send_report(HID_GAMEPAD_ADC_AXES_REPORT_IDX, report, HID_GAMEPAD_ADC_AXES_REPORT_SIZE, HOGPD_REPORT);
 }
+#endif
 
 /**
  ****************************************************************************************
@@ -323,7 +444,27 @@ void user_gamepad_update_joystick(void){
  */
 void user_gamepad_axis_polling_cb(void){
 	user_gamepad_update_joystick();
-	if(axis_polling_on)
+#if defined (CFG_ADC_AXES)
+	user_gamepad_send_axes();
+#endif
+	axis_update_timer_used = EASY_TIMER_INVALID_TIMER;
+	if(!axis_polling_on)
+		return;
+#if !defined (CFG_ADC_AXES)
+	// Only UART2 is polled, nothing to do until it wakes the system up again
+	if(!user_gamepad_uart_busy() && !user_uart_wakeup_awake())
+		return;
+#endif
+	axis_update_timer_used = app_easy_timer(AXIS_UPDATE_PER, user_gamepad_axis_polling_cb);
+}
+
+/**
+ ****************************************************************************************
+ * Restart the polling timer parked while UART2 was idle
+ ****************************************************************************************
+ */
+void user_gamepad_polling_resume(void){
+	if(axis_polling_on && (axis_update_timer_used == EASY_TIMER_INVALID_TIMER))
 		axis_update_timer_used = app_easy_timer(AXIS_UPDATE_PER, user_gamepad_axis_polling_cb);
 }
 
@@ -337,11 +478,17 @@ void user_gamepad_toggle_axis_polling(bool on){
 	if(axis_polling_on!=on){
 		if(on){
 			axis_polling_on = on;
+#if defined (CFG_ADC_AXES)
+			user_adc_axes_start();
+#endif
 			user_gamepad_axis_polling_cb();
 		}
 		else{
 			axis_polling_on = on;
 			axis_update_timer_used = EASY_TIMER_INVALID_TIMER;
+#if defined (CFG_ADC_AXES)
+			user_adc_axes_stop();
+#endif
 		}
 	}
 }
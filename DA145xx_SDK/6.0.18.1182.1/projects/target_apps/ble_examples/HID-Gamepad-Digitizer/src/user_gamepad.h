@@ -56,6 +56,8 @@
 #define R_DEADZONE				8    //out of 100
 #define LS_ADC_SAMPLE_MIN       0
 #define ADC_SAMPLE_MAX				1860
+#define HOST_SWITCH_CHAR        0x1B // UART2 frame "<ESC><n>!" sends the reports to host n
+#define STREAM_CHAR             0x02 // UART2 frame "<STX><data>!" is streamed to the active host, see user_stream.h
 
 #define CFG_USE_DIGITIZER   (0)
 #define CFG_USE_JOYSTICKS		(1)
@@ -68,6 +70,11 @@ void user_gamepad_init(void);
 void user_gamepad_enable_buttons(void);
 void user_gamepad_config_digitizer(void);
 void user_gamepad_toggle_axis_polling(bool on);
+void user_gamepad_uart_rx_resume(void);
+bool user_gamepad_uart_busy(void);
+void user_gamepad_polling_resume(void);
+uint8_t user_sample_conv(uint16_t input, uint16_t cap);
+uint8_t kbd_code(uint8_t ch);     // HID keycode of an ASCII character, bit 7 set if it needs Shift
 void app_hid_gamepad_event_handler(ke_msg_id_t const msgid,
                                          void const *param,
                                          ke_task_id_t const dest_id,
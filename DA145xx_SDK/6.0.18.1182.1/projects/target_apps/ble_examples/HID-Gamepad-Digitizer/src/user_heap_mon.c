@@ -0,0 +1,283 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_heap_mon.c
+ *
+ * @brief Kernel heap usage monitor source code.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <string.h>
+#include "rwip_config.h"             // SW configuration
+#include "arch.h"
+#include "ke_mem.h"
+#include "ke_env.h"
+#include "lld_evt.h"
+#include "co_utils.h"
+#include "user_heap_mon.h"
+
+#if !(KE_PROFILING)
+// The ROM kernel keeps the heap usage counters regardless of KE_PROFILING
+uint16_t ke_get_mem_usage(uint8_t type);
+uint32_t ke_get_max_mem_usage(void);
+#endif
+
+#if defined (CFG_LOG_HEAP_USAGE)
+extern struct mem_usage_log heap_usage_env;
+extern struct mem_usage_log heap_usage_db;
+extern struct mem_usage_log heap_usage_msg;
+extern struct mem_usage_log heap_usage_nonRet;
+#endif
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Per heap statistics
+struct heap_mon_stats
+{
+    /// Used size at the last sample
+    uint16_t used;
+    /// Highest used size
+    uint16_t max_used;
+    /// Largest block that could be allocated at the last search
+    uint16_t largest_free;
+    /// Smallest largest_free seen
+    uint16_t min_largest_free;
+};
+
+/// Monitor environment
+struct heap_mon_env_tag
+{
+    /// BLE time of the last sample
+    uint32_t last_sample;
+    /// Number of samples
+    uint16_t samples;
+    /// Peak use of all heaps reported by the kernel
+    uint32_t max_mem_usage;
+    /// Per heap statistics
+    struct heap_mon_stats heaps[KE_MEM_BLOCK_MAX];
+    /// Allocation failures per call site
+    uint16_t alloc_failures[USER_HEAP_MON_SITE_NB];
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static struct heap_mon_env_tag heap_mon_env             __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Finds the largest block that can be allocated from a heap. The kernel may serve
+ *        the request from another heap when the requested one is full, so this is the
+ *        largest request of this type that would currently succeed.
+ * @param[in] type Heap
+ * @return Size of the block in bytes
+ ****************************************************************************************
+ */
+static uint16_t heap_mon_largest_free(uint8_t type)
+{
+    uint32_t low = 0;
+    uint32_t high = ke_env.heap_size[type];
+
+    // Binary search on the size accepted by ke_check_malloc()
+    while (low < high)
+    {
+        uint32_t mid = (low + high + 1) / 2;
+
+        if (ke_check_malloc(mid, type))
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid - 1;
+        }
+    }
+
+    return (uint16_t)low;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Returns the exact high-water mark of a heap when heap logging is enabled.
+ * @param[in] type Heap
+ * @return High-water mark in bytes, 0 if not available
+ ****************************************************************************************
+ */
+static uint16_t heap_mon_logged_max(uint8_t type)
+{
+#if defined (CFG_LOG_HEAP_USAGE)
+    switch (type)
+    {
+        case KE_MEM_ENV:            return heap_usage_env.max_used_sz;
+        case KE_MEM_ATT_DB:         return heap_usage_db.max_used_sz;
+        case KE_MEM_KE_MSG:         return heap_usage_msg.max_used_sz;
+        case KE_MEM_NON_RETENTION:  return heap_usage_nonRet.max_used_sz;
+        default:                    break;
+    }
+#endif
+    return 0;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Samples the heaps.
+ * @return void
+ ****************************************************************************************
+ */
+static void heap_mon_sample(void)
+{
+    bool search = ((heap_mon_env.samples % USER_HEAP_MON_FRAG_DIV) == 0);
+    uint32_t max_mem_usage;
+    uint8_t i;
+
+    for (i = 0; i < KE_MEM_BLOCK_MAX; i++)
+    {
+        struct heap_mon_stats *heap = &heap_mon_env.heaps[i];
+        uint16_t logged_max = heap_mon_logged_max(i);
+
+        heap->used = ke_get_mem_usage(i);
+
+        if (heap->used > heap->max_used)
+        {
+            heap->max_used = heap->used;
+        }
+
+        if (logged_max > heap->max_used)
+        {
+            heap->max_used = logged_max;
+        }
+
+        if (search)
+        {
+            heap->largest_free = heap_mon_largest_free(i);
+
+            if ((heap_mon_env.samples == 0) || (heap->largest_free < heap->min_largest_free))
+            {
+                heap->min_largest_free = heap->largest_free;
+            }
+        }
+    }
+
+    // Reading the peak also restarts it
+    max_mem_usage = ke_get_max_mem_usage();
+    if (max_mem_usage > heap_mon_env.max_mem_usage)
+    {
+        heap_mon_env.max_mem_usage = max_mem_usage;
+    }
+
+    if (heap_mon_env.samples != 0xFFFF)
+    {
+        heap_mon_env.samples++;
+    }
+    else
+    {
+        // Keep searching periodically once the counter saturates
+        heap_mon_env.samples -= USER_HEAP_MON_FRAG_DIV - 1;
+    }
+}
+
+arch_main_loop_callback_ret_t user_heap_mon_on_ble_powered(void)
+{
+    uint32_t now = lld_evt_time_get();
+
+    if ((heap_mon_env.samples == 0) ||
+        (((now - heap_mon_env.last_sample) & BLE_BASETIMECNT_MASK) >= USER_HEAP_MON_PERIOD))
+    {
+        heap_mon_env.last_sample = now;
+        heap_mon_sample();
+    }
+
+    return GOTO_SLEEP;
+}
+
+void user_heap_mon_alloc_failed(enum user_heap_mon_site site)
+{
+    if (heap_mon_env.alloc_failures[site] != 0xFFFF)
+    {
+        heap_mon_env.alloc_failures[site]++;
+    }
+}
+
+void user_heap_mon_reset(void)
+{
+    memset(&heap_mon_env, 0, sizeof(heap_mon_env));
+}
+
+uint16_t user_heap_mon_stats_pack(uint8_t *buf)
+{
+    uint8_t *p = buf;
+    uint8_t i;
+
+    *p++ = USER_HEAP_MON_STATS_VERSION;
+    *p++ = KE_MEM_BLOCK_MAX;
+    co_write16p(p, heap_mon_env.samples);
+    p += 2;
+    co_write32p(p, heap_mon_env.max_mem_usage);
+    p += 4;
+
+    for (i = 0; i < KE_MEM_BLOCK_MAX; i++)
+    {
+        struct heap_mon_stats const *heap = &heap_mon_env.heaps[i];
+
+        co_write16p(p, ke_env.heap_size[i]);
+        co_write16p(p + 2, heap->used);
+        co_write16p(p + 4, heap->max_used);
+        co_write16p(p + 6, heap->largest_free);
+        co_write16p(p + 8, heap->min_largest_free);
+        p += 10;
+    }
+
+    *p++ = USER_HEAP_MON_SITE_NB;
+    for (i = 0; i < USER_HEAP_MON_SITE_NB; i++)
+    {
+        co_write16p(p, heap_mon_env.alloc_failures[i]);
+        p += 2;
+    }
+
+    return (uint16_t)(p - buf);
+}
+
+/// @} APP
@@ -0,0 +1,147 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_heap_mon.h
+ *
+ * @brief Kernel heap usage monitor header file.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+#ifndef _USER_HEAP_MON_H_
+#define _USER_HEAP_MON_H_
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @ingroup RICOW
+ *
+ * @brief Samples the use of the four kernel heaps while the BLE core is powered, i.e.
+ *        around the connection events, and counts allocation failures per call site.
+ *
+ * Per heap it keeps the current use, the sampled high-water mark (exact when
+ * CFG_LOG_HEAP_USAGE is defined) and the largest block that can still be allocated,
+ * which shows fragmentation. The statistics are exported through the
+ * CUST1_IDX_HEAP_STATS_VAL characteristic, see user_heap_mon_stats_pack() for the
+ * layout. Writing the characteristic clears them.
+ *
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "rwip_config.h"
+#include "arch_api.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/* Minimum time between two samples, in 625us BLE slots */
+#define USER_HEAP_MON_PERIOD                (8)
+
+/* The largest free block is searched every USER_HEAP_MON_FRAG_DIV samples */
+#define USER_HEAP_MON_FRAG_DIV              (16)
+
+/* Layout version of the exported statistics */
+#define USER_HEAP_MON_STATS_VERSION         (1)
+
+/* Size of the exported statistics */
+#define USER_HEAP_MON_STATS_LEN             (8 + 10 * KE_MEM_BLOCK_MAX + 1 + 2 * USER_HEAP_MON_SITE_NB)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Allocation call sites whose failures are counted
+enum user_heap_mon_site
+{
+    /// HOGPD_REPORT_UPD_REQ in app_hogpd_send_report()
+    USER_HEAP_MON_SITE_HOGPD_REPORT = 0,
+    /// CUSTS1_VALUE_REQ_RSP for the statistics characteristics
+    USER_HEAP_MON_SITE_CUSTS1_RSP,
+    /// GATTC_SEND_EVT_CMD in user_stream.c
+    USER_HEAP_MON_SITE_STREAM_NTF,
+    /// GATTC_SEND_EVT_CMD in user_audio.c
+    USER_HEAP_MON_SITE_AUDIO_NTF,
+    /// L2CC_PDU_SEND_REQ in user_lecb.c
+    USER_HEAP_MON_SITE_LECB_SDU,
+
+    USER_HEAP_MON_SITE_NB
+};
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Samples the heaps if USER_HEAP_MON_PERIOD has elapsed. To be registered as
+ *        app_on_ble_powered callback.
+ * @return GOTO_SLEEP
+ ****************************************************************************************
+*/
+arch_main_loop_callback_ret_t user_heap_mon_on_ble_powered(void);
+
+/**
+ ****************************************************************************************
+ * @brief Counts an allocation failure.
+ * @param[in] site Call site
+ * @return void
+ ****************************************************************************************
+*/
+void user_heap_mon_alloc_failed(enum user_heap_mon_site site);
+
+/**
+ ****************************************************************************************
+ * @brief Clears the statistics.
+ * @return void
+ ****************************************************************************************
+*/
+void user_heap_mon_reset(void);
+
+/**
+ ****************************************************************************************
+ * @brief Serializes the statistics, little endian:
+ *        u8 version, u8 nb_heaps, u16 samples, u32 peak use of all heaps,
+ *        per heap (ENV, DB, MSG, NON_RET): u16 size, u16 used, u16 max_used,
+ *        u16 largest_free, u16 min_largest_free,
+ *        u8 nb_sites, u16 alloc_failures[nb_sites].
+ * @param[out] buf Buffer of at least USER_HEAP_MON_STATS_LEN bytes
+ * @return Number of bytes written
+ ****************************************************************************************
+*/
+uint16_t user_heap_mon_stats_pack(uint8_t *buf);
+
+/// @} APP
+
+#endif // _USER_HEAP_MON_H_
@@ -48,6 +48,7 @@
 #include "hogpd.h"
 #include "hogpd_task.h"
 #include "user_gamepad.h"
+#include "user_adc_axes.h"
 
 #define HID_MOUSE_MOTION_REPORT_ID       	0x01 // Mouse motion report
 #define HID_MOUSE_MOTION_REPORT_SIZE     	8    // The size of the mouse motion report
@@ -66,6 +67,11 @@
                                          
 	#define HID_GAMEPAD_BUTTONS_REPORT_ID     		0x03 // Advanced buttons report
 	#define HID_GAMEPAD_BUTTONS_REPORT_SIZE   		2    // The size of the advanced buttons report
+
+#if defined (CFG_ADC_AXES)
+	#define HID_GAMEPAD_ADC_AXES_REPORT_ID    		0x04 // Analog axes report
+	#define HID_GAMEPAD_ADC_AXES_REPORT_SIZE  		(USER_ADC_AXES_NUM) // The size of the analog axes report
+#endif
 #endif
 
 enum hogpd_indexes {
@@ -77,6 +83,9 @@ enum hogpd_indexes {
 #else
 	  HID_GAMEPAD_AXIS_REPORT_IDX,
 		HID_GAMEPAD_BUTTONS_REPORT_IDX,
+#if defined (CFG_ADC_AXES)
+		HID_GAMEPAD_ADC_AXES_REPORT_IDX,
+#endif
 #endif
     HID_NUM_OF_REPORTS // Don't remove this.
 };
@@ -114,6 +123,13 @@ static const hogpd_reports_t hogpd_reports[HID_NUM_OF_REPORTS] =
                                     .read_callback  = NULL,
                                     .write_callback = NULL},
 
+#if defined (CFG_ADC_AXES)
+	[HID_GAMEPAD_ADC_AXES_REPORT_IDX]   = {.id        = HID_GAMEPAD_ADC_AXES_REPORT_ID,
+                                    .size           = HID_GAMEPAD_ADC_AXES_REPORT_SIZE,
+                                    .cfg            = HOGPD_CFG_REPORT_IN | HOGPD_REPORT_NTF_CFG_MASK | HOGPD_CFG_REPORT_WR,
+                                    .read_callback  = NULL,
+                                    .write_callback = NULL},
+#endif
 #endif																		
 };
 
@@ -151,6 +167,13 @@ static const hogpd_params_t hogpd_params = {
 #else
     .normally_connectable = false,
 #endif  
+
+/**
+ ****************************************************************************************
+ * Routing of the reports when several hosts are connected (CFG_MULTI_HOST)
+ ****************************************************************************************
+ */
+    .host_routing         = APP_HOGPD_ROUTE_HOTKEY,
   
 /**
  ****************************************************************************************
@@ -168,6 +191,32 @@ static const hogpd_params_t hogpd_params = {
 // Report Descriptor == Report Map (HID1_11.pdf section E.6)
 static const uint8_t report_map[]  =
 {
+#if defined (CFG_APP_ENCODER)
+    HID_USAGE_PAGE          (HID_USAGE_PAGE_GENERIC_DESKTOP),                   // USAGE_PAGE (Generic Desktop)
+    HID_USAGE               (HID_GEN_DESKTOP_USAGE_MOUSE),                      // USAGE (Mouse)
+    HID_COLLECTION          (HID_APPLICATION),                                  // COLLECTION (Application)
+        HID_REPORT_ID           (HID_MOUSE_MOTION_REPORT_ID),                   // REPORT_ID (1)
+        HID_USAGE               (HID_GEN_DESKTOP_USAGE_POINTER),                // USAGE (Pointer)
+        HID_COLLECTION          (HID_PHYSICAL),                                 // COLLECTION (Physical)
+            HID_USAGE               (HID_GEN_DESKTOP_USAGE_X),                  // USAGE (X)
+            HID_USAGE               (HID_GEN_DESKTOP_USAGE_Y),                  // USAGE (Y)
+            HID_LOGICAL_MIN_16      (0x01,0x80),                                // LOGICAL_MINIMUM (-32767)
+            HID_LOGICAL_MAX_16      (0xff,0x7f),                                // LOGICAL_MAXIMUM (32767)
+            HID_REPORT_SIZE         (0x10),                                     // REPORT_SIZE (16)
+            HID_REPORT_COUNT        (0x02),                                     // REPORT_COUNT (2)
+            HID_INPUT               (HID_DATA_BIT | HID_VAR_BIT | HID_REL_BIT), // INPUT (Data,Var,Rel)
+            HID_USAGE               (HID_GEN_DESKTOP_USAGE_WHEEL),              // USAGE (Wheel)
+            HID_LOGICAL_MIN_8       (0x81),                                     // LOGICAL_MINIMUM (-127)
+            HID_LOGICAL_MAX_8       (0x7f),                                     // LOGICAL_MAXIMUM (127)
+            HID_REPORT_SIZE         (0x08),                                     // REPORT_SIZE (8)
+            HID_REPORT_COUNT        (0x01),                                     // REPORT_COUNT (1)
+            HID_INPUT               (HID_DATA_BIT | HID_VAR_BIT | HID_REL_BIT), // INPUT (Data,Var,Rel)
+            HID_REPORT_COUNT        (HID_MOUSE_MOTION_REPORT_SIZE - 5),         // Padding to the report size
+            HID_INPUT               (HID_CONST_BIT | HID_VAR_BIT | HID_ABS_BIT),// INPUT (Cnst,Var,Abs)
+        HID_END_COLLECTION,                                                     //   END_COLLECTION
+    HID_END_COLLECTION,                                                         // END_COLLECTION
+#endif // CFG_APP_ENCODER
+
 #if CFG_USE_DIGITIZER
 	HID_USAGE_PAGE          (HID_USAGE_PAGE_DIGITIZER),                   // USAGE_PAGE (Digitizer)
     HID_USAGE               (HID_GEN_DIGITIZER_USAGE_PEN),                    // USAGE (Pen)
@@ -375,6 +424,21 @@ static const uint8_t report_map[]  =
         0x29, 0x65,        //   Usage Maximum (0x65)
         0x81, 0x00,        //   Input (Data,Array,Abs,No Wrap,Linear,Preferred State,No Null Position)
         0xC0,              // End Collection
+
+#if defined (CFG_ADC_AXES)
+    HID_USAGE_PAGE          (HID_USAGE_PAGE_GENERIC_DESKTOP),                   // USAGE_PAGE (Generic Desktop)
+    HID_USAGE               (HID_GEN_DESKTOP_USAGE_GAMEPAD),                    // USAGE (Gamepad)
+    HID_COLLECTION          (HID_APPLICATION),                                  // COLLECTION (Application)
+        HID_REPORT_ID           (HID_GAMEPAD_ADC_AXES_REPORT_ID),               // REPORT_ID (4)
+        HID_USAGE               (HID_GEN_DESKTOP_USAGE_X),                      // USAGE (X)
+        HID_USAGE               (HID_GEN_DESKTOP_USAGE_Y),                      // USAGE (Y)
+        HID_LOGICAL_MIN_8       (0x00),                                         // LOGICAL_MINIMUM (0)
+        HID_LOGICAL_MAX_16      (0xff,0x00),                                    // LOGICAL_MAXIMUM (255)
+        HID_REPORT_SIZE         (0x08),                                         // REPORT_SIZE (8)
+        HID_REPORT_COUNT        (USER_ADC_AXES_NUM),                            // REPORT_COUNT (2)
+        HID_INPUT               (HID_DATA_BIT | HID_VAR_BIT | HID_ABS_BIT),     // INPUT (Data,Var,Abs)
+    HID_END_COLLECTION,                                                         // END_COLLECTION
+#endif // CFG_ADC_AXES
 				
 #endif
 };
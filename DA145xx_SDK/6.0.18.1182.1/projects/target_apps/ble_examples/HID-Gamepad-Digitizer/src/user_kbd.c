@@ -0,0 +1,494 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_kbd.c
+ *
+ * @brief Keystroke pacing source code.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <string.h>
+#include "rwip_config.h"             // SW configuration
+#include "arch_api.h"
+#include "co_math.h"
+#include "gap.h"
+#include "gapc.h"
+#include "llc.h"
+#include "lld_evt.h"
+#include "app.h"
+#include "app_hogpd.h"
+#include "app_hid_report_config.h"
+#include "user_hogpd_config.h"
+#include "user_gamepad.h"
+#include "user_kbd.h"
+
+#if defined (CFG_KBD_PACING)
+
+#if (USER_KBD_PKTS_PER_EVENT > HID_REPORT_FIFO_SIZE)
+    #error "USER_KBD_PKTS_PER_EVENT must not exceed HID_REPORT_FIFO_SIZE"
+#endif
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Shift bit of the codes returned by kbd_code()
+#define KBD_CODE_SHIFT                      (0x80)
+
+/// Left Shift in the modifier byte of the keyboard report
+#define KBD_MOD_LEFT_SHIFT                  (0x02)
+
+/// Keycode in the keyboard report
+#define KBD_REPORT_KEY                      (2)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Keys as last reported to the host
+struct kbd_keys
+{
+    /// Key, 0 if none
+    uint8_t key;
+    /// Modifier byte
+    uint8_t mod;
+};
+
+/// Queued string
+struct kbd_string
+{
+    /// Reports sent once the string is typed, in kbd_env.sent units
+    uint32_t end_seq;
+    /// Position after its last character
+    uint16_t end;
+    /// Id
+    uint8_t id;
+};
+
+/// Keystroke pacing environment
+struct kbd_env_tag
+{
+    /// Characters
+    uint8_t buf[USER_KBD_BUF_SIZE];
+    /// Strings, oldest first
+    struct kbd_string strings[USER_KBD_STRINGS_MAX];
+    /// Reports sent, a release that is skipped counts as sent
+    uint32_t sent;
+    /// Connection interval of each host link, 1.25ms units
+    uint16_t con_interval[APP_EASY_MAX_ACTIVE_CONNECTION];
+    /// Position of the next character to type, free running
+    uint16_t head;
+    /// Position of the next free character, free running
+    uint16_t tail;
+    /// Connection event counter of the paced link at the last release
+    uint16_t evt_count;
+    /// Oldest string
+    uint8_t str_head;
+    /// Number of strings
+    uint8_t str_cnt;
+    /// Id of the last string
+    uint8_t last_id;
+    /// Reports still allowed before the next connection event
+    uint8_t credits;
+    /// Link the reports are paced on
+    uint8_t conidx;
+    /// True while the reports are paced on conidx
+    bool paced;
+    /// Keys as last reported to the host
+    struct kbd_keys keys;
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static struct kbd_env_tag kbd_env                   __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Builds the next report towards a character.
+ * @param[in,out] keys  Keys as last reported, updated
+ * @param[in] code      Code of the character, with a key
+ * @param[out] report   Keyboard report
+ * @return true if the report presses the key of the character, false if it only
+ *         changes the modifier or releases the previous key
+ ****************************************************************************************
+ */
+static bool kbd_step(struct kbd_keys *keys, uint8_t code, uint8_t *report)
+{
+    uint8_t key = code & ~KBD_CODE_SHIFT;
+    uint8_t mod = (code & KBD_CODE_SHIFT) ? KBD_MOD_LEFT_SHIFT : 0;
+
+    memset(report, 0, HID_GAMEPAD_AXIS_REPORT_SIZE);
+    report[0] = mod;
+
+    if (mod != keys->mod)
+    {
+        // The modifier changes in a report of its own, the previous key is released
+        keys->mod = mod;
+        keys->key = 0;
+        return false;
+    }
+
+    if (key == keys->key)
+    {
+        // The same key again is released first
+        keys->key = 0;
+        return false;
+    }
+
+    // Pressing the key releases the previous one
+    report[KBD_REPORT_KEY] = key;
+    keys->key = key;
+    return true;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Counts the reports typing characters takes from released keys, with the final
+ *        release.
+ * @param[in] pos       Position of the first character
+ * @param[in] end       Position after the last character
+ * @return Reports
+ ****************************************************************************************
+ */
+static uint32_t kbd_plan(uint16_t pos, uint16_t end)
+{
+    struct kbd_keys keys = {0, 0};
+    uint8_t report[HID_GAMEPAD_AXIS_REPORT_SIZE];
+    uint32_t reports = 0;
+
+    while (pos != end)
+    {
+        uint8_t code = kbd_code(kbd_env.buf[pos % USER_KBD_BUF_SIZE]);
+
+        if ((code & ~KBD_CODE_SHIFT) == 0)
+        {
+            pos++;
+            continue;
+        }
+
+        reports++;
+        if (kbd_step(&keys, code, report))
+        {
+            pos++;
+        }
+    }
+
+    return reports + ((keys.key != 0) || (keys.mod != 0));
+}
+
+/**
+ ****************************************************************************************
+ * @brief Sends the reports of the queued strings, as far as the credits allow.
+ * @param[in] evt_end   true at the end of the event, false while the application may
+ *                      still queue strings before the next event
+ * @return void
+ ****************************************************************************************
+ */
+static void kbd_release(bool evt_end)
+{
+    uint8_t report[HID_GAMEPAD_AXIS_REPORT_SIZE];
+
+    while (kbd_env.str_cnt != 0)
+    {
+        struct kbd_string *str = &kbd_env.strings[kbd_env.str_head];
+        struct kbd_keys keys = kbd_env.keys;
+        bool typed = false;
+
+        if (kbd_env.head == str->end)
+        {
+            // The next string releases the keys itself, and nothing is held without one
+            if (((keys.key == 0) && (keys.mod == 0)) || (kbd_env.str_cnt > 1))
+            {
+                if ((int32_t)(str->end_seq - kbd_env.sent) > 0)
+                {
+                    kbd_env.sent = str->end_seq;
+                }
+                kbd_env.str_head = (kbd_env.str_head + 1) % USER_KBD_STRINGS_MAX;
+                kbd_env.str_cnt--;
+                continue;
+            }
+
+            // A string queued before the next event continues without the release
+            if (!evt_end)
+            {
+                break;
+            }
+
+            memset(report, 0, sizeof(report));
+            keys.key = 0;
+            keys.mod = 0;
+        }
+        else
+        {
+            uint8_t code = kbd_code(kbd_env.buf[kbd_env.head % USER_KBD_BUF_SIZE]);
+
+            // A character without a key is not typed
+            if ((code & ~KBD_CODE_SHIFT) == 0)
+            {
+                kbd_env.head++;
+                continue;
+            }
+
+            typed = kbd_step(&keys, code, report);
+        }
+
+        if ((kbd_env.credits == 0) ||
+            !app_hogpd_send_report(HID_GAMEPAD_AXIS_REPORT_IDX, report, HID_GAMEPAD_AXIS_REPORT_SIZE, HOGPD_REPORT))
+        {
+            break;
+        }
+
+        kbd_env.credits--;
+        kbd_env.sent++;
+        kbd_env.keys = keys;
+        if (typed)
+        {
+            kbd_env.head++;
+        }
+    }
+
+    if (kbd_env.str_cnt == 0)
+    {
+        kbd_env.paced = false;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Reads the connection event counter of a host link.
+ * @param[in] conidx    Connection index
+ * @param[out] count    Event counter
+ * @return false if the link is down
+ ****************************************************************************************
+ */
+static bool kbd_evt_count(uint8_t conidx, uint16_t *count)
+{
+    uint16_t conhdl = gapc_get_conhdl(conidx);
+
+    if ((conhdl >= BLE_CONNECTION_MAX) || (llc_env[conhdl] == NULL) || (llc_env[conhdl]->elt == NULL))
+    {
+        return false;
+    }
+
+    *count = lld_evt_con_count_get(LLD_EVT_ENV_ADDR_GET(llc_env[conhdl]->elt));
+    return true;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Gives the credits of a new connection event of the active host and releases the
+ *        reports. Only between two BLE events, so the reports go out in the next one.
+ * @param[in] evt_end   See kbd_release()
+ * @return void
+ ****************************************************************************************
+ */
+static void kbd_pace(bool evt_end)
+{
+    uint8_t conidx = app_hogpd_get_active_host();
+    uint16_t count;
+
+    if ((kbd_env.str_cnt == 0) || (arch_last_rwble_evt_get() != BLE_EVT_END))
+    {
+        return;
+    }
+
+    if ((conidx == GAP_INVALID_CONIDX) || !kbd_evt_count(conidx, &count))
+    {
+        kbd_env.paced = false;
+        return;
+    }
+
+    if (!kbd_env.paced || (kbd_env.conidx != conidx))
+    {
+        // Another host has not seen the keys of the previous one
+        if (kbd_env.conidx != conidx)
+        {
+            kbd_env.keys.key = 0;
+            kbd_env.keys.mod = 0;
+        }
+        kbd_env.paced = true;
+        kbd_env.conidx = conidx;
+        kbd_env.credits = user_kbd_per_event();
+    }
+    else if (count != kbd_env.evt_count)
+    {
+        // Credits left over are not carried, an event takes at most one batch
+        kbd_env.credits = user_kbd_per_event();
+    }
+    kbd_env.evt_count = count;
+
+    kbd_release(evt_end);
+}
+
+void user_kbd_connected(uint8_t conidx, uint16_t con_interval)
+{
+    if (conidx >= APP_EASY_MAX_ACTIVE_CONNECTION)
+    {
+        return;
+    }
+
+    kbd_env.con_interval[conidx] = con_interval;
+
+    // The new host has no key pressed
+    if (conidx == kbd_env.conidx)
+    {
+        kbd_env.keys.key = 0;
+        kbd_env.keys.mod = 0;
+        kbd_env.paced = false;
+    }
+}
+
+void user_kbd_param_updated(uint8_t conidx, uint16_t con_interval)
+{
+    if (conidx < APP_EASY_MAX_ACTIVE_CONNECTION)
+    {
+        kbd_env.con_interval[conidx] = con_interval;
+    }
+}
+
+bool user_kbd_has_room(uint16_t len)
+{
+    return (kbd_env.str_cnt < USER_KBD_STRINGS_MAX) &&
+           ((uint16_t)(kbd_env.tail - kbd_env.head) + len <= USER_KBD_BUF_SIZE);
+}
+
+uint8_t user_kbd_send_str(const char *str)
+{
+    uint16_t len = strlen(str);
+    uint16_t start = kbd_env.tail;
+    uint32_t seq = kbd_env.sent;
+    struct kbd_string *s;
+
+    if ((len == 0) || !user_kbd_has_room(len))
+    {
+        return 0;
+    }
+
+    while (*str)
+    {
+        kbd_env.buf[kbd_env.tail % USER_KBD_BUF_SIZE] = (uint8_t)*str++;
+        kbd_env.tail++;
+    }
+
+    if (kbd_env.str_cnt != 0)
+    {
+        seq = kbd_env.strings[(kbd_env.str_head + kbd_env.str_cnt - 1) % USER_KBD_STRINGS_MAX].end_seq;
+    }
+
+    if (++kbd_env.last_id == 0)
+    {
+        kbd_env.last_id = 1;
+    }
+
+    s = &kbd_env.strings[(kbd_env.str_head + kbd_env.str_cnt) % USER_KBD_STRINGS_MAX];
+    s->end = kbd_env.tail;
+    s->end_seq = seq + kbd_plan(start, kbd_env.tail);
+    s->id = kbd_env.last_id;
+    kbd_env.str_cnt++;
+
+    // Between two events the first reports go out in the next one
+    kbd_pace(false);
+
+    return s->id;
+}
+
+uint32_t user_kbd_eta(uint8_t id)
+{
+    uint8_t per_event = user_kbd_per_event();
+    uint8_t i;
+
+    for (i = 0; i < kbd_env.str_cnt; i++)
+    {
+        struct kbd_string *str = &kbd_env.strings[(kbd_env.str_head + i) % USER_KBD_STRINGS_MAX];
+        int32_t left;
+
+        if (str->id != id)
+        {
+            continue;
+        }
+
+        if (per_event == 0)
+        {
+            return USER_KBD_ETA_UNKNOWN;
+        }
+
+        // One batch per event, the reports released last wait for the next event. The
+        // interval is in 1.25ms units, rounded up to stay an upper bound
+        left = (int32_t)(str->end_seq - kbd_env.sent);
+        if (left < 0)
+        {
+            left = 0;
+        }
+        return ((((uint32_t)left + per_event - 1) / per_event + 1) *
+                kbd_env.con_interval[app_hogpd_get_active_host()] * 5 + 3) / 4;
+    }
+
+    return 0;
+}
+
+uint8_t user_kbd_per_event(void)
+{
+    uint8_t conidx = app_hogpd_get_active_host();
+    uint32_t fit;
+
+    if ((conidx == GAP_INVALID_CONIDX) || (kbd_env.con_interval[conidx] == 0))
+    {
+        return 0;
+    }
+
+    fit = ((uint32_t)kbd_env.con_interval[conidx] * 1250 - USER_KBD_EVT_GUARD_US) / USER_KBD_PKT_US;
+
+    return (uint8_t)co_max(co_min(fit, USER_KBD_PKTS_PER_EVENT), 1);
+}
+
+void user_kbd_on_ble_powered(void)
+{
+    kbd_pace(true);
+}
+
+#endif // CFG_KBD_PACING
+
+/// @} APP
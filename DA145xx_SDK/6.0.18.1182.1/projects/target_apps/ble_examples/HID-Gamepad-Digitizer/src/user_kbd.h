@@ -0,0 +1,174 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_kbd.h
+ *
+ * @brief Keystroke pacing header file.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+#ifndef _USER_KBD_H_
+#define _USER_KBD_H_
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @ingroup RICOW
+ *
+ * @brief Types the UART2 strings in the keyboard report at the pace of the connection.
+ *
+ * The characters are buffered and turned into keyboard reports only when the link can
+ * take them: every connection event of the active host allows user_kbd_per_event()
+ * reports, as many as fit in the connection interval and at most USER_KBD_PKTS_PER_EVENT.
+ * The event counter of the link is read when the last BLE event has ended, so the reports
+ * released then go out together in the next connection event and the report FIFO of
+ * app_hogpd never overflows.
+ *
+ * A character takes a single report: pressing the next key releases the previous one.
+ * A release report is only added before the same key is pressed again and at the end of
+ * the buffered text, the latter only from user_kbd_on_ble_powered() so the strings queued
+ * until then continue without it, and a change of the Shift modifier is sent in a report of its own,
+ * without a key, so the host sees the modifier before the key it applies to.
+ *
+ * Every string gets an id, user_kbd_eta() estimates when its last report is sent.
+ * A string is taken whole or not at all, user_kbd_has_room() tells whether it fits.
+ *
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined (CFG_KBD_PACING)
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/* Characters buffered */
+#define USER_KBD_BUF_SIZE                   (128)
+
+/* Strings queued at a time */
+#define USER_KBD_STRINGS_MAX                (8)
+
+/* Keyboard reports the hosts take in one connection event, at most HID_REPORT_FIFO_SIZE */
+#define USER_KBD_PKTS_PER_EVENT             (4)
+
+/* Air time of a keyboard report notification with the empty packet of the central, on an
+ * encrypted 1M PHY link, and the time kept free at the end of the event (us) */
+#define USER_KBD_PKT_US                     (625)
+#define USER_KBD_EVT_GUARD_US               (1250)
+
+/* Estimate returned when no host is connected */
+#define USER_KBD_ETA_UNKNOWN                (0xFFFFFFFF)
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Starts from released keys on a new connection.
+ * @param[in] conidx        Connection index
+ * @param[in] con_interval  Connection interval, 1.25ms units
+ * @return void
+ ****************************************************************************************
+*/
+void user_kbd_connected(uint8_t conidx, uint16_t con_interval);
+
+/**
+ ****************************************************************************************
+ * @brief Keeps track of the connection interval.
+ * @param[in] conidx        Connection index
+ * @param[in] con_interval  Connection interval, 1.25ms units
+ * @return void
+ ****************************************************************************************
+*/
+void user_kbd_param_updated(uint8_t conidx, uint16_t con_interval);
+
+/**
+ ****************************************************************************************
+ * @brief Checks whether a string fits in the buffer.
+ * @param[in] len       Length of the string
+ * @return true if user_kbd_send_str() takes it
+ ****************************************************************************************
+*/
+bool user_kbd_has_room(uint16_t len);
+
+/**
+ ****************************************************************************************
+ * @brief Queues a string for typing.
+ * @param[in] str       Characters, converted by kbd_code()
+ * @return Id of the string, 0 if it does not fit
+ ****************************************************************************************
+*/
+uint8_t user_kbd_send_str(const char *str);
+
+/**
+ ****************************************************************************************
+ * @brief Estimates when the last report of a string is sent, at the current connection
+ *        interval. The estimate is an upper bound, a release that is not needed is skipped.
+ * @param[in] id        Id of the string
+ * @return Milliseconds, 0 once all the reports of the string are handed to HOGPD,
+ *         USER_KBD_ETA_UNKNOWN without a host
+ ****************************************************************************************
+*/
+uint32_t user_kbd_eta(uint8_t id);
+
+/**
+ ****************************************************************************************
+ * @brief Reports the active host takes in one connection event.
+ * @return Reports, 0 without a host
+ ****************************************************************************************
+*/
+uint8_t user_kbd_per_event(void);
+
+/**
+ ****************************************************************************************
+ * @brief Releases the reports allowed by the connection events that have ended. To be
+ *        called from app_on_ble_powered.
+ * @return void
+ ****************************************************************************************
+*/
+void user_kbd_on_ble_powered(void);
+
+#else
+
+#define user_kbd_connected(conidx, con_interval)
+#define user_kbd_param_updated(conidx, con_interval)
+#define user_kbd_on_ble_powered()
+
+#endif // CFG_KBD_PACING
+
+/// @} APP
+
+#endif // _USER_KBD_H_
@@ -0,0 +1,233 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_key_matrix.c
+ *
+ * @brief Key matrix to HID keyboard report source code.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <string.h>
+#include "rwip_config.h"             // SW configuration
+#include "app_easy_timer.h"
+#include "app_key_matrix.h"
+#include "app_hogpd.h"
+#include "user_hogpd_config.h"
+#include "user_periph_setup.h"
+#include "user_key_matrix.h"
+
+#if defined (CFG_APP_KEY_MATRIX)
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+#define KEY_MATRIX_NB_ROWS                  (2)
+#define KEY_MATRIX_NB_COLS                  (2)
+
+/// Keycodes of a keyboard report
+#define KEY_MATRIX_NB_KEYCODES              (6)
+
+/// HID usage reported in every keycode when too many keys are pressed
+#define KEY_MATRIX_ERROR_ROLLOVER           (0x01)
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static const struct app_key_matrix_pin key_matrix_rows[KEY_MATRIX_NB_ROWS] =
+{
+    {KEY_MATRIX_ROW0_PORT, KEY_MATRIX_ROW0_PIN},
+    {KEY_MATRIX_ROW1_PORT, KEY_MATRIX_ROW1_PIN},
+};
+
+static const struct app_key_matrix_pin key_matrix_cols[KEY_MATRIX_NB_COLS] =
+{
+    {KEY_MATRIX_COL0_PORT, KEY_MATRIX_COL0_PIN},
+    {KEY_MATRIX_COL1_PORT, KEY_MATRIX_COL1_PIN},
+};
+
+/// HID usage of every key (Keyboard/Keypad page)
+static const uint8_t key_matrix_usage[KEY_MATRIX_NB_ROWS][KEY_MATRIX_NB_COLS] =
+{
+    {0x52, 0x51},   // Up Arrow, Down Arrow
+    {0x50, 0x4F},   // Left Arrow, Right Arrow
+};
+
+static void key_matrix_on_key(uint8_t row, uint8_t col, bool pressed);
+static void key_matrix_on_scan_end(void);
+
+static const struct app_key_matrix_cfg key_matrix_cfg =
+{
+    .rows           = key_matrix_rows,
+    .cols           = key_matrix_cols,
+    .nb_rows        = KEY_MATRIX_NB_ROWS,
+    .nb_cols        = KEY_MATRIX_NB_COLS,
+    .on_key         = key_matrix_on_key,
+    .on_scan_end    = key_matrix_on_scan_end,
+};
+
+/// Keyboard report: modifier, reserved, keycodes
+static uint8_t key_matrix_report[2 + KEY_MATRIX_NB_KEYCODES]    __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+/// Pressed keys that do not fit in the report
+static uint8_t key_matrix_overflow                               __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+/// Report retry timer
+static timer_hnd key_matrix_retry_timer                          __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Adds or removes a key of the report. The keycodes are kept in press order.
+ * @param[in] row     Row of the key
+ * @param[in] col     Column of the key
+ * @param[in] pressed True if the key has been pressed
+ * @return void
+ ****************************************************************************************
+ */
+static void key_matrix_on_key(uint8_t row, uint8_t col, bool pressed)
+{
+    uint8_t *keycodes = &key_matrix_report[2];
+    uint8_t usage = key_matrix_usage[row][col];
+    uint8_t i;
+
+    if (pressed)
+    {
+        for (i = 0; i < KEY_MATRIX_NB_KEYCODES; i++)
+        {
+            if (keycodes[i] == 0)
+            {
+                keycodes[i] = usage;
+                return;
+            }
+        }
+        key_matrix_overflow++;
+        return;
+    }
+
+    for (i = 0; i < KEY_MATRIX_NB_KEYCODES; i++)
+    {
+        if (keycodes[i] == usage)
+        {
+            memmove(&keycodes[i], &keycodes[i + 1], KEY_MATRIX_NB_KEYCODES - 1 - i);
+            keycodes[KEY_MATRIX_NB_KEYCODES - 1] = 0;
+            break;
+        }
+    }
+
+    if (i == KEY_MATRIX_NB_KEYCODES)
+    {
+        // One of the keys that did not fit
+        if (key_matrix_overflow != 0)
+        {
+            key_matrix_overflow--;
+        }
+        return;
+    }
+
+    // Give the free keycode to a key that did not fit, rebuilding the list from the matrix
+    if (key_matrix_overflow != 0)
+    {
+        uint8_t r, c;
+
+        memset(keycodes, 0, KEY_MATRIX_NB_KEYCODES);
+        key_matrix_overflow = 0;
+        for (r = 0; r < KEY_MATRIX_NB_ROWS; r++)
+        {
+            for (c = 0; c < KEY_MATRIX_NB_COLS; c++)
+            {
+                if (((r != row) || (c != col)) && app_key_matrix_is_pressed(r, c))
+                {
+                    key_matrix_on_key(r, c, true);
+                }
+            }
+        }
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Sends the keyboard report, retried until it is queued.
+ * @return void
+ ****************************************************************************************
+ */
+static void key_matrix_send(void)
+{
+    uint8_t report[sizeof(key_matrix_report)];
+
+    key_matrix_retry_timer = EASY_TIMER_INVALID_TIMER;
+
+    memcpy(report, key_matrix_report, sizeof(report));
+    if (key_matrix_overflow != 0)
+    {
+        memset(&report[2], KEY_MATRIX_ERROR_ROLLOVER, KEY_MATRIX_NB_KEYCODES);
+    }
+
+    if (!app_hogpd_send_report(HID_GAMEPAD_AXIS_REPORT_IDX, report, HID_GAMEPAD_AXIS_REPORT_SIZE, HOGPD_REPORT) &&
+        (app_hogpd_get_active_host() != GAP_INVALID_CONIDX))
+    {
+        key_matrix_retry_timer = app_easy_timer(USER_KEY_MATRIX_RETRY, key_matrix_send);
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Sends the report once all the key changes of a scan are applied.
+ * @return void
+ ****************************************************************************************
+ */
+static void key_matrix_on_scan_end(void)
+{
+    // A pending retry sends the latest report
+    if (key_matrix_retry_timer == EASY_TIMER_INVALID_TIMER)
+    {
+        key_matrix_send();
+    }
+}
+
+void user_key_matrix_init(void)
+{
+    app_key_matrix_init(&key_matrix_cfg);
+}
+
+#endif // CFG_APP_KEY_MATRIX
+
+/// @} APP
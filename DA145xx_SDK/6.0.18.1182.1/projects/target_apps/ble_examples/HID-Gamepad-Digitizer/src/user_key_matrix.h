@@ -0,0 +1,85 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_key_matrix.h
+ *
+ * @brief Key matrix to HID keyboard report header file.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+#ifndef _USER_KEY_MATRIX_H_
+#define _USER_KEY_MATRIX_H_
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @ingroup RICOW
+ *
+ * @brief Sends the keys of a matrix scanned by app_key_matrix in the keyboard report.
+ *
+ * The matrix pins are listed in user_periph_setup.h and the HID usage of every key in
+ * user_key_matrix.c. Up to six keys are reported at a time, further keys fill the
+ * keycodes with ErrorRollOver until one is released. The report is sent once per scan
+ * that changed a key.
+ *
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/* Retry period of a report that could not be queued */
+#define USER_KEY_MATRIX_RETRY               (1)      // 1*10ms = 10ms
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+#if defined (CFG_APP_KEY_MATRIX)
+
+/**
+ ****************************************************************************************
+ * @brief Starts scanning the key matrix.
+ * @return void
+ ****************************************************************************************
+*/
+void user_key_matrix_init(void);
+
+#endif // CFG_APP_KEY_MATRIX
+
+/// @} APP
+
+#endif // _USER_KEY_MATRIX_H_
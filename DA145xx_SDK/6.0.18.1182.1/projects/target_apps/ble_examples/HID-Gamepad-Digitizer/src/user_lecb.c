@@ -0,0 +1,219 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_lecb.c
+ *
+ * @brief LE credit based echo channel source code.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <string.h>
+#include "rwip_config.h"             // SW configuration
+#include "arch.h"
+#include "gapc_task.h"
+#include "l2cc_pdu.h"
+#include "app.h"
+#include "app_easy_timer.h"
+#include "user_heap_mon.h"
+#include "user_lecb.h"
+
+#if defined (CFG_APP_LECB)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// SDUs of a connection waiting for their echo, oldest first
+struct user_lecb_queue_tag
+{
+    /// SDU data, kept until its echo is allocated
+    const uint8_t *sdu[APP_LECB_RX_CREDITS];
+    /// SDU lengths
+    uint16_t len[APP_LECB_RX_CREDITS];
+    /// Index of the oldest SDU
+    uint8_t head;
+    /// Number of SDUs
+    uint8_t count;
+};
+
+/// Echo environment
+struct user_lecb_env_tag
+{
+    /// SDUs waiting per connection
+    struct user_lecb_queue_tag queue[APP_EASY_MAX_ACTIVE_CONNECTION];
+    /// Timer retrying the echoes the heap was short for
+    timer_hnd retry_timer;
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static struct user_lecb_env_tag user_lecb_env           __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Releases the oldest SDU of a connection.
+ * @param[in] conidx Connection index
+ ****************************************************************************************
+ */
+static void lecb_pop(uint8_t conidx)
+{
+    struct user_lecb_queue_tag *q = &user_lecb_env.queue[conidx];
+    const uint8_t *sdu = q->sdu[q->head];
+
+    q->head = (q->head + 1) % APP_LECB_RX_CREDITS;
+    q->count--;
+
+    // Returns the credits of the SDU to the host
+    app_lecb_rx_release(conidx, sdu);
+}
+
+static void lecb_retry_timer_cb(void);
+
+/**
+ ****************************************************************************************
+ * @brief Hands the echoes of the waiting SDUs to L2CC, as far as app_lecb accepts them.
+ * @param[in] conidx Connection index
+ ****************************************************************************************
+ */
+static void lecb_pump(uint8_t conidx)
+{
+    struct user_lecb_queue_tag *q = &user_lecb_env.queue[conidx];
+
+    while (q->count != 0)
+    {
+        uint16_t len = q->len[q->head];
+        uint8_t *echo;
+
+        if (len > app_lecb_env[conidx].peer_mtu)
+        {
+            // The host could not take the echo
+            lecb_pop(conidx);
+            continue;
+        }
+
+        echo = app_lecb_sdu_alloc(conidx, len);
+        if (echo == NULL)
+        {
+            if (app_lecb_env[conidx].tx_pending < APP_LECB_TX_PIPELINE)
+            {
+                // The heap is short, no SDU sent will pump again if none is pending
+                user_heap_mon_alloc_failed(USER_HEAP_MON_SITE_LECB_SDU);
+                if ((app_lecb_env[conidx].tx_pending == 0) &&
+                    (user_lecb_env.retry_timer == EASY_TIMER_INVALID_TIMER))
+                {
+                    user_lecb_env.retry_timer = app_easy_timer(USER_LECB_RETRY_DELAY, lecb_retry_timer_cb);
+                }
+            }
+            break;
+        }
+
+        memcpy(echo, q->sdu[q->head], len);
+        app_lecb_sdu_send(conidx);
+        lecb_pop(conidx);
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Retries the echoes of every connection.
+ ****************************************************************************************
+ */
+static void lecb_retry_timer_cb(void)
+{
+    uint8_t i;
+
+    user_lecb_env.retry_timer = EASY_TIMER_INVALID_TIMER;
+
+    for (i = 0; i < APP_EASY_MAX_ACTIVE_CONNECTION; i++)
+    {
+        lecb_pump(i);
+    }
+}
+
+void user_lecb_connected(uint8_t conidx)
+{
+    struct user_lecb_queue_tag *q = &user_lecb_env.queue[conidx];
+
+    q->head = 0;
+    q->count = 0;
+
+    app_lecb_listen(conidx, USER_LECB_LE_PSM, USER_LECB_SEC_LVL);
+}
+
+uint16_t user_lecb_connect_req(uint8_t conidx, uint16_t le_psm, uint16_t peer_mtu)
+{
+    return (le_psm == USER_LECB_LE_PSM) ? L2C_CB_CON_SUCCESS : L2C_CB_CON_LEPSM_NOT_SUPP;
+}
+
+void user_lecb_disconnected(uint8_t conidx, uint16_t le_psm, uint16_t reason)
+{
+    while (user_lecb_env.queue[conidx].count != 0)
+    {
+        lecb_pop(conidx);
+    }
+}
+
+void user_lecb_sdu_received(uint8_t conidx, const uint8_t *sdu, uint16_t len)
+{
+    struct user_lecb_queue_tag *q = &user_lecb_env.queue[conidx];
+
+    // The SDUs kept never exceed the receive budget of app_lecb
+    ASSERT_WARNING(q->count < APP_LECB_RX_CREDITS);
+
+    q->sdu[(q->head + q->count) % APP_LECB_RX_CREDITS] = sdu;
+    q->len[(q->head + q->count) % APP_LECB_RX_CREDITS] = len;
+    q->count++;
+
+    lecb_pump(conidx);
+}
+
+void user_lecb_sdu_sent(uint8_t conidx, uint8_t status)
+{
+    lecb_pump(conidx);
+}
+
+#endif // CFG_APP_LECB
+
+/// @} APP
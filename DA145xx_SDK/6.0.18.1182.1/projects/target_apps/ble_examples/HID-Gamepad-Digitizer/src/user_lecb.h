@@ -0,0 +1,139 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_lecb.h
+ *
+ * @brief LE credit based echo channel header file.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+#ifndef _USER_LECB_H_
+#define _USER_LECB_H_
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @ingroup RICOW
+ *
+ * @brief Echoes the SDUs of an LE credit based channel, opened by the host on
+ * USER_LECB_LE_PSM, through the SDK module app_lecb.
+ *
+ * The LE_PSM is registered on every connection. An SDU received is kept until its echo
+ * is handed to L2CC, so the credits of the host only come back as fast as the echoes
+ * go out: a host sending faster than it reads is paced by app_lecb, not by dropping
+ * SDUs. An SDU longer than the MTU of the host is dropped. Up to APP_LECB_RX_CREDITS
+ * SDUs wait per connection, which the receive budget of app_lecb never exceeds.
+ *
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined (CFG_APP_LECB)
+
+#include "app_lecb.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/* LE_PSM of the echo channel, dynamic range */
+#define USER_LECB_LE_PSM                    (0x0080)
+
+/* Security a host needs to open the echo channel, none for the demo */
+#define USER_LECB_SEC_LVL                   (GAPC_LK_SEC_NONE)
+
+/* Delay before an echo that could not be allocated is retried, in 10 ms units */
+#define USER_LECB_RETRY_DELAY               (1)
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Registers the LE_PSM of the echo channel on a new connection.
+ * @param[in] conidx        Connection index
+ * @return void
+ ****************************************************************************************
+*/
+void user_lecb_connected(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Accepts the channel on USER_LECB_LE_PSM.
+ * @param[in] conidx        Connection index
+ * @param[in] le_psm        LE_PSM requested by the host
+ * @param[in] peer_mtu      MTU of the host
+ * @return L2CAP result
+ ****************************************************************************************
+*/
+uint16_t user_lecb_connect_req(uint8_t conidx, uint16_t le_psm, uint16_t peer_mtu);
+
+/**
+ ****************************************************************************************
+ * @brief Releases the SDUs waiting for their echo when the channel is closed.
+ * @param[in] conidx        Connection index
+ * @param[in] le_psm        LE_PSM of the channel
+ * @param[in] reason        Reason of the closing
+ * @return void
+ ****************************************************************************************
+*/
+void user_lecb_disconnected(uint8_t conidx, uint16_t le_psm, uint16_t reason);
+
+/**
+ ****************************************************************************************
+ * @brief Queues a received SDU for its echo.
+ * @param[in] conidx        Connection index
+ * @param[in] sdu           SDU data
+ * @param[in] len           SDU length
+ * @return void
+ ****************************************************************************************
+*/
+void user_lecb_sdu_received(uint8_t conidx, const uint8_t *sdu, uint16_t len);
+
+/**
+ ****************************************************************************************
+ * @brief Sends the next echoes once an SDU has been sent.
+ * @param[in] conidx        Connection index
+ * @param[in] status        Status of the SDU
+ * @return void
+ ****************************************************************************************
+*/
+void user_lecb_sdu_sent(uint8_t conidx, uint8_t status);
+
+#endif // CFG_APP_LECB
+
+/// @} APP
+
+#endif // _USER_LECB_H_
@@ -48,6 +48,17 @@
 #include "custs1_task.h"
 #include "co_bt.h"
 #include "app_easy_security.h"
+#include "user_conn_ctrl.h"
+#include "user_uart_wakeup.h"
+#include "user_trace.h"
+#include "user_key_matrix.h"
+#include "user_encoder.h"
+#include "user_heap_mon.h"
+#include "user_stream.h"
+#include "user_audio.h"
+#include "user_lecb.h"
+#include "user_kbd.h"
+#include "app_time.h"
 
 #if BLE_HID_DEVICE
 
@@ -68,9 +79,6 @@
  * GLOBAL VARIABLE DEFINITIONS
  ****************************************************************************************
  */
-timer_hnd app_param_update_request_timer_used   __SECTION_ZERO("retention_mem_area0");
-
-
 uint8_t app_connection_idx                      __SECTION_ZERO("retention_mem_area0");
 
 
@@ -80,54 +88,91 @@ uint8_t app_connection_idx                      __SECTION_ZERO("retention_mem_ar
 */
 
 
-/**
- ****************************************************************************************
- * @brief Parameter update request timer callback function.
- * @return void
- ****************************************************************************************
-*/
-static void param_update_request_timer_cb()
-{
-    app_easy_gap_param_update_start(app_connection_idx);
-    app_param_update_request_timer_used = EASY_TIMER_INVALID_TIMER;
-}
-
 void user_app_init(void)
 {
+    user_trace_boot_mark(USER_TRACE_BOOT_INIT);
     default_app_on_init();
 		user_gamepad_init();
+#if defined (CFG_APP_KEY_MATRIX)
+    user_key_matrix_init();
+#endif
+#if defined (CFG_APP_ENCODER)
+    user_encoder_init();
+#endif
+#if defined (CFG_APP_TIME)
+    app_time_init();
+#endif
 }
 
 void user_app_on_db_init_complete(void){
+	user_trace_boot_mark(USER_TRACE_BOOT_DB);
 #if (CFG_USE_JOYSTICKS)
 	user_gamepad_toggle_axis_polling(true);
 #endif
 	default_app_on_db_init_complete();
 }
 
+arch_main_loop_callback_ret_t user_app_on_ble_powered(void)
+{
+    // Between two BLE events, release the keystrokes of the next connection event
+    user_kbd_on_ble_powered();
+    // A frame that woke the system is timed from now on
+    user_trace_on_ble_powered();
+
+    return user_heap_mon_on_ble_powered();
+}
+
 void user_app_adv_start(void)
 {
+    user_trace_boot_mark(USER_TRACE_BOOT_ADV);
     app_easy_gap_undirected_advertise_start();
 }
 
+/**
+ ****************************************************************************************
+ * @brief Counts the connected hosts.
+ * @return Number of active connections
+ ****************************************************************************************
+ */
+static uint8_t user_app_nb_connections(void)
+{
+    uint8_t nb = 0;
+    uint8_t i;
+
+    for (i = 0; i < APP_EASY_MAX_ACTIVE_CONNECTION; i++)
+    {
+        if (app_env[i].connection_active)
+        {
+            nb++;
+        }
+    }
+
+    return nb;
+}
+
 void user_app_connection(uint8_t connection_idx, struct gapc_connection_req_ind const *param)
 {
     if (app_env[connection_idx].conidx != GAP_INVALID_CONIDX)
     {
-        app_connection_idx = connection_idx;
-
-        // Check if the parameters of the established connection are the preferred ones.
-        // If not then schedule a connection parameter update request.
-        if ((param->con_interval < user_connection_param_conf.intv_min) ||
-            (param->con_interval > user_connection_param_conf.intv_max) ||
-            (param->con_latency != user_connection_param_conf.latency) ||
-            (param->sup_to != user_connection_param_conf.time_out))
+        // The connection parameters of the first host follow the UART/HID traffic from now on
+        if (user_app_nb_connections() == 1)
         {
-            // Connection params are not these that we expect
-            app_param_update_request_timer_used = app_easy_timer(APP_PARAM_UPDATE_REQUEST_TO, param_update_request_timer_cb);
+            app_connection_idx = connection_idx;
+            user_conn_ctrl_start(connection_idx, param);
         }
 				GPIO_SetActive(BT_STATE_PORT, BT_STATE_PIN);
+				user_uart_wakeup_keep_awake();
 				uart_send(UART2,(uint8_t*)"ble_ready!",10,UART_OP_INTR);
+#if defined (CFG_CUSTS1_STREAM)
+        user_stream_connected(connection_idx, param->con_interval);
+#endif
+        user_kbd_connected(connection_idx, param->con_interval);
+#if defined (CFG_APP_AUDIO)
+        user_audio_connected(connection_idx);
+#endif
+#if defined (CFG_APP_LECB)
+        user_lecb_connected(connection_idx);
+#endif
     }
     else
     {
@@ -136,6 +181,13 @@ void user_app_connection(uint8_t connection_idx, struct gapc_connection_req_ind
     }
 		
     default_app_on_connection(connection_idx, param);
+
+    // Keep advertising for a further host
+    if ((app_env[connection_idx].conidx != GAP_INVALID_CONIDX) &&
+        (user_app_nb_connections() < APP_EASY_MAX_ACTIVE_CONNECTION))
+    {
+        user_app_adv_start();
+    }
 }
 
 void user_app_adv_undirect_complete(uint8_t status)
@@ -149,15 +201,41 @@ void user_app_adv_undirect_complete(uint8_t status)
 
 void user_app_disconnect(struct gapc_disconnect_ind const *param)
 {
-    // Cancel the parameter update request timer
-    if (app_param_update_request_timer_used != EASY_TIMER_INVALID_TIMER)
+    uint8_t nb = user_app_nb_connections();
+#if defined (CFG_CUSTS1_STREAM) || defined (CFG_APP_AUDIO)
+    uint8_t i;
+
+    // The link is already marked down, drop the bytes buffered for it
+    for (i = 0; i < APP_EASY_MAX_ACTIVE_CONNECTION; i++)
+    {
+        if (!app_env[i].connection_active)
+        {
+#if defined (CFG_CUSTS1_STREAM)
+            user_stream_disconnected(i);
+#endif
+#if defined (CFG_APP_AUDIO)
+            user_audio_disconnected(i);
+#endif
+        }
+    }
+#endif
+
+    // Stop the connection parameter controller if its host is gone
+    if (!app_env[app_connection_idx].connection_active)
+    {
+        user_conn_ctrl_stop();
+    }
+
+    if (nb == 0)
+    {
+        GPIO_SetInactive(BT_STATE_PORT, BT_STATE_PIN);
+    }
+
+    // Restart Advertising, unless it still runs for a further host
+    if (nb == APP_EASY_MAX_ACTIVE_CONNECTION - 1)
     {
-        app_easy_timer_cancel(app_param_update_request_timer_used);
-        app_param_update_request_timer_used = EASY_TIMER_INVALID_TIMER;
+        user_app_adv_start();
     }
-    // Restart Advertising
-		GPIO_SetInactive(BT_STATE_PORT, BT_STATE_PIN);
-    user_app_adv_start();
 }
 
 void user_custs1_server_rx_ind_handler(ke_msg_id_t const msgid,
@@ -174,6 +252,11 @@ void user_custs1_server_tx_cfg_ind_handler(ke_msg_id_t const msgid,
                                             ke_task_id_t const src_id)
 {
 	//CCC value already handled in cust1 task 
+#if defined (CFG_CUSTS1_STREAM)
+    uint16_t ccc = co_read16p(param->value);
+
+    user_stream_ntf_cfg(param->conidx, (ccc & PRF_CLI_START_NTF) != 0);
+#endif
 }
 
 void user_custs1_server_tx_ntf_cfm_handler(ke_msg_id_t const msgid,
@@ -184,6 +267,85 @@ void user_custs1_server_tx_ntf_cfm_handler(ke_msg_id_t const msgid,
 
 }
 
+void user_custs1_trace_stats_wr_ind_handler(ke_msg_id_t const msgid,
+                                            struct custs1_val_write_ind const *param,
+                                            ke_task_id_t const dest_id,
+                                            ke_task_id_t const src_id)
+{
+    user_trace_reset();
+}
+
+void user_custs1_heap_stats_wr_ind_handler(ke_msg_id_t const msgid,
+                                           struct custs1_val_write_ind const *param,
+                                           ke_task_id_t const dest_id,
+                                           ke_task_id_t const src_id)
+{
+    user_heap_mon_reset();
+}
+
+#if defined (CFG_CUSTS1_STREAM)
+void user_custs1_stream_stats_wr_ind_handler(ke_msg_id_t const msgid,
+                                             struct custs1_val_write_ind const *param,
+                                             ke_task_id_t const dest_id,
+                                             ke_task_id_t const src_id)
+{
+    user_stream_reset();
+}
+#endif
+
+#if defined (CFG_APP_AUDIO)
+void user_custs1_audio_cfg_ind_handler(ke_msg_id_t const msgid,
+                                       struct custs1_val_write_ind const *param,
+                                       ke_task_id_t const dest_id,
+                                       ke_task_id_t const src_id)
+{
+    uint16_t ccc = co_read16p(param->value);
+
+    user_audio_ntf_cfg(param->conidx, (ccc & PRF_CLI_START_NTF) != 0);
+}
+
+void user_custs1_audio_stats_wr_ind_handler(ke_msg_id_t const msgid,
+                                            struct custs1_val_write_ind const *param,
+                                            ke_task_id_t const dest_id,
+                                            ke_task_id_t const src_id)
+{
+    user_audio_reset();
+}
+#endif
+
+/**
+ ****************************************************************************************
+ * @brief Answers a read of a statistics characteristic.
+ * @param[in] param   Pointer to CUSTS1_VALUE_REQ_IND message
+ * @param[in] max_len Maximum length of the value
+ * @param[in] pack    Function serializing the value
+ * @return void
+ ****************************************************************************************
+ */
+static void user_custs1_stats_rsp(struct custs1_value_req_ind const *param,
+                                  uint16_t max_len,
+                                  uint16_t (*pack)(uint8_t *buf))
+{
+    struct custs1_value_req_rsp *rsp = KE_MSG_ALLOC_DYN(CUSTS1_VALUE_REQ_RSP,
+                                                        prf_get_task_from_id(TASK_ID_CUSTS1),
+                                                        TASK_APP,
+                                                        custs1_value_req_rsp,
+                                                        max_len);
+
+    if (rsp == NULL)
+    {
+        user_heap_mon_alloc_failed(USER_HEAP_MON_SITE_CUSTS1_RSP);
+        return;
+    }
+
+    rsp->conidx  = app_env[param->conidx].conidx;
+    rsp->att_idx = param->att_idx;
+    rsp->length  = pack(rsp->value);
+    rsp->status  = ATT_ERR_NO_ERROR;
+
+    ke_msg_send(rsp);
+}
+
 
 
 void user_catch_rest_hndl(ke_msg_id_t const msgid,
@@ -205,25 +367,130 @@ void user_catch_rest_hndl(ke_msg_id_t const msgid,
                     user_custs1_server_tx_cfg_ind_handler(msgid, msg_param, dest_id, src_id);
                     break;
 
+                case CUST1_IDX_TRACE_STATS_VAL:
+                    user_custs1_trace_stats_wr_ind_handler(msgid, msg_param, dest_id, src_id);
+                    break;
+
+                case CUST1_IDX_HEAP_STATS_VAL:
+                    user_custs1_heap_stats_wr_ind_handler(msgid, msg_param, dest_id, src_id);
+                    break;
+
+#if defined (CFG_CUSTS1_STREAM)
+                case CUST1_IDX_STREAM_STATS_VAL:
+                    user_custs1_stream_stats_wr_ind_handler(msgid, msg_param, dest_id, src_id);
+                    break;
+#endif
+
+#if defined (CFG_APP_AUDIO)
+                case CUST1_IDX_AUDIO_NTF_CFG:
+                    user_custs1_audio_cfg_ind_handler(msgid, msg_param, dest_id, src_id);
+                    break;
+
+                case CUST1_IDX_AUDIO_STATS_VAL:
+                    user_custs1_audio_stats_wr_ind_handler(msgid, msg_param, dest_id, src_id);
+                    break;
+#endif
+
                 default:
                     break;
             }
         } break;
 
+        case CUSTS1_VALUE_REQ_IND:
+        {
+            struct custs1_value_req_ind const *msg_param = (struct custs1_value_req_ind const *) param;
+
+            switch (msg_param->att_idx)
+            {
+#if (CFG_USER_TRACE)
+                case CUST1_IDX_TRACE_STATS_VAL:
+                    user_custs1_stats_rsp(msg_param, DEF_CUST1_TRACE_STATS_CHAR_LEN, user_trace_stats_pack);
+                    break;
+#endif
+
+                case CUST1_IDX_HEAP_STATS_VAL:
+                    user_custs1_stats_rsp(msg_param, DEF_CUST1_HEAP_STATS_CHAR_LEN, user_heap_mon_stats_pack);
+                    break;
+
+#if defined (CFG_CUSTS1_STREAM)
+                case CUST1_IDX_STREAM_STATS_VAL:
+                    user_custs1_stats_rsp(msg_param, DEF_CUST1_STREAM_STATS_CHAR_LEN, user_stream_stats_pack);
+                    break;
+#endif
+
+#if defined (CFG_APP_AUDIO)
+                case CUST1_IDX_AUDIO_STATS_VAL:
+                    user_custs1_stats_rsp(msg_param, DEF_CUST1_AUDIO_STATS_CHAR_LEN, user_audio_stats_pack);
+                    break;
+#endif
+
+                default:
+                {
+                    // Send Error message
+                    struct custs1_value_req_rsp *rsp = KE_MSG_ALLOC(CUSTS1_VALUE_REQ_RSP,
+                                                                    src_id,
+                                                                    dest_id,
+                                                                    custs1_value_req_rsp);
+
+                    // Provide the connection index.
+                    rsp->conidx  = app_env[msg_param->conidx].conidx;
+                    // Provide the attribute index.
+                    rsp->att_idx = msg_param->att_idx;
+                    // Force current length to zero.
+                    rsp->length = 0;
+                    // Set Error status
+                    rsp->status  = ATT_ERR_APP_ERROR;
+                    // Send message
+                    ke_msg_send(rsp);
+                } break;
+            }
+        } break;
+
         case GAPC_PARAM_UPDATED_IND:
         {
             // Cast the "param" pointer to the appropriate message structure
             struct gapc_param_updated_ind const *msg_param = (struct gapc_param_updated_ind const *)(param);
 
-            // Check if updated Conn Params filled to preferred ones
-            if ((msg_param->con_interval >= user_connection_param_conf.intv_min) &&
-                (msg_param->con_interval <= user_connection_param_conf.intv_max) &&
-                (msg_param->con_latency == user_connection_param_conf.latency) &&
-                (msg_param->sup_to == user_connection_param_conf.time_out))
+            // Track the parameters actually in use on the controlled link
+            if (KE_IDX_GET(src_id) == app_connection_idx)
             {
+                user_conn_ctrl_param_updated(msg_param);
             }
+#if defined (CFG_CUSTS1_STREAM)
+            user_stream_param_updated(KE_IDX_GET(src_id), msg_param->con_interval);
+#endif
+            user_kbd_param_updated(KE_IDX_GET(src_id), msg_param->con_interval);
         } break;
 
+#if defined (CFG_CUSTS1_STREAM) || defined (CFG_APP_AUDIO)
+        case GATTC_CMP_EVT:
+        {
+            struct gattc_cmp_evt const *msg_param = (struct gattc_cmp_evt const *)(param);
+
+#if defined (CFG_APP_AUDIO)
+            // Completion of a notification sent by user_audio.c
+            if ((msg_param->operation == GATTC_NOTIFY) && (msg_param->seq_num == USER_AUDIO_NTF_SEQ))
+            {
+                user_audio_ntf_cmp(KE_IDX_GET(src_id), msg_param->status);
+            }
+            else
+#endif
+#if defined (CFG_CUSTS1_STREAM)
+            // Completion of a notification sent by user_stream.c
+            if (msg_param->operation == GATTC_NOTIFY)
+            {
+                user_stream_ntf_cmp(KE_IDX_GET(src_id), msg_param->status);
+            }
+            else
+#endif
+            {
+#if BLE_HID_DEVICE
+                app_hid_gamepad_event_handler(msgid, param, dest_id, src_id);
+#endif // BLE_HID_DEVICE
+            }
+        } break;
+#endif
+
 
         default:
 					#if BLE_HID_DEVICE
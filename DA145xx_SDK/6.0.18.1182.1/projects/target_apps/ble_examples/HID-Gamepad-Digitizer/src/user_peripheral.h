@@ -54,6 +54,7 @@
 #include "app.h"                       // application definitions
 #include "co_error.h"                  // error code definitions
 #include "arch_wdg.h"
+#include "arch_api.h"
 
 #include "app_callback.h"
 #include "app_default_handlers.h"
@@ -64,9 +65,6 @@
  ****************************************************************************************
  */
 
-/* Duration of timer for connection parameter update request */
-#define APP_PARAM_UPDATE_REQUEST_TO         (1000)   // 1000*10ms = 10sec, The maximum allowed value is 41943sec (4194300 * 10ms)
-
 /* Advertising data update timer */
 #define APP_ADV_DATA_UPDATE_TO              (3000)   // 3000*10ms = 30sec, The maximum allowed value is 41943sec (4194300 * 10ms)
 
@@ -95,6 +93,14 @@
 */
 void user_app_init(void);
 
+/**
+ ****************************************************************************************
+ * @brief Main loop callback while the BLE core is powered.
+ * @return GOTO_SLEEP
+ ****************************************************************************************
+*/
+arch_main_loop_callback_ret_t user_app_on_ble_powered(void);
+
 /**
  ****************************************************************************************
  * @brief Advertising function.
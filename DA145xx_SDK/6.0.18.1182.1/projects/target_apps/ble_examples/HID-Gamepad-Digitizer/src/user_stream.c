@@ -0,0 +1,426 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_stream.c
+ *
+ * @brief Notification streaming over the custom service source code.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <string.h>
+#include "rwip_config.h"             // SW configuration
+#include "arch.h"
+#include "gattc.h"
+#include "gattc_task.h"
+#include "lld_evt.h"
+#include "co_math.h"
+#include "co_utils.h"
+#include "app.h"
+#include "app_easy_gap.h"
+#include "custom_common.h"
+#include "user_custs1_def.h"
+#include "user_heap_mon.h"
+#include "user_stream.h"
+
+#if defined (CFG_CUSTS1_STREAM)
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/* ATT notification header, opcode and handle */
+#define STREAM_ATT_HDR_LEN                  (3)
+
+/* L2CAP header, length and channel */
+#define STREAM_L2C_HDR_LEN                  (4)
+
+/* Link layer payload before the Data Length update */
+#define STREAM_DEF_TX_OCTETS                (27)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Stream of a connection
+struct stream_link
+{
+    /// Notifications enabled in the Server TX CCC
+    bool enabled;
+    /// Notifications handed to GATTC and not yet completed
+    uint8_t in_flight;
+    /// Link layer payload in use
+    uint16_t tx_octets;
+    /// Index of the oldest buffered byte
+    uint16_t head;
+    /// Number of buffered bytes
+    uint16_t count;
+    /// Buffered bytes
+    uint8_t buf[USER_STREAM_BUF_SIZE];
+};
+
+/// Statistics
+struct stream_stats
+{
+    /// Highest number of notifications in flight
+    uint8_t max_queued;
+    /// ATT MTU of the last notification
+    uint16_t mtu;
+    /// Link layer payload of the last connection
+    uint16_t tx_octets;
+    /// Connection interval of the last connection
+    uint16_t con_interval;
+    /// Bytes notified
+    uint32_t bytes;
+    /// Notifications sent
+    uint32_t ntf;
+    /// 625us slots during which bytes were pending
+    uint32_t active_slots;
+    /// Bytes that did not fit in the buffer or had no host to go to
+    uint32_t dropped;
+    /// Notifications of the largest payload the link allows
+    uint16_t full_ntf;
+    /// Notifications not sent, either not allocated or completed with an error
+    uint16_t ntf_errors;
+};
+
+/// Stream environment
+struct stream_env_tag
+{
+    /// Bytes are pending on a connection
+    bool active;
+    /// BLE time at which the bytes became pending
+    uint32_t active_since;
+    /// Statistics
+    struct stream_stats stats;
+    /// Streams of the connections
+    struct stream_link links[APP_EASY_MAX_ACTIVE_CONNECTION];
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static struct stream_env_tag stream_env                 __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Accumulates the time during which bytes are pending on any connection.
+ * @return void
+ ****************************************************************************************
+ */
+static void stream_activity_update(void)
+{
+    bool pending = false;
+    uint8_t i;
+
+    for (i = 0; i < APP_EASY_MAX_ACTIVE_CONNECTION; i++)
+    {
+        if ((stream_env.links[i].count != 0) || (stream_env.links[i].in_flight != 0))
+        {
+            pending = true;
+            break;
+        }
+    }
+
+    if (pending && !stream_env.active)
+    {
+        stream_env.active_since = lld_evt_time_get();
+        stream_env.active = true;
+    }
+    else if (!pending && stream_env.active)
+    {
+        stream_env.stats.active_slots += (lld_evt_time_get() - stream_env.active_since) & BLE_BASETIMECNT_MASK;
+        stream_env.active = false;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Computes the payload of a full notification. The notification fills the ATT MTU,
+ *        or when the link layer fragments it, a whole number of link layer packets, so that
+ *        no packet of the connection event is sent half empty.
+ * @param[in] conidx Connection index
+ * @return Payload in bytes
+ ****************************************************************************************
+ */
+static uint16_t stream_payload_max(uint8_t conidx)
+{
+    uint16_t mtu = gattc_get_mtu(conidx);
+    uint16_t tx_octets = stream_env.links[conidx].tx_octets;
+    uint16_t pdu = co_min(mtu - STREAM_ATT_HDR_LEN, DEF_CUST1_SERVER_TX_CHAR_LEN) +
+                   STREAM_ATT_HDR_LEN + STREAM_L2C_HDR_LEN;
+
+    stream_env.stats.mtu = mtu;
+
+    if (pdu > tx_octets)
+    {
+        pdu -= pdu % tx_octets;
+    }
+
+    return pdu - STREAM_ATT_HDR_LEN - STREAM_L2C_HDR_LEN;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Hands the buffered bytes of a connection to GATTC, in full notifications, and in
+ *        a shorter one only when no notification is in flight.
+ * @param[in] conidx Connection index
+ * @return void
+ ****************************************************************************************
+ */
+static void stream_send(uint8_t conidx)
+{
+    struct stream_link *link = &stream_env.links[conidx];
+    uint16_t max_len;
+
+    if (!link->enabled)
+    {
+        return;
+    }
+
+    max_len = stream_payload_max(conidx);
+
+    while ((link->count != 0) && (link->in_flight < USER_STREAM_NTF_QUEUED))
+    {
+        uint16_t len = co_min(link->count, max_len);
+        uint16_t first;
+        struct gattc_send_evt_cmd *cmd;
+
+        // Leave the tail to the bytes still coming
+        if ((len < max_len) && (link->in_flight != 0))
+        {
+            break;
+        }
+
+        cmd = KE_MSG_ALLOC_DYN(GATTC_SEND_EVT_CMD,
+                               KE_BUILD_ID(TASK_GATTC, conidx),
+                               TASK_APP,
+                               gattc_send_evt_cmd,
+                               len);
+
+        if (cmd == NULL)
+        {
+            user_heap_mon_alloc_failed(USER_HEAP_MON_SITE_STREAM_NTF);
+            if (stream_env.stats.ntf_errors != 0xFFFF)
+            {
+                stream_env.stats.ntf_errors++;
+            }
+            break;
+        }
+
+        cmd->operation = GATTC_NOTIFY;
+        cmd->seq_num = 0;
+        cmd->handle = custs1_get_att_handle(CUST1_IDX_SERVER_TX_VAL);
+        cmd->length = len;
+
+        first = co_min(len, USER_STREAM_BUF_SIZE - link->head);
+        memcpy(cmd->value, &link->buf[link->head], first);
+        memcpy(&cmd->value[first], link->buf, len - first);
+
+        ke_msg_send(cmd);
+
+        link->head = (link->head + len) % USER_STREAM_BUF_SIZE;
+        link->count -= len;
+        link->in_flight++;
+
+        stream_env.stats.bytes += len;
+        stream_env.stats.ntf++;
+        if ((len == max_len) && (stream_env.stats.full_ntf != 0xFFFF))
+        {
+            stream_env.stats.full_ntf++;
+        }
+        if (link->in_flight > stream_env.stats.max_queued)
+        {
+            stream_env.stats.max_queued = link->in_flight;
+        }
+    }
+}
+
+void user_stream_connected(uint8_t conidx, uint16_t con_interval)
+{
+    struct gattc_exc_mtu_cmd *cmd = KE_MSG_ALLOC(GATTC_EXC_MTU_CMD,
+                                                 KE_BUILD_ID(TASK_GATTC, conidx),
+                                                 TASK_APP,
+                                                 gattc_exc_mtu_cmd);
+
+    user_stream_disconnected(conidx);
+    stream_env.links[conidx].tx_octets = STREAM_DEF_TX_OCTETS;
+    stream_env.stats.con_interval = con_interval;
+    stream_env.stats.tx_octets = STREAM_DEF_TX_OCTETS;
+
+    // The host may also start both procedures, the controller and GATTC keep the larger values
+    cmd->operation = GATTC_MTU_EXCH;
+    cmd->seq_num = 0;
+    ke_msg_send(cmd);
+
+    app_easy_gap_set_data_packet_length(conidx, USER_STREAM_TX_OCTETS, USER_STREAM_TX_TIME);
+}
+
+void user_stream_disconnected(uint8_t conidx)
+{
+    struct stream_link *link = &stream_env.links[conidx];
+
+    link->enabled = false;
+    link->in_flight = 0;
+    link->head = 0;
+    link->count = 0;
+
+    stream_activity_update();
+}
+
+void user_stream_param_updated(uint8_t conidx, uint16_t con_interval)
+{
+    stream_env.stats.con_interval = con_interval;
+}
+
+void user_stream_data_length_changed(const uint8_t conidx, struct gapc_le_pkt_size_ind *param)
+{
+    stream_env.links[conidx].tx_octets = param->max_tx_octets;
+    stream_env.stats.tx_octets = param->max_tx_octets;
+
+    // Bytes held back for a full notification may now fit in fewer packets
+    stream_send(conidx);
+}
+
+void user_stream_ntf_cfg(uint8_t conidx, bool enable)
+{
+    stream_env.links[conidx].enabled = enable;
+
+    if (enable)
+    {
+        stream_send(conidx);
+    }
+}
+
+void user_stream_ntf_cmp(uint8_t conidx, uint8_t status)
+{
+    struct stream_link *link = &stream_env.links[conidx];
+
+    if (link->in_flight != 0)
+    {
+        link->in_flight--;
+    }
+
+    if ((status != GAP_ERR_NO_ERROR) && (stream_env.stats.ntf_errors != 0xFFFF))
+    {
+        stream_env.stats.ntf_errors++;
+    }
+
+    stream_send(conidx);
+    stream_activity_update();
+}
+
+uint16_t user_stream_write(uint8_t conidx, const uint8_t *data, uint16_t len)
+{
+    struct stream_link *link;
+    uint16_t tail;
+    uint16_t first;
+
+    if ((conidx >= APP_EASY_MAX_ACTIVE_CONNECTION) || !stream_env.links[conidx].enabled)
+    {
+        stream_env.stats.dropped += len;
+        return 0;
+    }
+
+    link = &stream_env.links[conidx];
+
+    if (len > USER_STREAM_BUF_SIZE - link->count)
+    {
+        stream_env.stats.dropped += len - (USER_STREAM_BUF_SIZE - link->count);
+        len = USER_STREAM_BUF_SIZE - link->count;
+    }
+
+    tail = (link->head + link->count) % USER_STREAM_BUF_SIZE;
+    first = co_min(len, USER_STREAM_BUF_SIZE - tail);
+    memcpy(&link->buf[tail], data, first);
+    memcpy(link->buf, &data[first], len - first);
+    link->count += len;
+
+    stream_send(conidx);
+    stream_activity_update();
+
+    return len;
+}
+
+void user_stream_reset(void)
+{
+    memset(&stream_env.stats, 0, sizeof(stream_env.stats));
+
+    // Restart the active time from now if bytes are pending
+    stream_env.active = false;
+    stream_activity_update();
+}
+
+uint16_t user_stream_stats_pack(uint8_t *buf)
+{
+    uint8_t *p = buf;
+    uint32_t active_slots = stream_env.stats.active_slots;
+
+    // Include the time of the bytes still pending
+    if (stream_env.active)
+    {
+        active_slots += (lld_evt_time_get() - stream_env.active_since) & BLE_BASETIMECNT_MASK;
+    }
+
+    *p++ = USER_STREAM_STATS_VERSION;
+    *p++ = stream_env.stats.max_queued;
+    co_write16p(p, stream_env.stats.mtu);
+    co_write16p(p + 2, stream_env.stats.tx_octets);
+    co_write16p(p + 4, stream_env.stats.con_interval);
+    p += 6;
+    co_write32p(p, stream_env.stats.bytes);
+    co_write32p(p + 4, stream_env.stats.ntf);
+    co_write32p(p + 8, active_slots);
+    co_write32p(p + 12, stream_env.stats.dropped);
+    p += 16;
+    co_write16p(p, stream_env.stats.full_ntf);
+    co_write16p(p + 2, stream_env.stats.ntf_errors);
+    p += 4;
+
+    return (uint16_t)(p - buf);
+}
+
+#endif // CFG_CUSTS1_STREAM
+
+/// @} APP
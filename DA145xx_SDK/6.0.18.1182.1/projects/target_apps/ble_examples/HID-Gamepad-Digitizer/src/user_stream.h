@@ -0,0 +1,196 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_stream.h
+ *
+ * @brief Notification streaming over the custom service header file.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+#ifndef _USER_STREAM_H_
+#define _USER_STREAM_H_
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @ingroup RICOW
+ *
+ * @brief Streams bytes to a host through notifications of the Server TX characteristic.
+ *
+ * At connection time the ATT MTU exchange and the LE Data Length update are requested,
+ * so that a notification of up to MTU - 3 bytes goes out in a single link layer packet.
+ * The bytes written by the application are buffered per connection and sent in
+ * notifications of gattc_get_mtu() - 3 bytes, or of a whole number of link layer packets
+ * when the host does not take the Data Length update. Up to USER_STREAM_NTF_QUEUED
+ * notifications are handed to GATTC at a time, so several of them can go out in the
+ * same connection event. A notification shorter than the MTU allows is only sent when
+ * nothing is pending, the bytes written in the meantime fill the next one.
+ *
+ * The notifications are sent straight to GATTC for one connection, custs1 would send
+ * them one at a time to every subscribed host.
+ *
+ * The throughput counters are exported through the CUST1_IDX_STREAM_STATS_VAL
+ * characteristic, see user_stream_stats_pack() for the layout. Writing the
+ * characteristic clears them.
+ *
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gapc_task.h"
+
+#if defined (CFG_CUSTS1_STREAM)
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/* Bytes buffered per connection */
+#define USER_STREAM_BUF_SIZE                (512)
+
+/* Notifications handed to GATTC and not yet completed, per connection */
+#define USER_STREAM_NTF_QUEUED              (4)
+
+/* LE Data Length requested at connection time, see max_txoctets and max_txtime in
+ * user_config.h */
+#define USER_STREAM_TX_OCTETS               (251)
+#define USER_STREAM_TX_TIME                 (2120)
+
+/* Layout version of the exported statistics */
+#define USER_STREAM_STATS_VERSION           (1)
+
+/* Size of the exported statistics */
+#define USER_STREAM_STATS_LEN               (28)
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Requests the ATT MTU exchange and the LE Data Length update on a new connection.
+ * @param[in] conidx        Connection index
+ * @param[in] con_interval  Connection interval, 1.25ms units
+ * @return void
+ ****************************************************************************************
+*/
+void user_stream_connected(uint8_t conidx, uint16_t con_interval);
+
+/**
+ ****************************************************************************************
+ * @brief Drops the bytes buffered for a connection.
+ * @param[in] conidx        Connection index
+ * @return void
+ ****************************************************************************************
+*/
+void user_stream_disconnected(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Keeps track of the connection interval.
+ * @param[in] conidx        Connection index
+ * @param[in] con_interval  Connection interval, 1.25ms units
+ * @return void
+ ****************************************************************************************
+*/
+void user_stream_param_updated(uint8_t conidx, uint16_t con_interval);
+
+/**
+ ****************************************************************************************
+ * @brief Keeps track of the LE Data Length. To be registered as app_on_data_length_change
+ *        callback.
+ * @param[in] conidx    Connection index
+ * @param[in] param     Data Length in use
+ * @return void
+ ****************************************************************************************
+*/
+void user_stream_data_length_changed(const uint8_t conidx, struct gapc_le_pkt_size_ind *param);
+
+/**
+ ****************************************************************************************
+ * @brief Enables or disables the stream of a host, as set in the Server TX CCC.
+ * @param[in] conidx    Connection index
+ * @param[in] enable    True if notifications are enabled
+ * @return void
+ ****************************************************************************************
+*/
+void user_stream_ntf_cfg(uint8_t conidx, bool enable);
+
+/**
+ ****************************************************************************************
+ * @brief Handles the completion of a stream notification (GATTC_CMP_EVT).
+ * @param[in] conidx    Connection index
+ * @param[in] status    Status of the notification
+ * @return void
+ ****************************************************************************************
+*/
+void user_stream_ntf_cmp(uint8_t conidx, uint8_t status);
+
+/**
+ ****************************************************************************************
+ * @brief Queues bytes for a host.
+ * @param[in] conidx    Connection index
+ * @param[in] data      Bytes to send
+ * @param[in] len       Number of bytes
+ * @return Number of bytes queued, less than len if the buffer is full
+ ****************************************************************************************
+*/
+uint16_t user_stream_write(uint8_t conidx, const uint8_t *data, uint16_t len);
+
+/**
+ ****************************************************************************************
+ * @brief Clears the statistics.
+ * @return void
+ ****************************************************************************************
+*/
+void user_stream_reset(void);
+
+/**
+ ****************************************************************************************
+ * @brief Serializes the statistics, little endian:
+ *        u8 version, u8 max_queued, u16 mtu, u16 tx_octets, u16 con_interval,
+ *        u32 bytes, u32 notifications, u32 active_slots, u32 dropped_bytes,
+ *        u16 full_notifications, u16 ntf_errors.
+ *        mtu, tx_octets and con_interval are the values of the last connection,
+ *        active_slots counts the 625us slots during which bytes were pending.
+ * @param[out] buf Buffer of at least USER_STREAM_STATS_LEN bytes
+ * @return Number of bytes written
+ ****************************************************************************************
+*/
+uint16_t user_stream_stats_pack(uint8_t *buf);
+
+#endif // CFG_CUSTS1_STREAM
+
+/// @} APP
+
+#endif // _USER_STREAM_H_
@@ -0,0 +1,484 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_trace.c
+ *
+ * @brief UART to HID report latency tracing source code.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <string.h>
+#include "rwip_config.h"             // SW configuration
+#include "rwip.h"
+#include "lld_evt.h"
+#include "reg_blecore.h"
+#include "prf_types.h"
+#include "co_utils.h"
+#include "ll.h"
+#include "user_trace.h"
+
+#if (CFG_USER_TRACE)
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Slot value of a timestamp taken while the BLE core was asleep
+#define TRACE_TS_INVALID            (0xFFFFFFFF)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// BLE core timestamp
+struct trace_ts
+{
+    /// Base time counter, 625us slots
+    uint32_t slot;
+    /// Microseconds elapsed in the slot
+    uint16_t us;
+};
+
+/// Frame waiting for its HID reports to be acknowledged
+struct trace_frame
+{
+    /// First byte received
+    struct trace_ts rx_start;
+    /// HID report generation started
+    struct trace_ts dispatch;
+    /// Sequence number of the first HID report of the frame
+    uint16_t first_seq;
+    /// Sequence number following the last HID report of the frame
+    uint16_t end_seq;
+};
+
+/// Per stage statistics
+struct trace_stage_stats
+{
+    /// Longest latency in us
+    uint32_t max_us;
+    /// Latency histogram
+    uint16_t buckets[USER_TRACE_NB_BUCKETS];
+};
+
+/// Tracing environment
+struct trace_env_tag
+{
+    /// Frame reception timestamps, written from the UART interrupt
+    struct trace_ts rx_start;
+    struct trace_ts rx_end;
+    /// First byte received while the BLE core was asleep, rx_start not taken yet
+    bool rx_restart;
+    /// rx_start taken after the BLE core woke up
+    bool rx_woken;
+    /// Frames in flight, oldest first
+    struct trace_frame frames[USER_TRACE_MAX_FRAMES];
+    uint8_t frame_head;
+    uint8_t frame_cnt;
+    /// True between user_trace_frame_dispatch() and user_trace_frame_done()
+    bool frame_open;
+    /// Sequence number of the next HID report request
+    uint16_t req_seq;
+    /// Sequence number of the next HID report response
+    uint16_t rsp_seq;
+    /// Number of completed frames
+    uint32_t frames_done;
+    /// Error counters
+    uint16_t errors[USER_TRACE_ERR_NB];
+    /// Per stage statistics
+    struct trace_stage_stats stages[USER_TRACE_STAGE_NB];
+    /// Boot milestones
+    struct trace_ts boot[USER_TRACE_BOOT_NB];
+    /// Boot milestones already marked, one bit each
+    uint8_t boot_marked;
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static struct trace_env_tag trace_env                   __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Reads the BLE core timer.
+ * @param[out] ts Timestamp, invalid if the BLE core is asleep
+ * @return void
+ ****************************************************************************************
+ */
+static void trace_now(struct trace_ts *ts)
+{
+    uint32_t fine;
+
+    if ((GetBits16(CLK_RADIO_REG, BLE_ENABLE) == 0) ||
+        ble_deep_sleep_stat_getf() ||
+        (rwip_prevent_sleep_get() & RW_WAKE_UP_ONGOING))
+    {
+        ts->slot = TRACE_TS_INVALID;
+        return;
+    }
+
+    // Samples both the base and the fine time counter
+    ts->slot = lld_evt_time_get();
+    // The fine counter counts down the microseconds of the slot
+    fine = ble_finetimecnt_get() & BLE_FINECNT_MASK;
+    ts->us = (fine < 625) ? (624 - fine) : 0;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Computes the time between two timestamps.
+ * @param[in] from  Earlier timestamp
+ * @param[in] to    Later timestamp
+ * @return Time in us, TRACE_TS_INVALID if a timestamp was taken while the BLE core was
+ *         asleep
+ ****************************************************************************************
+ */
+static uint32_t trace_delta(struct trace_ts const *from, struct trace_ts const *to)
+{
+    uint32_t delta;
+
+    if ((from->slot == TRACE_TS_INVALID) || (to->slot == TRACE_TS_INVALID))
+    {
+        return TRACE_TS_INVALID;
+    }
+
+    delta = ((to->slot - from->slot) & BLE_BASETIMECNT_MASK) * 625 + to->us - from->us;
+
+    // Guard against a fine counter sampled right at the slot boundary
+    if ((int32_t)delta < 0)
+    {
+        delta = 0;
+    }
+
+    return delta;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Adds the latency between a past timestamp and now to a stage.
+ * @param[in] stage Stage
+ * @param[in] from  Timestamp taken at the start of the stage
+ * @param[in] to    Timestamp taken at the end of the stage
+ * @return void
+ ****************************************************************************************
+ */
+static void trace_record(enum user_trace_stage stage, struct trace_ts const *from, struct trace_ts const *to)
+{
+    struct trace_stage_stats *stats = &trace_env.stages[stage];
+    uint32_t delta = trace_delta(from, to);
+    uint8_t bucket = 0;
+
+    if (delta == TRACE_TS_INVALID)
+    {
+        return;
+    }
+
+    while ((bucket < (USER_TRACE_NB_BUCKETS - 1)) && (delta >= ((uint32_t)USER_TRACE_BUCKET0_US << bucket)))
+    {
+        bucket++;
+    }
+
+    if (stats->buckets[bucket] != 0xFFFF)
+    {
+        stats->buckets[bucket]++;
+    }
+
+    if (delta > stats->max_us)
+    {
+        stats->max_us = delta;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Increments an error counter.
+ * @param[in] err Error counter
+ * @return void
+ ****************************************************************************************
+ */
+static void trace_error(enum user_trace_err err)
+{
+    if (trace_env.errors[err] != 0xFFFF)
+    {
+        trace_env.errors[err]++;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Takes the start timestamp of a frame that arrived while the BLE core was asleep,
+ *        once it is awake.
+ * @return void
+ ****************************************************************************************
+ */
+static void trace_restart(void)
+{
+    struct trace_ts now;
+
+    if (!trace_env.rx_restart)
+    {
+        return;
+    }
+
+    trace_now(&now);
+    if (now.slot != TRACE_TS_INVALID)
+    {
+        trace_env.rx_start = now;
+        trace_env.rx_restart = false;
+        trace_env.rx_woken = true;
+    }
+}
+
+void user_trace_rx_start(void)
+{
+    trace_now(&trace_env.rx_start);
+    trace_env.rx_restart = (trace_env.rx_start.slot == TRACE_TS_INVALID);
+    trace_env.rx_woken = false;
+}
+
+void user_trace_rx_end(void)
+{
+    trace_restart();
+    trace_now(&trace_env.rx_end);
+
+    // The wake-up took part of the reception, the RX stage would only be its tail
+    if (!trace_env.rx_woken)
+    {
+        trace_record(USER_TRACE_STAGE_RX, &trace_env.rx_start, &trace_env.rx_end);
+    }
+}
+
+void user_trace_on_ble_powered(void)
+{
+    GLOBAL_INT_DISABLE();
+    trace_restart();
+    GLOBAL_INT_RESTORE();
+}
+
+void user_trace_frame_dispatch(void)
+{
+    struct trace_frame *frame;
+
+    trace_env.frame_open = false;
+
+    if (trace_env.frame_cnt == USER_TRACE_MAX_FRAMES)
+    {
+        trace_error(USER_TRACE_ERR_UNSYNCED);
+        return;
+    }
+
+    if (trace_env.rx_start.slot == TRACE_TS_INVALID)
+    {
+        // Still tracked so that its reports are told apart, just not timed end to end
+        trace_error(USER_TRACE_ERR_UNSYNCED);
+    }
+    else if (trace_env.rx_woken)
+    {
+        trace_error(USER_TRACE_ERR_WOKEN);
+    }
+
+    frame = &trace_env.frames[(trace_env.frame_head + trace_env.frame_cnt) % USER_TRACE_MAX_FRAMES];
+    frame->rx_start = trace_env.rx_start;
+    frame->first_seq = trace_env.req_seq;
+    trace_now(&frame->dispatch);
+    trace_record(USER_TRACE_STAGE_DISPATCH, &trace_env.rx_end, &frame->dispatch);
+
+    trace_env.frame_cnt++;
+    trace_env.frame_open = true;
+}
+
+void user_trace_frame_done(void)
+{
+    struct trace_frame *frame;
+
+    if (!trace_env.frame_open)
+    {
+        return;
+    }
+
+    trace_env.frame_open = false;
+
+    frame = &trace_env.frames[(trace_env.frame_head + trace_env.frame_cnt - 1) % USER_TRACE_MAX_FRAMES];
+    frame->end_seq = trace_env.req_seq;
+
+    // Nothing to wait for if no report could be queued
+    if (frame->end_seq == frame->first_seq)
+    {
+        trace_env.frame_cnt--;
+    }
+}
+
+void user_trace_report_queued(bool queued)
+{
+    if (!queued)
+    {
+        trace_error(USER_TRACE_ERR_QUEUE_FULL);
+        return;
+    }
+
+    trace_env.req_seq++;
+}
+
+void user_trace_report_rsp(uint8_t status)
+{
+    struct trace_frame *frame;
+    struct trace_ts now;
+    uint16_t seq = trace_env.rsp_seq++;
+
+    switch (status)
+    {
+        case GAP_ERR_NO_ERROR:
+            break;
+        case PRF_ERR_NTF_DISABLED:
+            trace_error(USER_TRACE_ERR_NTF_DISABLED);
+            break;
+        case PRF_ERR_REQ_DISALLOWED:
+            trace_error(USER_TRACE_ERR_REQ_DISALLOWED);
+            break;
+        default:
+            trace_error(USER_TRACE_ERR_OTHER);
+            break;
+    }
+
+    if (trace_env.frame_cnt == 0)
+    {
+        return;
+    }
+
+    // HOGPD answers the requests in order, the oldest frame owns this response unless
+    // the report was queued outside of a traced frame
+    frame = &trace_env.frames[trace_env.frame_head];
+    if ((int16_t)(seq - frame->first_seq) < 0)
+    {
+        return;
+    }
+
+    trace_now(&now);
+    trace_record(USER_TRACE_STAGE_REPORT, &frame->dispatch, &now);
+
+    if (trace_env.frame_open && (trace_env.frame_cnt == 1))
+    {
+        // Frame still being generated, its last report is not known yet
+        return;
+    }
+
+    if ((int16_t)(seq + 1 - frame->end_seq) >= 0)
+    {
+        trace_record(USER_TRACE_STAGE_FRAME, &frame->rx_start, &now);
+        trace_env.frames_done++;
+        trace_env.frame_head = (trace_env.frame_head + 1) % USER_TRACE_MAX_FRAMES;
+        trace_env.frame_cnt--;
+    }
+}
+
+void user_trace_boot_mark(enum user_trace_boot boot)
+{
+    if (trace_env.boot_marked & (1 << boot))
+    {
+        return;
+    }
+
+    trace_env.boot_marked |= (1 << boot);
+    trace_now(&trace_env.boot[boot]);
+}
+
+void user_trace_reset(void)
+{
+    trace_env.frames_done = 0;
+    memset(trace_env.errors, 0, sizeof(trace_env.errors));
+    memset(trace_env.stages, 0, sizeof(trace_env.stages));
+}
+
+uint16_t user_trace_stats_pack(uint8_t *buf)
+{
+    uint8_t *p = buf;
+    uint8_t i, j;
+
+    *p++ = USER_TRACE_STATS_VERSION;
+    *p++ = USER_TRACE_STAGE_NB;
+    *p++ = USER_TRACE_NB_BUCKETS;
+    *p++ = USER_TRACE_BUCKET0_US / 50;
+
+    for (i = 0; i < USER_TRACE_ERR_NB; i++)
+    {
+        co_write16p(p, trace_env.errors[i]);
+        p += 2;
+    }
+
+    co_write32p(p, trace_env.frames_done);
+    p += 4;
+
+    for (i = 0; i < USER_TRACE_STAGE_NB; i++)
+    {
+        co_write32p(p, trace_env.stages[i].max_us);
+        p += 4;
+
+        for (j = 0; j < USER_TRACE_NB_BUCKETS; j++)
+        {
+            co_write16p(p, trace_env.stages[i].buckets[j]);
+            p += 2;
+        }
+    }
+
+    // Not cleared by user_trace_reset(), the boot happens once
+    for (i = USER_TRACE_BOOT_INIT + 1; i < USER_TRACE_BOOT_NB; i++)
+    {
+        if ((trace_env.boot_marked & (1 << i)) && (trace_env.boot_marked & (1 << USER_TRACE_BOOT_INIT)))
+        {
+            co_write32p(p, trace_delta(&trace_env.boot[USER_TRACE_BOOT_INIT], &trace_env.boot[i]));
+        }
+        else
+        {
+            co_write32p(p, TRACE_TS_INVALID);
+        }
+        p += 4;
+    }
+
+    return (uint16_t)(p - buf);
+}
+
+#endif // CFG_USER_TRACE
+
+/// @} APP
@@ -0,0 +1,257 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_trace.h
+ *
+ * @brief UART to HID report latency tracing header file.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+#ifndef _USER_TRACE_H_
+#define _USER_TRACE_H_
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @ingroup RICOW
+ *
+ * @brief Timestamps a UART frame at each stage of its way to the HID host and keeps
+ *        per-stage latency histograms and error counters.
+ *
+ * Stages:
+ *  - RX:       first byte received to end of frame ('!')
+ *  - DISPATCH: end of frame to kbd_send_str()
+ *  - REPORT:   app_hogpd_send_report() to HOGPD_REPORT_UPD_RSP, for every report
+ *  - FRAME:    first byte received to HOGPD_REPORT_UPD_RSP of the last report
+ *
+ * The boot is timed once after reset, from user_app_init() to the end of the database
+ * initialization and to the first advertising request.
+ *
+ * Timestamps are taken from the BLE core timer (625us slots + 1us fine counter), which
+ * does not run while the BLE core sleeps. A frame whose first byte wakes the system is
+ * timed from the moment the BLE core is awake again and counted as woken, its RX stage
+ * is not recorded.
+ *
+ * The statistics are exported through the CUST1_IDX_TRACE_STATS_VAL characteristic,
+ * see user_trace_stats_pack() for the layout. Writing the characteristic clears them.
+ *
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/* Enable the latency probes */
+#define CFG_USER_TRACE                      (1)
+
+/* Layout version of the exported statistics */
+#define USER_TRACE_STATS_VERSION            (3)
+
+/* Number of histogram buckets. Bucket n counts latencies below 250us << n, the last
+ * bucket counts everything above */
+#define USER_TRACE_NB_BUCKETS               (10)
+#define USER_TRACE_BUCKET0_US               (250)
+
+/* Number of frames that can wait for their HID reports to be acknowledged */
+#define USER_TRACE_MAX_FRAMES               (4)
+
+/* Size of the exported statistics */
+#define USER_TRACE_STATS_LEN                (4 + 2 * USER_TRACE_ERR_NB + 4 + \
+                                             USER_TRACE_STAGE_NB * (4 + 2 * USER_TRACE_NB_BUCKETS) + \
+                                             4 * (USER_TRACE_BOOT_NB - 1))
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Traced stages
+enum user_trace_stage
+{
+    USER_TRACE_STAGE_RX = 0,
+    USER_TRACE_STAGE_DISPATCH,
+    USER_TRACE_STAGE_REPORT,
+    USER_TRACE_STAGE_FRAME,
+
+    USER_TRACE_STAGE_NB
+};
+
+/// Error counters
+enum user_trace_err
+{
+    /// HID report rejected, notifications disabled by the host
+    USER_TRACE_ERR_NTF_DISABLED = 0,
+    /// HID report rejected, request disallowed
+    USER_TRACE_ERR_REQ_DISALLOWED,
+    /// HID report not queued, no memory for the request
+    USER_TRACE_ERR_QUEUE_FULL,
+    /// HID report rejected with any other status
+    USER_TRACE_ERR_OTHER,
+    /// Frame not traced, frame table full or BLE core still asleep at its end
+    USER_TRACE_ERR_UNSYNCED,
+    /// Frame timed from the BLE core wake-up, its first byte woke the system
+    USER_TRACE_ERR_WOKEN,
+
+    USER_TRACE_ERR_NB
+};
+
+/// Boot milestones
+enum user_trace_boot
+{
+    /// user_app_init()
+    USER_TRACE_BOOT_INIT = 0,
+    /// All the profile databases added
+    USER_TRACE_BOOT_DB,
+    /// First advertising request
+    USER_TRACE_BOOT_ADV,
+
+    USER_TRACE_BOOT_NB
+};
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+#if (CFG_USER_TRACE)
+
+/**
+ ****************************************************************************************
+ * @brief Marks the reception of the first byte of a frame. Called from interrupt context.
+ * @return void
+ ****************************************************************************************
+*/
+void user_trace_rx_start(void);
+
+/**
+ ****************************************************************************************
+ * @brief Marks the reception of the end of a frame. Called from interrupt context.
+ * @return void
+ ****************************************************************************************
+*/
+void user_trace_rx_end(void);
+
+/**
+ ****************************************************************************************
+ * @brief Restarts the timing of a frame whose first byte arrived while the BLE core was
+ *        asleep. To be called from app_on_ble_powered.
+ * @return void
+ ****************************************************************************************
+*/
+void user_trace_on_ble_powered(void);
+
+/**
+ ****************************************************************************************
+ * @brief Marks the start of the HID report generation for the received frame.
+ * @return void
+ ****************************************************************************************
+*/
+void user_trace_frame_dispatch(void);
+
+/**
+ ****************************************************************************************
+ * @brief Marks the end of the HID report generation for the received frame.
+ * @return void
+ ****************************************************************************************
+*/
+void user_trace_frame_done(void);
+
+/**
+ ****************************************************************************************
+ * @brief Records the outcome of a HID report request.
+ * @param[in] queued True if the request has been sent to HOGPD
+ * @return void
+ ****************************************************************************************
+*/
+void user_trace_report_queued(bool queued);
+
+/**
+ ****************************************************************************************
+ * @brief Records the HOGPD_REPORT_UPD_RSP of a HID report.
+ * @param[in] status Status reported by HOGPD
+ * @return void
+ ****************************************************************************************
+*/
+void user_trace_report_rsp(uint8_t status);
+
+/**
+ ****************************************************************************************
+ * @brief Marks a boot milestone. Only the first mark after reset is kept.
+ * @param[in] boot Milestone
+ * @return void
+ ****************************************************************************************
+*/
+void user_trace_boot_mark(enum user_trace_boot boot);
+
+/**
+ ****************************************************************************************
+ * @brief Clears the statistics.
+ * @return void
+ ****************************************************************************************
+*/
+void user_trace_reset(void);
+
+/**
+ ****************************************************************************************
+ * @brief Serializes the statistics, little endian:
+ *        u8 version, u8 nb_stages, u8 nb_buckets, u8 bucket0 in 50us units,
+ *        u16 errors[USER_TRACE_ERR_NB], u32 frames,
+ *        per stage: u32 max_us, u16 buckets[USER_TRACE_NB_BUCKETS],
+ *        per boot milestone after USER_TRACE_BOOT_INIT: u32 us since user_app_init()
+ *        (0xFFFFFFFF if not reached or not timed).
+ * @param[out] buf Buffer of at least USER_TRACE_STATS_LEN bytes
+ * @return Number of bytes written
+ ****************************************************************************************
+*/
+uint16_t user_trace_stats_pack(uint8_t *buf);
+
+#else
+
+#define user_trace_rx_start()
+#define user_trace_rx_end()
+#define user_trace_on_ble_powered()
+#define user_trace_frame_dispatch()
+#define user_trace_frame_done()
+#define user_trace_report_queued(queued)
+#define user_trace_report_rsp(status)
+#define user_trace_boot_mark(boot)
+#define user_trace_reset()
+#define user_trace_stats_pack(buf)          (0)
+
+#endif // CFG_USER_TRACE
+
+/// @} APP
+
+#endif // _USER_TRACE_H_
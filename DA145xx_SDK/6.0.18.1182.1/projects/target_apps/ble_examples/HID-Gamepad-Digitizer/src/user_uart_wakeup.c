@@ -0,0 +1,196 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_uart_wakeup.c
+ *
+ * @brief Wake-on-UART handling for the UART2 to HID bridge source code.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "rwip_config.h"             // SW configuration
+#include "arch_api.h"
+#include "app_easy_timer.h"
+#include "app_easy_msg_utils.h"
+#include "wkupct_quadec.h"
+#include "user_periph_setup.h"
+#include "user_gamepad.h"
+#include "user_uart_wakeup.h"
+
+#if defined (CFG_UART2_WAKEUP)
+
+// The DA14585/586 have a single wakeup interrupt, whose callback and pins would be taken over
+#if !defined (__DA14531__) && (defined (CFG_APP_KEY_MATRIX) || defined (CFG_APP_ENCODER))
+#error "CFG_UART2_WAKEUP shares the wakeup interrupt with CFG_APP_KEY_MATRIX and CFG_APP_ENCODER"
+#endif
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// True while the system is forced to stay awake
+static bool uart_wakeup_active                  __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+/// Awake window timer
+static timer_hnd uart_wakeup_timer              __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Arms the wakeup controller on the falling edge of the wake-up pin.
+ * @return void
+ ****************************************************************************************
+ */
+static void uart_wakeup_arm(void)
+{
+    wkupct_enable_irq(WKUPCT_PIN_SELECT(UART2_WAKEUP_PORT, UART2_WAKEUP_PIN),
+                      WKUPCT_PIN_POLARITY(UART2_WAKEUP_PORT, UART2_WAKEUP_PIN, WKUPCT_PIN_POLARITY_LOW),
+                      1,
+                      UART2_WAKEUP_DEB_TIME);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Awake window timer callback. Lets the system sleep again once UART2 is idle.
+ * @return void
+ ****************************************************************************************
+ */
+static void uart_wakeup_timer_cb(void)
+{
+    if (user_gamepad_uart_busy())
+    {
+        // Frame still in progress, stay awake
+        uart_wakeup_timer = app_easy_timer(USER_UART_WAKEUP_BUSY_POLL, uart_wakeup_timer_cb);
+        return;
+    }
+
+    uart_wakeup_timer = EASY_TIMER_INVALID_TIMER;
+
+    if (uart_wakeup_active)
+    {
+        uart_wakeup_active = false;
+        arch_restore_sleep_mode();
+    }
+
+    uart_wakeup_arm();
+}
+
+/**
+ ****************************************************************************************
+ * @brief Called from the kernel once the BLE core is awake after a wake-up interrupt.
+ * @return void
+ ****************************************************************************************
+ */
+static void uart_wakeup_app_cb(void)
+{
+    user_uart_wakeup_keep_awake();
+}
+
+/**
+ ****************************************************************************************
+ * @brief Wakeup controller interrupt callback.
+ * @return void
+ ****************************************************************************************
+ */
+static void uart_wakeup_irq_cb(void)
+{
+#if !defined (__DA14531__)
+    if (GetBits16(SYS_STAT_REG, PER_IS_DOWN))
+    {
+        periph_init();
+    }
+#endif
+
+    // Receive the frame right away, the kernel is not running yet
+    user_gamepad_uart_rx_resume();
+
+    arch_ble_force_wakeup();
+    app_easy_wakeup();
+}
+
+void user_uart_wakeup_init(void)
+{
+    wkupct_register_callback(uart_wakeup_irq_cb);
+    app_easy_wakeup_set(uart_wakeup_app_cb);
+
+    uart_wakeup_arm();
+}
+
+void user_uart_wakeup_keep_awake(void)
+{
+    if (!uart_wakeup_active)
+    {
+        uart_wakeup_active = true;
+        arch_force_active_mode();
+    }
+
+    if (uart_wakeup_timer != EASY_TIMER_INVALID_TIMER)
+    {
+        uart_wakeup_timer = app_easy_timer_modify(uart_wakeup_timer, USER_UART_WAKEUP_WINDOW);
+    }
+    else
+    {
+        uart_wakeup_timer = app_easy_timer(USER_UART_WAKEUP_WINDOW, uart_wakeup_timer_cb);
+    }
+
+    // The polling timer is parked while the system may sleep
+    user_gamepad_polling_resume();
+}
+
+bool user_uart_wakeup_awake(void)
+{
+    return uart_wakeup_active;
+}
+
+void user_uart_wakeup_resume(void)
+{
+#if !defined (__DA14531__)
+    if (GetBits16(SYS_STAT_REG, PER_IS_DOWN))
+    {
+        periph_init();
+    }
+#endif
+
+    // periph_init() has re-initialized UART2, re-enable reception
+    user_gamepad_uart_rx_resume();
+}
+
+#endif // CFG_UART2_WAKEUP
+
+/// @} APP
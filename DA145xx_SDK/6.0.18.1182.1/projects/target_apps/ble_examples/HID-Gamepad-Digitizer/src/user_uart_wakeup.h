@@ -0,0 +1,121 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_uart_wakeup.h
+ *
+ * @brief Wake-on-UART handling for the UART2 to HID bridge header file.
+ *
+ * Copyright (c) 2015-2021 Renesas Electronics Corporation and/or its affiliates
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE
+ * OR OTHER DEALINGS IN THE SOFTWARE.
+ ****************************************************************************************
+ */
+
+#ifndef _USER_UART_WAKEUP_H_
+#define _USER_UART_WAKEUP_H_
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @ingroup RICOW
+ *
+ * @brief Lets the bridge run in extended sleep between UART2 frames.
+ *
+ * The wake-up pin (the UART2 RX pin by default) is armed on the wakeup controller while
+ * the system sleeps. The host either sends a UART2_WAKEUP_PREAMBLE byte and waits
+ * UART2_WAKEUP_HOST_DELAY_MS before the frame, or asserts a dedicated wake line. The
+ * system then stays awake until the frame has been received and forwarded and UART2
+ * has drained its transmitter.
+ *
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined (CFG_UART2_WAKEUP)
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/* Time the system stays awake after the last UART2 activity */
+#define USER_UART_WAKEUP_WINDOW             (10)     // 10*10ms = 100ms
+
+/* Polling period while a frame is still being received or transmitted */
+#define USER_UART_WAKEUP_BUSY_POLL          (2)      // 2*10ms = 20ms
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Registers the wake-up handlers and arms the wake-up pin.
+ * @return void
+ ****************************************************************************************
+*/
+void user_uart_wakeup_init(void);
+
+/**
+ ****************************************************************************************
+ * @brief Keeps the system awake for USER_UART_WAKEUP_WINDOW, e.g. while the application
+ *        transmits on UART2. Must not be called from interrupt context.
+ * @return void
+ ****************************************************************************************
+*/
+void user_uart_wakeup_keep_awake(void);
+
+/**
+ ****************************************************************************************
+ * @brief Tells whether the system is kept awake.
+ * @return true until USER_UART_WAKEUP_WINDOW has elapsed after the last UART2 activity
+ ****************************************************************************************
+*/
+bool user_uart_wakeup_awake(void);
+
+/**
+ ****************************************************************************************
+ * @brief Restores UART2 reception after the system has woken up. To be registered as
+ *        app_resume_from_sleep callback.
+ * @return void
+ ****************************************************************************************
+*/
+void user_uart_wakeup_resume(void);
+
+#else
+
+#define user_uart_wakeup_init()
+#define user_uart_wakeup_keep_awake()
+#define user_uart_wakeup_awake()            (true)
+
+#endif // CFG_UART2_WAKEUP
+
+/// @} APP
+
+#endif // _USER_UART_WAKEUP_H_
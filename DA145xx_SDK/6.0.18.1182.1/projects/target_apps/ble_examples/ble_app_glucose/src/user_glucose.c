@@ -0,0 +1,224 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_glucose.c
+ *
+ * @brief Glucose sensor demo project source code.
+ *
+ * A simulated measurement is stored in the GLPS record store every APP_GLUCOSE_MEAS_TO.
+ * The records are kept in the SPI flash and are reported to the collector through the
+ * Record Access Control Point.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "rwip_config.h"             // SW configuration
+#include "gap.h"
+#include "app_easy_timer.h"
+#include "user_glucose.h"
+#include "co_bt.h"
+#include "arch_console.h"
+#include "app_easy_security.h"
+#include "app_glps.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Seconds between two measurements
+#define APP_GLUCOSE_MEAS_PERIOD_S           (APP_GLUCOSE_MEAS_TO / 100)
+
+/// Glucose concentration in mg/dL: mantissa of an SFLOAT in kg/L with exponent -5
+#define APP_GLUCOSE_MG_DL(val)              ((prf_sfloat)((0xB << 12) | ((val) & 0x0FFF)))
+
+/*
+ * GLOBAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static uint8_t app_connection_idx                       __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+static timer_hnd app_param_update_request_timer_used    __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+static struct prf_date_time app_glucose_time            __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+static uint16_t app_glucose_level                       __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+*/
+
+/**
+ ****************************************************************************************
+ * @brief Advance a date by some seconds.
+ * @param[in,out] date  Date to advance
+ * @param[in] secs      Seconds to add, less than a day
+ ****************************************************************************************
+ */
+static void date_add_secs(struct prf_date_time *date, uint32_t secs)
+{
+    static const uint8_t month_days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    uint32_t day_secs = date->hour * 3600 + date->min * 60 + date->sec + secs;
+    uint8_t days = month_days[date->month - 1];
+
+    if ((date->month == 2) && ((date->year % 4) == 0) &&
+        (((date->year % 100) != 0) || ((date->year % 400) == 0)))
+    {
+        days++;
+    }
+
+    if (day_secs >= 86400)
+    {
+        day_secs -= 86400;
+        if (++date->day > days)
+        {
+            date->day = 1;
+            if (++date->month > 12)
+            {
+                date->month = 1;
+                date->year++;
+            }
+        }
+    }
+
+    date->hour = day_secs / 3600;
+    date->min = (day_secs / 60) % 60;
+    date->sec = day_secs % 60;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Store a simulated measurement and restart the measurement timer.
+ ****************************************************************************************
+ */
+static void glucose_meas_timer_cb(void)
+{
+    struct glp_meas meas;
+    uint16_t seq_num;
+
+    app_easy_timer(APP_GLUCOSE_MEAS_TO, glucose_meas_timer_cb);
+
+    date_add_secs(&app_glucose_time, APP_GLUCOSE_MEAS_PERIOD_S);
+
+    // Slow walk between 70 and 180 mg/dL
+    app_glucose_level = 70 + (app_glucose_level + 37) % 111;
+
+    meas.base_time = app_glucose_time;
+    meas.time_offset = 0;
+    meas.concentration = APP_GLUCOSE_MG_DL(app_glucose_level);
+    meas.status = 0;
+    meas.type = GLP_TYPE_CAPILLARY_WHOLE_BLOOD;
+    meas.location = GLP_LOC_FINGER;
+    meas.flags = GLP_MEAS_GL_CTR_TYPE_AND_SPL_LOC_PRES | GLP_MEAS_GL_CTR_UNITS_KG_L;
+
+    if (app_glps_store_add(&meas, NULL, &seq_num))
+    {
+        arch_printf("Record %u: %u mg/dL, %u stored\r\n", seq_num, app_glucose_level,
+                    app_glps_store_count());
+    }
+    else
+    {
+        arch_printf("Record not stored\r\n");
+    }
+}
+
+static void param_update_request_timer_cb()
+{
+    app_easy_gap_param_update_start(app_connection_idx);
+    app_param_update_request_timer_used = EASY_TIMER_INVALID_TIMER;
+}
+
+void user_app_init(void)
+{
+    app_param_update_request_timer_used = EASY_TIMER_INVALID_TIMER;
+
+    default_app_on_init();
+
+    app_easy_security_bdb_init();
+
+    // The sensor has no clock, the records are timed from a fixed date
+    app_glucose_time.year = 2020;
+    app_glucose_time.month = 1;
+    app_glucose_time.day = 1;
+    app_glucose_level = 100;
+
+    app_easy_timer(APP_GLUCOSE_MEAS_TO, glucose_meas_timer_cb);
+
+    arch_printf("Start advertising, %u records stored\r\n", app_glps_store_count());
+}
+
+void user_app_connection(uint8_t conidx, struct gapc_connection_req_ind const *param)
+{
+    if (app_env[conidx].conidx != GAP_INVALID_CONIDX)
+    {
+        app_connection_idx = conidx;
+
+        if (app_param_update_request_timer_used != EASY_TIMER_INVALID_TIMER)
+        {
+            app_easy_timer_cancel(app_param_update_request_timer_used);
+            app_param_update_request_timer_used = EASY_TIMER_INVALID_TIMER;
+        }
+        // Check if the parameters of the established connection are the preferred ones.
+        // If not then schedule a connection parameter update request.
+        if ((param->con_interval < user_connection_param_conf.intv_min) ||
+            (param->con_interval > user_connection_param_conf.intv_max) ||
+            (param->con_latency != user_connection_param_conf.latency) ||
+            (param->sup_to != user_connection_param_conf.time_out))
+        {
+            // Connection params are not these that we expect
+            app_param_update_request_timer_used = app_easy_timer(APP_PARAM_UPDATE_REQUEST_TO, param_update_request_timer_cb);
+        }
+
+        arch_printf("Device connected\r\n");
+    }
+
+    default_app_on_connection(conidx, param);
+}
+
+void user_app_disconnect(struct gapc_disconnect_ind const *param)
+{
+    // Cancel the parameter update request timer
+    if (app_param_update_request_timer_used != EASY_TIMER_INVALID_TIMER)
+    {
+        app_easy_timer_cancel(app_param_update_request_timer_used);
+        app_param_update_request_timer_used = EASY_TIMER_INVALID_TIMER;
+    }
+    arch_printf("Device disconnected\r\n");
+    default_app_on_disconnect(param);
+}
+
+void user_catch_rest_hndl(ke_msg_id_t const msgid,
+                          void const *param,
+                          ke_task_id_t const dest_id,
+                          ke_task_id_t const src_id)
+{
+    switch(msgid)
+    {
+        case GATTC_EVENT_REQ_IND:
+        { // Confirm unhandled indication to avoid GATT timeout
+            struct gattc_event_cfm * cfm = KE_MSG_ALLOC(GATTC_EVENT_CFM, src_id, dest_id, gattc_event_cfm);
+            cfm->handle = ((struct gattc_event_ind const *)param)->handle;
+            ke_msg_send(cfm);
+        } break;
+
+        default:
+            break;
+    }
+}
+
+/// @} APP
@@ -0,0 +1,95 @@
+/**
+ ****************************************************************************************
+ *
+ * @file user_glucose.h
+ *
+ * @brief Glucose sensor demo application header file.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _USER_GLUCOSE_H_
+#define _USER_GLUCOSE_H_
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @ingroup
+ *
+ * @brief
+ *
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "gapc_task.h"                 // gap functions and messages
+#include "app_task.h"                  // application task
+#include "app.h"                       // application definitions
+#include "app_callback.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/* Duration of timer for connection parameter update request */
+#define APP_PARAM_UPDATE_REQUEST_TO         (1000)   // 1000*10ms = 10sec, The maximum allowed value is 30000 = 300 sec
+
+/* Period of the simulated glucose measurements */
+#define APP_GLUCOSE_MEAS_TO                 (6000)   // 6000*10ms = 60sec
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Application initialization function.
+ ****************************************************************************************
+*/
+void user_app_init(void);
+
+/**
+ ****************************************************************************************
+ * @brief Connection function.
+ * @param[in] conidx        Connection Id index
+ * @param[in] param         Pointer to GAPC_CONNECTION_REQ_IND message
+ ****************************************************************************************
+*/
+void user_app_connection(const uint8_t conidx, struct gapc_connection_req_ind const *param);
+
+/**
+ ****************************************************************************************
+ * @brief Disconnection function.
+ * @param[in] param         Pointer to GAPC_DISCONNECT_IND message
+ ****************************************************************************************
+*/
+void user_app_disconnect(struct gapc_disconnect_ind const *param);
+
+/**
+ ****************************************************************************************
+ * @brief Handles the messages that are not handled by the SDK internal mechanisms.
+ * @param[in] msgid   Id of the message received.
+ * @param[in] param   Pointer to the parameters of the message.
+ * @param[in] dest_id ID of the receiving task instance.
+ * @param[in] src_id  ID of the sending task instance.
+ ****************************************************************************************
+*/
+void user_catch_rest_hndl(ke_msg_id_t const msgid,
+                          void const *param,
+                          ke_task_id_t const dest_id,
+                          ke_task_id_t const src_id);
+
+/// @} APP
+
+#endif //_USER_GLUCOSE_H_
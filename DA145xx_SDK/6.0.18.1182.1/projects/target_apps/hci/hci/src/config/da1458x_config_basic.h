@@ -88,6 +88,17 @@
 #undef CFG_SPI_DMA_SUPPORT
 #undef CFG_I2C_DMA_SUPPORT
 
+/****************************************************************************************************************/
+/* Batched transport over UART1. If CFG_UART_BATCHED_EIF is defined, GTL/H4TL data are received in a DMA        */
+/* ring buffer and outgoing packets are coalesced in DMA transfers, with RTS/CTS flow control. The UART1 SDK    */
+/* driver and the UART DMA support are then enabled. UART1_BAUDRATE may be set up to UART_BAUDRATE_1000000.     */
+/****************************************************************************************************************/
+#undef CFG_UART_BATCHED_EIF
+#if defined (CFG_UART_BATCHED_EIF)
+    #define CFG_UART1_SDK
+    #define CFG_UART_DMA_SUPPORT
+#endif
+
 
 
 #else
@@ -163,6 +174,17 @@
 #undef CFG_UART_DMA_SUPPORT
 #undef CFG_SPI_DMA_SUPPORT
 #undef CFG_I2C_DMA_SUPPORT
+
+/****************************************************************************************************************/
+/* Batched transport over UART1. If CFG_UART_BATCHED_EIF is defined, GTL/H4TL data are received in a DMA        */
+/* ring buffer and outgoing packets are coalesced in DMA transfers, with RTS/CTS flow control. The UART1 SDK    */
+/* driver and the UART DMA support are then enabled. UART1_BAUDRATE may be set up to UART_BAUDRATE_1000000.     */
+/****************************************************************************************************************/
+#undef CFG_UART_BATCHED_EIF
+#if defined (CFG_UART_BATCHED_EIF)
+    #define CFG_UART1_SDK
+    #define CFG_UART_DMA_SUPPORT
+#endif
 #undef CFG_ADC_DMA_SUPPORT
 
 /****************************************************************************************************************/
@@ -23,6 +23,9 @@
 #include "rwip_config.h"
 #include "gpio.h"
 #include "uart.h"
+#if defined (CFG_UART_BATCHED_EIF)
+#include "uart_eif.h"
+#endif
 #include "syscntl.h"
 #include "fpga_helper.h"
 
@@ -88,6 +91,23 @@ void set_pad_functions(void)
 #endif
 }
 
+#if defined (CFG_UART_BATCHED_EIF)
+// Configuration struct for UART1
+static const uart_cfg_t uart1_cfg = {
+    .baud_rate = UART1_BAUDRATE,
+    .data_bits = UART1_DATABITS,
+    .parity = UART1_PARITY,
+    .stop_bits = UART1_STOPBITS,
+    .auto_flow_control = UART1_AFCE,
+    .use_fifo = UART1_FIFO,
+    .tx_fifo_tr_lvl = UART1_TX_FIFO_LEVEL,
+    .rx_fifo_tr_lvl = UART1_RX_FIFO_LEVEL,
+    .intr_priority = 2,
+    .uart_dma_channel = UART_DMA_CHANNEL_01,
+    .uart_dma_priority = DMA_PRIO_0,
+};
+#endif
+
 #if defined (CFG_PRINTF_UART2)
 // Configuration struct for UART2
 static const uart_cfg_t uart_cfg = {
@@ -126,8 +146,13 @@ void periph_init(void)
     // ROM patch
     patch_func();
 
+#if defined (CFG_UART_BATCHED_EIF)
+    // Initialize UART1 batched transport
+    uart_eif_init(&uart1_cfg);
+#else
     // Initialize UART1 ROM driver
     uart_init(BAUD_RATE_DIV(UART1_BAUDRATE), BAUD_RATE_FRAC(UART1_BAUDRATE), UART1_DATABITS);
+#endif
 
 #if defined (CFG_PRINTF_UART2)
     // Initialize UART2
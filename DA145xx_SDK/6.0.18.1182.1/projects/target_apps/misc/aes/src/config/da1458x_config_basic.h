@@ -84,6 +84,13 @@
 #undef CFG_UART1_SDK
 
 
+/****************************************************************************************************************/
+/* AES job queue. If CFG_AES_QUEUE is defined, the blocks of the jobs queued by aes_queue_submit() are          */
+/* encrypted by the BLE core AES engine one after the other from the end of encryption interrupt.               */
+/****************************************************************************************************************/
+#undef CFG_AES_QUEUE
+
+
 /****************************************************************************************************************/
 /* Select external memory device for data storage                                                               */
 /* SPI FLASH  (#define CFG_SPI_FLASH_ENABLE)                                                                    */
@@ -168,6 +175,13 @@
 #undef CFG_UART1_SDK
 
 
+/****************************************************************************************************************/
+/* AES job queue. If CFG_AES_QUEUE is defined, the blocks of the jobs queued by aes_queue_submit() are          */
+/* encrypted by the BLE core AES engine one after the other from the end of encryption interrupt.               */
+/****************************************************************************************************************/
+#undef CFG_AES_QUEUE
+
+
 /****************************************************************************************************************/
 /* Select external memory device for data storage                                                               */
 /* SPI FLASH  (#define CFG_SPI_FLASH_ENABLE)                                                                    */
@@ -33,13 +33,21 @@
 #include "co_bt.h"
 #include "arch_console.h"
 #include "app_easy_security.h"
-#include "co_list.h"
 #include "gpio.h"
 
 #define ANCC_ATTS_MAX_LEN       (25)
 #define ANCC_ATTS_MSG_MAX_LEN   (75)
 #define APP_ANCC_DELAY          (1000)
 
+// Applications kept in the cache, the least recently used one is evicted when it is full
+#define ANCC_APP_CACHE_SIZE     (6)
+// Hash buckets of the application cache, power of 2
+#define ANCC_APP_HASH_SIZE      (8)
+// Longest application identifier kept, including the terminating NULL
+#define ANCC_APP_ID_MAX_LEN     (40)
+// Notifications waiting for their attributes, the oldest one is dropped when it is full
+#define ANCC_NTF_QUEUE_SIZE     (8)
+
 /*
  * TYPE DEFINITIONS
  ****************************************************************************************
@@ -54,23 +62,49 @@ enum
     APP_STATE_BROWSING_COMPLETE,
 };
 
+// ANCS application info
+struct application
+{
+    // Hash of app_id
+    uint32_t hash;
+    // Value of app_cache.use_cnt at the last use
+    uint16_t last_use;
+    // Next entry of the same hash bucket plus one, 0 for none
+    uint8_t next;
+    // True if the entry holds an application
+    bool used;
+    // True once the display name has been received
+    bool name_valid;
+    char app_id[ANCC_APP_ID_MAX_LEN];
+    char display_name[ANCC_ATTS_MAX_LEN + 1];
+};
+
+// Application cache, the identifiers are stored once and shared by the notifications
+struct app_cache
+{
+    struct application apps[ANCC_APP_CACHE_SIZE];
+    // First entry of each hash bucket plus one, 0 for none
+    uint8_t bucket[ANCC_APP_HASH_SIZE];
+    // Incremented at each use of an entry
+    uint16_t use_cnt;
+};
+
 // ANCS notification details info
 struct notification
 {
-    struct co_list_hdr hdr;
     struct anc_ntf_src ntf;
-    char title[ANCC_ATTS_MAX_LEN];
-    char date[ANCC_ATTS_MAX_LEN];
-    char message[ANCC_ATTS_MSG_MAX_LEN];
-    char *app_id;
+    char title[ANCC_ATTS_MAX_LEN + 1];
+    char date[ANCC_ATTS_MAX_LEN + 1];
+    char message[ANCC_ATTS_MSG_MAX_LEN + 1];
+    struct application *app;
 };
 
-// ANCS application info
-struct application
+// Notifications waiting for their attributes to be fetched, oldest first
+struct notif_queue
 {
-    struct co_list_hdr hdr;
-    char *app_id;
-    char *display_name;
+    struct anc_ntf_src ntf[ANCC_NTF_QUEUE_SIZE];
+    uint8_t head;
+    uint8_t cnt;
 };
 
 // Application service client data
@@ -91,8 +125,9 @@ static timer_hnd app_param_update_request_timer_used    __SECTION_ZERO("retentio
 static timer_hnd app_ancc_delay_timer                   __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 static uint8_t app_user_state                           __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 static uint32_t last_notif_uid                          __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
-static struct co_list notif_queue                       __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
-static struct co_list app_queue                         __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+static struct notif_queue notif_queue                   __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+static struct app_cache app_cache                       __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+static struct notification pending_notif_buf            __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 struct notification *pending_notif                      __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 struct svc_info gattc_svc                               __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 struct svc_info ancc_svc                                __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
@@ -147,14 +182,14 @@ static const char *notifcategory2str(uint8_t category)
  * @brief Print notification details
  *
  * @param[in] notif    notification data
- * @param[in] app      application data
  ****************************************************************************************
  */
-static void print_notification(const struct notification *notif, const struct application *app)
+static void print_notification(const struct notification *notif)
 {
-    const char *app_name = app ? app->display_name : "<unknown>";
+    const struct application *app = notif->app;
+    const char *app_name = (app && app->name_valid) ? app->display_name : "<unknown>";
 
-    arch_printf("Notification from %s (%s)\r\n", app_name, (app && notif->app_id) ? notif->app_id : "<unknown>");
+    arch_printf("Notification from %s (%s)\r\n", app_name, app ? app->app_id : "<unknown>");
     arch_printf("\tCategory: %s\r\n", notifcategory2str(notif->ntf.cat_id));
     arch_printf("\t    Date: %s\r\n", notif->date);
     arch_printf("\t   Title: %s\r\n", notif->title);
@@ -164,21 +199,44 @@ static void print_notification(const struct notification *notif, const struct ap
 
 /**
  ****************************************************************************************
- * @brief Free memory allocated for notification data
+ * @brief Copy an attribute value, truncated to the destination size
  *
- * @param[in] notif    notification data
+ * @param[out] dst     destination string
+ * @param[in] val      attribute value NULL terminated, NULL if not present
+ * @param[in] size     destination size
+ ****************************************************************************************
+ */
+static void copy_attribute(char *dst, const uint8_t *val, uint32_t size)
+{
+    dst[0] = '\0';
+    if (val)
+    {
+        strncpy(dst, (const char *)val, size - 1);
+        dst[size - 1] = '\0';
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Find a queued notification
+ *
+ * @param[in] uid      notification uid
+ * @return queue position from the oldest notification, notif_queue.cnt if not queued
  ****************************************************************************************
  */
-static void free_notification(struct notification *notif)
+static uint8_t find_queued_notification(uint32_t uid)
 {
-    if (notif)
+    uint8_t pos;
+
+    for (pos = 0; pos < notif_queue.cnt; pos++)
     {
-        if (notif->app_id)
+        if (notif_queue.ntf[(notif_queue.head + pos) % ANCC_NTF_QUEUE_SIZE].ntf_uid == uid)
         {
-            ke_free(notif->app_id);
+            break;
         }
-        ke_free(notif);
     }
+
+    return pos;
 }
 
 /**
@@ -188,44 +246,87 @@ static void free_notification(struct notification *notif)
  */
 static void clear_notification_queue()
 {
-    while (!co_list_is_empty(&notif_queue))
-    {
-        struct notification *notif = (struct notification *)co_list_pop_front(&notif_queue);
-        free_notification(notif);
-    }
+    notif_queue.head = 0;
+    notif_queue.cnt = 0;
 }
 
 /**
  ****************************************************************************************
- * @brief Store notification data if possible
+ * @brief Queue a notification for its attributes to be fetched. An event for a
+ *        notification that is already queued updates it, so that its attributes are
+ *        fetched once. If the queue is full the oldest notification is dropped.
  *
  * @param[in] ntf    notification data
  ****************************************************************************************
  */
 static void add_notification(const struct anc_ntf_src *ntf)
 {
-    if (ke_check_malloc(sizeof(struct notification), KE_MEM_ENV))
+    uint8_t pos = find_queued_notification(ntf->ntf_uid);
+
+    if (pos < notif_queue.cnt)
     {
-        struct notification *notif = (struct notification *)ke_malloc(sizeof(struct notification), KE_MEM_ENV);
-        memset(notif, 0, sizeof(struct notification));
-        notif->ntf = *ntf;
-        co_list_push_back(&notif_queue, (void *)notif);
+        struct anc_ntf_src *queued = &notif_queue.ntf[(notif_queue.head + pos) % ANCC_NTF_QUEUE_SIZE];
+        uint8_t event_id = queued->event_id;
+
+        *queued = *ntf;
+        queued->event_id = event_id;
+        return;
+    }
+
+    if (notif_queue.cnt == ANCC_NTF_QUEUE_SIZE)
+    {
+        notif_queue.head = (notif_queue.head + 1) % ANCC_NTF_QUEUE_SIZE;
+        notif_queue.cnt--;
     }
+
+    notif_queue.ntf[(notif_queue.head + notif_queue.cnt) % ANCC_NTF_QUEUE_SIZE] = *ntf;
+    notif_queue.cnt++;
 }
 
 /**
  ****************************************************************************************
- * @brief Fetch notification from list and get attributes
+ * @brief Remove a notification from the queue if it is there
+ *
+ * @param[in] uid    notification uid
+ ****************************************************************************************
+ */
+static void remove_notification(uint32_t uid)
+{
+    uint8_t pos = find_queued_notification(uid);
+
+    if (pos == notif_queue.cnt)
+    {
+        return;
+    }
+
+    for (; pos < (notif_queue.cnt - 1); pos++)
+    {
+        notif_queue.ntf[(notif_queue.head + pos) % ANCC_NTF_QUEUE_SIZE] =
+            notif_queue.ntf[(notif_queue.head + pos + 1) % ANCC_NTF_QUEUE_SIZE];
+    }
+
+    notif_queue.cnt--;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Fetch notification from queue and get attributes
  ****************************************************************************************
  */
 static void fetch_next_notification()
 {
-    pending_notif = (struct notification *)co_list_pop_front(&notif_queue);
-    if (!pending_notif)
+    if (notif_queue.cnt == 0)
     {
+        pending_notif = NULL;
         return;
     }
 
+    pending_notif = &pending_notif_buf;
+    memset(pending_notif, 0, sizeof(struct notification));
+    pending_notif->ntf = notif_queue.ntf[notif_queue.head];
+    notif_queue.head = (notif_queue.head + 1) % ANCC_NTF_QUEUE_SIZE;
+    notif_queue.cnt--;
+
     uint8_t atts = NTF_ATT_ID_APP_ID_PRESENT | NTF_ATT_ID_DATE_PRESENT |
                    NTF_ATT_ID_TITLE_PRESENT | NTF_ATT_ID_MSG_PRESENT;
 
@@ -241,7 +342,6 @@ void free_pending_notif(void)
 {
     if (pending_notif)
     {
-        free_notification(pending_notif);
         pending_notif = NULL;
         fetch_next_notification();
     }
@@ -249,58 +349,49 @@ void free_pending_notif(void)
 
 /**
  ****************************************************************************************
- * @brief Store application data if possible
+ * @brief Hash an application identifier (FNV-1a)
  *
- * @param[in] ntf    notification data
+ * @param[in] app_id    application identifier
+ * @return hash
  ****************************************************************************************
  */
-static struct application *add_application(const char *app_id)
+static uint32_t hash_app_id(const char *app_id)
 {
-    struct application *app = NULL;
-    uint32_t size = strlen(app_id);
+    uint32_t hash = 2166136261UL;
 
-    if (ke_check_malloc((size + 1), KE_MEM_ENV))
+    while (*app_id)
     {
-        app = ke_malloc(sizeof(struct application), KE_MEM_ENV);
-        memset(app, 0, sizeof(struct application));
-        app->app_id = ke_malloc(size + 1, KE_MEM_ENV);
-        memset(app->app_id, 0, size + 1);
-        strcpy(app->app_id, app_id);
-        co_list_push_back(&app_queue, (void*)app);
+        hash ^= (uint8_t)*app_id++;
+        hash *= 16777619UL;
     }
 
-    return app;
+    return hash;
 }
 
 /**
  ****************************************************************************************
- * @brief Store application data if possible
+ * @brief Find application data
  *
- * @param[in] ntf    notification data
+ * @param[in] app_id    application identifier
+ * @return application data, NULL if not cached
  ****************************************************************************************
  */
 static struct application *find_application(const char *app_id)
 {
-    if (!co_list_is_empty(&app_queue)) {
-        struct co_list_hdr *el = app_queue.first;
-        struct application *app = NULL;
+    uint32_t hash = hash_app_id(app_id);
+    uint8_t link = app_cache.bucket[hash & (ANCC_APP_HASH_SIZE - 1)];
 
-        while (true)
+    while (link)
+    {
+        struct application *app = &app_cache.apps[link - 1];
+
+        if ((app->hash == hash) && !strcmp(app->app_id, app_id))
         {
-            app = (struct application *)el;
-            if (!strcmp(app->app_id, app_id))
-            {
-                return (struct application*)el;
-            }
-            else if (el == app_queue.last)
-            {
-                return NULL;
-            }
-            else
-            {
-                el = co_list_next(el);
-            }
+            app->last_use = ++app_cache.use_cnt;
+            return app;
         }
+
+        link = app->next;
     }
 
     return NULL;
@@ -308,40 +399,112 @@ static struct application *find_application(const char *app_id)
 
 /**
  ****************************************************************************************
- * @brief Free memory allocated for application data
+ * @brief Remove application data from its hash bucket
  *
- * @param[in] notif    application data
+ * @param[in] app    application data
  ****************************************************************************************
  */
-static void free_application(struct application *app)
+static void unlink_application(struct application *app)
 {
-    if (!app)
+    uint8_t *link = &app_cache.bucket[app->hash & (ANCC_APP_HASH_SIZE - 1)];
+    uint8_t entry = (uint8_t)(app - app_cache.apps) + 1;
+
+    while (*link != entry)
     {
-        return;
+        link = &app_cache.apps[*link - 1].next;
     }
-    if (app->app_id)
+
+    *link = app->next;
+    app->used = false;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Store application data, evicting the least recently used application if the
+ *        cache is full. The application of the pending notification is never evicted.
+ *
+ * @param[in] app_id    application identifier
+ * @return application data, NULL if the identifier is too long
+ ****************************************************************************************
+ */
+static struct application *add_application(const char *app_id)
+{
+    struct application *app = NULL;
+    uint8_t bucket;
+    uint8_t i;
+
+    if (strlen(app_id) >= ANCC_APP_ID_MAX_LEN)
     {
-        ke_free(app->app_id);
+        return NULL;
     }
-    if(app->display_name)
+
+    for (i = 0; i < ANCC_APP_CACHE_SIZE; i++)
     {
-        ke_free(app->display_name);
+        struct application *entry = &app_cache.apps[i];
+
+        if (!entry->used)
+        {
+            app = entry;
+            break;
+        }
+
+        if (pending_notif && (pending_notif->app == entry))
+        {
+            continue;
+        }
+
+        if (!app || ((uint16_t)(app_cache.use_cnt - entry->last_use) > (uint16_t)(app_cache.use_cnt - app->last_use)))
+        {
+            app = entry;
+        }
     }
 
-    ke_free(app);
+    if (!app)
+    {
+        return NULL;
+    }
+
+    if (app->used)
+    {
+        unlink_application(app);
+    }
+
+    memset(app, 0, sizeof(struct application));
+    strcpy(app->app_id, app_id);
+    app->hash = hash_app_id(app_id);
+    app->used = true;
+    app->last_use = ++app_cache.use_cnt;
+
+    bucket = app->hash & (ANCC_APP_HASH_SIZE - 1);
+    app->next = app_cache.bucket[bucket];
+    app_cache.bucket[bucket] = (uint8_t)(app - app_cache.apps) + 1;
+
+    return app;
 }
 
 /**
  ****************************************************************************************
- * @brief Clear application queue
+ * @brief Find application data, store it if not cached
+ *
+ * @param[in] app_id    application identifier
+ * @return application data, NULL if it could not be stored
  ****************************************************************************************
  */
-void clear_application_queue()
+static struct application *intern_application(const char *app_id)
 {
-    while (!co_list_is_empty(&app_queue))
-    {
-        free_application((struct application *)co_list_pop_front(&app_queue));
-    }
+    struct application *app = find_application(app_id);
+
+    return app ? app : add_application(app_id);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Clear application cache
+ ****************************************************************************************
+ */
+void clear_application_cache()
+{
+    memset(&app_cache, 0, sizeof(app_cache));
 }
 
 /**
@@ -352,12 +515,8 @@ void clear_application_queue()
 void clear_ancs_data()
 {
     clear_notification_queue();
-    clear_application_queue();
-    if (pending_notif)
-    {
-        free_notification(pending_notif);
-        pending_notif = NULL;
-    }
+    pending_notif = NULL;
+    clear_application_cache();
 }
 
 /**
@@ -679,6 +838,13 @@ void user_on_ancc_ntf_src_ind_cb(uint8_t conidx, const struct anc_ntf_src *ntf)
         arch_printf("|\tcategory_count=%d\r\n", ntf->cat_cnt);
         arch_printf("\n");
 #endif
+        // Coalesced with the queued events of the same notification
+        add_notification(ntf);
+
+        if (!pending_notif)
+        {
+            fetch_next_notification();
+        }
     }
     else if (ntf->event_id == EVT_ID_NTF_REMOVED)
     {
@@ -686,12 +852,12 @@ void user_on_ancc_ntf_src_ind_cb(uint8_t conidx, const struct anc_ntf_src *ntf)
         arch_printf("| Notification removed (0x%08x)\r\n", ntf->ntf_uid);
         arch_printf("\n");
 #endif
+        remove_notification(ntf->ntf_uid);
     }
 }
 
 void user_on_ancc_ntf_att_ind_cb(uint8_t conidx, uint32_t uid, uint8_t att_id, uint8_t *val)
 {
-    uint32_t len = 0;
 #if CFG_VERBOSE_LOG
     arch_printf("| Notification (%08x) attribute (%d)\r\n", uid, att_id);
     arch_printf("|\t%s\r\n", val);
@@ -706,22 +872,16 @@ void user_on_ancc_ntf_att_ind_cb(uint8_t conidx, uint32_t uid, uint8_t att_id, u
     switch (att_id)
     {
         case NTF_ATT_ID_TITLE:
-            strcpy(pending_notif->title, (char *)val);
+            copy_attribute(pending_notif->title, val, sizeof(pending_notif->title));
         break;
         case NTF_ATT_ID_DATE:
-            strcpy(pending_notif->date, (char *)val);
+            copy_attribute(pending_notif->date, val, sizeof(pending_notif->date));
         break;
         case NTF_ATT_ID_MSG:
-            strcpy(pending_notif->message, (char *)val);
+            copy_attribute(pending_notif->message, val, sizeof(pending_notif->message));
         break;
         case NTF_ATT_ID_APP_ID:
-            len = strlen((char *)val) + 1;
-            if (ke_check_malloc(len, KE_MEM_ENV))
-            {
-                pending_notif->app_id = ke_malloc(len, KE_MEM_ENV);
-                memset(pending_notif->app_id, 0, len);
-                strcpy(pending_notif->app_id, (char *)val);
-            }
+            pending_notif->app = val ? intern_application((char *)val) : NULL;
         break;
         default:
         break;
@@ -731,7 +891,6 @@ void user_on_ancc_ntf_att_ind_cb(uint8_t conidx, uint32_t uid, uint8_t att_id, u
 void user_on_ancc_app_att_ind_cb(uint8_t conidx, uint8_t att_id, uint8_t *app_id, uint8_t *att)
 {
     struct application *app;
-    uint32_t size = 0;
 
 #if CFG_VERBOSE_LOG
     arch_printf("| Application (%s) attribute (%d)\r\n", app_id, att_id);
@@ -739,34 +898,17 @@ void user_on_ancc_app_att_ind_cb(uint8_t conidx, uint8_t att_id, uint8_t *app_id
     arch_printf("\n");
 #endif
 
-    app = (struct application*) find_application((char*)app_id);
-    if (!app)
-    {
-        app = add_application((char*)app_id);
-    }
+    app = intern_application((char*)app_id);
 
-    if (app != NULL)
+    if ((app != NULL) && (att_id == APP_ATT_ID_DISPLAY_NAME))
     {
-        if (att_id == APP_ATT_ID_DISPLAY_NAME)
-        {
-            if (!app->display_name)
-            {
-                size = strlen((char*)att) + 1;
-                if (ke_check_malloc(size, KE_MEM_ENV))
-                {
-                    app->display_name = ke_malloc(size, KE_MEM_ENV);
-                    memset(app->display_name, 0, size);
-                    strcpy(app->display_name, (char*)att);
-                }
-            }
-        }
+        copy_attribute(app->display_name, att, sizeof(app->display_name));
+        app->name_valid = true;
     }
 }
 
 void user_on_ancc_get_ntf_att_cmp_cb(uint8_t conidx, uint8_t status)
 {
-    struct application *app = NULL;
-
     if (!pending_notif)
     {
         return;
@@ -781,33 +923,27 @@ void user_on_ancc_get_ntf_att_cmp_cb(uint8_t conidx, uint8_t status)
         return;
     }
 
-    if (pending_notif->app_id)
+    if (pending_notif->app && !pending_notif->app->name_valid)
     {
-        app = (struct application *)find_application(pending_notif->app_id);
-        if (!app)
-        {
-            app_ancc_get_app_atts(conidx, APP_ATT_ID_DISPLAY_NAME_PRESENT, (uint8_t*)pending_notif->app_id);
-            return;
-        }
+        app_ancc_get_app_atts(conidx, APP_ATT_ID_DISPLAY_NAME_PRESENT, (uint8_t*)pending_notif->app->app_id);
+        return;
     }
 
-    print_notification(pending_notif, app);
+    print_notification(pending_notif);
     free_pending_notif();
 }
 
 void user_on_ancc_get_app_att_cmp_cb(uint8_t conidx, uint8_t status)
 {
-#if CFG_VERBOSE_LOG
-    if (status != ATT_ERR_NO_ERROR)
-    {
-        printf("| FAILED to get attributes for %s\r\n\n", pending_notif->app_id);
-    }
-#endif
-
     if (pending_notif)
     {
-        struct application *app = find_application(pending_notif->app_id);
-        print_notification(pending_notif, app);
+#if CFG_VERBOSE_LOG
+        if ((status != ATT_ERR_NO_ERROR) && pending_notif->app)
+        {
+            arch_printf("| FAILED to get attributes for %s\r\n\n", pending_notif->app->app_id);
+        }
+#endif
+        print_notification(pending_notif);
         free_pending_notif();
     }
 }
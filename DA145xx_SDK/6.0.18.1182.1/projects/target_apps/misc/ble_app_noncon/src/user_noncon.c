@@ -35,6 +35,57 @@
  ****************************************************************************************
  */
 
+/// Entry of the advertising payload rotation
+struct adv_rotation_entry
+{
+    /// AD structures appended to the initial advertising data
+    const uint8_t *adv_ad;
+    uint8_t adv_ad_len;
+    /// AD structures appended to the initial scan response data
+    const uint8_t *scan_rsp_ad;
+    uint8_t scan_rsp_ad_len;
+    /// Number of APP_ADV_DATA_UPDATE_TO periods the payload stays on air
+    uint8_t repeat;
+};
+
+/// Complete advertising payload, ready to be put on air
+struct adv_payload
+{
+    uint8_t adv_data[ADV_DATA_LEN];
+    uint8_t adv_data_len;
+    uint8_t scan_rsp_data[SCAN_RSP_DATA_LEN];
+    uint8_t scan_rsp_data_len;
+    uint8_t repeat;
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+// Manufacturer specific data, Dialog Semiconductor company identifier
+static const uint8_t adv_ad_manu[] = {0x05, GAP_AD_TYPE_MANU_SPECIFIC_DATA, 0xD2, 0x00, 0x01, 0x02};
+
+// Battery Service data, battery level
+static const uint8_t adv_ad_batt[] = {0x04, GAP_AD_TYPE_SERVICE_16_BIT_DATA, 0x0F, 0x18, 0x64};
+
+// Manufacturer specific data followed by Battery Service data
+static const uint8_t adv_ad_manu_batt[] = {0x05, GAP_AD_TYPE_MANU_SPECIFIC_DATA, 0xD2, 0x00, 0x01, 0x02,
+                                           0x04, GAP_AD_TYPE_SERVICE_16_BIT_DATA, 0x0F, 0x18, 0x64};
+
+// Payload rotation. The payloads are swapped on air with an advertising data update, at the
+// advertising interval of user_adv_conf. Keep them all with or all without scan response
+// data: a change of advertising type (ADV_NONCONN_IND or ADV_SCAN_IND) restarts advertising,
+// which loses the advertising events until the restart completes.
+static const struct adv_rotation_entry adv_rotation[] =
+{
+    {adv_ad_manu,      sizeof(adv_ad_manu),      NULL, 0, 3},
+    {adv_ad_batt,      sizeof(adv_ad_batt),      NULL, 0, 1},
+    {adv_ad_manu_batt, sizeof(adv_ad_manu_batt), NULL, 0, 2},
+};
+
+#define ADV_ROTATION_LEN    (sizeof(adv_rotation) / sizeof(adv_rotation[0]))
+
 /*
  * GLOBAL VARIABLE DEFINITIONS
  ****************************************************************************************
@@ -45,22 +96,14 @@ timer_hnd app_adv_data_update_timer_used            __SECTION_ZERO("retention_me
 uint8_t initial_adv_data[ADV_DATA_LEN]              __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 uint8_t initial_adv_data_len                        __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 
-uint8_t user_adv_data[ADV_DATA_LEN]                 __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
-uint8_t user_adv_data_len                           __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
-
 uint8_t initial_scan_rsp_data[SCAN_RSP_DATA_LEN]    __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 uint8_t initial_scan_rsp_data_len                   __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 
-uint8_t user_scan_rsp_data[SCAN_RSP_DATA_LEN]       __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
-uint8_t user_scan_rsp_data_len                      __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
-
-uint8_t added_adv_data_len                          __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
-uint8_t added_scan_rsp_data_len                     __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
-
-uint8_t adv_data_cursor                             __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
-uint8_t scan_rsp_data_cursor                        __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
-
-bool update_adv_data                                __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+// Payload on air and next payload of the rotation
+struct adv_payload adv_payloads[2]                  __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+uint8_t adv_payload_active                          __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+uint8_t adv_rotation_idx                            __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+uint8_t adv_repeat_left                             __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 
 /*
  * FUNCTION DEFINITIONS
@@ -69,72 +112,84 @@ bool update_adv_data                                __SECTION_ZERO("retention_me
 
 /**
  ****************************************************************************************
- * @brief Initialize data values kept in global variables.
+ * @brief Append AD structures to advertising or scan response data if there is space.
+ * @param[in,out] data     Advertising or scan response data
+ * @param[in,out] len      Length of data
+ * @param[in] max_len      Maximum length of data
+ * @param[in] ad           AD structures
+ * @param[in] ad_len       Length of the AD structures
  ****************************************************************************************
  */
-static void data_init()
+static void append_ad(uint8_t *data, uint8_t *len, uint8_t max_len, const uint8_t *ad, uint8_t ad_len)
 {
-    // Load initial advertising data and length
-    user_adv_data_len = initial_adv_data_len;
-    memcpy(user_adv_data, initial_adv_data, user_adv_data_len);
+    if ((*len + ad_len) <= max_len)
+    {
+        memcpy(&data[*len], ad, ad_len);
+        *len += ad_len;
+    }
+}
 
-    // Load initial scan response data and length
-    user_scan_rsp_data_len = initial_scan_rsp_data_len;
-    memcpy(user_scan_rsp_data, initial_scan_rsp_data, user_scan_rsp_data_len);
+/**
+ ****************************************************************************************
+ * @brief Build the next payload of the rotation in the buffer that is not on air.
+ ****************************************************************************************
+ */
+static void adv_payload_prepare_next(void)
+{
+    const struct adv_rotation_entry *entry = &adv_rotation[adv_rotation_idx];
+    struct adv_payload *payload = &adv_payloads[adv_payload_active ^ 1];
+
+    memcpy(payload->adv_data, initial_adv_data, initial_adv_data_len);
+    payload->adv_data_len = initial_adv_data_len;
+    append_ad(payload->adv_data, &payload->adv_data_len, ADV_DATA_LEN, entry->adv_ad, entry->adv_ad_len);
 
-    added_adv_data_len = 0;
-    added_scan_rsp_data_len = 0;
+    memcpy(payload->scan_rsp_data, initial_scan_rsp_data, initial_scan_rsp_data_len);
+    payload->scan_rsp_data_len = initial_scan_rsp_data_len;
+    append_ad(payload->scan_rsp_data, &payload->scan_rsp_data_len, SCAN_RSP_DATA_LEN, entry->scan_rsp_ad, entry->scan_rsp_ad_len);
 
-    adv_data_cursor = initial_adv_data_len;
-    scan_rsp_data_cursor = initial_scan_rsp_data_len;
+    payload->repeat = entry->repeat ? entry->repeat : 1;
 
-    update_adv_data = true;
+    adv_rotation_idx = (adv_rotation_idx + 1) % ADV_ROTATION_LEN;
 }
 
 /**
  ****************************************************************************************
- * @brief Adds a byte to ADV_DATA if there is space.
- * @return true if ADV_DATA is full, otherwise false
+ * @brief Make the prepared payload the active one and prepare the following one.
+ * @return The payload to be put on air
  ****************************************************************************************
  */
-static bool is_adv_data_full(void)
+static struct adv_payload *adv_payload_swap(void)
 {
-    if ((user_adv_data_len < ADV_DATA_LEN) && update_adv_data)
-    {
-        added_adv_data_len++;
-        adv_data_cursor++;
+    struct adv_payload *payload;
 
-        user_adv_data[initial_adv_data_len] = added_adv_data_len;
+    adv_payload_active ^= 1;
+    payload = &adv_payloads[adv_payload_active];
+    adv_repeat_left = payload->repeat;
 
-        user_adv_data[adv_data_cursor] = 0xA5;
-        user_adv_data_len = initial_adv_data_len + added_adv_data_len + 1;
+    adv_payload_prepare_next();
 
-        return false;
-    }
-    return true;
+    return payload;
 }
 
 /**
  ****************************************************************************************
- * @brief Adds a byte to SCAN_RSP_DATA if there is space.
- * @return true if SCAN_RSP_DATA is full, otherwise false
+ * @brief Load the active payload in the advertising start command and start advertising.
  ****************************************************************************************
  */
-static bool is_scan_rsp_data_full(void)
+static void adv_payload_start(void)
 {
-    if ((user_scan_rsp_data_len < SCAN_RSP_DATA_LEN) && !update_adv_data)
-    {
-        added_scan_rsp_data_len++;
-        scan_rsp_data_cursor++;
+    struct gapm_start_advertise_cmd *cmd = app_easy_gap_non_connectable_advertise_get_active();
+    struct adv_payload *payload = &adv_payloads[adv_payload_active];
 
-        user_scan_rsp_data[initial_scan_rsp_data_len] = added_scan_rsp_data_len;
+    // Load advertising data and length
+    cmd->info.host.adv_data_len = payload->adv_data_len;
+    memcpy(cmd->info.host.adv_data, payload->adv_data, payload->adv_data_len);
 
-        user_scan_rsp_data[scan_rsp_data_cursor] = 0xA5;
-        user_scan_rsp_data_len = initial_scan_rsp_data_len + added_scan_rsp_data_len + 1;
+    // Load scan response data and length
+    cmd->info.host.scan_rsp_data_len = payload->scan_rsp_data_len;
+    memcpy(cmd->info.host.scan_rsp_data, payload->scan_rsp_data, payload->scan_rsp_data_len);
 
-        return false;
-    }
-    return true;
+    app_easy_gap_non_connectable_advertise_start();
 }
 
 /**
@@ -144,49 +199,37 @@ static bool is_scan_rsp_data_full(void)
  */
 static void adv_data_update_timer_cb(void)
 {
+    const struct adv_payload *active = &adv_payloads[adv_payload_active];
+    const struct adv_payload *next = &adv_payloads[adv_payload_active ^ 1];
+
     app_adv_data_update_timer_used = EASY_TIMER_INVALID_TIMER;
 
-    if (is_adv_data_full() && update_adv_data)
+    if (--adv_repeat_left == 0)
     {
-        // Ready to switch to SCAN_RSP_DATA
-        update_adv_data = false;
-
-        // Since the ADV_DATA has reached its limit (31-bytes), we start to fill the SCAN_RSP_DATA
-        is_scan_rsp_data_full();
-
-        // Stop advertising when switching from ADV_NONCONN_IND to ADV_SCAN_IND type and vice versa
-        // On the fly update of the ADV_DATA or SCAN_RSP_DATA cannot be applied when the advertising type is dynamically changed.
-        app_easy_gap_advertise_stop();
-
-        // Exit here
-        return;
-    }
+        if ((next->scan_rsp_data_len == 0) != (active->scan_rsp_data_len == 0))
+        {
+            // The advertising type (ADV_NONCONN_IND or ADV_SCAN_IND) cannot be changed on the fly,
+            // advertising is restarted with the next payload when the stop completes.
+            adv_payload_swap();
+            app_easy_gap_advertise_stop();
 
-    if (is_scan_rsp_data_full() && !update_adv_data)
-    {
-        // Ready to switch to ADV_DATA
-        update_adv_data = true;
+            // Exit here
+            return;
+        }
 
-        // Stop advertising when switching from ADV_NONCONN_IND to ADV_SCAN_IND type and vice versa
-        // On the fly update of the ADV_DATA or SCAN_RSP_DATA cannot be applied when the advertising type is dynamically changed.
-        app_easy_gap_advertise_stop();
+        active = adv_payload_swap();
 
-        // Exit here
-        return;
+        // Update advertising data on the fly
+        app_easy_gap_update_adv_data(active->adv_data, active->adv_data_len,
+                                     active->scan_rsp_data, active->scan_rsp_data_len);
     }
 
-    // Update advertising data on the fly
-    app_easy_gap_update_adv_data(user_adv_data, user_adv_data_len, user_scan_rsp_data, user_scan_rsp_data_len);
-
     // Restart timer for the next advertising update
     app_adv_data_update_timer_used = app_easy_timer(APP_ADV_DATA_UPDATE_TO, adv_data_update_timer_cb);
 }
 
 void user_app_adv_start(void)
 {
-    // Schedule the next advertising data update
-    app_adv_data_update_timer_used = app_easy_timer(APP_ADV_DATA_UPDATE_TO, adv_data_update_timer_cb);
-
     struct gapm_start_advertise_cmd *cmd = app_easy_gap_non_connectable_advertise_get_active();
 
     // Store initial advertising data and length
@@ -197,35 +240,24 @@ void user_app_adv_start(void)
     initial_scan_rsp_data_len = cmd->info.host.scan_rsp_data_len;
     memcpy(initial_scan_rsp_data, cmd->info.host.scan_rsp_data, initial_scan_rsp_data_len);
 
-    // Initialize data
-    data_init();
+    // Prepare the first payload and make it active, which prepares the second one
+    adv_rotation_idx = 0;
+    adv_payload_active = 0;
+    adv_payload_prepare_next();
+    adv_payload_swap();
 
-    app_easy_gap_non_connectable_advertise_start();
+    adv_payload_start();
+
+    // Schedule the next advertising data update
+    app_adv_data_update_timer_used = app_easy_timer(APP_ADV_DATA_UPDATE_TO, adv_data_update_timer_cb);
 }
 
 void user_app_adv_nonconn_complete(uint8_t status)
 {
-    // If advertising was canceled then update advertising data and start advertising again
+    // If advertising was canceled then start advertising again with the active payload
     if (status == GAP_ERR_CANCELED)
     {
-        struct gapm_start_advertise_cmd *cmd = app_easy_gap_non_connectable_advertise_get_active();
-
-        // Initialize ADV_DATA and SCAN_RSP_DATA to restart the process
-        if (update_adv_data)
-        {
-            // Initialize data
-            data_init();
-        }
-
-        // Load advertising data and length
-        cmd->info.host.adv_data_len = user_adv_data_len;
-        memcpy(cmd->info.host.adv_data, user_adv_data, user_adv_data_len);
-
-        // Load scan response data and length
-        cmd->info.host.scan_rsp_data_len = user_scan_rsp_data_len;
-        memcpy(cmd->info.host.scan_rsp_data, user_scan_rsp_data, user_scan_rsp_data_len);
-
-        app_easy_gap_non_connectable_advertise_start();
+        adv_payload_start();
 
         // Schedule the next advertising data update
         app_adv_data_update_timer_used = app_easy_timer(APP_ADV_DATA_UPDATE_TO, adv_data_update_timer_cb);
@@ -101,6 +101,16 @@
 #include "app_wsss_task.h"
 #endif
 
+#if (BLE_GL_SENSOR)
+#include "app_glps.h"
+#include "app_glps_task.h"
+#endif
+
+#if (BLE_APP_LECB)
+#include "app_lecb.h"
+#include "app_lecb_task.h"
+#endif
+
 /*
  * DEFINES
  ****************************************************************************************
@@ -112,8 +122,11 @@
 /// Scan Response data maximal length
 #define APP_SCAN_RESP_DATA_MAX_SIZE         (SCAN_RSP_DATA_LEN)
 
-/// Max connections supported by application task
+/// Max connections supported by application task, may be raised by the application
+/// configuration together with __EXCLUDE_ROM_APP_TASK__
+#if !defined (APP_EASY_MAX_ACTIVE_CONNECTION)
 #define APP_EASY_MAX_ACTIVE_CONNECTION      (1)
+#endif
 
 /*
  * TYPE DEFINITIONS
@@ -0,0 +1,219 @@
+/**
+ ****************************************************************************************
+ * @addtogroup APP_Modules
+ * @{
+ * @addtogroup AUDIO
+ * @brief PDM Microphone Audio Streaming API
+ * @{
+ *
+ * @file app_audio.h
+ *
+ * @brief PDM microphone to IMA-ADPCM frames header.
+ *
+ * The PDM interface and the sample rate converter turn the microphone bit stream into
+ * APP_AUDIO_SRC_RATE samples per second. The SRC output interrupt narrows each sample to
+ * 16 bits and stores it in a ring of APP_AUDIO_BLOCKS blocks. When a block is full, a
+ * message wakes up the kernel, which halves the rate if APP_AUDIO_DECIMATION is 2 and
+ * encodes the block to IMA-ADPCM, 4 bits per sample, straight into the frame being
+ * filled. A block completed while all the others wait for the kernel is lost and counted
+ * as an overrun.
+ *
+ * A frame is a 4 byte header, little endian: i16 predictor, u8 step index, u8 sequence
+ * number, followed by the codes of 2 samples per byte, the first one in the low nibble.
+ * The header holds the codec state before the first sample, so that a receiver can
+ * decode any frame on its own and a lost frame only costs its own samples. The frame
+ * length is set by the application, usually to the ATT MTU - 3, and is applied at once:
+ * the frames not sent yet are dropped.
+ *
+ * The frames wait in a FIFO of APP_AUDIO_FIFO_SIZE bytes, which absorbs the jitter
+ * between the constant rate of the encoder and the connection events that take them.
+ * A frame completed while the FIFO is full is dropped, its sequence number is skipped.
+ * After encoding, the kernel hands the frames to the application through the send
+ * callback until it refuses one. The application tells
+ * when it can take more with app_audio_sent().
+ *
+ * The system is kept out of sleep while the microphone records. The module uses the
+ * PDM interface and the sample rate converter of the DA14585/586, the DA14531 has none
+ * of them.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _APP_AUDIO_H_
+#define _APP_AUDIO_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined (CFG_APP_AUDIO)
+
+#if defined (__DA14531__)
+#error "The DA14531 has no PDM interface"
+#endif
+
+#include "pdm.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Sample rate of the sample rate converter
+#ifndef APP_AUDIO_SRC_RATE
+#define APP_AUDIO_SRC_RATE              (16000)
+#endif
+
+/// Decimation after the sample rate converter, 1 or 2
+#ifndef APP_AUDIO_DECIMATION
+#define APP_AUDIO_DECIMATION            (1)
+#endif
+
+/// Sample rate of the frames
+#define APP_AUDIO_SAMPLE_RATE           (APP_AUDIO_SRC_RATE / APP_AUDIO_DECIMATION)
+
+/// Gain as a left shift of the samples, 0 to 8
+#ifndef APP_AUDIO_GAIN_SHIFT
+#define APP_AUDIO_GAIN_SHIFT            (0)
+#endif
+
+/// Samples of a block, 8ms at 16kHz
+#ifndef APP_AUDIO_BLOCK_LEN
+#define APP_AUDIO_BLOCK_LEN             (128)
+#endif
+
+/// Blocks of the sample ring, the kernel may be late by all of them but one
+#ifndef APP_AUDIO_BLOCKS
+#define APP_AUDIO_BLOCKS                (4)
+#endif
+
+/// Size of the frame FIFO in bytes
+#ifndef APP_AUDIO_FIFO_SIZE
+#define APP_AUDIO_FIFO_SIZE             (2048)
+#endif
+
+/// Frame header length
+#define APP_AUDIO_HDR_LEN               (4)
+
+/// Shortest frame, the payload of a notification with the default ATT MTU
+#define APP_AUDIO_FRAME_MIN             (20)
+
+/// Longest frame
+#define APP_AUDIO_FRAME_MAX             (244)
+
+/// Samples of a frame of len bytes
+#define APP_AUDIO_FRAME_SAMPLES(len)    (((len) - APP_AUDIO_HDR_LEN) * 2)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Audio configuration, must stay valid while the microphone records
+struct app_audio_cfg
+{
+    /// PDM clock pin
+    pdm_gpio_t clk_gpio;
+    /// PDM data pin
+    pdm_gpio_t data_gpio;
+    /**
+     * Sends a frame. Returns false to keep the frame and try again after app_audio_sent(),
+     * true once the frame is taken, it may then be overwritten.
+     */
+    bool (*send)(const uint8_t *frame, uint16_t len);
+};
+
+/// Audio statistics
+struct app_audio_stats
+{
+    /// Frames encoded
+    uint32_t frames;
+    /// Frames taken by the send callback
+    uint32_t sent;
+    /// Frames dropped, the FIFO was full or the frame length changed
+    uint32_t dropped;
+    /// Blocks lost because the kernel had not encoded the previous ones
+    uint16_t overruns;
+    /// Highest number of frames in the FIFO
+    uint8_t max_depth;
+    /// Frames the FIFO holds at the current frame length
+    uint8_t slots;
+    /// Current frame length
+    uint16_t frame_len;
+};
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Start recording. Does nothing if the microphone already records.
+ * @param[in] cfg       Audio configuration
+ * @param[in] frame_len Frame length, APP_AUDIO_FRAME_MIN to APP_AUDIO_FRAME_MAX
+ ****************************************************************************************
+ */
+void app_audio_start(const struct app_audio_cfg *cfg, uint16_t frame_len);
+
+/**
+ ****************************************************************************************
+ * @brief Stop recording, the frames not sent are dropped.
+ ****************************************************************************************
+ */
+void app_audio_stop(void);
+
+/**
+ ****************************************************************************************
+ * @brief Change the frame length, e.g. after the ATT MTU exchange. The frames not sent
+ *        yet are dropped, does nothing if the length is unchanged.
+ * @param[in] frame_len Frame length, clamped to APP_AUDIO_FRAME_MIN..APP_AUDIO_FRAME_MAX
+ ****************************************************************************************
+ */
+void app_audio_set_frame_len(uint16_t frame_len);
+
+/**
+ ****************************************************************************************
+ * @brief Tell that the application can take frames again, e.g. on the completion of a
+ *        notification. The frames waiting in the FIFO are sent.
+ ****************************************************************************************
+ */
+void app_audio_sent(void);
+
+/**
+ ****************************************************************************************
+ * @brief Check if the microphone records.
+ * @return true between app_audio_start() and app_audio_stop()
+ ****************************************************************************************
+ */
+bool app_audio_is_active(void);
+
+/**
+ ****************************************************************************************
+ * @brief Get the statistics of the audio module.
+ * @return Statistics since the last app_audio_reset_stats()
+ ****************************************************************************************
+ */
+const struct app_audio_stats *app_audio_get_stats(void);
+
+/**
+ ****************************************************************************************
+ * @brief Clear the statistics.
+ ****************************************************************************************
+ */
+void app_audio_reset_stats(void);
+
+#endif // CFG_APP_AUDIO
+
+#endif // _APP_AUDIO_H_
+
+///@}
+///@}
@@ -12,6 +12,16 @@
  *
  * @brief Battery server application header file.
  *
+ * With CFG_APP_BASS_ADAPTIVE_POLL the battery is not converted at every poll period.
+ * The period given to app_batt_poll_start() becomes the shortest one: it doubles up to
+ * APP_BATT_MON_MAX_SHIFT times while the level is stable, halves when the level moves
+ * and stays the shortest one near the alert threshold. A conversion waits for a gap of
+ * APP_BATT_MON_GAP_SLOTS before the next radio event, so that the cell is not sampled
+ * while it supplies the radio. The samples that could not wait go through a slower
+ * filter. The level only rises by APP_BATT_MON_LVL_HYST or more, and BASS is updated
+ * only when the level changes; app_batt_get_lvl() returns the last level without a
+ * conversion.
+ *
  * Copyright (C) 2012-2019 Dialog Semiconductor.
  * This computer program includes Confidential, Proprietary Information
  * of Dialog Semiconductor. All Rights Reserved.
@@ -31,6 +41,53 @@
 #include <stdint.h>
 #include "gpio.h"
 
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+#if defined (CFG_APP_BASS_ADAPTIVE_POLL)
+/// Longest poll period, as a power of 2 of the period given to app_batt_poll_start()
+#ifndef APP_BATT_MON_MAX_SHIFT
+#define APP_BATT_MON_MAX_SHIFT          (4)
+#endif
+
+/// Filter of the samples taken out of the radio events, weight 2^-shift
+#ifndef APP_BATT_MON_FILTER_SHIFT
+#define APP_BATT_MON_FILTER_SHIFT       (2)
+#endif
+
+/// Extra filter shift of the samples taken close to a radio event
+#ifndef APP_BATT_MON_LOAD_SHIFT
+#define APP_BATT_MON_LOAD_SHIFT         (2)
+#endif
+
+/// Levels above the alert threshold polled with the shortest period
+#ifndef APP_BATT_MON_ALERT_MARGIN
+#define APP_BATT_MON_ALERT_MARGIN       (5)
+#endif
+
+/// Rise of the level needed to report it, the cell recovers after a load
+#ifndef APP_BATT_MON_LVL_HYST
+#define APP_BATT_MON_LVL_HYST           (2)
+#endif
+
+/// Free slots of 625us needed before the next radio event to run a conversion
+#ifndef APP_BATT_MON_GAP_SLOTS
+#define APP_BATT_MON_GAP_SLOTS          (4)
+#endif
+
+/// Retries in 10ms units when the next radio event is too close
+#ifndef APP_BATT_MON_RETRY_DELAY
+#define APP_BATT_MON_RETRY_DELAY        (1)
+#endif
+
+/// Retries before sampling anyway
+#ifndef APP_BATT_MON_RETRY_MAX
+#define APP_BATT_MON_RETRY_MAX          (8)
+#endif
+#endif // CFG_APP_BASS_ADAPTIVE_POLL
+
 /*
  * EXTERNAL VARIABLES DECLARATION
  ****************************************************************************************
@@ -48,6 +105,25 @@ extern uint8_t bat_led_state;
  ****************************************************************************************
  */
 
+#if defined (CFG_APP_BASS_ADAPTIVE_POLL)
+/// Adaptive battery polling statistics
+struct app_batt_mon_stats
+{
+    /// Conversions run
+    uint32_t conversions;
+    /// Conversions the fixed poll period would have run meanwhile but were not
+    uint32_t avoided;
+    /// Conversions run close to a radio event after all the retries
+    uint16_t loaded;
+    /// Retries because the next radio event was too close
+    uint16_t retries;
+    /// Level updates sent to BASS
+    uint16_t updates;
+    /// Current poll period in 10ms units
+    uint32_t period;
+};
+#endif
+
 /// BASS APP callbacks
 struct app_bass_cb
 {
@@ -113,10 +189,38 @@ void app_batt_lvl(void);
  */
 void app_batt_set_level(uint8_t batt_level);
 
+/**
+ ****************************************************************************************
+ * @brief Returns the last battery level, no conversion is run.
+ * @return battery level (0-100%)
+ ****************************************************************************************
+ */
+uint8_t app_batt_get_lvl(void);
+
+#if defined (CFG_APP_BASS_ADAPTIVE_POLL)
+/**
+ ****************************************************************************************
+ * @brief Runs a poll of the adaptive battery monitor: converts the battery if the radio
+ *        leaves time for it, filters the sample and updates the level.
+ * @return Delay to the next poll in 10ms units
+ ****************************************************************************************
+ */
+uint32_t app_batt_mon_poll(void);
+
+/**
+ ****************************************************************************************
+ * @brief Returns the statistics of the adaptive battery monitor.
+ * @return Statistics since app_batt_init()
+ ****************************************************************************************
+ */
+const struct app_batt_mon_stats *app_batt_mon_get_stats(void);
+#endif
+
 /**
  ****************************************************************************************
  * @brief Starts battery level polling.
- * @param[in] poll_timeout      Battery Polling frequency
+ * @param[in] poll_timeout      Battery Polling frequency, the shortest period with
+ *                              CFG_APP_BASS_ADAPTIVE_POLL
  ****************************************************************************************
  */
 void app_batt_poll_start(uint16_t poll_timeout);
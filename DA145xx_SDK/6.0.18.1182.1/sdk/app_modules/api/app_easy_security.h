@@ -36,6 +36,23 @@
 #include "app_utils.h"
 #include "app_security.h"
 
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+#if defined (CFG_APP_SEC_RPA_CACHE)
+/// Number of Resolvable Private Addresses remembered with the bond slot they resolve to
+#ifndef APP_EASY_SECURITY_RPA_CACHE_SIZE
+#define APP_EASY_SECURITY_RPA_CACHE_SIZE        (4)
+#endif
+
+/// Number of most recently used bond slots whose IRKs are tried first
+#ifndef APP_EASY_SECURITY_MRU_SIZE
+#define APP_EASY_SECURITY_MRU_SIZE              (8)
+#endif
+#endif // CFG_APP_SEC_RPA_CACHE
+
 /*
  * FUNCTION DECLARATIONS
  ****************************************************************************************
@@ -218,6 +235,38 @@ void app_easy_security_reject_encryption(uint8_t conidx);
  */
 uint8_t app_easy_security_resolve_bdaddr(uint8_t conidx);
 
+#if defined (CFG_APP_SEC_RPA_CACHE)
+/**
+ ****************************************************************************************
+ * @brief Resolve the Resolvable Private Address of a new connection ahead of the
+ *        encryption request.
+ *
+ * The RPA is first looked up in the cache of recently resolved addresses. Otherwise the
+ * stored IRKs are tried in software through the AES engine, the most recently used bond
+ * slots first. The result is delivered by app_easy_security_resolve_bdaddr() without a
+ * GAPM_RESOLV_ADDR_CMD. Nothing is done for other address types.
+ * @param[in] conidx    Connection Id index
+ ****************************************************************************************
+ */
+void app_easy_security_rpa_prefetch(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Record the bond slot found by GAPM for the pending RPA resolution.
+ * @param[in] param     GAPM_ADDR_SOLVED_IND parameters
+ * @return Connection Id index of the resolution
+ ****************************************************************************************
+ */
+uint8_t app_easy_security_rpa_solved(struct gapm_addr_solved_ind const *param);
+
+/**
+ ****************************************************************************************
+ * @brief Forget the resolved RPAs, e.g. after the bond database has changed.
+ ****************************************************************************************
+ */
+void app_easy_security_rpa_cache_clear(void);
+#endif // CFG_APP_SEC_RPA_CACHE
+
 /**
  ****************************************************************************************
  * @brief Request a Resolving List operation
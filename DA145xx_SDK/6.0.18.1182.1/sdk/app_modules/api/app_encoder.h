@@ -0,0 +1,203 @@
+/**
+ ****************************************************************************************
+ * @addtogroup APP_Modules
+ * @{
+ * @addtogroup ENCODER
+ * @brief Quadrature Encoder Motion API
+ * @{
+ *
+ * @file app_encoder.h
+ *
+ * @brief Quadrature encoder to relative motion reports header.
+ *
+ * The quadrature decoder interrupt only wakes the kernel up, the counters are read in the
+ * kernel context and their differences, modulo 2^16, are added to the motion not yet
+ * reported. A report is built when none is in flight: the first motion is sent at once,
+ * further motion is gathered until the application tells that the previous report has
+ * been handled, i.e. one report per connection event. The counters are read again at
+ * that point, so the counts below the interrupt threshold are not delayed. The X/Y and Z motion of a report
+ * goes through an acceleration curve with a Q8 gain. The fraction of a count left by the
+ * gain, and the motion beyond the range of a report, are carried over to the next report
+ * so that no count is lost.
+ *
+ * The system is kept out of sleep while the decoder counts. After APP_ENCODER_IDLE_TIME
+ * without motion the decoder is released and its pins are armed on the wakeup controller,
+ * each one on the level opposite to its current level, so that any edge starts the
+ * decoder again. The edge that wakes the encoder up is not counted.
+ *
+ * On the DA14531 the encoder uses the second wakeup interrupt (wkupct2), as does the key
+ * matrix, so the two modules cannot be used together. On the DA14585/586 it uses the
+ * wakeup interrupt. The build stops if CFG_APP_KEY_MATRIX, or CFG_UART2_WAKEUP on the
+ * DA14585/586, wants the same interrupt.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _APP_ENCODER_H_
+#define _APP_ENCODER_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gpio.h"
+#include "wkupct_quadec.h"
+
+#if defined (CFG_APP_ENCODER)
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Largest number of decoder pins armed on the wakeup controller
+#define APP_ENCODER_MAX_PINS            (6)
+
+/// Interrupt threshold of the decoder, see quad_decoder_enable_irq(). The counts below the
+/// threshold wait for the next report or the idle timer, 0 interrupts on every count.
+#ifndef APP_ENCODER_IRQ_EVENTS
+#define APP_ENCODER_IRQ_EVENTS          (0)
+#endif
+
+/// Time without motion before the decoder is released, in 10ms units
+#ifndef APP_ENCODER_IDLE_TIME
+#define APP_ENCODER_IDLE_TIME           (100)
+#endif
+
+/// Debouncing time of the wakeup controller in ms, max 63
+#ifndef APP_ENCODER_WKUP_DEB_TIME
+#define APP_ENCODER_WKUP_DEB_TIME       (0)
+#endif
+
+/// Unity gain of an acceleration curve
+#define APP_ENCODER_GAIN_ONE            (256)
+
+/// Range of the X/Y motion of a report
+#define APP_ENCODER_XY_MAX              (32767)
+
+/// Range of the Z motion of a report
+#define APP_ENCODER_Z_MAX               (127)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Pin of the decoder
+struct app_encoder_pin
+{
+    /// GPIO port
+    GPIO_PORT port;
+    /// GPIO pin
+    GPIO_PIN pin;
+};
+
+/// Point of an acceleration curve
+struct app_encoder_accel
+{
+    /// Motion of a report, in counts
+    uint16_t speed;
+    /// Gain at this speed, APP_ENCODER_GAIN_ONE for 1.0
+    uint16_t gain;
+};
+
+/// Acceleration curve, the gain is interpolated linearly between the points
+struct app_encoder_curve
+{
+    /// Points by increasing speed, the gain stays flat beyond the first and last ones
+    const struct app_encoder_accel *points;
+    /// Number of points
+    uint8_t nb_points;
+};
+
+/// Encoder configuration, must stay valid while the encoder runs
+struct app_encoder_cfg
+{
+    /// Decoder channels and clock
+    QUAD_DEC_INIT_PARAMS_t qdec;
+    /// Pins of the channels in use, armed on the wakeup controller while idle
+    const struct app_encoder_pin *pins;
+    /// Number of pins, up to APP_ENCODER_MAX_PINS
+    uint8_t nb_pins;
+    /// Curve of the X/Y motion, NULL for unity gain. The speed is the larger of |X| and |Y|
+    const struct app_encoder_curve *xy_curve;
+    /// Curve of the Z motion, NULL for unity gain
+    const struct app_encoder_curve *z_curve;
+    /**
+     * Sends a report. Returns false to keep the motion and try again later, true once the
+     * report is queued or dropped on purpose, e.g. while no host is connected.
+     */
+    bool (*send)(int16_t x, int16_t y, int8_t z);
+};
+
+/// Encoder statistics
+struct app_encoder_stats
+{
+    /// Counts read from the decoder, per channel
+    int32_t counts[3];
+    /// Reports sent
+    uint32_t reports;
+    /// Decoder interrupts
+    uint32_t irqs;
+    /// Wakeups from idle
+    uint16_t wakeups;
+};
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Start the encoder: arm the decoder pins on the wakeup controller.
+ * @param[in] cfg       Encoder configuration
+ ****************************************************************************************
+ */
+void app_encoder_init(const struct app_encoder_cfg *cfg);
+
+/**
+ ****************************************************************************************
+ * @brief Configure the decoder pins as inputs with pull-up. To be called from
+ *        set_pad_functions(), the GPIO configuration is lost in sleep.
+ ****************************************************************************************
+ */
+void app_encoder_set_pads(void);
+
+/**
+ ****************************************************************************************
+ * @brief Tell that the last report has been handled, e.g. on HOGPD_REPORT_UPD_RSP. The
+ *        motion gathered meanwhile is sent.
+ ****************************************************************************************
+ */
+void app_encoder_report_done(void);
+
+/**
+ ****************************************************************************************
+ * @brief Check if the decoder is counting.
+ * @return false while the encoder is idle, armed on the wakeup controller
+ ****************************************************************************************
+ */
+bool app_encoder_is_active(void);
+
+/**
+ ****************************************************************************************
+ * @brief Get the statistics of the encoder.
+ * @return Statistics since app_encoder_init()
+ ****************************************************************************************
+ */
+const struct app_encoder_stats *app_encoder_get_stats(void);
+
+#endif // CFG_APP_ENCODER
+
+#endif // _APP_ENCODER_H_
+
+///@}
+///@}
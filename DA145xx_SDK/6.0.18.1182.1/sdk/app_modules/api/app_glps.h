@@ -0,0 +1,160 @@
+/**
+ ****************************************************************************************
+ * @addtogroup APP_Modules
+ * @{
+ * @addtogroup Profiles
+ * @{
+ * @addtogroup GLPS
+ * @brief Glucose Profile Sensor Application API
+ * @{
+ *
+ * @file app_glps.h
+ *
+ * @brief Glucose Profile Sensor Application header.
+ *
+ * The application keeps the measurements in a record store in SPI flash and serves the
+ * Record Access Control Point on its own: the number of stored records, report, delete
+ * and abort operations are executed by this module and the reported records are sent
+ * one after the other without involving the user application.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _APP_GLPS_H_
+#define _APP_GLPS_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "rwip_config.h"
+
+#if (BLE_GL_SENSOR)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "glp_common.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Flash offset of the record store. It must not overlap the application image, the
+/// bond database or any other data kept in the SPI flash.
+#ifndef APP_GLPS_STORE_OFFSET
+#define APP_GLPS_STORE_OFFSET           (0x18000)
+#endif
+
+/// Number of 4KB flash sectors used by the record store, at least 2. The store holds
+/// between (APP_GLPS_STORE_SECTORS - 1) and APP_GLPS_STORE_SECTORS sectors of records,
+/// the oldest sector is dropped when a new one is needed.
+#ifndef APP_GLPS_STORE_SECTORS
+#define APP_GLPS_STORE_SECTORS          (4)
+#endif
+
+/// Glucose features exposed by the service
+#ifndef APP_GLPS_FEATURES
+#define APP_GLPS_FEATURES               (GLP_FET_LOW_BAT_DET_DUR_MEAS_SUPP | \
+                                         GLP_FET_SENS_MFNC_DET_SUPP | \
+                                         GLP_FET_TIME_FLT_SUPP)
+#endif
+
+/// Measurement context supported
+#ifndef APP_GLPS_MEAS_CTX_SUPPORTED
+#define APP_GLPS_MEAS_CTX_SUPPORTED     (1)
+#endif
+
+/*
+ * FUNCTIONS DECLARATION
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Add a Glucose Profile Sensor instance in the DB
+ ****************************************************************************************
+ */
+void app_glps_create_db(void);
+
+/**
+ ****************************************************************************************
+ * @brief Enable Glucose Profile Sensor.
+ * param[in] conidx     Connection index
+ ****************************************************************************************
+ */
+void app_glps_enable(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Store a measurement. It is assigned the next sequence number.
+ * @param[in] meas      Glucose measurement
+ * @param[in] ctx       Measurement context, NULL if none
+ * @param[out] seq_num  Sequence number of the stored record, may be NULL
+ * @return true if the record was written to flash
+ ****************************************************************************************
+ */
+bool app_glps_store_add(const struct glp_meas *meas, const struct glp_meas_ctx *ctx,
+                        uint16_t *seq_num);
+
+/**
+ ****************************************************************************************
+ * @brief Number of stored records.
+ * @return Number of records
+ ****************************************************************************************
+ */
+uint16_t app_glps_store_count(void);
+
+/**
+ ****************************************************************************************
+ * @brief Erase all the stored records. Sequence numbers are not reused.
+ ****************************************************************************************
+ */
+void app_glps_store_clear(void);
+
+/**
+ ****************************************************************************************
+ * @brief Set the client configuration restored when the service is enabled.
+ * param[in] evt_cfg     GLPS_MEAS_NTF_CFG, GLPS_MEAS_CTX_NTF_CFG and GLPS_RACP_IND_CFG bits
+ ****************************************************************************************
+ */
+void app_glps_set_initial_evt_cfg(uint16_t evt_cfg);
+
+/**
+ ****************************************************************************************
+ * @brief Execute a Record Access Control Point request.
+ * param[in] conidx     Connection index
+ * param[in] req        Request received by the profile
+ ****************************************************************************************
+ */
+void app_glps_racp_req(uint8_t conidx, const struct glp_racp_req *req);
+
+/**
+ ****************************************************************************************
+ * @brief Continue the ongoing report once a measurement has been sent.
+ * param[in] conidx     Connection index
+ * param[in] status     Status of the measurement notification
+ ****************************************************************************************
+ */
+void app_glps_meas_sent(uint8_t conidx, uint8_t status);
+
+/**
+ ****************************************************************************************
+ * @brief Keep track of the client configuration.
+ * param[in] evt_cfg     Client configuration reported by the profile
+ ****************************************************************************************
+ */
+void app_glps_cfg_ind(uint16_t evt_cfg);
+
+#endif // (BLE_GL_SENSOR)
+
+#endif // _APP_GLPS_H_
+
+///@}
+///@}
+///@}
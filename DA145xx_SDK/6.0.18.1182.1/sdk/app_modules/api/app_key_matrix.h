@@ -0,0 +1,159 @@
+/**
+ ****************************************************************************************
+ * @addtogroup APP_Modules
+ * @{
+ * @addtogroup KEY_MATRIX
+ * @brief Key Matrix Scanner API
+ * @{
+ *
+ * @file app_key_matrix.h
+ *
+ * @brief Key matrix scanner header.
+ *
+ * The rows are inputs with pull-up and the columns are driven low while no key is
+ * pressed, so a key press pulls its row low. The rows are then armed on the wakeup
+ * controller and the system may stay in extended sleep. The wakeup interrupt starts a
+ * burst of scans, one every APP_KEY_MATRIX_SCAN_PERIOD, each driving one column low at a
+ * time while the other columns float on their pull-ups. Every key is debounced with an
+ * integrator and a change is reported once the integrator saturates. The burst stops
+ * and the rows are armed again once every key is released and settled.
+ *
+ * Three keys at the corners of a rectangle make the fourth corner read as pressed. While
+ * two rows share more than one pressed column, no new press is reported in these rows.
+ *
+ * On the DA14531 the matrix uses the second wakeup interrupt (wkupct2), the first one
+ * stays available to the application. On the DA14585/586 it uses the wakeup interrupt.
+ * The build stops if CFG_APP_ENCODER, or CFG_UART2_WAKEUP on the DA14585/586, wants the
+ * same interrupt.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _APP_KEY_MATRIX_H_
+#define _APP_KEY_MATRIX_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gpio.h"
+
+#if defined (CFG_APP_KEY_MATRIX)
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Largest number of rows
+#ifndef APP_KEY_MATRIX_MAX_ROWS
+#define APP_KEY_MATRIX_MAX_ROWS         (8)
+#endif
+
+/// Largest number of columns, the pressed keys of a row are kept in one byte
+#define APP_KEY_MATRIX_MAX_COLS         (8)
+
+/// Interval between two scans of a burst, in 10ms units
+#ifndef APP_KEY_MATRIX_SCAN_PERIOD
+#define APP_KEY_MATRIX_SCAN_PERIOD      (1)
+#endif
+
+/// Consecutive scans a key must be read in its new state before the change is reported
+#ifndef APP_KEY_MATRIX_DEBOUNCE
+#define APP_KEY_MATRIX_DEBOUNCE         (2)
+#endif
+
+/// Debouncing time of the wakeup controller in ms, max 63
+#ifndef APP_KEY_MATRIX_WKUP_DEB_TIME
+#define APP_KEY_MATRIX_WKUP_DEB_TIME    (2)
+#endif
+
+/// Delay loop iterations between driving a column and reading the rows
+#ifndef APP_KEY_MATRIX_SETTLE_LOOPS
+#define APP_KEY_MATRIX_SETTLE_LOOPS     (20)
+#endif
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Pin of a row or column
+struct app_key_matrix_pin
+{
+    /// GPIO port
+    GPIO_PORT port;
+    /// GPIO pin
+    GPIO_PIN pin;
+};
+
+/// Key matrix configuration, must stay valid while the scanner runs
+struct app_key_matrix_cfg
+{
+    /// Row pins, inputs with pull-up
+    const struct app_key_matrix_pin *rows;
+    /// Column pins, driven low
+    const struct app_key_matrix_pin *cols;
+    /// Number of rows, up to APP_KEY_MATRIX_MAX_ROWS
+    uint8_t nb_rows;
+    /// Number of columns, up to APP_KEY_MATRIX_MAX_COLS
+    uint8_t nb_cols;
+    /// Called for every debounced key change
+    void (*on_key)(uint8_t row, uint8_t col, bool pressed);
+    /// Called after the key changes of a scan have been reported, may be NULL
+    void (*on_scan_end)(void);
+};
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Start the scanner: configure the pins and arm the rows on the wakeup
+ *        controller.
+ * @param[in] cfg       Matrix configuration
+ ****************************************************************************************
+ */
+void app_key_matrix_init(const struct app_key_matrix_cfg *cfg);
+
+/**
+ ****************************************************************************************
+ * @brief Configure the pins of the matrix in their idle state. To be called from
+ *        set_pad_functions(), the GPIO configuration is lost in sleep.
+ ****************************************************************************************
+ */
+void app_key_matrix_set_pads(void);
+
+/**
+ ****************************************************************************************
+ * @brief Check if a key is pressed, after debouncing.
+ * @param[in] row       Row of the key
+ * @param[in] col       Column of the key
+ * @return true if the key is pressed
+ ****************************************************************************************
+ */
+bool app_key_matrix_is_pressed(uint8_t row, uint8_t col);
+
+/**
+ ****************************************************************************************
+ * @brief Check if a scan burst is running.
+ * @return true between the wakeup interrupt and the release of all the keys
+ ****************************************************************************************
+ */
+bool app_key_matrix_is_scanning(void);
+
+#endif // CFG_APP_KEY_MATRIX
+
+#endif // _APP_KEY_MATRIX_H_
+
+///@}
+///@}
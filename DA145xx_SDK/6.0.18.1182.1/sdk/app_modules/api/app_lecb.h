@@ -0,0 +1,267 @@
+/**
+ ****************************************************************************************
+ * @addtogroup APP_Modules
+ * @{
+ * @addtogroup LECB
+ * @brief LE Credit Based Channel Application API
+ * @{
+ *
+ * @file app_lecb.h
+ *
+ * @brief LE Credit Based Channel application header.
+ *
+ * One LE credit based L2CAP channel (LE CoC) per connection, opened either by accepting
+ * the peer request on a registered LE_PSM or by connecting to the peer LE_PSM.
+ *
+ * Transmitted SDUs are written by the application straight into the L2CC message handed
+ * over to the stack, which segments them into K-frames and waits for the peer credits.
+ * Received SDUs are reassembled by the stack and handed to the application in the L2CC
+ * message, which is kept until the application releases it. The credits given to the
+ * peer are bounded by the receive budget of APP_LECB_RX_CREDITS K-frames: a credit is
+ * returned only when the space of a released SDU is free again.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _APP_LECB_H_
+#define _APP_LECB_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "rwip_config.h"
+
+#if (BLE_APP_LECB)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "l2cc_task.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Receive budget of a channel in K-frames of MPS bytes. The peer never holds more
+/// credits than the K-frames not yet used by the SDUs kept by the application. It must
+/// cover an SDU of the local MTU, i.e. ((MTU + 2) / MPS) rounded up.
+#ifndef APP_LECB_RX_CREDITS
+#define APP_LECB_RX_CREDITS             (8)
+#endif
+
+/// Credits are returned to the peer once at least this many are free, or once all the
+/// received SDUs are released. Batching saves a signaling packet per released SDU.
+#ifndef APP_LECB_CREDIT_BATCH
+#define APP_LECB_CREDIT_BATCH           ((APP_LECB_RX_CREDITS + 3) / 4)
+#endif
+
+/// Number of SDUs of a channel handed to the stack and not yet sent. Two keep the next
+/// SDU ready while the previous one is transmitted.
+#ifndef APP_LECB_TX_PIPELINE
+#define APP_LECB_TX_PIPELINE            (2)
+#endif
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// LECB APP callbacks
+struct app_lecb_cb
+{
+    /// Callback upon 'connect_req_ind', returns the L2CAP result (L2C_CB_CON_SUCCESS to accept)
+    uint16_t (*on_lecb_connect_req)(uint8_t conidx, uint16_t le_psm, uint16_t peer_mtu);
+
+    /// Callback upon 'connect_ind', the channel is open
+    void (*on_lecb_connected)(uint8_t conidx, uint16_t le_psm, uint16_t peer_mtu);
+
+    /// Callback upon 'disconnect_ind' or a failed channel establishment
+    void (*on_lecb_disconnected)(uint8_t conidx, uint16_t le_psm, uint16_t reason);
+
+    /// Callback upon 'data_recv_ind', the SDU must be released with app_lecb_rx_release()
+    void (*on_lecb_sdu_received)(uint8_t conidx, const uint8_t *sdu, uint16_t len);
+
+    /// Callback upon 'pdu_send_rsp', a further SDU may be allocated
+    void (*on_lecb_sdu_sent)(uint8_t conidx, uint8_t status);
+};
+
+/// Channel states
+enum app_lecb_state
+{
+    /// No channel
+    APP_LECB_IDLE,
+    /// LE_PSM registered, waiting for the peer
+    APP_LECB_LISTENING,
+    /// Channel being established
+    APP_LECB_CONNECTING,
+    /// Channel open
+    APP_LECB_CONNECTED,
+    /// Channel being closed and LE_PSM being released
+    APP_LECB_DISCONNECTING,
+};
+
+/// LECB environment of a connection
+struct app_lecb_env_tag
+{
+    /// Channel state, see enum app_lecb_state
+    uint8_t state;
+    /// LE_PSM registered locally (back to listening when the peer closes the channel)
+    bool listen;
+    /// SDUs handed to the stack and not yet sent
+    uint8_t tx_pending;
+    /// LE Protocol/Service Multiplexer
+    uint16_t le_psm;
+    /// Channel identifier of the peer
+    uint16_t dest_cid;
+    /// Largest SDU accepted by the peer
+    uint16_t peer_mtu;
+    /// Credits granted by the peer
+    uint16_t tx_credit;
+    /// Credits held by the peer
+    uint16_t rx_credit;
+    /// Credits used by the SDUs kept by the application
+    uint16_t rx_held;
+    /// SDUs of the channel kept by the application, an SDU uses one credit at least
+    const uint8_t *rx_sdu[APP_LECB_RX_CREDITS];
+    /// Credits being returned to the peer, not yet applied by the stack
+    uint16_t rx_adding;
+    /// SDU allocated and not yet sent
+    struct l2cc_pdu_send_req *tx_req;
+};
+
+/*
+ * GLOBAL VARIABLES DECLARATIONS
+ ****************************************************************************************
+ */
+
+/// LECB environment of the connections
+extern struct app_lecb_env_tag app_lecb_env[];
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Register an LE_PSM on a connection, the peer may then open the channel.
+ * @param[in] conidx    Connection index
+ * @param[in] le_psm    LE Protocol/Service Multiplexer
+ * @param[in] sec_lvl   Required security level, see GAPC_LECB_AUTH() and GAPC_LECB_EKS()
+ * @return false if the connection already has a channel
+ ****************************************************************************************
+ */
+bool app_lecb_listen(uint8_t conidx, uint16_t le_psm, uint16_t sec_lvl);
+
+/**
+ ****************************************************************************************
+ * @brief Open a channel to an LE_PSM of the peer.
+ * @param[in] conidx    Connection index
+ * @param[in] le_psm    LE Protocol/Service Multiplexer
+ * @param[in] sec_lvl   Required security level, see GAPC_LECB_AUTH() and GAPC_LECB_EKS()
+ * @return false if the connection already has a channel
+ ****************************************************************************************
+ */
+bool app_lecb_connect(uint8_t conidx, uint16_t le_psm, uint16_t sec_lvl);
+
+/**
+ ****************************************************************************************
+ * @brief Close the channel of a connection. A registered LE_PSM is released too.
+ * @param[in] conidx    Connection index
+ ****************************************************************************************
+ */
+void app_lecb_disconnect(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Allocate the message of the next SDU to send. The SDU is written in place and
+ *        sent with app_lecb_sdu_send().
+ * @param[in] conidx    Connection index
+ * @param[in] len       SDU length, up to the peer MTU
+ * @return Pointer to the SDU data, NULL if the channel is not open, the SDU is too long
+ *         or APP_LECB_TX_PIPELINE SDUs are pending, or the heap is short
+ ****************************************************************************************
+ */
+uint8_t *app_lecb_sdu_alloc(uint8_t conidx, uint16_t len);
+
+/**
+ ****************************************************************************************
+ * @brief Send the SDU allocated by app_lecb_sdu_alloc().
+ * @param[in] conidx    Connection index
+ ****************************************************************************************
+ */
+void app_lecb_sdu_send(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Release a received SDU. Its credits are returned to the peer.
+ * @param[in] conidx    Connection index
+ * @param[in] sdu       SDU data, as passed to on_lecb_sdu_received
+ ****************************************************************************************
+ */
+void app_lecb_rx_release(uint8_t conidx, const uint8_t *sdu);
+
+/**
+ ****************************************************************************************
+ * @brief Credits granted by the peer, i.e. K-frames that can be sent right away.
+ * @param[in] conidx    Connection index
+ * @return Number of credits
+ ****************************************************************************************
+ */
+uint16_t app_lecb_get_tx_credit(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Check if the channel of a connection is open.
+ * @param[in] conidx    Connection index
+ * @return true if SDUs can be exchanged
+ ****************************************************************************************
+ */
+bool app_lecb_is_connected(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Credits used by an SDU, i.e. K-frames of the SDU and its length field.
+ * @param[in] len       SDU length
+ * @return Number of credits
+ ****************************************************************************************
+ */
+uint16_t app_lecb_sdu_credits(uint16_t len);
+
+/**
+ ****************************************************************************************
+ * @brief Return the free credits of the receive budget to the peer.
+ * @param[in] conidx    Connection index
+ ****************************************************************************************
+ */
+void app_lecb_return_credits(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Close the channel of a connection, the LE_PSM is kept if it was registered.
+ *        Called when the peer has closed the channel or refused to open it.
+ * @param[in] conidx    Connection index
+ ****************************************************************************************
+ */
+void app_lecb_closed(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Clear the channel of a connection.
+ * @param[in] conidx    Connection index
+ ****************************************************************************************
+ */
+void app_lecb_reset(uint8_t conidx);
+
+#endif // (BLE_APP_LECB)
+
+#endif // _APP_LECB_H_
+
+///@}
+///@}
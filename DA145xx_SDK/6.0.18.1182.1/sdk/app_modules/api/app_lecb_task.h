@@ -0,0 +1,55 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_lecb_task.h
+ *
+ * @brief LE Credit Based Channel Application task header.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef APP_LECB_TASK_H_
+#define APP_LECB_TASK_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "rwip_config.h"
+
+#if BLE_APP_LECB
+
+#include "ke_msg.h"
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Process handler for the Application LECB messages. It handles the completion of
+ *        the LE credit based operations only, and the disconnection indication is passed
+ *        on to the GAP process handler.
+ * @param[in] msgid   Id of the message received
+ * @param[in] param   Pointer to the parameters of the message
+ * @param[in] dest_id ID of the receiving task instance (probably unused)
+ * @param[in] src_id  ID of the sending task instance
+ * @param[in] msg_ret Result of the message handler
+ * @return Returns if the message is handled by the process handler
+ ****************************************************************************************
+ */
+enum process_event_response app_lecb_process_handler(ke_msg_id_t const msgid,
+                                                     void const *param,
+                                                     ke_task_id_t const dest_id,
+                                                     ke_task_id_t const src_id,
+                                                     enum ke_msg_status_tag *msg_ret);
+
+#endif //BLE_APP_LECB
+
+#endif // APP_LECB_TASK_H_
@@ -0,0 +1,191 @@
+/**
+ ****************************************************************************************
+ * @addtogroup APP_Modules
+ * @{
+ * @addtogroup TIME
+ * @brief RTC Time Keeping API
+ * @{
+ *
+ * @file app_time.h
+ *
+ * @brief Drift compensated wall clock on the RTC header.
+ *
+ * The RTC of the DA14531 counts hundredths of a second from the low power clock and
+ * keeps running in sleep. The module reads it without stopping the counters and turns
+ * its calendar into a day count only when the date changes, so a read costs two BCD
+ * conversions of the time register and no division by the calendar.
+ *
+ * The RTC is as good as its clock. The time is corrected from an anchor, the RTC time
+ * and the true time of the last synchronization or rate change, by two rate errors:
+ *  - with the RCX20, the error of the integer divider, measured at each calibration of
+ *    the RCX (rcx_time_data.rcx_period). The anchor is moved when the period changes, so
+ *    every stretch of time is corrected with the rate it ran at.
+ *  - the error learned from the offsets found at each app_time_sync(), weighed by the
+ *    length of the interval since the previous one. A synchronization that changes the
+ *    time zone or the DST, or an offset faster than APP_TIME_DRIFT_MAX_PPB, is a step and
+ *    not learned from.
+ *
+ * Times are seconds since 2000-01-01 00:00:00 of the local time, the time written by the
+ * Current Time Service client. The state is lost on a reset, the clock then starts again
+ * from 2000-01-01 until it is synchronized. The module owns the RTC.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _APP_TIME_H_
+#define _APP_TIME_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined (CFG_APP_TIME)
+
+#if !defined (__DA14531__)
+#error "The time module needs the RTC of the DA14531"
+#endif
+
+#include "rwip_config.h"
+
+#if (BLE_CTS_SERVER)
+#include "cts_common.h"
+#endif
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Largest rate error of the clock, parts per billion
+#ifndef APP_TIME_DRIFT_MAX_PPB
+#define APP_TIME_DRIFT_MAX_PPB          (500000)
+#endif
+
+/// Rate error assumed once learned, for the accuracy reported to CTS clients
+#ifndef APP_TIME_RESIDUAL_PPB
+#define APP_TIME_RESIDUAL_PPB           (20000)
+#endif
+
+/// Interval between synchronizations at which the measured rate gets half the weight (cs)
+#ifndef APP_TIME_LEARN_TAU
+#define APP_TIME_LEARN_TAU              (8640000UL)
+#endif
+
+/// Shortest interval between synchronizations to learn from (cs)
+#ifndef APP_TIME_LEARN_MIN
+#define APP_TIME_LEARN_MIN              (360000UL)
+#endif
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Time statistics
+struct app_time_stats
+{
+    /// Reads of the RTC
+    uint32_t reads;
+    /// Conversions of the calendar register
+    uint16_t date_decodes;
+    /// Synchronizations
+    uint16_t syncs;
+    /// Synchronizations learned from
+    uint16_t learned;
+    /// Changes of the RCX period
+    uint16_t rcx_updates;
+    /// Learned rate error, parts per billion
+    int32_t learned_ppb;
+    /// Rate error of the RCX divider, parts per billion
+    int32_t rcx_ppb;
+};
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Start the RTC at 2000-01-01 00:00:00. The low power clock must run.
+ ****************************************************************************************
+ */
+void app_time_init(void);
+
+/**
+ ****************************************************************************************
+ * @brief Get the corrected time.
+ * @param[out] hsec     Hundredths of the second, may be NULL
+ * @return Seconds since 2000-01-01 00:00:00
+ ****************************************************************************************
+ */
+uint32_t app_time_now(uint8_t *hsec);
+
+/**
+ ****************************************************************************************
+ * @brief Set the time from a reference, and learn the rate error from the offset.
+ * @param[in] sec       Seconds since 2000-01-01 00:00:00
+ * @param[in] hsec      Hundredths of the second
+ * @param[in] learn     False if the time is stepped on purpose, e.g. a time zone change
+ ****************************************************************************************
+ */
+void app_time_sync(uint32_t sec, uint8_t hsec, bool learn);
+
+/**
+ ****************************************************************************************
+ * @brief Check if the time has been set since the reset.
+ * @return true after the first app_time_sync()
+ ****************************************************************************************
+ */
+bool app_time_is_synced(void);
+
+/**
+ ****************************************************************************************
+ * @brief Get the statistics of the time module.
+ * @return Statistics since app_time_init()
+ ****************************************************************************************
+ */
+const struct app_time_stats *app_time_get_stats(void);
+
+#if (BLE_CTS_SERVER)
+/**
+ ****************************************************************************************
+ * @brief Current Time read callback, for app_ctss_cb.on_cur_time_read_req.
+ * @param[out] ct       Current time
+ ****************************************************************************************
+ */
+void app_time_ctss_read(struct cts_curr_time *ct);
+
+/**
+ ****************************************************************************************
+ * @brief Current Time write callback, for app_ctss_cb.on_cur_time_write_req.
+ * @param[in] ct        Current time
+ * @return ATT_ERR_NO_ERROR, or ATT_ERR_APP_ERROR (Data Field Ignored) for a date out of
+ *         the range of the clock
+ ****************************************************************************************
+ */
+uint8_t app_time_ctss_write(const struct cts_curr_time *ct);
+
+/**
+ ****************************************************************************************
+ * @brief Reference Time Information callback, for app_ctss_cb.on_ref_time_info_read_req.
+ * @param[out] rt       Time since the last synchronization and its accuracy
+ ****************************************************************************************
+ */
+void app_time_ctss_ref_info(struct cts_ref_time_info *rt);
+#endif // BLE_CTS_SERVER
+
+#endif // CFG_APP_TIME
+
+#endif // _APP_TIME_H_
+
+///@}
+///@}
@@ -0,0 +1,426 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_audio.c
+ *
+ * @brief PDM microphone to IMA-ADPCM frames.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "rwip_config.h"     // SW configuration
+#include "app_audio.h"
+
+#if defined (CFG_APP_AUDIO)
+#include <string.h>
+#include "arch_api.h"
+#include "ke_msg.h"
+#include "co_math.h"
+#include "app_easy_msg_utils.h"
+#include "pdm.h"
+#include "audio_codec.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+#if (APP_AUDIO_DECIMATION != 1) && (APP_AUDIO_DECIMATION != 2)
+#error "APP_AUDIO_DECIMATION must be 1 or 2"
+#endif
+
+#if (APP_AUDIO_BLOCK_LEN % 4) != 0
+#error "APP_AUDIO_BLOCK_LEN must be a multiple of 4"
+#endif
+
+#if (APP_AUDIO_BLOCKS < 2) || (APP_AUDIO_BLOCKS > 255)
+#error "APP_AUDIO_BLOCKS must be 2 to 255"
+#endif
+
+#if (APP_AUDIO_FIFO_SIZE < 2 * APP_AUDIO_FRAME_MAX) || (APP_AUDIO_FIFO_SIZE / APP_AUDIO_FRAME_MIN > 255)
+#error "The FIFO must hold 2 to 255 frames"
+#endif
+
+/// Priority of the SRC output interrupt, below the BLE interrupts
+#define AUDIO_SRC_IRQ_PRIO      (2)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Audio environment
+struct audio_env_tag
+{
+    /// Audio configuration
+    const struct app_audio_cfg *cfg;
+    /// Statistics
+    struct app_audio_stats stats;
+    /// Encoder state
+    struct audio_codec_state codec;
+    /// Decimation filter state
+    struct audio_codec_decim decim;
+    /// Message sent from the SRC interrupt to encode the full blocks
+    ke_msg_id_t encode_msg;
+    /// Samples encoded in the frame being filled
+    uint16_t fill;
+    /// Samples written in the block being filled, by the interrupt only
+    uint16_t in;
+    /// Block being filled, written by the interrupt only
+    uint8_t blk_wr;
+    /// Oldest full block, written by the kernel only
+    uint8_t blk_rd;
+    /// Full blocks waiting for the kernel
+    volatile uint8_t blk_full;
+    /// Slot of the frame being filled
+    uint8_t wr;
+    /// Slot of the oldest frame
+    uint8_t rd;
+    /// Sequence number of the frame being filled
+    uint8_t seq;
+    /// True while an encode message is pending
+    volatile bool encode_posted;
+    /// True while the microphone records
+    bool active;
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static struct audio_env_tag audio_env __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+// Only used while recording, the system does not sleep then
+static int16_t audio_pcm[APP_AUDIO_BLOCKS][APP_AUDIO_BLOCK_LEN];
+static uint8_t audio_fifo[APP_AUDIO_FIFO_SIZE];
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Get a slot of the FIFO.
+ * @param[in] slot  Slot index
+ * @return First byte of the frame
+ ****************************************************************************************
+ */
+static uint8_t *audio_slot(uint8_t slot)
+{
+    return &audio_fifo[slot * audio_env.stats.frame_len];
+}
+
+/**
+ ****************************************************************************************
+ * @brief Get the number of frames waiting in the FIFO.
+ * @return Number of complete frames not sent yet
+ ****************************************************************************************
+ */
+static uint8_t audio_depth(void)
+{
+    uint8_t slots = audio_env.stats.slots + 1;
+
+    return (audio_env.wr + slots - audio_env.rd) % slots;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Empty the FIFO and cut it in slots of a new frame length.
+ * @param[in] frame_len Frame length
+ ****************************************************************************************
+ */
+static void audio_fifo_reset(uint16_t frame_len)
+{
+    frame_len = co_max(co_min(frame_len, APP_AUDIO_FRAME_MAX), APP_AUDIO_FRAME_MIN);
+
+    audio_env.stats.frame_len = frame_len;
+    // One slot holds the frame being filled
+    audio_env.stats.slots = (APP_AUDIO_FIFO_SIZE / frame_len) - 1;
+    audio_env.wr = 0;
+    audio_env.rd = 0;
+    audio_env.fill = 0;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Queue the frame just filled, or drop it if the FIFO is full, and start the next
+ *        one.
+ ****************************************************************************************
+ */
+static void audio_commit(void)
+{
+    uint8_t next = (audio_env.wr + 1) % (audio_env.stats.slots + 1);
+    uint8_t depth;
+
+    audio_env.fill = 0;
+    audio_env.seq++;
+    audio_env.stats.frames++;
+
+    if (next == audio_env.rd)
+    {
+        // The slot is filled again, the receiver sees the gap in the sequence numbers
+        audio_env.stats.dropped++;
+        return;
+    }
+
+    audio_env.wr = next;
+
+    depth = audio_depth();
+    if (depth > audio_env.stats.max_depth)
+    {
+        audio_env.stats.max_depth = depth;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Encode a block of samples into the frames.
+ * @param[in,out] pcm   Samples, overwritten by the decimation
+ ****************************************************************************************
+ */
+static void audio_encode(int16_t *pcm)
+{
+    uint16_t n;
+
+#if (APP_AUDIO_DECIMATION == 2)
+    n = audio_codec_decimate(&audio_env.decim, pcm, APP_AUDIO_BLOCK_LEN);
+#else
+    n = APP_AUDIO_BLOCK_LEN;
+#endif
+
+    while (n != 0)
+    {
+        uint8_t *frame = audio_slot(audio_env.wr);
+        uint16_t samples = APP_AUDIO_FRAME_SAMPLES(audio_env.stats.frame_len);
+        uint16_t len;
+
+        // The header holds the state the decoder starts from
+        if (audio_env.fill == 0)
+        {
+            frame[0] = (uint8_t)audio_env.codec.predictor;
+            frame[1] = (uint8_t)((uint16_t)audio_env.codec.predictor >> 8);
+            frame[2] = audio_env.codec.step_index;
+            frame[3] = audio_env.seq;
+        }
+
+        // Both counts are even, a byte is never shared by two blocks
+        len = co_min(n, samples - audio_env.fill);
+        audio_codec_encode(&audio_env.codec, pcm, len, &frame[APP_AUDIO_HDR_LEN + audio_env.fill / 2]);
+        audio_env.fill += len;
+        pcm += len;
+        n -= len;
+
+        if (audio_env.fill == samples)
+        {
+            audio_commit();
+        }
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief SRC output interrupt callback, stores a sample in the block being filled. A
+ *        full block is handed to the kernel, or filled again if all the others still
+ *        wait for it.
+ * @param[in] src_isr_data  Registers of the sample rate converter
+ ****************************************************************************************
+ */
+static void audio_sample(pdm_src_isr_data_t *src_isr_data)
+{
+    audio_codec_narrow(&src_isr_data->src_out1_value, &audio_pcm[audio_env.blk_wr][audio_env.in],
+                       1, APP_AUDIO_GAIN_SHIFT);
+
+    if (++audio_env.in < APP_AUDIO_BLOCK_LEN)
+    {
+        return;
+    }
+
+    audio_env.in = 0;
+
+    if (audio_env.blk_full == APP_AUDIO_BLOCKS - 1)
+    {
+        // The samples of the block are lost
+        audio_env.stats.overruns++;
+        return;
+    }
+
+    audio_env.blk_wr = (audio_env.blk_wr + 1) % APP_AUDIO_BLOCKS;
+    audio_env.blk_full++;
+
+    if (!audio_env.encode_posted)
+    {
+        audio_env.encode_posted = true;
+        ke_msg_send_basic(audio_env.encode_msg, TASK_APP, 0);
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Hand the frames of the FIFO to the application until it refuses one.
+ ****************************************************************************************
+ */
+static void audio_drain(void)
+{
+    while (audio_env.active && (audio_env.rd != audio_env.wr))
+    {
+        if (!audio_env.cfg->send(audio_slot(audio_env.rd), audio_env.stats.frame_len))
+        {
+            break;
+        }
+
+        audio_env.rd = (audio_env.rd + 1) % (audio_env.stats.slots + 1);
+        audio_env.stats.sent++;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Encode the full blocks and send the frames, on the message of the interrupt.
+ ****************************************************************************************
+ */
+static void audio_process(void)
+{
+    audio_env.encode_posted = false;
+
+    while (audio_env.active && (audio_env.blk_full != 0))
+    {
+        audio_encode(audio_pcm[audio_env.blk_rd]);
+        audio_env.blk_rd = (audio_env.blk_rd + 1) % APP_AUDIO_BLOCKS;
+
+        GLOBAL_INT_DISABLE();
+        audio_env.blk_full--;
+        GLOBAL_INT_RESTORE();
+    }
+
+    audio_drain();
+}
+
+void app_audio_start(const struct app_audio_cfg *cfg, uint16_t frame_len)
+{
+    pdm_config_t pdm;
+
+    if (audio_env.active)
+    {
+        return;
+    }
+
+    audio_env.cfg = cfg;
+    memset(&audio_env.codec, 0, sizeof(audio_env.codec));
+    memset(&audio_env.decim, 0, sizeof(audio_env.decim));
+    audio_env.seq = 0;
+    audio_env.in = 0;
+    audio_env.blk_wr = 0;
+    audio_env.blk_rd = 0;
+    audio_env.blk_full = 0;
+    audio_env.encode_posted = false;
+    audio_fifo_reset(frame_len);
+
+    // The message callback is kept when the microphone is started again
+    if (audio_env.encode_msg == 0)
+    {
+        audio_env.encode_msg = app_easy_msg_set(audio_process);
+    }
+
+    pdm.clk_gpio = cfg->clk_gpio;
+    pdm.data_gpio = cfg->data_gpio;
+    pdm.mode = PDM_MODE_MASTER;
+    pdm.direction = PDM_DIRECTION_IN;
+    pdm.src_direction = PDM_SRC_DIRECTION_REG;
+    pdm.src_sample_rate = APP_AUDIO_SRC_RATE;
+    pdm.bypass_out_filter = false;
+    pdm.bypass_in_filter = false;
+    pdm.enable_dithering = true;
+    pdm.pdm_div = 5;
+    pdm.enable_interrupt = true;
+    pdm.interrupt_priority = AUDIO_SRC_IRQ_PRIO;
+    pdm.callback = audio_sample;
+
+    arch_force_active_mode();
+    audio_env.active = true;
+
+    pdm_enable(&pdm);
+}
+
+void app_audio_stop(void)
+{
+    if (!audio_env.active)
+    {
+        return;
+    }
+
+    pdm_disable();
+    audio_env.stats.dropped += audio_depth();
+    audio_env.active = false;
+
+    arch_restore_sleep_mode();
+}
+
+void app_audio_set_frame_len(uint16_t frame_len)
+{
+    uint8_t depth;
+
+    if (!audio_env.active)
+    {
+        return;
+    }
+
+    frame_len = co_max(co_min(frame_len, APP_AUDIO_FRAME_MAX), APP_AUDIO_FRAME_MIN);
+    if (frame_len == audio_env.stats.frame_len)
+    {
+        return;
+    }
+
+    depth = audio_depth();
+    audio_fifo_reset(frame_len);
+
+    audio_env.stats.dropped += depth;
+}
+
+void app_audio_sent(void)
+{
+    audio_drain();
+}
+
+bool app_audio_is_active(void)
+{
+    return audio_env.active;
+}
+
+const struct app_audio_stats *app_audio_get_stats(void)
+{
+    return &audio_env.stats;
+}
+
+void app_audio_reset_stats(void)
+{
+    uint16_t frame_len = audio_env.stats.frame_len;
+    uint8_t slots = audio_env.stats.slots;
+
+    GLOBAL_INT_DISABLE();
+    memset(&audio_env.stats, 0, sizeof(audio_env.stats));
+    audio_env.stats.frame_len = frame_len;
+    audio_env.stats.slots = slots;
+    GLOBAL_INT_RESTORE();
+}
+
+#endif // CFG_APP_AUDIO
+
+/// @} APP
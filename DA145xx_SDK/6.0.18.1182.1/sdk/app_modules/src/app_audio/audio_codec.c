@@ -0,0 +1,244 @@
+/**
+ ****************************************************************************************
+ *
+ * @file audio_codec.c
+ *
+ * @brief PCM conditioning and IMA-ADPCM codec of the audio module.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "audio_codec.h"
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Quantizer step sizes
+static const uint16_t codec_step_table[AUDIO_CODEC_STEP_INDEX_MAX + 1] =
+{
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+/// Step index change by magnitude of the code
+static const int8_t codec_index_table[8] =
+{
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Saturate to 16 bits.
+ * @param[in] v     Value
+ * @return Value clamped to the int16_t range
+ ****************************************************************************************
+ */
+static int16_t codec_sat16(int32_t v)
+{
+    if (v > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+    if (v < INT16_MIN)
+    {
+        return INT16_MIN;
+    }
+    return (int16_t)v;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Update the state with a code, as the decoder does.
+ * @param[in,out] state    Codec state
+ * @param[in]     code     4-bit code
+ * @param[in]     vpdiff   Difference quantized by the code
+ ****************************************************************************************
+ */
+static void codec_update(struct audio_codec_state *state, uint8_t code, int32_t vpdiff)
+{
+    int16_t index = state->step_index + codec_index_table[code & 7];
+
+    state->predictor = codec_sat16((code & 8) ? state->predictor - vpdiff : state->predictor + vpdiff);
+
+    if (index < 0)
+    {
+        index = 0;
+    }
+    else if (index > AUDIO_CODEC_STEP_INDEX_MAX)
+    {
+        index = AUDIO_CODEC_STEP_INDEX_MAX;
+    }
+    state->step_index = (uint8_t)index;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Encode one sample.
+ * @param[in,out] state    Encoder state
+ * @param[in]     sample   PCM sample
+ * @return 4-bit code
+ ****************************************************************************************
+ */
+static uint8_t codec_encode_sample(struct audio_codec_state *state, int16_t sample)
+{
+    int32_t diff = (int32_t)sample - state->predictor;
+    int32_t step = codec_step_table[state->step_index];
+    int32_t vpdiff = step >> 3;
+    uint8_t code = 0;
+
+    if (diff < 0)
+    {
+        code = 8;
+        diff = -diff;
+    }
+
+    if (diff >= step)
+    {
+        code |= 4;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step)
+    {
+        code |= 2;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step)
+    {
+        code |= 1;
+        vpdiff += step;
+    }
+
+    codec_update(state, code, vpdiff);
+
+    return code;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Decode one sample.
+ * @param[in,out] state    Decoder state
+ * @param[in]     code     4-bit code
+ * @return PCM sample
+ ****************************************************************************************
+ */
+static int16_t codec_decode_sample(struct audio_codec_state *state, uint8_t code)
+{
+    int32_t step = codec_step_table[state->step_index];
+    int32_t vpdiff = step >> 3;
+
+    if (code & 4)
+    {
+        vpdiff += step;
+    }
+    if (code & 2)
+    {
+        vpdiff += step >> 1;
+    }
+    if (code & 1)
+    {
+        vpdiff += step >> 2;
+    }
+
+    codec_update(state, code, vpdiff);
+
+    return state->predictor;
+}
+
+void audio_codec_narrow(const uint32_t *src, int16_t *pcm, uint16_t n, uint8_t gain_shift)
+{
+    uint8_t shift = 16 - gain_shift;
+    uint16_t i;
+
+    for (i = 0; i < n; i++)
+    {
+        pcm[i] = codec_sat16((int32_t)src[i] >> shift);
+    }
+}
+
+uint16_t audio_codec_decimate(struct audio_codec_decim *decim, int16_t *pcm, uint16_t n)
+{
+    int16_t *h = decim->hist;
+    uint16_t i;
+    uint16_t o = 0;
+
+    // Half-band filter (-1, 0, 9, 16, 9, 0, -1) / 32, one output per two inputs
+    for (i = 0; i + 1 < n; i += 2)
+    {
+        int32_t acc;
+
+        h[0] = h[2];
+        h[1] = h[3];
+        h[2] = h[4];
+        h[3] = h[5];
+        h[4] = h[6];
+        h[5] = pcm[i];
+        h[6] = pcm[i + 1];
+
+        acc = 16 * (int32_t)h[3] + 9 * ((int32_t)h[2] + h[4]) - ((int32_t)h[0] + h[6]);
+        pcm[o++] = codec_sat16((acc + 16) >> 5);
+    }
+
+    return o;
+}
+
+void audio_codec_encode(struct audio_codec_state *state, const int16_t *pcm, uint16_t n, uint8_t *out)
+{
+    uint16_t i;
+
+    for (i = 0; i + 1 < n; i += 2)
+    {
+        uint8_t lo = codec_encode_sample(state, pcm[i]);
+        uint8_t hi = codec_encode_sample(state, pcm[i + 1]);
+
+        *out++ = lo | (hi << 4);
+    }
+}
+
+void audio_codec_decode(struct audio_codec_state *state, const uint8_t *in, uint16_t n, int16_t *pcm)
+{
+    uint16_t i;
+
+    for (i = 0; i + 1 < n; i += 2)
+    {
+        uint8_t b = *in++;
+
+        pcm[i] = codec_decode_sample(state, b & 0x0F);
+        pcm[i + 1] = codec_decode_sample(state, b >> 4);
+    }
+}
+
+/// @} APP
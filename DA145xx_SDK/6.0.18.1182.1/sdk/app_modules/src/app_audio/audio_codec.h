@@ -0,0 +1,111 @@
+/**
+ ****************************************************************************************
+ *
+ * @file audio_codec.h
+ *
+ * @brief PCM conditioning and IMA-ADPCM codec of the audio module.
+ *
+ * The functions only depend on the C library, they are also built on the host by
+ * audio_model.py.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _AUDIO_CODEC_H_
+#define _AUDIO_CODEC_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Largest step index of the IMA-ADPCM step table
+#define AUDIO_CODEC_STEP_INDEX_MAX      (88)
+
+/// Taps of the 2:1 decimation filter
+#define AUDIO_CODEC_DECIM_TAPS          (7)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// IMA-ADPCM state, the same on both sides of the link
+struct audio_codec_state
+{
+    /// Predicted sample
+    int16_t predictor;
+    /// Index in the step table
+    uint8_t step_index;
+};
+
+/// State of the 2:1 decimation filter
+struct audio_codec_decim
+{
+    /// Last input samples, oldest first
+    int16_t hist[AUDIO_CODEC_DECIM_TAPS];
+};
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Convert the words of the sample rate converter to 16-bit PCM. The sample is in
+ *        the upper bits of the word.
+ * @param[in]  src         Words read from SRC1_OUT1_REG
+ * @param[out] pcm         PCM samples, may overlay src
+ * @param[in]  n           Number of samples
+ * @param[in]  gain_shift  Gain as a left shift, 0 to 8, the result is saturated
+ ****************************************************************************************
+ */
+void audio_codec_narrow(const uint32_t *src, int16_t *pcm, uint16_t n, uint8_t gain_shift);
+
+/**
+ ****************************************************************************************
+ * @brief Halve the sample rate with a half-band filter, in place.
+ * @param[in,out] decim    Filter state, zeroed before the first call
+ * @param[in,out] pcm      Samples, the output is written over the first half
+ * @param[in]     n        Number of input samples, even
+ * @return Number of output samples, n / 2
+ ****************************************************************************************
+ */
+uint16_t audio_codec_decimate(struct audio_codec_decim *decim, int16_t *pcm, uint16_t n);
+
+/**
+ ****************************************************************************************
+ * @brief Encode PCM samples to IMA-ADPCM, two samples per byte, the first one in the low
+ *        nibble.
+ * @param[in,out] state    Encoder state
+ * @param[in]     pcm      Samples
+ * @param[in]     n        Number of samples, even
+ * @param[out]    out      n / 2 bytes
+ ****************************************************************************************
+ */
+void audio_codec_encode(struct audio_codec_state *state, const int16_t *pcm, uint16_t n, uint8_t *out);
+
+/**
+ ****************************************************************************************
+ * @brief Decode IMA-ADPCM to PCM samples.
+ * @param[in,out] state    Decoder state
+ * @param[in]     in       Codes, two per byte, the first one in the low nibble
+ * @param[in]     n        Number of samples, even
+ * @param[out]    pcm      Samples
+ ****************************************************************************************
+ */
+void audio_codec_decode(struct audio_codec_state *state, const uint8_t *in, uint16_t n, int16_t *pcm);
+
+#endif // _AUDIO_CODEC_H_
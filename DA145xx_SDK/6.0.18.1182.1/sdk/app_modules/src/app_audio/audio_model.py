@@ -0,0 +1,364 @@
+#!/usr/bin/env python3
+"""
+Host model of the audio pipeline of app_audio.c. audio_codec.c is built with the host
+compiler and called through ctypes, so the samples go through the code of the target:
+the words of the sample rate converter are narrowed, decimated if asked, encoded in
+blocks of APP_AUDIO_BLOCK_LEN samples into frames of the ATT MTU - 3, some frames are
+lost on the link, and the receiver decodes every frame from its own header.
+
+The run checks:
+
+    reference   the C encoder, decoder and decimation filter match the Python reference
+    framing     a frame decodes on its own, the sequence numbers show the lost frames
+    quality     SNR of the decoded frames against the input, per MTU
+
+The time per frame is measured on the host, it only compares the settings with each
+other and says nothing of the Cortex-M0 cycles.
+
+    audio_model.py                              synthetic speech-like signal
+    audio_model.py --wav voice.wav --mtu 247    16-bit mono WAV file
+    audio_model.py --decimation 2 --loss 5
+"""
+
+import argparse
+import ctypes
+import math
+import os
+import random
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+import wave
+
+HDR_LEN = 4
+FRAME_MIN = 20
+FRAME_MAX = 244
+
+STEPS = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+]
+INDEX = [-1, -1, -1, -1, 2, 4, 6, 8]
+
+
+class CodecState(ctypes.Structure):
+    _fields_ = [("predictor", ctypes.c_int16), ("step_index", ctypes.c_uint8)]
+
+
+class DecimState(ctypes.Structure):
+    _fields_ = [("hist", ctypes.c_int16 * 7)]
+
+
+def build_codec():
+    """Build audio_codec.c as a shared library, returns the ctypes handle."""
+    here = os.path.dirname(os.path.abspath(__file__))
+    cc = os.environ.get("CC") or shutil.which("gcc") or shutil.which("cc")
+    if cc is None:
+        sys.exit("no host C compiler found, set CC")
+    out = os.path.join(tempfile.mkdtemp(prefix="audio_model_"), "audio_codec.so")
+    subprocess.check_call([cc, "-O2", "-shared", "-fPIC", "-I", here,
+                           os.path.join(here, "audio_codec.c"), "-o", out])
+    lib = ctypes.CDLL(out)
+    lib.audio_codec_narrow.argtypes = [ctypes.POINTER(ctypes.c_uint32), ctypes.POINTER(ctypes.c_int16),
+                                       ctypes.c_uint16, ctypes.c_uint8]
+    lib.audio_codec_decimate.argtypes = [ctypes.POINTER(DecimState), ctypes.POINTER(ctypes.c_int16),
+                                         ctypes.c_uint16]
+    lib.audio_codec_decimate.restype = ctypes.c_uint16
+    lib.audio_codec_encode.argtypes = [ctypes.POINTER(CodecState), ctypes.POINTER(ctypes.c_int16),
+                                       ctypes.c_uint16, ctypes.POINTER(ctypes.c_uint8)]
+    lib.audio_codec_decode.argtypes = [ctypes.POINTER(CodecState), ctypes.POINTER(ctypes.c_uint8),
+                                       ctypes.c_uint16, ctypes.POINTER(ctypes.c_int16)]
+    return lib
+
+
+def sat16(v):
+    return max(-32768, min(32767, v))
+
+
+def ref_decode(predictor, index, codes):
+    """Python reference of audio_codec_decode(), codes are 4-bit values."""
+    out = []
+    for code in codes:
+        step = STEPS[index]
+        diff = step >> 3
+        if code & 4:
+            diff += step
+        if code & 2:
+            diff += step >> 1
+        if code & 1:
+            diff += step >> 2
+        predictor = sat16(predictor - diff if code & 8 else predictor + diff)
+        index = max(0, min(88, index + INDEX[code & 7]))
+        out.append(predictor)
+    return out, predictor, index
+
+
+def ref_encode(predictor, index, pcm):
+    """Python reference of audio_codec_encode(), returns the 4-bit codes."""
+    codes = []
+    for sample in pcm:
+        step = STEPS[index]
+        diff = sample - predictor
+        code = 0
+        if diff < 0:
+            code = 8
+            diff = -diff
+        for bit in (4, 2, 1):
+            if diff >= step:
+                code |= bit
+                diff -= step
+            step >>= 1
+        codes.append(code)
+        _, predictor, index = ref_decode(predictor, index, [code])
+    return codes, predictor, index
+
+
+def ref_decimate(hist, pcm):
+    """Python reference of audio_codec_decimate(), hist is updated in place."""
+    out = []
+    for i in range(0, len(pcm) - 1, 2):
+        hist[:] = hist[2:] + [pcm[i], pcm[i + 1]]
+        acc = 16 * hist[3] + 9 * (hist[2] + hist[4]) - (hist[0] + hist[6])
+        out.append(sat16((acc + 16) >> 5))
+    return out
+
+
+def nibbles(data):
+    codes = []
+    for b in data:
+        codes += [b & 0x0F, b >> 4]
+    return codes
+
+
+def synth(rate, seconds, seed):
+    """Speech-like test signal: voiced bursts with a wandering pitch, pauses and noise."""
+    rnd = random.Random(seed)
+    out = []
+    phase = 0.0
+    pitch = 140.0
+    amp = 0.0
+    target = 0.0
+    for n in range(int(rate * seconds)):
+        if n % (rate // 20) == 0:
+            target = rnd.choice([0.0, 0.2, 0.5, 0.8])
+            pitch = max(90.0, min(260.0, pitch + rnd.uniform(-30, 30)))
+        amp += (target - amp) * 0.002
+        phase += 2 * math.pi * pitch / rate
+        v = sum(math.sin(k * phase) / k for k in range(1, 8)) * 0.45
+        v = amp * v + rnd.gauss(0, 0.003)
+        out.append(sat16(int(v * 32767)))
+    return out
+
+
+def read_wav(path):
+    with wave.open(path, "rb") as w:
+        if w.getsampwidth() != 2:
+            sys.exit("%s: 16-bit samples only" % path)
+        rate = w.getframerate()
+        channels = w.getnchannels()
+        data = w.readframes(w.getnframes())
+    samples = struct.unpack("<%dh" % (len(data) // 2), data)
+    return list(samples[::channels]), rate
+
+
+def snr_db(ref, test):
+    sig = sum(x * x for x in ref)
+    err = sum((x - y) ** 2 for x, y in zip(ref, test))
+    if err == 0:
+        return float("inf")
+    return 10 * math.log10(max(sig, 1) / err)
+
+
+class Encoder:
+    """Mirror of audio_block() and audio_commit() with an unbounded FIFO, the link loss
+    is applied afterwards."""
+
+    def __init__(self, lib, frame_len, decimation, gain_shift):
+        self.lib = lib
+        self.frame_len = frame_len
+        self.samples = (frame_len - HDR_LEN) * 2
+        self.decimation = decimation
+        self.gain_shift = gain_shift
+        self.codec = CodecState()
+        self.decim = DecimState()
+        self.frame = None
+        self.fill = 0
+        self.seq = 0
+        self.frames = []
+        self.pcm = []
+        self.busy = 0.0
+
+    def block(self, words):
+        n = len(words)
+        src = (ctypes.c_uint32 * n)(*words)
+        pcm = (ctypes.c_int16 * n)()
+        t0 = time.perf_counter()
+        self.lib.audio_codec_narrow(src, pcm, n, self.gain_shift)
+        if self.decimation == 2:
+            n = self.lib.audio_codec_decimate(ctypes.byref(self.decim), pcm, n)
+        self.busy += time.perf_counter() - t0
+        self.pcm += list(pcm[:n])
+
+        pos = 0
+        while pos < n:
+            if self.fill == 0:
+                self.frame = (ctypes.c_uint8 * self.frame_len)()
+                self.frame[0:HDR_LEN] = list(struct.pack("<hBB", self.codec.predictor,
+                                                         self.codec.step_index, self.seq))
+            length = min(n - pos, self.samples - self.fill)
+            out = ctypes.cast(ctypes.byref(self.frame, HDR_LEN + self.fill // 2),
+                              ctypes.POINTER(ctypes.c_uint8))
+            t0 = time.perf_counter()
+            self.lib.audio_codec_encode(ctypes.byref(self.codec),
+                                        ctypes.cast(ctypes.byref(pcm, pos * 2), ctypes.POINTER(ctypes.c_int16)),
+                                        length, out)
+            self.busy += time.perf_counter() - t0
+            self.fill += length
+            pos += length
+            if self.fill == self.samples:
+                self.frames.append(bytes(self.frame))
+                self.fill = 0
+                self.seq = (self.seq + 1) & 0xFF
+
+
+def decode_frame(lib, frame):
+    predictor, index, seq = struct.unpack_from("<hBB", frame, 0)
+    n = (len(frame) - HDR_LEN) * 2
+    state = CodecState(predictor, index)
+    codes = (ctypes.c_uint8 * (len(frame) - HDR_LEN)).from_buffer_copy(frame[HDR_LEN:])
+    pcm = (ctypes.c_int16 * n)()
+    lib.audio_codec_decode(ctypes.byref(state), codes, n, pcm)
+    return seq, list(pcm)
+
+
+def run(lib, signal, args, mtu, rnd):
+    frame_len = max(FRAME_MIN, min(FRAME_MAX, mtu - 3))
+    enc = Encoder(lib, frame_len, args.decimation, args.gain_shift)
+    block = args.block_len
+    # The sample sits in the upper bits of the SRC word
+    words = [(s << 16) & 0xFFFFFFFF for s in signal]
+    for i in range(0, len(words) - block + 1, block):
+        enc.block(words[i:i + block])
+
+    failures = []
+
+    # The C encoder against the reference over the whole recording
+    codes, predictor, index = ref_encode(0, 0, enc.pcm[:len(enc.frames) * enc.samples])
+    got = []
+    for frame in enc.frames:
+        got += nibbles(frame[HDR_LEN:])
+    if codes != got:
+        failures.append("encoder differs from the reference")
+
+    # Receiver: every frame on its own, the gaps in the sequence numbers are silence
+    received = []
+    expected = 0
+    lost = 0
+    out_pcm = []
+    ref_pcm = []
+    for frame in enc.frames:
+        if rnd.random() * 100 < args.loss:
+            lost += 1
+            continue
+        seq, pcm = decode_frame(lib, frame)
+        ref, _, _ = ref_decode(struct.unpack_from("<h", frame)[0], frame[2], nibbles(frame[HDR_LEN:]))
+        if pcm != ref:
+            failures.append("decoder differs from the reference in frame %d" % seq)
+        gap = (seq - expected) & 0xFF
+        out_pcm += [0] * (gap * enc.samples)
+        expected = (seq + 1) & 0xFF
+        start = len(ref_pcm) + gap * enc.samples
+        ref_pcm += enc.pcm[len(ref_pcm):start + enc.samples]
+        out_pcm += pcm
+        received.append((start, pcm))
+
+    if len(out_pcm) != len(ref_pcm):
+        failures.append("sequence numbers lost the frame positions")
+
+    kept_ref = []
+    kept_out = []
+    for start, pcm in received:
+        kept_ref += enc.pcm[start:start + enc.samples]
+        kept_out += pcm
+
+    return {
+        "mtu": mtu,
+        "frame_len": frame_len,
+        "samples": enc.samples,
+        "frames": len(enc.frames),
+        "lost": lost,
+        "snr": snr_db(kept_ref, kept_out),
+        "snr_all": snr_db(ref_pcm, out_pcm),
+        "us_frame": 1e6 * enc.busy / max(len(enc.frames), 1),
+        "failures": failures,
+    }
+
+
+def check_decimate(lib, rnd):
+    hist = [0] * 7
+    state = DecimState()
+    for _ in range(20):
+        pcm = [rnd.randint(-32768, 32767) for _ in range(128)]
+        buf = (ctypes.c_int16 * len(pcm))(*pcm)
+        n = lib.audio_codec_decimate(ctypes.byref(state), buf, len(pcm))
+        if list(buf[:n]) != ref_decimate(hist, pcm):
+            return ["decimation differs from the reference"]
+    return []
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--wav", help="16-bit WAV file at the SRC rate, the first channel is used")
+    parser.add_argument("--rate", type=int, default=16000, help="SRC rate of the synthetic signal (Hz)")
+    parser.add_argument("--seconds", type=float, default=5.0, help="length of the synthetic signal")
+    parser.add_argument("--decimation", type=int, choices=(1, 2), default=1, help="APP_AUDIO_DECIMATION")
+    parser.add_argument("--gain-shift", type=int, default=0, help="APP_AUDIO_GAIN_SHIFT")
+    parser.add_argument("--block-len", type=int, default=128, help="APP_AUDIO_BLOCK_LEN")
+    parser.add_argument("--mtu", type=int, action="append", help="ATT MTU, may be repeated")
+    parser.add_argument("--loss", type=float, default=1.0, help="frames lost on the link (%%)")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    lib = build_codec()
+    rnd = random.Random(args.seed)
+
+    if args.wav:
+        signal, rate = read_wav(args.wav)
+    else:
+        rate = args.rate
+        signal = synth(rate, args.seconds, args.seed)
+    out_rate = rate // args.decimation
+
+    failures = check_decimate(lib, rnd)
+
+    print("input: %d samples at %d Hz, frames at %d Hz, %.1f %% loss"
+          % (len(signal), rate, out_rate, args.loss))
+    print()
+    print("%5s %6s %8s %7s %6s %9s %9s %10s %14s"
+          % ("mtu", "frame", "samples", "frames", "lost", "SNR dB", "SNR all", "bytes/s", "host us/frame"))
+    for mtu in args.mtu or [23, 185, 247]:
+        res = run(lib, signal, args, mtu, rnd)
+        failures += res["failures"]
+        print("%5d %6d %8d %7d %6d %9.1f %9.1f %10.0f %14.2f"
+              % (mtu, res["frame_len"], res["samples"], res["frames"], res["lost"], res["snr"],
+                 res["snr_all"], res["frame_len"] * out_rate / float(res["samples"]), res["us_frame"]))
+
+    print()
+    for failure in sorted(set(failures)):
+        print("FAILED: " + failure)
+    print("ok" if not failures else "FAILED")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
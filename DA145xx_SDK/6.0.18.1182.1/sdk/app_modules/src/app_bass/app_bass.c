@@ -40,6 +40,55 @@
 #include "prf.h"
 #include "user_profiles_config.h"
 
+#if defined (CFG_APP_BASS_ADAPTIVE_POLL)
+#include <stdlib.h>
+#include <string.h>
+#include "co_math.h"
+#include "ea.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Level under which the battery alert starts
+#if defined(BATTERY_ALERT_AT_PERCENTAGE_LEFT)
+#define APP_BATT_MON_ALERT_LVL      (BATTERY_ALERT_AT_PERCENTAGE_LEFT)
+#else
+#define APP_BATT_MON_ALERT_LVL      (5)
+#endif
+
+/// Fraction bits of the filtered sample
+#define APP_BATT_MON_FRAC           (8)
+
+/// Change of a sample that restarts the filter, e.g. a new battery: 200mV
+#if defined (__DA14531__)
+#define APP_BATT_MON_JUMP           (200)
+#else
+#define APP_BATT_MON_JUMP           (114)
+#endif
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Adaptive battery polling environment
+struct app_batt_mon_env_tag
+{
+    /// Statistics
+    struct app_batt_mon_stats stats;
+    /// Time polled in 10ms units
+    uint32_t elapsed;
+    /// Filtered sample with APP_BATT_MON_FRAC fraction bits, 0 before the first sample
+    int32_t filt;
+    /// Level of the previous conversion
+    uint8_t last_lvl;
+    /// Retries of the current poll
+    uint8_t retries;
+};
+#endif // CFG_APP_BASS_ADAPTIVE_POLL
+
 /*
  * VARIABLES DEFINITION
  ****************************************************************************************
@@ -53,6 +102,10 @@ uint8_t bat_lvl_alert_used    __SECTION_ZERO("retention_mem_area0"); //@RETENTIO
 GPIO_PORT bat_led_port        __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 GPIO_PIN bat_led_pin          __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
 
+#if defined (CFG_APP_BASS_ADAPTIVE_POLL)
+static struct app_batt_mon_env_tag batt_mon_env __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+#endif
+
 /*
  * FUNCTION DEFINITIONS
  ****************************************************************************************
@@ -94,6 +147,10 @@ void app_bass_create_db(void)
 
 void app_batt_init(void)
 {
+#if defined (CFG_APP_BASS_ADAPTIVE_POLL)
+    memset(&batt_mon_env, 0, sizeof(batt_mon_env));
+#endif
+
 #if !defined (__FPGA__)
     cur_batt_level = battery_get_lvl(BATT_CR2032);
 #else
@@ -132,19 +189,20 @@ void app_bass_enable(uint8_t conidx)
     app_batt_poll_start(APP_BASS_POLL_INTERVAL);
 }
 
-void app_batt_lvl(void)
+/**
+ ****************************************************************************************
+ * @brief Sends the battery level to BASS if it changed and drives the battery alert.
+ * @param[in] batt_lvl Battery level
+ ****************************************************************************************
+ */
+static void app_batt_update(uint8_t batt_lvl)
 {
-    uint8_t batt_lvl;
-
-#if !defined (__FPGA__)
-    batt_lvl = battery_get_lvl(BATT_CR2032);
-#else
-    batt_lvl = 100;
-#endif
-
     if (batt_lvl != cur_batt_level)
     {
         app_batt_set_level(batt_lvl);
+#if defined (CFG_APP_BASS_ADAPTIVE_POLL)
+        batt_mon_env.stats.updates++;
+#endif
     }
 
     //update old_batt_lvl for the next use
@@ -172,6 +230,108 @@ void app_batt_lvl(void)
 #endif //defined(BATTERY_ALERT_AT_PERCENTAGE_LEFT)
 }
 
+void app_batt_lvl(void)
+{
+    uint8_t batt_lvl;
+
+#if !defined (__FPGA__)
+    batt_lvl = battery_get_lvl(BATT_CR2032);
+#else
+    batt_lvl = 100;
+#endif
+
+    app_batt_update(batt_lvl);
+}
+
+uint8_t app_batt_get_lvl(void)
+{
+    return cur_batt_level;
+}
+
+#if defined (CFG_APP_BASS_ADAPTIVE_POLL)
+uint32_t app_batt_mon_poll(void)
+{
+    uint32_t period = batt_mon_env.stats.period;
+#if !defined (__FPGA__)
+    uint32_t sleep_duration = 0;
+    uint8_t shift = APP_BATT_MON_FILTER_SHIFT;
+    int32_t raw;
+    uint8_t batt_lvl;
+
+    // The cell drops while it supplies the radio, wait for a gap between two events
+    if (!ea_sleep_check(&sleep_duration, APP_BATT_MON_GAP_SLOTS))
+    {
+        if (batt_mon_env.retries < APP_BATT_MON_RETRY_MAX)
+        {
+            batt_mon_env.retries++;
+            batt_mon_env.stats.retries++;
+            batt_mon_env.elapsed += APP_BATT_MON_RETRY_DELAY;
+            return APP_BATT_MON_RETRY_DELAY;
+        }
+
+        // Sample anyway, with a lower weight
+        shift += APP_BATT_MON_LOAD_SHIFT;
+        batt_mon_env.stats.loaded++;
+    }
+    batt_mon_env.retries = 0;
+
+    raw = battery_get_raw(BATT_CR2032);
+    batt_mon_env.stats.conversions++;
+
+    if ((batt_mon_env.filt == 0) ||
+        ((shift == APP_BATT_MON_FILTER_SHIFT) &&
+         (abs(raw - (batt_mon_env.filt >> APP_BATT_MON_FRAC)) > APP_BATT_MON_JUMP)))
+    {
+        batt_mon_env.filt = raw << APP_BATT_MON_FRAC;
+    }
+    else
+    {
+        batt_mon_env.filt += ((raw << APP_BATT_MON_FRAC) - batt_mon_env.filt) >> shift;
+    }
+
+    batt_lvl = battery_raw_to_lvl(BATT_CR2032,
+                                  (batt_mon_env.filt + (1 << (APP_BATT_MON_FRAC - 1))) >> APP_BATT_MON_FRAC);
+
+    // A drop is reported at once, a rise only past the hysteresis
+    if ((batt_lvl < cur_batt_level) || (batt_lvl >= cur_batt_level + APP_BATT_MON_LVL_HYST))
+    {
+        app_batt_update(batt_lvl);
+    }
+
+    if (batt_lvl <= APP_BATT_MON_ALERT_LVL + APP_BATT_MON_ALERT_MARGIN)
+    {
+        period = bat_poll_timeout;
+    }
+    else if (batt_lvl != batt_mon_env.last_lvl)
+    {
+        period = co_max(period >> 1, (uint32_t)bat_poll_timeout);
+    }
+    else
+    {
+        period = co_min(period << 1, (uint32_t)bat_poll_timeout << APP_BATT_MON_MAX_SHIFT);
+    }
+    batt_mon_env.last_lvl = batt_lvl;
+#else
+    app_batt_update(100);
+#endif // __FPGA__
+
+    batt_mon_env.stats.period = period;
+    batt_mon_env.elapsed += period;
+
+    return period;
+}
+
+const struct app_batt_mon_stats *app_batt_mon_get_stats(void)
+{
+    uint32_t fixed = (bat_poll_timeout != 0) ? (batt_mon_env.elapsed / bat_poll_timeout) : 0;
+
+    batt_mon_env.stats.avoided = (fixed > batt_mon_env.stats.conversions) ?
+                                 (fixed - batt_mon_env.stats.conversions) : 0;
+
+    return &batt_mon_env.stats;
+}
+#endif // CFG_APP_BASS_ADAPTIVE_POLL
+
 void app_batt_set_level(uint8_t batt_lvl)
 {
     // Allocate the message
@@ -191,6 +351,10 @@ void app_batt_set_level(uint8_t batt_lvl)
 void app_batt_poll_start(uint16_t poll_timeout)
 {
     bat_poll_timeout = poll_timeout;
+#if defined (CFG_APP_BASS_ADAPTIVE_POLL)
+    batt_mon_env.stats.period = poll_timeout;
+    batt_mon_env.retries = 0;
+#endif
 
     app_timer_set(APP_BASS_TIMER, TASK_APP, 10);    //first poll in 100 ms
 }
@@ -86,9 +86,13 @@ static int app_bass_timer_handler(ke_msg_id_t const msgid,
                                   ke_task_id_t const dest_id,
                                   ke_task_id_t const src_id)
 {
+#if defined (CFG_APP_BASS_ADAPTIVE_POLL)
+    app_timer_set(APP_BASS_TIMER, dest_id, app_batt_mon_poll());
+#else
     app_batt_lvl();
 
     app_timer_set(APP_BASS_TIMER, dest_id, bat_poll_timeout);
+#endif
 
     return (KE_MSG_CONSUMED);
 }
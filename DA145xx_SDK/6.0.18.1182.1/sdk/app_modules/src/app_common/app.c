@@ -128,6 +128,10 @@ const struct prf_func_callbacks prf_funcs[] =
     {TASK_ID_WSSS,          app_wsss_create_db, app_wsss_enable},
 #endif
 
+#if (BLE_GL_SENSOR)
+    {TASK_ID_GLPS,          app_glps_create_db, app_glps_enable},
+#endif
+
     {TASK_ID_INVALID,       NULL, NULL},   // DO NOT MOVE. Must always be last
 };
 
@@ -186,6 +190,76 @@ static bool app_task_in_user_app(enum KE_API_ID task_id)
      return false;
 }
 
+#if defined (CFG_APP_DB_INIT_BATCH)
+/**
+ ****************************************************************************************
+ * @brief Request the databases of all the included profiles at once. They are requested
+ *        in the order of the one by one initialization, so GAPM allocates the same
+ *        attribute handles.
+ * @return Number of databases requested
+ ****************************************************************************************
+ */
+static uint8_t app_db_create_all(void)
+{
+    uint8_t nb = 0;
+    uint8_t i;
+
+    for (i = 0; user_prf_funcs[i].task_id != TASK_ID_INVALID; i++)
+    {
+        if (user_prf_funcs[i].db_create_func != NULL)
+        {
+            user_prf_funcs[i].db_create_func();
+            nb++;
+        }
+    }
+
+    for (i = 0; prf_funcs[i].task_id != TASK_ID_INVALID; i++)
+    {
+        if ((prf_funcs[i].db_create_func != NULL)
+            && (!app_task_in_user_app(prf_funcs[i].task_id)))    //case that the this task has an entry in the user_prf as well
+        {
+            prf_funcs[i].db_create_func();
+            nb++;
+        }
+    }
+
+#if (BLE_CUSTOM_SERVER)
+    for (i = 0; cust_prf_funcs[i].task_id != TASK_ID_INVALID; i++)
+    {
+        if (cust_prf_funcs[i].db_create_func != NULL)
+        {
+            cust_prf_funcs[i].db_create_func();
+            nb++;
+        }
+    }
+#endif
+
+    return nb;
+}
+
+/*
+ * With CFG_APP_DB_INIT_BATCH the first call, from app_db_init_start(), sends all the
+ * GAPM_PROFILE_TASK_ADD_CMD messages in a row and every further call, from the
+ * GAPM_PROFILE_ADDED_IND handler, counts one database added, whatever the profile.
+ * GAPM processes the commands back to back instead of waiting for the application
+ * between them, so advertising starts as soon as the last database is added.
+ */
+bool app_db_init_next(void)
+{
+    static uint8_t pending __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY;
+
+    if (pending == 0)
+    {
+        pending = app_db_create_all();
+    }
+    else
+    {
+        pending--;
+    }
+
+    return (pending == 0);
+}
+#else
 bool app_db_init_next(void)
 {
     static uint8_t i __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY;
@@ -236,6 +310,7 @@ bool app_db_init_next(void)
 
     return true;
 }
+#endif // CFG_APP_DB_INIT_BATCH
 
 #if !defined (__DA14531__) || defined (__EXCLUDE_ROM_APP_TASK__)
 bool app_db_init_start(void)
@@ -318,7 +318,12 @@ static int gapc_disconnect_ind_handler(ke_msg_id_t const msgid,
     uint8_t state = ke_state_get(dest_id);
     uint8_t conidx = KE_IDX_GET(src_id);
 
+#if (APP_EASY_MAX_ACTIVE_CONNECTION > 1)
+    // Advertising may have been restarted for a further connection
+    if ((state == APP_CONNECTED) || app_env[conidx].connection_active)
+#else
     if (state == APP_CONNECTED)
+#endif
     {
         app_env[conidx].conidx = GAP_INVALID_CONIDX;
         app_env[conidx].connection_active = false;
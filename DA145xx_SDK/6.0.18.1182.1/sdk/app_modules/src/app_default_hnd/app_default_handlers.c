@@ -153,6 +153,11 @@ void default_app_on_connection(uint8_t conidx, struct gapc_connection_req_ind co
         // Enable the created profiles/services
         app_prf_enable(conidx);
 
+        #if (BLE_APP_SEC) && defined (CFG_APP_SEC_RPA_CACHE)
+        // Resolve the peer RPA before the encryption request comes in
+        app_easy_security_rpa_prefetch(conidx);
+        #endif
+
         #if (BLE_APP_SEC)
         if (user_default_hnd_conf.security_request_scenario == DEF_SEC_REQ_ON_CONNECT)
         {
@@ -37,6 +37,55 @@
 #include "app_security.h"
 #include "user_callback_config.h"
 
+#if defined (CFG_APP_SEC_RPA_CACHE)
+#include "aes_api.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// No resolution prefetched for the connection
+#define RPA_SLOT_UNKNOWN        (0)
+/// All the stored IRKs were tried, none resolves the RPA
+#define RPA_SLOT_NOT_FOUND      (0xFF)
+/// No bond slot
+#define RPA_NO_SLOT             (0xFF)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// RPA resolved to a bond slot
+struct rpa_cache_entry
+{
+    /// Resolvable Private Address
+    struct bd_addr rpa;
+    /// Bond slot
+    uint8_t slot;
+};
+
+/// RPA resolution cache
+struct rpa_cache_env_tag
+{
+    /// Resolved RPAs, most recent first
+    struct rpa_cache_entry entries[APP_EASY_SECURITY_RPA_CACHE_SIZE];
+    /// Number of valid entries
+    uint8_t nb_entries;
+    /// Most recently used bond slots, most recent first
+    uint8_t mru[APP_EASY_SECURITY_MRU_SIZE];
+    /// Number of valid mru slots
+    uint8_t nb_mru;
+    /// Prefetched result per connection: slot + 1, RPA_SLOT_UNKNOWN or RPA_SLOT_NOT_FOUND
+    uint8_t conn_slot[APP_EASY_MAX_ACTIVE_CONNECTION];
+    /// RPA the prefetched result applies to
+    struct bd_addr conn_rpa[APP_EASY_MAX_ACTIVE_CONNECTION];
+    /// Connection of the resolution requested from GAPM
+    uint8_t gapm_conidx;
+};
+#endif // CFG_APP_SEC_RPA_CACHE
+
 /*
  * LOCAL VARIABLE DEFINITIONS
  ****************************************************************************************
@@ -49,6 +98,10 @@ static struct gapc_bond_cfm *gapc_bond_cfm_ltk_exch[APP_EASY_MAX_ACTIVE_CONNECTI
 static struct gapc_encrypt_cfm *gapc_encrypt_cfm[APP_EASY_MAX_ACTIVE_CONNECTION]        __SECTION_ZERO("retention_mem_area0");
 static struct gapc_security_cmd *gapc_security_req[APP_EASY_MAX_ACTIVE_CONNECTION]      __SECTION_ZERO("retention_mem_area0");
 
+#if defined (CFG_APP_SEC_RPA_CACHE)
+static struct rpa_cache_env_tag rpa_cache_env                                           __SECTION_ZERO("retention_mem_area0");
+#endif
+
 /*
  * FUNCTION DEFINITIONS
  ****************************************************************************************
@@ -321,6 +374,289 @@ void app_easy_security_reject_encryption(uint8_t conidx)
     app_easy_gap_disconnect(conidx);
 }
 
+#if defined (CFG_APP_SEC_RPA_CACHE)
+/**
+ ****************************************************************************************
+ * @brief Move a bond slot to the front of the most recently used list.
+ * @param[in] slot          Bond slot
+ ****************************************************************************************
+ */
+static void rpa_mru_touch(uint8_t slot)
+{
+    uint8_t i;
+
+    for (i = 0; (i < rpa_cache_env.nb_mru) && (rpa_cache_env.mru[i] != slot); i++);
+
+    if (i == rpa_cache_env.nb_mru)
+    {
+        // Not in the list, the least recently used slot drops out when the list is full
+        if (rpa_cache_env.nb_mru < APP_EASY_SECURITY_MRU_SIZE)
+        {
+            rpa_cache_env.nb_mru++;
+        }
+        else
+        {
+            i--;
+        }
+    }
+
+    memmove(&rpa_cache_env.mru[1], &rpa_cache_env.mru[0], i);
+    rpa_cache_env.mru[0] = slot;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Remember the bond slot an RPA resolves to.
+ * @param[in] rpa           Resolvable Private Address
+ * @param[in] slot          Bond slot
+ ****************************************************************************************
+ */
+static void rpa_cache_add(const struct bd_addr *rpa, uint8_t slot)
+{
+    uint8_t i;
+
+    for (i = 0; (i < rpa_cache_env.nb_entries) && memcmp(&rpa_cache_env.entries[i].rpa, rpa, BD_ADDR_LEN); i++);
+
+    if (i == rpa_cache_env.nb_entries)
+    {
+        if (rpa_cache_env.nb_entries < APP_EASY_SECURITY_RPA_CACHE_SIZE)
+        {
+            rpa_cache_env.nb_entries++;
+        }
+        else
+        {
+            i--;
+        }
+    }
+
+    memmove(&rpa_cache_env.entries[1], &rpa_cache_env.entries[0], i * sizeof(struct rpa_cache_entry));
+    rpa_cache_env.entries[0].rpa = *rpa;
+    rpa_cache_env.entries[0].slot = slot;
+
+    rpa_mru_touch(slot);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Look an RPA up in the cache.
+ * @param[in] rpa           Resolvable Private Address
+ * @return Bond slot, RPA_NO_SLOT if the RPA is not cached
+ ****************************************************************************************
+ */
+static uint8_t rpa_cache_find(const struct bd_addr *rpa)
+{
+    uint8_t i;
+
+    for (i = 0; i < rpa_cache_env.nb_entries; i++)
+    {
+        if (!memcmp(&rpa_cache_env.entries[i].rpa, rpa, BD_ADDR_LEN))
+        {
+            return rpa_cache_env.entries[i].slot;
+        }
+    }
+
+    return RPA_NO_SLOT;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Get the n-th bond slot in the order the IRKs are tried: the most recently used
+ *        slots first, then the other slots in database order.
+ * @param[in] n             Position
+ * @return Bond slot, RPA_NO_SLOT past the last slot
+ ****************************************************************************************
+ */
+static uint8_t rpa_trial_slot(uint8_t n)
+{
+    uint8_t size = app_easy_security_bdb_get_size();
+    uint8_t slot;
+    uint8_t i;
+
+    if (n < rpa_cache_env.nb_mru)
+    {
+        return rpa_cache_env.mru[n];
+    }
+
+    n -= rpa_cache_env.nb_mru;
+
+    for (slot = 0; slot < size; slot++)
+    {
+        for (i = 0; (i < rpa_cache_env.nb_mru) && (rpa_cache_env.mru[i] != slot); i++);
+
+        if ((i == rpa_cache_env.nb_mru) && (n-- == 0))
+        {
+            return slot;
+        }
+    }
+
+    return RPA_NO_SLOT;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Check whether an RPA was generated from an IRK, i.e. compute the random address
+ *        hash function ah(irk, prand) with the AES engine and compare it to the hash part
+ *        of the RPA.
+ * @param[in] irk           IRK, least significant byte first
+ * @param[in] rpa           Resolvable Private Address
+ * @return 1 if the RPA matches, 0 if not, -1 if the AES engine is in use
+ ****************************************************************************************
+ */
+static int rpa_ah_match(const uint8_t *irk, const struct bd_addr *rpa)
+{
+    AES_KEY aes_key;
+    uint8_t key[KEY_LEN];
+    uint8_t r[KEY_LEN];
+    uint8_t e[KEY_LEN];
+    uint8_t i;
+
+    // aes_api expects the most significant byte first
+    for (i = 0; i < KEY_LEN; i++)
+    {
+        key[i] = irk[KEY_LEN - 1 - i];
+    }
+
+    // r' = padding || prand
+    memset(r, 0, KEY_LEN);
+    r[KEY_LEN - 3] = rpa->addr[5];
+    r[KEY_LEN - 2] = rpa->addr[4];
+    r[KEY_LEN - 1] = rpa->addr[3];
+
+    aes_set_key(key, 128, &aes_key, AES_ENCRYPT);
+    if (aes_enc_dec(r, e, &aes_key, AES_ENCRYPT, 0) != 0)
+    {
+        return -1;
+    }
+
+    return ((e[KEY_LEN - 1] == rpa->addr[0]) &&
+            (e[KEY_LEN - 2] == rpa->addr[1]) &&
+            (e[KEY_LEN - 3] == rpa->addr[2]));
+}
+
+void app_easy_security_rpa_prefetch(uint8_t conidx)
+{
+    const struct bd_addr *rpa = &app_env[conidx].peer_addr;
+    struct gap_ral_dev_info dev_info;
+    uint8_t slot;
+    uint8_t n;
+
+    rpa_cache_env.conn_slot[conidx] = RPA_SLOT_UNKNOWN;
+
+    if (app_get_address_type(app_env[conidx].peer_addr_type, app_env[conidx].peer_addr) != APP_RANDOM_PRIVATE_RESOLV_ADDR_TYPE)
+    {
+        return;
+    }
+
+    rpa_cache_env.conn_rpa[conidx] = *rpa;
+
+    // A cached RPA needs no AES at all, its slot must still hold an IRK
+    slot = rpa_cache_find(rpa);
+    if ((slot != RPA_NO_SLOT) && app_easy_security_bdb_get_device_info_from_slot(slot, &dev_info))
+    {
+        rpa_mru_touch(slot);
+        rpa_cache_env.conn_slot[conidx] = slot + 1;
+        return;
+    }
+
+    for (n = 0; (slot = rpa_trial_slot(n)) != RPA_NO_SLOT; n++)
+    {
+        int match;
+
+        if (!app_easy_security_bdb_get_device_info_from_slot(slot, &dev_info))
+        {
+            continue;
+        }
+
+        match = rpa_ah_match(dev_info.peer_irk, rpa);
+        if (match < 0)
+        {
+            // The link layer uses the engine, GAPM resolves the address later on
+            return;
+        }
+
+        if (match)
+        {
+            rpa_cache_add(rpa, slot);
+            rpa_cache_env.conn_slot[conidx] = slot + 1;
+            return;
+        }
+    }
+
+    rpa_cache_env.conn_slot[conidx] = RPA_SLOT_NOT_FOUND;
+}
+
+uint8_t app_easy_security_rpa_solved(struct gapm_addr_solved_ind const *param)
+{
+    uint8_t conidx = rpa_cache_env.gapm_conidx;
+    uint8_t size = app_easy_security_bdb_get_size();
+    struct gap_ral_dev_info dev_info;
+    uint8_t slot;
+
+    for (slot = 0; slot < size; slot++)
+    {
+        if (app_easy_security_bdb_get_device_info_from_slot(slot, &dev_info) &&
+            !memcmp(dev_info.peer_irk, param->irk.key, KEY_LEN))
+        {
+            rpa_cache_add(&param->addr, slot);
+            break;
+        }
+    }
+
+    return conidx;
+}
+
+void app_easy_security_rpa_cache_clear(void)
+{
+    uint8_t i;
+
+    rpa_cache_env.nb_entries = 0;
+
+    for (i = 0; i < APP_EASY_MAX_ACTIVE_CONNECTION; i++)
+    {
+        rpa_cache_env.conn_slot[i] = RPA_SLOT_UNKNOWN;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Deliver the resolution prefetched at connection time, as GAPM would.
+ * @param[in] conidx        Connection Id index
+ * @return false if no resolution was prefetched for the peer address
+ ****************************************************************************************
+ */
+static bool rpa_prefetched_result(uint8_t conidx)
+{
+    uint8_t conn_slot = rpa_cache_env.conn_slot[conidx];
+    struct gap_ral_dev_info dev_info;
+    struct gapm_addr_solved_ind ind;
+
+    rpa_cache_env.conn_slot[conidx] = RPA_SLOT_UNKNOWN;
+
+    if ((conn_slot == RPA_SLOT_UNKNOWN) ||
+        memcmp(&rpa_cache_env.conn_rpa[conidx], &app_env[conidx].peer_addr, BD_ADDR_LEN))
+    {
+        return false;
+    }
+
+    if (conn_slot == RPA_SLOT_NOT_FOUND)
+    {
+        CALLBACK_ARGS_1(user_app_callbacks.app_on_addr_resolve_failed, conidx)
+        return true;
+    }
+
+    if (!app_easy_security_bdb_get_device_info_from_slot(conn_slot - 1, &dev_info))
+    {
+        return false;
+    }
+
+    ind.addr = app_env[conidx].peer_addr;
+    memcpy(ind.irk.key, dev_info.peer_irk, KEY_LEN);
+    CALLBACK_ARGS_2(user_app_callbacks.app_on_addr_solved_ind, conidx, &ind)
+
+    return true;
+}
+#endif // CFG_APP_SEC_RPA_CACHE
+
 uint8_t app_easy_security_resolve_bdaddr(uint8_t conidx)
 {
     uint8_t nb_key = 0;
@@ -328,6 +664,13 @@ uint8_t app_easy_security_resolve_bdaddr(uint8_t conidx)
     // Get the number of stored IRKs in Bond Database
     nb_key = app_easy_security_bdb_get_number_of_stored_irks();
 
+#if defined (CFG_APP_SEC_RPA_CACHE)
+    if (nb_key && rpa_prefetched_result(conidx))
+    {
+        return nb_key;
+    }
+#endif
+
     if(nb_key)
     {
         struct gapm_resolv_addr_cmd *cmd = KE_MSG_ALLOC_DYN(GAPM_RESOLV_ADDR_CMD,
@@ -341,8 +684,28 @@ uint8_t app_easy_security_resolve_bdaddr(uint8_t conidx)
         // RPA to resolve
         memcpy( &cmd->addr, app_env[conidx].peer_addr.addr, BD_ADDR_LEN);
 
+#if defined (CFG_APP_SEC_RPA_CACHE)
+        {
+            struct gap_ral_dev_info dev_info;
+            uint8_t slot;
+            uint8_t n;
+            uint8_t i = 0;
+
+            // GAPM tries the IRKs in order, the most recently used bonds first
+            for (n = 0; ((slot = rpa_trial_slot(n)) != RPA_NO_SLOT) && (i < nb_key); n++)
+            {
+                if (app_easy_security_bdb_get_device_info_from_slot(slot, &dev_info))
+                {
+                    memcpy(cmd->irk[i++].key, dev_info.peer_irk, KEY_LEN);
+                }
+            }
+            cmd->nb_key = i;
+            rpa_cache_env.gapm_conidx = conidx;
+        }
+#else
         // Get the valid IRKs from Bond Database
         app_easy_security_bdb_get_stored_irks(cmd->irk);
+#endif
 
         // Send the message
         ke_msg_send(cmd);
@@ -395,6 +758,9 @@ void app_easy_security_ral_op(enum app_ral_operations ral_op, struct gap_ral_dev
 
 void app_easy_security_bdb_init(void)
 {
+#if defined (CFG_APP_SEC_RPA_CACHE)
+    app_easy_security_rpa_cache_clear();
+#endif
     CALLBACK_ARGS_0(user_app_bond_db_callbacks.app_bdb_init)
 }
 
@@ -409,12 +775,19 @@ uint8_t app_easy_security_bdb_get_size(void)
 
 void app_easy_security_bdb_add_entry(struct app_sec_bond_data_env_tag *data)
 {
+#if defined (CFG_APP_SEC_RPA_CACHE)
+    // The entry may overwrite the slot of a cached RPA
+    app_easy_security_rpa_cache_clear();
+#endif
     CALLBACK_ARGS_1(user_app_bond_db_callbacks.app_bdb_add_entry, data)
 }
 
 void app_easy_security_bdb_remove_entry(enum bdb_search_by_type search_type, enum bdb_remove_type remove_type,
                                         void *search_param, uint8_t search_param_length)
 {
+#if defined (CFG_APP_SEC_RPA_CACHE)
+    app_easy_security_rpa_cache_clear();
+#endif
     CALLBACK_ARGS_4(user_app_bond_db_callbacks.app_bdb_remove_entry, search_type, remove_type, search_param, search_param_length)
 }
 
@@ -0,0 +1,540 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_encoder.c
+ *
+ * @brief Quadrature encoder to relative motion reports.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "rwip_config.h"     // SW configuration
+#include "app_encoder.h"
+
+#if defined (CFG_APP_ENCODER)
+#include <string.h>
+#include <stdlib.h>
+#include "arch_api.h"
+#include "ke_msg.h"
+#include "app_easy_timer.h"
+#include "app_easy_msg_utils.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+#if defined (__DA14531__)
+#define ENCODER_WKUP_ENABLE(sel, pol)       wkupct2_enable_irq((sel), (pol), 1, APP_ENCODER_WKUP_DEB_TIME)
+#define ENCODER_WKUP_DISABLE()              wkupct2_disable_irq()
+#define ENCODER_WKUP_REGISTER(cb)           wkupct2_register_callback(cb)
+#else
+#define ENCODER_WKUP_ENABLE(sel, pol)       wkupct_enable_irq((sel), (pol), 1, APP_ENCODER_WKUP_DEB_TIME)
+#define ENCODER_WKUP_DISABLE()              wkupct_disable_irq()
+#define ENCODER_WKUP_REGISTER(cb)           wkupct_register_callback(cb)
+#endif
+
+// The callback and the pins of the wakeup interrupt would be taken over by the other module
+#if defined (CFG_APP_KEY_MATRIX)
+#error "CFG_APP_ENCODER and CFG_APP_KEY_MATRIX use the same wakeup interrupt"
+#endif
+
+#if !defined (__DA14531__) && defined (CFG_UART2_WAKEUP)
+#error "CFG_APP_ENCODER and CFG_UART2_WAKEUP use the same wakeup interrupt on the DA14585/586"
+#endif
+
+/// Decoder channels
+enum encoder_ch
+{
+    ENCODER_CH_X,
+    ENCODER_CH_Y,
+    ENCODER_CH_Z,
+    ENCODER_CH_NB,
+};
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Encoder environment
+struct encoder_env_tag
+{
+    /// Encoder configuration
+    const struct app_encoder_cfg *cfg;
+    /// Counter values at the last read
+    int16_t last[ENCODER_CH_NB];
+    /// Counts read but not reported yet
+    int32_t pending[ENCODER_CH_NB];
+    /// Motion carried over to the next report, Q8
+    int32_t residual[ENCODER_CH_NB];
+    /// Statistics
+    struct app_encoder_stats stats;
+    /// Message sent from the decoder interrupt to read the counters
+    ke_msg_id_t read_msg;
+    /// Message sent from the wakeup interrupt to start the decoder
+    ke_msg_id_t start_msg;
+    /// Idle timer
+    timer_hnd timer;
+    /// Pin levels armed on the wakeup controller, one bit per pin
+    uint8_t levels;
+    /// True while the decoder counts
+    bool active;
+    /// True from a report sent to app_encoder_report_done()
+    bool in_flight;
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static struct encoder_env_tag encoder_env __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+static void encoder_start(void);
+
+/**
+ ****************************************************************************************
+ * @brief Read the decoder counters and add their change to the pending counts.
+ * @return true if a counter has changed
+ ****************************************************************************************
+ */
+static bool encoder_read(void)
+{
+    int16_t cnt[ENCODER_CH_NB];
+    bool moved = false;
+    uint8_t ch;
+
+    cnt[ENCODER_CH_X] = quad_decoder_get_x_counter();
+    cnt[ENCODER_CH_Y] = quad_decoder_get_y_counter();
+    cnt[ENCODER_CH_Z] = quad_decoder_get_z_counter();
+
+    for (ch = 0; ch < ENCODER_CH_NB; ch++)
+    {
+        // The counters wrap around, the difference is taken modulo 2^16
+        int16_t delta = (int16_t)(uint16_t)((uint16_t)cnt[ch] - (uint16_t)encoder_env.last[ch]);
+
+        if (delta != 0)
+        {
+            encoder_env.last[ch] = cnt[ch];
+            encoder_env.pending[ch] += delta;
+            encoder_env.stats.counts[ch] += delta;
+            moved = true;
+        }
+    }
+
+    return moved;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Get the gain of an acceleration curve.
+ * @param[in] curve     Acceleration curve, NULL for unity gain
+ * @param[in] speed     Motion of the report, in counts
+ * @return Gain, APP_ENCODER_GAIN_ONE for 1.0
+ ****************************************************************************************
+ */
+static uint16_t encoder_gain(const struct app_encoder_curve *curve, uint32_t speed)
+{
+    const struct app_encoder_accel *p;
+    uint8_t i;
+
+    if ((curve == NULL) || (curve->nb_points == 0))
+    {
+        return APP_ENCODER_GAIN_ONE;
+    }
+
+    p = curve->points;
+    if (speed <= p[0].speed)
+    {
+        return p[0].gain;
+    }
+
+    for (i = 1; i < curve->nb_points; i++)
+    {
+        if (speed < p[i].speed)
+        {
+            return (uint16_t)(p[i - 1].gain + ((int32_t)p[i].gain - p[i - 1].gain) *
+                              (int32_t)(speed - p[i - 1].speed) / (p[i].speed - p[i - 1].speed));
+        }
+    }
+
+    return p[curve->nb_points - 1].gain;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Scale the pending counts of a channel.
+ * @param[in]  ch       Channel
+ * @param[in]  gain     Gain, APP_ENCODER_GAIN_ONE for 1.0
+ * @param[in]  max      Range of the report
+ * @param[out] residual Motion left for the next report, Q8
+ * @return Motion of the report
+ ****************************************************************************************
+ */
+static int32_t encoder_scale(uint8_t ch, uint16_t gain, int32_t max, int32_t *residual)
+{
+    int32_t acc = encoder_env.residual[ch] + encoder_env.pending[ch] * gain;
+    // Rounded towards zero, the residual keeps the sign of the motion
+    int32_t out = acc / APP_ENCODER_GAIN_ONE;
+
+    if (out > max)
+    {
+        out = max;
+    }
+    else if (out < -max)
+    {
+        out = -max;
+    }
+
+    *residual = acc - out * APP_ENCODER_GAIN_ONE;
+
+    return out;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Send the motion gathered since the last report, unless a report is in flight.
+ ****************************************************************************************
+ */
+static void encoder_flush(void)
+{
+    const struct app_encoder_cfg *cfg = encoder_env.cfg;
+    int32_t residual[ENCODER_CH_NB];
+    int32_t out[ENCODER_CH_NB];
+    uint32_t speed;
+
+    if (encoder_env.in_flight)
+    {
+        return;
+    }
+
+    speed = (uint32_t)abs(encoder_env.pending[ENCODER_CH_X]);
+    if ((uint32_t)abs(encoder_env.pending[ENCODER_CH_Y]) > speed)
+    {
+        speed = (uint32_t)abs(encoder_env.pending[ENCODER_CH_Y]);
+    }
+
+    out[ENCODER_CH_X] = encoder_scale(ENCODER_CH_X, encoder_gain(cfg->xy_curve, speed),
+                                      APP_ENCODER_XY_MAX, &residual[ENCODER_CH_X]);
+    out[ENCODER_CH_Y] = encoder_scale(ENCODER_CH_Y, encoder_gain(cfg->xy_curve, speed),
+                                      APP_ENCODER_XY_MAX, &residual[ENCODER_CH_Y]);
+    out[ENCODER_CH_Z] = encoder_scale(ENCODER_CH_Z, encoder_gain(cfg->z_curve, abs(encoder_env.pending[ENCODER_CH_Z])),
+                                      APP_ENCODER_Z_MAX, &residual[ENCODER_CH_Z]);
+
+    // Only fractions of a count, they wait for more motion
+    if ((out[ENCODER_CH_X] == 0) && (out[ENCODER_CH_Y] == 0) && (out[ENCODER_CH_Z] == 0))
+    {
+        memcpy(encoder_env.residual, residual, sizeof(residual));
+        memset(encoder_env.pending, 0, sizeof(encoder_env.pending));
+        return;
+    }
+
+    // On failure the counts stay pending and are scaled again with the next motion
+    if (!cfg->send((int16_t)out[ENCODER_CH_X], (int16_t)out[ENCODER_CH_Y], (int8_t)out[ENCODER_CH_Z]))
+    {
+        return;
+    }
+
+    memcpy(encoder_env.residual, residual, sizeof(residual));
+    memset(encoder_env.pending, 0, sizeof(encoder_env.pending));
+    encoder_env.in_flight = true;
+    encoder_env.stats.reports++;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Check if some motion is left to report.
+ * @return true if counts are pending or the residual holds a whole count
+ ****************************************************************************************
+ */
+static bool encoder_motion_left(void)
+{
+    uint8_t ch;
+
+    for (ch = 0; ch < ENCODER_CH_NB; ch++)
+    {
+        if ((encoder_env.pending[ch] != 0) || (abs(encoder_env.residual[ch]) >= APP_ENCODER_GAIN_ONE))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Read the pin levels.
+ * @return Pins at high level, one bit per pin
+ ****************************************************************************************
+ */
+static uint8_t encoder_read_pins(void)
+{
+    const struct app_encoder_cfg *cfg = encoder_env.cfg;
+    uint8_t levels = 0;
+    uint8_t i;
+
+    for (i = 0; i < cfg->nb_pins; i++)
+    {
+        if (GPIO_GetPinStatus(cfg->pins[i].port, cfg->pins[i].pin))
+        {
+            levels |= (1 << i);
+        }
+    }
+
+    return levels;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Arm the pins on the wakeup controller, each one on the level opposite to its
+ *        current level.
+ * @return false if a pin has changed meanwhile, the decoder must be started
+ ****************************************************************************************
+ */
+static bool encoder_arm(void)
+{
+    const struct app_encoder_cfg *cfg = encoder_env.cfg;
+    uint32_t sel = 0;
+    uint32_t pol = 0;
+    uint8_t i;
+
+    encoder_env.levels = encoder_read_pins();
+
+    for (i = 0; i < cfg->nb_pins; i++)
+    {
+        sel |= WKUPCT_PIN_SELECT(cfg->pins[i].port, cfg->pins[i].pin);
+        if (encoder_env.levels & (1 << i))
+        {
+            pol |= WKUPCT_PIN_POLARITY(cfg->pins[i].port, cfg->pins[i].pin, WKUPCT_PIN_POLARITY_LOW);
+        }
+    }
+
+    ENCODER_WKUP_ENABLE(sel, pol);
+
+    // An edge between the read and the arming is not seen by the wakeup controller
+    if (encoder_read_pins() != encoder_env.levels)
+    {
+        ENCODER_WKUP_DISABLE();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Release the decoder and arm the pins, once the motion has been reported.
+ ****************************************************************************************
+ */
+static void encoder_stop(void)
+{
+    quad_decoder_release();
+    encoder_env.active = false;
+    arch_restore_sleep_mode();
+
+    if (!encoder_arm())
+    {
+        encoder_start();
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Idle timer callback. A report whose completion was never told, e.g. when the
+ *        link is lost, does not hold the motion any longer.
+ ****************************************************************************************
+ */
+static void encoder_idle(void)
+{
+    encoder_env.timer = EASY_TIMER_INVALID_TIMER;
+
+    // Counts below the interrupt threshold
+    encoder_read();
+
+    if (encoder_motion_left())
+    {
+        encoder_env.in_flight = false;
+        encoder_flush();
+        encoder_env.timer = app_easy_timer(APP_ENCODER_IDLE_TIME, encoder_idle);
+        return;
+    }
+
+    encoder_stop();
+}
+
+/**
+ ****************************************************************************************
+ * @brief Read the counters after a decoder interrupt, in the kernel context.
+ ****************************************************************************************
+ */
+static void encoder_irq_read(void)
+{
+    if (!encoder_env.active)
+    {
+        return;
+    }
+
+    quad_decoder_enable_irq(APP_ENCODER_IRQ_EVENTS);
+
+    if (encoder_read())
+    {
+        if (encoder_env.timer != EASY_TIMER_INVALID_TIMER)
+        {
+            encoder_env.timer = app_easy_timer_modify(encoder_env.timer, APP_ENCODER_IDLE_TIME);
+        }
+        encoder_flush();
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Quadrature decoder interrupt callback. The interrupt is already masked.
+ ****************************************************************************************
+ */
+static void encoder_qdec_cb(int16_t qdec_xcnt_reg, int16_t qdec_ycnt_reg, int16_t qdec_zcnt_reg)
+{
+    encoder_env.stats.irqs++;
+    ke_msg_send_basic(encoder_env.read_msg, TASK_APP, 0);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Start the decoder and keep the system out of sleep while it counts.
+ ****************************************************************************************
+ */
+static void encoder_start(void)
+{
+    if (encoder_env.active)
+    {
+        return;
+    }
+
+    quad_decoder_init(&encoder_env.cfg->qdec);
+    encoder_env.last[ENCODER_CH_X] = quad_decoder_get_x_counter();
+    encoder_env.last[ENCODER_CH_Y] = quad_decoder_get_y_counter();
+    encoder_env.last[ENCODER_CH_Z] = quad_decoder_get_z_counter();
+
+    quad_decoder_register_callback(encoder_qdec_cb);
+    quad_decoder_enable_irq(APP_ENCODER_IRQ_EVENTS);
+
+    arch_force_active_mode();
+    encoder_env.active = true;
+    encoder_env.stats.wakeups++;
+
+    encoder_env.timer = app_easy_timer(APP_ENCODER_IDLE_TIME, encoder_idle);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Wakeup controller interrupt callback. The interrupt is already disabled.
+ ****************************************************************************************
+ */
+static void encoder_wkup_cb(void)
+{
+    arch_ble_force_wakeup();
+    ke_msg_send_basic(encoder_env.start_msg, TASK_APP, 0);
+}
+
+void app_encoder_init(const struct app_encoder_cfg *cfg)
+{
+    ke_msg_id_t read_msg = encoder_env.read_msg;
+    ke_msg_id_t start_msg = encoder_env.start_msg;
+
+    ASSERT_WARNING((cfg->nb_pins > 0) && (cfg->nb_pins <= APP_ENCODER_MAX_PINS));
+
+    if (encoder_env.timer != EASY_TIMER_INVALID_TIMER)
+    {
+        app_easy_timer_cancel(encoder_env.timer);
+    }
+
+    if (encoder_env.active)
+    {
+        quad_decoder_release();
+        arch_restore_sleep_mode();
+    }
+
+    memset(&encoder_env, 0, sizeof(struct encoder_env_tag));
+    encoder_env.cfg = cfg;
+    // The message callbacks are kept when the encoder is started again
+    encoder_env.read_msg = (read_msg != 0) ? read_msg : app_easy_msg_set(encoder_irq_read);
+    encoder_env.start_msg = (start_msg != 0) ? start_msg : app_easy_msg_set(encoder_start);
+
+    app_encoder_set_pads();
+
+    ENCODER_WKUP_REGISTER(encoder_wkup_cb);
+
+    if (!encoder_arm())
+    {
+        encoder_start();
+    }
+}
+
+void app_encoder_set_pads(void)
+{
+    const struct app_encoder_cfg *cfg = encoder_env.cfg;
+    uint8_t i;
+
+    if (cfg == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < cfg->nb_pins; i++)
+    {
+        GPIO_ConfigurePin(cfg->pins[i].port, cfg->pins[i].pin, INPUT_PULLUP, PID_GPIO, false);
+    }
+}
+
+void app_encoder_report_done(void)
+{
+    if (encoder_env.cfg == NULL)
+    {
+        return;
+    }
+
+    encoder_env.in_flight = false;
+
+    if (encoder_env.active)
+    {
+        encoder_read();
+    }
+
+    encoder_flush();
+}
+
+bool app_encoder_is_active(void)
+{
+    return encoder_env.active;
+}
+
+const struct app_encoder_stats *app_encoder_get_stats(void)
+{
+    return &encoder_env.stats;
+}
+
+#endif // CFG_APP_ENCODER
+
+/// @} APP
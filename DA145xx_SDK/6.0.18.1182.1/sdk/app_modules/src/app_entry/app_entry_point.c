@@ -94,6 +94,14 @@
 #include "app_wsss_task.h"
 #endif
 
+#if ((BLE_GL_SENSOR) && (!EXCLUDE_DLG_GLPS))
+#include "app_glps_task.h"
+#endif
+
+#if ((BLE_APP_LECB) && (!EXCLUDE_DLG_LECB))
+#include "app_lecb_task.h"
+#endif
+
 /*
  * GLOBAL VARIABLES DEFINITION
  ****************************************************************************************
@@ -101,6 +109,11 @@
 
 const process_event_func_t app_process_handlers[] = {
 
+// Ahead of the GAP process handler, which completes every GAPC_CMP_EVT
+#if ((BLE_APP_LECB) && (!EXCLUDE_DLG_LECB))
+    (process_event_func_t) app_lecb_process_handler,
+#endif
+
 #if (!EXCLUDE_DLG_GAP)
     (process_event_func_t) app_gap_process_handler,
 #endif
@@ -171,6 +184,9 @@ const process_event_func_t app_process_handlers[] = {
 #if ((BLE_WSS_SERVER) && (!EXCLUDE_DLG_WSSS))
     (process_event_func_t) app_wsss_process_handler,
 #endif
+#if ((BLE_GL_SENSOR) && (!EXCLUDE_DLG_GLPS))
+    (process_event_func_t) app_glps_process_handler,
+#endif
 #if ((BLE_GATT_CLIENT) && (!EXCLUDE_DLG_GATTC))
     (process_event_func_t) app_gattc_process_handler,
 #endif
@@ -0,0 +1,1240 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_glps.c
+ *
+ * @brief Glucose Profile Sensor application.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "rwip_config.h"     // SW configuration
+
+#if (BLE_APP_PRESENT)
+
+#if (BLE_GL_SENSOR)
+#include <string.h>
+#include <stddef.h>
+#include "app.h"
+#include "app_task.h"
+#include "app_glps.h"
+#include "app_prf_perm_types.h"
+#include "prf_utils.h"
+#include "co_math.h"
+#include "spi_flash.h"
+
+#include "glps.h"
+#include "glps_task.h"
+
+/*
+ * Record store layout
+ *
+ * APP_GLPS_STORE_SECTORS sectors starting at APP_GLPS_STORE_OFFSET used as a ring. A sector
+ * in use starts with {u32 magic, u16 first_seq, u16 reserved} followed by fixed-size
+ * records, the record in slot i holds sequence number first_seq + i, so sequence numbers
+ * increase along the ring from the oldest sector. A record is programmed with its state
+ * byte still erased, the state is programmed to WRITTEN afterwards and to DELETED when the
+ * record is deleted. A record that is neither WRITTEN nor DELETED was torn by a reset and
+ * is skipped, as is an erased slot followed by used ones. The magic of a sector header is
+ * programmed last. When the newest sector is full the next one is erased, dropping the
+ * oldest sector if the ring is full.
+ *
+ * A sparse index in retention memory keeps, per sector, the first sequence number, the
+ * number of slots used, a bitmap of the live records and the range of their user facing
+ * times. A sequence number is located by a binary search on the sectors, a time by
+ * skipping the sectors whose range does not overlap and by a binary search in the
+ * sectors whose records were stored in chronological order. Counting records only reads
+ * the flash for sectors that are neither skipped nor fully matched and are not sorted.
+ */
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+#define GLPS_STORE_MAGIC            (0x53504C47)    // "GLPS"
+#define GLPS_STORE_HDR_LEN          (sizeof(struct glps_store_hdr))
+#define GLPS_STORE_REC_LEN          (sizeof(struct glps_store_rec))
+#define GLPS_STORE_RECS             ((SPI_FLASH_SECTOR_SIZE - GLPS_STORE_HDR_LEN) / GLPS_STORE_REC_LEN)
+
+/// Record states
+#define GLPS_STORE_REC_WRITTEN      (0xA5)
+#define GLPS_STORE_REC_DELETED      (0x00)
+
+/// Times are counted in seconds from 2000-01-01 00:00:00
+#define GLPS_STORE_BASE_YEAR        (2000)
+#define GLPS_STORE_MAX_YEARS        (135)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Sector header
+struct glps_store_hdr
+{
+    /// GLPS_STORE_MAGIC
+    uint32_t magic;
+    /// Sequence number of the first slot
+    uint16_t first_seq;
+    /// Left erased
+    uint16_t reserved;
+};
+
+/// Record
+struct glps_store_rec
+{
+    /// GLPS_STORE_REC_WRITTEN or GLPS_STORE_REC_DELETED
+    uint8_t state;
+    /// Non-zero if ctx is valid
+    uint8_t ctx_present;
+    /// Sequence number
+    uint16_t seq_num;
+    /// Glucose measurement
+    struct glp_meas meas;
+    /// Glucose measurement context
+    struct glp_meas_ctx ctx;
+};
+
+/// Sparse index entry, one per sector
+struct glps_store_idx
+{
+    /// Smallest and largest user facing time of the live records
+    uint32_t min_time;
+    uint32_t max_time;
+    /// User facing time of the last record written
+    uint32_t last_time;
+    /// Sequence number of the first slot
+    uint16_t first_seq;
+    /// Slots used
+    uint8_t used;
+    /// Live records
+    uint8_t live;
+    /// True if the user facing times do not decrease along the slots used
+    bool sorted;
+    /// Live record bitmap
+    uint8_t live_map[(GLPS_STORE_RECS + 7) / 8];
+};
+
+/// Record store environment
+struct glps_store_env_tag
+{
+    /// Index of each sector
+    struct glps_store_idx idx[APP_GLPS_STORE_SECTORS];
+    /// Sector holding the oldest records
+    uint8_t oldest;
+    /// Sectors in use, from the oldest one
+    uint8_t nb_sectors;
+    /// Sequence number of the next record
+    uint16_t next_seq;
+    /// Live records
+    uint16_t count;
+    /// True once the flash has been scanned
+    bool init_done;
+};
+
+/// Records selected by a RACP filter, bounds are inclusive
+struct glps_store_query
+{
+    /// GLP_FILTER_SEQ_NUMBER or GLP_FILTER_USER_FACING_TIME
+    uint8_t filter_type;
+    /// Smallest sequence number or time
+    uint32_t min;
+    /// Largest sequence number or time
+    uint32_t max;
+};
+
+/// Application environment
+struct app_glps_env_tag
+{
+    /// Client configuration restored when the service is enabled
+    uint16_t initial_evt_cfg;
+    /// Client configuration of the connection
+    uint16_t evt_cfg;
+    /// Records being reported
+    struct glps_store_query query;
+    /// Smallest sequence number of the next record to report
+    uint32_t report_seq;
+    /// True while records are being reported
+    bool reporting;
+};
+
+/*
+ * LOCAL VARIABLES DEFINITION
+ ****************************************************************************************
+ */
+
+static struct glps_store_env_tag glps_store_env __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+static struct app_glps_env_tag app_glps_env     __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/*
+ * RECORD STORE
+ ****************************************************************************************
+ */
+
+static void glps_store_flash_open(void)
+{
+    uint8_t dev_id;
+
+    spi_flash_release_from_power_down();
+    spi_flash_configure_memory_protection(SPI_FLASH_MEM_PROT_NONE);
+    spi_flash_auto_detect(&dev_id);
+}
+
+static void glps_store_flash_close(void)
+{
+    spi_flash_power_down();
+}
+
+static bool glps_store_read(uint32_t addr, void *buf, uint32_t len)
+{
+    uint32_t actual_size;
+
+    return (spi_flash_read_data(buf, addr, len, &actual_size) == SPI_FLASH_ERR_OK) &&
+           (actual_size == len);
+}
+
+static bool glps_store_write(uint32_t addr, void *buf, uint32_t len)
+{
+    uint32_t actual_size;
+
+    return (spi_flash_write_data(buf, addr, len, &actual_size) == SPI_FLASH_ERR_OK) &&
+           (actual_size == len);
+}
+
+static uint32_t glps_store_sector_addr(uint8_t sector)
+{
+    return APP_GLPS_STORE_OFFSET + (uint32_t)sector * SPI_FLASH_SECTOR_SIZE;
+}
+
+static uint32_t glps_store_rec_addr(uint8_t sector, uint8_t slot)
+{
+    return glps_store_sector_addr(sector) + GLPS_STORE_HDR_LEN + (uint32_t)slot * GLPS_STORE_REC_LEN;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Physical sector of a sector in use.
+ * @param[in] order Position of the sector in the ring, 0 for the oldest
+ * @return Sector
+ ****************************************************************************************
+ */
+static uint8_t glps_store_sector(uint8_t order)
+{
+    return (glps_store_env.oldest + order) % APP_GLPS_STORE_SECTORS;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Converts a date to seconds since GLPS_STORE_BASE_YEAR. Dates are clamped to
+ *        the years that fit, only the RACP filter order matters.
+ ****************************************************************************************
+ */
+static uint32_t glps_store_date_time(const struct prf_date_time *date)
+{
+    static const uint16_t month_days[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+    uint32_t year = 0;
+    uint32_t month = 0;
+    uint32_t days;
+
+    if (date->year > GLPS_STORE_BASE_YEAR)
+    {
+        year = co_min(date->year - GLPS_STORE_BASE_YEAR, GLPS_STORE_MAX_YEARS);
+    }
+
+    if ((date->month >= 1) && (date->month <= 12))
+    {
+        month = date->month - 1;
+    }
+
+    // (year + 3) / 4 leap days before this year, the base year being a leap year
+    days = year * 365 + (year + 3) / 4 + month_days[month] + ((date->day > 0) ? (date->day - 1) : 0);
+
+    if (((year % 4) == 0) && (month >= 2))
+    {
+        days++;
+    }
+
+    return ((days * 24 + date->hour) * 60 + date->min) * 60 + date->sec;
+}
+
+/**
+ ****************************************************************************************
+ * @brief User facing time of a measurement, the base time plus the time offset.
+ ****************************************************************************************
+ */
+static uint32_t glps_store_meas_time(const struct glp_meas *meas)
+{
+    int32_t time = (int32_t)glps_store_date_time(&meas->base_time);
+
+    if (meas->flags & GLP_MEAS_TIME_OFF_PRES)
+    {
+        time += (int32_t)meas->time_offset * 60;
+    }
+
+    return (time > 0) ? (uint32_t)time : 0;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Reads the user facing time of a record.
+ ****************************************************************************************
+ */
+static uint32_t glps_store_rec_time(uint8_t sector, uint8_t slot)
+{
+    struct glp_meas meas;
+
+    if (!glps_store_read(glps_store_rec_addr(sector, slot) + offsetof(struct glps_store_rec, meas),
+                         &meas, sizeof(meas)))
+    {
+        return 0;
+    }
+
+    return glps_store_meas_time(&meas);
+}
+
+static bool glps_store_is_live(const struct glps_store_idx *idx, uint8_t slot)
+{
+    return (idx->live_map[slot >> 3] & (1 << (slot & 7))) != 0;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Counts the live records of a sector in a range of slots.
+ * @param[in] idx Sector index
+ * @param[in] lo  First slot
+ * @param[in] hi  Slot following the last one
+ * @return Number of live records
+ ****************************************************************************************
+ */
+static uint8_t glps_store_live_cnt(const struct glps_store_idx *idx, uint8_t lo, uint8_t hi)
+{
+    uint8_t cnt = 0;
+
+    while (lo < hi)
+    {
+        if (((lo & 7) == 0) && ((hi - lo) >= 8))
+        {
+            uint8_t bits = idx->live_map[lo >> 3];
+
+            bits = bits - ((bits >> 1) & 0x55);
+            bits = (bits & 0x33) + ((bits >> 2) & 0x33);
+            cnt += (bits + (bits >> 4)) & 0x0F;
+            lo += 8;
+        }
+        else
+        {
+            cnt += glps_store_is_live(idx, lo);
+            lo++;
+        }
+    }
+
+    return cnt;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Adds a written record to the index of its sector.
+ ****************************************************************************************
+ */
+static void glps_store_idx_add(struct glps_store_idx *idx, uint8_t slot, uint32_t time, bool live)
+{
+    if (time < idx->last_time)
+    {
+        idx->sorted = false;
+    }
+    idx->last_time = time;
+
+    if (live)
+    {
+        idx->live_map[slot >> 3] |= (1 << (slot & 7));
+        idx->live++;
+        glps_store_env.count++;
+
+        if (time < idx->min_time)
+        {
+            idx->min_time = time;
+        }
+        if (time > idx->max_time)
+        {
+            idx->max_time = time;
+        }
+    }
+}
+
+static void glps_store_idx_reset(struct glps_store_idx *idx, uint16_t first_seq)
+{
+    memset(idx, 0, sizeof(struct glps_store_idx));
+    idx->first_seq = first_seq;
+    idx->min_time = 0xFFFFFFFF;
+    idx->sorted = true;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Rebuilds the index of a sector in use from the flash.
+ ****************************************************************************************
+ */
+static void glps_store_scan_sector(uint8_t sector, uint16_t first_seq)
+{
+    struct glps_store_idx *idx = &glps_store_env.idx[sector];
+    struct glps_store_rec rec;
+    uint8_t slot;
+
+    glps_store_idx_reset(idx, first_seq);
+
+    for (slot = 0; slot < GLPS_STORE_RECS; slot++)
+    {
+        const uint8_t *p = (const uint8_t *)&rec;
+        uint8_t i;
+
+        if (!glps_store_read(glps_store_rec_addr(sector, slot), &rec, GLPS_STORE_REC_LEN))
+        {
+            break;
+        }
+
+        for (i = 0; (i < GLPS_STORE_REC_LEN) && (p[i] == 0xFF); i++);
+
+        if (i == GLPS_STORE_REC_LEN)
+        {
+            // Erased, unless a write failed without programming it and later slots are used
+            continue;
+        }
+
+        if (idx->used < slot)
+        {
+            // Slots lost by failed writes
+            idx->sorted = false;
+        }
+
+        idx->used = slot + 1;
+
+        if (((rec.state == GLPS_STORE_REC_WRITTEN) || (rec.state == GLPS_STORE_REC_DELETED)) &&
+            (rec.seq_num == (uint16_t)(first_seq + slot)))
+        {
+            glps_store_idx_add(idx, slot, glps_store_meas_time(&rec.meas),
+                               rec.state == GLPS_STORE_REC_WRITTEN);
+        }
+        else
+        {
+            // Torn record, its slot is lost
+            idx->sorted = false;
+        }
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Rebuilds the index from the flash.
+ ****************************************************************************************
+ */
+static void glps_store_scan(void)
+{
+    struct glps_store_hdr hdr[APP_GLPS_STORE_SECTORS];
+    uint8_t sector;
+    uint8_t order;
+    bool found = false;
+
+    memset(&glps_store_env, 0, sizeof(glps_store_env));
+
+    for (sector = 0; sector < APP_GLPS_STORE_SECTORS; sector++)
+    {
+        if (!glps_store_read(glps_store_sector_addr(sector), &hdr[sector], GLPS_STORE_HDR_LEN))
+        {
+            hdr[sector].magic = 0;
+        }
+
+        // The oldest sector holds the smallest sequence number
+        if ((hdr[sector].magic == GLPS_STORE_MAGIC) &&
+            (!found || (hdr[sector].first_seq < hdr[glps_store_env.oldest].first_seq)))
+        {
+            glps_store_env.oldest = sector;
+            found = true;
+        }
+    }
+
+    if (!found)
+    {
+        return;
+    }
+
+    // The sectors in use follow the oldest one with increasing sequence numbers
+    for (order = 0; order < APP_GLPS_STORE_SECTORS; order++)
+    {
+        sector = glps_store_sector(order);
+
+        if ((hdr[sector].magic != GLPS_STORE_MAGIC) ||
+            ((order > 0) && (hdr[sector].first_seq <= glps_store_env.idx[glps_store_sector(order - 1)].first_seq)))
+        {
+            break;
+        }
+
+        glps_store_scan_sector(sector, hdr[sector].first_seq);
+        glps_store_env.nb_sectors++;
+    }
+
+    sector = glps_store_sector(glps_store_env.nb_sectors - 1);
+    glps_store_env.next_seq = glps_store_env.idx[sector].first_seq + glps_store_env.idx[sector].used;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Scans the flash on first use. The flash must be open.
+ ****************************************************************************************
+ */
+static void glps_store_init(void)
+{
+    if (!glps_store_env.init_done)
+    {
+        glps_store_scan();
+        glps_store_env.init_done = true;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Starts a new sector after the newest one, dropping the oldest sector if all
+ *        are in use.
+ * @return true on success
+ ****************************************************************************************
+ */
+static bool glps_store_new_sector(void)
+{
+    struct glps_store_hdr hdr;
+    uint8_t sector;
+
+    if (glps_store_env.nb_sectors == APP_GLPS_STORE_SECTORS)
+    {
+        glps_store_env.count -= glps_store_env.idx[glps_store_env.oldest].live;
+        glps_store_env.oldest = glps_store_sector(1);
+        glps_store_env.nb_sectors--;
+    }
+
+    sector = glps_store_sector(glps_store_env.nb_sectors);
+
+    if (spi_flash_block_erase(glps_store_sector_addr(sector), SPI_FLASH_OP_SE) != SPI_FLASH_ERR_OK)
+    {
+        return false;
+    }
+
+    hdr.magic = GLPS_STORE_MAGIC;
+    hdr.first_seq = glps_store_env.next_seq;
+    hdr.reserved = 0xFFFF;
+
+    // The magic is programmed last, a sector whose header was torn is not in use
+    if (!glps_store_write(glps_store_sector_addr(sector) + sizeof(hdr.magic),
+                          (uint8_t *)&hdr + sizeof(hdr.magic), GLPS_STORE_HDR_LEN - sizeof(hdr.magic)) ||
+        !glps_store_write(glps_store_sector_addr(sector), &hdr.magic, sizeof(hdr.magic)))
+    {
+        return false;
+    }
+
+    glps_store_idx_reset(&glps_store_env.idx[sector], glps_store_env.next_seq);
+    glps_store_env.nb_sectors++;
+
+    return true;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Erases the sectors in use and starts an empty one, so that the sequence
+ *        numbers go on after a reset.
+ ****************************************************************************************
+ */
+static void glps_store_erase_all(void)
+{
+    uint8_t order;
+
+    for (order = 0; order < glps_store_env.nb_sectors; order++)
+    {
+        spi_flash_block_erase(glps_store_sector_addr(glps_store_sector(order)), SPI_FLASH_OP_SE);
+    }
+
+    glps_store_env.nb_sectors = 0;
+    glps_store_env.count = 0;
+    glps_store_new_sector();
+}
+
+static bool glps_store_append(const struct glp_meas *meas, const struct glp_meas_ctx *ctx, uint16_t *seq_num)
+{
+    struct glps_store_rec rec;
+    struct glps_store_idx *idx;
+    uint8_t state = GLPS_STORE_REC_WRITTEN;
+    uint8_t sector;
+    uint8_t slot;
+    uint32_t addr;
+
+    if ((glps_store_env.nb_sectors == 0) ||
+        (glps_store_env.idx[glps_store_sector(glps_store_env.nb_sectors - 1)].used == GLPS_STORE_RECS))
+    {
+        if (!glps_store_new_sector())
+        {
+            return false;
+        }
+    }
+
+    sector = glps_store_sector(glps_store_env.nb_sectors - 1);
+    idx = &glps_store_env.idx[sector];
+    slot = idx->used;
+    addr = glps_store_rec_addr(sector, slot);
+
+    memset(&rec, 0, sizeof(rec));
+    rec.seq_num = idx->first_seq + slot;
+    rec.meas = *meas;
+    if (ctx != NULL)
+    {
+        rec.ctx_present = 1;
+        rec.ctx = *ctx;
+    }
+
+    // The slot is consumed even if programming fails
+    idx->used++;
+    glps_store_env.next_seq = rec.seq_num + 1;
+
+    // The state byte is programmed last
+    if (!glps_store_write(addr + 1, (uint8_t *)&rec + 1, GLPS_STORE_REC_LEN - 1) ||
+        !glps_store_write(addr, &state, 1))
+    {
+        idx->sorted = false;
+        return false;
+    }
+
+    glps_store_idx_add(idx, slot, glps_store_meas_time(meas), true);
+
+    if (seq_num != NULL)
+    {
+        *seq_num = rec.seq_num;
+    }
+
+    return true;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Finds the sector holding a sequence number.
+ * @return Order of the last sector whose first sequence number is not larger, 0 if none
+ ****************************************************************************************
+ */
+static uint8_t glps_store_seq_order(uint32_t seq_num)
+{
+    uint8_t lo = 0;
+    uint8_t hi = glps_store_env.nb_sectors;
+
+    while ((hi - lo) > 1)
+    {
+        uint8_t mid = (lo + hi) / 2;
+
+        if (glps_store_env.idx[glps_store_sector(mid)].first_seq <= seq_num)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Slot of a sequence number, clamped to the slots used of the sector.
+ ****************************************************************************************
+ */
+static uint8_t glps_store_seq_slot(const struct glps_store_idx *idx, uint32_t seq_num)
+{
+    if (seq_num <= idx->first_seq)
+    {
+        return 0;
+    }
+
+    return (uint8_t)co_min(seq_num - idx->first_seq, idx->used);
+}
+
+/**
+ ****************************************************************************************
+ * @brief First slot of a sorted sector whose time is larger than, or equal to, a time.
+ * @param[in] sector Sector
+ * @param[in] time   Time
+ * @param[in] after  True to look for a larger time only
+ ****************************************************************************************
+ */
+static uint8_t glps_store_time_bound(uint8_t sector, uint32_t time, bool after)
+{
+    uint8_t lo = 0;
+    uint8_t hi = glps_store_env.idx[sector].used;
+
+    while (lo < hi)
+    {
+        uint8_t mid = (lo + hi) / 2;
+        uint32_t mid_time = glps_store_rec_time(sector, mid);
+
+        if ((mid_time < time) || (after && (mid_time == time)))
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Narrows the slots of a sector that may match a query.
+ * @param[in] sector Sector
+ * @param[in] query  Query
+ * @param[out] lo    First slot
+ * @param[out] hi    Slot following the last one
+ * @return true if every live record of the range matches, false if each one has to be
+ *         checked
+ ****************************************************************************************
+ */
+static bool glps_store_range(uint8_t sector, const struct glps_store_query *query, uint8_t *lo, uint8_t *hi)
+{
+    const struct glps_store_idx *idx = &glps_store_env.idx[sector];
+
+    *lo = 0;
+    *hi = idx->used;
+
+    if (query->filter_type == GLP_FILTER_SEQ_NUMBER)
+    {
+        *lo = glps_store_seq_slot(idx, query->min);
+        *hi = glps_store_seq_slot(idx, query->max + 1);
+    }
+    else if ((idx->live == 0) || (idx->max_time < query->min) || (idx->min_time > query->max))
+    {
+        *hi = 0;
+    }
+    else if ((idx->min_time < query->min) || (idx->max_time > query->max))
+    {
+        if (!idx->sorted)
+        {
+            return false;
+        }
+
+        if (idx->min_time < query->min)
+        {
+            *lo = glps_store_time_bound(sector, query->min, false);
+        }
+        if (idx->max_time > query->max)
+        {
+            *hi = glps_store_time_bound(sector, query->max, true);
+        }
+    }
+
+    return true;
+}
+
+static bool glps_store_match(uint8_t sector, uint8_t slot, const struct glps_store_query *query)
+{
+    uint32_t time = glps_store_rec_time(sector, slot);
+
+    return (time >= query->min) && (time <= query->max);
+}
+
+static uint16_t glps_store_count(const struct glps_store_query *query)
+{
+    uint16_t cnt = 0;
+    uint8_t order;
+
+    for (order = 0; order < glps_store_env.nb_sectors; order++)
+    {
+        uint8_t sector = glps_store_sector(order);
+        const struct glps_store_idx *idx = &glps_store_env.idx[sector];
+        uint8_t lo, hi;
+
+        if (glps_store_range(sector, query, &lo, &hi))
+        {
+            cnt += glps_store_live_cnt(idx, lo, hi);
+            continue;
+        }
+
+        for (; lo < hi; lo++)
+        {
+            if (glps_store_is_live(idx, lo) && glps_store_match(sector, lo, query))
+            {
+                cnt++;
+            }
+        }
+    }
+
+    return cnt;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Reads the first live record matching a query from a sequence number on.
+ * @param[in] query   Query
+ * @param[in] seq_num Smallest sequence number
+ * @param[out] rec    Record
+ * @return true if found
+ ****************************************************************************************
+ */
+static bool glps_store_next(const struct glps_store_query *query, uint32_t seq_num, struct glps_store_rec *rec)
+{
+    uint8_t order;
+
+    for (order = glps_store_seq_order(seq_num); order < glps_store_env.nb_sectors; order++)
+    {
+        uint8_t sector = glps_store_sector(order);
+        const struct glps_store_idx *idx = &glps_store_env.idx[sector];
+        uint8_t lo, hi;
+        bool exact = glps_store_range(sector, query, &lo, &hi);
+
+        lo = co_max(lo, glps_store_seq_slot(idx, seq_num));
+
+        for (; lo < hi; lo++)
+        {
+            if (glps_store_is_live(idx, lo) && (exact || glps_store_match(sector, lo, query)))
+            {
+                return glps_store_read(glps_store_rec_addr(sector, lo), rec, GLPS_STORE_REC_LEN);
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Deletes the records matching a query and erases the sectors left empty.
+ * @return Number of records deleted
+ ****************************************************************************************
+ */
+static uint16_t glps_store_delete(const struct glps_store_query *query)
+{
+    uint16_t cnt = glps_store_count(query);
+    uint8_t state = GLPS_STORE_REC_DELETED;
+    uint8_t order;
+
+    if ((cnt == 0) || (cnt == glps_store_env.count))
+    {
+        if (cnt != 0)
+        {
+            glps_store_erase_all();
+        }
+        return cnt;
+    }
+
+    for (order = 0; order < glps_store_env.nb_sectors; order++)
+    {
+        uint8_t sector = glps_store_sector(order);
+        struct glps_store_idx *idx = &glps_store_env.idx[sector];
+        uint8_t lo, hi;
+        bool exact = glps_store_range(sector, query, &lo, &hi);
+
+        for (; lo < hi; lo++)
+        {
+            if (glps_store_is_live(idx, lo) && (exact || glps_store_match(sector, lo, query)))
+            {
+                glps_store_write(glps_store_rec_addr(sector, lo), &state, 1);
+                idx->live_map[lo >> 3] &= ~(1 << (lo & 7));
+                idx->live--;
+                glps_store_env.count--;
+            }
+        }
+    }
+
+    // Give back the oldest sectors that hold no record anymore
+    while ((glps_store_env.nb_sectors > 1) && (glps_store_env.idx[glps_store_env.oldest].live == 0))
+    {
+        spi_flash_block_erase(glps_store_sector_addr(glps_store_env.oldest), SPI_FLASH_OP_SE);
+        glps_store_env.oldest = glps_store_sector(1);
+        glps_store_env.nb_sectors--;
+    }
+
+    return cnt;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Sequence number of the oldest or of the most recent live record.
+ * @param[in] last    True for the most recent one
+ * @param[out] seq_num Sequence number
+ * @return true if the store is not empty
+ ****************************************************************************************
+ */
+static bool glps_store_edge_seq(bool last, uint16_t *seq_num)
+{
+    uint8_t i;
+
+    for (i = 0; i < glps_store_env.nb_sectors; i++)
+    {
+        uint8_t order = last ? (glps_store_env.nb_sectors - 1 - i) : i;
+        const struct glps_store_idx *idx = &glps_store_env.idx[glps_store_sector(order)];
+        uint8_t j;
+
+        if (idx->live == 0)
+        {
+            continue;
+        }
+
+        for (j = 0; j < idx->used; j++)
+        {
+            uint8_t slot = last ? (idx->used - 1 - j) : j;
+
+            if (glps_store_is_live(idx, slot))
+            {
+                *seq_num = idx->first_seq + slot;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Converts a RACP filter to a query.
+ * @return GLP_RSP_SUCCESS or the RACP response code
+ ****************************************************************************************
+ */
+static uint8_t glps_store_query_get(const struct glp_filter *filter, struct glps_store_query *query)
+{
+    uint16_t seq_num;
+
+    query->filter_type = GLP_FILTER_SEQ_NUMBER;
+    query->min = 0;
+    query->max = 0xFFFF;
+
+    switch (filter->operator)
+    {
+        case GLP_OP_ALL_RECS:
+            break;
+
+        case GLP_OP_FIRST_REC:
+        case GLP_OP_LAST_REC:
+        {
+            if (!glps_store_edge_seq(filter->operator == GLP_OP_LAST_REC, &seq_num))
+            {
+                return GLP_RSP_NO_RECS_FOUND;
+            }
+            query->min = seq_num;
+            query->max = seq_num;
+        } break;
+
+        case GLP_OP_LT_OR_EQ:
+        case GLP_OP_GT_OR_EQ:
+        case GLP_OP_WITHIN_RANGE_OF:
+        {
+            bool has_min = (filter->operator != GLP_OP_LT_OR_EQ);
+            bool has_max = (filter->operator != GLP_OP_GT_OR_EQ);
+
+            if (filter->filter_type == GLP_FILTER_SEQ_NUMBER)
+            {
+                if (has_min)
+                {
+                    query->min = filter->val.seq_num.min;
+                }
+                if (has_max)
+                {
+                    query->max = filter->val.seq_num.max;
+                }
+            }
+            else if (filter->filter_type == GLP_FILTER_USER_FACING_TIME)
+            {
+                query->filter_type = GLP_FILTER_USER_FACING_TIME;
+                query->max = 0xFFFFFFFF;
+
+                if (has_min)
+                {
+                    query->min = glps_store_date_time(&filter->val.time.facetime_min);
+                }
+                if (has_max)
+                {
+                    query->max = glps_store_date_time(&filter->val.time.facetime_max);
+                }
+            }
+            else
+            {
+                return GLP_RSP_OPERAND_NOT_SUP;
+            }
+
+            if (query->min > query->max)
+            {
+                return GLP_RSP_INVALID_OPERAND;
+            }
+        } break;
+
+        default:
+            return GLP_RSP_OPERATOR_NOT_SUP;
+    }
+
+    return GLP_RSP_SUCCESS;
+}
+
+/*
+ * RECORD ACCESS CONTROL POINT
+ ****************************************************************************************
+ */
+
+static void app_glps_send_racp_rsp(uint8_t conidx, uint8_t op_code, uint8_t status, uint16_t num_of_record)
+{
+    struct glps_env_tag *glps_env = PRF_ENV_GET(GLPS, glps);
+    struct glps_send_racp_rsp_cmd *cmd = KE_MSG_ALLOC(GLPS_SEND_RACP_RSP_CMD,
+                                                      prf_src_task_get(&glps_env->prf_env, conidx),
+                                                      TASK_APP,
+                                                      glps_send_racp_rsp_cmd);
+
+    cmd->op_code = op_code;
+    cmd->status = status;
+    cmd->num_of_record = num_of_record;
+
+    ke_msg_send(cmd);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Sends the next record of the ongoing report.
+ * @return false if no record is left, the flash must be open
+ ****************************************************************************************
+ */
+static bool app_glps_send_next(uint8_t conidx)
+{
+    struct glps_env_tag *glps_env = PRF_ENV_GET(GLPS, glps);
+    struct glps_store_rec rec;
+
+    if (!glps_store_next(&app_glps_env.query, app_glps_env.report_seq, &rec))
+    {
+        return false;
+    }
+
+    app_glps_env.report_seq = (uint32_t)rec.seq_num + 1;
+
+    if (rec.ctx_present && APP_GLPS_MEAS_CTX_SUPPORTED && (app_glps_env.evt_cfg & GLPS_MEAS_CTX_NTF_CFG))
+    {
+        struct glps_send_meas_with_ctx_cmd *cmd = KE_MSG_ALLOC(GLPS_SEND_MEAS_WITH_CTX_CMD,
+                                                               prf_src_task_get(&glps_env->prf_env, conidx),
+                                                               TASK_APP,
+                                                               glps_send_meas_with_ctx_cmd);
+
+        cmd->seq_num = rec.seq_num;
+        cmd->meas = rec.meas;
+        cmd->meas.flags |= GLP_MEAS_CTX_INF_FOLW;
+        cmd->ctx = rec.ctx;
+
+        ke_msg_send(cmd);
+    }
+    else
+    {
+        struct glps_send_meas_without_ctx_cmd *cmd = KE_MSG_ALLOC(GLPS_SEND_MEAS_WITHOUT_CTX_CMD,
+                                                                  prf_src_task_get(&glps_env->prf_env, conidx),
+                                                                  TASK_APP,
+                                                                  glps_send_meas_without_ctx_cmd);
+
+        cmd->seq_num = rec.seq_num;
+        cmd->meas = rec.meas;
+        cmd->meas.flags &= ~GLP_MEAS_CTX_INF_FOLW;
+
+        ke_msg_send(cmd);
+    }
+
+    return true;
+}
+
+void app_glps_racp_req(uint8_t conidx, const struct glp_racp_req *req)
+{
+    struct glps_store_query query;
+    uint16_t cnt = 0;
+    uint8_t status;
+
+    if (req->op_code == GLP_REQ_ABORT_OP)
+    {
+        // The measurement in flight completes, nothing follows it
+        app_glps_env.reporting = false;
+        app_glps_send_racp_rsp(conidx, GLP_REQ_ABORT_OP, GLP_RSP_SUCCESS, 0);
+        return;
+    }
+
+    glps_store_flash_open();
+    glps_store_init();
+
+    status = glps_store_query_get(&req->filter, &query);
+
+    if (status == GLP_RSP_SUCCESS)
+    {
+        switch (req->op_code)
+        {
+            case GLP_REQ_REP_NUM_OF_STRD_RECS:
+            {
+                cnt = glps_store_count(&query);
+            } break;
+
+            case GLP_REQ_REP_STRD_RECS:
+            {
+                app_glps_env.query = query;
+                app_glps_env.report_seq = (query.filter_type == GLP_FILTER_SEQ_NUMBER) ? query.min : 0;
+
+                app_glps_env.reporting = app_glps_send_next(conidx);
+                if (app_glps_env.reporting)
+                {
+                    // Answered once the last record is sent
+                    glps_store_flash_close();
+                    return;
+                }
+                status = GLP_RSP_NO_RECS_FOUND;
+            } break;
+
+            case GLP_REQ_DEL_STRD_RECS:
+            {
+                if (glps_store_delete(&query) == 0)
+                {
+                    status = GLP_RSP_NO_RECS_FOUND;
+                }
+            } break;
+
+            default:
+            {
+                status = GLP_RSP_OP_CODE_NOT_SUP;
+            } break;
+        }
+    }
+
+    glps_store_flash_close();
+
+    app_glps_send_racp_rsp(conidx, req->op_code, status, cnt);
+}
+
+void app_glps_meas_sent(uint8_t conidx, uint8_t status)
+{
+    bool more;
+
+    if (!app_glps_env.reporting)
+    {
+        return;
+    }
+
+    if (status != GAP_ERR_NO_ERROR)
+    {
+        app_glps_env.reporting = false;
+        app_glps_send_racp_rsp(conidx, GLP_REQ_REP_STRD_RECS, GLP_RSP_PROCEDURE_NOT_COMPLETED, 0);
+        return;
+    }
+
+    glps_store_flash_open();
+    more = app_glps_send_next(conidx);
+    glps_store_flash_close();
+
+    if (!more)
+    {
+        app_glps_env.reporting = false;
+        app_glps_send_racp_rsp(conidx, GLP_REQ_REP_STRD_RECS, GLP_RSP_SUCCESS, 0);
+    }
+}
+
+void app_glps_cfg_ind(uint16_t evt_cfg)
+{
+    app_glps_env.evt_cfg = evt_cfg;
+}
+
+/*
+ * GLOBAL FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+void app_glps_create_db(void)
+{
+    struct glps_db_cfg* db_cfg;
+
+    struct gapm_profile_task_add_cmd *req = KE_MSG_ALLOC_DYN(GAPM_PROFILE_TASK_ADD_CMD,
+                                                             TASK_GAPM,
+                                                             TASK_APP,
+                                                             gapm_profile_task_add_cmd,
+                                                             sizeof(struct glps_db_cfg));
+
+    // Fill message
+    req->operation = GAPM_PROFILE_TASK_ADD;
+    req->sec_lvl = get_user_prf_srv_perm(TASK_ID_GLPS);
+    req->prf_task_id = TASK_ID_GLPS;
+    req->app_task = TASK_APP;
+    req->start_hdl = 0;
+
+    // Set parameters
+    db_cfg = (struct glps_db_cfg* ) req->param;
+    db_cfg->features = APP_GLPS_FEATURES;
+    db_cfg->meas_ctx_supported = APP_GLPS_MEAS_CTX_SUPPORTED;
+
+    // Send the message
+    ke_msg_send(req);
+}
+
+void app_glps_enable(uint8_t conidx)
+{
+    struct glps_env_tag *glps_env = PRF_ENV_GET(GLPS, glps);
+    // Allocate the message
+    struct glps_enable_req * req = KE_MSG_ALLOC(GLPS_ENABLE_REQ,
+                                                prf_src_task_get(&glps_env->prf_env, conidx),
+                                                TASK_APP,
+                                                glps_enable_req);
+
+    req->evt_cfg = app_glps_env.initial_evt_cfg;
+    app_glps_env.evt_cfg = app_glps_env.initial_evt_cfg;
+    app_glps_env.reporting = false;
+
+    ke_msg_send(req);
+}
+
+bool app_glps_store_add(const struct glp_meas *meas, const struct glp_meas_ctx *ctx, uint16_t *seq_num)
+{
+    bool ret;
+
+    glps_store_flash_open();
+    glps_store_init();
+    ret = glps_store_append(meas, ctx, seq_num);
+    glps_store_flash_close();
+
+    return ret;
+}
+
+uint16_t app_glps_store_count(void)
+{
+    if (!glps_store_env.init_done)
+    {
+        glps_store_flash_open();
+        glps_store_init();
+        glps_store_flash_close();
+    }
+
+    return glps_store_env.count;
+}
+
+void app_glps_store_clear(void)
+{
+    glps_store_flash_open();
+    glps_store_init();
+    glps_store_erase_all();
+    glps_store_flash_close();
+}
+
+void app_glps_set_initial_evt_cfg(uint16_t evt_cfg)
+{
+    app_glps_env.initial_evt_cfg = evt_cfg;
+}
+
+#endif // (BLE_GL_SENSOR)
+
+#endif // (BLE_APP_PRESENT)
+
+/// @} APP
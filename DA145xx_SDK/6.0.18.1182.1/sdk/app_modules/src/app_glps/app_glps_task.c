@@ -0,0 +1,152 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_glps_task.c
+ *
+ * @brief Glucose Profile Sensor application task.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APPTASK
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "rwip_config.h"               // SW configuration
+
+#if (BLE_APP_PRESENT)
+
+#if (BLE_GL_SENSOR)
+#include "glps_task.h"
+#include "app_glps.h"
+#include "app_glps_task.h"
+#include "app_task.h"                  // Application Task API
+#include "app_entry_point.h"
+#include "app.h"
+
+/**
+ ****************************************************************************************
+ * @brief Message handler for the GLPS Application message (service enable).
+ * @param[in] msgid     Id of the message received.
+ * @param[in] param     Pointer to the parameters of the message.
+ * @param[in] dest_id   ID of the receiving task instance.
+ * @param[in] src_id    ID of the sending task instance.
+ * @return If the message was consumed or not.
+ ****************************************************************************************
+ */
+static int glps_enable_rsp_handler(ke_msg_id_t const msgid,
+                                   struct glps_enable_rsp const *param,
+                                   ke_task_id_t const dest_id,
+                                   ke_task_id_t const src_id)
+{
+    return (KE_MSG_CONSUMED);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Message handler for the GLPS Application CCC descriptor reconfiguration.
+ * @param[in] msgid   Id of the message received
+ * @param[in] param   Pointer to the parameters of the message
+ * @param[in] dest_id ID of the receiving task instance
+ * @param[in] src_id  ID of the sending task instance
+ * @return Returns if the message is handled by the process handler
+ ****************************************************************************************
+ */
+static int glps_cfg_indntf_ind_handler(ke_msg_id_t const msgid,
+                                       struct glps_cfg_indntf_ind const *param,
+                                       ke_task_id_t const dest_id,
+                                       ke_task_id_t const src_id)
+{
+    app_glps_cfg_ind(param->evt_cfg);
+
+    return (KE_MSG_CONSUMED);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Message handler for the GLPS Application Record Access Control Point request.
+ * @param[in] msgid   Id of the message received
+ * @param[in] param   Pointer to the parameters of the message
+ * @param[in] dest_id ID of the receiving task instance
+ * @param[in] src_id  ID of the sending task instance
+ * @return Returns if the message is handled by the process handler
+ ****************************************************************************************
+ */
+static int glps_racp_req_rcv_ind_handler(ke_msg_id_t const msgid,
+                                         struct glps_racp_req_rcv_ind const *param,
+                                         ke_task_id_t const dest_id,
+                                         ke_task_id_t const src_id)
+{
+    app_glps_racp_req(KE_IDX_GET(src_id), &param->racp_req);
+
+    return (KE_MSG_CONSUMED);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Message handler for the GLPS Application request completion.
+ * @param[in] msgid   Id of the message received
+ * @param[in] param   Pointer to the parameters of the message
+ * @param[in] dest_id ID of the receiving task instance
+ * @param[in] src_id  ID of the sending task instance
+ * @return Returns if the message is handled by the process handler
+ ****************************************************************************************
+ */
+static int glps_cmp_evt_handler(ke_msg_id_t const msgid,
+                                struct glps_cmp_evt const *param,
+                                ke_task_id_t const dest_id,
+                                ke_task_id_t const src_id)
+{
+    if (param->request == GLPS_SEND_MEAS_REQ_NTF_CMP)
+    {
+        app_glps_meas_sent(KE_IDX_GET(src_id), param->status);
+    }
+
+    return (KE_MSG_CONSUMED);
+}
+
+/*
+ * GLOBAL VARIABLES DEFINITION
+ ****************************************************************************************
+ */
+
+const struct ke_msg_handler app_glps_process_handlers[]=
+{
+    {GLPS_ENABLE_RSP,                  (ke_msg_func_t)glps_enable_rsp_handler},
+    {GLPS_CFG_INDNTF_IND,              (ke_msg_func_t)glps_cfg_indntf_ind_handler},
+    {GLPS_RACP_REQ_RCV_IND,            (ke_msg_func_t)glps_racp_req_rcv_ind_handler},
+    {GLPS_CMP_EVT,                     (ke_msg_func_t)glps_cmp_evt_handler},
+};
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+enum process_event_response app_glps_process_handler(ke_msg_id_t const msgid,
+                                                     void const *param,
+                                                     ke_task_id_t const dest_id,
+                                                     ke_task_id_t const src_id,
+                                                     enum ke_msg_status_tag *msg_ret)
+{
+    return app_std_process_event(msgid, param, src_id, dest_id, msg_ret, app_glps_process_handlers,
+                                         sizeof(app_glps_process_handlers) / sizeof(struct ke_msg_handler));
+}
+
+#endif //BLE_GL_SENSOR
+
+#endif //(BLE_APP_PRESENT)
+
+/// @} APPTASK
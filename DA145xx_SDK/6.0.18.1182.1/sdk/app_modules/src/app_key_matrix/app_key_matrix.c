@@ -0,0 +1,412 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_key_matrix.c
+ *
+ * @brief Key matrix scanner.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "rwip_config.h"     // SW configuration
+#include "app_key_matrix.h"
+
+#if defined (CFG_APP_KEY_MATRIX)
+#include <string.h>
+#include "arch_api.h"
+#include "ke_msg.h"
+#include "app_easy_timer.h"
+#include "app_easy_msg_utils.h"
+#include "wkupct_quadec.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+#if defined (__DA14531__)
+#define KEY_MATRIX_WKUP_ENABLE(sel, pol)    wkupct2_enable_irq((sel), (pol), 1, APP_KEY_MATRIX_WKUP_DEB_TIME)
+#define KEY_MATRIX_WKUP_DISABLE()           wkupct2_disable_irq()
+#define KEY_MATRIX_WKUP_REGISTER(cb)        wkupct2_register_callback(cb)
+#else
+#define KEY_MATRIX_WKUP_ENABLE(sel, pol)    wkupct_enable_irq((sel), (pol), 1, APP_KEY_MATRIX_WKUP_DEB_TIME)
+#define KEY_MATRIX_WKUP_DISABLE()           wkupct_disable_irq()
+#define KEY_MATRIX_WKUP_REGISTER(cb)        wkupct_register_callback(cb)
+#endif
+
+// The callback and the pins of the wakeup interrupt would be taken over by the other module
+#if defined (CFG_APP_ENCODER)
+#error "CFG_APP_KEY_MATRIX and CFG_APP_ENCODER use the same wakeup interrupt"
+#endif
+
+#if !defined (__DA14531__) && defined (CFG_UART2_WAKEUP)
+#error "CFG_APP_KEY_MATRIX and CFG_UART2_WAKEUP use the same wakeup interrupt on the DA14585/586"
+#endif
+
+#if (APP_KEY_MATRIX_DEBOUNCE < 1) || (APP_KEY_MATRIX_DEBOUNCE > 255)
+#error "APP_KEY_MATRIX_DEBOUNCE must be in 1..255"
+#endif
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Key matrix environment
+struct key_matrix_env_tag
+{
+    /// Matrix configuration
+    const struct app_key_matrix_cfg *cfg;
+    /// Debounced pressed keys, one bit per column
+    uint8_t pressed[APP_KEY_MATRIX_MAX_ROWS];
+    /// Integrator of every key, from 0 (released) to APP_KEY_MATRIX_DEBOUNCE (pressed)
+    uint8_t integ[APP_KEY_MATRIX_MAX_ROWS][APP_KEY_MATRIX_MAX_COLS];
+    /// Message sent from the wakeup interrupt to start a burst
+    ke_msg_id_t burst_msg;
+    /// Scan timer
+    timer_hnd timer;
+    /// True during a scan burst
+    bool scanning;
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static struct key_matrix_env_tag key_matrix_env __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Read the rows.
+ * @return Rows pulled low, one bit per row
+ ****************************************************************************************
+ */
+static uint8_t key_matrix_read_rows(void)
+{
+    const struct app_key_matrix_cfg *cfg = key_matrix_env.cfg;
+    uint8_t rows = 0;
+    uint8_t r;
+
+    for (r = 0; r < cfg->nb_rows; r++)
+    {
+        if (!GPIO_GetPinStatus(cfg->rows[r].port, cfg->rows[r].pin))
+        {
+            rows |= (1 << r);
+        }
+    }
+
+    return rows;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Read the keys, one column at a time. The other columns float on their
+ *        pull-ups so that two keys of a row do not short two driven columns.
+ * @param[out] raw      Keys read as pressed, one byte per row and one bit per column
+ ****************************************************************************************
+ */
+static void key_matrix_read(uint8_t *raw)
+{
+    const struct app_key_matrix_cfg *cfg = key_matrix_env.cfg;
+    uint8_t r, c;
+
+    memset(raw, 0, cfg->nb_rows);
+
+    for (c = 0; c < cfg->nb_cols; c++)
+    {
+        GPIO_ConfigurePin(cfg->cols[c].port, cfg->cols[c].pin, INPUT_PULLUP, PID_GPIO, false);
+    }
+
+    for (c = 0; c < cfg->nb_cols; c++)
+    {
+        uint8_t rows;
+
+        GPIO_ConfigurePin(cfg->cols[c].port, cfg->cols[c].pin, OUTPUT, PID_GPIO, false);
+
+        for (volatile uint16_t i = 0; i < APP_KEY_MATRIX_SETTLE_LOOPS; i++);
+
+        rows = key_matrix_read_rows();
+        for (r = 0; r < cfg->nb_rows; r++)
+        {
+            if (rows & (1 << r))
+            {
+                raw[r] |= (1 << c);
+            }
+        }
+
+        GPIO_ConfigurePin(cfg->cols[c].port, cfg->cols[c].pin, INPUT_PULLUP, PID_GPIO, false);
+    }
+
+    // Back to idle, all the columns low
+    for (c = 0; c < cfg->nb_cols; c++)
+    {
+        GPIO_ConfigurePin(cfg->cols[c].port, cfg->cols[c].pin, OUTPUT, PID_GPIO, false);
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Find the rows where a key may be a ghost, i.e. the rows sharing more than one
+ *        pressed column with another row.
+ * @param[in] raw       Keys read as pressed
+ * @return Ambiguous rows, one bit per row
+ ****************************************************************************************
+ */
+static uint8_t key_matrix_ghost_rows(const uint8_t *raw)
+{
+    uint8_t nb_rows = key_matrix_env.cfg->nb_rows;
+    uint8_t ghost = 0;
+    uint8_t r1, r2;
+
+    for (r1 = 0; r1 < nb_rows; r1++)
+    {
+        for (r2 = r1 + 1; r2 < nb_rows; r2++)
+        {
+            uint8_t common = raw[r1] & raw[r2];
+
+            // More than one bit set
+            if (common & (common - 1))
+            {
+                ghost |= (1 << r1) | (1 << r2);
+            }
+        }
+    }
+
+    return ghost;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Debounce a scan and report the key changes.
+ * @param[in] raw       Keys read as pressed
+ * @return true while a key is pressed or not settled
+ ****************************************************************************************
+ */
+static bool key_matrix_debounce(const uint8_t *raw)
+{
+    const struct app_key_matrix_cfg *cfg = key_matrix_env.cfg;
+    uint8_t ghost = key_matrix_ghost_rows(raw);
+    bool changed = false;
+    bool busy = false;
+    uint8_t r, c;
+
+    for (r = 0; r < cfg->nb_rows; r++)
+    {
+        for (c = 0; c < cfg->nb_cols; c++)
+        {
+            uint8_t *integ = &key_matrix_env.integ[r][c];
+            bool was_pressed = (key_matrix_env.pressed[r] & (1 << c)) != 0;
+            bool sample = (raw[r] & (1 << c)) != 0;
+
+            // A new press in an ambiguous row may be a ghost, it waits for the row to clear
+            if (sample && !was_pressed && (ghost & (1 << r)))
+            {
+                sample = false;
+            }
+
+            if (sample)
+            {
+                if (*integ < APP_KEY_MATRIX_DEBOUNCE)
+                {
+                    (*integ)++;
+                }
+            }
+            else if (*integ > 0)
+            {
+                (*integ)--;
+            }
+
+            if (!was_pressed && (*integ == APP_KEY_MATRIX_DEBOUNCE))
+            {
+                key_matrix_env.pressed[r] |= (1 << c);
+                cfg->on_key(r, c, true);
+                changed = true;
+            }
+            else if (was_pressed && (*integ == 0))
+            {
+                key_matrix_env.pressed[r] &= ~(1 << c);
+                cfg->on_key(r, c, false);
+                changed = true;
+            }
+
+            if (*integ != 0)
+            {
+                busy = true;
+            }
+        }
+
+        if (raw[r] != 0)
+        {
+            busy = true;
+        }
+    }
+
+    if (changed && (cfg->on_scan_end != NULL))
+    {
+        cfg->on_scan_end();
+    }
+
+    return busy;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Arm the rows on the wakeup controller.
+ * @return false if a row is already low, the burst must go on
+ ****************************************************************************************
+ */
+static bool key_matrix_arm(void)
+{
+    const struct app_key_matrix_cfg *cfg = key_matrix_env.cfg;
+    uint32_t sel = 0;
+    uint32_t pol = 0;
+    uint8_t r;
+
+    for (r = 0; r < cfg->nb_rows; r++)
+    {
+        sel |= WKUPCT_PIN_SELECT(cfg->rows[r].port, cfg->rows[r].pin);
+        pol |= WKUPCT_PIN_POLARITY(cfg->rows[r].port, cfg->rows[r].pin, WKUPCT_PIN_POLARITY_LOW);
+    }
+
+    KEY_MATRIX_WKUP_ENABLE(sel, pol);
+
+    // A key pressed since the last scan may not produce an edge
+    if (key_matrix_read_rows() != 0)
+    {
+        KEY_MATRIX_WKUP_DISABLE();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Scan the matrix and schedule the next scan of the burst, or arm the rows once
+ *        all the keys are released.
+ ****************************************************************************************
+ */
+static void key_matrix_scan(void)
+{
+    uint8_t raw[APP_KEY_MATRIX_MAX_ROWS];
+
+    key_matrix_env.timer = EASY_TIMER_INVALID_TIMER;
+
+    key_matrix_read(raw);
+
+    if (!key_matrix_debounce(raw) && key_matrix_arm())
+    {
+        key_matrix_env.scanning = false;
+        return;
+    }
+
+    key_matrix_env.timer = app_easy_timer(APP_KEY_MATRIX_SCAN_PERIOD, key_matrix_scan);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Start a scan burst, in the kernel context.
+ ****************************************************************************************
+ */
+static void key_matrix_burst_start(void)
+{
+    if (!key_matrix_env.scanning)
+    {
+        key_matrix_env.scanning = true;
+        key_matrix_scan();
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Wakeup controller interrupt callback. The interrupt is already disabled.
+ ****************************************************************************************
+ */
+static void key_matrix_wkup_cb(void)
+{
+    arch_ble_force_wakeup();
+    ke_msg_send_basic(key_matrix_env.burst_msg, TASK_APP, 0);
+}
+
+void app_key_matrix_init(const struct app_key_matrix_cfg *cfg)
+{
+    ke_msg_id_t burst_msg = key_matrix_env.burst_msg;
+
+    ASSERT_WARNING((cfg->nb_rows <= APP_KEY_MATRIX_MAX_ROWS) && (cfg->nb_cols <= APP_KEY_MATRIX_MAX_COLS));
+
+    if (key_matrix_env.timer != EASY_TIMER_INVALID_TIMER)
+    {
+        app_easy_timer_cancel(key_matrix_env.timer);
+    }
+
+    memset(&key_matrix_env, 0, sizeof(struct key_matrix_env_tag));
+    key_matrix_env.cfg = cfg;
+    // The message callback is kept when the scanner is started again
+    key_matrix_env.burst_msg = (burst_msg != 0) ? burst_msg : app_easy_msg_set(key_matrix_burst_start);
+
+    app_key_matrix_set_pads();
+
+    KEY_MATRIX_WKUP_REGISTER(key_matrix_wkup_cb);
+
+    if (!key_matrix_arm())
+    {
+        key_matrix_burst_start();
+    }
+}
+
+void app_key_matrix_set_pads(void)
+{
+    const struct app_key_matrix_cfg *cfg = key_matrix_env.cfg;
+    uint8_t i;
+
+    if (cfg == NULL)
+    {
+        return;
+    }
+
+    for (i = 0; i < cfg->nb_rows; i++)
+    {
+        GPIO_ConfigurePin(cfg->rows[i].port, cfg->rows[i].pin, INPUT_PULLUP, PID_GPIO, false);
+    }
+
+    for (i = 0; i < cfg->nb_cols; i++)
+    {
+        GPIO_ConfigurePin(cfg->cols[i].port, cfg->cols[i].pin, OUTPUT, PID_GPIO, false);
+    }
+}
+
+bool app_key_matrix_is_pressed(uint8_t row, uint8_t col)
+{
+    return (key_matrix_env.pressed[row] & (1 << col)) != 0;
+}
+
+bool app_key_matrix_is_scanning(void)
+{
+    return key_matrix_env.scanning;
+}
+
+#endif // CFG_APP_KEY_MATRIX
+
+/// @} APP
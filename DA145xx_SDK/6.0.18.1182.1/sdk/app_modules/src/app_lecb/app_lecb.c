@@ -0,0 +1,376 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_lecb.c
+ *
+ * @brief LE Credit Based Channel application.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "rwip_config.h"     // SW configuration
+
+#if (BLE_APP_PRESENT)
+
+#if (BLE_APP_LECB)
+#include <string.h>
+#include <stddef.h>
+#include "app.h"
+#include "app_lecb.h"
+#include "gapc_task.h"
+#include "gattm.h"
+#include "l2cc_pdu.h"
+#include "co_math.h"
+
+/*
+ * Credit accounting
+ *
+ * A channel receives at most APP_LECB_RX_CREDITS K-frames that the application has not
+ * released: rx_credit counts the credits held by the peer, rx_held the credits used by
+ * the SDUs kept by the application, and the difference to APP_LECB_RX_CREDITS is what
+ * can be returned. rx_credit is taken from the stack whenever an SDU completes, so the
+ * K-frames of an SDU still being reassembled are counted as held by the peer until then,
+ * which only delays their return. One credit command is pending at a time: GAPC applies
+ * the credits when it completes the command, so an SDU indicated before the completion
+ * does not count them yet and rx_adding is added to its credits.
+ */
+
+/*
+ * GLOBAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+struct app_lecb_env_tag app_lecb_env[APP_EASY_MAX_ACTIVE_CONNECTION] __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Register the LE_PSM of the channel in the stack.
+ * @param[in] conidx    Connection index
+ * @param[in] le_psm    LE Protocol/Service Multiplexer
+ * @param[in] sec_lvl   Required security level
+ ****************************************************************************************
+ */
+static void lecb_create(uint8_t conidx, uint16_t le_psm, uint16_t sec_lvl)
+{
+    struct gapc_lecb_create_cmd *cmd = KE_MSG_ALLOC(GAPC_LECB_CREATE_CMD,
+                                                    KE_BUILD_ID(TASK_GAPC, conidx),
+                                                    TASK_APP,
+                                                    gapc_lecb_create_cmd);
+
+    cmd->operation = GAPC_LE_CB_CREATE;
+    cmd->sec_lvl = sec_lvl;
+    cmd->le_psm = le_psm;
+    // Local channel identifier allocated by the stack
+    cmd->cid = 0;
+    cmd->intial_credit = APP_LECB_RX_CREDITS;
+
+    ke_msg_send(cmd);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Release the LE_PSM of the channel in the stack.
+ * @param[in] conidx    Connection index
+ ****************************************************************************************
+ */
+static void lecb_destroy(uint8_t conidx)
+{
+    struct gapc_lecb_destroy_cmd *cmd = KE_MSG_ALLOC(GAPC_LECB_DESTROY_CMD,
+                                                     KE_BUILD_ID(TASK_GAPC, conidx),
+                                                     TASK_APP,
+                                                     gapc_lecb_destroy_cmd);
+
+    cmd->operation = GAPC_LE_CB_DESTROY;
+    cmd->le_psm = app_lecb_env[conidx].le_psm;
+
+    ke_msg_send(cmd);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Prepare a new channel.
+ * @param[in] conidx    Connection index
+ * @param[in] le_psm    LE Protocol/Service Multiplexer
+ * @return false if the connection already has a channel
+ ****************************************************************************************
+ */
+static bool lecb_open(uint8_t conidx, uint16_t le_psm)
+{
+    struct app_lecb_env_tag *env = &app_lecb_env[conidx];
+
+    if ((conidx >= APP_EASY_MAX_ACTIVE_CONNECTION) || (env->state != APP_LECB_IDLE))
+    {
+        return false;
+    }
+
+    // A received SDU of the local MTU must fit in the receive budget
+    ASSERT_WARNING(app_lecb_sdu_credits(gattm_get_max_mtu()) <= APP_LECB_RX_CREDITS);
+
+    memset(env, 0, sizeof(struct app_lecb_env_tag));
+    env->le_psm = le_psm;
+
+    return true;
+}
+
+bool app_lecb_listen(uint8_t conidx, uint16_t le_psm, uint16_t sec_lvl)
+{
+    if (!lecb_open(conidx, le_psm))
+    {
+        return false;
+    }
+
+    lecb_create(conidx, le_psm, sec_lvl);
+    app_lecb_env[conidx].listen = true;
+    app_lecb_env[conidx].state = APP_LECB_LISTENING;
+
+    return true;
+}
+
+bool app_lecb_connect(uint8_t conidx, uint16_t le_psm, uint16_t sec_lvl)
+{
+    struct gapc_lecb_connect_cmd *cmd;
+
+    if (!lecb_open(conidx, le_psm))
+    {
+        return false;
+    }
+
+    // The commands are executed one after the other by GAPC
+    lecb_create(conidx, le_psm, sec_lvl);
+
+    cmd = KE_MSG_ALLOC(GAPC_LECB_CONNECT_CMD,
+                       KE_BUILD_ID(TASK_GAPC, conidx),
+                       TASK_APP,
+                       gapc_lecb_connect_cmd);
+
+    cmd->operation = GAPC_LE_CB_CONNECTION;
+    cmd->pkt_id = 0;
+    cmd->le_psm = le_psm;
+    cmd->cid = 0;
+    cmd->credit = APP_LECB_RX_CREDITS;
+
+    ke_msg_send(cmd);
+
+    app_lecb_env[conidx].state = APP_LECB_CONNECTING;
+
+    return true;
+}
+
+void app_lecb_disconnect(uint8_t conidx)
+{
+    struct app_lecb_env_tag *env = &app_lecb_env[conidx];
+
+    switch (env->state)
+    {
+        case APP_LECB_CONNECTING:
+        case APP_LECB_CONNECTED:
+        {
+            struct gapc_lecb_disconnect_cmd *cmd = KE_MSG_ALLOC(GAPC_LECB_DISCONNECT_CMD,
+                                                                KE_BUILD_ID(TASK_GAPC, conidx),
+                                                                TASK_APP,
+                                                                gapc_lecb_disconnect_cmd);
+
+            cmd->operation = GAPC_LE_CB_DISCONNECTION;
+            cmd->pkt_id = 0;
+            cmd->le_psm = env->le_psm;
+
+            ke_msg_send(cmd);
+        }
+        // no break
+
+        case APP_LECB_LISTENING:
+        {
+            lecb_destroy(conidx);
+            env->listen = false;
+            env->state = APP_LECB_DISCONNECTING;
+        }
+        break;
+
+        default:
+            break;
+    }
+}
+
+uint8_t *app_lecb_sdu_alloc(uint8_t conidx, uint16_t len)
+{
+    struct app_lecb_env_tag *env = &app_lecb_env[conidx];
+    struct l2cc_pdu_send_req *req;
+
+    if ((env->state != APP_LECB_CONNECTED) || (len > env->peer_mtu) ||
+        (env->tx_req != NULL) || (env->tx_pending >= APP_LECB_TX_PIPELINE))
+    {
+        return NULL;
+    }
+
+    req = KE_MSG_ALLOC_DYN(L2CC_PDU_SEND_REQ,
+                           KE_BUILD_ID(TASK_L2CC, conidx),
+                           TASK_APP,
+                           l2cc_pdu_send_req,
+                           len);
+
+    if (req == NULL)
+    {
+        // The heap is short, the SDU is retried later
+        return NULL;
+    }
+
+    // The stack adds the SDU length field and segments the SDU in K-frames
+    req->offset = 0;
+    req->pdu.payld_len = len;
+    req->pdu.chan_id = env->dest_cid;
+    req->pdu.data.send_lecb_data_req.code = 0;
+    req->pdu.data.send_lecb_data_req.sdu_data_len = len;
+
+    env->tx_req = req;
+
+    return req->pdu.data.send_lecb_data_req.sdu_data;
+}
+
+void app_lecb_sdu_send(uint8_t conidx)
+{
+    struct app_lecb_env_tag *env = &app_lecb_env[conidx];
+
+    if (env->tx_req != NULL)
+    {
+        ke_msg_send(env->tx_req);
+        env->tx_req = NULL;
+        env->tx_pending++;
+    }
+}
+
+void app_lecb_rx_release(uint8_t conidx, const uint8_t *sdu)
+{
+    struct l2cc_lecnx_data_recv_ind *ind = (struct l2cc_lecnx_data_recv_ind *)
+                                           (sdu - offsetof(struct l2cc_lecnx_data_recv_ind, data));
+    struct app_lecb_env_tag *env = &app_lecb_env[conidx];
+    uint16_t credits = app_lecb_sdu_credits(ind->len);
+    uint8_t i;
+
+    ke_msg_free(ke_param2msg(ind));
+
+    // The SDU may be released after its channel is gone, even once the next channel is
+    // open. Only the SDUs of the open channel use its credits.
+    for (i = 0; i < APP_LECB_RX_CREDITS; i++)
+    {
+        if (env->rx_sdu[i] == sdu)
+        {
+            env->rx_sdu[i] = NULL;
+            env->rx_held -= co_min(credits, env->rx_held);
+            app_lecb_return_credits(conidx);
+            break;
+        }
+    }
+}
+
+uint16_t app_lecb_get_tx_credit(uint8_t conidx)
+{
+    return app_lecb_env[conidx].tx_credit;
+}
+
+bool app_lecb_is_connected(uint8_t conidx)
+{
+    return (app_lecb_env[conidx].state == APP_LECB_CONNECTED);
+}
+
+uint16_t app_lecb_sdu_credits(uint16_t len)
+{
+    uint16_t mps = gattm_get_max_mps();
+
+    return (len + L2C_SDU_LEN + mps - 1) / mps;
+}
+
+void app_lecb_return_credits(uint8_t conidx)
+{
+    struct app_lecb_env_tag *env = &app_lecb_env[conidx];
+    struct gapc_lecb_add_cmd *cmd;
+    uint16_t used = env->rx_credit + env->rx_held;
+    uint16_t credit;
+
+    if ((env->state != APP_LECB_CONNECTED) || (env->rx_adding != 0) || (used >= APP_LECB_RX_CREDITS))
+    {
+        return;
+    }
+
+    // Return the credits in batches, and all of them once the application holds no SDU
+    credit = APP_LECB_RX_CREDITS - used;
+    if ((credit < APP_LECB_CREDIT_BATCH) && (env->rx_held != 0))
+    {
+        return;
+    }
+
+    cmd = KE_MSG_ALLOC(GAPC_LECB_ADD_CMD,
+                       KE_BUILD_ID(TASK_GAPC, conidx),
+                       TASK_APP,
+                       gapc_lecb_add_cmd);
+
+    cmd->operation = GAPC_LE_CB_ADDITION;
+    cmd->pkt_id = 0;
+    cmd->le_psm = env->le_psm;
+    cmd->credit = credit;
+
+    ke_msg_send(cmd);
+
+    env->rx_credit += credit;
+    env->rx_adding = credit;
+}
+
+void app_lecb_closed(uint8_t conidx)
+{
+    struct app_lecb_env_tag *env = &app_lecb_env[conidx];
+
+    if (env->listen)
+    {
+        // The LE_PSM stays registered, the peer may open the channel again
+        uint16_t le_psm = env->le_psm;
+
+        app_lecb_reset(conidx);
+        env->le_psm = le_psm;
+        env->listen = true;
+        env->state = APP_LECB_LISTENING;
+    }
+    else
+    {
+        lecb_destroy(conidx);
+        app_lecb_reset(conidx);
+        env->state = APP_LECB_DISCONNECTING;
+    }
+}
+
+void app_lecb_reset(uint8_t conidx)
+{
+    struct app_lecb_env_tag *env = &app_lecb_env[conidx];
+
+    if (env->tx_req != NULL)
+    {
+        ke_msg_free(ke_param2msg(env->tx_req));
+    }
+
+    memset(env, 0, sizeof(struct app_lecb_env_tag));
+}
+
+#endif // (BLE_APP_LECB)
+
+#endif // (BLE_APP_PRESENT)
+
+/// @} APP
@@ -0,0 +1,402 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_lecb_task.c
+ *
+ * @brief LE Credit Based Channel application task.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APPTASK
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "rwip_config.h"               // SW configuration
+
+#if (BLE_APP_PRESENT)
+
+#if (BLE_APP_LECB)
+#include "gapc_task.h"
+#include "l2cc_task.h"
+#include "l2cc_pdu.h"
+#include "app_lecb.h"
+#include "app_lecb_task.h"
+#include "app_task.h"                  // Application Task API
+#include "app_entry_point.h"
+#include "app.h"
+#include "user_callback_config.h"
+
+/**
+ ****************************************************************************************
+ * @brief Handles the completion of the LE credit based operations.
+ * @param[in] msgid     Id of the message received.
+ * @param[in] param     Pointer to the parameters of the message.
+ * @param[in] dest_id   ID of the receiving task instance.
+ * @param[in] src_id    ID of the sending task instance.
+ * @return If the message was consumed or not.
+ ****************************************************************************************
+ */
+static int lecb_cmp_evt_handler(ke_msg_id_t const msgid,
+                                struct gapc_cmp_evt const *param,
+                                ke_task_id_t const dest_id,
+                                ke_task_id_t const src_id)
+{
+    uint8_t conidx = KE_IDX_GET(src_id);
+    struct app_lecb_env_tag *env = &app_lecb_env[conidx];
+
+    switch (param->operation)
+    {
+        case GAPC_LE_CB_CREATE:
+        case GAPC_LE_CB_CONNECTION:
+        {
+            if ((param->status != GAP_ERR_NO_ERROR) && (env->state != APP_LECB_DISCONNECTING))
+            {
+                uint16_t le_psm = env->le_psm;
+
+                if (param->operation == GAPC_LE_CB_CREATE)
+                {
+                    if (!env->listen)
+                    {
+                        // The connection command queued after it fails too, the channel
+                        // is closed and reported once then
+                        break;
+                    }
+
+                    // Nothing is registered in the stack
+                    app_lecb_reset(conidx);
+                }
+                else
+                {
+                    app_lecb_closed(conidx);
+                }
+
+                CALLBACK_ARGS_3(user_app_lecb_cb.on_lecb_disconnected, conidx, le_psm, param->status);
+            }
+        }
+        break;
+
+        case GAPC_LE_CB_ADDITION:
+        {
+            // Credits freed in the meantime are returned now
+            env->rx_adding = 0;
+            app_lecb_return_credits(conidx);
+        }
+        break;
+
+        case GAPC_LE_CB_DESTROY:
+        {
+            if (env->state == APP_LECB_DISCONNECTING)
+            {
+                app_lecb_reset(conidx);
+            }
+        }
+        break;
+
+        default:
+            break;
+    }
+
+    return (KE_MSG_CONSUMED);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Handles the channel request of the peer.
+ * @param[in] msgid     Id of the message received.
+ * @param[in] param     Pointer to the parameters of the message.
+ * @param[in] dest_id   ID of the receiving task instance.
+ * @param[in] src_id    ID of the sending task instance.
+ * @return If the message was consumed or not.
+ ****************************************************************************************
+ */
+static int lecb_connect_req_ind_handler(ke_msg_id_t const msgid,
+                                        struct gapc_lecb_connect_req_ind const *param,
+                                        ke_task_id_t const dest_id,
+                                        ke_task_id_t const src_id)
+{
+    uint8_t conidx = KE_IDX_GET(src_id);
+    struct app_lecb_env_tag *env = &app_lecb_env[conidx];
+    struct gapc_lecb_connect_cfm *cfm = KE_MSG_ALLOC(GAPC_LECB_CONNECT_CFM,
+                                                     src_id,
+                                                     TASK_APP,
+                                                     gapc_lecb_connect_cfm);
+
+    cfm->le_psm = param->le_psm;
+    cfm->status = L2C_CB_CON_LEPSM_NOT_SUPP;
+
+    if ((env->state == APP_LECB_LISTENING) && (env->le_psm == param->le_psm))
+    {
+        cfm->status = L2C_CB_CON_SUCCESS;
+
+        if (user_app_lecb_cb.on_lecb_connect_req != NULL)
+        {
+            cfm->status = user_app_lecb_cb.on_lecb_connect_req(conidx, param->le_psm, param->max_sdu);
+        }
+
+        if (cfm->status == L2C_CB_CON_SUCCESS)
+        {
+            env->state = APP_LECB_CONNECTING;
+        }
+    }
+
+    ke_msg_send(cfm);
+
+    return (KE_MSG_CONSUMED);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Handles the opening of the channel.
+ * @param[in] msgid     Id of the message received.
+ * @param[in] param     Pointer to the parameters of the message.
+ * @param[in] dest_id   ID of the receiving task instance.
+ * @param[in] src_id    ID of the sending task instance.
+ * @return If the message was consumed or not.
+ ****************************************************************************************
+ */
+static int lecb_connect_ind_handler(ke_msg_id_t const msgid,
+                                    struct gapc_lecb_connect_ind const *param,
+                                    ke_task_id_t const dest_id,
+                                    ke_task_id_t const src_id)
+{
+    uint8_t conidx = KE_IDX_GET(src_id);
+    struct app_lecb_env_tag *env = &app_lecb_env[conidx];
+
+    if (env->state != APP_LECB_CONNECTING)
+    {
+        return (KE_MSG_CONSUMED);
+    }
+
+    env->state = APP_LECB_CONNECTED;
+    env->dest_cid = param->dest_cid;
+    env->peer_mtu = param->max_sdu;
+    env->tx_credit = param->dest_credit;
+    env->rx_credit = APP_LECB_RX_CREDITS;
+    env->rx_held = 0;
+
+    CALLBACK_ARGS_3(user_app_lecb_cb.on_lecb_connected, conidx, param->le_psm, param->max_sdu);
+
+    return (KE_MSG_CONSUMED);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Handles the credits update of the channel.
+ * @param[in] msgid     Id of the message received.
+ * @param[in] param     Pointer to the parameters of the message.
+ * @param[in] dest_id   ID of the receiving task instance.
+ * @param[in] src_id    ID of the sending task instance.
+ * @return If the message was consumed or not.
+ ****************************************************************************************
+ */
+static int lecb_add_ind_handler(ke_msg_id_t const msgid,
+                                struct gapc_lecb_add_ind const *param,
+                                ke_task_id_t const dest_id,
+                                ke_task_id_t const src_id)
+{
+    struct app_lecb_env_tag *env = &app_lecb_env[KE_IDX_GET(src_id)];
+
+    if (env->state == APP_LECB_CONNECTED)
+    {
+        env->tx_credit = param->dest_credit;
+    }
+
+    return (KE_MSG_CONSUMED);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Handles the closing of the channel.
+ * @param[in] msgid     Id of the message received.
+ * @param[in] param     Pointer to the parameters of the message.
+ * @param[in] dest_id   ID of the receiving task instance.
+ * @param[in] src_id    ID of the sending task instance.
+ * @return If the message was consumed or not.
+ ****************************************************************************************
+ */
+static int lecb_disconnect_ind_handler(ke_msg_id_t const msgid,
+                                       struct gapc_lecb_disconnect_ind const *param,
+                                       ke_task_id_t const dest_id,
+                                       ke_task_id_t const src_id)
+{
+    uint8_t conidx = KE_IDX_GET(src_id);
+
+    // The LE_PSM is released on the completion of the destroy command if the
+    // application closed the channel
+    if (app_lecb_env[conidx].state != APP_LECB_DISCONNECTING)
+    {
+        app_lecb_closed(conidx);
+    }
+    else
+    {
+        // The closing is reported once, not again if the link drops meanwhile
+        app_lecb_env[conidx].dest_cid = 0;
+    }
+
+    CALLBACK_ARGS_3(user_app_lecb_cb.on_lecb_disconnected, conidx, param->le_psm, param->reason);
+
+    return (KE_MSG_CONSUMED);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Handles a received SDU. The message is kept until the application releases it.
+ * @param[in] msgid     Id of the message received.
+ * @param[in] param     Pointer to the parameters of the message.
+ * @param[in] dest_id   ID of the receiving task instance.
+ * @param[in] src_id    ID of the sending task instance.
+ * @return If the message was consumed or not.
+ ****************************************************************************************
+ */
+static int lecb_data_recv_ind_handler(ke_msg_id_t const msgid,
+                                      struct l2cc_lecnx_data_recv_ind const *param,
+                                      ke_task_id_t const dest_id,
+                                      ke_task_id_t const src_id)
+{
+    uint8_t conidx = KE_IDX_GET(src_id);
+    struct app_lecb_env_tag *env = &app_lecb_env[conidx];
+    uint8_t i;
+
+    if ((env->state != APP_LECB_CONNECTED) || (user_app_lecb_cb.on_lecb_sdu_received == NULL))
+    {
+        return (KE_MSG_CONSUMED);
+    }
+
+    env->rx_credit = param->src_credit + env->rx_adding;
+    env->rx_held += app_lecb_sdu_credits(param->len);
+
+    // The SDUs kept never exceed the receive budget, a slot is free
+    for (i = 0; i < APP_LECB_RX_CREDITS; i++)
+    {
+        if (env->rx_sdu[i] == NULL)
+        {
+            env->rx_sdu[i] = param->data;
+            break;
+        }
+    }
+
+    user_app_lecb_cb.on_lecb_sdu_received(conidx, param->data, param->len);
+
+    return (KE_MSG_NO_FREE);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Handles the transmission of an SDU.
+ * @param[in] msgid     Id of the message received.
+ * @param[in] param     Pointer to the parameters of the message.
+ * @param[in] dest_id   ID of the receiving task instance.
+ * @param[in] src_id    ID of the sending task instance.
+ * @return If the message was consumed or not.
+ ****************************************************************************************
+ */
+static int lecb_pdu_send_rsp_handler(ke_msg_id_t const msgid,
+                                     struct l2cc_data_send_rsp const *param,
+                                     ke_task_id_t const dest_id,
+                                     ke_task_id_t const src_id)
+{
+    uint8_t conidx = KE_IDX_GET(src_id);
+    struct app_lecb_env_tag *env = &app_lecb_env[conidx];
+
+    if (env->state != APP_LECB_CONNECTED)
+    {
+        return (KE_MSG_CONSUMED);
+    }
+
+    if (env->tx_pending > 0)
+    {
+        env->tx_pending--;
+    }
+    env->tx_credit = param->dest_credit;
+
+    CALLBACK_ARGS_2(user_app_lecb_cb.on_lecb_sdu_sent, conidx, param->status);
+
+    return (KE_MSG_CONSUMED);
+}
+
+/*
+ * GLOBAL VARIABLES DEFINITION
+ ****************************************************************************************
+ */
+
+const struct ke_msg_handler app_lecb_process_handlers[]=
+{
+    {GAPC_CMP_EVT,                     (ke_msg_func_t)lecb_cmp_evt_handler},
+    {GAPC_LECB_CONNECT_REQ_IND,        (ke_msg_func_t)lecb_connect_req_ind_handler},
+    {GAPC_LECB_CONNECT_IND,            (ke_msg_func_t)lecb_connect_ind_handler},
+    {GAPC_LECB_ADD_IND,                (ke_msg_func_t)lecb_add_ind_handler},
+    {GAPC_LECB_DISCONNECT_IND,         (ke_msg_func_t)lecb_disconnect_ind_handler},
+    {L2CC_LECNX_DATA_RECV_IND,         (ke_msg_func_t)lecb_data_recv_ind_handler},
+    {L2CC_PDU_SEND_RSP,                (ke_msg_func_t)lecb_pdu_send_rsp_handler},
+};
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+enum process_event_response app_lecb_process_handler(ke_msg_id_t const msgid,
+                                                     void const *param,
+                                                     ke_task_id_t const dest_id,
+                                                     ke_task_id_t const src_id,
+                                                     enum ke_msg_status_tag *msg_ret)
+{
+    switch (msgid)
+    {
+        case GAPC_CMP_EVT:
+        {
+            uint8_t operation = ((struct gapc_cmp_evt const *)param)->operation;
+
+            // Only the LE credit based operations are completed here, the others are
+            // left to the GAP process handler
+            if ((operation < GAPC_LE_CB_CREATE) || (operation > GAPC_LE_CB_ADDITION))
+            {
+                return PR_EVENT_UNHANDLED;
+            }
+        }
+        break;
+
+        case GAPC_DISCONNECT_IND:
+        {
+            uint8_t conidx = KE_IDX_GET(src_id);
+            struct app_lecb_env_tag *env = &app_lecb_env[conidx];
+
+            // The stack drops the channel with the link, the message is still handled by
+            // the GAP process handler. A channel being closed by the application is
+            // reported too if the peer has not answered yet.
+            if ((env->state == APP_LECB_CONNECTING) || (env->state == APP_LECB_CONNECTED) ||
+                ((env->state == APP_LECB_DISCONNECTING) && (env->dest_cid != 0)))
+            {
+                CALLBACK_ARGS_3(user_app_lecb_cb.on_lecb_disconnected, conidx, env->le_psm,
+                                ((struct gapc_disconnect_ind const *)param)->reason);
+            }
+            app_lecb_reset(conidx);
+        }
+        return PR_EVENT_UNHANDLED;
+
+        default:
+            break;
+    }
+
+    return app_std_process_event(msgid, param, src_id, dest_id, msg_ret, app_lecb_process_handlers,
+                                         sizeof(app_lecb_process_handlers) / sizeof(struct ke_msg_handler));
+}
+
+#endif // (BLE_APP_LECB)
+
+#endif // (BLE_APP_PRESENT)
+
+/// @} APPTASK
@@ -258,7 +258,14 @@ static int gapm_addr_solved_ind_handler(ke_msg_id_t const msgid,
                                         ke_task_id_t const dest_id,
                                         ke_task_id_t const src_id)
 {
+#if defined (CFG_APP_SEC_RPA_CACHE)
+    // GAPM has a single instance, the connection is the one of the pending request
+    uint8_t conidx = app_easy_security_rpa_solved(param);
+
+    CALLBACK_ARGS_2(user_app_callbacks.app_on_addr_solved_ind, conidx, param)
+#else
     CALLBACK_ARGS_2(user_app_callbacks.app_on_addr_solved_ind, KE_IDX_GET(src_id), param)
+#endif
 
     return (KE_MSG_CONSUMED);
 }
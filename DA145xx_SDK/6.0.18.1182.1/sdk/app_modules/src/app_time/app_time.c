@@ -0,0 +1,322 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_time.c
+ *
+ * @brief Drift compensated wall clock on the RTC.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup APP
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "rwip_config.h"     // SW configuration
+#include "app_time.h"
+
+#if defined (CFG_APP_TIME)
+#include <string.h>
+#include "arch_system.h"
+#include "rtc.h"
+#include "time_calc.h"
+
+#if (BLE_CTS_SERVER)
+#include "rwble_hl_error.h"
+#endif
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Nominal frequency of the XTAL32
+#define TIME_XTAL32_HZ      (32768)
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Time environment, the times are in cs since 2000-01-01
+struct time_env_tag
+{
+    /// RTC time of the anchor
+    uint64_t ref_rtc;
+    /// Corrected time of the anchor
+    uint64_t ref_true;
+    /// Corrected time of the last synchronization
+    uint64_t sync_true;
+    /// Statistics, also hold the rate errors
+    struct app_time_stats stats;
+    /// Calendar register of the cached day count
+    uint32_t clndr_bcd;
+    /// Days since 2000-01-01 of clndr_bcd
+    uint32_t days;
+    /// RCX period the rcx_ppb was computed from, 0 with the XTAL32
+    uint32_t rcx_period;
+    /// Frequency the RTC divider is set for
+    uint16_t cfg_hz;
+    /// True after the first synchronization
+    bool synced;
+};
+
+/*
+ * LOCAL VARIABLE DEFINITIONS
+ ****************************************************************************************
+ */
+
+static struct time_env_tag time_env __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+extern rcx_time_data_t rcx_time_data;
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Read the RTC.
+ * @return RTC time in cs
+ ****************************************************************************************
+ */
+static uint64_t time_rtc_read(void)
+{
+    uint32_t time_bcd;
+    uint32_t clndr_bcd;
+
+    rtc_get_time_clndr_bcd(&time_bcd, &clndr_bcd);
+    time_env.stats.reads++;
+
+    // The calendar only changes once a day
+    if (clndr_bcd != time_env.clndr_bcd)
+    {
+        time_env.clndr_bcd = clndr_bcd;
+        time_env.days = time_calc_clndr_bcd_to_days(clndr_bcd);
+        time_env.stats.date_decodes++;
+    }
+
+    return (uint64_t)time_env.days * TIME_CALC_CS_PER_DAY + time_calc_time_bcd_to_cs(time_bcd);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Correct an RTC time.
+ * @param[in] rtc       RTC time, not before the anchor
+ * @return Corrected time
+ ****************************************************************************************
+ */
+static uint64_t time_correct(uint64_t rtc)
+{
+    uint64_t elapsed = rtc - time_env.ref_rtc;
+
+    return time_env.ref_true + elapsed +
+           time_calc_drift(elapsed, time_env.stats.learned_ppb + time_env.stats.rcx_ppb);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Move the anchor to an RTC time.
+ * @param[in] rtc       RTC time
+ * @param[in] now       Corrected time of rtc
+ ****************************************************************************************
+ */
+static void time_anchor(uint64_t rtc, uint64_t now)
+{
+    time_env.ref_rtc = rtc;
+    time_env.ref_true = now;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Follow the calibrations of the RCX. The time up to rtc is corrected with the
+ *        previous rate, the time after it with the new one.
+ * @param[in] rtc       RTC time
+ ****************************************************************************************
+ */
+static void time_rcx_update(uint64_t rtc)
+{
+    uint32_t period = rcx_time_data.rcx_period;
+
+    if ((time_env.rcx_period == 0) || (period == 0) || (period == time_env.rcx_period))
+    {
+        return;
+    }
+
+    time_anchor(rtc, time_correct(rtc));
+    time_env.rcx_period = period;
+    time_env.stats.rcx_ppb = time_calc_rcx_ppb(time_env.cfg_hz, period);
+    time_env.stats.rcx_updates++;
+}
+
+void app_time_init(void)
+{
+    rtc_config_t cfg = {RTC_HOUR_MODE_24H, false};
+    rtc_time_t time = {RTC_HOUR_MODE_24H, false, 0, 0, 0, 0};
+    // 2000-01-01 was a Saturday
+    rtc_calendar_t clndr = {TIME_CALC_YEAR_MIN, 1, 1, 6};
+
+    memset(&time_env, 0, sizeof(time_env));
+
+    // The RTC is divided for the nominal frequency, the RCX error is corrected in software
+    if (arch_clk_is_RCX20() && (rcx_time_data.rcx_period != 0))
+    {
+        time_env.rcx_period = rcx_time_data.rcx_period;
+        time_env.cfg_hz = (uint16_t)((1024000000UL + time_env.rcx_period / 2) / time_env.rcx_period);
+        time_env.stats.rcx_ppb = time_calc_rcx_ppb(time_env.cfg_hz, time_env.rcx_period);
+    }
+    else
+    {
+        time_env.cfg_hz = TIME_XTAL32_HZ;
+    }
+
+    // PD_TIM stays up in sleep
+    SetBits16(PMU_CTRL_REG, TIM_SLEEP, 0);
+    while ((GetWord16(SYS_STAT_REG) & TIM_IS_UP) != TIM_IS_UP);
+
+    rtc_clk_config(RTC_DIV_DENOM_1000, time_env.cfg_hz);
+    rtc_clock_enable();
+    rtc_init(&cfg);
+    rtc_set_time_clndr(&time, &clndr);
+}
+
+uint32_t app_time_now(uint8_t *hsec)
+{
+    uint64_t rtc = time_rtc_read();
+    uint64_t now;
+
+    time_rcx_update(rtc);
+
+    now = time_correct(rtc);
+    if (hsec != NULL)
+    {
+        *hsec = (uint8_t)(now % 100);
+    }
+
+    return (uint32_t)(now / 100);
+}
+
+void app_time_sync(uint32_t sec, uint8_t hsec, bool learn)
+{
+    uint64_t rtc = time_rtc_read();
+    uint64_t ref = (uint64_t)sec * 100 + hsec;
+
+    time_rcx_update(rtc);
+
+    if (learn && time_env.synced && (ref > time_env.sync_true + APP_TIME_LEARN_MIN))
+    {
+        int64_t offset = (int64_t)(ref - time_correct(rtc));
+        uint64_t interval = ref - time_env.sync_true;
+
+        // An offset faster than the clock can drift is a step of the reference
+        if (((offset < 0) ? -offset : offset) <= time_calc_drift(interval, APP_TIME_DRIFT_MAX_PPB))
+        {
+            time_env.stats.learned_ppb = time_calc_learn(time_env.stats.learned_ppb, offset, interval,
+                                                         APP_TIME_LEARN_TAU, APP_TIME_DRIFT_MAX_PPB);
+            time_env.stats.learned++;
+        }
+    }
+
+    time_anchor(rtc, ref);
+    time_env.sync_true = ref;
+    time_env.synced = true;
+    time_env.stats.syncs++;
+}
+
+bool app_time_is_synced(void)
+{
+    return time_env.synced;
+}
+
+const struct app_time_stats *app_time_get_stats(void)
+{
+    return &time_env.stats;
+}
+
+#if (BLE_CTS_SERVER)
+void app_time_ctss_read(struct cts_curr_time *ct)
+{
+    struct prf_date_time *dt = &ct->exact_time_256.day_date_time.date_time;
+    uint8_t hsec;
+    uint32_t sec = app_time_now(&hsec);
+    uint32_t sod = sec % 86400;
+
+    ct->exact_time_256.day_date_time.day_of_week = time_calc_date(sec / 86400, &dt->year, &dt->month, &dt->day);
+    dt->hour = sod / 3600;
+    dt->min = (sod / 60) % 60;
+    dt->sec = sod % 60;
+    ct->exact_time_256.fraction_256 = (hsec * 256) / 100;
+    ct->adjust_reason = 0;
+}
+
+uint8_t app_time_ctss_write(const struct cts_curr_time *ct)
+{
+    const struct prf_date_time *dt = &ct->exact_time_256.day_date_time.date_time;
+    uint32_t sec;
+
+    if ((dt->year < TIME_CALC_YEAR_MIN) || (dt->year > TIME_CALC_YEAR_MAX) ||
+        (dt->month < 1) || (dt->month > 12) || (dt->day < 1) || (dt->day > 31) ||
+        (dt->hour > 23) || (dt->min > 59) || (dt->sec > 59))
+    {
+        return ATT_ERR_APP_ERROR;
+    }
+
+    sec = time_calc_days(dt->year, dt->month, dt->day) * 86400UL + dt->hour * 3600UL + dt->min * 60UL + dt->sec;
+
+    // A new time zone or DST offset moves the local time on purpose
+    app_time_sync(sec, (ct->exact_time_256.fraction_256 * 100) / 256,
+                  !(ct->adjust_reason & (CTSS_REASON_FLAG_CHG_TIME_ZONE | CTSS_REASON_FLAG_DST_CHANGE)));
+
+    return ATT_ERR_NO_ERROR;
+}
+
+void app_time_ctss_ref_info(struct cts_ref_time_info *rt)
+{
+    uint64_t since;
+    uint64_t acc;
+
+    rt->time_source = 0;
+    if (!time_env.synced)
+    {
+        rt->time_accuracy = 255;
+        rt->days_update = 255;
+        rt->hours_update = 255;
+        return;
+    }
+
+    since = time_correct(time_rtc_read()) - time_env.sync_true;
+    // Drift since the synchronization in 1/8 s
+    acc = (uint64_t)time_calc_drift(since, (time_env.stats.learned != 0) ? APP_TIME_RESIDUAL_PPB :
+                                                                          APP_TIME_DRIFT_MAX_PPB) * 8 / 100;
+    rt->time_accuracy = (acc > 253) ? 254 : (uint8_t)acc;
+
+    since /= 360000;
+    if (since >= 255 * 24)
+    {
+        rt->days_update = 255;
+        rt->hours_update = 255;
+    }
+    else
+    {
+        rt->days_update = since / 24;
+        rt->hours_update = since % 24;
+    }
+}
+#endif // BLE_CTS_SERVER
+
+#endif // CFG_APP_TIME
+
+/// @} APP
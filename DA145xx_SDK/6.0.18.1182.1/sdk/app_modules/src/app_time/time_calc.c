@@ -0,0 +1,125 @@
+/**
+ ****************************************************************************************
+ *
+ * @file time_calc.c
+ *
+ * @brief Calendar and drift arithmetic of the time module.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include "time_calc.h"
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Days from 0000-03-01 to 2000-01-01 in the proleptic Gregorian calendar
+#define DAYS_0000_TO_2000           (730425UL)
+
+/// Days of a 400 year cycle
+#define DAYS_PER_ERA                (146097UL)
+
+/// Parts per billion
+#define PPB                         (1000000000LL)
+
+// Fields of the RTC registers, see RTC_TIME_REG and RTC_CALENDAR_REG
+#define BCD_FIELD(v, shift, mask)   (((v) >> (shift)) & (mask))
+#define BCD_2(v, shift, tmask)      (BCD_FIELD(v, (shift) + 4, tmask) * 10 + BCD_FIELD(v, shift, 0xF))
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+uint32_t time_calc_days(uint16_t year, uint8_t month, uint8_t mday)
+{
+    // The years start in March, the leap day is the last day of the year
+    uint32_t y = year - (month <= 2);
+    uint32_t m = (month + 9) % 12;
+
+    return (365 * y + y / 4 - y / 100 + y / 400 + (153 * m + 2) / 5 + mday - 1) - DAYS_0000_TO_2000;
+}
+
+uint8_t time_calc_date(uint32_t days, uint16_t *year, uint8_t *month, uint8_t *mday)
+{
+    uint32_t z = days + DAYS_0000_TO_2000;
+    uint32_t era = z / DAYS_PER_ERA;
+    uint32_t doe = z - era * DAYS_PER_ERA;
+    uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / (DAYS_PER_ERA - 1)) / 365;
+    uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    uint32_t mp = (5 * doy + 2) / 153;
+
+    *mday = (uint8_t)(doy - (153 * mp + 2) / 5 + 1);
+    *month = (uint8_t)(mp < 10 ? mp + 3 : mp - 9);
+    *year = (uint16_t)(era * 400 + yoe + (*month <= 2));
+
+    // 2000-01-01 was a Saturday
+    return (uint8_t)((days + 5) % 7 + 1);
+}
+
+uint32_t time_calc_clndr_bcd_to_days(uint32_t clndr_bcd)
+{
+    uint16_t year = BCD_2(clndr_bcd, 24, 0x3) * 100 + BCD_2(clndr_bcd, 16, 0xF);
+    uint8_t month = BCD_FIELD(clndr_bcd, 7, 0x1) * 10 + BCD_FIELD(clndr_bcd, 3, 0xF);
+    uint8_t mday = BCD_2(clndr_bcd, 8, 0x3);
+
+    return time_calc_days(year, month, mday);
+}
+
+uint32_t time_calc_time_bcd_to_cs(uint32_t time_bcd)
+{
+    uint32_t hour = BCD_2(time_bcd, 24, 0x3);
+    uint32_t min = BCD_2(time_bcd, 16, 0x7);
+    uint32_t sec = BCD_2(time_bcd, 8, 0x7);
+
+    return ((hour * 60 + min) * 60 + sec) * 100 + BCD_2(time_bcd, 0, 0xF);
+}
+
+int64_t time_calc_drift(uint64_t elapsed, int32_t ppb)
+{
+    return (int64_t)elapsed * ppb / PPB;
+}
+
+int32_t time_calc_learn(int32_t ppb, int64_t offset, uint64_t interval, uint64_t tau, int32_t max_ppb)
+{
+    int64_t rate = offset * PPB / (int64_t)interval;
+
+    // An offset that large is a step of the reference, not a drift
+    if (rate > max_ppb)
+    {
+        rate = max_ppb;
+    }
+    else if (rate < -max_ppb)
+    {
+        rate = -max_ppb;
+    }
+
+    rate = ppb + rate * (int64_t)interval / (int64_t)(interval + tau);
+
+    if (rate > max_ppb)
+    {
+        return max_ppb;
+    }
+    if (rate < -max_ppb)
+    {
+        return -max_ppb;
+    }
+    return (int32_t)rate;
+}
+
+int32_t time_calc_rcx_ppb(uint32_t cfg_hz, uint32_t period)
+{
+    // The RTC counts a second every cfg_hz cycles of period / 1024 us
+    return (int32_t)(((int64_t)cfg_hz * period - 1024000000LL) * 125 / 128);
+}
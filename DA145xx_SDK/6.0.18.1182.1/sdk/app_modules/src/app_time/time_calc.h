@@ -0,0 +1,126 @@
+/**
+ ****************************************************************************************
+ *
+ * @file time_calc.h
+ *
+ * @brief Calendar and drift arithmetic of the time module.
+ *
+ * Times are counted in hundredths of a second (cs) since 2000-01-01 00:00:00, the tick
+ * of the RTC. The functions only depend on the C library, they are also built on the
+ * host by utilities/host_tests/time_test.py.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _TIME_CALC_H_
+#define _TIME_CALC_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Hundredths of a second in a day
+#define TIME_CALC_CS_PER_DAY        (8640000UL)
+
+/// First year of the day count
+#define TIME_CALC_YEAR_MIN          (2000)
+
+/// Last year the RTC calendar and the 32-bit second count both reach
+#define TIME_CALC_YEAR_MAX          (2135)
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Count the days from 2000-01-01 to a date of the Gregorian calendar.
+ * @param[in] year      TIME_CALC_YEAR_MIN to TIME_CALC_YEAR_MAX
+ * @param[in] month     1 to 12
+ * @param[in] mday      1 to 31
+ * @return Days since 2000-01-01
+ ****************************************************************************************
+ */
+uint32_t time_calc_days(uint16_t year, uint8_t month, uint8_t mday);
+
+/**
+ ****************************************************************************************
+ * @brief Get the date of a day count.
+ * @param[in] days      Days since 2000-01-01
+ * @param[out] year     Year
+ * @param[out] month    Month, 1 to 12
+ * @param[out] mday     Day of the month, 1 to 31
+ * @return Day of the week, 1 for Monday to 7 for Sunday as in the Current Time Service
+ ****************************************************************************************
+ */
+uint8_t time_calc_date(uint32_t days, uint16_t *year, uint8_t *month, uint8_t *mday);
+
+/**
+ ****************************************************************************************
+ * @brief Get the day count of the RTC calendar register, century 20 or 21.
+ * @param[in] clndr_bcd Calendar register
+ * @return Days since 2000-01-01
+ ****************************************************************************************
+ */
+uint32_t time_calc_clndr_bcd_to_days(uint32_t clndr_bcd);
+
+/**
+ ****************************************************************************************
+ * @brief Get the time of the day of the RTC time register, 24-hour mode.
+ * @param[in] time_bcd  Time register
+ * @return Hundredths of a second since midnight
+ ****************************************************************************************
+ */
+uint32_t time_calc_time_bcd_to_cs(uint32_t time_bcd);
+
+/**
+ ****************************************************************************************
+ * @brief Get the correction of an interval measured by a clock that runs ppb parts per
+ *        billion slow.
+ * @param[in] elapsed   Interval on the clock, less than 2^63 / 10^9 cs (2900 years)
+ * @param[in] ppb       Rate error of the clock, positive when it runs slow
+ * @return Time to add to the interval, rounded towards zero
+ ****************************************************************************************
+ */
+int64_t time_calc_drift(uint64_t elapsed, int32_t ppb);
+
+/**
+ ****************************************************************************************
+ * @brief Update the rate error learned from the offset found at a time synchronization.
+ *        The rate measured over the interval is weighed by interval / (interval + tau),
+ *        so the jitter of the reference counts less over a long interval.
+ * @param[in] ppb       Rate error used over the interval
+ * @param[in] offset    Reference time minus the corrected time at the synchronization
+ * @param[in] interval  Time since the previous synchronization, not 0
+ * @param[in] tau       Interval at which the measurement gets half the weight
+ * @param[in] max_ppb   Largest rate error
+ * @return New rate error, clamped to +/- max_ppb
+ ****************************************************************************************
+ */
+int32_t time_calc_learn(int32_t ppb, int64_t offset, uint64_t interval, uint64_t tau, int32_t max_ppb);
+
+/**
+ ****************************************************************************************
+ * @brief Get the rate error of an RTC divided for a clock of cfg_hz that runs with a
+ *        measured period.
+ * @param[in] cfg_hz    Frequency the RTC divider is set for
+ * @param[in] period    Measured period in 1/1024 us, as rcx_time_data.rcx_period
+ * @return Rate error, positive when the RTC runs slow
+ ****************************************************************************************
+ */
+int32_t time_calc_rcx_ppb(uint32_t cfg_hz, uint32_t period);
+
+#endif // _TIME_CALC_H_
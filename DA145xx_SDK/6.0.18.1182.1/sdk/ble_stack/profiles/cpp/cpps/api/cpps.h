@@ -256,16 +256,6 @@ const struct prf_task_cbs* cpps_prf_itf_get(void);
  */
 uint8_t cpps_pack_meas_ntf(struct cpp_cp_meas *param, uint8_t *pckd_meas);
 
-/**
- ****************************************************************************************
- * @brief Splits notifications in order to be sent with default MTU
- * @param[in] conidx connection index
- * @param[out] meas_val message to split
- * @return length of the second notification
- ****************************************************************************************
- */
-uint8_t cpps_split_meas_ntf(uint8_t conidx, struct gattc_send_evt_cmd *meas_val);
-
 /**
  ****************************************************************************************
  * @brief updates the environment with the descriptor configuration and sends indication
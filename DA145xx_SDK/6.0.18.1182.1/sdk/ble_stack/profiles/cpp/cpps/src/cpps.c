@@ -85,6 +85,31 @@ static const struct attm_desc cpps_att_db[CPS_IDX_NB] =
     [CPS_IDX_CTNL_PT_IND_CFG]        =   {ATT_DESC_CLIENT_CHAR_CFG, PERM(RD, ENABLE) | PERM(WR, ENABLE) | PERM(WRITE_REQ, ENABLE), 0},
 };
 
+/// CP Measurement optional fields, in packing order
+static const struct prf_ntf_field cpps_meas_ntf_fields[] =
+{
+    {CPP_MEAS_PEDAL_POWER_BALANCE_PRESENT,        1},
+    {CPP_MEAS_ACCUM_TORQUE_PRESENT,               2},
+    {CPP_MEAS_WHEEL_REV_DATA_PRESENT,             6},
+    {CPP_MEAS_CRANK_REV_DATA_PRESENT,             4},
+    {CPP_MEAS_EXTREME_FORCE_MAGNITUDES_PRESENT,   4},
+    {CPP_MEAS_EXTREME_TORQUE_MAGNITUDES_PRESENT,  4},
+    {CPP_MEAS_EXTREME_ANGLES_PRESENT,             3},
+    {CPP_MEAS_TOP_DEAD_SPOT_ANGLE_PRESENT,        2},
+    {CPP_MEAS_BOTTOM_DEAD_SPOT_ANGLE_PRESENT,     2},
+    {CPP_MEAS_ACCUM_ENERGY_PRESENT,               2},
+};
+
+/// CP Measurement notification description
+static const struct prf_ntf_desc cpps_meas_ntf_desc =
+{
+    .fields       = cpps_meas_ntf_fields,
+    .nb_fields    = ARRAY_LEN(cpps_meas_ntf_fields),
+    .min_len      = CPP_CP_MEAS_NTF_MIN_LEN,
+    .status_flags = CPP_MEAS_PEDAL_POWER_BALANCE_REFERENCE | CPP_MEAS_ACCUM_TORQUE_SOURCE |
+                    CPP_MEAS_OFFSET_COMPENSATION_INDICATOR,
+};
+
 
 /*
  * EXPORTED FUNCTIONS DEFINITIONS
@@ -480,109 +505,6 @@ uint8_t cpps_pack_meas_ntf(struct cpp_cp_meas *param, uint8_t *pckd_meas)
     return pckd_meas_len;
 }
 
-uint8_t cpps_split_meas_ntf(uint8_t conidx, struct gattc_send_evt_cmd *meas_ntf1)
-{
-    // Get the address of the environment
-    struct cpps_env_tag *cpps_env = PRF_ENV_GET(CPPS, cpps);
-    // Extract flags info
-    uint16_t flags = co_read16p(&meas_ntf1->value[0]);
-    // Allocate the GATT notification message
-    struct gattc_send_evt_cmd *meas_ntf2 = KE_MSG_ALLOC_DYN(GATTC_SEND_EVT_CMD,
-            KE_BUILD_ID(TASK_GATTC, conidx), prf_src_task_get(&cpps_env->prf_env, conidx),
-            gattc_send_evt_cmd, CPP_CP_MEAS_NTF_MAX_LEN);
-
-    // Fill in the parameter structure
-    meas_ntf2->operation = GATTC_NOTIFY;
-    meas_ntf2->handle = CPPS_HANDLE(CPS_IDX_CP_MEAS_VAL);
-    meas_ntf2->length = CPP_CP_MEAS_NTF_MIN_LEN;
-
-    // Copy status flags
-    co_write16p(&meas_ntf2->value[0], (flags & (CPP_MEAS_PEDAL_POWER_BALANCE_REFERENCE |
-                                                CPP_MEAS_ACCUM_TORQUE_SOURCE |
-                                                CPP_MEAS_OFFSET_COMPENSATION_INDICATOR)));
-    // Copy Instantaneous power
-    memcpy(&meas_ntf2->value[2], &meas_ntf1->value[2], 2);
-
-    // Current position
-    uint8_t len = 0;
-
-    for (uint16_t feat = CPP_MEAS_PEDAL_POWER_BALANCE_PRESENT;
-            feat <= CPP_MEAS_OFFSET_COMPENSATION_INDICATOR;
-            feat <<= 1)
-    {
-        // First message fits within the MTU
-        if (meas_ntf1->length <= gattc_get_mtu(conidx) - 3)
-        {
-            // Stop splitting
-            break;
-        }
-
-        if (CPPS_IS_PRESENT(flags, feat))
-        {
-            switch (feat)
-            {
-                case CPP_MEAS_PEDAL_POWER_BALANCE_PRESENT:
-                    // Copy uint8
-                    meas_ntf2->value[meas_ntf2->length] = meas_ntf1->value[CPP_CP_MEAS_NTF_MIN_LEN];
-                    len = 1;
-                    break;
-
-                case CPP_MEAS_ACCUM_TORQUE_PRESENT:
-                case CPP_MEAS_TOP_DEAD_SPOT_ANGLE_PRESENT:
-                case CPP_MEAS_ACCUM_ENERGY_PRESENT:
-                case CPP_MEAS_BOTTOM_DEAD_SPOT_ANGLE_PRESENT:
-                    // Copy uint16
-                    memcpy(&meas_ntf2->value[meas_ntf2->length], &meas_ntf1->value[CPP_CP_MEAS_NTF_MIN_LEN], 2);
-                    len = 2;
-                    break;
-
-                case CPP_MEAS_EXTREME_ANGLES_PRESENT:
-                    // Copy uint24
-                    memcpy(&meas_ntf2->value[meas_ntf2->length], &meas_ntf1->value[CPP_CP_MEAS_NTF_MIN_LEN], 3);
-                    len = 3;
-                    break;
-
-                case CPP_MEAS_CRANK_REV_DATA_PRESENT:
-                case CPP_MEAS_EXTREME_FORCE_MAGNITUDES_PRESENT:
-                case CPP_MEAS_EXTREME_TORQUE_MAGNITUDES_PRESENT:
-                    // Copy uint16 + uint16
-                    memcpy(&meas_ntf2->value[meas_ntf2->length], &meas_ntf1->value[CPP_CP_MEAS_NTF_MIN_LEN], 4);
-                    len = 4;
-                    break;
-
-                case CPP_MEAS_WHEEL_REV_DATA_PRESENT:
-                    // Copy uint32 + uint16
-                    memcpy(&meas_ntf2->value[meas_ntf2->length], &meas_ntf1->value[CPP_CP_MEAS_NTF_MIN_LEN], 6);
-                    len = 6;
-                    break;
-
-                default:
-                    len = 0;
-                    break;
-            }
-
-            if (len)
-            {
-                // Update values
-                meas_ntf2->length += len;
-                // Remove field and flags from the first ntf
-                meas_ntf1->length -= len;
-                memcpy(&meas_ntf1->value[CPP_CP_MEAS_NTF_MIN_LEN],
-                        &meas_ntf1->value[CPP_CP_MEAS_NTF_MIN_LEN + len],
-                        meas_ntf1->length);
-                // Update flags
-                meas_ntf1->value[0] &= ~feat;
-                meas_ntf2->value[0] |= feat;
-            }
-        }
-    }
-
-    // store the pending notification to send
-    cpps_env->op_data->ntf_pending = meas_ntf2;
-
-    return meas_ntf2->length;
-}
-
 uint8_t cpps_update_characteristic_config(uint8_t conidx, uint8_t prfl_config, struct gattc_write_req_ind const *param)
 {
     // Get the address of the environment
@@ -1375,8 +1297,18 @@ void cpps_exe_operation(void)
 
                     if (meas_val->length > gattc_get_mtu(conidx) - 3)
                     {
-                        // Split (if necessary)
-                        cpps_split_meas_ntf(conidx, meas_val);
+                        // Split, the second notification is sent next
+                        struct gattc_send_evt_cmd *meas_ntf2 = KE_MSG_ALLOC_DYN(GATTC_SEND_EVT_CMD,
+                                KE_BUILD_ID(TASK_GATTC, conidx), prf_src_task_get(&(cpps_env->prf_env),conidx),
+                                gattc_send_evt_cmd, CPP_CP_MEAS_NTF_MAX_LEN);
+
+                        meas_ntf2->operation = GATTC_NOTIFY;
+                        meas_ntf2->handle = CPPS_HANDLE(CPS_IDX_CP_MEAS_VAL);
+                        meas_val->length = prf_ntf_split(&cpps_meas_ntf_desc, meas_val->value, meas_val->length,
+                                                         gattc_get_mtu(conidx) - 3, meas_ntf2->value,
+                                                         &meas_ntf2->length);
+
+                        cpps_env->op_data->ntf_pending = meas_ntf2;
                     }
 
                     // Restore flags value
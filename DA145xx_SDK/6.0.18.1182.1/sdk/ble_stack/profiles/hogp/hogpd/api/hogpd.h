@@ -137,8 +137,8 @@ struct hogpd_svc_cfg
     uint8_t  nb_report;
     /// Handle offset where report are available - to enhance handle search
     uint8_t  report_hdl_offset;
-    /// Current Protocol Mode
-    uint8_t  proto_mode;
+    /// Current Protocol Mode of each connection
+    uint8_t  proto_mode[BLE_CONNECTION_MAX];
 };
 
 /// HIDS on-going operation
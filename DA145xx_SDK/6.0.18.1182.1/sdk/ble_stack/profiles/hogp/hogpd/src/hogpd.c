@@ -160,7 +160,7 @@ static uint8_t hogpd_init (struct prf_task_env* env, uint16_t* start_hdl, uint16
     // Status
     uint8_t status = GAP_ERR_NO_ERROR;
     // Service Instance Counter, Counter
-    uint8_t svc_idx, report_idx;
+    uint8_t svc_idx, report_idx, conidx;
     // Report Char. Report Ref value
     struct hids_report_ref report_ref;
 
@@ -368,7 +368,10 @@ static uint8_t hogpd_init (struct prf_task_env* env, uint16_t* start_hdl, uint16
 
 
         // by default in Report protocol mode.
-        hogpd_env->svcs[svc_idx].proto_mode = HOGP_REPORT_PROTOCOL_MODE;
+        for (conidx = 0; conidx < BLE_CONNECTION_MAX; conidx++)
+        {
+            hogpd_env->svcs[svc_idx].proto_mode[conidx] = HOGP_REPORT_PROTOCOL_MODE;
+        }
 
     }
 
@@ -453,10 +456,11 @@ static void hogpd_cleanup(struct prf_task_env* env, uint8_t conidx, uint8_t reas
     ASSERT_ERROR(conidx < BLE_CONNECTION_MAX);
 
     // Reset the notification configuration to ensure that no notification will be sent on
-    // a disconnected link
+    // a disconnected link, and the protocol mode for the next connection
     for (svc_idx = 0; svc_idx < hogpd_env->hids_nb; svc_idx++)
     {
         hogpd_env->svcs[svc_idx].ntf_cfg[conidx] = 0;
+        hogpd_env->svcs[svc_idx].proto_mode[conidx] = HOGP_REPORT_PROTOCOL_MODE;
     }
 }
 
@@ -814,7 +818,7 @@ uint8_t hogpd_ntf_send(uint8_t conidx, const struct hogpd_report_info* report)
         status = PRF_ERR_NTF_DISABLED;
     }
     // check if protocol mode is valid
-    else if((hogpd_env->svcs[report->hid_idx].proto_mode != exp_prot_mode)
+    else if((hogpd_env->svcs[report->hid_idx].proto_mode[conidx] != exp_prot_mode)
             && ((hogpd_env->svcs[report->hid_idx].features & HOGPD_CFG_PROTO_MODE) != 0))
     {
         status = PRF_ERR_REQ_DISALLOWED;
@@ -310,7 +310,7 @@ static int hogpd_proto_mode_cfm_handler(ke_msg_id_t const msgid,
             if(handle == hogpd_env->op.handle)
             {
                 status = GAP_ERR_NO_ERROR;
-                hogpd_env->svcs[param->hid_idx].proto_mode = param->proto_mode;
+                hogpd_env->svcs[param->hid_idx].proto_mode[param->conidx] = param->proto_mode;
             }
         }
 
@@ -648,7 +648,7 @@ static int gattc_read_req_ind_handler(ke_msg_id_t const msgid,
                 //  ------------ READ active protocol mode
                 case HOGPD_IDX_PROTO_MODE_VAL:
                 {
-                    value =  hogpd_env->svcs[hid_idx].proto_mode;
+                    value =  hogpd_env->svcs[hid_idx].proto_mode[conidx];
                     length = sizeof(uint8_t);
                 }break;
 
@@ -277,16 +277,6 @@ uint8_t lans_pack_loc_speed_ntf(struct lanp_loc_speed *param, uint8_t *pckd_loc_
  */
 uint8_t lans_pack_navigation_ntf(struct lanp_navigation *param, uint8_t *pckd_navigation);
 
-/**
- ****************************************************************************************
- * @brief Splits notifications in order to be sent with default MTU
- * @param[in] conidx connection index
- * @param[in/out] loc_speed_ntf1 first notification
- * @return length
- ****************************************************************************************
- */
-uint8_t lans_split_loc_speed_ntf(uint8_t conidx, struct gattc_send_evt_cmd *loc_speed_ntf1);
-
 /**
  ****************************************************************************************
  * @brief updates the environment with the descriptor configuration and sends indication
@@ -83,6 +83,29 @@ static const struct attm_desc lans_att_db[LNS_IDX_NB] =
     [LNS_IDX_NAVIGATION_NTF_CFG]    =   {ATT_DESC_CLIENT_CHAR_CFG, PERM(RD, ENABLE) | PERM(WR, ENABLE) | PERM(WRITE_REQ, ENABLE), 0},
 };
 
+/// Location and Speed optional fields, in packing order
+static const struct prf_ntf_field lans_loc_speed_ntf_fields[] =
+{
+    {LANP_LSPEED_INST_SPEED_PRESENT,        2},
+    {LANP_LSPEED_TOTAL_DISTANCE_PRESENT,    3},
+    {LANP_LSPEED_LOCATION_PRESENT,          8},
+    {LANP_LSPEED_ELEVATION_PRESENT,         3},
+    {LANP_LSPEED_HEADING_PRESENT,           2},
+    {LANP_LSPEED_ROLLING_TIME_PRESENT,      1},
+    {LANP_LSPEED_UTC_TIME_PRESENT,          7},
+};
+
+/// Location and Speed notification description
+static const struct prf_ntf_desc lans_loc_speed_ntf_desc =
+{
+    .fields       = lans_loc_speed_ntf_fields,
+    .nb_fields    = ARRAY_LEN(lans_loc_speed_ntf_fields),
+    .min_len      = LANP_LAN_LOC_SPEED_MIN_LEN,
+    .status_flags = LANP_LSPEED_POSITION_STATUS_LSB | LANP_LSPEED_POSITION_STATUS_MSB |
+                    LANP_LSPEED_SPEED_AND_DISTANCE_FORMAT | LANP_LSPEED_ELEVATION_SOURCE_LSB |
+                    LANP_LSPEED_ELEVATION_SOURCE_MSB | LANP_LSPEED_HEADING_SOURCE,
+};
+
 /*
  * EXPORTED FUNCTIONS DEFINITIONS
  ****************************************************************************************
@@ -444,115 +467,6 @@ uint8_t lans_pack_loc_speed_ntf(struct lanp_loc_speed *param, uint8_t *pckd_loc_
     return pckd_loc_speed_len;
 }
 
-uint8_t lans_split_loc_speed_ntf(uint8_t conidx, struct gattc_send_evt_cmd *loc_speed_ntf1)
-{
-    // Get the address of the environment
-    struct lans_env_tag *lans_env = PRF_ENV_GET(LANS, lans);
-    // Extract flags info
-    uint16_t flags = co_read16p(&loc_speed_ntf1->value[0]);
-    // Allocate the GATT notification message
-    struct gattc_send_evt_cmd *loc_speed_ntf2 = KE_MSG_ALLOC_DYN(GATTC_SEND_EVT_CMD,
-            KE_BUILD_ID(TASK_GATTC, conidx), prf_src_task_get(&(lans_env->prf_env), conidx),
-            gattc_send_evt_cmd, LANP_LAN_LOC_SPEED_MAX_LEN);
-
-    // Fill in the parameter structure
-    loc_speed_ntf2->operation = GATTC_NOTIFY;
-    loc_speed_ntf2->handle = LANS_HANDLE(LNS_IDX_LOC_SPEED_VAL);
-    loc_speed_ntf2->length = LANP_LAN_LOC_SPEED_MIN_LEN;
-
-    // Copy status flags
-    co_write16p(&loc_speed_ntf2->value[0], (flags & (LANP_LSPEED_POSITION_STATUS_LSB |
-                                    LANP_LSPEED_POSITION_STATUS_MSB |
-                                    LANP_LSPEED_SPEED_AND_DISTANCE_FORMAT |
-                                    LANP_LSPEED_ELEVATION_SOURCE_LSB |
-                                    LANP_LSPEED_ELEVATION_SOURCE_MSB |
-                                    LANP_LSPEED_HEADING_SOURCE)));
-    // Current position
-    uint8_t len = 0;
-
-    for (uint16_t feat = LANP_LSPEED_INST_SPEED_PRESENT;
-            feat <= LANP_LSPEED_POSITION_STATUS_LSB;
-            feat <<= 1)
-    {
-        // First message fits within the MTU
-        if (loc_speed_ntf1->length <= gattc_get_mtu(conidx) - 3)
-        {
-            // Stop splitting
-            break;
-        }
-
-        if (LANS_IS_PRESENT(flags, feat))
-        {
-            switch (feat)
-            {
-                case LANP_LSPEED_ROLLING_TIME_PRESENT:
-                    // Copy uint8
-                    loc_speed_ntf2->value[loc_speed_ntf2->length] =
-                            loc_speed_ntf1->value[LANP_LAN_LOC_SPEED_MIN_LEN];
-                    len = 1;
-                    break;
-
-                case LANP_LSPEED_INST_SPEED_PRESENT:
-                case LANP_LSPEED_HEADING_PRESENT:
-                    // Copy uint16
-                    memcpy(&loc_speed_ntf2->value[loc_speed_ntf2->length],
-                            &loc_speed_ntf1->value[LANP_LAN_LOC_SPEED_MIN_LEN],
-                            2);
-                    len = 2;
-                    break;
-
-                case LANP_LSPEED_TOTAL_DISTANCE_PRESENT:
-                case LANP_LSPEED_ELEVATION_PRESENT:
-                    // Copy uint24
-                    memcpy(&loc_speed_ntf2->value[loc_speed_ntf2->length],
-                            &loc_speed_ntf1->value[LANP_LAN_LOC_SPEED_MIN_LEN],
-                            3);
-                    len = 3;
-                    break;
-
-                case LANP_LSPEED_LOCATION_PRESENT:
-                    // Copy latitude and longitude
-                    memcpy(&loc_speed_ntf2->value[loc_speed_ntf2->length],
-                            &loc_speed_ntf1->value[LANP_LAN_LOC_SPEED_MIN_LEN],
-                            8);
-                    len = 8;
-                    break;
-
-                case LANP_LSPEED_UTC_TIME_PRESENT:
-                    // Copy time
-                    memcpy(&loc_speed_ntf2->value[loc_speed_ntf2->length],
-                            &loc_speed_ntf1->value[LANP_LAN_LOC_SPEED_MIN_LEN],
-                            7);
-                    len = 7;
-                    break;
-
-                default:
-                    len = 0;
-                    break;
-            }
-
-            if (len)
-            {
-                // Update values
-                loc_speed_ntf2->length += len;
-                // Remove field and flags from the first ntf
-                loc_speed_ntf1->length -= len;
-                memcpy(&loc_speed_ntf1->value[LANP_LAN_LOC_SPEED_MIN_LEN],
-                        &loc_speed_ntf1->value[LANP_LAN_LOC_SPEED_MIN_LEN + len],
-                        loc_speed_ntf1->length);
-                // Update flags
-                loc_speed_ntf1->value[0] &= ~feat;
-                loc_speed_ntf2->value[0] |= feat;
-            }
-        }
-    }
-
-    // store the pending notification to send
-    lans_env->op_data->ntf_pending = loc_speed_ntf2;
-
-    return loc_speed_ntf2->length;
-}
-
 uint8_t lans_update_characteristic_config(uint8_t conidx, uint8_t prfl_config, struct gattc_write_req_ind const *param)
 {
     // Get the address of the environment
@@ -1274,8 +1188,18 @@ void lans_exe_operation(void)
 
                     if (meas_val->length > gattc_get_mtu(conidx) - 3)
                     {
-                        // Split (if necessary)
-                        lans_split_loc_speed_ntf(conidx, meas_val);
+                        // Split, the second notification is sent next
+                        struct gattc_send_evt_cmd *loc_speed_ntf2 = KE_MSG_ALLOC_DYN(GATTC_SEND_EVT_CMD,
+                                KE_BUILD_ID(TASK_GATTC, conidx), prf_src_task_get(&(lans_env->prf_env),conidx),
+                                gattc_send_evt_cmd, LANP_LAN_LOC_SPEED_MAX_LEN);
+
+                        loc_speed_ntf2->operation = GATTC_NOTIFY;
+                        loc_speed_ntf2->handle = LANS_HANDLE(LNS_IDX_LOC_SPEED_VAL);
+                        meas_val->length = prf_ntf_split(&lans_loc_speed_ntf_desc, meas_val->value, meas_val->length,
+                                                         gattc_get_mtu(conidx) - 3, loc_speed_ntf2->value,
+                                                         &loc_speed_ntf2->length);
+
+                        lans_env->op_data->ntf_pending = loc_speed_ntf2;
                     }
 
                     // Restore flags value
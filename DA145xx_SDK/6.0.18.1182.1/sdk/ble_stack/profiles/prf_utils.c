@@ -29,6 +29,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include "ke_task.h"
 #include "co_error.h"
 #include "attm.h"
@@ -526,5 +527,38 @@ uint8_t prf_unpack_date_time(uint8_t *packed_date, struct prf_date_time* date_ti
 #endif
 #endif /* ((BLE_SERVER_PRF || BLE_CLIENT_PRF)) */
 
+#if (BLE_CP_SENSOR || BLE_LN_SENSOR)
+uint8_t prf_ntf_split(const struct prf_ntf_desc *desc, uint8_t *value, uint8_t length, uint16_t max_len,
+                      uint8_t *value2, uint16_t *length2)
+{
+    uint16_t flags = co_read16p(&value[0]);
+    uint16_t split_flags = 0;
+    uint8_t split_len = 0;
+    uint8_t i;
+
+    // Move the leading fields until the first notification fits
+    for (i = 0; (i < desc->nb_fields) && (length - split_len > max_len); i++)
+    {
+        if (flags & desc->fields[i].flag)
+        {
+            split_flags |= desc->fields[i].flag;
+            split_len += desc->fields[i].len;
+        }
+    }
+
+    // Second notification: status flags, mandatory part and the moved fields, which
+    // follow the mandatory part in the packed value
+    co_write16p(&value2[0], (flags & desc->status_flags) | split_flags);
+    memcpy(&value2[2], &value[2], desc->min_len - 2 + split_len);
+    *length2 = desc->min_len + split_len;
+
+    // First notification: the remaining fields move up once
+    co_write16p(&value[0], flags & ~split_flags);
+    memmove(&value[desc->min_len], &value[desc->min_len + split_len], length - desc->min_len - split_len);
+
+    return length - split_len;
+}
+#endif /* (BLE_CP_SENSOR || BLE_LN_SENSOR) */
+
 /// @} PRF_UTILS
 
@@ -361,6 +361,52 @@ uint8_t prf_unpack_date_time(uint8_t *packed_date, struct prf_date_time* date_ti
 
 #endif /* (BLE_SERVER_PRF || BLE_CLIENT_PRF) */
 
+#if (BLE_CP_SENSOR || BLE_LN_SENSOR)
+/// Optional field of a notification that can be moved to a second notification
+struct prf_ntf_field
+{
+    /// Presence flag of the field
+    uint16_t flag;
+    /// Packed length of the field
+    uint8_t len;
+};
+
+/// Description of a notification made of a 16-bit flags field, mandatory fields and
+/// optional fields packed in flag order
+struct prf_ntf_desc
+{
+    /// Optional fields, in packing order
+    const struct prf_ntf_field *fields;
+    /// Number of optional fields
+    uint8_t nb_fields;
+    /// Length of the mandatory part, flags included
+    uint8_t min_len;
+    /// Flags copied to both notifications when the value is split
+    uint16_t status_flags;
+};
+
+/**
+ ****************************************************************************************
+ * @brief Split a notification value that exceeds the maximum notification length.
+ *
+ * The leading optional fields are moved to a second notification until the first one
+ * fits. The second notification gets the mandatory part, the status flags and the moved
+ * fields, the other fields move up in the first one.
+ *
+ * @param[in]     desc     Notification description
+ * @param[in,out] value    Packed value, the first notification on return
+ * @param[in]     length   Packed length
+ * @param[in]     max_len  Maximum notification length of the connection (MTU - 3)
+ * @param[out]    value2   Second notification
+ * @param[out]    length2  Length of the second notification
+ *
+ * @return Length of the first notification
+ ****************************************************************************************
+ */
+uint8_t prf_ntf_split(const struct prf_ntf_desc *desc, uint8_t *value, uint8_t length, uint16_t max_len,
+                      uint8_t *value2, uint16_t *length2);
+#endif /* (BLE_CP_SENSOR || BLE_LN_SENSOR) */
+
 /// @} prf_utils
 
 #endif /* _PRF_UTILS_H_ */
@@ -439,6 +439,10 @@ __STATIC_INLINE void schedule_while_ble_on(void)
             rcx20_read_freq();
 #endif
 
+#if defined (__DA14531__) && defined (CFG_RF_CAL_SCHED)
+            // the scheduler checks the time left to the next event itself
+            conditionally_run_radio_cals();
+#else
             uint32_t sleep_duration = 0;
             //if you have enough time run a temperature calibration of the radio
             if (ea_sleep_check(&sleep_duration, 4)) //6 slots -> 3.750 ms
@@ -446,6 +450,7 @@ __STATIC_INLINE void schedule_while_ble_on(void)
                 // check time and temperature to run radio calibrations.
                 conditionally_run_radio_cals();
             }
+#endif
         }
 #endif
 
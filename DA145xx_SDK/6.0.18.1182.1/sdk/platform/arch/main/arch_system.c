@@ -60,6 +60,10 @@
 #include "adc.h"
 #include "otp_cs.h"
 #include "syscntl.h"
+#if defined (CFG_RF_CAL_SCHED) && !defined (__NON_BLE_EXAMPLE__)
+#include "ea.h"
+#include "reg_blecore.h"
+#endif
 #endif
 
 #if (USE_RANGE_EXT)
@@ -137,6 +141,27 @@ volatile uint32_t startup_sleep_delay = STARTUP_SLEEP_DELAY_DEFAULT;
 int8_t last_temp    __SECTION_ZERO("retention_mem_area0");
 /// Radio calibration counter increasing by one just before calibration runs
 static uint32_t rfcal_count __SECTION_ZERO("retention_mem_area0");
+
+#if defined (CFG_RF_CAL_SCHED)
+/// RF calibration scheduler environment
+struct rf_cal_sched_env_tag
+{
+    /// Statistics
+    struct arch_rf_cal_stats stats;
+    /// Slots elapsed and not yet counted in stats.seconds
+    uint16_t slots_rem;
+    /// Time between the last and the next temperature sample, in slots
+    uint16_t period;
+    /// Temperature slope in milli-degrees Celsius per second, smoothed over the samples
+    int32_t slope;
+    /// Last temperature sample
+    int8_t sample_temp;
+    /// A calibration is due and waits for a long enough gap between two events
+    bool pending;
+};
+
+static struct rf_cal_sched_env_tag rf_cal_sched_env __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+#endif
 #else
 uint16_t last_temp_count    __SECTION_ZERO("retention_mem_area0"); // temperature counter
 #endif
@@ -650,10 +675,238 @@ uint16_t get_rc16m_count(void)
 
 void rf_recalibration(void);
 
+#if defined (__DA14531__) && !defined (__FPGA__)
+/**
+ ****************************************************************************************
+ * @brief Read the die temperature through the GPADC. The GPADC configuration is restored.
+ * @return Temperature in degrees Celsius
+ ****************************************************************************************
+ */
+static int8_t rf_cal_read_temp(void)
+{
+    // Store the current content of the following registers:
+    // - GP_ADC_CTRL_REG,
+    // - GP_ADC_CTRL2_REG,
+    // - GP_ADC_CTRL3_REG,
+    // - GP_ADC_SEL_REG.
+    uint16_t tmp_adc_ctrl_reg  = GetWord16(GP_ADC_CTRL_REG);
+    uint16_t tmp_adc_ctrl2_reg = GetWord16(GP_ADC_CTRL2_REG);
+    uint16_t tmp_adc_ctrl3_reg = GetWord16(GP_ADC_CTRL3_REG);
+    uint16_t tmp_adc_sel_reg   = GetWord16(GP_ADC_SEL_REG);
+
+    adc_config_t cfg =
+    {
+        .input_mode = ADC_INPUT_MODE_SINGLE_ENDED,
+        .input      = ADC_INPUT_SE_TEMP_SENS,
+        .continuous = false
+    };
+
+    // Initialize and enable ADC
+    adc_init(&cfg);
+
+    int8_t current_temp = adc_get_temp();
+
+    // Restore the content of the ADC CTRL and SEL registers
+    SetWord16(GP_ADC_CTRL2_REG, tmp_adc_ctrl2_reg);
+    SetWord16(GP_ADC_CTRL3_REG, tmp_adc_ctrl3_reg);
+    SetWord16(GP_ADC_SEL_REG, tmp_adc_sel_reg);
+    SetWord16(GP_ADC_CTRL_REG, tmp_adc_ctrl_reg);
+
+    return current_temp;
+}
+#endif
+
+#if defined (__DA14531__) && !defined (__FPGA__) && defined (CFG_RF_CAL_SCHED)
+/**
+ ****************************************************************************************
+ * @brief Check that the next event of the exchange memory leaves enough time.
+ * @param[in] slots Time needed, in slots of 625us
+ * @return true if the next event is at least that far
+ ****************************************************************************************
+ */
+static bool rf_cal_sched_fits(uint32_t slots)
+{
+    uint32_t sleep_duration = 0;
+
+    return ea_sleep_check(&sleep_duration, slots);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Read the BLE core timer.
+ * @param[out] slot Base time counter, in slots
+ * @return Time elapsed in the slot, in us
+ ****************************************************************************************
+ */
+static uint32_t rf_cal_sched_now(uint32_t *slot)
+{
+    *slot = lld_evt_time_get();
+    // The fine counter counts down the microseconds of the slot
+    uint32_t fine = ble_finetimecnt_get() & BLE_FINECNT_MASK;
+
+    return (fine < 625) ? (624 - fine) : 0;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Predict when the drift from the last calibration reaches the threshold and set
+ *        the time to the next temperature sample.
+ * @param[in] drift Temperature of the last sample minus the temperature of the last
+ *                  calibration
+ * @return Predicted time to the threshold in slots, UINT32_MAX if the temperature does
+ *         not move away from the one of the last calibration
+ ****************************************************************************************
+ */
+static uint32_t rf_cal_sched_predict(int drift)
+{
+    int32_t slope = rf_cal_sched_env.slope;
+    uint32_t time = UINT32_MAX;
+    uint32_t period;
+
+    if (co_abs(drift) >= RF_CAL_SCHED_THRESHOLD)
+    {
+        time = 0;
+    }
+    else if ((slope != 0) && ((drift == 0) || ((drift < 0) == (slope < 0))))
+    {
+        time = (uint32_t)(RF_CAL_SCHED_THRESHOLD - co_abs(drift)) * 1000 * 1600 / co_abs(slope);
+    }
+
+    period = co_min(time / 2, RF_CAL_SCHED_MAX_PERIOD);
+    // Sample again before a change at the largest slope can take the drift past the threshold
+    if (co_abs(drift) <= RF_CAL_SCHED_THRESHOLD)
+    {
+        period = co_min(period, (uint32_t)(RF_CAL_SCHED_THRESHOLD + 1 - co_abs(drift)) * 1000 * 1600 / RF_CAL_SCHED_MAX_SLOPE);
+    }
+    rf_cal_sched_env.period = co_max(period, RF_CAL_SCHED_MIN_PERIOD);
+
+    return time;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Take a temperature sample and decide if a calibration is due. The calibration is
+ *        due when the drift from the last calibration reaches the threshold, or when the
+ *        slope predicts that the drift reaches it before the next sample.
+ * @param[in] now Base time counter, in slots
+ ****************************************************************************************
+ */
+static void rf_cal_sched_sample(uint32_t now)
+{
+    struct rf_cal_sched_env_tag *env = &rf_cal_sched_env;
+    uint32_t elapsed = (now - last_temp_time) & BLE_BASETIMECNT_MASK;
+    int8_t temp = rf_cal_read_temp();
+    int drift;
+
+    env->stats.samples++;
+    last_temp_time = now;
+
+    if (last_temp == 127)
+    {
+        last_temp = temp;
+        env->sample_temp = temp;
+        env->period = RF_CAL_SCHED_MIN_PERIOD;
+        return;
+    }
+
+    if (elapsed != 0)
+    {
+        // Slope since the previous sample, smoothed with a weight of 1/2
+        int32_t slope = (int32_t)(temp - env->sample_temp) * 1000 * 1600 / (int32_t)co_min(elapsed, 0xFFFFF);
+
+        env->slope += (slope - env->slope) / 2;
+    }
+    env->sample_temp = temp;
+
+    elapsed += env->slots_rem;
+    env->stats.seconds += elapsed / 1600;
+    env->slots_rem = elapsed % 1600;
+
+    drift = temp - last_temp;
+    if ((rf_cal_sched_predict(drift) < RF_CAL_SCHED_MIN_PERIOD) && !env->pending)
+    {
+        if (co_abs(drift) < RF_CAL_SCHED_THRESHOLD)
+        {
+            env->stats.early++;
+        }
+        env->pending = true;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Run the RF calibration scheduler, after the end of an event. A due calibration
+ *        only runs when the next event leaves enough time for it, it is deferred
+ *        otherwise, unless the drift exceeds the threshold by RF_CAL_SCHED_FORCE_DRIFT.
+ ****************************************************************************************
+ */
+static void rf_cal_sched_run(void)
+{
+    struct rf_cal_sched_env_tag *env = &rf_cal_sched_env;
+    uint32_t now = lld_evt_time_get();
+    uint32_t start_slot, end_slot, start_us, end_us, delta, slots;
+
+    if ((last_temp == 127) ||
+        (((now - last_temp_time) & BLE_BASETIMECNT_MASK) >= env->period))
+    {
+        if (!rf_cal_sched_fits(RF_CAL_SCHED_SAMPLE_SLOTS))
+        {
+            return;
+        }
+        rf_cal_sched_sample(now);
+    }
+
+    if (!env->pending)
+    {
+        return;
+    }
+
+    slots = co_max((env->stats.cal_max_us + 624) / 625, RF_CAL_SCHED_CAL_SLOTS) + RF_CAL_SCHED_GUARD_SLOTS;
+    if (!rf_cal_sched_fits(slots) &&
+        ((co_abs(env->sample_temp - last_temp) < RF_CAL_SCHED_THRESHOLD + RF_CAL_SCHED_FORCE_DRIFT) ||
+         !rf_cal_sched_fits(RF_CAL_SCHED_SAMPLE_SLOTS)))
+    {
+        env->stats.deferrals++;
+        return;
+    }
+
+    start_us = rf_cal_sched_now(&start_slot);
+    rfcal_count++;
+    rf_recalibration();
+    end_us = rf_cal_sched_now(&end_slot);
+
+    delta = ((end_slot - start_slot) & BLE_BASETIMECNT_MASK) * 625 + end_us - start_us;
+    // Guard against a fine counter sampled right at the slot boundary
+    if ((int32_t)delta < 0)
+    {
+        delta = 0;
+    }
+    env->stats.calibrations++;
+    env->stats.cal_time_us += delta;
+    env->stats.cal_max_us = co_max(env->stats.cal_max_us, delta);
+
+    last_temp = env->sample_temp;
+    env->pending = false;
+    rf_cal_sched_predict(0);
+}
+
+const struct arch_rf_cal_stats *arch_rf_cal_get_stats(void)
+{
+    struct arch_rf_cal_stats *stats = &rf_cal_sched_env.stats;
+
+    stats->per_hour = (stats->seconds != 0) ? (stats->calibrations * 3600 / stats->seconds) : 0;
+
+    return stats;
+}
+#endif
+
 void conditionally_run_radio_cals(void)
 {
 #if !defined (__FPGA__)
 #if defined (__DA14531__)
+#if defined (CFG_RF_CAL_SCHED)
+    rf_cal_sched_run();
+#else
     // 531 case
     uint32_t current_time = lld_evt_time_get();
 
@@ -666,27 +919,7 @@ void conditionally_run_radio_cals(void)
     {
         last_temp_time = current_time;
 
-        // Store the current content of the following registers:
-        // - GP_ADC_CTRL_REG,
-        // - GP_ADC_CTRL2_REG,
-        // - GP_ADC_CTRL3_REG,
-        // - GP_ADC_SEL_REG.
-        uint16_t tmp_adc_ctrl_reg  = GetWord16(GP_ADC_CTRL_REG);
-        uint16_t tmp_adc_ctrl2_reg = GetWord16(GP_ADC_CTRL2_REG);
-        uint16_t tmp_adc_ctrl3_reg = GetWord16(GP_ADC_CTRL3_REG);
-        uint16_t tmp_adc_sel_reg   = GetWord16(GP_ADC_SEL_REG);
-
-        adc_config_t cfg =
-        {
-            .input_mode = ADC_INPUT_MODE_SINGLE_ENDED,
-            .input      = ADC_INPUT_SE_TEMP_SENS,
-            .continuous = false
-        };
-
-        // Initialize and enable ADC
-        adc_init(&cfg);
-
-        int8_t current_temp = adc_get_temp();
+        int8_t current_temp = rf_cal_read_temp();
 
         if (last_temp == 127)
         {
@@ -711,13 +944,8 @@ void conditionally_run_radio_cals(void)
                 last_temp = current_temp;
             }
         }
-
-        // Restore the content of the ADC CTRL and SEL registers
-        SetWord16(GP_ADC_CTRL2_REG, tmp_adc_ctrl2_reg);
-        SetWord16(GP_ADC_CTRL3_REG, tmp_adc_ctrl3_reg);
-        SetWord16(GP_ADC_SEL_REG, tmp_adc_sel_reg);
-        SetWord16(GP_ADC_CTRL_REG, tmp_adc_ctrl_reg);
     }
+#endif // CFG_RF_CAL_SCHED
 #else
     // 585/586 case
     uint16_t count, count_diff;
@@ -37,6 +37,62 @@
     #define RCX_CALIB_TIME      20
 #endif
 
+#if defined (__DA14531__) && defined (CFG_RF_CAL_SCHED)
+// Drift of the die temperature since the last RF calibration that requires a new one, in
+// degrees Celsius
+#ifndef RF_CAL_SCHED_THRESHOLD
+#define RF_CAL_SCHED_THRESHOLD      (8)
+#endif
+
+// Shortest and longest time between two temperature samples, in slots of 625us. The time
+// is half the predicted time to the threshold, within these bounds.
+#ifndef RF_CAL_SCHED_MIN_PERIOD
+#define RF_CAL_SCHED_MIN_PERIOD     (1600)      // 1s
+#endif
+#ifndef RF_CAL_SCHED_MAX_PERIOD
+#define RF_CAL_SCHED_MAX_PERIOD     (12800)     // 8s
+#endif
+
+// Largest expected slope of the die temperature, in milli-degrees Celsius per second. The
+// next sample is taken before a change at this slope can exceed the threshold by one degree.
+#ifndef RF_CAL_SCHED_MAX_SLOPE
+#define RF_CAL_SCHED_MAX_SLOPE      (1000)
+#endif
+
+// Gap to the next event needed for a temperature sample, in slots
+#define RF_CAL_SCHED_SAMPLE_SLOTS   (4)
+
+// Gap kept free after a calibration, in slots. The calibration also needs the longest
+// time it has taken so far, RF_CAL_SCHED_CAL_SLOTS before the first one.
+#define RF_CAL_SCHED_GUARD_SLOTS    (2)
+#define RF_CAL_SCHED_CAL_SLOTS      (4)
+
+// Drift beyond the threshold, in degrees Celsius, at which a deferred calibration runs in
+// any gap long enough for a temperature sample
+#define RF_CAL_SCHED_FORCE_DRIFT    (2)
+
+/// RF calibration scheduler statistics
+struct arch_rf_cal_stats
+{
+    /// Temperature samples
+    uint32_t samples;
+    /// Calibrations
+    uint32_t calibrations;
+    /// Calibrations run on a predicted crossing of the threshold, before it was measured
+    uint32_t early;
+    /// Checks on which a due calibration did not fit before the next event
+    uint32_t deferrals;
+    /// Time spent in calibrations, in us
+    uint32_t cal_time_us;
+    /// Longest calibration, in us
+    uint32_t cal_max_us;
+    /// Time covered by the statistics, in s
+    uint32_t seconds;
+    /// Calibrations per hour over that time
+    uint32_t per_hour;
+};
+#endif
+
 extern uint32_t lp_clk_sel;
 
 /*
@@ -147,9 +203,21 @@ uint16_t get_rc16m_count(void);
 /**
  ****************************************************************************************
  * @brief Conditionally run radio calibration.
+ * @note With CFG_RF_CAL_SCHED on the DA14531 the RF calibration scheduler runs, it checks
+ *       the time left to the next event itself.
  *****************************************************************************************
  */
 void conditionally_run_radio_cals(void);
+
+#if defined (__DA14531__) && defined (CFG_RF_CAL_SCHED)
+/**
+ ****************************************************************************************
+ * @brief Get the statistics of the RF calibration scheduler.
+ * @return Statistics since power up
+ ****************************************************************************************
+ */
+const struct arch_rf_cal_stats *arch_rf_cal_get_stats(void);
+#endif
 #endif // (__NON_BLE_EXAMPLE__)
 
 #if !defined (__DA14531__)
@@ -51,6 +51,13 @@
 #include "ke_mem.h"          // kernel memory manager
 #include "dbg.h"             // debug definition
 #include "uart.h"
+#if defined (CFG_UART_BATCHED_EIF)
+#include "uart_eif.h"
+#endif
+
+#if defined (CFG_AES_QUEUE)
+#include "aes_queue.h"
+#endif
 
 
 #if ((BLE_APP_PRESENT) || ((BLE_HOST_PRESENT && (!GTL_ITF))))
@@ -408,6 +415,14 @@ const void * const rom_func_addr_table_var[] =
     (void *) rf_init_func,
     (void *) rf_reinit_func,
     (void *) uart_init_func,
+#if defined (CFG_UART_BATCHED_EIF)
+    (void *) uart_eif_flow_on_func,
+    (void *) uart_eif_flow_off_func,
+    (void *) uart_eif_finish_transfers_func,
+    (void *) uart_eif_read_func,
+    (void *) uart_eif_write_func,
+    (void *) uart_eif_handler_func,
+#else
     (void *) uart_flow_on_func,
     (void *) uart_flow_off_func,
     (void *) uart_finish_transfers_func,
@@ -422,6 +437,7 @@ const void * const rom_func_addr_table_var[] =
 #else
     (void *) UART_Handler_func,
 #endif
+#endif // CFG_UART_BATCHED_EIF
     (void *) gtl_init_func,
     (void *) gtl_eif_init_func,
     (void *) gtl_eif_read_start_func,
@@ -447,7 +463,11 @@ const void * const rom_func_addr_table_var[] =
     (void *) h4tl_rx_done_func,
     (void *) ke_task_init_func,
     (void *) ke_timer_init_func,
+#if defined (CFG_AES_QUEUE)
+    (void *) aes_queue_encryption_done_func,
+#else
     (void *) llm_encryption_done_func,
+#endif
     (void *) nvds_get_func,
     (void *) nvds_put_func,
     (void *) nvds_del_func,
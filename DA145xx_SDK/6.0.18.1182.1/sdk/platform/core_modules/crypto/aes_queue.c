@@ -0,0 +1,695 @@
+/**
+ ****************************************************************************************
+ *
+ * @file aes_queue.c
+ *
+ * @brief AES job queue implementation.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @addtogroup AES_QUEUE
+ * @{
+ ****************************************************************************************
+ */
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <string.h>
+#include <stdint.h>
+#include "aes_queue.h"
+
+#if defined (CFG_AES_QUEUE)
+
+#include "sw_aes.h"
+#include "aes_api.h"
+#include "co_bt.h"
+
+#if !defined (AES_QUEUE_SW_BACKEND)
+#include "ll.h"
+#include "ke_msg.h"
+#include "llm.h"
+#include "em_map.h"
+#include "reg_blecore.h"
+#endif
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Processing phase of the current job
+enum aes_queue_phase
+{
+    /// ECB, CBC or CTR data block
+    AES_QUEUE_PH_DATA,
+    /// CCM B0 block
+    AES_QUEUE_PH_CCM_B0,
+    /// CCM additional authenticated data block
+    AES_QUEUE_PH_CCM_ADATA,
+    /// CCM payload keystream block
+    AES_QUEUE_PH_CCM_CTR,
+    /// CCM payload CBC-MAC block
+    AES_QUEUE_PH_CCM_MAC,
+    /// CCM MIC keystream block
+    AES_QUEUE_PH_CCM_S0,
+    /// Job completed
+    AES_QUEUE_PH_DONE,
+};
+
+/// Largest CCM additional data length encoded on two bytes
+#define AES_QUEUE_CCM_ADATA_MAX     (0xFEFF)
+
+/*
+ * STRUCTURES
+ ****************************************************************************************
+ */
+
+/// AES job queue environment
+struct aes_queue_env_tag
+{
+    /// Queued jobs
+    struct co_list queue;
+    /// Current job
+    struct aes_queue_job *job;
+    /// Status of the current job
+    uint8_t status;
+    /// Phase of the current job (@see enum aes_queue_phase)
+    uint8_t phase;
+    /// Scheduler running, prevents a callback from re-entering it
+    bool running;
+    /// A block of the queue is in the engine
+    bool engine_busy;
+
+    /// Gather cursor: scatter-gather entry and offset
+    uint8_t in_sg;
+    uint16_t in_off;
+    /// Scatter cursor: scatter-gather entry and offset
+    uint8_t out_sg;
+    uint16_t out_off;
+
+    /// Data bytes not processed yet
+    uint32_t remaining;
+    /// Length of the CCM payload chunk being processed
+    uint8_t chunk_len;
+    /// Offset of the next CCM additional data byte
+    uint16_t adata_off;
+
+    /// CCM payload chunk, plaintext zero padded
+    uint8_t data[AES_QUEUE_BLK_SIZE];
+    /// CCM CBC-MAC value
+    uint8_t x[AES_QUEUE_BLK_SIZE];
+    /// CCM counter block
+    uint8_t ctr[AES_QUEUE_BLK_SIZE];
+
+#if defined (AES_QUEUE_SW_BACKEND)
+    /// Software AES key schedule of the current job
+    AES_CTX ctx;
+#else
+    /// Key of the current job, in the engine register order
+    uint32_t key[4];
+#endif
+};
+
+/*
+ * LOCAL VARIABLES
+ ****************************************************************************************
+ */
+
+static struct aes_queue_env_tag aes_queue_env                   __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+
+/*
+ * LOCAL FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+static void aes_queue_xor(uint8_t *dst, const uint8_t *src, uint8_t len)
+{
+    while (len--)
+    {
+        *dst++ ^= *src++;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Increment a 128-bit big-endian counter block.
+ * @param[in,out] ctr       Counter block
+ ****************************************************************************************
+ */
+static void aes_queue_ctr_inc(uint8_t *ctr)
+{
+    uint8_t i = AES_QUEUE_BLK_SIZE;
+
+    while (i-- && (++ctr[i] == 0));
+}
+
+/**
+ ****************************************************************************************
+ * @brief Copy the next input bytes of the current job, following the scatter-gather list.
+ * @param[out] dst          Destination
+ * @param[in] len           Number of bytes
+ ****************************************************************************************
+ */
+static void aes_queue_gather(uint8_t *dst, uint8_t len)
+{
+    const struct aes_queue_sg *sg;
+    uint16_t n;
+
+    while (len)
+    {
+        sg = &aes_queue_env.job->sg[aes_queue_env.in_sg];
+        n = sg->len - aes_queue_env.in_off;
+        if (n == 0)
+        {
+            aes_queue_env.in_sg++;
+            aes_queue_env.in_off = 0;
+            continue;
+        }
+        if (n > len)
+        {
+            n = len;
+        }
+        memcpy(dst, &sg->in[aes_queue_env.in_off], n);
+        aes_queue_env.in_off += n;
+        dst += n;
+        len -= n;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Copy the next output bytes of the current job, following the scatter-gather list.
+ * @param[in] src           Source
+ * @param[in] len           Number of bytes
+ ****************************************************************************************
+ */
+static void aes_queue_scatter(const uint8_t *src, uint8_t len)
+{
+    const struct aes_queue_sg *sg;
+    uint16_t n;
+
+    while (len)
+    {
+        sg = &aes_queue_env.job->sg[aes_queue_env.out_sg];
+        n = sg->len - aes_queue_env.out_off;
+        if (n == 0)
+        {
+            aes_queue_env.out_sg++;
+            aes_queue_env.out_off = 0;
+            continue;
+        }
+        if (n > len)
+        {
+            n = len;
+        }
+        memcpy(&sg->out[aes_queue_env.out_off], src, n);
+        aes_queue_env.out_off += n;
+        src += n;
+        len -= n;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Build the CCM counter block A0.
+ * @param[out] blk          Counter block
+ ****************************************************************************************
+ */
+static void aes_queue_ccm_a0(uint8_t *blk)
+{
+    const struct aes_queue_job *job = aes_queue_env.job;
+
+    memset(blk, 0, AES_QUEUE_BLK_SIZE);
+    blk[0] = 14 - job->nonce_len;
+    memcpy(&blk[1], job->iv, job->nonce_len);
+}
+
+/// Phase following the CCM header blocks
+static uint8_t aes_queue_ccm_payload_phase(void)
+{
+    return (aes_queue_env.remaining ? AES_QUEUE_PH_CCM_CTR : AES_QUEUE_PH_CCM_S0);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Prepare the current job for processing.
+ ****************************************************************************************
+ */
+static void aes_queue_job_start(void)
+{
+    struct aes_queue_job *job = aes_queue_env.job;
+
+    aes_queue_env.status = AES_QUEUE_ERR_NO_ERR;
+    aes_queue_env.in_sg = 0;
+    aes_queue_env.in_off = 0;
+    aes_queue_env.out_sg = 0;
+    aes_queue_env.out_off = 0;
+    aes_queue_env.remaining = job->len;
+    aes_queue_env.adata_off = 0;
+
+#if defined (AES_QUEUE_SW_BACKEND)
+    AES_set_key(&aes_queue_env.ctx, job->key, job->iv, AES_MODE_128);
+#else
+    aes_queue_env.key[0] = GETU32(job->key);
+    aes_queue_env.key[1] = GETU32(job->key + 4);
+    aes_queue_env.key[2] = GETU32(job->key + 8);
+    aes_queue_env.key[3] = GETU32(job->key + 12);
+#endif
+
+    if (job->mode == AES_QUEUE_CCM)
+    {
+        aes_queue_ccm_a0(aes_queue_env.ctr);
+        aes_queue_env.phase = AES_QUEUE_PH_CCM_B0;
+    }
+    else
+    {
+        aes_queue_env.phase = job->len ? AES_QUEUE_PH_DATA : AES_QUEUE_PH_DONE;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Build the next engine input block of the current job.
+ * @param[out] blk          Engine input block
+ ****************************************************************************************
+ */
+static void aes_queue_next_block(uint8_t *blk)
+{
+    struct aes_queue_job *job = aes_queue_env.job;
+    uint8_t q = 15 - job->nonce_len;
+    uint8_t pos = 0;
+    uint16_t n;
+    uint32_t len;
+
+    switch (aes_queue_env.phase)
+    {
+        case AES_QUEUE_PH_DATA:
+        {
+            if (job->mode == AES_QUEUE_CTR)
+            {
+                memcpy(blk, job->iv, AES_QUEUE_BLK_SIZE);
+            }
+            else
+            {
+                aes_queue_gather(blk, AES_QUEUE_BLK_SIZE);
+                if (job->mode == AES_QUEUE_CBC)
+                {
+                    aes_queue_xor(blk, job->iv, AES_QUEUE_BLK_SIZE);
+                }
+            }
+        } break;
+
+        case AES_QUEUE_PH_CCM_B0:
+        {
+            memset(blk, 0, AES_QUEUE_BLK_SIZE);
+            blk[0] = (job->adata_len ? 0x40 : 0) | (((job->mic_len - 2) / 2) << 3) | (q - 1);
+            memcpy(&blk[1], job->iv, job->nonce_len);
+            for (len = job->len, pos = AES_QUEUE_BLK_SIZE - 1; len; len >>= 8, pos--)
+            {
+                blk[pos] = (uint8_t) len;
+            }
+        } break;
+
+        case AES_QUEUE_PH_CCM_ADATA:
+        {
+            memset(blk, 0, AES_QUEUE_BLK_SIZE);
+            if (aes_queue_env.adata_off == 0)
+            {
+                blk[0] = (uint8_t) (job->adata_len >> 8);
+                blk[1] = (uint8_t) job->adata_len;
+                pos = 2;
+            }
+            n = job->adata_len - aes_queue_env.adata_off;
+            if (n > AES_QUEUE_BLK_SIZE - pos)
+            {
+                n = AES_QUEUE_BLK_SIZE - pos;
+            }
+            memcpy(&blk[pos], &job->adata[aes_queue_env.adata_off], n);
+            aes_queue_env.adata_off += n;
+            aes_queue_xor(blk, aes_queue_env.x, AES_QUEUE_BLK_SIZE);
+        } break;
+
+        case AES_QUEUE_PH_CCM_CTR:
+        {
+            aes_queue_ctr_inc(aes_queue_env.ctr);
+            memcpy(blk, aes_queue_env.ctr, AES_QUEUE_BLK_SIZE);
+        } break;
+
+        case AES_QUEUE_PH_CCM_MAC:
+        {
+            memcpy(blk, aes_queue_env.x, AES_QUEUE_BLK_SIZE);
+            aes_queue_xor(blk, aes_queue_env.data, AES_QUEUE_BLK_SIZE);
+        } break;
+
+        case AES_QUEUE_PH_CCM_S0:
+        {
+            aes_queue_ccm_a0(blk);
+        } break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Consume the engine output block of the current job and move to the next phase.
+ * @param[in,out] res       Engine output block
+ ****************************************************************************************
+ */
+static void aes_queue_block_done(uint8_t *res)
+{
+    struct aes_queue_job *job = aes_queue_env.job;
+    uint8_t n = (aes_queue_env.remaining < AES_QUEUE_BLK_SIZE) ? aes_queue_env.remaining : AES_QUEUE_BLK_SIZE;
+    uint8_t out[AES_QUEUE_BLK_SIZE];
+
+    switch (aes_queue_env.phase)
+    {
+        case AES_QUEUE_PH_DATA:
+        {
+            if (job->mode == AES_QUEUE_CTR)
+            {
+                aes_queue_gather(out, n);
+                aes_queue_xor(out, res, n);
+                aes_queue_scatter(out, n);
+                aes_queue_ctr_inc(job->iv);
+            }
+            else
+            {
+                aes_queue_scatter(res, AES_QUEUE_BLK_SIZE);
+                if (job->mode == AES_QUEUE_CBC)
+                {
+                    memcpy(job->iv, res, AES_QUEUE_BLK_SIZE);
+                }
+            }
+            aes_queue_env.remaining -= n;
+            if (aes_queue_env.remaining == 0)
+            {
+                aes_queue_env.phase = AES_QUEUE_PH_DONE;
+            }
+        } break;
+
+        case AES_QUEUE_PH_CCM_B0:
+        {
+            memcpy(aes_queue_env.x, res, AES_QUEUE_BLK_SIZE);
+            aes_queue_env.phase = job->adata_len ? AES_QUEUE_PH_CCM_ADATA : aes_queue_ccm_payload_phase();
+        } break;
+
+        case AES_QUEUE_PH_CCM_ADATA:
+        {
+            memcpy(aes_queue_env.x, res, AES_QUEUE_BLK_SIZE);
+            if (aes_queue_env.adata_off == job->adata_len)
+            {
+                aes_queue_env.phase = aes_queue_ccm_payload_phase();
+            }
+        } break;
+
+        case AES_QUEUE_PH_CCM_CTR:
+        {
+            // Keep the zero padded plaintext for the CBC-MAC
+            memset(aes_queue_env.data, 0, AES_QUEUE_BLK_SIZE);
+            aes_queue_gather(aes_queue_env.data, n);
+            memcpy(out, aes_queue_env.data, n);
+            aes_queue_xor(out, res, n);
+            if (job->enc_dec == AES_DECRYPT)
+            {
+                memcpy(aes_queue_env.data, out, n);
+            }
+            aes_queue_scatter(out, n);
+            aes_queue_env.chunk_len = n;
+            aes_queue_env.phase = AES_QUEUE_PH_CCM_MAC;
+        } break;
+
+        case AES_QUEUE_PH_CCM_MAC:
+        {
+            memcpy(aes_queue_env.x, res, AES_QUEUE_BLK_SIZE);
+            aes_queue_env.remaining -= aes_queue_env.chunk_len;
+            aes_queue_env.phase = aes_queue_ccm_payload_phase();
+        } break;
+
+        case AES_QUEUE_PH_CCM_S0:
+        {
+            aes_queue_xor(res, aes_queue_env.x, job->mic_len);
+            if (job->enc_dec == AES_ENCRYPT)
+            {
+                memcpy(job->mic, res, job->mic_len);
+            }
+            else if (memcmp(job->mic, res, job->mic_len))
+            {
+                aes_queue_env.status = AES_QUEUE_ERR_MIC;
+            }
+            aes_queue_env.phase = AES_QUEUE_PH_DONE;
+        } break;
+
+        default:
+            break;
+    }
+}
+
+#if defined (AES_QUEUE_SW_BACKEND)
+/**
+ ****************************************************************************************
+ * @brief Encrypt a block with the software AES implementation.
+ * @param[in,out] blk       Block, encrypted in place
+ ****************************************************************************************
+ */
+static void aes_queue_sw_encrypt(uint8_t *blk)
+{
+    uint32_t data[4];
+    uint8_t i;
+
+    for (i = 0; i < 4; i++)
+    {
+        data[i] = GETU32(&blk[i * 4]);
+    }
+
+    AES_encrypt(&aes_queue_env.ctx, data);
+
+    for (i = 0; i < 4; i++)
+    {
+        PUTU32(&blk[i * 4], data[i]);
+    }
+}
+#else
+/**
+ ****************************************************************************************
+ * @brief Start the encryption of a block by the BLE core AES engine. The block is copied
+ *        the same way as by aes_enc_dec().
+ * @param[in] blk           Block
+ ****************************************************************************************
+ */
+static void aes_queue_engine_start(const uint8_t *blk)
+{
+    uint8_t *em = (uint8_t *) (EM_BLE_ENC_PLAIN_OFFSET + EM_BASE_ADDR);
+    uint8_t i;
+
+    // Hold the engine, the link layer defers its requests meanwhile
+    llm_le_env.enc_pend = true;
+    aes_queue_env.engine_busy = true;
+
+    ble_aeskey31_0_set(aes_queue_env.key[3]);
+    ble_aeskey63_32_set(aes_queue_env.key[2]);
+    ble_aeskey95_64_set(aes_queue_env.key[1]);
+    ble_aeskey127_96_set(aes_queue_env.key[0]);
+
+    // copy data from sys ram to exchange memory (in reverse order)
+    for (i = 0; i < ENC_DATA_LEN; i++)
+    {
+        em[i] = blk[ENC_DATA_LEN - 1 - i];
+    }
+
+    ble_aesptr_set(EM_BLE_ENC_PLAIN_OFFSET);
+    ble_aescntl_set(BLE_AES_START_BIT);
+}
+#endif
+
+/**
+ ****************************************************************************************
+ * @brief Process the queued jobs until a block is in the engine or the queue is empty.
+ ****************************************************************************************
+ */
+static void aes_queue_schedule(void)
+{
+    struct aes_queue_job *job;
+    uint8_t blk[AES_QUEUE_BLK_SIZE];
+
+    aes_queue_env.running = true;
+
+    while (true)
+    {
+        if (aes_queue_env.job == NULL)
+        {
+            aes_queue_env.job = (struct aes_queue_job *) co_list_pop_front(&aes_queue_env.queue);
+            if (aes_queue_env.job == NULL)
+            {
+                break;
+            }
+            aes_queue_job_start();
+        }
+
+        if (aes_queue_env.phase != AES_QUEUE_PH_DONE)
+        {
+            aes_queue_next_block(blk);
+#if defined (AES_QUEUE_SW_BACKEND)
+            aes_queue_sw_encrypt(blk);
+            aes_queue_block_done(blk);
+            continue;
+#else
+            aes_queue_engine_start(blk);
+            break;
+#endif
+        }
+
+        job = aes_queue_env.job;
+        aes_queue_env.job = NULL;
+        job->cb(job, aes_queue_env.status);
+    }
+
+    aes_queue_env.running = false;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Check the parameters of a job and compute its data length.
+ * @param[in,out] job       Job
+ * @return true if the job is valid
+ ****************************************************************************************
+ */
+static bool aes_queue_check(struct aes_queue_job *job)
+{
+    uint8_t i;
+    uint8_t q;
+
+    if ((job->key == NULL) || (job->cb == NULL) || ((job->sg == NULL) && job->sg_cnt))
+    {
+        return false;
+    }
+
+    job->len = 0;
+    for (i = 0; i < job->sg_cnt; i++)
+    {
+        if ((job->sg[i].len) && ((job->sg[i].in == NULL) || (job->sg[i].out == NULL)))
+        {
+            return false;
+        }
+        job->len += job->sg[i].len;
+    }
+
+    switch (job->mode)
+    {
+        case AES_QUEUE_ECB:
+        case AES_QUEUE_CBC:
+            // The engine only encrypts, decryption is left to aes_operation()
+            return ((job->enc_dec == AES_ENCRYPT) && ((job->len % AES_QUEUE_BLK_SIZE) == 0));
+
+        case AES_QUEUE_CTR:
+            return true;
+
+        case AES_QUEUE_CCM:
+        {
+            if ((job->nonce_len < 7) || (job->nonce_len > 13) ||
+                (job->mic_len < 4) || (job->mic_len > 16) || (job->mic_len & 1) ||
+                (job->mic == NULL) || (job->adata_len > AES_QUEUE_CCM_ADATA_MAX) ||
+                ((job->adata == NULL) && job->adata_len))
+            {
+                return false;
+            }
+
+            // The payload length must fit in the q bytes of the counter
+            q = 15 - job->nonce_len;
+            return ((q >= 4) || ((job->len >> (q * 8)) == 0));
+        }
+
+        default:
+            return false;
+    }
+}
+
+/*
+ * GLOBAL FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+uint8_t aes_queue_submit(struct aes_queue_job *job)
+{
+    if ((job == NULL) || !aes_queue_check(job))
+    {
+        return AES_QUEUE_ERR_INVALID_PARAM;
+    }
+
+#if defined (AES_QUEUE_SW_BACKEND)
+    co_list_push_back(&aes_queue_env.queue, &job->hdr);
+    if (!aes_queue_env.running)
+    {
+        aes_queue_schedule();
+    }
+#else
+    GLOBAL_INT_DISABLE();
+    co_list_push_back(&aes_queue_env.queue, &job->hdr);
+    // Otherwise started by the end of the current encryption
+    if (!aes_queue_env.running && !aes_queue_env.engine_busy && !llm_le_env.enc_pend &&
+        co_list_is_empty(&llm_le_env.enc_req))
+    {
+        aes_queue_schedule();
+    }
+    GLOBAL_INT_RESTORE();
+#endif
+
+    return AES_QUEUE_ERR_NO_ERR;
+}
+
+bool aes_queue_is_idle(void)
+{
+    return ((aes_queue_env.job == NULL) && co_list_is_empty(&aes_queue_env.queue));
+}
+
+#if !defined (AES_QUEUE_SW_BACKEND)
+extern void llm_encryption_done_func(void);
+
+void aes_queue_encryption_done_func(void)
+{
+    uint8_t res[ENC_DATA_LEN];
+
+    if (aes_queue_env.engine_busy)
+    {
+        aes_queue_env.engine_busy = false;
+        llm_le_env.enc_pend = false;
+
+        // copy data from em to sys ram
+        em_rd(res, EM_BLE_ENC_CIPHER_OFFSET, ENC_DATA_LEN);
+        aes_queue_block_done(res);
+
+        // The link layer requests deferred while the block was in the engine are served
+        // before the next block, llm_encryption_done() starts the following ones
+        if (!co_list_is_empty(&llm_le_env.enc_req))
+        {
+            llm_le_env.enc_pend = true;
+            llm_encryption_start((struct llm_enc_req *) ke_msg2param((struct ke_msg *) co_list_pick(&llm_le_env.enc_req)));
+        }
+    }
+    else
+    {
+        llm_encryption_done_func();
+    }
+
+    // Continue with the current job, or resume the queue once the link layer is done
+    if (!aes_queue_env.running && !llm_le_env.enc_pend)
+    {
+        aes_queue_schedule();
+    }
+}
+#endif
+
+#endif // CFG_AES_QUEUE
+
+/// @} AES_QUEUE
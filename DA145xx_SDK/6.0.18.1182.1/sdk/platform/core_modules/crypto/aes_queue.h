@@ -0,0 +1,178 @@
+/**
+ ****************************************************************************************
+ * @addtogroup Core_Modules
+ * @{
+ * @addtogroup Crypto
+ * @{
+ * @addtogroup AES_QUEUE AES Job Queue
+ * @brief Asynchronous AES job queue on the BLE core encryption engine.
+ * @{
+ *
+ * @file aes_queue.h
+ *
+ * @brief AES job queue header file.
+ *
+ * Jobs are queued by aes_queue_submit() and processed one block after the other by the
+ * BLE core AES engine. The next block is fed to the engine from the end of encryption
+ * interrupt, so a job of any length completes with a single callback and without any
+ * kernel message per block. Input and output data are described by scatter-gather lists.
+ *
+ * The engine is shared with the link layer. The queue holds it only while one of its
+ * blocks is being encrypted and never starts a block while an encryption requested by
+ * the link layer is pending. Link layer requests made meanwhile are started as soon as
+ * the block completes, before the next block of the queue.
+ *
+ * Enabled with CFG_AES_QUEUE. If AES_QUEUE_SW_BACKEND is defined, the blocks are
+ * encrypted synchronously by the software AES implementation instead, e.g. to run the
+ * queue on a host.
+ *
+ * Copyright (C) 2017-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef AES_QUEUE_H_
+#define AES_QUEUE_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "co_list.h"
+
+#if defined (CFG_AES_QUEUE)
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// AES block size
+#define AES_QUEUE_BLK_SIZE          (16)
+
+/// AES job queue mode of operation
+enum aes_queue_mode
+{
+    /// Electronic codebook, encryption only
+    AES_QUEUE_ECB,
+    /// Cipher block chaining, encryption only
+    AES_QUEUE_CBC,
+    /// Counter mode
+    AES_QUEUE_CTR,
+    /// Counter with CBC-MAC
+    AES_QUEUE_CCM,
+};
+
+/// AES job queue status
+enum aes_queue_status
+{
+    /// No error
+    AES_QUEUE_ERR_NO_ERR        = 0,
+    /// Invalid job parameters
+    AES_QUEUE_ERR_INVALID_PARAM,
+    /// CCM authentication failed
+    AES_QUEUE_ERR_MIC,
+};
+
+/*
+ * STRUCTURES
+ ****************************************************************************************
+ */
+
+/// Scatter-gather list entry
+struct aes_queue_sg
+{
+    /// Input data
+    const uint8_t *in;
+    /// Output data, may be equal to in
+    uint8_t *out;
+    /// Length of the entry in bytes
+    uint16_t len;
+};
+
+/// AES job, owned by the queue from aes_queue_submit() until the callback is called
+struct aes_queue_job
+{
+    /// List header
+    struct co_list_hdr hdr;
+
+    /// Mode of operation (@see enum aes_queue_mode)
+    uint8_t mode;
+    /// AES_ENCRYPT or AES_DECRYPT. Only CTR and CCM decrypt, using the forward cipher.
+    uint8_t enc_dec;
+    /// 128-bit key, most significant byte first
+    const uint8_t *key;
+    /// CBC initialization vector or CTR initial counter block, updated so that a following
+    /// job continues the stream. CCM nonce in the first nonce_len bytes.
+    uint8_t iv[AES_QUEUE_BLK_SIZE];
+
+    /// CCM nonce length, 7 to 13 bytes
+    uint8_t nonce_len;
+    /// CCM MIC length, 4 to 16 bytes, even
+    uint8_t mic_len;
+    /// CCM additional authenticated data
+    const uint8_t *adata;
+    /// CCM additional authenticated data length
+    uint16_t adata_len;
+    /// CCM MIC, written on encryption and checked on decryption
+    uint8_t *mic;
+
+    /// Scatter-gather list of the data
+    const struct aes_queue_sg *sg;
+    /// Number of scatter-gather list entries
+    uint8_t sg_cnt;
+
+    /// Completion callback, called from the BLE interrupt (@see enum aes_queue_status)
+    void (*cb)(struct aes_queue_job *job, uint8_t status);
+
+    /// Total data length, set by the queue
+    uint32_t len;
+};
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Queue an AES job.
+ * @details ECB and CBC require a data length multiple of AES_QUEUE_BLK_SIZE. On a CCM
+ *          authentication failure the decrypted data have already been written and must
+ *          be discarded by the caller.
+ * @param[in] job           Job to queue. It must stay valid until its callback is called.
+ * @return AES_QUEUE_ERR_NO_ERR if the job has been queued, AES_QUEUE_ERR_INVALID_PARAM
+ *         otherwise, in which case the callback is not called.
+ ****************************************************************************************
+ */
+uint8_t aes_queue_submit(struct aes_queue_job *job);
+
+/**
+ ****************************************************************************************
+ * @brief Check whether all queued jobs have completed.
+ * @details The BLE core must not enter deep sleep while jobs are queued.
+ * @return true if the queue is idle
+ ****************************************************************************************
+ */
+bool aes_queue_is_idle(void);
+
+/**
+ ****************************************************************************************
+ * @brief End of encryption handler, replaces llm_encryption_done() in the jump table.
+ *        Completes the block of the queue or forwards the link layer encryption.
+ ****************************************************************************************
+ */
+void aes_queue_encryption_done_func(void);
+
+#endif // CFG_AES_QUEUE
+
+#endif // AES_QUEUE_H_
+
+/// @}
+/// @}
+/// @}
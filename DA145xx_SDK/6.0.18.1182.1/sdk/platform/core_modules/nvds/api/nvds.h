@@ -367,7 +367,9 @@ uint8_t nvds_get(uint8_t tag, nvds_tag_len_t * lengthPtr, uint8_t *buf);
  *
  * @param[in]  tag    TAG to mark as deleted
  *
- * @return NVDS_FAIL
+ * @return NVDS_OK               TAG deleted from the flash store (CFG_NVDS_FLASH_STORE)
+ *         NVDS_TAG_NOT_DEFINED  TAG not in the flash store
+ *         NVDS_FAIL             No flash store
  ****************************************************************************************
  */
 uint8_t nvds_del(uint8_t tag);
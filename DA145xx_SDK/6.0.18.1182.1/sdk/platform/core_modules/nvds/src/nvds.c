@@ -32,6 +32,47 @@
 #include "co_utils.h"
 #include "rwip_config.h"
 
+#if defined (CFG_NVDS_FLASH_STORE)
+#include "spi_flash.h"
+
+#if defined (__DA14531__) && !defined (__EXCLUDE_ROM_NVDS__)
+#error "CFG_NVDS_FLASH_STORE requires __EXCLUDE_ROM_NVDS__ on DA14531"
+#endif
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Offset of the first of the two SPI flash sectors used by the store
+#ifndef CFG_NVDS_FLASH_OFFSET
+#define CFG_NVDS_FLASH_OFFSET       (0x1C000)
+#endif
+
+/// Size of a store sector
+#define NVDS_STORE_SECTOR_SIZE      (SPI_FLASH_SECTOR_SIZE)
+
+/// Sector header marker ("NVDS")
+#define NVDS_STORE_MAGIC            (0x5344564E)
+
+/// Size of the sector header (magic, generation)
+#define NVDS_STORE_HDR_LEN          (8)
+
+/// Size of a record header (tag, length, type, crc)
+#define NVDS_STORE_REC_HDR_LEN      (4)
+
+/// Record types, any other value marks a corrupted record. A type cut while programmed
+/// reads as neither, the two have no bit set in common
+#define NVDS_STORE_REC_VALUE        (0xA5)
+#define NVDS_STORE_REC_DELETED      (0x5A)
+
+/// Number of tags that can be stored, see enum NVDS_TAG
+#define NVDS_STORE_TAG_NB           (0x80)
+
+/// Size of the stack buffer used to walk through the record data
+#define NVDS_STORE_CHUNK_LEN        (16)
+#endif // CFG_NVDS_FLASH_STORE
+
 /*
  * TYPE DEFINITIONS
  ****************************************************************************************
@@ -48,6 +89,38 @@ struct nvds_data_struct
     uint8_t     ble_ca_nb_bad_pkt;
 };
 
+#if defined (CFG_NVDS_FLASH_STORE)
+/// Flash store environment
+struct nvds_store_env_tag
+{
+    /// Flash offset of the active sector
+    uint32_t sector;
+    /// Generation of the active sector, incremented at each compaction
+    uint32_t generation;
+    /// Offset of the first free byte in the active sector
+    uint16_t write_off;
+    /// True once the flash has been scanned
+    bool init_done;
+    /// True if the active sector holds a valid header
+    bool formatted;
+    /// True if the scan stopped at a corrupted record, compaction is needed before appending
+    bool dirty;
+    /// True once the standby sector has been erased for the next compaction
+    bool standby_erased;
+    /// Offset of the latest record of each tag in the active sector, 0 if not stored
+    uint16_t index[NVDS_STORE_TAG_NB];
+};
+
+/// SPI flash state saved by nvds_store_flash_open(), restored by nvds_store_flash_close()
+struct nvds_store_flash_state
+{
+    /// True if the flash was in power down
+    bool was_down;
+    /// Memory protection bits of the status register, cleared for a write
+    uint8_t mem_prot;
+};
+#endif // CFG_NVDS_FLASH_STORE
+
 /*
  * LOCAL VARIABLES
  ****************************************************************************************
@@ -73,6 +146,10 @@ static const struct nvds_data_struct nvds_data_storage =
 extern const uint8_t blank_otp_bdaddr[6];
 #endif
 
+#if defined (CFG_NVDS_FLASH_STORE)
+static struct nvds_store_env_tag nvds_store_env __SECTION_ZERO("retention_mem_area0"); //@RETENTION MEMORY
+#endif
+
 
 /*
  * FUNCTION DEFINITIONS
@@ -81,7 +158,528 @@ extern const uint8_t blank_otp_bdaddr[6];
 
 #if !defined (__DA14531__) || defined (__EXCLUDE_ROM_NVDS__)
 
+#if defined (CFG_NVDS_FLASH_STORE)
+
+/*
+ * Flash store layout
+ *
+ * Two sectors starting at CFG_NVDS_FLASH_OFFSET, one of them active. The active sector
+ * starts with {u32 magic, u32 generation} followed by records appended one after the
+ * other: {u8 tag, u8 length, u8 type, u8 crc} and length bytes of data. A put appends a
+ * VALUE record and a del appends a DELETED record with no data, the latest record of a
+ * tag wins, and the type of a record is programmed last. When the active sector is full,
+ * the live records are copied to the other sector, whose header is written last with the
+ * next generation, and the magic of the old sector is cleared. At init the valid sector
+ * with the highest generation is used.
+ *
+ * The other sector is erased by the append that fills the active one past half, so that
+ * no put blocks for more than one sector erase and the compaction itself only copies.
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Releases the SPI flash from power down if needed, and waits for an operation
+ *        still in progress, e.g. a bond database erase.
+ * @param[in] write   true to program or erase it: the memory protection is cleared and the
+ *                    flash detected, which a read does not need
+ * @param[out] state  State to be passed to nvds_store_flash_close()
+ ****************************************************************************************
+ */
+static void nvds_store_flash_open(bool write, struct nvds_store_flash_state *state)
+{
+    state->was_down = !spi_flash_is_awake();
+    state->mem_prot = SPI_FLASH_MEM_PROT_NONE;
+
+    if (state->was_down)
+    {
+        spi_flash_release_from_power_down();
+    }
+
+    spi_flash_wait_till_ready();
+
+    if (write)
+    {
+        uint8_t dev_id;
+
+        state->mem_prot = spi_flash_read_status_reg() & SPI_FLASH_MEM_PROT_MASK;
+        if (state->mem_prot != SPI_FLASH_MEM_PROT_NONE)
+        {
+            spi_flash_configure_memory_protection(SPI_FLASH_MEM_PROT_NONE);
+        }
+        spi_flash_auto_detect(&dev_id);
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Restores the memory protection cleared by nvds_store_flash_open() and puts the
+ *        SPI flash back in power down if it was before.
+ ****************************************************************************************
+ */
+static void nvds_store_flash_close(const struct nvds_store_flash_state *state)
+{
+    if (state->mem_prot != SPI_FLASH_MEM_PROT_NONE)
+    {
+        spi_flash_configure_memory_protection(state->mem_prot);
+    }
+
+    if (state->was_down)
+    {
+        spi_flash_power_down();
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Reads from the SPI flash.
+ * @return true on success
+ ****************************************************************************************
+ */
+static bool nvds_store_read(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    uint32_t actual_size;
+
+    return (spi_flash_read_data(buf, addr, len, &actual_size) == SPI_FLASH_ERR_OK) &&
+           (actual_size == len);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Programs the SPI flash, the area must be erased.
+ * @return true on success
+ ****************************************************************************************
+ */
+static bool nvds_store_write(uint32_t addr, uint8_t *buf, uint32_t len)
+{
+    uint32_t actual_size;
+
+    return (spi_flash_write_data(buf, addr, len, &actual_size) == SPI_FLASH_ERR_OK) &&
+           (actual_size == len);
+}
+
+/**
+ ****************************************************************************************
+ * @brief CRC-8 (polynomial 0x07) update.
+ ****************************************************************************************
+ */
+static uint8_t nvds_store_crc8(uint8_t crc, const uint8_t *data, uint32_t len)
+{
+    uint8_t i;
+
+    while (len--)
+    {
+        crc ^= *data++;
+        for (i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Computes the CRC of a record whose header is already read, reading its data
+ *        from flash.
+ * @param[in] addr  Flash address of the record data
+ * @param[in] hdr   Record header
+ * @param[out] crc  Computed CRC
+ * @return true if the data could be read
+ ****************************************************************************************
+ */
+static bool nvds_store_rec_crc(uint32_t addr, const uint8_t *hdr, uint8_t *crc)
+{
+    uint8_t chunk[NVDS_STORE_CHUNK_LEN];
+    uint8_t left = hdr[1];
+
+    *crc = nvds_store_crc8(0, hdr, 3);
+
+    while (left)
+    {
+        uint8_t len = co_min(left, NVDS_STORE_CHUNK_LEN);
+
+        if (!nvds_store_read(addr, chunk, len))
+        {
+            return false;
+        }
+
+        *crc = nvds_store_crc8(*crc, chunk, len);
+        addr += len;
+        left -= len;
+    }
+
+    return true;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Reads the generation of a sector.
+ * @return true if the sector holds a valid header
+ ****************************************************************************************
+ */
+static bool nvds_store_sector_gen(uint32_t sector, uint32_t *generation)
+{
+    uint8_t hdr[NVDS_STORE_HDR_LEN];
+
+    if (!nvds_store_read(sector, hdr, NVDS_STORE_HDR_LEN) || (co_read32p(hdr) != NVDS_STORE_MAGIC))
+    {
+        return false;
+    }
+
+    *generation = co_read32p(&hdr[4]);
+
+    return true;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Selects the active sector and builds the tag index. Called with the flash open.
+ ****************************************************************************************
+ */
+static void nvds_store_scan(void)
+{
+    uint32_t gen_a, gen_b;
+    bool valid_a = nvds_store_sector_gen(CFG_NVDS_FLASH_OFFSET, &gen_a);
+    bool valid_b = nvds_store_sector_gen(CFG_NVDS_FLASH_OFFSET + NVDS_STORE_SECTOR_SIZE, &gen_b);
+    uint16_t off = NVDS_STORE_HDR_LEN;
+
+    memset(nvds_store_env.index, 0, sizeof(nvds_store_env.index));
+    nvds_store_env.init_done = true;
+    nvds_store_env.dirty = false;
+    nvds_store_env.standby_erased = false;
+    nvds_store_env.formatted = valid_a || valid_b;
+    nvds_store_env.sector = CFG_NVDS_FLASH_OFFSET;
+    nvds_store_env.generation = 0;
+    nvds_store_env.write_off = NVDS_STORE_HDR_LEN;
+
+    if (!nvds_store_env.formatted)
+    {
+        return;
+    }
+
+    // Both sectors are valid if a reset came before the magic of the old one was cleared
+    if (valid_b && (!valid_a || ((int32_t)(gen_b - gen_a) > 0)))
+    {
+        nvds_store_env.sector = CFG_NVDS_FLASH_OFFSET + NVDS_STORE_SECTOR_SIZE;
+        nvds_store_env.generation = gen_b;
+    }
+    else
+    {
+        nvds_store_env.generation = gen_a;
+    }
+
+    while (off + NVDS_STORE_REC_HDR_LEN <= NVDS_STORE_SECTOR_SIZE)
+    {
+        uint8_t hdr[NVDS_STORE_REC_HDR_LEN];
+        uint32_t addr = nvds_store_env.sector + off;
+        uint8_t crc;
+
+        if (!nvds_store_read(addr, hdr, NVDS_STORE_REC_HDR_LEN))
+        {
+            nvds_store_env.dirty = true;
+            break;
+        }
+
+        if (co_read32p(hdr) == 0xFFFFFFFF)
+        {
+            // Erased, end of the log
+            break;
+        }
+
+        // A record cut by a reset leaves an invalid header or a CRC mismatch
+        if ((hdr[0] >= NVDS_STORE_TAG_NB) ||
+            ((hdr[2] != NVDS_STORE_REC_VALUE) && (hdr[2] != NVDS_STORE_REC_DELETED)) ||
+            (off + NVDS_STORE_REC_HDR_LEN + hdr[1] > NVDS_STORE_SECTOR_SIZE) ||
+            !nvds_store_rec_crc(addr + NVDS_STORE_REC_HDR_LEN, hdr, &crc) ||
+            (crc != hdr[3]))
+        {
+            nvds_store_env.dirty = true;
+            break;
+        }
+
+        nvds_store_env.index[hdr[0]] = (hdr[2] == NVDS_STORE_REC_VALUE) ? off : 0;
+        off += NVDS_STORE_REC_HDR_LEN + hdr[1];
+    }
+
+    nvds_store_env.write_off = off;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Builds the index on first use. nvds_init() is not called by the SDK, the first
+ *        access from the ROM stack happens in rwip_init(), after periph_init().
+ ****************************************************************************************
+ */
+static void nvds_store_init(void)
+{
+    if (!nvds_store_env.init_done)
+    {
+        uint8_t dev_id;
+        struct nvds_store_flash_state state;
+
+        nvds_store_flash_open(false, &state);
+        // Once per boot, the flash parameters may not be configured yet
+        spi_flash_auto_detect(&dev_id);
+        nvds_store_scan();
+        nvds_store_flash_close(&state);
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Copies the live records to the other sector and makes it active. The other
+ *        sector is erased first unless nvds_store_append() already did it. Called with
+ *        the flash open.
+ * @return true on success
+ ****************************************************************************************
+ */
+static bool nvds_store_compact(void)
+{
+    uint32_t src = nvds_store_env.sector;
+    uint32_t dst = (src == CFG_NVDS_FLASH_OFFSET) ? (CFG_NVDS_FLASH_OFFSET + NVDS_STORE_SECTOR_SIZE)
+                                                   : CFG_NVDS_FLASH_OFFSET;
+    uint8_t hdr[NVDS_STORE_HDR_LEN];
+    uint16_t off = NVDS_STORE_HDR_LEN;
+    uint16_t tag;
+
+    if (!nvds_store_env.standby_erased &&
+        (spi_flash_block_erase(dst, SPI_FLASH_OP_SE) != SPI_FLASH_ERR_OK))
+    {
+        return false;
+    }
+
+    // From here on dst holds data, erased again before the next compaction
+    nvds_store_env.standby_erased = false;
+
+    for (tag = 0; tag < NVDS_STORE_TAG_NB; tag++)
+    {
+        uint8_t chunk[NVDS_STORE_CHUNK_LEN];
+        uint16_t src_off = nvds_store_env.index[tag];
+        uint16_t left;
+        uint16_t pos = 0;
+
+        if (src_off == 0)
+        {
+            continue;
+        }
+
+        // Record header included, the record is copied as is
+        if (!nvds_store_read(src + src_off + 1, chunk, 1))
+        {
+            return false;
+        }
+        left = NVDS_STORE_REC_HDR_LEN + chunk[0];
+
+        while (left)
+        {
+            uint8_t len = co_min(left, NVDS_STORE_CHUNK_LEN);
+
+            if (!nvds_store_read(src + src_off + pos, chunk, len) ||
+                !nvds_store_write(dst + off + pos, chunk, len))
+            {
+                return false;
+            }
+
+            pos += len;
+            left -= len;
+        }
+
+        nvds_store_env.index[tag] = off;
+        off += pos;
+    }
+
+    // The header validates the new sector, write it last
+    co_write32p(hdr, NVDS_STORE_MAGIC);
+    co_write32p(&hdr[4], nvds_store_env.generation + 1);
+    if (!nvds_store_write(dst, hdr, NVDS_STORE_HDR_LEN))
+    {
+        return false;
+    }
+
+    if (nvds_store_env.formatted)
+    {
+        // Not fatal, the new sector wins at the next scan anyway. Programming the magic to
+        // 0 takes a few us where the erase of the sector, left for later, takes up to 100s of ms
+        memset(hdr, 0, sizeof(uint32_t));
+        nvds_store_write(src, hdr, sizeof(uint32_t));
+    }
+
+    nvds_store_env.sector = dst;
+    nvds_store_env.generation++;
+    nvds_store_env.write_off = off;
+    nvds_store_env.formatted = true;
+    nvds_store_env.dirty = false;
+
+    return true;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Appends a record to the active sector, compacting it first if needed.
+ * @param[in] tag    Tag
+ * @param[in] type   NVDS_STORE_REC_VALUE or NVDS_STORE_REC_DELETED
+ * @param[in] length Data length
+ * @param[in] buf    Data
+ * @return NVDS_OK, NVDS_NO_SPACE_AVAILABLE or NVDS_FAIL
+ ****************************************************************************************
+ */
+static uint8_t nvds_store_append(uint8_t tag, uint8_t type, nvds_tag_len_t length, uint8_t *buf)
+{
+    uint8_t hdr[NVDS_STORE_REC_HDR_LEN];
+    uint32_t addr;
+    uint8_t status = NVDS_OK;
+    struct nvds_store_flash_state state;
+
+    nvds_store_flash_open(true, &state);
+
+    if (!nvds_store_env.formatted || nvds_store_env.dirty ||
+        (nvds_store_env.write_off + NVDS_STORE_REC_HDR_LEN + length > NVDS_STORE_SECTOR_SIZE))
+    {
+        // Also formats a blank store and drops a corrupted tail
+        if (!nvds_store_compact())
+        {
+            // Rescan as the index may point to the destination sector
+            nvds_store_scan();
+            nvds_store_flash_close(&state);
+            return NVDS_FAIL;
+        }
+
+        if (nvds_store_env.write_off + NVDS_STORE_REC_HDR_LEN + length > NVDS_STORE_SECTOR_SIZE)
+        {
+            nvds_store_flash_close(&state);
+            return NVDS_NO_SPACE_AVAILABLE;
+        }
+    }
+
+    hdr[0] = tag;
+    hdr[1] = length;
+    hdr[2] = type;
+    hdr[3] = nvds_store_crc8(nvds_store_crc8(0, hdr, 3), buf, length);
+    addr = nvds_store_env.sector + nvds_store_env.write_off;
+
+    // The type is programmed last, a reset before leaves it erased. The CRC alone misses
+    // some erased data tails, e.g. 254 bytes left at 0xFF flip a multiple of 127 bits
+    hdr[2] = 0xFF;
+    if (!nvds_store_write(addr, hdr, NVDS_STORE_REC_HDR_LEN) ||
+        ((length != 0) && !nvds_store_write(addr + NVDS_STORE_REC_HDR_LEN, buf, length)) ||
+        !nvds_store_write(addr + 2, &type, 1))
+    {
+        nvds_store_env.dirty = true;
+        status = NVDS_FAIL;
+    }
+    else
+    {
+        nvds_store_env.index[tag] = (type == NVDS_STORE_REC_VALUE) ? nvds_store_env.write_off : 0;
+    }
+
+    // Never reuse a partially written area
+    nvds_store_env.write_off += NVDS_STORE_REC_HDR_LEN + length;
+
+    // Prepare the next compaction, a failure only leaves the erase to it
+    if (!nvds_store_env.standby_erased && (nvds_store_env.write_off > NVDS_STORE_SECTOR_SIZE / 2))
+    {
+        uint32_t standby = (nvds_store_env.sector == CFG_NVDS_FLASH_OFFSET) ?
+                           (CFG_NVDS_FLASH_OFFSET + NVDS_STORE_SECTOR_SIZE) : CFG_NVDS_FLASH_OFFSET;
+
+        nvds_store_env.standby_erased = (spi_flash_block_erase(standby, SPI_FLASH_OP_SE) == SPI_FLASH_ERR_OK);
+    }
+
+    nvds_store_flash_close(&state);
+
+    return status;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Reads a tag from the flash store.
+ * @return NVDS_TAG_NOT_DEFINED if the tag is not stored, else as nvds_get_func()
+ ****************************************************************************************
+ */
+static uint8_t nvds_store_get(uint8_t tag, nvds_tag_len_t *lengthPtr, uint8_t *buf)
+{
+    uint8_t hdr[NVDS_STORE_REC_HDR_LEN];
+    uint32_t addr;
+    uint8_t status = NVDS_OK;
+    struct nvds_store_flash_state state;
+
+    nvds_store_init();
+
+    if ((tag >= NVDS_STORE_TAG_NB) || (nvds_store_env.index[tag] == 0))
+    {
+        return NVDS_TAG_NOT_DEFINED;
+    }
+
+    addr = nvds_store_env.sector + nvds_store_env.index[tag];
+
+    // A read only wakes the flash up, if at all
+    nvds_store_flash_open(false, &state);
+
+    if (!nvds_store_read(addr, hdr, NVDS_STORE_REC_HDR_LEN))
+    {
+        status = NVDS_TAG_NOT_DEFINED;
+    }
+    else if (*lengthPtr < hdr[1])
+    {
+        *lengthPtr = 0;
+        status = NVDS_LENGTH_OUT_OF_RANGE;
+    }
+    else if (!nvds_store_read(addr + NVDS_STORE_REC_HDR_LEN, buf, hdr[1]))
+    {
+        status = NVDS_TAG_NOT_DEFINED;
+    }
+    else
+    {
+        *lengthPtr = hdr[1];
+    }
+
+    nvds_store_flash_close(&state);
+
+    return status;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Checks whether a tag is stored with the given value.
+ ****************************************************************************************
+ */
+static bool nvds_store_equal(uint8_t tag, nvds_tag_len_t length, const uint8_t *buf)
+{
+    uint8_t chunk[NVDS_STORE_CHUNK_LEN];
+    uint32_t addr = nvds_store_env.sector + nvds_store_env.index[tag];
+    nvds_tag_len_t pos = 0;
+    struct nvds_store_flash_state state;
+    bool equal;
+
+    if (nvds_store_env.index[tag] == 0)
+    {
+        return false;
+    }
+
+    nvds_store_flash_open(false, &state);
+
+    equal = nvds_store_read(addr + 1, chunk, 1) && (chunk[0] == length);
+    addr += NVDS_STORE_REC_HDR_LEN;
+
+    while (equal && (pos < length))
+    {
+        uint8_t len = co_min(length - pos, NVDS_STORE_CHUNK_LEN);
+
+        equal = nvds_store_read(addr + pos, chunk, len) && (memcmp(chunk, &buf[pos], len) == 0);
+        pos += len;
+    }
+
+    nvds_store_flash_close(&state);
+
+    return equal;
+}
+#endif // CFG_NVDS_FLASH_STORE
+
+#if defined (CFG_NVDS_FLASH_STORE)
+static uint8_t nvds_get_default(uint8_t tag, nvds_tag_len_t *lengthPtr, uint8_t *buf)
+#else
 uint8_t nvds_get_func(uint8_t tag, nvds_tag_len_t *lengthPtr, uint8_t *buf)
+#endif
 {
     extern struct bd_addr dev_bdaddr;
     uint8_t status = NVDS_FAIL;
@@ -206,22 +804,70 @@ uint8_t nvds_get_func(uint8_t tag, nvds_tag_len_t *lengthPtr, uint8_t *buf)
     return status;
 }
 
+#if defined (CFG_NVDS_FLASH_STORE)
+uint8_t nvds_get_func(uint8_t tag, nvds_tag_len_t *lengthPtr, uint8_t *buf)
+{
+    // Stored values override the defaults, a deleted tag reverts to its default
+    uint8_t status = nvds_store_get(tag, lengthPtr, buf);
+
+    if (status == NVDS_TAG_NOT_DEFINED)
+    {
+        status = nvds_get_default(tag, lengthPtr, buf);
+    }
+
+    return status;
+}
+#endif
+
 #if (NVDS_READ_WRITE == 1)
 uint8_t nvds_init_func(uint8_t *base, uint32_t len)
 {
+#if defined (CFG_NVDS_FLASH_STORE)
+    // Rebuild the index from flash
+    nvds_store_env.init_done = false;
+    nvds_store_init();
+#endif
     return NVDS_OK;
 }
 
 /// NVDS API implementation - required by ROM function table
 uint8_t nvds_del_func(uint8_t tag)
 {
+#if defined (CFG_NVDS_FLASH_STORE)
+    nvds_store_init();
+
+    if ((tag >= NVDS_STORE_TAG_NB) || (nvds_store_env.index[tag] == 0))
+    {
+        return NVDS_TAG_NOT_DEFINED;
+    }
+
+    return nvds_store_append(tag, NVDS_STORE_REC_DELETED, 0, NULL);
+#else
     return NVDS_FAIL;
+#endif
 }
 
 /// NVDS API implementation - required by ROM function table
 uint8_t nvds_put_func(uint8_t tag, nvds_tag_len_t length, uint8_t *buf)
 {
+#if defined (CFG_NVDS_FLASH_STORE)
+    nvds_store_init();
+
+    if (tag >= NVDS_STORE_TAG_NB)
+    {
+        return NVDS_TAG_NOT_DEFINED;
+    }
+
+    // Spare the flash if the value did not change
+    if (nvds_store_equal(tag, length, buf))
+    {
+        return NVDS_OK;
+    }
+
+    return nvds_store_append(tag, NVDS_STORE_REC_VALUE, length, buf);
+#else
     return NVDS_FAIL;
+#endif
 }
 #endif //(NVDS_READ_WRITE == 1)
 
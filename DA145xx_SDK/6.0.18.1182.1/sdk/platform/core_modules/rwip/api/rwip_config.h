@@ -115,6 +115,13 @@
     #define BLE_APP_SEC                 0
 #endif
 
+/// LE Credit Based Channel Application
+#ifdef CFG_APP_LECB
+    #define BLE_APP_LECB                1
+#else
+    #define BLE_APP_LECB                0
+#endif
+
 /// Integrated processor host application with GTL iface
 #ifdef CFG_INTEGRATED_HOST_GTL
     #define BLE_INTEGRATED_HOST_GTL     1
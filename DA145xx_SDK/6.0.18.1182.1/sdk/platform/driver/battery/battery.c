@@ -352,45 +352,40 @@ static uint8_t (*const batt_cal_lvl[])(uint16_t adc_sample) =
 };
 #endif // __DA14531__
 
-uint8_t battery_get_lvl(const batt_t batt_type)
+uint16_t battery_get_raw(const batt_t batt_type)
 {
-    uint8_t batt_lvl = 0;
 #if defined (__DA14531__)
-    uint16_t batt_volt = 0;
-#else
-    uint16_t adc_sample = 0;
-#endif
-
-#if !defined (__DA14531__)
-    // NOTE1: In the DA14585/DA14586 case, ADC offset calibration is performed
-    // for each and every battery type.
-    // NOTE2: In the DA14531 case, ADC offset calibration is performed as
+    // NOTE: In the DA14531 case, ADC offset calibration is performed as
     // appropriate (in the context of battery-specific functions, see also
     // batt_cal_volt).
+    return battery_get_voltage(batt_type);
+#else
+    // NOTE: In the DA14585/DA14586 case, ADC offset calibration is performed
+    // for each and every battery type.
     adc_offset_calibrate(ADC_INPUT_MODE_SINGLE_ENDED);
-#endif
 
-#if defined (__DA14531__)
-    batt_volt = battery_get_voltage(batt_type);
-#else
     if ((batt_type == BATT_ALKALINE) && (GetBits16(ANA_STATUS_REG, BOOST_SELECTED) == 0x1))
     {
         // BOOST mode (single AAA battery)
-        adc_sample = adc_get_vbat_sample(true);
-    }
-    else
-    {
-        adc_sample = adc_get_vbat_sample(false);
+        return adc_get_vbat_sample(true);
     }
 
-    adc_sample = battery_filter_value(adc_sample);
+    return adc_get_vbat_sample(false);
 #endif // __DA14531__
+}
 
-#if defined (__DA14531__)
-    batt_lvl = batt_cal_lvl[batt_type](batt_volt);
-#else
-    batt_lvl = batt_cal_lvl[batt_type](adc_sample);
+uint8_t battery_raw_to_lvl(const batt_t batt_type, uint16_t raw)
+{
+    return batt_cal_lvl[batt_type](raw);
+}
+
+uint8_t battery_get_lvl(const batt_t batt_type)
+{
+    uint16_t raw = battery_get_raw(batt_type);
+
+#if !defined (__DA14531__)
+    raw = battery_filter_value(raw);
 #endif
 
-    return batt_lvl;
+    return battery_raw_to_lvl(batt_type, raw);
 }
@@ -87,6 +87,27 @@ typedef enum
 uint16_t battery_get_voltage(const batt_t batt_type);
 #endif
 
+/**
+ ****************************************************************************************
+ * @brief Runs one conversion of the @p batt_type battery, without filtering.
+ * @param[in] batt_type Battery type.
+ * @return battery voltage in mV on the DA14531, ADC sample on the DA14585/586
+ ****************************************************************************************
+ */
+uint16_t battery_get_raw(const batt_t batt_type);
+
+/**
+ ****************************************************************************************
+ * @brief Converts a value returned by battery_get_raw() to a battery level, no ADC
+ *        conversion is run.
+ * @param[in] batt_type Battery type.
+ * @param[in] raw       Battery voltage in mV on the DA14531, ADC sample on the
+ *                      DA14585/586.
+ * @return battery level (0-100%)
+ ****************************************************************************************
+ */
+uint8_t battery_raw_to_lvl(const batt_t batt_type, uint16_t raw);
+
 /**
  ****************************************************************************************
  * @brief Returns battery level for @p batt_type.
@@ -282,6 +282,19 @@ void rtc_get_time_clndr(rtc_time_t *time, rtc_calendar_t *clndr)
     }
 }
 
+void rtc_get_time_clndr_bcd(uint32_t *time_bcd, uint32_t *clndr_bcd)
+{
+    uint32_t before;
+
+    /* The date only changes when the hour rolls over at midnight. */
+    do
+    {
+        before = rtc_get_time_bcd();
+        *clndr_bcd = rtc_get_clndr_bcd();
+        *time_bcd = rtc_get_time_bcd();
+    } while ((before ^ *time_bcd) & (RTC_TIME_HR_T | RTC_TIME_HR_U | RTC_TIME_PM));
+}
+
 rtc_status_code_t rtc_set_alarm(const rtc_time_t *time, const rtc_alarm_calendar_t *clndr, const uint8_t mask)
 {
     uint8_t status;
@@ -360,6 +360,18 @@ __STATIC_FORCEINLINE void rtc_set_clndr_bcd(uint32_t clndr_bcd)
  */
 void rtc_get_time_clndr(rtc_time_t *time, rtc_calendar_t *clndr);
 
+/**
+ ****************************************************************************************
+ * @brief Gets a coherent view of the RTC time and calendar registers without stopping
+ *        the counters, which would lose the fraction of the hundredth of a second that
+ *        elapses meanwhile. The time is read before and after the calendar, and the
+ *        registers are read again if the hour has changed in between.
+ * @param[out] time_bcd Time in binary-coded decimal (BCD) format.
+ * @param[out] clndr_bcd Calendar date in binary-coded decimal (BCD) format.
+ ****************************************************************************************
+ */
+void rtc_get_time_clndr_bcd(uint32_t *time_bcd, uint32_t *clndr_bcd);
+
 /**
  ****************************************************************************************
  * @brief Reads the RTC time register.
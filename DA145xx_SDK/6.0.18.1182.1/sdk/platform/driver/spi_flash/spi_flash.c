@@ -22,6 +22,9 @@
 // SPI Flash device parameters environment
 static spi_flash_cfg_t spi_flash_cfg_env;
 
+// True once the flash has been released from power down and not powered down since
+static bool spi_flash_awake     __SECTION_ZERO("retention_mem_area0");
+
 #if (USE_SPI_FLASH_EXTENSIONS)
 #define SPI_FLASH_ENABLE_POWER_PIN()    do {                                                        \
                                                 bool is_pin_enabled = spi_flash_enable_power_pin(); \
@@ -205,6 +208,7 @@ int8_t spi_flash_power_down(void)
     // Send command
     spi_set_bitmode(SPI_MODE_8BIT);
     spi_transaction(SPI_FLASH_OP_DP);
+    spi_flash_awake = false;
 
     return SPI_FLASH_ERR_OK;
 }
@@ -229,9 +233,16 @@ int8_t spi_flash_release_from_power_down(void)
     const int repetitions = 2 * wait_time_in_us;
     for (volatile int i = 0; i < repetitions; i++);
 #endif
+    spi_flash_awake = true;
+
     return SPI_FLASH_ERR_OK;
 }
 
+bool spi_flash_is_awake(void)
+{
+    return spi_flash_awake;
+}
+
 int8_t spi_flash_ultra_deep_power_down(void)
 {
     SPI_FLASH_ENABLE_POWER_PIN();
@@ -246,6 +257,7 @@ int8_t spi_flash_ultra_deep_power_down(void)
     // Send command
     spi_set_bitmode(SPI_MODE_8BIT);
     spi_transaction(SPI_FLASH_OP_UDPD);
+    spi_flash_awake = false;
 
     return SPI_FLASH_ERR_OK;
 }
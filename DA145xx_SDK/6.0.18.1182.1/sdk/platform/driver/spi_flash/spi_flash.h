@@ -621,6 +621,17 @@ int8_t spi_flash_power_down(void);
  */
 int8_t spi_flash_release_from_power_down(void);
 
+/**
+ ****************************************************************************************
+ * @brief Tells whether the flash is out of power down
+ * @details Tracks the Power-Down and Release from Power-Down instructions sent by this
+ *          driver. The state is unknown until the first of them, false is returned.
+ * @return true if the flash has been released from power down since it was last
+ *         powered down
+ ****************************************************************************************
+ */
+bool spi_flash_is_awake(void);
+
 /**
  ****************************************************************************************
  * @brief Sends the Ultra Deep Power-Down instruction
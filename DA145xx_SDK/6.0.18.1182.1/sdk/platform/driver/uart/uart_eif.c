@@ -0,0 +1,430 @@
+/**
+ ****************************************************************************************
+ *
+ * @file uart_eif.c
+ *
+ * @brief UART batched external interface for the GTL/H4TL transport over UART1.
+ *
+ * All the read and write requests are completed from the UART1 interrupt handler, which
+ * is pended by the requests and by the DMA callbacks. The transport layers are therefore
+ * never called back from the context that issued a request.
+ *
+ * Copyright (C) 2012-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+#if defined (CFG_UART_BATCHED_EIF)
+
+#if !defined (CFG_UART1_SDK) || !defined (CFG_UART_DMA_SUPPORT)
+#error "CFG_UART_BATCHED_EIF requires CFG_UART1_SDK and CFG_UART_DMA_SUPPORT"
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#include "compiler.h"
+#include "ll.h"
+#include "co_math.h"
+#include "dma.h"
+#include "rwip.h"
+#include "uart_eif.h"
+
+#if (UART_EIF_RX_RING_SIZE & (UART_EIF_RX_RING_SIZE - 1))
+#error "UART_EIF_RX_RING_SIZE must be a power of 2"
+#endif
+
+/*
+ * UART EIF Environment
+ ****************************************************************************************
+ */
+/// @brief UART EIF environment definition
+typedef struct
+{
+    /// Pending read request, callback is NULL if none
+    uint8_t                 *rx_buf;
+    uint32_t                rx_size;
+    rwip_eif_callback       rx_cb;
+
+    /// Ring buffer position of the next byte to read
+    uint16_t                rx_out;
+
+    /// Receive line error since the last completed read
+    bool                    rx_error;
+
+    /// Flow disabled by uart_eif_flow_off_func()
+    bool                    flow_off;
+
+    /// Pending write request, callback is NULL if none
+    uint8_t                 *tx_req_buf;
+    uint32_t                tx_req_size;
+    rwip_eif_callback       tx_req_cb;
+
+    /// Callback of a write sent from the buffer of the transport layer, once sent
+    rwip_eif_callback       tx_direct_cb;
+
+    /// Transmission ongoing
+    volatile bool           tx_busy;
+
+    /// Index and length of the transmit buffer being filled
+    uint8_t                 tx_fill;
+    volatile uint16_t       tx_fill_len;
+
+    /// DMA channels of the reception and of the transmission
+    DMA_ID                  rx_dma_channel;
+    DMA_ID                  tx_dma_channel;
+} uart_eif_env_t;
+
+/// UART EIF environment, retained in retention memory area.
+static uart_eif_env_t uart_eif_env                                  __SECTION_ZERO("retention_mem_area0");
+
+/// Receive ring buffer, written by the DMA
+static uint8_t uart_eif_rx_ring[UART_EIF_RX_RING_SIZE]              __SECTION_ZERO("retention_mem_area0");
+
+/// Transmit buffers, one is filled while the other one is sent
+static uint8_t uart_eif_tx_buf[2][UART_EIF_TX_BUF_SIZE]             __SECTION_ZERO("retention_mem_area0");
+
+/*
+ * STATIC FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Number of received bytes not read yet.
+ ****************************************************************************************
+ */
+static uint16_t uart_eif_rx_used(void)
+{
+    return (dma_get_idx(uart_eif_env.rx_dma_channel) - uart_eif_env.rx_out) & (UART_EIF_RX_RING_SIZE - 1);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Set RTS according to the ring buffer level and program the DMA interrupt for
+ *        the pending read request or the ring buffer high level, whichever comes first.
+ ****************************************************************************************
+ */
+static void uart_eif_rx_arm(void)
+{
+    uint16_t target = UART_EIF_RX_RING_SIZE - UART_EIF_RX_MARGIN;
+    uint16_t used = uart_eif_rx_used();
+
+    uart_rtsn_setf(UART1, (!uart_eif_env.flow_off && (used < target)) ? UART_BIT_EN : UART_BIT_DIS);
+
+    if ((uart_eif_env.rx_cb != NULL) && (uart_eif_env.rx_size < target))
+    {
+        target = uart_eif_env.rx_size;
+    }
+
+    if (used < target)
+    {
+        dma_set_int(uart_eif_env.rx_dma_channel, ((uart_eif_env.rx_out + target - 1) & (UART_EIF_RX_RING_SIZE - 1)) + 1);
+
+        // The data may have arrived while the interrupt was programmed
+        if (uart_eif_rx_used() >= target)
+        {
+            NVIC_SetPendingIRQ(UART_IRQn);
+        }
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Complete the pending read request if enough data have been received.
+ * @return true if a request has been completed
+ ****************************************************************************************
+ */
+static bool uart_eif_rx_process(void)
+{
+    rwip_eif_callback cb = NULL;
+    uint8_t status = RWIP_EIF_STATUS_OK;
+
+    GLOBAL_INT_DISABLE();
+    if ((uart_eif_env.rx_cb != NULL) &&
+        (uart_eif_env.rx_error || (uart_eif_rx_used() >= uart_eif_env.rx_size)))
+    {
+        if (uart_eif_env.rx_error)
+        {
+            status = RWIP_EIF_STATUS_ERROR;
+            uart_eif_env.rx_error = false;
+        }
+        else
+        {
+            uint16_t first = co_min(uart_eif_env.rx_size, UART_EIF_RX_RING_SIZE - uart_eif_env.rx_out);
+
+            memcpy(uart_eif_env.rx_buf, &uart_eif_rx_ring[uart_eif_env.rx_out], first);
+            memcpy(&uart_eif_env.rx_buf[first], uart_eif_rx_ring, uart_eif_env.rx_size - first);
+            uart_eif_env.rx_out = (uart_eif_env.rx_out + uart_eif_env.rx_size) & (UART_EIF_RX_RING_SIZE - 1);
+        }
+
+        cb = uart_eif_env.rx_cb;
+        uart_eif_env.rx_cb = NULL;
+    }
+    GLOBAL_INT_RESTORE();
+
+    if (cb != NULL)
+    {
+        cb(status);
+    }
+
+    return (cb != NULL);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Send everything queued during the previous transmission at once.
+ ****************************************************************************************
+ */
+static void uart_eif_tx_start(void)
+{
+    if (!uart_eif_env.tx_busy && (uart_eif_env.tx_fill_len != 0))
+    {
+        uart_eif_env.tx_busy = true;
+        uart_send(UART1, uart_eif_tx_buf[uart_eif_env.tx_fill], uart_eif_env.tx_fill_len, UART_OP_DMA);
+
+        uart_eif_env.tx_fill ^= 1;
+        uart_eif_env.tx_fill_len = 0;
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Wait for the end of the ongoing transmission polling the DMA interrupt status
+ *        and complete it in place of the DMA interrupt handler, which may be masked.
+ ****************************************************************************************
+ */
+static void uart_eif_tx_wait(void)
+{
+    uint16_t done = 1 << DMA_CH_GET(uart_eif_env.tx_dma_channel);
+
+    while (uart_eif_env.tx_busy && !(dma_get_int_status() & done));
+
+    GLOBAL_INT_DISABLE();
+    if (uart_eif_env.tx_busy)
+    {
+        // The DMA interrupt handler will find nothing to do for this channel
+        dma_clear_int_reg(uart_eif_env.tx_dma_channel);
+        dma_channel_stop(uart_eif_env.tx_dma_channel);
+        uart_eif_env.tx_busy = false;
+    }
+    GLOBAL_INT_RESTORE();
+}
+
+/**
+ ****************************************************************************************
+ * @brief Queue the pending write request, complete the write sent from the buffer of the
+ *        transport layer and start the next transmission.
+ * @return true if a request has been completed
+ ****************************************************************************************
+ */
+static bool uart_eif_tx_process(void)
+{
+    rwip_eif_callback cb = NULL;
+
+    GLOBAL_INT_DISABLE();
+    if ((uart_eif_env.tx_direct_cb != NULL) && !uart_eif_env.tx_busy)
+    {
+        cb = uart_eif_env.tx_direct_cb;
+        uart_eif_env.tx_direct_cb = NULL;
+    }
+    else if (uart_eif_env.tx_req_cb != NULL)
+    {
+        if (uart_eif_env.tx_req_size > UART_EIF_TX_BUF_SIZE)
+        {
+            // Too long to be queued, sent once the queued data are out
+            if (!uart_eif_env.tx_busy && (uart_eif_env.tx_fill_len == 0) && (uart_eif_env.tx_direct_cb == NULL))
+            {
+                uart_eif_env.tx_direct_cb = uart_eif_env.tx_req_cb;
+                uart_eif_env.tx_req_cb = NULL;
+                uart_eif_env.tx_busy = true;
+                uart_send(UART1, uart_eif_env.tx_req_buf, uart_eif_env.tx_req_size, UART_OP_DMA);
+            }
+        }
+        else if ((uart_eif_env.tx_fill_len + uart_eif_env.tx_req_size) <= UART_EIF_TX_BUF_SIZE)
+        {
+            memcpy(&uart_eif_tx_buf[uart_eif_env.tx_fill][uart_eif_env.tx_fill_len], uart_eif_env.tx_req_buf, uart_eif_env.tx_req_size);
+            uart_eif_env.tx_fill_len += uart_eif_env.tx_req_size;
+
+            cb = uart_eif_env.tx_req_cb;
+            uart_eif_env.tx_req_cb = NULL;
+        }
+    }
+
+    uart_eif_tx_start();
+    GLOBAL_INT_RESTORE();
+
+    if (cb != NULL)
+    {
+        cb(RWIP_EIF_STATUS_OK);
+    }
+
+    return (cb != NULL);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Tx DMA callback, called upon Tx DMA completion
+ * @param[in] len           Data length of completed transaction
+ ****************************************************************************************
+ */
+static void uart_eif_tx_done(uint16_t len)
+{
+    uart_eif_env.tx_busy = false;
+    NVIC_SetPendingIRQ(UART_IRQn);
+}
+
+/**
+ ****************************************************************************************
+ * @brief Rx DMA callback, called when the programmed ring buffer position is reached
+ * @param[in] user_data     Not used
+ * @param[in] len           Not used
+ ****************************************************************************************
+ */
+static void uart_eif_rx_dma_callback(void *user_data, uint16_t len)
+{
+    NVIC_SetPendingIRQ(UART_IRQn);
+}
+
+/*
+ * GLOBAL FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+void uart_eif_init(const uart_cfg_t *uart_cfg)
+{
+    memset(&uart_eif_env, 0, sizeof(uart_eif_env));
+
+    uart_initialize(UART1, uart_cfg);
+    uart_register_tx_cb(UART1, uart_eif_tx_done);
+
+    // Receive continuously in the ring buffer
+    uart_eif_env.rx_dma_channel = (uart_cfg->uart_dma_channel == UART_DMA_CHANNEL_01) ? DMA_CHANNEL_0 : DMA_CHANNEL_2;
+    uart_eif_env.tx_dma_channel = (uart_cfg->uart_dma_channel == UART_DMA_CHANNEL_01) ? DMA_CHANNEL_1 : DMA_CHANNEL_3;
+
+    dma_cfg_t dma_cfg = {
+        .bus_width =    DMA_BW_BYTE,
+        .irq_enable =   DMA_IRQ_STATE_ENABLED,
+        .dreq_mode =    DMA_DREQ_TRIGGERED,
+        .src_inc =      DMA_INC_FALSE,
+        .dst_inc =      DMA_INC_TRUE,
+        .circular =     DMA_MODE_CIRCULAR,
+        .dma_prio =     uart_cfg->uart_dma_priority,
+        .dma_idle =     DMA_IDLE_BLOCKING_MODE,
+        .dma_init =     DMA_INIT_AX_BX_AY_BY,
+        .dma_sense =    DMA_SENSE_LEVEL_SENSITIVE,
+        .dma_req_mux =  DMA_TRIG_UART_RXTX,
+        .src_address =  (uint32_t) &(UART1)->UART_RBR_THR_DLL_REGF,
+        .dst_address =  (uint32_t) uart_eif_rx_ring,
+        .length =       UART_EIF_RX_RING_SIZE,
+        .irq_nr_of_trans = UART_EIF_RX_RING_SIZE - UART_EIF_RX_MARGIN,
+        .cb =           uart_eif_rx_dma_callback,
+        .user_data =    NULL,
+    };
+
+    dma_initialize(uart_eif_env.rx_dma_channel, &dma_cfg);
+    uart_dmasa_setf(UART1, UART_BIT_EN);
+    dma_channel_start(uart_eif_env.rx_dma_channel, DMA_IRQ_STATE_ENABLED);
+
+    // Line status errors are reported to the pending read request
+    uart_rls_intr_setf(UART1, UART_BIT_EN);
+    NVIC_SetPriority(UART_IRQn, uart_cfg->intr_priority);
+    NVIC_EnableIRQ(UART_IRQn);
+}
+
+void uart_eif_read_func(uint8_t *bufptr, uint32_t size, void (*callback) (uint8_t))
+{
+    ASSERT_ERROR(size < (UART_EIF_RX_RING_SIZE - UART_EIF_RX_MARGIN));
+
+    GLOBAL_INT_DISABLE();
+    uart_eif_env.rx_buf = bufptr;
+    uart_eif_env.rx_size = size;
+    uart_eif_env.rx_cb = callback;
+    GLOBAL_INT_RESTORE();
+
+    NVIC_SetPendingIRQ(UART_IRQn);
+}
+
+void uart_eif_write_func(uint8_t *bufptr, uint32_t size, void (*callback) (uint8_t))
+{
+    GLOBAL_INT_DISABLE();
+    uart_eif_env.tx_req_buf = bufptr;
+    uart_eif_env.tx_req_size = size;
+    uart_eif_env.tx_req_cb = callback;
+    GLOBAL_INT_RESTORE();
+
+    NVIC_SetPendingIRQ(UART_IRQn);
+}
+
+void uart_eif_flow_on_func(void)
+{
+    uart_eif_env.flow_off = false;
+    NVIC_SetPendingIRQ(UART_IRQn);
+}
+
+bool uart_eif_flow_off_func(void)
+{
+    bool idle;
+
+    GLOBAL_INT_DISABLE();
+    idle = !uart_eif_env.tx_busy && (uart_eif_env.tx_fill_len == 0) && (uart_eif_env.tx_req_cb == NULL) &&
+           (uart_eif_rx_used() == 0) && uart_tx_empty_getf(UART1);
+    if (idle)
+    {
+        uart_eif_env.flow_off = true;
+        uart_rtsn_setf(UART1, UART_BIT_DIS);
+    }
+    GLOBAL_INT_RESTORE();
+
+    // A byte may have been received before RTS was deasserted
+    if (idle && (uart_eif_rx_used() != 0))
+    {
+        uart_eif_flow_on_func();
+        idle = false;
+    }
+
+    return idle;
+}
+
+void uart_eif_finish_transfers_func(void)
+{
+    // Called with the interrupts masked before sleep, the transmissions are started and
+    // completed here polling the DMA and the UART
+    uart_eif_tx_wait();
+
+    GLOBAL_INT_DISABLE();
+    uart_eif_tx_start();
+    GLOBAL_INT_RESTORE();
+
+    uart_eif_tx_wait();
+
+    uart_wait_tx_finish(UART1);
+
+    // A write sent from the buffer of the transport layer is completed by the handler
+    NVIC_SetPendingIRQ(UART_IRQn);
+}
+
+void uart_eif_handler_func(void)
+{
+    bool progress;
+
+    // Clear the receive line status
+    if (uart_intr_id_getf(UART1) == UART_INT_RECEIVE_LINE_STAT)
+    {
+        uart_rls_error_getf(UART1);
+        uart_eif_env.rx_error = true;
+    }
+
+    // Several packets may be parsed per wakeup, the transport layers issue the next
+    // request from the completion callbacks
+    do
+    {
+        progress = uart_eif_rx_process();
+        progress |= uart_eif_tx_process();
+    } while (progress);
+
+    uart_eif_rx_arm();
+}
+
+#endif // CFG_UART_BATCHED_EIF
@@ -0,0 +1,136 @@
+/**
+ ****************************************************************************************
+ * @addtogroup Drivers
+ * @{
+ * @addtogroup UART
+ * @{
+ * @addtogroup UART_EIF UART Batched External Interface
+ * @brief Batched DMA external interface of the GTL/H4TL transport over UART1
+ * @{
+ *
+ * @file uart_eif.h
+ *
+ * @brief UART batched external interface header file.
+ *
+ * Replaces the UART1 ROM driver used by the GTL and H4TL transport layers. Received data
+ * are stored by a circular DMA transfer in a ring buffer, so that several packets are
+ * parsed per wakeup, and outgoing packets queued while a transmission is ongoing are sent
+ * together by the next DMA transfer. RTS is deasserted when the ring buffer is almost full
+ * and CTS is handled by the UART auto flow control.
+ *
+ * Requires CFG_UART1_SDK and CFG_UART_DMA_SUPPORT. Enabled with CFG_UART_BATCHED_EIF.
+ *
+ * Copyright (C) 2012-2019 Dialog Semiconductor.
+ * This computer program includes Confidential, Proprietary Information
+ * of Dialog Semiconductor. All Rights Reserved.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _UART_EIF_H_
+#define _UART_EIF_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uart.h"
+
+#if defined (CFG_UART_BATCHED_EIF)
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Size of the receive ring buffer, power of 2
+#ifndef UART_EIF_RX_RING_SIZE
+#define UART_EIF_RX_RING_SIZE       (512)
+#endif
+
+/// Free space of the receive ring buffer below which RTS is deasserted. It must cover the
+/// bytes the host may still send after RTS is deasserted.
+#ifndef UART_EIF_RX_MARGIN
+#define UART_EIF_RX_MARGIN          (64)
+#endif
+
+/// Size of each of the two transmit buffers. Longer packets are sent from the buffer of
+/// the transport layer.
+#ifndef UART_EIF_TX_BUF_SIZE
+#define UART_EIF_TX_BUF_SIZE        (264)
+#endif
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Initialize UART1 and start the reception in the ring buffer.
+ * @param[in] uart_cfg      UART1 configuration. The DMA channels, the auto flow control
+ *                          and the interrupt priority are used, the callbacks are not.
+ ****************************************************************************************
+ */
+void uart_eif_init(const uart_cfg_t *uart_cfg);
+
+/**
+ ****************************************************************************************
+ * @brief Start data reception. Completes as soon as the ring buffer holds size bytes.
+ * @param[out] bufptr       Pointer to the RX buffer
+ * @param[in] size          Size of the expected reception
+ * @param[in] callback      Callback to return upon completion
+ ****************************************************************************************
+ */
+void uart_eif_read_func(uint8_t *bufptr, uint32_t size, void (*callback) (uint8_t));
+
+/**
+ ****************************************************************************************
+ * @brief Start data transmission. Completes once the data have been queued.
+ * @param[in] bufptr        Pointer to the TX buffer
+ * @param[in] size          Size of the transmission
+ * @param[in] callback      Callback to return upon completion
+ ****************************************************************************************
+ */
+void uart_eif_write_func(uint8_t *bufptr, uint32_t size, void (*callback) (uint8_t));
+
+/**
+ ****************************************************************************************
+ * @brief Enable the flow, assert RTS.
+ ****************************************************************************************
+ */
+void uart_eif_flow_on_func(void);
+
+/**
+ ****************************************************************************************
+ * @brief Disable the flow if the interface is idle, deassert RTS.
+ * @return true if the flow has been disabled
+ ****************************************************************************************
+ */
+bool uart_eif_flow_off_func(void);
+
+/**
+ ****************************************************************************************
+ * @brief Wait until the queued data have been transmitted. The transmission is polled,
+ *        the function may be called with the interrupts masked.
+ ****************************************************************************************
+ */
+void uart_eif_finish_transfers_func(void);
+
+/**
+ ****************************************************************************************
+ * @brief UART1 interrupt handler. Completes the pending read and write requests.
+ ****************************************************************************************
+ */
+void uart_eif_handler_func(void);
+
+#endif // CFG_UART_BATCHED_EIF
+
+#endif // _UART_EIF_H_
+
+///@}
+///@}
+///@}
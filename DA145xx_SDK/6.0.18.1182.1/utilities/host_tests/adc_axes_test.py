@@ -0,0 +1,589 @@
+#!/usr/bin/env python3
+"""
+Host test of the analog axes of the HID-Gamepad-Digitizer example, user_adc_axes.c
+(CFG_ADC_AXES), and of their report in user_gamepad.c.
+
+user_adc_axes.c and user_gamepad.c are built unmodified against the SDK headers and the
+DA14531 configuration of the example, with the Y axis on P0_2 as when DEBUGGING is
+undefined. The ADC in continuous mode and the circular DMA transfer into the ring buffer
+are emulated conversion by conversion, a conversion every USER_ADC_AXES_INTERVAL ms: the
+conversion in progress when the half buffer interrupt switches the input is still taken
+on the previous one, and the interrupt comes when the DMA reaches the count set with
+dma_set_int(). The axes report is polled every AXIS_UPDATE_PER ms, the reports go to an
+emulated HOGPD. The checks:
+
+- each axis follows its own input, the other one stays at the center
+- a still joystick within the dead-zone reads exactly the center, the ends read 0 and 255
+- a slow sweep of an axis publishes a monotonic sequence that covers the whole range
+- a step is published within the delay of the moving average, and a still joystick with
+  noise sends few reports
+- one OTP correction per decimated value, the axes read once per change by
+  user_adc_axes_get()
+- the ADC and the DMA run, and the system stays in idle mode, only between
+  user_gamepad_toggle_axis_polling(true) and (false), and a new start begins at the center
+- the axes go in a report of their own, a report refused by HOGPD or a host switch sends
+  them again, and the UART2 frames are still typed in the keyboard report
+
+    adc_axes_test.py                         noise of 8 codes of 12 bits
+    adc_axes_test.py --noise 12 --seconds 30
+"""
+
+import argparse
+import ctypes
+import os
+import random
+import sys
+
+import host_c
+
+HARNESS = r"""
+#include "da1458x_config_basic.h"
+#include "da1458x_config_advanced.h"
+#include "user_config.h"
+#include "ll.h"
+
+// The analog axes with the keyboard of the UART2 frames, typed at once
+#define CFG_ADC_AXES
+#define CFG_ADC_DMA_SUPPORT
+#undef CFG_KBD_PACING
+// UART2 wakes the system up, the handlers are stubbed below
+#define CFG_UART2_WAKEUP
+
+// The release pinout, the Y axis on its own input
+#include "user_periph_setup.h"
+#undef ADC_AXIS_Y_INPUT
+#define ADC_AXIS_Y_INPUT        ADC_INPUT_SE_P0_2
+
+// The interrupts of the test run between its calls, a critical section is only counted
+int irq_lock;
+#undef GLOBAL_INT_DISABLE
+#undef GLOBAL_INT_RESTORE
+#define GLOBAL_INT_DISABLE()    do { irq_lock++;
+#define GLOBAL_INT_RESTORE()    irq_lock--; } while (0)
+
+#include "user_adc_axes.c"
+#include "user_gamepad.c"
+
+uint32_t host_reg_rd(uint32_t addr)
+{
+    uint32_t *val = reg(addr);
+
+    // Out of the continuous mode, the conversion in progress ends
+    if ((addr == GP_ADC_CTRL_REG) && !(*val & GP_ADC_CONT))
+        *val &= ~GP_ADC_START;
+    return *val;
+}
+
+void host_reg_wr(uint32_t addr, uint32_t value)
+{
+    *reg(addr) = value;
+}
+
+void __nop(void)
+{
+}
+
+/* ADC, the conversion of the selected input */
+static adc_input_se_t adc_sel;
+static adc_input_se_t conv_input;
+int adc_inits;
+int corrections;
+int bad_adc;
+
+void adc_init(const adc_config_t *cfg)
+{
+    if ((cfg->input_mode != ADC_INPUT_MODE_SINGLE_ENDED) || !cfg->continuous ||
+        (cfg->interval_mult != USER_ADC_AXES_INTERVAL) || (cfg->oversampling != USER_ADC_AXES_OVERSAMPLING))
+        bad_adc++;
+    SetWord16(GP_ADC_CTRL_REG, GP_ADC_EN | GP_ADC_CONT);
+    adc_sel = (adc_input_se_t) cfg->input;
+    adc_inits++;
+}
+
+void adc_set_se_input(adc_input_se_t input)
+{
+    adc_sel = input;
+}
+
+void adc_start(void)
+{
+    SetBits16(GP_ADC_CTRL_REG, GP_ADC_START, 1);
+    conv_input = adc_sel;
+}
+
+void adc_disable(void)
+{
+    SetBits16(GP_ADC_CTRL_REG, GP_ADC_EN, 0);
+}
+
+uint16_t adc_correct_sample(const uint16_t input)
+{
+    corrections++;
+    return input;
+}
+
+/* DMA channel of the ADC, circular into the ring buffer */
+static dma_cb_t dma_cb;
+static bool dma_on;
+static uint16_t dma_idx;
+int interrupts;
+int bad_dma;
+
+void dma_initialize(DMA_ID id, dma_cfg_t *cfg)
+{
+    // The address is 64-bit on the host, the conversions go to adc_axes_ring
+    if ((id != ADC_AXES_DMA_CHANNEL) || (cfg->circular != DMA_MODE_CIRCULAR) ||
+        (cfg->dma_req_mux != DMA_TRIG_ADC_RX) || (cfg->dst_inc != DMA_INC_TRUE) ||
+        (cfg->bus_width != DMA_BW_HALFWORD) || (cfg->length != 2 * USER_ADC_AXES_BLOCK) ||
+        (cfg->dst_address != (uint32_t)(uintptr_t) adc_axes_ring))
+        bad_dma++;
+    dma_cb = cfg->cb;
+    dma_idx = 0;
+    SetWord16(DMA(id)->DMA_INT_REG, cfg->irq_nr_of_trans - 1);
+}
+
+void dma_channel_start(DMA_ID id, DMA_IRQ_CFG irq_en)
+{
+    dma_on = true;
+}
+
+void dma_channel_stop(DMA_ID id)
+{
+    dma_on = false;
+}
+
+/* n conversions, codes[] holds the 12-bit code of each axis for each of them */
+void run(int n, const uint16_t *codes)
+{
+    for (int i = 0; i < n; i++, codes += USER_ADC_AXES_NUM)
+    {
+        uint16_t ctrl = GetWord16(GP_ADC_CTRL_REG);
+        uint16_t code = 0;
+
+        if (!(ctrl & GP_ADC_EN) || !(ctrl & GP_ADC_START))
+            continue;
+        for (int axis = 0; axis < USER_ADC_AXES_NUM; axis++)
+            if (adc_axes_inputs[axis] == conv_input)
+                code = codes[axis];
+
+        // The next conversion starts at once on the input selected now
+        if (!(ctrl & GP_ADC_CONT))
+            SetBits16(GP_ADC_CTRL_REG, GP_ADC_START, 0);
+        conv_input = adc_sel;
+        if (!(ctrl & GP_ADC_DMA_EN) || !dma_on)
+        {
+            bad_dma++;
+            continue;
+        }
+
+        // The result of the oversampling is 16-bit
+        adc_axes_ring[dma_idx++] = code << 4;
+        if (dma_idx == dma_get_int(ADC_AXES_DMA_CHANNEL))
+        {
+            interrupts++;
+            dma_cb(NULL, dma_idx);
+        }
+        if (dma_idx == 2 * USER_ADC_AXES_BLOCK)
+            dma_idx = 0;
+    }
+}
+
+bool adc_running(void)
+{
+    return dma_on || (GetWord16(GP_ADC_CTRL_REG) & (GP_ADC_EN | GP_ADC_START | GP_ADC_DMA_EN));
+}
+
+/* Application */
+void app_easy_security_bdb_init(void) {}
+void app_set_prf_srv_perm(enum KE_API_ID task_id, app_prf_srv_perm_t srv_perm) {}
+timer_hnd app_easy_timer(const uint32_t delay, timer_callback fn) { return EASY_TIMER_INVALID_TIMER; }
+enum process_event_response app_hogpd_process_handler(ke_msg_id_t const msgid, void const *param,
+                                                      ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    return PR_EVENT_UNHANDLED;
+}
+void user_conn_ctrl_traffic_ind(void) {}
+void user_uart_wakeup_init(void) {}
+void user_uart_wakeup_keep_awake(void) {}
+bool user_uart_wakeup_awake(void) { return false; }
+void user_trace_rx_start(void) {}
+void user_trace_rx_end(void) {}
+void user_trace_frame_dispatch(void) {}
+void user_trace_frame_done(void) {}
+uint16_t user_stream_write(uint8_t conidx, const uint8_t *data, uint16_t len) { return len; }
+
+/* HOGPD, the reports go to the test */
+static bool (*report_cb)(uint8_t idx, const uint8_t *report, uint16_t length);
+static uint8_t active_host;
+int bad_reports;
+
+bool app_hogpd_send_report(uint8_t report_idx, uint8_t *data, uint16_t length, enum hogpd_report_type type)
+{
+    if ((type != HOGPD_REPORT) || (irq_lock != 0))
+    {
+        bad_reports++;
+        return false;
+    }
+    return report_cb(report_idx, data, length);
+}
+
+uint8_t app_hogpd_get_active_host(void)
+{
+    return active_host;
+}
+
+bool app_hogpd_set_active_host(uint8_t conidx)
+{
+    if (conidx >= APP_EASY_MAX_ACTIVE_CONNECTION)
+        return false;
+    active_host = conidx;
+    return true;
+}
+
+/* UART2, a frame at a time */
+static uart_cb_t uart_rx_cb;
+static uint8_t *uart_rx_data;
+
+void uart_register_rx_cb(uart_t *uart_id, uart_cb_t cb)
+{
+    uart_rx_cb = cb;
+}
+
+void uart_receive(uart_t *uart_id, uint8_t *data, uint16_t len, UART_OP_CFG op)
+{
+    if ((uart_id != UART2) || (len != 1) || (op != UART_OP_INTR))
+        abort();
+    uart_rx_data = data;
+}
+
+void uart_send(uart_t *uart_id, const uint8_t *data, uint16_t len, UART_OP_CFG op)
+{
+}
+
+void uart_rx_frame(const uint8_t *frame, int len)
+{
+    for (int i = 0; i < len; i++)
+    {
+        uint8_t *data = uart_rx_data;
+
+        if (data == NULL)
+            abort();
+        uart_rx_data = NULL;
+        *data = frame[i];
+        uart_rx_cb(1);
+    }
+}
+
+void start(bool (*report)(uint8_t, const uint8_t *, uint16_t))
+{
+    report_cb = report;
+    active_host = 0;
+    rx_cnt = 0;
+    rx_flag = 0;
+    rx_frame_len = 0;
+    uart_rx_data = NULL;
+    user_gamepad_uart_rx_resume();
+}
+
+uint8_t axes_value(int axis)
+{
+    return adc_axes_env.value[axis];
+}
+
+const int axes_num = USER_ADC_AXES_NUM;
+const int block = USER_ADC_AXES_BLOCK;
+const int avg_len = ADC_AXES_AVG_LEN;
+const int interval = USER_ADC_AXES_INTERVAL;
+const int sample_max = ADC_SAMPLE_MAX;
+const int deadzone = ADC_AXES_DEADZONE;
+const int poll_ms = AXIS_UPDATE_PER;
+const int axes_idx = HID_GAMEPAD_ADC_AXES_REPORT_IDX;
+const int axes_size = HID_GAMEPAD_ADC_AXES_REPORT_SIZE;
+const int kbd_idx = HID_GAMEPAD_AXIS_REPORT_IDX;
+const int kbd_size = HID_GAMEPAD_AXIS_REPORT_SIZE;
+const int sleep_active = mode_active;
+const int sleep_idle = mode_idle;
+const int sleep_ext = mode_ext_sleep;
+"""
+
+REPORT_CB = ctypes.CFUNCTYPE(ctypes.c_bool, ctypes.c_uint8, ctypes.POINTER(ctypes.c_uint8), ctypes.c_uint16)
+
+CENTER = 0x80
+CONV_MS = 1.024                 # a conversion per interval unit
+
+
+def build():
+    # The quoted includes of the sources must find the stub of datasheet.h first
+    lib = host_c.build("adc_axes_test", host_c.REG_FILE + HARNESS,
+                       stubs={"datasheet.h": host_c.DATASHEET_531},
+                       copies=[os.path.join(host_c.HID_EXAMPLE, name)
+                               for name in ("user_adc_axes.c", "user_gamepad.c")],
+                       includes=host_c.HID_INCLUDES + host_c.sdk_includes(), defines={"__DA14531__": None})
+    lib.start.argtypes = [REPORT_CB]
+    lib.run.argtypes = [ctypes.c_int, ctypes.POINTER(ctypes.c_uint16)]
+    lib.uart_rx_frame.argtypes = [ctypes.c_char_p, ctypes.c_int]
+    lib.axes_value.argtypes = [ctypes.c_int]
+    lib.axes_value.restype = ctypes.c_uint8
+    lib.adc_running.restype = ctypes.c_bool
+    lib.user_adc_axes_get.argtypes = [ctypes.POINTER(ctypes.c_uint8)]
+    lib.user_adc_axes_get.restype = ctypes.c_bool
+    lib.user_adc_axes_validate_sleep.argtypes = [ctypes.c_int]
+    lib.user_adc_axes_validate_sleep.restype = ctypes.c_int
+    lib.user_gamepad_toggle_axis_polling.argtypes = [ctypes.c_bool]
+    lib.kbd_code.argtypes = [ctypes.c_uint8]
+    lib.kbd_code.restype = ctypes.c_uint8
+    return lib
+
+
+class Test:
+    def __init__(self, args):
+        self.args = args
+        self.lib = build()
+        self.rnd = random.Random(args.seed)
+        self.failures = []
+        self.c = {name: host_c.cint(self.lib, name).value for name in
+                  ("axes_num", "block", "avg_len", "interval", "sample_max", "deadzone", "poll_ms",
+                   "axes_idx", "axes_size", "kbd_idx", "kbd_size", "sleep_active", "sleep_idle", "sleep_ext")}
+        self.conv_ms = CONV_MS * self.c["interval"]
+        self.reports = []           # (ms, idx, bytes)
+        self.refuse = 0
+        self.now = 0.0
+        self.report_cb = REPORT_CB(self.report)
+        self.lib.start(self.report_cb)
+
+    def report(self, idx, data, length):
+        if self.refuse:
+            self.refuse -= 1
+            return False
+        self.reports.append((self.now, idx, bytes(data[:length])))
+        return True
+
+    def fail(self, msg):
+        self.failures.append(msg)
+
+    def counter(self, name):
+        return host_c.cint(self.lib, name).value
+
+    def code(self, level):
+        """12-bit code of a level of 0.0 (low end) to 1.0 (high end)."""
+        return level * self.c["sample_max"]
+
+    def axes(self):
+        return [self.lib.axes_value(axis) for axis in range(self.c["axes_num"])]
+
+    def run(self, ms, inputs, noise=None):
+        """The inputs, a function of the time in ms per axis giving a 12-bit code, converted
+        for ms, the axes report polled every AXIS_UPDATE_PER ms. Returns the axes reports."""
+        noise = self.args.noise if noise is None else noise
+        num = self.c["axes_num"]
+        start = len(self.reports)
+        poll = self.c["poll_ms"]
+        end = self.now + ms
+        while self.now < end - 1e-9:
+            n = max(1, int(round(poll / self.conv_ms)))
+            codes = (ctypes.c_uint16 * (n * num))()
+            for i in range(n):
+                t = self.now + i * self.conv_ms
+                for axis in range(num):
+                    code = inputs[axis](t) + self.rnd.gauss(0, noise) if noise else inputs[axis](t)
+                    codes[i * num + axis] = max(0, min(4095, int(round(code))))
+            self.lib.run(n, codes)
+            self.now += n * self.conv_ms
+            self.lib.user_gamepad_axis_polling_cb()
+        return [(t, data) for t, idx, data in self.reports[start:] if idx == self.c["axes_idx"]]
+
+    def hold(self, ms, *levels, noise=None):
+        return self.run(ms, [lambda t, v=self.code(level): v for level in levels], noise)
+
+    def settle_ms(self):
+        """Time for a step to go through the decimation and the moving average of an axis."""
+        per_value = self.c["axes_num"] * self.c["block"] * self.conv_ms
+        return (self.c["avg_len"] + 1) * per_value + self.c["poll_ms"]
+
+    def check_reports(self):
+        bad = [(idx, len(data)) for t, idx, data in self.reports
+               if (idx, len(data)) not in ((self.c["axes_idx"], self.c["axes_size"]),
+                                           (self.c["kbd_idx"], self.c["kbd_size"]))]
+        if bad or self.counter("bad_reports"):
+            self.fail("%d reports of unknown index or size, e.g. %s, %d sent in a critical section or "
+                      "not as input reports" % (len(bad), bad[:3], self.counter("bad_reports")))
+        if self.counter("bad_adc") or self.counter("bad_dma"):
+            self.fail("ADC set up %d times and DMA %d times out of the axes configuration"
+                      % (self.counter("bad_adc"), self.counter("bad_dma")))
+
+    def check_start(self):
+        lib = self.lib
+        c = self.c
+        if lib.adc_running() or lib.user_adc_axes_validate_sleep(c["sleep_ext"]) != c["sleep_ext"]:
+            self.fail("ADC running or sleep limited before the start")
+        lib.user_gamepad_toggle_axis_polling(True)
+        if not lib.adc_running():
+            self.fail("ADC not running after the start")
+        for mode in (c["sleep_ext"], c["sleep_idle"], c["sleep_active"]):
+            want = c["sleep_active"] if mode == c["sleep_active"] else c["sleep_idle"]
+            if lib.user_adc_axes_validate_sleep(mode) != want:
+                self.fail("sleep mode %d gives %d while sampling" % (mode, lib.user_adc_axes_validate_sleep(mode)))
+
+    def check_center(self, seconds):
+        sent = self.hold(seconds * 1000, 0.5, 0.5)
+        dz = self.c["deadzone"] / 255.0
+        sent += self.hold(seconds * 1000, 0.5 + dz / 2, 0.5 - dz / 2)
+        if sent or self.axes() != [CENTER] * self.c["axes_num"]:
+            self.fail("still joystick in the dead-zone: axes %s, %d reports" % (self.axes(), len(sent)))
+
+    def check_ends(self):
+        num = self.c["axes_num"]
+        settle = self.settle_ms()
+        for axis in range(num):
+            for level, want in ((1.1, 0xFF), (-0.1, 0x00)):
+                levels = [0.5] * num
+                levels[axis] = level
+                sent = self.hold(2 * settle, *levels)
+                expect = [CENTER] * num
+                expect[axis] = want
+                if self.axes() != expect or not sent or list(sent[-1][1]) != expect:
+                    self.fail("axis %d at %s: axes %s, last report %s"
+                              % (axis, level, self.axes(), list(sent[-1][1]) if sent else None))
+                crosstalk = [list(data) for t, data in sent
+                             if any(data[a] != CENTER for a in range(num) if a != axis)]
+                if crosstalk:
+                    self.fail("axis %d moved the other axes: %s" % (axis, crosstalk[:3]))
+            self.hold(2 * settle, *([0.5] * num))
+
+    def check_sweep(self, seconds):
+        num = self.c["axes_num"]
+        ms = seconds * 1000.0
+        for axis in range(num):
+            self.hold(2 * self.settle_ms(), *[0.5 if a != axis else 0.0 for a in range(num)])
+            inputs = [lambda t: self.code(0.5)] * num
+            # From below to above the range, the ends saturate whatever the noise
+            inputs[axis] = lambda t, t0=self.now: self.code(min(1.1, (t - t0) / ms * 1.1))
+            sent = self.run(ms + 2 * self.settle_ms(), inputs)
+            values = [data[axis] for t, data in sent]
+            drops = [(a, b) for a, b in zip(values, values[1:]) if b < a]
+            if drops or not values or values[-1] != 0xFF:
+                self.fail("sweep of axis %d: %d reports, %d decreasing, ends at %s"
+                          % (axis, len(values), len(drops), values[-1] if values else None))
+            print("sweep of axis %d in %g s: %d reports" % (axis, seconds, len(values)))
+            self.hold(2 * self.settle_ms(), *([0.5] * num))
+
+    def check_step(self):
+        num = self.c["axes_num"]
+        bound = self.settle_ms()
+        worst = 0.0
+        for axis in range(num):
+            for level, want in ((1.1, 0xFF), (0.5, CENTER), (-0.1, 0x00), (0.5, CENTER)):
+                levels = [0.5] * num
+                levels[axis] = level
+                t0 = self.now
+                sent = self.hold(2 * bound, *levels)
+                at = next((t - t0 for t, data in sent if data[axis] == want), None)
+                if at is None or at > bound:
+                    self.fail("axis %d step to %s published after %s ms, bound %.0f ms" % (axis, level, at, bound))
+                else:
+                    worst = max(worst, at)
+        print("step published within %.1f ms, bound %.1f ms" % (worst, bound))
+
+    def check_noise(self, seconds):
+        num = self.c["axes_num"]
+        before = self.counter("interrupts")
+        corrections = self.counter("corrections")
+        sent = self.hold(seconds * 1000, *([0.75] * num))
+        irqs = self.counter("interrupts") - before
+        if self.counter("corrections") - corrections != irqs:
+            self.fail("%d OTP corrections for %d decimated values" % (self.counter("corrections") - corrections, irqs))
+        # After the move to the level, a report per second on average at most
+        if len(sent) > num + seconds:
+            self.fail("still joystick with noise %g: %d reports in %d s" % (self.args.noise, len(sent), seconds))
+        print("still joystick with noise %g: %d reports in %d s, %.0f interrupts/s instead of %.0f "
+              "one-shot conversions/s" % (self.args.noise, len(sent), seconds, irqs / seconds,
+                                         1000.0 / self.conv_ms))
+
+    def check_get(self):
+        lib = self.lib
+        num = self.c["axes_num"]
+        lib.user_gamepad_toggle_axis_polling(False)
+        lib.user_gamepad_toggle_axis_polling(True)
+        axes = (ctypes.c_uint8 * num)()
+        self.run(2 * self.settle_ms(), [lambda t: self.code(0.9)] * num)
+        # The polling took the change, nothing new since
+        if lib.user_adc_axes_get(axes):
+            self.fail("user_adc_axes_get() reports a change already sent")
+        # Enough conversions at 0 for the moving average, not polled
+        n = (self.c["avg_len"] + 1) * num * self.c["block"]
+        self.lib.run(n, (ctypes.c_uint16 * (n * num))())
+        self.now += n * self.conv_ms
+        first = lib.user_adc_axes_get(axes)
+        second = lib.user_adc_axes_get(axes)
+        if not first or second or list(axes) != [0] * num:
+            self.fail("user_adc_axes_get(): %s then %s, axes %s" % (first, second, list(axes)))
+
+    def check_stop(self):
+        lib = self.lib
+        c = self.c
+        num = self.c["axes_num"]
+        lib.user_gamepad_toggle_axis_polling(False)
+        if lib.adc_running() or lib.user_adc_axes_validate_sleep(c["sleep_ext"]) != c["sleep_ext"]:
+            self.fail("ADC running or sleep limited after the stop")
+        irqs = self.counter("interrupts")
+        sent = self.hold(100, *([1.0] * num))
+        if self.counter("interrupts") != irqs or sent:
+            self.fail("%d interrupts and %d reports after the stop" % (self.counter("interrupts") - irqs, len(sent)))
+        inits = self.counter("adc_inits")
+        lib.user_gamepad_toggle_axis_polling(True)
+        if self.counter("adc_inits") != inits + 1 or self.axes() != [CENTER] * num:
+            self.fail("restart: %d ADC setups, axes %s" % (self.counter("adc_inits") - inits, self.axes()))
+        self.hold(2 * self.settle_ms(), *([0.5] * num))
+
+    def check_report_path(self):
+        lib = self.lib
+        num = self.c["axes_num"]
+        settle = self.settle_ms()
+        self.hold(2 * settle, *([1.1] * num))
+        # The host selected gets the axes as they are, a report refused by HOGPD goes at the next poll
+        self.refuse = 1
+        lib.uart_rx_frame(b"\x1b1!", 3)
+        sent = self.hold(2 * self.c["poll_ms"], *([1.1] * num))
+        if self.refuse or [list(d) for t, d in sent] != [[0xFF] * num]:
+            self.fail("host switch with a refused report: axes reports %s" % [list(d) for t, d in sent])
+        # A keyboard frame with the axes moving
+        text = b"Axes 42"
+        start = len(self.reports)
+        lib.uart_rx_frame(text + b"!", len(text) + 1)
+        sent = self.run(2 * settle, [lambda t: self.code(0.5)] * num)
+        keys = [data for t, idx, data in self.reports[start:] if idx == self.c["kbd_idx"]]
+        presses = [(data[0], data[2]) for data in keys if data[2]]
+        want = [((0x02 if lib.kbd_code(ch) & 0x80 else 0), lib.kbd_code(ch) & 0x7F) for ch in text]
+        if presses != want or len(keys) != 2 * len(text):
+            self.fail("keyboard frame with CFG_ADC_AXES: %d reports, presses %s" % (len(keys), presses[:4]))
+        if not sent or list(sent[-1][1]) != [CENTER] * num:
+            self.fail("axes not sent next to the keyboard frame")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--noise", type=float, default=8.0, help="ADC noise, standard deviation in 12-bit codes")
+    parser.add_argument("--seconds", type=int, default=10, help="duration of the still joystick checks")
+    parser.add_argument("--sweep", type=float, default=4.0, help="duration of a sweep in s")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    test = Test(args)
+    print("%d axes, a conversion every %.3f ms, a decimated value per axis every %.1f ms"
+          % (test.c["axes_num"], test.conv_ms, test.c["axes_num"] * test.c["block"] * test.conv_ms))
+    test.check_start()
+    test.check_center(args.seconds)
+    test.check_ends()
+    test.check_sweep(args.sweep)
+    test.check_step()
+    test.check_noise(args.seconds)
+    test.check_get()
+    test.check_stop()
+    test.check_report_path()
+    test.check_reports()
+
+    return host_c.report(test.failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
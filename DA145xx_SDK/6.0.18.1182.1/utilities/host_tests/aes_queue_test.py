@@ -0,0 +1,809 @@
+#!/usr/bin/env python3
+"""
+Unit test and benchmark of the AES job queue (aes_queue.c).
+
+aes_queue.c is built twice against stub headers, with the software backend
+(AES_QUEUE_SW_BACKEND, on sw_aes.c) and with the BLE core engine backend on an emulated
+engine. The emulated engine takes the key registers and the reversed plaintext in the
+exchange memory as aes_enc_dec() writes them and encrypts with sw_aes.c. An emulated
+link layer shares the engine: its encryption requests are queued in llm_le_env.enc_req
+and started by llm_encryption_start() and llm_encryption_done_func().
+
+Both builds are checked against the NIST SP 800-38A (ECB, CBC, CTR) and SP 800-38C (CCM)
+vectors. The engine build then runs random jobs with random scatter-gather lists,
+interleaved with link layer requests and engine completions, and checks
+ - the output, the chained IV and the MIC of every job against a reference on sw_aes.c,
+ - CCM decryption and the rejection of a wrong MIC,
+ - one callback per job, in submission order,
+ - that a link layer request made while a block of the queue is in the engine is started
+   at the end of that block, before the next block of the queue,
+ - that the engine is never started while busy and never left idle with work pending.
+The software build is benchmarked per mode and job length.
+
+    aes_queue_test.py
+    aes_queue_test.py --jobs 20000 --seed 3
+"""
+
+import argparse
+import ctypes
+import os
+import random
+import sys
+
+import host_c
+
+CRYPTO = os.path.join(host_c.SDK_SRC, "platform", "core_modules", "crypto")
+COMMON = os.path.join(host_c.SDK_SRC, "platform", "core_modules", "common", "api")
+
+ECB, CBC, CTR, CCM = 0, 1, 2, 3
+AES_ENCRYPT, AES_DECRYPT = 1, 0
+ERR_NO_ERR, ERR_INVALID_PARAM, ERR_MIC = 0, 1, 2
+
+STUBS = {
+    "rwip_config.h": """
+#ifndef RWIP_CONFIG_H_
+#define RWIP_CONFIG_H_
+#endif
+""",
+    "compiler.h": """
+#ifndef COMPILER_H_
+#define COMPILER_H_
+#define __STATIC_FORCEINLINE        static inline
+#define __INLINE                    static inline
+#define __SECTION_ZERO(sec)
+#endif
+""",
+    "co_bt.h": "",
+    "aes_api.h": """
+#ifndef AES_API_H_
+#define AES_API_H_
+#include <stdint.h>
+#include "sw_aes.h"
+#define ENC_DATA_LEN                16
+#define GETU32(pt)     (((uint32_t)(pt)[0] << 24) ^ ((uint32_t)(pt)[1] << 16) ^ ((uint32_t)(pt)[2] <<  8) ^ ((uint32_t)(pt)[3]))
+#define PUTU32(ct, st) { (ct)[0] = (uint8_t)((st) >> 24); (ct)[1] = (uint8_t)((st) >> 16); (ct)[2] = (uint8_t)((st) >>  8); (ct)[3] = (uint8_t)(st); }
+#endif
+""",
+    "ll.h": """
+#ifndef LL_H_
+#define LL_H_
+#define GLOBAL_INT_DISABLE()        do {
+#define GLOBAL_INT_RESTORE()        } while (0)
+#endif
+""",
+    "ke_msg.h": """
+#ifndef KE_MSG_H_
+#define KE_MSG_H_
+#include <stddef.h>
+#include "co_list.h"
+struct ke_msg
+{
+    struct co_list_hdr hdr;
+    uint32_t saved;
+    uint16_t id;
+    uint16_t dest_id;
+    uint16_t src_id;
+    uint16_t param_len;
+    uint32_t param[1];
+};
+static inline void *ke_msg2param(struct ke_msg const *msg)
+{
+    return (void *) (((uint8_t *) msg) + offsetof(struct ke_msg, param));
+}
+#endif
+""",
+    "llm.h": """
+#ifndef LLM_H_
+#define LLM_H_
+#include <stdbool.h>
+#include "co_list.h"
+struct llm_le_env_tag
+{
+    struct co_list enc_req;
+    bool enc_pend;
+};
+extern struct llm_le_env_tag llm_le_env;
+struct llm_enc_req
+{
+    uint8_t key[16];
+    uint8_t plain_data[16];
+    uint32_t tag;
+};
+void llm_encryption_start(struct llm_enc_req const *param);
+#endif
+""",
+    "em_map.h": """
+#ifndef EM_MAP_H_
+#define EM_MAP_H_
+#include <stdint.h>
+extern uint8_t em_mem[64];
+#define EM_BASE_ADDR                ((uintptr_t) em_mem)
+#define EM_BLE_ENC_PLAIN_OFFSET     (0)
+#define EM_BLE_ENC_CIPHER_OFFSET    (32)
+void em_rd(void *sys_addr, uint16_t em_addr, uint16_t size);
+#endif
+""",
+    "reg_blecore.h": """
+#ifndef REG_BLECORE_H_
+#define REG_BLECORE_H_
+#include <stdint.h>
+#define BLE_AES_START_BIT           (0x00000001)
+void ble_aeskey31_0_set(uint32_t value);
+void ble_aeskey63_32_set(uint32_t value);
+void ble_aeskey95_64_set(uint32_t value);
+void ble_aeskey127_96_set(uint32_t value);
+void ble_aesptr_set(uint16_t value);
+void ble_aescntl_set(uint32_t value);
+#endif
+""",
+}
+
+HARNESS = r"""
+#include <stdlib.h>
+#include <time.h>
+#include "aes_queue.c"
+
+/* co_list, as in the ROM */
+
+void co_list_push_back(struct co_list *list, struct co_list_hdr *list_hdr)
+{
+    if (list->first == NULL)
+    {
+        list->first = list_hdr;
+    }
+    else
+    {
+        list->last->next = list_hdr;
+    }
+    list->last = list_hdr;
+    list_hdr->next = NULL;
+}
+
+struct co_list_hdr *co_list_pop_front(struct co_list *list)
+{
+    struct co_list_hdr *element = list->first;
+
+    if (element != NULL)
+    {
+        list->first = element->next;
+    }
+    return element;
+}
+
+/* Reference block encryption on sw_aes */
+
+void ref_encrypt(const uint8_t *key, const uint8_t *in, uint8_t *out)
+{
+    AES_CTX ctx;
+    uint32_t data[4];
+    uint8_t i;
+    static const uint8_t iv[16];
+
+    AES_set_key(&ctx, key, iv, AES_MODE_128);
+    for (i = 0; i < 4; i++)
+    {
+        data[i] = GETU32(&in[i * 4]);
+    }
+    AES_encrypt(&ctx, data);
+    for (i = 0; i < 4; i++)
+    {
+        PUTU32(&out[i * 4], data[i]);
+    }
+}
+
+/* Jobs submitted by the host */
+
+#define JOBS_MAX    64
+#define SG_MAX      8
+
+struct host_job
+{
+    struct aes_queue_job job;
+    struct aes_queue_sg sg[SG_MAX];
+    int done;
+    int status;
+    int order;
+};
+
+static struct host_job jobs[JOBS_MAX];
+static int completions;
+
+static void job_cb(struct aes_queue_job *job, uint8_t status)
+{
+    struct host_job *hj = (struct host_job *) job;
+
+    hj->done++;
+    hj->status = status;
+    hj->order = completions++;
+}
+
+int job_submit(int slot, int mode, int enc_dec, const uint8_t *key, const uint8_t *iv, int nonce_len, int mic_len,
+               const uint8_t *adata, int adata_len, uint8_t *mic, const uint8_t *in, uint8_t *out,
+               const uint16_t *sg_len, int sg_cnt)
+{
+    struct host_job *hj = &jobs[slot];
+    int off = 0;
+
+    memset(hj, 0, sizeof(*hj));
+    hj->job.mode = mode;
+    hj->job.enc_dec = enc_dec;
+    hj->job.key = key;
+    memcpy(hj->job.iv, iv, AES_QUEUE_BLK_SIZE);
+    hj->job.nonce_len = nonce_len;
+    hj->job.mic_len = mic_len;
+    hj->job.adata = adata;
+    hj->job.adata_len = adata_len;
+    hj->job.mic = mic;
+    for (int i = 0; i < sg_cnt; i++)
+    {
+        hj->sg[i].in = in + off;
+        hj->sg[i].out = out + off;
+        hj->sg[i].len = sg_len[i];
+        off += sg_len[i];
+    }
+    hj->job.sg = hj->sg;
+    hj->job.sg_cnt = sg_cnt;
+    hj->job.cb = job_cb;
+    hj->done = 0;
+    hj->order = -1;
+    return aes_queue_submit(&hj->job);
+}
+
+int job_state(int slot, uint8_t *iv)
+{
+    memcpy(iv, jobs[slot].job.iv, AES_QUEUE_BLK_SIZE);
+    return jobs[slot].done * 1000 + jobs[slot].status * 100;
+}
+
+int job_order(int slot)
+{
+    return jobs[slot].order;
+}
+
+int queue_idle(void)
+{
+    return aes_queue_is_idle();
+}
+
+#if !defined (AES_QUEUE_SW_BACKEND)
+
+/* Emulated BLE core AES engine */
+
+uint8_t em_mem[64];
+static uint32_t aes_key[4];
+static uint16_t aes_ptr;
+static int engine_busy;
+static int ll_starting;
+static int engine_owner;        // 'Q' or 'L'
+
+struct llm_le_env_tag llm_le_env;
+
+struct engine_stats
+{
+    uint32_t queue_blocks;
+    uint32_t ll_blocks;
+    uint32_t collisions;
+    uint32_t ll_skipped;
+    uint32_t stalls;
+    uint32_t ll_wait_max;
+};
+
+struct engine_stats engine_stats;
+static int expect_ll;
+
+void ble_aeskey31_0_set(uint32_t value)     { aes_key[3] = value; }
+void ble_aeskey63_32_set(uint32_t value)    { aes_key[2] = value; }
+void ble_aeskey95_64_set(uint32_t value)    { aes_key[1] = value; }
+void ble_aeskey127_96_set(uint32_t value)   { aes_key[0] = value; }
+void ble_aesptr_set(uint16_t value)         { aes_ptr = value; }
+
+void ble_aescntl_set(uint32_t value)
+{
+    if (engine_busy)
+    {
+        engine_stats.collisions++;
+    }
+    engine_busy = 1;
+    engine_owner = ll_starting ? 'L' : 'Q';
+    if (expect_ll && (engine_owner != 'L'))
+    {
+        engine_stats.ll_skipped++;
+    }
+    expect_ll = 0;
+    ll_starting = 0;
+}
+
+void em_rd(void *sys_addr, uint16_t em_addr, uint16_t size)
+{
+    memcpy(sys_addr, &em_mem[em_addr], size);
+}
+
+/* Emulated link layer: requests are pushed in llm_le_env.enc_req and the first one is
+   started if no encryption is pending, llm_encryption_done_func() completes the first one
+   and starts the following one */
+
+struct ll_result
+{
+    uint32_t tag;
+    uint8_t cipher[16];
+    uint32_t wait;
+};
+
+#define LL_RESULTS_MAX  4096
+struct ll_result ll_results[LL_RESULTS_MAX];
+int ll_result_cnt;
+
+void llm_encryption_start(struct llm_enc_req const *param)
+{
+    ble_aeskey31_0_set(GETU32(&param->key[12]));
+    ble_aeskey63_32_set(GETU32(&param->key[8]));
+    ble_aeskey95_64_set(GETU32(&param->key[4]));
+    ble_aeskey127_96_set(GETU32(&param->key[0]));
+    for (int i = 0; i < 16; i++)
+    {
+        em_mem[EM_BLE_ENC_PLAIN_OFFSET + i] = param->plain_data[15 - i];
+    }
+    ble_aesptr_set(EM_BLE_ENC_PLAIN_OFFSET);
+    ll_starting = 1;
+    ble_aescntl_set(BLE_AES_START_BIT);
+}
+
+void ll_request(const uint8_t *key, const uint8_t *plain, uint32_t tag)
+{
+    struct ke_msg *msg = calloc(1, sizeof(struct ke_msg) + sizeof(struct llm_enc_req));
+    struct llm_enc_req *req = ke_msg2param(msg);
+
+    memcpy(req->key, key, 16);
+    memcpy(req->plain_data, plain, 16);
+    // Blocks of the queue completed while the request waits
+    req->tag = tag;
+    msg->saved = engine_stats.queue_blocks;
+    co_list_push_back(&llm_le_env.enc_req, &msg->hdr);
+    if (!llm_le_env.enc_pend)
+    {
+        llm_le_env.enc_pend = true;
+        llm_encryption_start(req);
+    }
+}
+
+void llm_encryption_done_func(void)
+{
+    struct ke_msg *msg = (struct ke_msg *) co_list_pop_front(&llm_le_env.enc_req);
+    struct llm_enc_req *req = ke_msg2param(msg);
+    struct ll_result *res = &ll_results[ll_result_cnt++ % LL_RESULTS_MAX];
+
+    res->tag = req->tag;
+    em_rd(res->cipher, EM_BLE_ENC_CIPHER_OFFSET, 16);
+    res->wait = engine_stats.queue_blocks - msg->saved;
+    if (res->wait > engine_stats.ll_wait_max)
+    {
+        engine_stats.ll_wait_max = res->wait;
+    }
+    free(msg);
+
+    if (co_list_is_empty(&llm_le_env.enc_req))
+    {
+        llm_le_env.enc_pend = false;
+    }
+    else
+    {
+        llm_encryption_start(ke_msg2param((struct ke_msg *) co_list_pick(&llm_le_env.enc_req)));
+    }
+}
+
+/* End of encryption: the engine writes the cipher and raises the interrupt, served by the
+   jump table entry */
+int engine_complete(void)
+{
+    uint8_t key[16], plain[16];
+    int ll_pending;
+
+    if (!engine_busy)
+    {
+        return 0;
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        PUTU32(&key[i * 4], aes_key[i]);
+    }
+    for (int i = 0; i < 16; i++)
+    {
+        plain[i] = em_mem[aes_ptr + 15 - i];
+    }
+    ref_encrypt(key, plain, &em_mem[EM_BLE_ENC_CIPHER_OFFSET]);
+    engine_busy = 0;
+    if (engine_owner == 'Q')
+    {
+        engine_stats.queue_blocks++;
+    }
+    else
+    {
+        engine_stats.ll_blocks++;
+    }
+
+    // A link layer request waiting at the end of a block of the queue goes next
+    ll_pending = (engine_owner == 'Q') && !co_list_is_empty(&llm_le_env.enc_req);
+    expect_ll = ll_pending;
+
+    aes_queue_encryption_done_func();
+
+    if (!engine_busy && (!co_list_is_empty(&llm_le_env.enc_req) || !aes_queue_is_idle()))
+    {
+        engine_stats.stalls++;
+    }
+    return 1;
+}
+
+int engine_is_busy(void)
+{
+    return engine_busy;
+}
+
+#else
+
+/* Benchmark of the software backend: ns per job */
+double bench(int mode, int len, int iters)
+{
+    static uint8_t buf[4096], mic[16], adata[16];
+    static const uint8_t key[16] = {1, 2, 3};
+    uint8_t iv[16] = {0};
+    uint16_t sg_len = len;
+    struct timespec t0, t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < iters; i++)
+    {
+        job_submit(0, mode, 1, key, iv, 13, 4, adata, mode == 3 ? 16 : 0, mic, buf, buf, &sg_len, 1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / iters;
+}
+
+#endif
+"""
+
+H = bytes.fromhex
+
+# NIST SP 800-38A, F.1.1, F.2.1 and F.5.1
+SP800_38A_KEY = H("2b7e151628aed2a6abf7158809cf4f3c")
+SP800_38A_PLAIN = H("6bc1bee22e409f96e93d7e117393172a" "ae2d8a571e03ac9c9eb76fac45af8e51"
+                    "30c81c46a35ce411e5fbc1191a0a52ef" "f69f2445df4f9b17ad2b417be66c3710")
+NIST = [
+    ("SP 800-38A F.1.1 ECB-AES128", ECB, SP800_38A_KEY, bytes(16),
+     H("3ad77bb40d7a3660a89ecaf32466ef97" "f5d3d58503b9699de785895a96fdbaaf"
+       "43b1cd7f598ece23881b00e3ed030688" "7b0c785e27e8ad3f8223207104725dd4")),
+    ("SP 800-38A F.2.1 CBC-AES128", CBC, SP800_38A_KEY, H("000102030405060708090a0b0c0d0e0f"),
+     H("7649abac8119b246cee98e9b12e9197d" "5086cb9b507219ee95db113a917678b2"
+       "73bed6b8e3c1743b7116e69e22229516" "3ff1caa1681fac09120eca307586e1a7")),
+    ("SP 800-38A F.5.1 CTR-AES128", CTR, SP800_38A_KEY, H("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff"),
+     H("874d6191b620e3261bef6864990db6ce" "9806f66b7970fdff8617187bb9fffdff"
+       "5ae4df3edbd5d35e5b4f09020db03eab" "1e031dda2fbe03d1792170a0f3009cee")),
+]
+
+# NIST SP 800-38C, C.1 to C.3: nonce, associated data, payload, ciphertext and tag
+CCM_KEY = H("404142434445464748494a4b4c4d4e4f")
+NIST_CCM = [
+    ("SP 800-38C C.1", H("10111213141516"), H("0001020304050607"), H("20212223"), H("7162015b"), H("4dac255d")),
+    ("SP 800-38C C.2", H("1011121314151617"), H("000102030405060708090a0b0c0d0e0f"),
+     H("202122232425262728292a2b2c2d2e2f"), H("d2a1f0e051ea5f62081a7792073d593d"), H("1fc64fbfaccd")),
+    ("SP 800-38C C.3", H("101112131415161718191a1b"), H("000102030405060708090a0b0c0d0e0f10111213"),
+     H("202122232425262728292a2b2c2d2e2f3031323334353637"), H("e3b201a9f5b71a7a9b1ceaeccd97e70b6176aad9a4428aa5"),
+     H("484392fbc1b09951")),
+]
+
+
+def build(tmp, sw):
+    name = "aes_queue_sw" if sw else "aes_queue_engine"
+    defines = {"CFG_AES_QUEUE": None, "AES_QUEUE_SW_BACKEND": None} if sw else {"CFG_AES_QUEUE": None}
+    lib = host_c.compile_lib(tmp, name, sources=["sw_aes.c"], includes=[COMMON], defines=defines)
+    if sw:
+        lib.bench.restype = ctypes.c_double
+    return lib
+
+
+def build_all():
+    # Copied next to the stubs, so that they are included in place of the SDK headers
+    tmp = host_c.stage("aes_queue_test", HARNESS, stubs=STUBS,
+                       copies=[os.path.join(CRYPTO, name) for name in ("aes_queue.c", "aes_queue.h", "sw_aes.c",
+                                                                      "sw_aes.h")])
+    return build(tmp, True), build(tmp, False)
+
+
+class Ref:
+    """Modes of operation on the sw_aes block cipher."""
+
+    def __init__(self, lib):
+        self.lib = lib
+
+    def enc(self, key, blk):
+        out = ctypes.create_string_buffer(16)
+        self.lib.ref_encrypt(key, blk, out)
+        return out.raw
+
+    @staticmethod
+    def inc(ctr):
+        return ((int.from_bytes(ctr, "big") + 1) % (1 << 128)).to_bytes(16, "big")
+
+    def run(self, mode, enc_dec, key, iv, data, nonce_len=0, mic_len=0, adata=b""):
+        """Output, updated IV and MIC (CCM) of a job."""
+        out = b""
+        if mode == ECB:
+            out = b"".join(self.enc(key, data[i:i + 16]) for i in range(0, len(data), 16))
+        elif mode == CBC:
+            for i in range(0, len(data), 16):
+                iv = self.enc(key, bytes(a ^ b for a, b in zip(data[i:i + 16], iv)))
+                out += iv
+        elif mode == CTR:
+            for i in range(0, len(data), 16):
+                ks = self.enc(key, iv)
+                out += bytes(a ^ b for a, b in zip(data[i:i + 16], ks))
+                iv = self.inc(iv)
+        else:
+            return self.ccm(enc_dec, key, iv, data, nonce_len, mic_len, adata)
+        return out, iv, None
+
+    def ccm(self, enc_dec, key, iv, data, nonce_len, mic_len, adata):
+        nonce = iv[:nonce_len]
+        q = 15 - nonce_len
+        a = bytes([q - 1]) + nonce
+        ks = b""
+        for i in range((len(data) + 15) // 16):
+            ks += self.enc(key, a + (i + 1).to_bytes(q, "big"))
+        out = bytes(x ^ y for x, y in zip(data, ks))
+        plain = data if enc_dec == AES_ENCRYPT else out
+        b0 = bytes([(0x40 if adata else 0) | (((mic_len - 2) // 2) << 3) | (q - 1)]) + nonce + len(plain).to_bytes(q, "big")
+        blocks = b0
+        if adata:
+            ad = len(adata).to_bytes(2, "big") + adata
+            blocks += ad + bytes(-len(ad) % 16)
+        blocks += plain + bytes(-len(plain) % 16)
+        x = bytes(16)
+        for i in range(0, len(blocks), 16):
+            x = self.enc(key, bytes(p ^ r for p, r in zip(blocks[i:i + 16], x)))
+        s0 = self.enc(key, a + bytes(q))
+        return out, iv, bytes(p ^ r for p, r in zip(x[:mic_len], s0))
+
+
+class Job:
+    """A job submitted to the library, its buffers kept alive until checked."""
+
+    def __init__(self, lib, slot, mode, enc_dec, key, iv, data, sg, nonce_len=0, mic_len=0, adata=b"", mic=b""):
+        self.lib, self.slot = lib, slot
+        self.args = (mode, enc_dec, key, iv, data, nonce_len, mic_len, adata)
+        self.key = ctypes.create_string_buffer(key, 16)
+        self.iv = ctypes.create_string_buffer(iv, 16)
+        self.adata = ctypes.create_string_buffer(adata, max(len(adata), 1))
+        self.mic = ctypes.create_string_buffer(mic, 16)
+        self.inp = ctypes.create_string_buffer(data, max(len(data), 1))
+        self.out = ctypes.create_string_buffer(max(len(data), 1))
+        self.sg = (ctypes.c_uint16 * 8)(*sg)
+        self.ret = lib.job_submit(slot, mode, enc_dec, self.key, self.iv, nonce_len, mic_len, self.adata, len(adata),
+                                  self.mic, self.inp, self.out, self.sg, len(sg))
+
+    def result(self):
+        iv = ctypes.create_string_buffer(16)
+        state = self.lib.job_state(self.slot, iv)
+        return state // 1000, state % 1000 // 100, self.out.raw[:len(self.args[4])], iv.raw, self.mic.raw
+
+
+def split(rnd, n):
+    cuts = sorted(rnd.randint(0, n) for _ in range(rnd.randint(0, 7)))
+    return [b - a for a, b in zip([0] + cuts, cuts + [n])]
+
+
+def check_nist(lib, ref, name):
+    failures = []
+    for what, mode, key, iv, cipher in NIST:
+        job = Job(lib, 0, mode, AES_ENCRYPT, key, iv, SP800_38A_PLAIN, [16, 20, 0, 28])
+        while name == "engine" and lib.engine_complete():
+            pass
+        done, status, out, _, _ = job.result()
+        if (done, status, out) != (1, ERR_NO_ERR, cipher):
+            failures.append("%s: %s" % (name, what))
+        if mode == CTR:
+            job = Job(lib, 0, mode, AES_DECRYPT, key, iv, cipher, [64])
+            while name == "engine" and lib.engine_complete():
+                pass
+            if job.result()[2] != SP800_38A_PLAIN:
+                failures.append("%s: %s decryption" % (name, what))
+    for what, nonce, adata, plain, cipher, tag in NIST_CCM:
+        iv = nonce + bytes(16 - len(nonce))
+        job = Job(lib, 0, CCM, AES_ENCRYPT, CCM_KEY, iv, plain, [len(plain)], len(nonce), len(tag), adata)
+        while name == "engine" and lib.engine_complete():
+            pass
+        done, status, out, _, mic = job.result()
+        if (done, status, out, mic[:len(tag)]) != (1, ERR_NO_ERR, cipher, tag):
+            failures.append("%s: %s" % (name, what))
+        job = Job(lib, 0, CCM, AES_DECRYPT, CCM_KEY, iv, cipher, [len(cipher)], len(nonce), len(tag), adata, tag)
+        while name == "engine" and lib.engine_complete():
+            pass
+        done, status, out, _, _ = job.result()
+        if (done, status, out) != (1, ERR_NO_ERR, plain):
+            failures.append("%s: %s decryption" % (name, what))
+    if ref.run(CCM, AES_ENCRYPT, CCM_KEY, NIST_CCM[0][1] + bytes(9), NIST_CCM[0][3], 7, 4, NIST_CCM[0][2])[2] != NIST_CCM[0][5]:
+        failures.append("reference CCM")
+    return failures
+
+
+def random_job(rnd, lib, ref, slot):
+    mode = rnd.choice((ECB, CBC, CTR, CCM))
+    key = rnd.randbytes(16)
+    iv = rnd.randbytes(16)
+    if mode in (ECB, CBC):
+        n = 16 * rnd.randint(0, 12)
+        enc_dec = AES_ENCRYPT
+    else:
+        n = rnd.choice((0, 1, 15, 16, 17, rnd.randint(0, 200)))
+        enc_dec = rnd.choice((AES_ENCRYPT, AES_DECRYPT))
+    data = rnd.randbytes(n)
+    if mode != CCM:
+        return Job(lib, slot, mode, enc_dec, key, iv, data, split(rnd, n)), None
+    nonce_len = rnd.randint(7, 13)
+    mic_len = rnd.choice((4, 6, 8, 10, 12, 14, 16))
+    adata = rnd.randbytes(rnd.choice((0, 1, 14, 15, 30, 300, rnd.randint(0, 60))))
+    mic = b""
+    bad = False
+    if enc_dec == AES_DECRYPT:
+        # Decrypt a valid message, or one with a wrong MIC
+        plain = data
+        data, _, mic = ref.run(CCM, AES_ENCRYPT, key, iv, plain, nonce_len, mic_len, adata)
+        bad = rnd.random() < 0.2
+        if bad:
+            mic = bytes([mic[0] ^ 1]) + mic[1:]
+    return Job(lib, slot, CCM, enc_dec, key, iv, data, split(rnd, n), nonce_len, mic_len, adata, mic), bad
+
+
+def check_job(job, bad, ref):
+    mode, enc_dec, key, iv, data, nonce_len, mic_len, adata = job.args
+    done, status, out, iv_out, mic = job.result()
+    exp_out, exp_iv, exp_mic = ref.run(mode, enc_dec, key, iv, data, nonce_len, mic_len, adata)
+    if done != 1:
+        return "%d callbacks" % done
+    if status != (ERR_MIC if bad else ERR_NO_ERR):
+        return "status %d" % status
+    if out != exp_out:
+        return "wrong output"
+    if mode in (CBC, CTR) and iv_out != exp_iv:
+        return "wrong chained IV"
+    if mode == CCM and enc_dec == AES_ENCRYPT and mic[:mic_len] != exp_mic:
+        return "wrong MIC"
+    return None
+
+
+def interleave(lib, ref, args):
+    """Random jobs, link layer requests and engine completions on the engine build."""
+    rnd = random.Random(args.seed)
+    failures = []
+    pending = {}
+    order = []
+    ll_sent = {}
+    slots = list(range(64))
+    checked = 0
+    while checked < args.jobs or pending:
+        r = rnd.random()
+        if r < 0.25 and slots and len(order) < args.jobs:
+            slot = slots.pop(rnd.randrange(len(slots)))
+            job, bad = random_job(rnd, lib, ref, slot)
+            if job.ret != ERR_NO_ERR:
+                failures.append("job %d rejected" % len(order))
+                slots.append(slot)
+                continue
+            pending[slot] = (job, bad, len(order))
+            order.append(slot)
+        elif r < 0.28:
+            key, plain = rnd.randbytes(16), rnd.randbytes(16)
+            tag = len(ll_sent)
+            ll_sent[tag] = ref.enc(key, plain)
+            lib.ll_request(key, plain, tag)
+        elif not lib.engine_complete() and not lib.engine_is_busy() and not lib.queue_idle():
+            failures.append("queue stalled with the engine idle")
+            break
+        for slot in [s for s, (job, _, _) in pending.items() if job.result()[0]]:
+            job, bad, seq = pending.pop(slot)
+            err = check_job(job, bad, ref)
+            if err:
+                failures.append("job %d (mode %d, %d bytes): %s" % (seq, job.args[0], len(job.args[4]), err))
+            checked += 1
+            slots.append(slot)
+        if len(failures) > 10:
+            break
+    while lib.engine_complete():
+        pass
+
+    stats = EngineStats.in_dll(lib, "engine_stats")
+    results = (LlResult * 4096).in_dll(lib, "ll_results")
+    count = ctypes.c_int.in_dll(lib, "ll_result_cnt").value
+    if count != len(ll_sent):
+        failures.append("%d of %d link layer encryptions completed" % (count, len(ll_sent)))
+    for i in range(min(count, 4096)):
+        if bytes(results[i].cipher) != ll_sent[results[i].tag]:
+            failures.append("link layer encryption %d: wrong result" % results[i].tag)
+            break
+    if [s for s in order if lib.job_order(s) < 0]:
+        failures.append("jobs never completed")
+    if stats.collisions:
+        failures.append("engine started %d times while busy" % stats.collisions)
+    if stats.ll_skipped:
+        failures.append("%d blocks of the queue started before a waiting link layer request" % stats.ll_skipped)
+    if stats.ll_wait_max > 1:
+        failures.append("a link layer encryption waited for %d blocks of the queue" % stats.ll_wait_max)
+    if stats.stalls:
+        failures.append("engine left idle %d times with work pending" % stats.stalls)
+    print("engine: %d jobs, %d queue blocks (%.1f per job callback), %d link layer encryptions, "
+          "longest link layer wait %d block of the queue" % (checked, stats.queue_blocks, stats.queue_blocks / max(checked, 1),
+                                                 stats.ll_blocks, stats.ll_wait_max))
+    return failures
+
+
+def param_check(lib):
+    """Invalid jobs are rejected without a callback."""
+    failures = []
+    key, iv = bytes(16), bytes(16)
+    for what, args in (("ECB length not a multiple of 16", (ECB, AES_ENCRYPT, 20, 0, 0)),
+                       ("CBC decryption", (CBC, AES_DECRYPT, 32, 0, 0)),
+                       ("unknown mode", (7, AES_ENCRYPT, 16, 0, 0)),
+                       ("CCM nonce of 6 bytes", (CCM, AES_ENCRYPT, 16, 6, 8)),
+                       ("CCM nonce of 14 bytes", (CCM, AES_ENCRYPT, 16, 14, 8)),
+                       ("CCM MIC of 2 bytes", (CCM, AES_ENCRYPT, 16, 13, 2)),
+                       ("CCM MIC of 5 bytes", (CCM, AES_ENCRYPT, 16, 13, 5)),
+                       ("CCM MIC of 18 bytes", (CCM, AES_ENCRYPT, 16, 13, 18))):
+        mode, enc_dec, n, nonce_len, mic_len = args
+        job = Job(lib, 0, mode, enc_dec, key, iv, bytes(n), [n], nonce_len, mic_len)
+        while lib.engine_complete():
+            pass
+        if job.ret != ERR_INVALID_PARAM or job.result()[0]:
+            failures.append("%s accepted" % what)
+    return failures
+
+
+def order_check(lib, ref):
+    """Callbacks follow the submission order."""
+    jobs = [Job(lib, i, CTR, AES_ENCRYPT, bytes(16), bytes(16), bytes(40 * (4 - i)), [40 * (4 - i)]) for i in range(4)]
+    while lib.engine_complete():
+        pass
+    if [lib.job_order(j.slot) for j in jobs] != sorted(lib.job_order(j.slot) for j in jobs):
+        return ["callbacks out of submission order"]
+    return []
+
+
+def benchmark(lib):
+    print("software backend, per job:")
+    for name, mode in (("ECB", ECB), ("CBC", CBC), ("CTR", CTR), ("CCM", CCM)):
+        line = []
+        for n in (16, 256, 2048):
+            iters = max(20000 // n, 50) * 10
+            ns = lib.bench(mode, n, iters)
+            line.append("%5d bytes %7.2fus %6.1f MB/s" % (n, ns / 1e3, n / ns * 1e3))
+        print("  %s  %s" % (name, " | ".join(line)))
+
+
+class EngineStats(ctypes.Structure):
+    _fields_ = [(n, ctypes.c_uint32) for n in ("queue_blocks", "ll_blocks", "collisions", "ll_skipped", "stalls",
+                                                "ll_wait_max")]
+
+
+class LlResult(ctypes.Structure):
+    _fields_ = [("tag", ctypes.c_uint32), ("cipher", ctypes.c_uint8 * 16), ("wait", ctypes.c_uint32)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--jobs", type=int, default=3000, help="random jobs on the engine build")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--no-bench", action="store_true")
+    args = parser.parse_args()
+
+    sw, engine = build_all()
+    ref = Ref(sw)
+    failures = check_nist(sw, ref, "software") + check_nist(engine, ref, "engine")
+    failures += param_check(engine)
+    failures += order_check(engine, ref)
+    failures += interleave(engine, ref, args)
+    if not args.no_bench:
+        benchmark(sw)
+
+    return host_c.report(failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,676 @@
+#!/usr/bin/env python3
+"""
+Replay of ANCS traffic through the notification queue and application cache of the ANCS
+client example.
+
+user_ancs_client.c is built unmodified against stub headers and driven through its
+ANCS callbacks by a phone model. The phone keeps the notifications and the application
+display names, answers the attribute requests of the client and sends the Notification
+Source events of the trace, also while a request is outstanding.
+
+A Python model of the client predicts the attribute requests and the console output:
+the 8-entry UID ring that coalesces the events of a queued notification and drops the
+oldest one when full, and the 6-entry application cache with LRU eviction that never
+evicts the application of the notification being fetched. The requests and the output
+of the C code must match the model exactly, at most one request may be outstanding, and
+the build is linked with -z defs so any heap call fails it.
+
+By default a trace is generated: applications with a skewed popularity, bursts of new
+notifications such as the pre-existing ones sent on connection, conversation updates,
+removals, failed requests and disconnections. --save writes it, --trace replays a saved
+or recorded one. A trace is one JSON object per line:
+
+    {"ev": "added", "uid": 7, "cat": 4, "flags": 0, "app": "com.apple.MobileSMS",
+     "title": "...", "msg": "...", "date": "20200101T120000"}
+    {"ev": "modified", "uid": 7, "title": "...", "msg": "..."}
+    {"ev": "removed", "uid": 7}
+    {"ev": "name", "app": "com.apple.MobileSMS", "name": "Messages"}
+    {"ev": "answer"}        the phone answers the outstanding request
+    {"ev": "fail"}          the phone answers it with an error
+    {"ev": "late", "app": "com.apple.MobileSMS"}
+                            application attributes arriving after their request failed
+    {"ev": "disconnect"}
+
+    ancs_replay_test.py
+    ancs_replay_test.py --events 200000 --seed 3 --save trace.jsonl
+    ancs_replay_test.py --trace trace.jsonl
+"""
+
+import argparse
+import ctypes
+import json
+import os
+import random
+import sys
+
+import host_c
+
+EXAMPLE = os.path.join(host_c.SDK, "projects", "target_apps", "misc", "ancs_client", "src")
+
+STUBS = {
+    "rwip_config.h": """
+#ifndef RWIP_CONFIG_H_
+#define RWIP_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#define BLE_CLIENT_PRF              1
+#define BLE_SERVER_PRF              0
+#define BLE_ANC_CLIENT              1
+#define BLE_ANC_SERVER              0
+#define CFG_VERBOSE_LOG             0
+#define __SECTION_ZERO(sec)
+#define __ARRAY_EMPTY
+#endif
+""",
+    "ke_msg.h": """
+#ifndef KE_MSG_H_
+#define KE_MSG_H_
+typedef uint16_t ke_msg_id_t;
+typedef uint16_t ke_task_id_t;
+#endif
+""",
+    "attm.h": """
+#ifndef ATTM_H_
+#define ATTM_H_
+#define ATT_UUID_128_LEN            16
+#define ATT_INVALID_HANDLE          0x0000
+#define ATT_ERR_NO_ERROR            0x00
+#define ATT_ERR_INSUFF_AUTHEN       0x05
+#endif
+""",
+    "app.h": """
+#ifndef APP_H_
+#define APP_H_
+#include "rwip_config.h"
+#include "ke_msg.h"
+#include "anc_common.h"
+#define GAP_INVALID_CONIDX          0xFF
+#define GAP_ERR_NO_ERROR            0x00
+#define KEY_LEN                     16
+#define TASK_ID_ANCC                1
+#define TASK_ID_GATT_CLIENT         2
+#define GATTC_EVENT_REQ_IND         0x0C16
+#define GATTC_EVENT_CFM             0x0C17
+#define GAPC_PARAM_UPDATED_IND      0x0E0F
+#define GPIO1_IRQn                  1
+enum { GAP_TK_OOB, GAP_TK_DISPLAY, GAP_TK_KEY_ENTRY, GAP_TK_KEY_CONFIRM };
+typedef uint8_t timer_hnd;
+#define EASY_TIMER_INVALID_TIMER    0
+#define MS_TO_TIMERUNITS(x)         ((x) / 10)
+struct app_env_tag { uint8_t conidx; };
+extern struct app_env_tag app_env[1];
+struct connection_param_configuration { uint16_t intv_min, intv_max, latency, time_out; };
+static const struct connection_param_configuration user_connection_param_conf = {8, 16, 0, 500};
+struct gapc_connection_req_ind { uint16_t con_interval, con_latency, sup_to; };
+struct gapc_disconnect_ind { uint8_t reason; };
+struct gapc_param_updated_ind { uint16_t con_interval, con_latency, sup_to; };
+struct gapc_bond_req_ind { struct { uint8_t tk_type; } data; struct { uint8_t key[KEY_LEN]; } tk; };
+struct gattc_event_ind { uint16_t handle; };
+struct gattc_event_cfm { uint16_t handle; };
+struct ancc_content { struct prf_svc svc; };
+struct gatt_client_content { struct prf_svc svc; };
+#define KE_MSG_ALLOC(id, dest, src, type)   ((struct type *)host_msg_alloc(sizeof(struct type)))
+void *host_msg_alloc(size_t size);
+void ke_msg_send(void const *param);
+void arch_printf(const char *fmt, ...);
+timer_hnd app_easy_timer(uint32_t delay, void (*fn)(void));
+void app_easy_timer_cancel(timer_hnd timer);
+void app_easy_gap_param_update_start(uint8_t conidx);
+void app_easy_gap_disconnect(uint8_t conidx);
+void app_easy_security_request(uint8_t conidx);
+void app_easy_security_bdb_init(void);
+void app_easy_security_tk_exch(uint8_t conidx, uint8_t *key, uint8_t length, bool accept);
+uint32_t app_sec_gen_tk(void);
+void default_app_on_init(void);
+void default_app_on_connection(uint8_t conidx, struct gapc_connection_req_ind const *param);
+void default_app_on_disconnect(struct gapc_disconnect_ind const *param);
+void default_app_on_pairing_succeeded(uint8_t conidx);
+void prf_reset_func(uint16_t task_id, uint8_t conidx);
+void GPIO_ResetIRQ(int irq);
+void GPIO_RegisterCallback(int irq, void (*fn)(void));
+void GPIO_EnableIRQ(int port, int pin, int irq, bool low, bool release, uint8_t debounce);
+void NVIC_DisableIRQ(int irq);
+#define GPIO_PORT_1                 1
+#define GPIO_PIN_1                  1
+void app_ancc_enable(uint8_t conidx);
+void app_ancc_wr_cfg_ntf_src(uint8_t conidx, bool enable);
+void app_ancc_wr_cfg_data_src(uint8_t conidx, bool enable);
+void app_ancc_get_ntf_atts(uint8_t conidx, uint32_t uid, uint8_t atts, uint16_t title_len,
+                           uint16_t sub_len, uint16_t msg_len);
+void app_ancc_get_app_atts(uint8_t conidx, uint8_t atts, uint8_t *app_id);
+void app_ancc_ntf_action(uint8_t conidx, uint32_t uid, bool act_positive);
+void app_gattc_enable(uint8_t conidx);
+void app_gattc_write_ind_cfg(uint8_t conidx, bool enable);
+#endif
+""",
+}
+
+# Headers of the example that the stub app.h covers
+EMPTY = ("gap.h", "gapc_task.h", "app_task.h", "app_callback.h", "app_easy_timer.h", "co_bt.h",
+         "arch_console.h", "app_easy_security.h", "gpio.h")
+
+HARNESS = r"""
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "user_ancs_client.c"
+
+struct app_env_tag app_env[1];
+
+/* Requests of the client: kind 1 notification attributes, 2 application attributes */
+static uint8_t req_kind;
+static uint32_t req_uid;
+static uint8_t req_atts;
+static uint16_t req_lens[3];
+static char req_app_id[256];
+static unsigned long req_overlaps;
+
+static char log_buf[1 << 16];
+static size_t log_len;
+
+void app_ancc_get_ntf_atts(uint8_t conidx, uint32_t uid, uint8_t atts, uint16_t title_len,
+                           uint16_t sub_len, uint16_t msg_len)
+{
+    req_overlaps += (req_kind != 0);
+    req_kind = 1;
+    req_uid = uid;
+    req_atts = atts;
+    req_lens[0] = title_len;
+    req_lens[1] = sub_len;
+    req_lens[2] = msg_len;
+}
+
+void app_ancc_get_app_atts(uint8_t conidx, uint8_t atts, uint8_t *app_id)
+{
+    req_overlaps += (req_kind != 0);
+    req_kind = 2;
+    req_atts = atts;
+    snprintf(req_app_id, sizeof(req_app_id), "%s", (const char *)app_id);
+}
+
+int req_take(uint32_t *uid, uint8_t *atts, uint16_t *lens, char *app_id)
+{
+    int kind = req_kind;
+
+    *uid = req_uid;
+    *atts = req_atts;
+    memcpy(lens, req_lens, sizeof(req_lens));
+    strcpy(app_id, req_app_id);
+    req_kind = 0;
+    return kind;
+}
+
+unsigned long req_overlap_count(void)
+{
+    return req_overlaps;
+}
+
+void arch_printf(const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(log_buf + log_len, sizeof(log_buf) - log_len, fmt, ap);
+    va_end(ap);
+    if (n > 0)
+    {
+        log_len += n;
+        if (log_len >= sizeof(log_buf))
+        {
+            log_len = sizeof(log_buf) - 1;
+        }
+    }
+}
+
+size_t log_take(char *out, size_t size)
+{
+    size_t n = log_len < size ? log_len : size;
+
+    memcpy(out, log_buf, n);
+    log_len = 0;
+    return n;
+}
+
+void ntf_src(uint8_t event_id, uint8_t flags, uint8_t cat, uint8_t cnt, uint32_t uid)
+{
+    struct anc_ntf_src ntf = {event_id, flags, cat, cnt, uid};
+
+    user_on_ancc_ntf_src_ind_cb(0, &ntf);
+}
+
+void disconnect(void)
+{
+    struct gapc_disconnect_ind ind = {0x13};
+
+    req_kind = 0;
+    user_app_disconnect(&ind);
+}
+
+static unsigned char msg_buf[64];
+void *host_msg_alloc(size_t size) { return msg_buf; }
+void ke_msg_send(void const *param) {}
+timer_hnd app_easy_timer(uint32_t delay, void (*fn)(void)) { return 1; }
+void app_easy_timer_cancel(timer_hnd timer) {}
+void app_easy_gap_param_update_start(uint8_t conidx) {}
+void app_easy_gap_disconnect(uint8_t conidx) {}
+void app_easy_security_request(uint8_t conidx) {}
+void app_easy_security_bdb_init(void) {}
+void app_easy_security_tk_exch(uint8_t conidx, uint8_t *key, uint8_t length, bool accept) {}
+uint32_t app_sec_gen_tk(void) { return 0; }
+void default_app_on_init(void) {}
+void default_app_on_connection(uint8_t conidx, struct gapc_connection_req_ind const *param) {}
+void default_app_on_disconnect(struct gapc_disconnect_ind const *param) {}
+void default_app_on_pairing_succeeded(uint8_t conidx) {}
+void prf_reset_func(uint16_t task_id, uint8_t conidx) {}
+void GPIO_ResetIRQ(int irq) {}
+void GPIO_RegisterCallback(int irq, void (*fn)(void)) {}
+void GPIO_EnableIRQ(int port, int pin, int irq, bool low, bool release, uint8_t debounce) {}
+void NVIC_DisableIRQ(int irq) {}
+void app_ancc_enable(uint8_t conidx) {}
+void app_ancc_wr_cfg_ntf_src(uint8_t conidx, bool enable) {}
+void app_ancc_wr_cfg_data_src(uint8_t conidx, bool enable) {}
+void app_ancc_ntf_action(uint8_t conidx, uint32_t uid, bool act_positive) {}
+void app_gattc_enable(uint8_t conidx) {}
+void app_gattc_write_ind_cfg(uint8_t conidx, bool enable) {}
+"""
+
+EVT_ADDED, EVT_MODIFIED, EVT_REMOVED = 0, 1, 2
+ATT_APP_ID, ATT_TITLE, ATT_MSG, ATT_DATE = 0, 1, 3, 5
+ATT_APP_ID_PRESENT, ATT_TITLE_PRESENT, ATT_MSG_PRESENT, ATT_DATE_PRESENT = 0x01, 0x02, 0x08, 0x20
+APP_ATT_DISPLAY_NAME, APP_ATT_DISPLAY_NAME_PRESENT = 0, 0x01
+ERR_INVALID_PARAM = 0xA2
+ERR_UNLIKELY = 0x0E
+
+# Sizes of user_ancs_client.c
+ATTS_MAX_LEN, ATTS_MSG_MAX_LEN = 25, 75
+APP_CACHE_SIZE, APP_ID_MAX_LEN, NTF_QUEUE_SIZE = 6, 40, 8
+
+CATEGORIES = ("Other", "Incoming call", "Missed call", "Voicemail", "Social", "Schedule", "E-mail", "News",
+              "Health and Fitness", "Business and Finance", "Location", "Entertainment")
+
+
+def build():
+    lib = host_c.build("ancs_replay_test", HARNESS, stubs=STUBS, empty=EMPTY, empty_text="#include \"app.h\"\n",
+                       includes=[EXAMPLE, os.path.join(EXAMPLE, "config"), host_c.PROFILES,
+                                 os.path.join(host_c.PROFILES, "anc")])
+    lib.ntf_src.argtypes = [ctypes.c_uint8, ctypes.c_uint8, ctypes.c_uint8, ctypes.c_uint8, ctypes.c_uint32]
+    lib.req_take.argtypes = [ctypes.POINTER(ctypes.c_uint32), ctypes.POINTER(ctypes.c_uint8),
+                             ctypes.POINTER(ctypes.c_uint16), ctypes.c_char_p]
+    lib.req_overlap_count.restype = ctypes.c_ulong
+    lib.log_take.argtypes = [ctypes.c_char_p, ctypes.c_size_t]
+    lib.log_take.restype = ctypes.c_size_t
+    lib.user_on_ancc_ntf_att_ind_cb.argtypes = [ctypes.c_uint8, ctypes.c_uint32, ctypes.c_uint8, ctypes.c_char_p]
+    lib.user_on_ancc_app_att_ind_cb.argtypes = [ctypes.c_uint8, ctypes.c_uint8, ctypes.c_char_p, ctypes.c_char_p]
+    lib.user_on_ancc_get_ntf_att_cmp_cb.argtypes = [ctypes.c_uint8, ctypes.c_uint8]
+    lib.user_on_ancc_get_app_att_cmp_cb.argtypes = [ctypes.c_uint8, ctypes.c_uint8]
+    return lib
+
+
+class Client:
+    """Model of the notification queue and application cache of the client."""
+
+    def __init__(self):
+        self.stats_coalesced = 0
+        self.stats_dropped = 0
+        self.stats_unqueued = 0
+        self.disconnect()
+
+    def disconnect(self):
+        self.queue = []
+        self.pending = None
+        # Cache entries: [app_id, display name or None, last use]
+        self.apps = [None] * APP_CACHE_SIZE
+        self.use_cnt = 0
+        self.requests = []
+        self.log = []
+
+    def ntf_src(self, event_id, flags, cat, cnt, uid):
+        if event_id == EVT_REMOVED:
+            for i, ntf in enumerate(self.queue):
+                if ntf[4] == uid:
+                    del self.queue[i]
+                    self.stats_unqueued += 1
+                    break
+            return
+        for i, ntf in enumerate(self.queue):
+            if ntf[4] == uid:
+                # The first event is kept, the rest is updated
+                self.queue[i] = (ntf[0], flags, cat, cnt, uid)
+                self.stats_coalesced += 1
+                break
+        else:
+            if len(self.queue) == NTF_QUEUE_SIZE:
+                del self.queue[0]
+                self.stats_dropped += 1
+            self.queue.append((event_id, flags, cat, cnt, uid))
+        if self.pending is None:
+            self.fetch_next()
+
+    def fetch_next(self):
+        if not self.queue:
+            self.pending = None
+            return
+        ntf = self.queue.pop(0)
+        self.pending = {"cat": ntf[2], "uid": ntf[4], "app": None, "title": "", "date": "", "msg": ""}
+        self.requests.append(("ntf", ntf[4]))
+
+    def find(self, app_id):
+        for entry in self.apps:
+            if entry is not None and entry[0] == app_id:
+                self.use_cnt = (self.use_cnt + 1) & 0xFFFF
+                entry[2] = self.use_cnt
+                return entry
+        return None
+
+    def intern(self, app_id):
+        entry = self.find(app_id)
+        if entry is not None:
+            return entry
+        if len(app_id.encode()) >= APP_ID_MAX_LEN:
+            return None
+        slot = None
+        for i, entry in enumerate(self.apps):
+            if entry is None:
+                slot = i
+                break
+            if self.pending is not None and self.pending["app"] is entry:
+                continue
+            if slot is None or ((self.use_cnt - entry[2]) & 0xFFFF) > ((self.use_cnt - self.apps[slot][2]) & 0xFFFF):
+                slot = i
+        if slot is None:
+            return None
+        self.use_cnt = (self.use_cnt + 1) & 0xFFFF
+        self.apps[slot] = [app_id, None, self.use_cnt]
+        return self.apps[slot]
+
+    def ntf_att(self, att_id, val):
+        if self.pending is None:
+            return
+        if att_id == ATT_TITLE:
+            self.pending["title"] = val[:ATTS_MAX_LEN]
+        elif att_id == ATT_DATE:
+            self.pending["date"] = val[:ATTS_MAX_LEN]
+        elif att_id == ATT_MSG:
+            self.pending["msg"] = val[:ATTS_MSG_MAX_LEN]
+        elif att_id == ATT_APP_ID:
+            self.pending["app"] = self.intern(val)
+
+    def ntf_cmp(self, status):
+        if self.pending is None:
+            return
+        if status:
+            self.fetch_next()
+            return
+        app = self.pending["app"]
+        if app is not None and app[1] is None:
+            self.requests.append(("app", app[0]))
+            return
+        self.print_pending()
+
+    def app_att(self, att_id, app_id, name):
+        app = self.intern(app_id)
+        if app is not None and att_id == APP_ATT_DISPLAY_NAME:
+            app[1] = name[:ATTS_MAX_LEN]
+
+    def app_cmp(self, status):
+        if self.pending is not None:
+            self.print_pending()
+
+    def print_pending(self):
+        p = self.pending
+        app = p["app"]
+        name = app[1] if app is not None and app[1] is not None else "<unknown>"
+        cat = CATEGORIES[p["cat"]] if p["cat"] < len(CATEGORIES) else "<unknown>"
+        self.log.append("Notification from %s (%s)\r\n\tCategory: %s\r\n\t    Date: %s\r\n\t   Title: %s\r\n"
+                        "\t Message: %s\r\n\n" % (name, app[0] if app is not None else "<unknown>", cat,
+                                                   p["date"], p["title"], p["msg"]))
+        self.fetch_next()
+
+
+def generate(rnd, events):
+    """Traffic of a phone: a few busy applications, bursts, conversation updates."""
+    apps = ["com.apple.MobileSMS", "com.apple.mobilemail", "net.whatsapp.WhatsApp", "com.apple.mobilecal",
+            "com.apple.mobilephone", "com.facebook.Messenger", "com.slack.Slack", "com.apple.news",
+            "com.apple.reminders", "com.spotify.client", "com.apple.Health", "com.example.weather",
+            "com.example.an.application.with.a.very.long.identifier", "", "com.example.nameless",
+            "com.example.limit".ljust(APP_ID_MAX_LEN - 1, "x"), "com.example.limit".ljust(APP_ID_MAX_LEN, "x")]
+    weights = [40, 25, 20, 8, 8, 5, 5, 3, 2, 2, 1, 1, 1, 1, 1, 1, 1]
+    trace = []
+    for app in apps:
+        if app != "com.example.nameless":
+            name = "A display name longer than the buffer" if "long" in app else app.split(".")[-1]
+            trace.append({"ev": "name", "app": app, "name": name})
+    live = []
+    uid = 0
+    while len(trace) < events:
+        r = rnd.random()
+        if r < 0.005:
+            # Pre-existing notifications sent when the data source is subscribed
+            trace.append({"ev": "disconnect"})
+            burst = rnd.randint(1, 3 * NTF_QUEUE_SIZE)
+        elif r < 0.02:
+            burst = rnd.randint(2, 12)
+        else:
+            burst = 0
+        for _ in range(burst):
+            uid += 1
+            live.append(uid)
+            trace.append(added(rnd, uid, rnd.choices(apps, weights)[0]))
+        r = rnd.random()
+        if r < 0.2 or not live:
+            uid += 1
+            live.append(uid)
+            trace.append(added(rnd, uid, rnd.choices(apps, weights)[0]))
+        elif r < 0.35:
+            # Conversation update, usually a recent one
+            target = live[-1 - min(int(rnd.expovariate(0.5)), len(live) - 1)]
+            trace.append({"ev": "modified", "uid": target, "title": text(rnd, 30), "msg": text(rnd, 90)})
+        elif r < 0.45:
+            target = live.pop(rnd.randrange(len(live)))
+            trace.append({"ev": "removed", "uid": target})
+        elif r < 0.97:
+            trace.append({"ev": "answer"})
+        elif r < 0.985:
+            # Attributes of applications arriving after their request failed
+            for app in rnd.sample(apps, rnd.randint(1, APP_CACHE_SIZE + 1)):
+                trace.append({"ev": "late", "app": app})
+        elif r < 0.986:
+            app = rnd.choice(apps)
+            trace.append({"ev": "name", "app": app, "name": text(rnd, 30)})
+        else:
+            trace.append({"ev": "fail"})
+        if len(live) > 64:
+            del live[0]
+    return trace
+
+
+def added(rnd, uid, app):
+    return {"ev": "added", "uid": uid, "cat": rnd.randrange(len(CATEGORIES) + 1), "flags": rnd.randrange(32),
+            "app": app, "title": text(rnd, 30), "msg": text(rnd, 90),
+            "date": "2020%02d%02dT%02d%02d%02d" % (rnd.randint(1, 12), rnd.randint(1, 28), rnd.randrange(24),
+                                                  rnd.randrange(60), rnd.randrange(60))}
+
+
+def text(rnd, longest):
+    words = ("call", "me", "lunch", "at", "noon", "meeting", "moved", "ok", "see", "you", "soon", "build",
+             "passed", "review", "done", "thanks")
+    s = ""
+    while len(s) < rnd.randrange(longest + 1):
+        s += rnd.choice(words) + " "
+    return s.strip()
+
+
+class Replay:
+    def __init__(self, lib):
+        self.lib = lib
+        self.client = Client()
+        self.phone = {}
+        self.cat_cnt = {}
+        self.names = {}
+        self.outstanding = None
+        self.failures = []
+        self.log_buf = ctypes.create_string_buffer(1 << 16)
+        self.stats = {"events": 0, "shown": 0, "ntf_requests": 0, "app_requests": 0, "failed": 0}
+        self.lib.disconnect()
+        self.take_log()
+
+    def fail(self, what):
+        self.failures.append(what)
+
+    def take_log(self):
+        n = self.lib.log_take(self.log_buf, len(self.log_buf))
+        return ctypes.string_at(self.log_buf, n).decode("latin-1")
+
+    def check(self, where):
+        uid = ctypes.c_uint32()
+        atts = ctypes.c_uint8()
+        lens = (ctypes.c_uint16 * 3)()
+        app_id = ctypes.create_string_buffer(256)
+        kind = self.lib.req_take(ctypes.byref(uid), ctypes.byref(atts), lens, app_id)
+        expected = self.client.requests
+        self.client.requests = []
+        got = []
+        if kind == 1:
+            got = [("ntf", uid.value)]
+            if atts.value != ATT_APP_ID_PRESENT | ATT_DATE_PRESENT | ATT_TITLE_PRESENT | ATT_MSG_PRESENT:
+                self.fail("%s: attributes 0x%02x requested" % (where, atts.value))
+            self.outstanding = ("ntf", uid.value, lens[0], lens[2])
+            self.stats["ntf_requests"] += 1
+        elif kind == 2:
+            got = [("app", app_id.value.decode())]
+            if atts.value != APP_ATT_DISPLAY_NAME_PRESENT:
+                self.fail("%s: application attributes 0x%02x requested" % (where, atts.value))
+            self.outstanding = got[0]
+            self.stats["app_requests"] += 1
+        if got != expected:
+            self.fail("%s: requests %s, expected %s" % (where, got, expected))
+        log = self.take_log()
+        if log != "".join(self.client.log):
+            self.fail("%s: output %r, expected %r" % (where, log, "".join(self.client.log)))
+        self.stats["shown"] += "".join(self.client.log).count("Notification from")
+        self.client.log = []
+
+    def src(self, event_id, uid, cat, flags=0):
+        cnt = self.cat_cnt.get(cat, 0) & 0xFF
+        self.lib.ntf_src(event_id, flags, cat, cnt, uid)
+        self.client.ntf_src(event_id, flags, cat, cnt, uid)
+
+    def answer(self, error=0):
+        req = self.outstanding
+        self.outstanding = None
+        if req[0] == "ntf":
+            ntf = self.phone.get(req[1])
+            status = error or (0 if ntf is not None else ERR_INVALID_PARAM)
+            if not status:
+                # Attributes in the order of their identifiers, truncated to the requested lengths
+                for att_id, val in ((ATT_APP_ID, ntf["app"]), (ATT_TITLE, ntf["title"][:req[2]]),
+                                    (ATT_MSG, ntf["msg"][:req[3]]), (ATT_DATE, ntf["date"])):
+                    self.lib.user_on_ancc_ntf_att_ind_cb(0, req[1], att_id, val.encode())
+                    self.client.ntf_att(att_id, val)
+            self.lib.user_on_ancc_get_ntf_att_cmp_cb(0, status)
+            self.client.ntf_cmp(status)
+        else:
+            name = self.names.get(req[1])
+            status = error or (0 if name is not None else ERR_INVALID_PARAM)
+            if not status:
+                self.lib.user_on_ancc_app_att_ind_cb(0, APP_ATT_DISPLAY_NAME, req[1].encode(), name.encode())
+                self.client.app_att(APP_ATT_DISPLAY_NAME, req[1], name)
+            self.lib.user_on_ancc_get_app_att_cmp_cb(0, status)
+            self.client.app_cmp(status)
+        self.stats["failed"] += status != 0
+
+    def event(self, ev):
+        kind = ev["ev"]
+        self.stats["events"] += 1
+        if kind == "name":
+            self.names[ev["app"]] = ev["name"]
+        elif kind == "added":
+            old = self.phone.get(ev["uid"])
+            if old is not None:
+                self.cat_cnt[old["cat"]] -= 1
+            self.phone[ev["uid"]] = dict(ev)
+            self.cat_cnt[ev["cat"]] = self.cat_cnt.get(ev["cat"], 0) + 1
+            self.src(EVT_ADDED, ev["uid"], ev["cat"], ev["flags"])
+        elif kind == "modified":
+            ntf = self.phone.get(ev["uid"])
+            if ntf is None:
+                return
+            ntf["title"], ntf["msg"] = ev["title"], ev["msg"]
+            self.src(EVT_MODIFIED, ev["uid"], ntf["cat"], ntf["flags"])
+        elif kind == "removed":
+            ntf = self.phone.pop(ev["uid"], None)
+            if ntf is None:
+                return
+            self.cat_cnt[ntf["cat"]] -= 1
+            self.src(EVT_REMOVED, ev["uid"], ntf["cat"])
+        elif kind == "late":
+            name = self.names.get(ev["app"])
+            if name is None:
+                return
+            self.lib.user_on_ancc_app_att_ind_cb(0, APP_ATT_DISPLAY_NAME, ev["app"].encode(), name.encode())
+            self.client.app_att(APP_ATT_DISPLAY_NAME, ev["app"], name)
+        elif kind in ("answer", "fail"):
+            if self.outstanding is None:
+                return
+            self.answer(ERR_UNLIKELY if kind == "fail" else 0)
+        elif kind == "disconnect":
+            self.outstanding = None
+            self.lib.disconnect()
+            self.client.disconnect()
+            self.client.log.append("Device disconnected\r\n")
+        else:
+            self.fail("unknown event %r" % ev)
+        self.check("event %d (%s)" % (self.stats["events"], kind))
+
+    def drain(self):
+        while self.outstanding is not None:
+            self.answer()
+            self.check("drain")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--events", type=int, default=50000, help="events of the generated trace")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--trace", help="replay this trace instead of a generated one")
+    parser.add_argument("--save", help="write the trace to this file")
+    args = parser.parse_args()
+
+    if args.trace:
+        with open(args.trace) as f:
+            trace = [json.loads(line) for line in f if line.strip()]
+    else:
+        trace = generate(random.Random(args.seed), args.events)
+    if args.save:
+        with open(args.save, "w") as f:
+            for ev in trace:
+                f.write(json.dumps(ev) + "\n")
+
+    lib = build()
+    replay = Replay(lib)
+    for ev in trace:
+        replay.event(ev)
+        if len(replay.failures) > 10:
+            break
+    replay.drain()
+
+    if lib.req_overlap_count():
+        replay.fail("%d requests sent while one was outstanding" % lib.req_overlap_count())
+
+    s = replay.stats
+    c = replay.client
+    print("%d events: %d notifications shown, %d attribute requests, %d application name requests, "
+          "%d failed" % (s["events"], s["shown"], s["ntf_requests"], s["app_requests"], s["failed"]))
+    print("queue: %d events coalesced, %d removed while queued, %d dropped when full"
+          % (c.stats_coalesced, c.stats_unqueued, c.stats_dropped))
+    if s["shown"]:
+        print("application names fetched for %.1f%% of the notifications shown"
+              % (100.0 * s["app_requests"] / s["shown"]))
+
+    return host_c.report(replay.failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
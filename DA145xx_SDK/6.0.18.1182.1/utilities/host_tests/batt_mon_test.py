@@ -0,0 +1,583 @@
+#!/usr/bin/env python3
+"""
+Host test of the adaptive battery polling of app_bass.c (CFG_APP_BASS_ADAPTIVE_POLL).
+
+app_bass.c, app_bass_task.c and battery.c are built unmodified against the SDK headers
+and the configuration of the HID-Gamepad-Digitizer example, once with
+CFG_APP_BASS_ADAPTIVE_POLL and once without it, for the fixed poll period that runs
+battery_get_lvl() every time. The kernel timer of the harness fires the APP_BASS_TIMER
+handler after the delay it was set to, plus the jitter of the sleep clock. The GPADC stub
+converts the voltage of a coin cell discharged along a recorded or synthetic curve. The
+cell drops while it supplies the radio: a conversion that falls in a connection event
+sees the voltage minus the load drop, and ea_sleep_check() reports the time left to the
+next event. The level the host sees is the one of the last BASS_BATT_LEVEL_UPD_REQ, 255
+before the first one.
+
+The checks:
+
+- the adaptive poll runs fewer conversions and sends fewer level updates than the fixed
+  one, and no level under the alert threshold while the rest level is 2 above it
+- it reports the alert within two time constants of its filter,
+  2^APP_BATT_MON_FILTER_SHIFT periods each, of the rest level crossing the threshold
+- a conversion only falls within APP_BATT_MON_GAP_SLOTS of an event after
+  APP_BATT_MON_RETRY_MAX retries, and the poll period stays between the period given to
+  app_batt_poll_start() and 2^APP_BATT_MON_MAX_SHIFT times it, and at the shortest once
+  the alert is reported
+- the level of a new cell is reported at the first conversion out of the events
+- a drop of the rest level is reported at once, a rise only from APP_BATT_MON_LVL_HYST
+  levels up
+- app_batt_mon_get_stats() counts every conversion, retry, loaded sample and update,
+  and the conversions avoided over the time polled
+
+    batt_mon_test.py                                7 days, 60 s period, 15 ms interval
+    batt_mon_test.py --csv trace.csv --chip 585     "seconds,mV" rest voltage trace
+    batt_mon_test.py --interval 7.5 --load 250
+"""
+
+import argparse
+import bisect
+import csv
+import ctypes
+import math
+import os
+import random
+import sys
+
+import host_c
+
+SOURCES = [
+    os.path.join(host_c.APP_MODULES, "src", "app_bass", "app_bass.c"),
+    os.path.join(host_c.APP_MODULES, "src", "app_bass", "app_bass_task.c"),
+    os.path.join(host_c.SDK_SRC, "platform", "driver", "battery", "battery.c"),
+]
+
+# app_bass.h defaults
+MAX_SHIFT = 4
+FILTER_SHIFT = 2
+GAP_SLOTS = 4
+RETRY_DELAY = 1
+RETRY_MAX = 8
+ALERT_LVL = 5
+ALERT_MARGIN = 5
+LVL_HYST = 2
+
+CHIPS = {
+    # compiler flags, mV to the sample of the GPADC stub
+    "531": (["-D__DA14531__"], lambda mv: min(2047, max(0, int(round(mv * 2047 / 3600.0))))),
+    "585": (["-D__DA14585__"], lambda mv: min(2047, max(0, int(1137 + (mv - 2000) * 568 / 1000.0)))),
+}
+
+STUBS = {
+    "datasheet.h": """
+#ifndef _DATASHEET_H_
+#define _DATASHEET_H_
+#include <stdint.h>
+#if defined (__DA14531__)
+#include "da14531.h"
+#include "core_cm0plus.h"
+#include "system_DA14531.h"
+#else
+#include "da14585_586.h"
+#include "core_cm0.h"
+#include "system_DA14585_586.h"
+#endif
+#endif
+""",
+}
+
+HARNESS = r"""
+#include "da1458x_config_basic.h"
+#if (ADAPTIVE)
+#define CFG_APP_BASS_ADAPTIVE_POLL
+#endif
+#include "da1458x_config_advanced.h"
+#include "user_config.h"
+#include "user_profiles_config.h"
+#undef APP_BASS_POLL_INTERVAL
+#define APP_BASS_POLL_INTERVAL POLL
+#include "battery.c"
+#include "app_bass.c"
+#include "app_bass_task.c"
+
+#define SLOT_US 625
+
+/* Clock in us, connection events and the cell, given by the test */
+uint64_t now_us;
+static uint64_t interval_us, event_us, phase_us;
+static int (*cell_cb)(double t, int loaded);
+
+/* Kernel timer of APP_BASS_TIMER, 0 when cleared */
+uint32_t timer_delay;
+int timer_armed;
+
+int conversions, short_conversions, updates, reported;
+long retry_delays, polls_delay_sum;
+
+static uint64_t since_event(void)
+{
+    return (now_us + interval_us - phase_us) % interval_us;
+}
+
+static int sample(void)
+{
+    uint64_t ms = since_event();
+
+    conversions++;
+    if (ms < event_us || interval_us - ms < GAP_SLOTS * SLOT_US)
+        short_conversions++;
+    return cell_cb(now_us / 1e6, ms < event_us);
+}
+
+#if defined (__DA14531__)
+void adc_offset_calibrate(adc_input_mode_t input_mode) {}
+void adc_init(const adc_config_t *cfg) {}
+void adc_disable(void) {}
+void adc_input_shift_config(adc_input_sh_gain_t gain, adc_input_sh_cm_t cm) {}
+void adc_input_shift_disable(void) {}
+uint16_t adc_get_sample(void) { return sample(); }
+uint16_t adc_correct_sample(const uint16_t adc_val) { return adc_val; }
+#else
+void adc_offset_calibrate(adc_input_mode_t input_mode) {}
+uint32_t adc_get_vbat_sample(bool sample_vbat1v) { return sample(); }
+#endif
+
+bool ea_sleep_check(uint32_t *sleep_duration, uint32_t wakeup_delay)
+{
+    uint64_t ms = since_event();
+
+    return ms >= event_us && interval_us - ms >= (uint64_t)wakeup_delay * SLOT_US;
+}
+
+void app_timer_set(ke_msg_id_t const timer_id, ke_task_id_t const task_id, uint32_t delay)
+{
+    if (timer_id == APP_BASS_TIMER)
+    {
+        timer_delay = delay;
+        timer_armed = 1;
+    }
+}
+
+void ke_timer_clear(ke_msg_id_t const timer_id, ke_task_id_t const task)
+{
+    if (timer_id == APP_BASS_TIMER)
+        timer_armed = 0;
+}
+
+static ke_msg_id_t msg_id;
+static uint8_t msg_param[64];
+
+void *ke_msg_alloc(ke_msg_id_t const id, ke_task_id_t const dest_id, ke_task_id_t const src_id,
+                   uint16_t const param_len)
+{
+    msg_id = id;
+    memset(msg_param, 0, sizeof(msg_param));
+    return msg_param;
+}
+
+void ke_msg_send(void const *param_ptr)
+{
+    if (msg_id == BASS_BATT_LEVEL_UPD_REQ)
+    {
+        updates++;
+        reported = ((const struct bass_batt_level_upd_req *)param_ptr)->batt_level;
+    }
+}
+
+ke_task_id_t prf_get_task_from_id(ke_msg_id_t id) { return 0; }
+app_prf_srv_perm_t get_user_prf_srv_perm(enum KE_API_ID task_id) { return SRV_PERM_ENABLE; }
+void GPIO_SetActive(GPIO_PORT port, GPIO_PIN pin) {}
+void GPIO_SetInactive(GPIO_PORT port, GPIO_PIN pin) {}
+enum process_event_response app_std_process_event(ke_msg_id_t msgid, void const *param,
+        ke_task_id_t src_id, ke_task_id_t dest_id, enum ke_msg_status_tag *msg_ret,
+        const struct ke_msg_handler *handlers, const int handler_num)
+{
+    return PR_EVENT_UNHANDLED;
+}
+
+void start(uint32_t interval, uint32_t event, uint32_t phase, int (*cell)(double, int))
+{
+    now_us = 0;
+    interval_us = interval;
+    event_us = event;
+    phase_us = phase;
+    cell_cb = cell;
+    timer_delay = 0;
+    timer_armed = 0;
+    updates = 0;
+    reported = 255;
+    retry_delays = polls_delay_sum = 0;
+    // As at power up and on the connection
+    app_batt_init();
+    app_bass_enable(0);
+    conversions = short_conversions = 0;
+}
+
+/* Fires APP_BASS_TIMER after its delay, returns the new delay */
+uint32_t fire(uint32_t jitter_us)
+{
+    if (!timer_armed)
+        abort();
+    now_us += (uint64_t)timer_delay * 10000 + jitter_us;
+    app_bass_timer_handler(APP_BASS_TIMER, NULL, TASK_APP, TASK_APP);
+    if (timer_delay == RETRY_DELAY)
+        retry_delays++;
+    polls_delay_sum += timer_delay;
+    return timer_delay;
+}
+
+long stat(const char *name)
+{
+#if defined (CFG_APP_BASS_ADAPTIVE_POLL)
+    const struct app_batt_mon_stats *s = app_batt_mon_get_stats();
+
+    if (!strcmp(name, "conversions")) return s->conversions;
+    if (!strcmp(name, "avoided")) return s->avoided;
+    if (!strcmp(name, "loaded")) return s->loaded;
+    if (!strcmp(name, "retries")) return s->retries;
+    if (!strcmp(name, "updates")) return s->updates;
+    if (!strcmp(name, "period")) return s->period;
+#endif
+    return -1;
+}
+"""
+
+CELL = ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_double, ctypes.c_int)
+
+
+def build(chip, adaptive, poll):
+    # The quoted includes of the sources must find the stubs before the SDK headers
+    lib = host_c.build("batt_mon_test", HARNESS, stubs=STUBS, copies=SOURCES,
+                       includes=host_c.HID_INCLUDES + host_c.sdk_includes(), flags=CHIPS[chip][0],
+                       defines={"ADAPTIVE": adaptive, "POLL": poll, "GAP_SLOTS": GAP_SLOTS,
+                                "RETRY_DELAY": RETRY_DELAY})
+    lib.start.argtypes = [ctypes.c_uint32, ctypes.c_uint32, ctypes.c_uint32, CELL]
+    lib.fire.argtypes = [ctypes.c_uint32]
+    lib.fire.restype = ctypes.c_uint32
+    lib.stat.argtypes = [ctypes.c_char_p]
+    lib.stat.restype = ctypes.c_long
+    return lib
+
+
+def lvl_531(mv):
+    """Level of batt_cal_cr2032() of the DA14531 for a rest voltage."""
+    return 0 if mv < 2000 else 100 if mv > 3000 else int((mv - 2000) * 100 // 1000)
+
+
+def lvl_585(mv):
+    """Level of batt_cal_cr2032() of the DA14585/586 for a rest voltage."""
+    s = CHIPS["585"][1](mv)
+    if s > 1705:
+        return 100
+    if s > 1584:
+        return 28 + (((((s - 1584) << 16) // (1705 - 1584)) * 72) >> 16)
+    if s > 1360:
+        return 4 + (((((s - 1360) << 16) // (1584 - 1360)) * 24) >> 16)
+    if s > 1136:
+        return ((((s - 1136) << 16) // (1360 - 1136)) * 4) >> 16
+    return 0
+
+
+LEVELS = {"531": lvl_531, "585": lvl_585}
+
+
+def synth_trace(days, seed):
+    """CR2032 rest voltage: a slow plateau, then the knee of the end of life."""
+    rnd = random.Random(seed)
+    points = []
+    total = days * 86400.0
+    for i in range(0, int(total) + 1, 600):
+        x = i / total
+        mv = 3050 - 250 * x - 900 * max(0.0, (x - 0.75) / 0.25) ** 2
+        mv += 15 * math.sin(2 * math.pi * i / 86400.0) + rnd.gauss(0, 2)
+        points.append((float(i), mv))
+    return points
+
+
+def read_csv(path):
+    points = []
+    with open(path) as f:
+        for row in csv.reader(f):
+            try:
+                points.append((float(row[0]), float(row[1])))
+            except (ValueError, IndexError):
+                continue    # header
+    points.sort()
+    return points
+
+
+class Cell:
+    def __init__(self, points):
+        self.points = points
+        self.times = [p[0] for p in points]
+
+    def rest(self, t):
+        i = bisect.bisect_right(self.times, t) - 1
+        if i < 0:
+            return self.points[0][1]
+        if i + 1 >= len(self.points):
+            return self.points[-1][1]
+        (t0, v0), (t1, v1) = self.points[i], self.points[i + 1]
+        return v0 + (v1 - v0) * (t - t0) / (t1 - t0)
+
+
+class Test:
+    def __init__(self, args):
+        self.args = args
+        self.level = LEVELS[args.chip]
+        self.to_sample = CHIPS[args.chip][1]
+        self.libs = {}
+        self.failures = []
+
+    def fail(self, msg):
+        self.failures.append(msg)
+
+    def run(self, adaptive, cell, end, seed, period=None, interval=None, event=None):
+        """Polls the cell until end, returns the counters and the (time, level) reports."""
+        args = self.args
+        period = period or int(args.period * 100)
+        if (adaptive, period) not in self.libs:
+            self.libs[(adaptive, period)] = build(args.chip, adaptive, period)
+        lib = self.libs[(adaptive, period)]
+        rnd = random.Random(seed)
+        interval_us = int((interval or args.interval) * 1000)
+
+        def sample(t, loaded):
+            mv = cell.rest(t) + rnd.gauss(0, args.noise) - (args.load if loaded else 0)
+            return self.to_sample(mv)
+
+        cb = CELL(sample)
+        lib.start(interval_us, int((event or args.event) * 1000), rnd.randrange(interval_us), cb)
+        now = ctypes.c_uint64.in_dll(lib, "now_us")
+        res = {"reports": [], "delays": [], "alert_at": None}
+        while now.value < end * 1e6:
+            delay = lib.fire(rnd.randrange(10000))
+            t = now.value / 1e6
+            lvl = host_c.cint(lib, "reported").value
+            res["reports"].append((t, lvl))
+            res["delays"].append((t, delay))
+            if res["alert_at"] is None and lvl < ALERT_LVL:
+                res["alert_at"] = t
+        for name in ("conversions", "short_conversions", "updates"):
+            res[name] = host_c.cint(lib, name).value
+        res["retry_delays"] = ctypes.c_long.in_dll(lib, "retry_delays").value
+        res["delay_sum"] = ctypes.c_long.in_dll(lib, "polls_delay_sum").value
+        if adaptive:
+            res["stats"] = {name: lib.stat(name.encode()) for name in
+                            ("conversions", "avoided", "loaded", "retries", "updates", "period")}
+            res["stats"]["poll_timeout"] = period
+        del cb
+        return res
+
+    def score(self, res, cell, end):
+        false = 0
+        for t, lvl in res["reports"]:
+            if lvl < ALERT_LVL <= self.level(cell.rest(t)) - 2:
+                false += 1
+        res["false"] = false
+        cross = None
+        t = 0.0
+        while t < end:
+            if self.level(cell.rest(t)) < ALERT_LVL:
+                cross = t
+                break
+            t += 1.0
+        res["alert"] = None if cross is None or res["alert_at"] is None else res["alert_at"] - cross
+        return cross
+
+    def check_trace(self, points):
+        args = self.args
+        cell = Cell(points)
+        end = points[-1][0]
+        fixed = self.run(0, cell, end, args.seed)
+        adaptive = self.run(1, cell, end, args.seed)
+        cross = self.score(fixed, cell, end)
+        self.score(adaptive, cell, end)
+
+        print("trace: %.1f days, DA14%s, %.0f s period, %.1f ms interval, %.0f mV load drop"
+              % (end / 86400.0, args.chip, args.period, args.interval, args.load))
+        print()
+        print("%-9s %11s %8s %8s %8s %12s %6s"
+              % ("policy", "conversions", "updates", "loaded", "retries", "alert delay", "false"))
+        for name, res in (("fixed", fixed), ("adaptive", adaptive)):
+            stats = res.get("stats", {})
+            alert = "-" if res["alert"] is None else "%.0f s" % res["alert"]
+            print("%-9s %11d %8d %8s %8s %12s %6d"
+                  % (name, res["conversions"], res["updates"], stats.get("loaded", "-"),
+                     stats.get("retries", "-"), alert, res["false"]))
+        print()
+        avoided = fixed["conversions"] - adaptive["conversions"]
+        print("conversions avoided: %d (%.0f %%)" % (avoided, 100.0 * avoided / max(fixed["conversions"], 1)))
+        print()
+
+        if adaptive["conversions"] >= fixed["conversions"]:
+            self.fail("no conversion avoided")
+        if adaptive["updates"] > fixed["updates"]:
+            self.fail("more level updates than the fixed poll")
+        if adaptive["false"]:
+            self.fail("%d reports under the alert threshold above it" % adaptive["false"])
+        if cross is not None:
+            limit = 2 * (1 << FILTER_SHIFT) * args.period
+            if adaptive["alert"] is None or adaptive["alert"] > limit:
+                self.fail("alert reported %s s after the crossing, limit %.0f s" % (adaptive["alert"], limit))
+        elif not args.csv:
+            self.fail("the synthetic trace does not cross the alert threshold")
+        self.check_period(adaptive)
+        self.check_stats(adaptive)
+
+    def check_period(self, res):
+        period = res["stats"]["poll_timeout"]
+        retries = 0
+        last_delay, last_lvl = None, None
+        for (t, delay), (_, lvl) in zip(res["delays"], res["reports"]):
+            if delay == RETRY_DELAY and retries < RETRY_MAX:
+                retries += 1
+                continue
+            res.setdefault("retry_runs", set()).add(retries)
+            retries = 0
+            # A level change reported out of the alert margin halves the period
+            if (last_lvl not in (None, 255) and lvl != last_lvl and lvl > ALERT_LVL + ALERT_MARGIN
+                    and delay != max(last_delay >> 1, period)):
+                self.fail("poll period %d after the level change at %.0f s, was %d" % (delay, t, last_delay))
+                return
+            last_delay, last_lvl = delay, lvl
+            if not period <= delay <= period << MAX_SHIFT:
+                self.fail("poll period %d at %.0f s, expected %d to %d" % (delay, t, period, period << MAX_SHIFT))
+                return
+            if res["alert_at"] is not None and t > res["alert_at"] and delay != period:
+                self.fail("poll period %d at %.0f s after the alert" % (delay, t))
+                return
+
+    def check_stats(self, res):
+        stats = res["stats"]
+        expect = {
+            "conversions": res["conversions"],
+            "loaded": res["short_conversions"],
+            "retries": res["retry_delays"],
+            "updates": res["updates"],
+            "avoided": max(0, res["delay_sum"] // stats["poll_timeout"] - res["conversions"]),
+            "period": [d for t, d in res["delays"] if d != RETRY_DELAY][-1],
+        }
+        for name, value in expect.items():
+            if stats[name] != value:
+                self.fail("stats %s %d, expected %d" % (name, stats[name], value))
+
+    def check_swap(self):
+        """A new cell put in at mid-life is reported at the first unloaded conversion."""
+        swap = 86400.0
+        cell = Cell([(0.0, 2400.0), (swap, 2380.0), (swap + 0.001, 3000.0), (2 * swap, 2990.0)])
+        res = self.run(1, cell, 2 * swap, self.args.seed)
+        # First poll after the swap, and the retries that may follow it
+        seen = None
+        for t, lvl in res["reports"]:
+            if t > swap and lvl >= self.level(cell.rest(t)) - 2:
+                seen = t - swap
+                break
+        limit = ((self.args.period * (1 << MAX_SHIFT)) + RETRY_MAX * RETRY_DELAY * 0.01 + 0.1)
+        print("new cell reported after %s s, limit %.0f s" % ("-" if seen is None else "%.0f" % seen, limit))
+        if seen is None or seen > limit:
+            self.fail("new cell reported after %s s, limit %.0f s" % (seen, limit))
+
+
+    def half_step(self, res, step, high, low):
+        """Conversions after the step until the reported level covers half of it, the
+        voltages are the ones of the conversions."""
+        target = (self.level(high) + self.level(low)) // 2
+        polls = 0
+        for (t, delay), (_, lvl) in zip(res["delays"], res["reports"]):
+            if t <= step or delay == RETRY_DELAY:
+                continue
+            polls += 1
+            if lvl <= target:
+                return polls
+        return None
+
+    def check_step(self):
+        """A drop of the rest voltage is followed at the weight of the filter, and the
+        reported level settles on the rest level."""
+        day = 86400.0
+        high, low = 2805.0, 2705.0
+        cell = Cell([(0.0, high), (day, high), (day + 0.001, low), (2 * day, low)])
+        res = self.run(1, cell, 2 * day, self.args.seed)
+        polls = self.half_step(res, day, high, low)
+        settled = set(lvl for t, lvl in res["reports"] if t > 1.5 * day)
+        print("step of %.0f mV: half of it reported after %s conversions, then levels %s, rest level %d"
+              % (high - low, polls, sorted(settled), self.level(low)))
+        if polls is None or polls > 4:
+            self.fail("half of the step reported after %s conversions, expected 3" % polls)
+        # A drop to the rest level is reported, the noise may move it by one
+        if min(settled) > self.level(low) or max(settled) > self.level(low) + 1 or min(settled) < self.level(low) - 1:
+            self.fail("levels %s reported at the rest level %d" % (sorted(settled), self.level(low)))
+        self.check_period(res)
+        self.check_stats(res)
+
+    def mid(self, lvl):
+        """Rest voltage in the middle of the ones of a level."""
+        mvs = [mv for mv in range(1900, 3400) if self.level(mv) == lvl]
+        return (mvs[0] + mvs[-1]) / 2.0
+
+    def check_rise(self):
+        """A rise of the rest level, e.g. a cell recovering in the warmth, is reported from
+        APP_BATT_MON_LVL_HYST levels up, one level less is not."""
+        day = 86400.0
+        base = self.level(2705.0)
+        steps = [self.mid(base), self.mid(base + LVL_HYST - 1), self.mid(base + LVL_HYST)]
+        cell = Cell([(i * day + d, mv) for i, mv in enumerate(steps) for d in (0.001, day)])
+        res = self.run(1, cell, 3 * day, self.args.seed)
+        levels = [lvl for t, lvl in res["reports"]]
+        rises = [(a, b) for a, b in zip(levels, levels[1:]) if b > a]
+        print("rise of %d then %d levels from %d: rises %s, level %d"
+              % (LVL_HYST - 1, LVL_HYST, base, sorted(set(rises)), levels[-1]))
+        for a, b in rises:
+            if b < a + LVL_HYST:
+                self.fail("rise from %d to %d reported" % (a, b))
+        if levels[-1] <= base:
+            self.fail("rise of %d levels from %d not reported, level %d" % (LVL_HYST, base, levels[-1]))
+        self.check_period(res)
+        self.check_stats(res)
+
+    def check_busy(self):
+        """A link busy all the time, e.g. a stream: every conversion follows
+        APP_BATT_MON_RETRY_MAX retries and is filtered with the lower weight."""
+        half = 6 * 3600.0
+        high, low = 2805.0, 2705.0
+        cell = Cell([(0.0, high), (half, high), (half + 0.001, low), (2 * half, low)])
+        res = self.run(1, cell, 2 * half, self.args.seed, period=100, interval=10.0, event=10.0)
+        self.check_period(res)
+        polls = self.half_step(res, half, high - self.args.load, low - self.args.load)
+        print("busy link: %d conversions, %d loaded, %d retries, half of the step after %s conversions"
+              % (res["conversions"], res["stats"]["loaded"], res["stats"]["retries"], polls))
+        if res["stats"]["loaded"] != res["conversions"]:
+            self.fail("%d of %d conversions loaded on a busy link" % (res["stats"]["loaded"], res["conversions"]))
+        if res.get("retry_runs") != {RETRY_MAX}:
+            self.fail("conversions after %s retries on a busy link" % sorted(res.get("retry_runs", ())))
+        # Weight 2^-(FILTER_SHIFT + LOAD_SHIFT): about 11 conversions for half of the step
+        if polls is None or not 7 <= polls <= 16:
+            self.fail("half of the step reported after %s loaded conversions, expected about 11" % polls)
+        self.check_stats(res)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--csv", help="rest voltage trace, \"seconds,mV\" lines")
+    parser.add_argument("--days", type=float, default=7.0, help="length of the synthetic trace")
+    parser.add_argument("--chip", choices=sorted(CHIPS), default="531")
+    parser.add_argument("--period", type=float, default=60.0, help="APP_BASS_POLL_INTERVAL (s)")
+    parser.add_argument("--interval", type=float, default=15.0, help="connection interval (ms)")
+    parser.add_argument("--event", type=float, default=2.5, help="connection event length (ms)")
+    parser.add_argument("--load", type=float, default=150.0, help="drop of the cell during an event (mV)")
+    parser.add_argument("--noise", type=float, default=4.0, help="conversion noise (mV rms)")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    test = Test(args)
+    test.check_trace(read_csv(args.csv) if args.csv else synth_trace(args.days, args.seed))
+    test.check_swap()
+    test.check_step()
+    test.check_rise()
+    test.check_busy()
+
+    return host_c.report(test.failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
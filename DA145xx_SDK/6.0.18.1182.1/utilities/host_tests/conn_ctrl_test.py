@@ -0,0 +1,429 @@
+#!/usr/bin/env python3
+"""
+Host test of the traffic-adaptive connection parameter controller, user_conn_ctrl.c of
+the HID-Gamepad-Digitizer example.
+
+user_conn_ctrl.c is built unmodified against stub headers. The harness runs the easy
+timers on a 10ms clock. Traffic comes in bursts, a report every 100ms, with random
+lengths and gaps. The master answers each parameter update request after a delay, as
+one of:
+
+- accept:  applies the longest interval of the request and its latency
+- reject:  rejects every request
+- other:   accepts, but applies 15ms without latency for the active profile, which iOS
+           does for a request of 7.5 to 10ms, and accepts the idle profile
+- ignore:  completes the request without changing the parameters
+
+The checks:
+
+- no request before USER_CONN_CTRL_START_DELAY nor within USER_CONN_CTRL_MIN_REQ_INTERVAL
+  of the previous one
+- after a request rejected or completed outside the requested profile, the next one waits
+  for twice the previous distance, up to USER_CONN_CTRL_MAX_REQ_INTERVAL, and a request
+  that gets its profile brings the distance back to the minimum
+- with the accepting master, the link is on the active profile at the end of every burst
+  of 3s or more, and on the idle one at the end of every gap long enough
+- the statistics count the requests and their outcomes
+
+    conn_ctrl_test.py
+    conn_ctrl_test.py --hours 8 --seed 3
+"""
+
+import argparse
+import ctypes
+import os
+import random
+import re
+import sys
+
+import host_c
+
+MASTERS = ("accept", "reject", "other", "ignore")
+
+STUBS = {
+    "rwip_config.h": """
+#ifndef RWIP_CONFIG_H_
+#define RWIP_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#define __SECTION_ZERO(sec)
+#endif
+""",
+    "gapc_task.h": """
+#ifndef GAPC_TASK_H_
+#define GAPC_TASK_H_
+#include <stdint.h>
+struct gapc_connection_req_ind
+{
+    uint16_t conhdl;
+    uint16_t con_interval;
+    uint16_t con_latency;
+    uint16_t sup_to;
+};
+struct gapc_param_updated_ind
+{
+    uint16_t con_interval;
+    uint16_t con_latency;
+    uint16_t sup_to;
+};
+struct gapc_param_update_cmd
+{
+    uint8_t operation;
+    uint8_t pkt_id;
+    uint16_t intv_min;
+    uint16_t intv_max;
+    uint16_t latency;
+    uint16_t time_out;
+    uint16_t ce_len_min;
+    uint16_t ce_len_max;
+};
+#endif
+""",
+    "app_user_config.h": """
+#define MS_TO_DOUBLESLOTS(x)                ((int) (((x) * 1000) / 1250))
+#define MS_TO_TIMERUNITS(x)                 ((int) ((x) / 10))
+""",
+    "app_easy_timer.h": """
+#include <stdint.h>
+typedef uint8_t timer_hnd;
+#define EASY_TIMER_INVALID_TIMER    (0x0)
+timer_hnd app_easy_timer(const uint32_t delay, void (*fn)(void));
+void app_easy_timer_cancel(const timer_hnd timer_id);
+timer_hnd app_easy_timer_modify(const timer_hnd timer_id, const uint32_t delay);
+""",
+    "app_easy_gap.h": """
+#include "gapc_task.h"
+struct gapc_param_update_cmd *app_easy_gap_param_update_get_active(uint8_t conidx);
+void app_easy_gap_param_update_start(uint8_t conidx);
+""",
+}
+
+HARNESS = r"""
+#include "user_conn_ctrl.c"
+#include <stdlib.h>
+
+#define TIMERS 4
+
+/* Easy timers on the 10ms clock */
+static struct
+{
+    int used;
+    uint32_t expire;
+    void (*fn)(void);
+} timers[TIMERS];
+
+uint32_t now;
+
+static struct gapc_param_update_cmd update_cmd;
+
+/* Requests sent and the last one */
+int req_cnt;
+uint16_t req_intv_min, req_intv_max, req_latency;
+
+timer_hnd app_easy_timer(const uint32_t delay, void (*fn)(void))
+{
+    int i;
+
+    for (i = 0; i < TIMERS; i++)
+    {
+        if (!timers[i].used)
+        {
+            timers[i].used = 1;
+            timers[i].expire = now + delay;
+            timers[i].fn = fn;
+            return i + 1;
+        }
+    }
+    abort();
+}
+
+void app_easy_timer_cancel(const timer_hnd timer_id)
+{
+    if (timer_id == EASY_TIMER_INVALID_TIMER || !timers[timer_id - 1].used)
+    {
+        abort();
+    }
+    timers[timer_id - 1].used = 0;
+}
+
+timer_hnd app_easy_timer_modify(const timer_hnd timer_id, const uint32_t delay)
+{
+    if (timer_id == EASY_TIMER_INVALID_TIMER || !timers[timer_id - 1].used)
+    {
+        abort();
+    }
+    timers[timer_id - 1].expire = now + delay;
+    return timer_id;
+}
+
+struct gapc_param_update_cmd *app_easy_gap_param_update_get_active(uint8_t conidx)
+{
+    return &update_cmd;
+}
+
+void app_easy_gap_param_update_start(uint8_t conidx)
+{
+    req_cnt++;
+    req_intv_min = update_cmd.intv_min;
+    req_intv_max = update_cmd.intv_max;
+    req_latency = update_cmd.latency;
+}
+
+/* Ticks to the next timer, -1 if none runs */
+long timer_next(void)
+{
+    long next = -1;
+    int i;
+
+    for (i = 0; i < TIMERS; i++)
+    {
+        if (timers[i].used && (next < 0 || (long)(timers[i].expire - now) < next))
+        {
+            next = timers[i].expire - now;
+        }
+    }
+    return next;
+}
+
+/* Advance the clock, the timers due fire in order */
+void clock_advance(uint32_t ticks)
+{
+    uint32_t end = now + ticks;
+
+    for (;;)
+    {
+        int first = -1;
+        int i;
+
+        for (i = 0; i < TIMERS; i++)
+        {
+            if (timers[i].used && timers[i].expire <= end &&
+                (first < 0 || timers[i].expire < timers[first].expire))
+            {
+                first = i;
+            }
+        }
+        if (first < 0)
+        {
+            break;
+        }
+        now = timers[first].expire;
+        timers[first].used = 0;
+        timers[first].fn();
+    }
+    now = end;
+}
+
+void link_connect(uint16_t interval, uint16_t latency, uint16_t sup_to)
+{
+    struct gapc_connection_req_ind ind = {0, interval, latency, sup_to};
+
+    user_conn_ctrl_start(0, &ind);
+}
+
+void master_update(uint16_t interval, uint16_t latency, uint16_t sup_to)
+{
+    struct gapc_param_updated_ind ind = {interval, latency, sup_to};
+
+    user_conn_ctrl_param_updated(&ind);
+}
+"""
+
+RESPONSE_TICKS = 30
+TRAFFIC_TICKS = 10
+OTHER_INTERVAL = 12     # 15ms
+
+
+class Stats(ctypes.Structure):
+    _fields_ = [("requests", ctypes.c_uint16), ("accepted", ctypes.c_uint16), ("rejected", ctypes.c_uint16),
+                ("mismatched", ctypes.c_uint16), ("deferred", ctypes.c_uint16), ("updated", ctypes.c_uint16),
+                ("last_reject_status", ctypes.c_uint8)]
+
+
+def constants():
+    """Timings and profiles of user_conn_ctrl.h, in 10ms and 1.25ms units."""
+    with open(os.path.join(host_c.HID_EXAMPLE, "user_conn_ctrl.h")) as f:
+        text = f.read()
+    consts = {}
+    for name, value in re.findall(r"#define USER_CONN_CTRL_(\w+)\s+(.+?)\s*(?://.*)?$", text, re.M):
+        m = re.match(r"\((\d+)\)$", value) or re.match(r"MS_TO_DOUBLESLOTS\(([\d.]+)\)$", value)
+        if m is None:
+            continue
+        consts[name] = int(float(m.group(1)) * 1000 / 1250) if value.startswith("MS_TO_DOUBLE") else int(m.group(1))
+    return consts
+
+
+def build():
+    # The quoted includes of user_conn_ctrl.c must find the stubs before the example headers
+    lib = host_c.build("conn_ctrl_test", HARNESS, stubs=STUBS,
+                       copies=[os.path.join(host_c.HID_EXAMPLE, "user_conn_ctrl.c")], includes=[host_c.HID_EXAMPLE])
+    lib.timer_next.restype = ctypes.c_long
+    lib.clock_advance.argtypes = [ctypes.c_uint32]
+    lib.link_connect.argtypes = [ctypes.c_uint16] * 3
+    lib.master_update.argtypes = [ctypes.c_uint16] * 3
+    lib.user_conn_ctrl_on_update_rejected.argtypes = [ctypes.c_uint8]
+    lib.user_conn_ctrl_get_profile.restype = ctypes.c_int
+    lib.user_conn_ctrl_get_stats.restype = ctypes.POINTER(Stats)
+    return lib
+
+
+class Sim:
+    def __init__(self, lib, rnd, master, c):
+        self.lib = lib
+        self.rnd = rnd
+        self.master = master
+        self.c = c
+        self.failures = []
+        self.req_cnt = 0
+        self.response = None        # time of the answer to the request in flight
+        self.last_req = None
+        self.last_answer = None
+        self.backoff = c["MIN_REQ_INTERVAL"]
+        self.count = dict(requests=0, accepted=0, rejected=0, mismatched=0)
+        self.interval, self.latency = 24, 0
+        self.bursts = []            # (start, end) in ticks
+        lib.link_connect(self.interval, self.latency, 200)
+
+    @property
+    def now(self):
+        return ctypes.c_uint32.in_dll(self.lib, "now").value
+
+    def fail(self, what):
+        self.failures.append("%s master, %.2fs: %s" % (self.master, self.now / 100.0, what))
+
+    def matches(self, profile, interval, latency):
+        c = self.c
+        return c[profile + "_INTV_MIN"] <= interval <= c[profile + "_INTV_MAX"] and latency == c[profile + "_LATENCY"]
+
+    def poll_request(self):
+        """Check a request sent by the last call and plan the answer."""
+        n = host_c.cint(self.lib, "req_cnt").value
+        if n == self.req_cnt:
+            return
+        if n != self.req_cnt + 1 or self.response is not None:
+            self.fail("request sent while one is in flight")
+        self.req_cnt = n
+        self.count["requests"] += 1
+        now = self.now
+        if now < self.c["START_DELAY"]:
+            self.fail("request before the start delay")
+        if self.last_req is not None and now - self.last_req < self.c["MIN_REQ_INTERVAL"]:
+            self.fail("request %d ticks after the previous one" % (now - self.last_req))
+        if self.last_answer is not None and now - self.last_answer < self.backoff:
+            self.fail("request %d ticks after a failed one, back-off %d" % (now - self.last_answer, self.backoff))
+        self.last_req = now
+        self.response = now + RESPONSE_TICKS
+
+    def answer(self):
+        lib = self.lib
+        intv_min = ctypes.c_uint16.in_dll(lib, "req_intv_min").value
+        intv_max = ctypes.c_uint16.in_dll(lib, "req_intv_max").value
+        latency = ctypes.c_uint16.in_dll(lib, "req_latency").value
+        profile = "ACTIVE" if self.matches("ACTIVE", intv_min, latency) else "IDLE"
+        self.response = None
+        if self.master == "reject":
+            self.count["rejected"] += 1
+            lib.user_conn_ctrl_on_update_rejected(0x3B)
+            got = False
+        else:
+            if self.master == "accept":
+                self.interval, self.latency = intv_max, latency
+            elif self.master == "other":
+                self.interval, self.latency = ((OTHER_INTERVAL, 0) if profile == "ACTIVE" else (intv_max, latency))
+            if self.master != "ignore":
+                lib.master_update(self.interval, self.latency, 400)
+            self.count["accepted"] += 1
+            got = self.matches(profile, self.interval, self.latency)
+            if not got:
+                self.count["mismatched"] += 1
+            lib.user_conn_ctrl_on_update_complete()
+        if got:
+            self.backoff = self.c["MIN_REQ_INTERVAL"]
+            self.last_answer = None
+        else:
+            # Doubled from the distance of the request that failed
+            self.backoff = min(self.backoff * 2, self.c["MAX_REQ_INTERVAL"])
+            self.last_answer = self.now
+        self.poll_request()
+
+    def run(self, duration):
+        rnd = self.rnd
+        t = self.c["START_DELAY"] // 2
+        traffic = []
+        while t < duration:
+            length = rnd.randint(100, 1500)
+            self.bursts.append((t, t + length))
+            traffic += range(t, t + length, TRAFFIC_TICKS)
+            t += length + rnd.randint(200, 4000)
+        traffic.append(duration)
+        checks = []
+        for start, end in self.bursts:
+            if end - max(start, self.c["START_DELAY"]) >= 300 and end <= duration:
+                checks.append((end, "ACTIVE"))
+        for (_, end), (start, _) in zip(self.bursts, self.bursts[1:]):
+            if start - end > self.c["IDLE_TO"] + 2 * self.c["MIN_REQ_INTERVAL"] + RESPONSE_TICKS:
+                checks.append((start - 1, "IDLE"))
+        checks.sort()
+        events = sorted([(x, 0) for x in traffic] + [(x, 1) for x, _ in checks])
+        check_iter = iter(checks)
+        for when, kind in events:
+            self.advance_to(when)
+            if when >= duration:
+                break
+            if kind == 0:
+                self.lib.user_conn_ctrl_traffic_ind()
+                self.poll_request()
+            elif self.master == "accept":
+                _, profile = next(check_iter)
+                got = self.lib.user_conn_ctrl_get_profile()
+                if got != {"ACTIVE": 1, "IDLE": 2}[profile]:
+                    self.fail("profile %d, expected the %s one" % (got, profile.lower()))
+
+    def advance_to(self, t):
+        """Run the timers and the answers of the master up to t."""
+        lib = self.lib
+        while True:
+            step = lib.timer_next()
+            timer = None if step < 0 else self.now + step
+            if self.response is not None and self.response <= t and (timer is None or self.response < timer):
+                lib.clock_advance(self.response - self.now)
+                self.answer()
+            elif timer is not None and timer <= t:
+                lib.clock_advance(step)
+                self.poll_request()
+            else:
+                break
+        lib.clock_advance(t - self.now)
+
+    def check_stats(self):
+        stats = self.lib.user_conn_ctrl_get_stats().contents
+        for name, value in self.count.items():
+            if getattr(stats, name) != value:
+                self.fail("statistics: %d %s, expected %d" % (getattr(stats, name), name, value))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--hours", type=float, default=1.0, help="simulated time per master")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    c = constants()
+    duration = int(args.hours * 360000)
+    failures = []
+    for master in MASTERS:
+        lib = build()
+        sim = Sim(lib, random.Random(args.seed), master, c)
+        sim.run(duration)
+        sim.check_stats()
+        print("%-7s master: %4d bursts, %5d requests, %4d accepted, %4d rejected, %4d outside the profile"
+              % (master, len(sim.bursts), sim.count["requests"], sim.count["accepted"], sim.count["rejected"],
+                 sim.count["mismatched"]))
+        failures += sim.failures
+
+    return host_c.report(failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,1044 @@
+#!/usr/bin/env python3
+"""
+Host test of the quadrature encoder module app_encoder.c (CFG_APP_ENCODER).
+
+app_encoder.c is built unmodified against stubbed GPIO, quadrature decoder, wakeup
+controller, easy timer and kernel message layers, on a microsecond clock. The decoder stub
+counts the A/B edges of three channels in 16-bit counters that are not cleared by
+quad_decoder_init(), and interrupts after APP_ENCODER_IRQ_EVENTS edges. While the decoder
+is released the edges go to the wakeup controller stub instead, which fires on an edge to
+the armed polarity. The reports go to an emulated HID report FIFO that a link drains at
+its connection events, each one answered with app_encoder_report_done(). The checks:
+
+- counts: with unity gain, every count decoded is reported, and the only edges lost are
+  the ones that wake the encoder up
+- wrap: a long spin in one direction wraps the 16-bit counters
+- accel: with the curves of user_encoder.c, every report equals the one given by the
+  acceleration curve and the carried-over residual
+- one report in flight at a time, the decoder released and the sleep mode given back
+  after APP_ENCODER_IDLE_TIME, the pins armed on the level opposite to their current
+  one, and an edge while the pins are armed starts the decoder
+- a report never acknowledged, e.g. on a lost link, does not hold the motion after
+  APP_ENCODER_IDLE_TIME
+
+    encoder_test.py                         15 ms connection interval
+    encoder_test.py --interval 7.5 --per-event 4 --seconds 120
+"""
+
+import argparse
+import ctypes
+import os
+import random
+import sys
+
+import host_c
+
+SOURCES = [
+    os.path.join(host_c.APP_MODULES, "src", "app_encoder", "app_encoder.c"),
+    os.path.join(host_c.APP_MODULES, "api", "app_encoder.h"),
+]
+
+GAIN_ONE = 256
+XY_MAX = 32767
+Z_MAX = 127
+TIMER_UNIT_US = 10000
+
+# Curves of user_encoder.c: (speed, gain)
+XY_CURVE = [(2, GAIN_ONE), (8, 2 * GAIN_ONE), (24, 4 * GAIN_ONE)]
+Z_CURVE = [(2, GAIN_ONE), (8, 3 * GAIN_ONE)]
+
+STUBS = {
+    "rwip_config.h": """
+#ifndef RWIP_CONFIG_H_
+#define RWIP_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#define __SECTION_ZERO(name)
+#endif
+""",
+    "gpio.h": """
+#ifndef GPIO_H_
+#define GPIO_H_
+#include <stdint.h>
+#include <stdbool.h>
+typedef enum { GPIO_PORT_0 = 0 } GPIO_PORT;
+typedef enum { GPIO_PIN_0 = 0 } GPIO_PIN;
+typedef enum { INPUT = 0, INPUT_PULLUP = 0x100, INPUT_PULLDOWN = 0x200, OUTPUT = 0x300 } GPIO_PUPD;
+typedef enum { PID_GPIO = 0 } GPIO_FUNCTION;
+void GPIO_ConfigurePin(GPIO_PORT port, GPIO_PIN pin, GPIO_PUPD mode, GPIO_FUNCTION function, const bool high);
+bool GPIO_GetPinStatus(GPIO_PORT port, GPIO_PIN pin);
+#endif
+""",
+    "wkupct_quadec.h": """
+#ifndef WKUPCT_QUADEC_H_
+#define WKUPCT_QUADEC_H_
+#include <stdint.h>
+typedef enum { WKUPCT_QUADEC_ERR_OK = 0 } wkupct_quadec_error_t;
+typedef void (*wakeup_handler_function_t)(void);
+typedef void (*quad_encoder_handler_function_t)(int16_t qdec_xcnt_reg, int16_t qdec_ycnt_reg, int16_t qdec_zcnt_reg);
+typedef struct
+{
+    uint16_t chx_port_sel;
+    uint16_t chy_port_sel;
+    uint16_t chz_port_sel;
+    uint16_t qdec_clockdiv;
+    uint8_t qdec_events_count_to_trigger_interrupt;
+} QUAD_DEC_INIT_PARAMS_t;
+#define WKUPCT_PIN_POLARITY_HIGH    0
+#define WKUPCT_PIN_POLARITY_LOW     1
+#define WKUPCT_PIN_SELECT(port, pin)                ( 1U << (pin) )
+#define WKUPCT_PIN_POLARITY(port, pin, polarity)    ( (uint32_t) (polarity) << (pin) )
+void wkupct2_enable_irq(uint32_t sel_pins, uint32_t pol_pins, uint16_t events_num, uint16_t deb_time);
+wkupct_quadec_error_t wkupct2_disable_irq(void);
+void wkupct2_register_callback(wakeup_handler_function_t callback);
+void quad_decoder_register_callback(quad_encoder_handler_function_t callback);
+void quad_decoder_init(const QUAD_DEC_INIT_PARAMS_t *quad_dec_init_params);
+void quad_decoder_release(void);
+int16_t quad_decoder_get_x_counter(void);
+int16_t quad_decoder_get_y_counter(void);
+int16_t quad_decoder_get_z_counter(void);
+void quad_decoder_enable_irq(uint8_t event_count);
+#endif
+""",
+    "arch_api.h": """
+#ifndef ARCH_API_H_
+#define ARCH_API_H_
+extern int assert_warnings;
+#define ASSERT_WARNING(cond)    {if (!(cond)) assert_warnings++;}
+void arch_ble_force_wakeup(void);
+void arch_force_active_mode(void);
+void arch_restore_sleep_mode(void);
+#endif
+""",
+    "ke_msg.h": """
+#ifndef KE_MSG_H_
+#define KE_MSG_H_
+#include <stdint.h>
+typedef uint16_t ke_msg_id_t;
+typedef uint16_t ke_task_id_t;
+#define TASK_APP                (1)
+void ke_msg_send_basic(ke_msg_id_t const id, ke_task_id_t const dest_id, ke_task_id_t const src_id);
+#endif
+""",
+    "app_easy_timer.h": """
+#ifndef APP_EASY_TIMER_H_
+#define APP_EASY_TIMER_H_
+#include <stdint.h>
+typedef uint8_t timer_hnd;
+typedef void (* timer_callback)(void);
+#define EASY_TIMER_INVALID_TIMER    (0x0)
+timer_hnd app_easy_timer(const uint32_t delay, timer_callback fn);
+void app_easy_timer_cancel(const timer_hnd timer_id);
+timer_hnd app_easy_timer_modify(const timer_hnd timer_id, const uint32_t delay);
+#endif
+""",
+    "app_easy_msg_utils.h": """
+#ifndef APP_EASY_MSG_UTILS_H_
+#define APP_EASY_MSG_UTILS_H_
+#include "ke_msg.h"
+ke_msg_id_t app_easy_msg_set(void (*fn)(void));
+#endif
+""",
+}
+
+HARNESS = r"""
+#include <stdlib.h>
+#include <string.h>
+#include "app_encoder.c"
+
+#define NB_CH       3
+#define NB_PINS     (2 * NB_CH)
+
+int assert_warnings;
+uint32_t now_us;
+
+/* Curves of user_encoder.c */
+
+static const struct app_encoder_accel xy_points[] =
+{
+    {2,  APP_ENCODER_GAIN_ONE},
+    {8,  2 * APP_ENCODER_GAIN_ONE},
+    {24, 4 * APP_ENCODER_GAIN_ONE},
+};
+static const struct app_encoder_accel z_points[] =
+{
+    {2,  APP_ENCODER_GAIN_ONE},
+    {8,  3 * APP_ENCODER_GAIN_ONE},
+};
+static const struct app_encoder_curve xy_curve = {xy_points, 3};
+static const struct app_encoder_curve z_curve = {z_points, 2};
+
+/* Channels X, Y and Z, pins A and B of channel ch are pins 2 ch and 2 ch + 1 */
+
+static struct app_encoder_pin pins[NB_PINS];
+static bool send_report(int16_t x, int16_t y, int8_t z);
+static struct app_encoder_cfg cfg;
+
+/* Pins and decoder: the A/B levels follow a Gray sequence, one edge per count. The
+   counters keep their value across quad_decoder_init(). */
+
+static uint8_t phase[NB_CH];
+static int mode[NB_PINS];
+int pad_errors;
+static int16_t counter[NB_CH];
+static int qdec_on;
+static quad_encoder_handler_function_t qdec_cb;
+static int irq_enabled;
+static uint8_t irq_threshold;
+static int irq_events;
+int32_t decoded[NB_CH];
+int32_t lost[NB_CH];
+int lost_edges;
+int decoded_edges;
+int decoder_errors;
+
+/* Level of pin i: A = bit 1 of the Gray code, B = bit 0 */
+static bool level(int i)
+{
+    static const uint8_t gray[4] = {0, 1, 3, 2};
+
+    return (gray[phase[i / 2]] >> (1 - (i & 1))) & 1;
+}
+
+void GPIO_ConfigurePin(GPIO_PORT port, GPIO_PIN pin, GPIO_PUPD m, GPIO_FUNCTION function, const bool high)
+{
+    if ((pin >= NB_PINS) || (m != INPUT_PULLUP))
+    {
+        pad_errors++;
+        return;
+    }
+    mode[pin] = m;
+}
+
+/* An edge in the middle of the next arming of the pins, after a number of pin reads or,
+   when the count is reached there, just before the wakeup controller is enabled */
+
+static int late_ch = -1, late_dir, late_reads;
+static int reads;
+
+void turn_late(int ch, int dir, int after_reads)
+{
+    late_ch = ch;
+    late_dir = dir;
+    late_reads = after_reads;
+    reads = 0;
+}
+
+static void edge(int ch, int dir);
+
+int late_pending(void)
+{
+    return late_ch >= 0;
+}
+
+static void late_edge(void)
+{
+    if (late_ch >= 0)
+    {
+        int ch = late_ch;
+
+        late_ch = -1;
+        edge(ch, late_dir);
+    }
+}
+
+bool GPIO_GetPinStatus(GPIO_PORT port, GPIO_PIN pin)
+{
+    if (reads++ == late_reads)
+    {
+        late_edge();
+    }
+    if ((pin >= NB_PINS) || (mode[pin] != INPUT_PULLUP))
+    {
+        pad_errors++;
+    }
+    return level(pin);
+}
+
+void quad_decoder_register_callback(quad_encoder_handler_function_t callback)
+{
+    qdec_cb = callback;
+}
+
+void quad_decoder_init(const QUAD_DEC_INIT_PARAMS_t *params)
+{
+    if (qdec_on)
+    {
+        decoder_errors++;
+    }
+    qdec_on = 1;
+    irq_enabled = 0;
+    irq_events = 0;
+}
+
+void quad_decoder_release(void)
+{
+    if (!qdec_on)
+    {
+        decoder_errors++;
+    }
+    qdec_on = 0;
+    irq_enabled = 0;
+}
+
+int16_t quad_decoder_get_x_counter(void) { return counter[0]; }
+int16_t quad_decoder_get_y_counter(void) { return counter[1]; }
+int16_t quad_decoder_get_z_counter(void) { return counter[2]; }
+
+void quad_decoder_enable_irq(uint8_t event_count)
+{
+    if (!qdec_on)
+    {
+        decoder_errors++;
+    }
+    irq_threshold = event_count;
+    irq_enabled = 1;
+}
+
+/* Sleep mode */
+
+int forced_active;
+int sleep_errors;
+
+void arch_force_active_mode(void)
+{
+    if (forced_active)
+    {
+        sleep_errors++;
+    }
+    forced_active = 1;
+}
+
+void arch_restore_sleep_mode(void)
+{
+    if (!forced_active)
+    {
+        sleep_errors++;
+    }
+    forced_active = 0;
+}
+
+void arch_ble_force_wakeup(void)
+{
+}
+
+/* Wakeup controller: an edge of a selected pin to its polarity, held for the debouncing
+   time, disables the interrupt and calls the callback */
+
+static wakeup_handler_function_t wkup_cb;
+static uint32_t wkup_sel, wkup_pol;
+static uint16_t wkup_deb;
+int wkup_armed;
+static int wkup_active;
+static uint32_t wkup_at;
+int wakeups;
+int wrong_selection;
+
+static int wkup_level(void)
+{
+    int i;
+
+    for (i = 0; i < NB_PINS; i++)
+    {
+        if ((wkup_sel & (1U << i)) && (level(i) == !((wkup_pol >> i) & 1)))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void wkupct2_enable_irq(uint32_t sel_pins, uint32_t pol_pins, uint16_t events_num, uint16_t deb_time)
+{
+    if (reads == late_reads)
+    {
+        late_edge();
+    }
+    wkup_sel = sel_pins;
+    wkup_pol = pol_pins;
+    wkup_deb = deb_time;
+    wkup_armed = 1;
+    // Level already active: no edge
+    wkup_active = wkup_level();
+    wkup_at = (uint32_t) -1;
+    if (sel_pins != (1U << cfg.nb_pins) - 1)
+    {
+        wrong_selection++;
+    }
+}
+
+wkupct_quadec_error_t wkupct2_disable_irq(void)
+{
+    wkup_armed = 0;
+    return WKUPCT_QUADEC_ERR_OK;
+}
+
+void wkupct2_register_callback(wakeup_handler_function_t callback)
+{
+    wkup_cb = callback;
+}
+
+/* Kernel messages of the application, run in order when the interrupts return */
+
+#define MSG_MAX 8
+static void (*msg_fn[MSG_MAX])(void);
+static int nb_msg_fn;
+static ke_msg_id_t queue[16];
+static int queued;
+int stray_msgs;
+
+ke_msg_id_t app_easy_msg_set(void (*fn)(void))
+{
+    msg_fn[nb_msg_fn] = fn;
+    return 0x100 + nb_msg_fn++;
+}
+
+void ke_msg_send_basic(ke_msg_id_t const id, ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    if ((dest_id != TASK_APP) || (queued == 16))
+    {
+        stray_msgs++;
+        return;
+    }
+    queue[queued++] = id;
+}
+
+static void dispatch(void)
+{
+    while (queued)
+    {
+        ke_msg_id_t id = queue[0];
+
+        memmove(&queue[0], &queue[1], --queued * sizeof(queue[0]));
+        if ((id < 0x100) || (id >= 0x100 + nb_msg_fn))
+        {
+            stray_msgs++;
+            continue;
+        }
+        msg_fn[id - 0x100]();
+    }
+}
+
+/* Easy timers, in 10 ms units */
+
+#define TIMER_MAX 4
+static timer_callback timer_fn[TIMER_MAX];
+static uint32_t timer_at[TIMER_MAX];
+int timer_errors;
+
+timer_hnd app_easy_timer(const uint32_t delay, timer_callback fn)
+{
+    int i;
+
+    for (i = 0; i < TIMER_MAX; i++)
+    {
+        if (timer_fn[i] == NULL)
+        {
+            timer_fn[i] = fn;
+            timer_at[i] = now_us + delay * 10000;
+            return i + 1;
+        }
+    }
+    timer_errors++;
+    return EASY_TIMER_INVALID_TIMER;
+}
+
+void app_easy_timer_cancel(const timer_hnd timer_id)
+{
+    if ((timer_id == EASY_TIMER_INVALID_TIMER) || (timer_fn[timer_id - 1] == NULL))
+    {
+        timer_errors++;
+        return;
+    }
+    timer_fn[timer_id - 1] = NULL;
+}
+
+timer_hnd app_easy_timer_modify(const timer_hnd timer_id, const uint32_t delay)
+{
+    if ((timer_id == EASY_TIMER_INVALID_TIMER) || (timer_fn[timer_id - 1] == NULL))
+    {
+        timer_errors++;
+        return EASY_TIMER_INVALID_TIMER;
+    }
+    timer_at[timer_id - 1] = now_us + delay * 10000;
+    return timer_id;
+}
+
+int timers_pending(void)
+{
+    int i, n = 0;
+
+    for (i = 0; i < TIMER_MAX; i++)
+    {
+        n += timer_fn[i] != NULL;
+    }
+    return n;
+}
+
+/* Link: the HID report FIFO, drained at the connection events. A held link answers no
+   report, a lost link takes the reports and never answers. */
+
+#define REPORT_MAX 65536
+int16_t rep_x[REPORT_MAX], rep_y[REPORT_MAX];
+int8_t rep_z[REPORT_MAX];
+uint32_t rep_age[REPORT_MAX];
+int reports;
+int64_t reported[NB_CH];
+int fifo_size, per_event, fifo, max_fifo;
+uint32_t interval_us;
+static uint32_t next_event;
+int link_held, link_lost;
+static uint32_t oldest = (uint32_t) -1;
+
+static bool send_report(int16_t x, int16_t y, int8_t z)
+{
+    if (link_lost)
+    {
+        fifo = 0;
+    }
+    if (fifo == fifo_size)
+    {
+        return false;
+    }
+    fifo++;
+    if (fifo > max_fifo)
+    {
+        max_fifo = fifo;
+    }
+    if (reports < REPORT_MAX)
+    {
+        rep_x[reports] = x;
+        rep_y[reports] = y;
+        rep_z[reports] = z;
+        rep_age[reports] = (oldest == (uint32_t) -1) ? 0 : now_us - oldest;
+        reports++;
+    }
+    reported[0] += x;
+    reported[1] += y;
+    reported[2] += z;
+    oldest = (uint32_t) -1;
+    return true;
+}
+
+void conn_event(void)
+{
+    int n = (fifo < per_event) ? fifo : per_event;
+
+    if (link_held || link_lost)
+    {
+        return;
+    }
+    fifo -= n;
+    while (n--)
+    {
+        app_encoder_report_done();
+        dispatch();
+    }
+}
+
+/* An edge of channel ch, dir +1 or -1, then the kernel runs */
+
+static void wkup_check(void)
+{
+    int active;
+
+    if (!wkup_armed)
+    {
+        return;
+    }
+    active = wkup_level();
+    if (active && !wkup_active)
+    {
+        wkup_at = now_us + wkup_deb * 1000;
+    }
+    else if (!active)
+    {
+        wkup_at = (uint32_t) -1;
+    }
+    wkup_active = active;
+    if ((wkup_at != (uint32_t) -1) && (now_us >= wkup_at))
+    {
+        wakeups++;
+        wkup_armed = 0;
+        wkup_at = (uint32_t) -1;
+        // Wakeup from sleep: set_pad_functions()
+        memset(mode, 0, sizeof(mode));
+        app_encoder_set_pads();
+        wkup_cb();
+    }
+}
+
+static void edge(int ch, int dir)
+{
+    phase[ch] = (phase[ch] + dir) & 3;
+
+    if (!qdec_on)
+    {
+        lost[ch] += dir;
+        lost_edges++;
+        wkup_check();
+    }
+    else
+    {
+        counter[ch] += dir;
+        decoded[ch] += dir;
+        decoded_edges++;
+        if (oldest == (uint32_t) -1)
+        {
+            oldest = now_us;
+        }
+        if (irq_enabled && (++irq_events >= (irq_threshold ? irq_threshold : 1)))
+        {
+            irq_enabled = 0;
+            irq_events = 0;
+            qdec_cb(counter[0], counter[1], counter[2]);
+        }
+    }
+}
+
+void turn(int ch, int dir)
+{
+    edge(ch, dir);
+    dispatch();
+}
+
+/* Time goes on up to t: timers, connection events and wakeup debouncing in order */
+
+void run_until(uint32_t t)
+{
+    for (;;)
+    {
+        uint32_t next = t;
+        int i, which = -1;
+
+        for (i = 0; i < TIMER_MAX; i++)
+        {
+            if ((timer_fn[i] != NULL) && (timer_at[i] <= next))
+            {
+                next = timer_at[i];
+                which = i;
+            }
+        }
+        if (interval_us && (next_event <= next))
+        {
+            next = next_event;
+            which = -2;
+        }
+        if (wkup_armed && (wkup_at <= next))
+        {
+            next = wkup_at;
+            which = -3;
+        }
+        if (which == -1)
+        {
+            break;
+        }
+        now_us = next;
+        if (which >= 0)
+        {
+            timer_callback fn = timer_fn[which];
+
+            timer_fn[which] = NULL;
+            fn();
+        }
+        else if (which == -2)
+        {
+            next_event += interval_us;
+            conn_event();
+        }
+        else
+        {
+            wkup_check();
+        }
+        dispatch();
+    }
+    now_us = t;
+}
+
+void start(int unity, int fifo_sz, int per_evt, uint32_t interval, uint16_t seed)
+{
+    int i;
+
+    for (i = 0; i < NB_PINS; i++)
+    {
+        pins[i].port = GPIO_PORT_0;
+        pins[i].pin = (GPIO_PIN) i;
+    }
+    cfg.pins = pins;
+    cfg.nb_pins = NB_PINS;
+    cfg.xy_curve = unity ? NULL : &xy_curve;
+    cfg.z_curve = unity ? NULL : &z_curve;
+    cfg.send = send_report;
+
+    now_us = 0;
+    queued = 0;
+    wkup_armed = 0;
+    late_ch = -1;
+    memset(mode, 0, sizeof(mode));
+    memset(decoded, 0, sizeof(decoded));
+    memset(lost, 0, sizeof(lost));
+    memset(reported, 0, sizeof(reported));
+    reports = fifo = max_fifo = wakeups = lost_edges = decoded_edges = 0;
+    link_held = link_lost = 0;
+    oldest = (uint32_t) -1;
+    fifo_size = fifo_sz;
+    per_event = per_evt;
+    interval_us = interval;
+    next_event = interval;
+    // The counters and the wheel keep their state over a restart of the module
+    for (i = 0; i < NB_CH; i++)
+    {
+        counter[i] = (int16_t) (seed * (i + 1) * 7919);
+        phase[i] = (seed >> i) & 3;
+    }
+    app_encoder_init(&cfg);
+    dispatch();
+}
+
+int active(void)
+{
+    return app_encoder_is_active();
+}
+
+int32_t stats_counts(int ch)
+{
+    return app_encoder_get_stats()->counts[ch];
+}
+
+int32_t residual(int ch)
+{
+    return encoder_env.residual[ch];
+}
+
+int32_t pending(int ch)
+{
+    return encoder_env.pending[ch];
+}
+
+/* Pins armed on the level opposite to their current one */
+
+int armed_opposite(void)
+{
+    int i;
+
+    for (i = 0; i < NB_PINS; i++)
+    {
+        if (((wkup_pol >> i) & 1) != level(i))
+        {
+            return 0;
+        }
+    }
+    return wkup_armed && !wkup_active;
+}
+
+int constant(const char *name)
+{
+#define C(x)    if (strcmp(name, #x) == 0) return (x)
+    C(APP_ENCODER_IDLE_TIME); C(APP_ENCODER_IRQ_EVENTS); C(APP_ENCODER_WKUP_DEB_TIME);
+#undef C
+    return -1;
+}
+"""
+
+
+def build(args):
+    # The quoted includes of the sources must find the stubs before the SDK headers
+    lib = host_c.build("encoder_test", HARNESS, stubs=STUBS, copies=SOURCES,
+                       defines={"__DA14531__": None, "CFG_APP_ENCODER": None,
+                                "APP_ENCODER_IRQ_EVENTS": args.irq_events, "APP_ENCODER_IDLE_TIME": args.idle,
+                                "APP_ENCODER_WKUP_DEB_TIME": args.wkup_deb})
+    lib.constant.argtypes = [ctypes.c_char_p]
+    lib.run_until.argtypes = [ctypes.c_uint32]
+    lib.start.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_uint32, ctypes.c_uint16]
+    for name in ("stats_counts", "residual", "pending"):
+        getattr(lib, name).restype = ctypes.c_int32
+    return lib
+
+
+def gain(curve, speed):
+    """Acceleration curve: the gain is interpolated linearly between the points, with the
+    truncation of C towards zero, and stays flat beyond the first and last ones."""
+    if curve is None:
+        return GAIN_ONE
+    if speed <= curve[0][0]:
+        return curve[0][1]
+    for (s0, g0), (s1, g1) in zip(curve, curve[1:]):
+        if speed < s1:
+            num = (g1 - g0) * (speed - s0)
+            return g0 + (abs(num) // (s1 - s0)) * (1 if num >= 0 else -1)
+    return curve[-1][1]
+
+
+class Reference:
+    """Reports expected from a sequence of counts and acknowledgements: the counters are
+    read on the decoder interrupt and on an acknowledgement, a report is sent when none
+    is in flight, the motion of a report goes through the curve, the fraction of a count
+    and the motion beyond the range of a report are carried over."""
+
+    def __init__(self, irq_events):
+        self.threshold = max(1, irq_events)
+        self.events = 0
+        self.unread = [0, 0, 0]
+        self.pending = [0, 0, 0]
+        self.residual = [0, 0, 0]
+        self.in_flight = False
+        self.reports = []
+
+    def scale(self, ch, g, limit):
+        acc = self.residual[ch] + self.pending[ch] * g
+        out = abs(acc) // GAIN_ONE * (1 if acc >= 0 else -1)
+        out = max(-limit, min(limit, out))
+        return out, acc - out * GAIN_ONE
+
+    def flush(self):
+        if self.in_flight:
+            return
+        speed = max(abs(self.pending[0]), abs(self.pending[1]))
+        x, rx = self.scale(0, gain(XY_CURVE, speed), XY_MAX)
+        y, ry = self.scale(1, gain(XY_CURVE, speed), XY_MAX)
+        z, rz = self.scale(2, gain(Z_CURVE, abs(self.pending[2])), Z_MAX)
+        self.residual = [rx, ry, rz]
+        self.pending = [0, 0, 0]
+        if x or y or z:
+            self.reports.append((x, y, z))
+            self.in_flight = True
+
+    def read(self):
+        moved = any(self.unread)
+        self.pending = [p + u for p, u in zip(self.pending, self.unread)]
+        self.unread = [0, 0, 0]
+        return moved
+
+    def count(self, ch, d):
+        self.unread[ch] += d
+        self.events += 1
+        if self.events == self.threshold:
+            self.events = 0
+            if self.read():
+                self.flush()
+
+    def done(self):
+        self.in_flight = False
+        self.read()
+        self.flush()
+
+
+class Test:
+    def __init__(self, args):
+        self.args = args
+        self.failures = []
+        self.lib = build(args)
+
+    def fail(self, msg):
+        self.failures.append(msg)
+
+    def reports(self):
+        lib = self.lib
+        n = host_c.cint(lib, "reports").value
+        if not n:
+            return []
+        xs = (ctypes.c_int16 * n).in_dll(lib, "rep_x")
+        ys = (ctypes.c_int16 * n).in_dll(lib, "rep_y")
+        zs = (ctypes.c_int8 * n).in_dll(lib, "rep_z")
+        return [(xs[i], ys[i], zs[i]) for i in range(n)]
+
+    def play(self, steps, unity=True, seed=1):
+        """Plays a list of (time_us, channel, direction) and lets the encoder go idle."""
+        args = self.args
+        lib = self.lib
+        lib.start(1 if unity else 0, args.fifo, args.per_event, int(args.interval * 1000), seed)
+        for t, ch, d in steps:
+            lib.run_until(t)
+            lib.turn(ch, d)
+        end = (steps[-1][0] if steps else 0) + (args.idle + 10) * TIMER_UNIT_US
+        lib.run_until(end)
+        # The last reports may have restarted the idle timer
+        while lib.active():
+            end += args.idle * TIMER_UNIT_US
+            lib.run_until(end)
+        self.check_idle()
+
+    def check_idle(self):
+        lib = self.lib
+        if lib.active() or lib.timers_pending() or host_c.cint(lib, "forced_active").value or not lib.armed_opposite():
+            self.fail("encoder not idle with the pins armed on their opposite level")
+        if host_c.cint(lib, "max_fifo").value > 1:
+            self.fail("%d reports in the FIFO at once" % host_c.cint(lib, "max_fifo").value)
+        for name, what in (("assert_warnings", "assertions"), ("pad_errors", "pads misconfigured or read unset"),
+                           ("stray_msgs", "unexpected messages"), ("timer_errors", "timer errors"),
+                           ("decoder_errors", "decoder calls out of order"), ("sleep_errors", "sleep mode unbalanced"),
+                           ("wrong_selection", "pin selections")):
+            if host_c.cint(lib, name).value:
+                self.fail("%d %s" % (host_c.cint(lib, name).value, what))
+                host_c.cint(lib, name).value = 0
+
+    def counts(self):
+        lib = self.lib
+        decoded = list((ctypes.c_int32 * 3).in_dll(lib, "decoded"))
+        lost = list((ctypes.c_int32 * 3).in_dll(lib, "lost"))
+        reported = list((ctypes.c_int64 * 3).in_dll(lib, "reported"))
+        return decoded, lost, reported
+
+    def motion(self, rng, seconds):
+        """(time_us, channel, direction) of every edge: bursts of wheel scrolling and
+        pointer moves of random speed, with pauses."""
+        steps = []
+        now = 100000
+        end = seconds * 1000000
+        while now < end:
+            rate = rng.choice([20, 60, 200, 800, 2500])
+            length = rng.uniform(0.1, 1.5)
+            chans = rng.choice([[2], [2], [0], [0, 1]])
+            dirs = [rng.choice([-1, 1]) for _ in chans]
+            for _ in range(max(1, int(rate * length))):
+                k = rng.randrange(len(chans))
+                steps.append((int(now), chans[k], dirs[k]))
+                now += max(1, rng.expovariate(rate) * 1000000)
+            now += rng.choice([0.05, 0.3, 2.0]) * 1000000
+        return steps
+
+    def check_counts(self, steps):
+        args = self.args
+        lib = self.lib
+        self.play(steps, True, args.seed)
+        decoded, lost, reported = self.counts()
+        if decoded != reported:
+            self.fail("unity gain: %s decoded, %s reported" % (decoded, reported))
+        if [lib.stats_counts(ch) for ch in range(3)] != decoded:
+            self.fail("statistics count %s, %s decoded" % ([lib.stats_counts(ch) for ch in range(3)], decoded))
+        edges = [sum(d for _, c, d in steps if c == ch) for ch in range(3)]
+        if [a + b for a, b in zip(decoded, lost)] != edges:
+            self.fail("%s edges, %s decoded and %s lost" % (edges, decoded, lost))
+        wakeups = host_c.cint(lib, "wakeups").value
+        lost_edges = host_c.cint(lib, "lost_edges").value
+        if args.wkup_deb == 0 and lost_edges != wakeups:
+            self.fail("%d edges lost for %d wakeups" % (lost_edges, wakeups))
+
+        reports = host_c.cint(lib, "reports").value
+        ages = sorted((ctypes.c_uint32 * reports).in_dll(lib, "rep_age")) if reports else [0]
+        print("counts     unity gain: %d edges, %d decoded, %d reported, %d wakeups"
+              % (len(steps), host_c.cint(lib, "decoded_edges").value, sum(abs(x) for x in reported), wakeups))
+        print("           %d reports, %.1f counts per report, age of the oldest count %.1f ms mean, %.1f ms max"
+              % (reports, host_c.cint(lib, "decoded_edges").value / float(max(1, reports)),
+                 sum(ages) / 1000.0 / len(ages), ages[-1] / 1000.0))
+        print("           %d edges lost while the decoder was released" % lost_edges)
+
+    def check_wrap(self):
+        # The first edge wakes the encoder up
+        spin = [(100000, 2, 1)] + [(200000 + 300 * n, 2, 1) for n in range(70000)]
+        self.play(spin, True, 3)
+        decoded, lost, reported = self.counts()
+        if decoded[2] != reported[2] or decoded[2] + lost[2] != len(spin) or decoded[2] < 0x10000:
+            self.fail("wrap: %d edges, %d decoded, %d reported" % (len(spin), decoded[2], reported[2]))
+        print("wrap       %d edges in one direction: %d reported" % (len(spin), reported[2]))
+
+    def check_accel(self):
+        """Counts and acknowledgements within one idle period, compared with the reference."""
+        lib = self.lib
+        rng = random.Random(self.args.seed)
+        lib.start(0, 8, 1, 0, 5)
+        # The first edge wakes the encoder up
+        lib.turn(2, 1)
+        t = self.args.wkup_deb * 1000
+        lib.run_until(t)
+        if not lib.active():
+            self.fail("accel: the decoder does not start on an edge")
+        ref = Reference(self.args.irq_events)
+        for _ in range(400):
+            t += 100
+            lib.run_until(t)
+            if rng.random() < 0.3:
+                lib.conn_event()
+                ref.done()
+                continue
+            ch = rng.choice([0, 1, 2, 2])
+            d = rng.choice([-1, 1])
+            for _ in range(rng.choice([1, 1, 2, 5, 12, 40, 300])):
+                lib.turn(ch, d)
+                ref.count(ch, d)
+        got = self.reports()
+        if got != ref.reports:
+            first = next((i for i, (a, b) in enumerate(zip(got, ref.reports)) if a != b), min(len(got), len(ref.reports)))
+            self.fail("accel: report %d is %s, the curve gives %s (%d reports, %d expected)"
+                      % (first, got[first] if first < len(got) else None,
+                         ref.reports[first] if first < len(ref.reports) else None, len(got), len(ref.reports)))
+        state = ([lib.residual(ch) for ch in range(3)], [lib.pending(ch) for ch in range(3)])
+        if state != (ref.residual, ref.pending):
+            self.fail("accel: residual and pending counts %s, %s expected" % (state, (ref.residual, ref.pending)))
+        print("accel      %d reports as the curves give, residual %s/256"
+              % (len(got), [lib.residual(ch) for ch in range(3)]))
+
+    def check_arm_edge(self):
+        """An edge between the read of the levels and the arming is not seen by the
+        wakeup controller: the decoder must start at once."""
+        lib = self.lib
+        args = self.args
+        for after in range(1, 9):
+            lib.start(1, 8, 1, 0, 7)
+            lib.turn(2, 1)
+            lib.run_until(args.wkup_deb * 1000)
+            lib.turn(2, 1)
+            # An edge lands during the arming of the pins, once the idle timer fires
+            lib.turn_late(0, 1, after)
+            t = args.wkup_deb * 1000
+            while lib.late_pending() and t < 10 * args.idle * TIMER_UNIT_US:
+                t += TIMER_UNIT_US
+                lib.run_until(t)
+            # The wakeup controller debounces an edge seen after the arming
+            lib.run_until(t + (args.wkup_deb + 1) * 1000)
+            if lib.late_pending():
+                self.fail("arm: the pins are not read %d times while armed" % after)
+            elif not lib.active():
+                self.fail("arm: edge after %d pin reads of the arming, the decoder stays released" % after)
+        lib.run_until(3 * (args.idle + 1) * TIMER_UNIT_US)
+        self.check_idle()
+        print("arm        edges during the arming of the pins start the decoder")
+
+    def check_lost_link(self):
+        """Reports taken by a link that never answers."""
+        lib = self.lib
+        args = self.args
+        lib.start(1, 8, 1, int(args.interval * 1000), 9)
+        host_c.cint(lib, "link_lost").value = 1
+        t = 0
+        for n in range(50):
+            t += 2000
+            lib.run_until(t)
+            lib.turn(2, -1)
+        lib.run_until(t + 2 * (args.idle + 1) * TIMER_UNIT_US)
+        decoded, lost, reported = self.counts()
+        if decoded[2] != reported[2]:
+            self.fail("lost link: %d decoded, %d reported" % (decoded[2], reported[2]))
+        lib.run_until(t + 5 * (args.idle + 1) * TIMER_UNIT_US)
+        self.check_idle()
+        print("lost link  %d counts, %d reported within %d ms" % (-decoded[2], -reported[2], 2 * args.idle * 10))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--interval", type=float, default=15, help="connection interval in ms")
+    parser.add_argument("--per-event", type=int, default=2, help="notifications sent per connection event")
+    parser.add_argument("--fifo", type=int, default=8, help="HID_REPORT_FIFO_SIZE")
+    parser.add_argument("--irq-events", type=int, default=0, help="APP_ENCODER_IRQ_EVENTS")
+    parser.add_argument("--idle", type=int, default=100, help="APP_ENCODER_IDLE_TIME, 10 ms units")
+    parser.add_argument("--wkup-deb", type=int, default=0, help="APP_ENCODER_WKUP_DEB_TIME in ms")
+    parser.add_argument("--seconds", type=int, default=60)
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    test = Test(args)
+    steps = test.motion(random.Random(args.seed), args.seconds)
+    print("%d edges in %d s, %g ms connection interval, %d notifications per event"
+          % (len(steps), args.seconds, args.interval, args.per_event))
+    test.check_counts(steps)
+    test.check_wrap()
+    test.check_accel()
+    test.check_arm_edge()
+    test.check_lost_link()
+
+    return host_c.report(test.failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
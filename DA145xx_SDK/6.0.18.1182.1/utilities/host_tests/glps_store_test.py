@@ -0,0 +1,845 @@
+#!/usr/bin/env python3
+"""
+Host test of the record store and the Record Access Control Point of the Glucose
+Profile Sensor application, app_glps.c.
+
+app_glps.c is built unmodified against stub headers and an emulated SPI NOR flash: 4KB
+sectors erased to 0xFF, programming only clears bits, every access checked to happen
+between spi_flash_release_from_power_down() and spi_flash_power_down(). The kernel
+messages sent to the GLPS task are captured.
+
+Thousands of measurements are stored, with times that mostly increase but jump back now
+and then, with and without context. Between them the RACP requests of a collector are
+issued with random operators and filters: report the number of records, report the
+records, delete them, abort a report. Every answer is compared with a reference model of
+the ring of sectors. Along the way the device is reset, the index rebuilt from the flash
+must be the one held in retention memory, and the power is cut while a record or a
+sector header is programmed, the records left must be the model's.
+
+The flash bytes read per count request and the erase count of each sector are reported.
+
+    glps_store_test.py
+    glps_store_test.py --records 50000 --sectors 8
+"""
+
+import argparse
+import ctypes
+import datetime
+import os
+import random
+import sys
+
+import host_c
+
+STUBS = {
+    "rwip_config.h": """
+#ifndef RWIP_CONFIG_H_
+#define RWIP_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#define BLE_APP_PRESENT         1
+#define BLE_GL_SENSOR           1
+#define BLE_GL_COLLECTOR        0
+#define BLE_SERVER_PRF          1
+#define BLE_CLIENT_PRF          0
+#define BLE_CONNECTION_MAX      1
+#define __SECTION_ZERO(name)
+#define __ARRAY_EMPTY
+#endif
+""",
+    "ke_task.h": """
+#ifndef KE_TASK_H_
+#define KE_TASK_H_
+#include <stdint.h>
+typedef uint16_t ke_task_id_t;
+typedef uint16_t ke_msg_id_t;
+typedef uint8_t ke_state_t;
+struct ke_state_handler
+{
+    int unused;
+};
+#define KE_FIRST_MSG(task)      ((ke_msg_id_t)((task) << 8))
+#define TASK_ID_GLPS            (22)
+#define TASK_APP                (1)
+#define TASK_GAPM               (2)
+#endif
+""",
+    "prf.h": """
+#include "ke_task.h"
+typedef struct
+{
+    ke_task_id_t prf_task;
+} prf_env_t;
+""",
+    "prf_utils.h": """
+extern struct glps_env_tag glps_env_data;
+#define PRF_ENV_GET(prf_id, type)       (&type##_env_data)
+#define prf_src_task_get(env, conidx)   (TASK_ID_GLPS)
+""",
+    "app.h": """
+#include "ke_task.h"
+#define GAP_ERR_NO_ERROR                (0)
+#define GAPM_PROFILE_TASK_ADD           (0x1B)
+#define GAPM_PROFILE_TASK_ADD_CMD       (0x0D1B)
+struct gapm_profile_task_add_cmd
+{
+    uint8_t operation;
+    uint8_t sec_lvl;
+    uint16_t prf_task_id;
+    uint16_t app_task;
+    uint16_t start_hdl;
+    uint32_t param[8];
+};
+void *host_msg_alloc(ke_msg_id_t id);
+void host_msg_send(void *param);
+#define KE_MSG_ALLOC(id, dest, src, type)               ((struct type *)host_msg_alloc(id))
+#define KE_MSG_ALLOC_DYN(id, dest, src, type, len)      ((struct type *)host_msg_alloc(id))
+#define ke_msg_send(param)                              host_msg_send(param)
+""",
+    "app_prf_perm_types.h": """
+#define get_user_prf_srv_perm(task_id)  (0)
+""",
+    "co_math.h": """
+static inline uint32_t co_min(uint32_t a, uint32_t b)
+{
+    return (a < b) ? a : b;
+}
+static inline uint32_t co_max(uint32_t a, uint32_t b)
+{
+    return (a > b) ? a : b;
+}
+""",
+    "spi_flash.h": """
+#include <stdint.h>
+#define SPI_FLASH_SECTOR_SIZE           (4096)
+#define SPI_FLASH_MEM_PROT_NONE         (0)
+#define SPI_FLASH_ERR_OK                (0)
+#define SPI_FLASH_ERR_NOT_ERASED        (-2)
+typedef enum
+{
+    SPI_FLASH_OP_SE = 0x20,
+} spi_flash_op_t;
+int8_t spi_flash_auto_detect(uint8_t *dev_id);
+int8_t spi_flash_power_down(void);
+int8_t spi_flash_release_from_power_down(void);
+int8_t spi_flash_configure_memory_protection(uint8_t data);
+int8_t spi_flash_block_erase(uint32_t address, spi_flash_op_t erase_op);
+int8_t spi_flash_write_data(uint8_t *wr_data_ptr, uint32_t address, uint32_t size, uint32_t *actual_size);
+int8_t spi_flash_read_data(uint8_t *rd_data_ptr, uint32_t address, uint32_t size, uint32_t *actual_size);
+""",
+    "app_task.h": "",
+    "ke_msg.h": "",
+    "attm.h": "",
+    "atts.h": "",
+    "attm_db.h": "",
+}
+
+HARNESS = """
+#include "app_glps.c"
+
+/* SPI flash */
+
+#define FLASH_SIZE      (APP_GLPS_STORE_OFFSET + APP_GLPS_STORE_SECTORS * SPI_FLASH_SECTOR_SIZE)
+
+static uint8_t flash[FLASH_SIZE];
+static bool flash_on;
+static int flash_misuse;
+static long flash_cut = -1;         /* bytes programmed before the power is cut, -1 never */
+static unsigned long flash_read_bytes;
+static unsigned long flash_erases[APP_GLPS_STORE_SECTORS];
+
+int8_t spi_flash_auto_detect(uint8_t *dev_id)
+{
+    *dev_id = 0;
+    flash_misuse += !flash_on;
+    return SPI_FLASH_ERR_OK;
+}
+
+int8_t spi_flash_power_down(void)
+{
+    flash_on = false;
+    return SPI_FLASH_ERR_OK;
+}
+
+int8_t spi_flash_release_from_power_down(void)
+{
+    flash_on = true;
+    return SPI_FLASH_ERR_OK;
+}
+
+int8_t spi_flash_configure_memory_protection(uint8_t data)
+{
+    flash_misuse += !flash_on;
+    return SPI_FLASH_ERR_OK;
+}
+
+int8_t spi_flash_block_erase(uint32_t address, spi_flash_op_t erase_op)
+{
+    flash_misuse += !flash_on || (address % SPI_FLASH_SECTOR_SIZE) || (address + SPI_FLASH_SECTOR_SIZE > FLASH_SIZE);
+    if (flash_cut == 0)
+    {
+        return -1;
+    }
+    memset(&flash[address], 0xFF, SPI_FLASH_SECTOR_SIZE);
+    flash_erases[(address - APP_GLPS_STORE_OFFSET) / SPI_FLASH_SECTOR_SIZE]++;
+    return SPI_FLASH_ERR_OK;
+}
+
+int8_t spi_flash_write_data(uint8_t *wr_data_ptr, uint32_t address, uint32_t size, uint32_t *actual_size)
+{
+    uint32_t i;
+
+    flash_misuse += !flash_on || (address < APP_GLPS_STORE_OFFSET) || (address + size > FLASH_SIZE);
+    for (i = 0; i < size; i++)
+    {
+        if (flash_cut == 0)
+        {
+            *actual_size = i;
+            return -1;
+        }
+        if (flash_cut > 0)
+        {
+            flash_cut--;
+        }
+        flash[address + i] &= wr_data_ptr[i];
+    }
+    *actual_size = size;
+    return SPI_FLASH_ERR_OK;
+}
+
+int8_t spi_flash_read_data(uint8_t *rd_data_ptr, uint32_t address, uint32_t size, uint32_t *actual_size)
+{
+    flash_misuse += !flash_on || (address < APP_GLPS_STORE_OFFSET) || (address + size > FLASH_SIZE);
+    memcpy(rd_data_ptr, &flash[address], size);
+    flash_read_bytes += size;
+    *actual_size = size;
+    return SPI_FLASH_ERR_OK;
+}
+
+/* Kernel messages */
+
+struct host_msg
+{
+    uint16_t id;
+    uint16_t seq_num;
+    uint16_t num_of_record;
+    uint16_t concentration;
+    uint8_t op_code;
+    uint8_t status;
+    uint8_t ctx_follows;
+    uint8_t carbo_id;
+};
+
+#define HOST_MSG_MAX    (4)
+
+struct glps_env_tag glps_env_data;
+static ke_msg_id_t msg_id;
+static uint32_t msg_param[64];
+static struct host_msg msgs[HOST_MSG_MAX];
+static int msg_nb;
+
+void *host_msg_alloc(ke_msg_id_t id)
+{
+    msg_id = id;
+    memset(msg_param, 0, sizeof(msg_param));
+    return msg_param;
+}
+
+void host_msg_send(void *param)
+{
+    struct host_msg *msg = &msgs[msg_nb++ % HOST_MSG_MAX];
+
+    memset(msg, 0, sizeof(*msg));
+    msg->id = msg_id;
+
+    switch (msg_id)
+    {
+        case GLPS_SEND_RACP_RSP_CMD:
+        {
+            struct glps_send_racp_rsp_cmd *cmd = param;
+            msg->op_code = cmd->op_code;
+            msg->status = cmd->status;
+            msg->num_of_record = cmd->num_of_record;
+        } break;
+
+        case GLPS_SEND_MEAS_WITH_CTX_CMD:
+        {
+            struct glps_send_meas_with_ctx_cmd *cmd = param;
+            msg->seq_num = cmd->seq_num;
+            msg->concentration = cmd->meas.concentration;
+            msg->ctx_follows = (cmd->meas.flags & GLP_MEAS_CTX_INF_FOLW) != 0;
+            msg->carbo_id = cmd->ctx.carbo_id;
+        } break;
+
+        case GLPS_SEND_MEAS_WITHOUT_CTX_CMD:
+        {
+            struct glps_send_meas_without_ctx_cmd *cmd = param;
+            msg->seq_num = cmd->seq_num;
+            msg->concentration = cmd->meas.concentration;
+            msg->ctx_follows = (cmd->meas.flags & GLP_MEAS_CTX_INF_FOLW) != 0;
+        } break;
+
+        default:
+            break;
+    }
+}
+
+/* Messages sent since the last call, the last one copied */
+int msg_take(struct host_msg *msg)
+{
+    int nb = msg_nb;
+
+    if (nb > 0)
+    {
+        *msg = msgs[(nb - 1) % HOST_MSG_MAX];
+    }
+    msg_nb = 0;
+    return nb;
+}
+
+/* Test interface */
+
+int flash_state(void)
+{
+    return flash_misuse | (flash_on << 8);
+}
+
+void flash_set_cut(long bytes)
+{
+    flash_cut = bytes;
+}
+
+unsigned long flash_reads(void)
+{
+    return flash_read_bytes;
+}
+
+unsigned long flash_sector_erases(int sector)
+{
+    return flash_erases[sector];
+}
+
+void flash_wipe(void)
+{
+    memset(flash, 0xFF, sizeof(flash));
+}
+
+int store_state(int which)
+{
+    return (which == 0) ? glps_store_env.nb_sectors : (which == 1) ? glps_store_env.next_seq :
+           glps_store_env.count;
+}
+
+int store_geometry(int which)
+{
+    return (which == 0) ? (int)GLPS_STORE_RECS : (which == 1) ? APP_GLPS_STORE_SECTORS :
+           (which == 2) ? (int)GLPS_STORE_HDR_LEN : (int)GLPS_STORE_REC_LEN;
+}
+
+/* Reset, the retention memory is lost */
+void reset(void)
+{
+    memset(&glps_store_env, 0, sizeof(glps_store_env));
+    memset(&app_glps_env, 0, sizeof(app_glps_env));
+    flash_cut = -1;
+    flash_on = false;
+}
+
+/* Index of a sector in use: first_seq, used, live, sorted, last_time, min_time, max_time */
+void store_idx(int order, uint32_t *out, uint8_t *live_map)
+{
+    const struct glps_store_idx *idx = &glps_store_env.idx[glps_store_sector(order)];
+
+    out[0] = idx->first_seq;
+    out[1] = idx->used;
+    out[2] = idx->live;
+    out[3] = idx->sorted;
+    out[4] = idx->last_time;
+    out[5] = idx->min_time;
+    out[6] = idx->max_time;
+    memcpy(live_map, idx->live_map, sizeof(idx->live_map));
+}
+
+int add(const uint16_t *date, int16_t offset, uint16_t concentration, uint8_t carbo_id, uint16_t *seq_num)
+{
+    struct glp_meas meas;
+    struct glp_meas_ctx ctx;
+
+    memset(&meas, 0, sizeof(meas));
+    meas.base_time.year = date[0];
+    meas.base_time.month = date[1];
+    meas.base_time.day = date[2];
+    meas.base_time.hour = date[3];
+    meas.base_time.min = date[4];
+    meas.base_time.sec = date[5];
+    meas.time_offset = offset;
+    meas.concentration = concentration;
+    meas.flags = GLP_MEAS_GL_CTR_TYPE_AND_SPL_LOC_PRES | ((offset != 0) ? GLP_MEAS_TIME_OFF_PRES : 0);
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.carbo_id = carbo_id;
+    ctx.flags = GLP_CTX_CRBH_ID_AND_CRBH_PRES;
+
+    return app_glps_store_add(&meas, (carbo_id != 0) ? &ctx : NULL, seq_num);
+}
+
+static void set_date(struct prf_date_time *time, const uint16_t *date)
+{
+    time->year = date[0];
+    time->month = date[1];
+    time->day = date[2];
+    time->hour = date[3];
+    time->min = date[4];
+    time->sec = date[5];
+}
+
+void racp(uint8_t op_code, uint8_t operator, uint8_t filter_type, uint16_t min, uint16_t max,
+          const uint16_t *date_min, const uint16_t *date_max)
+{
+    struct glp_racp_req req;
+
+    memset(&req, 0, sizeof(req));
+    req.op_code = op_code;
+    req.filter.operator = operator;
+    req.filter.filter_type = filter_type;
+    if (filter_type == GLP_FILTER_USER_FACING_TIME)
+    {
+        set_date(&req.filter.val.time.facetime_min, date_min);
+        set_date(&req.filter.val.time.facetime_max, date_max);
+    }
+    else
+    {
+        req.filter.val.seq_num.min = min;
+        req.filter.val.seq_num.max = max;
+    }
+
+    app_glps_racp_req(0, &req);
+}
+
+int ctx_ntf_cfg(void)
+{
+    return GLPS_MEAS_CTX_NTF_CFG;
+}
+
+int msg_ids(int which)
+{
+    return (which == 0) ? GLPS_SEND_RACP_RSP_CMD : (which == 1) ? GLPS_SEND_MEAS_WITH_CTX_CMD :
+           GLPS_SEND_MEAS_WITHOUT_CTX_CMD;
+}
+"""
+
+# glp_common.h
+REQ_REP, REQ_DEL, REQ_ABORT, REQ_NUM = 1, 2, 3, 4
+OP_ALL, OP_LE, OP_GE, OP_RANGE, OP_FIRST, OP_LAST = 1, 2, 3, 4, 5, 6
+RSP_SUCCESS, RSP_OP_CODE_NOT_SUP, RSP_OPERATOR_NOT_SUP, RSP_INVALID_OPERAND = 1, 2, 4, 5
+RSP_NO_RECS, RSP_NOT_COMPLETED, RSP_OPERAND_NOT_SUP = 6, 8, 9
+FILTER_SEQ, FILTER_TIME = 1, 2
+
+EPOCH = datetime.datetime(2000, 1, 1)
+Date = ctypes.c_uint16 * 6
+
+
+class Msg(ctypes.Structure):
+    _fields_ = [("id", ctypes.c_uint16), ("seq_num", ctypes.c_uint16), ("num_of_record", ctypes.c_uint16),
+                ("concentration", ctypes.c_uint16), ("op_code", ctypes.c_uint8), ("status", ctypes.c_uint8),
+                ("ctx_follows", ctypes.c_uint8), ("carbo_id", ctypes.c_uint8)]
+
+
+def build(sectors):
+    glp = os.path.join(host_c.PROFILES, "glp")
+    lib = host_c.build("glps_store_test", HARNESS, stubs=STUBS, defines={"APP_GLPS_STORE_SECTORS": sectors},
+                       includes=[os.path.join(host_c.APP_MODULES, "src", "app_glps"),
+                                 os.path.join(host_c.APP_MODULES, "api"), host_c.PROFILES, glp,
+                                 os.path.join(glp, "glps", "api")])
+    lib.add.argtypes = [Date, ctypes.c_int16, ctypes.c_uint16, ctypes.c_uint8, ctypes.POINTER(ctypes.c_uint16)]
+    lib.racp.argtypes = [ctypes.c_uint8, ctypes.c_uint8, ctypes.c_uint8, ctypes.c_uint16, ctypes.c_uint16,
+                         Date, Date]
+    lib.msg_take.argtypes = [ctypes.POINTER(Msg)]
+    lib.flash_set_cut.argtypes = [ctypes.c_long]
+    lib.flash_reads.restype = ctypes.c_ulong
+    lib.flash_sector_erases.restype = ctypes.c_ulong
+    lib.store_idx.argtypes = [ctypes.c_int, ctypes.POINTER(ctypes.c_uint32), ctypes.POINTER(ctypes.c_uint8)]
+    lib.app_glps_meas_sent.argtypes = [ctypes.c_uint8, ctypes.c_uint8]
+    lib.app_glps_cfg_ind.argtypes = [ctypes.c_uint16]
+    return lib
+
+
+def seconds(date):
+    return int((datetime.datetime(*date) - EPOCH).total_seconds())
+
+
+class Record:
+    def __init__(self, seq, date, offset, concentration, carbo_id):
+        self.seq = seq
+        self.date = date
+        self.time = seconds(date) + offset * 60
+        self.offset = offset
+        self.concentration = concentration
+        self.carbo_id = carbo_id
+        self.live = True
+
+
+# Slots of a failed write, programmed in part or not at all
+LOST, ERASED = "lost", "erased"
+
+
+class Model:
+    """Ring of sectors of app_glps.c, a slot holds a Record, LOST or ERASED."""
+
+    def __init__(self, recs, sectors, hdr_len, rec_len):
+        self.recs = recs
+        self.max_sectors = sectors
+        self.hdr_len = hdr_len
+        self.rec_len = rec_len
+        self.sectors = []
+        self.next_seq = 0
+        self.stale = False
+
+    def live(self):
+        return [r for s in self.sectors for r in s[1] if isinstance(r, Record) and r.live]
+
+    def needs_sector(self):
+        return not self.sectors or len(self.sectors[-1][1]) == self.recs
+
+    def new_sector(self):
+        if len(self.sectors) == self.max_sectors:
+            self.sectors.pop(0)
+        self.sectors.append((self.next_seq, []))
+
+    def add(self, date, offset, concentration, carbo_id, cut=None):
+        """Stores a record, cut is the number of bytes programmed before the write fails."""
+        if self.needs_sector():
+            if cut == 0:
+                # The erase did not start, the oldest sector dropped from memory is still
+                # in the flash
+                self.stale = len(self.sectors) == self.max_sectors
+                return None
+            if len(self.sectors) == self.max_sectors:
+                self.sectors.pop(0)
+            if cut is not None and cut < self.hdr_len:
+                # The magic is programmed last
+                return None
+            self.sectors.append((self.next_seq, []))
+            if cut is not None:
+                cut -= self.hdr_len
+        first_seq, slots = self.sectors[-1]
+        rec = Record(first_seq + len(slots), date, offset, concentration, carbo_id)
+        self.next_seq = rec.seq + 1
+        slots.append(rec if cut is None else LOST if cut > 0 else ERASED)
+        return rec if cut is None else None
+
+    def reset(self):
+        """Index rebuilt from the flash, returns False if it differs from the one in memory."""
+        same = not self.stale
+        self.stale = False
+        for _, slots in self.sectors:
+            while slots and slots[-1] is ERASED:
+                slots.pop()
+                same = False
+        if self.sectors:
+            self.next_seq = self.sectors[-1][0] + len(self.sectors[-1][1])
+        return same
+
+    def edge(self, last):
+        live = self.live()
+        return (live[-1] if last else live[0]).seq if live else None
+
+    def select(self, operator, filter_type, lo, hi):
+        """Records selected by a filter, or the RACP response code."""
+        live = self.live()
+        if operator == OP_ALL:
+            return live
+        if operator in (OP_FIRST, OP_LAST):
+            seq = self.edge(operator == OP_LAST)
+            return RSP_NO_RECS if seq is None else [r for r in live if r.seq == seq]
+        if operator not in (OP_LE, OP_GE, OP_RANGE):
+            return RSP_OPERATOR_NOT_SUP
+        if filter_type not in (FILTER_SEQ, FILTER_TIME):
+            return RSP_OPERAND_NOT_SUP
+        if operator == OP_LE:
+            lo = 0
+        if operator == OP_GE:
+            hi = 0xFFFF if filter_type == FILTER_SEQ else 1 << 40
+        if lo > hi:
+            return RSP_INVALID_OPERAND
+        key = (lambda r: r.seq) if filter_type == FILTER_SEQ else (lambda r: r.time)
+        return [r for r in live if lo <= key(r) <= hi]
+
+    def delete(self, recs):
+        if len(recs) == len(self.live()):
+            self.sectors = []
+            self.new_sector()
+            return
+        for r in recs:
+            r.live = False
+        while len(self.sectors) > 1 and not any(isinstance(r, Record) and r.live for r in self.sectors[0][1]):
+            self.sectors.pop(0)
+
+
+class Test:
+    def __init__(self, lib, rnd, sectors):
+        self.lib = lib
+        self.rnd = rnd
+        self.model = Model(lib.store_geometry(0), sectors, lib.store_geometry(2), lib.store_geometry(3))
+        self.failures = []
+        self.clock = datetime.datetime(2024, 1, 1)
+        self.ctx_ntf = False
+        self.clock_back = 0.0
+        self.offset = 0
+        self.stats = {"records": 0, "requests": 0, "reported": 0, "deleted": 0, "resets": 0, "cuts": 0, "errors": 0,
+                      "count_requests": 0, "count_reads": 0}
+        self.ids = [lib.msg_ids(i) for i in range(3)]
+
+    def fail(self, what):
+        self.failures.append(what)
+
+    def check_flash(self, what):
+        state = self.lib.flash_state()
+        if state & 0xFF:
+            self.fail("%s: %d flash accesses while powered down" % (what, state & 0xFF))
+        if state >> 8:
+            self.fail("%s: flash left powered" % what)
+
+    def take(self):
+        msg = Msg()
+        nb = self.lib.msg_take(msg)
+        return nb, msg
+
+    def date(self):
+        # Mostly increasing, sometimes the user sets the clock back or changes the time offset
+        if self.rnd.random() < self.clock_back:
+            if self.rnd.random() < 0.5:
+                self.clock -= datetime.timedelta(hours=self.rnd.randrange(1, 72))
+            else:
+                self.offset = self.rnd.choice((0, self.rnd.randrange(-120, 120)))
+        else:
+            self.clock += datetime.timedelta(minutes=self.rnd.randrange(0, 240), seconds=self.rnd.randrange(60))
+        return self.clock.timetuple()[:6]
+
+    def add(self, cut=None):
+        date = self.date()
+        offset = self.offset
+        concentration = self.rnd.randrange(1, 0xFFFF)
+        carbo_id = self.rnd.choice((0, 0, self.rnd.randrange(1, 8)))
+        seq = ctypes.c_uint16(0xFFFF)
+        if cut is not None:
+            self.lib.flash_set_cut(cut)
+        ok = self.lib.add(Date(*date), offset, concentration, carbo_id, ctypes.byref(seq))
+        rec = self.model.add(date, offset, concentration, carbo_id, cut)
+        self.check_flash("add")
+        if cut is not None:
+            if ok:
+                self.fail("add with the power cut after %d bytes succeeded" % cut)
+            return
+        self.stats["records"] += 1
+        if not ok or seq.value != rec.seq:
+            self.fail("add: %s, sequence number %d, model %d" % (ok, seq.value, rec.seq))
+
+    def date_of(self, time):
+        return (EPOCH + datetime.timedelta(seconds=time)).timetuple()[:6]
+
+    def filter(self):
+        """Random RACP filter, the bounds are taken around the stored records."""
+        operator = self.rnd.choice((OP_ALL, OP_LE, OP_GE, OP_RANGE, OP_RANGE, OP_FIRST, OP_LAST, 7))
+        filter_type = self.rnd.choice((FILTER_SEQ, FILTER_SEQ, FILTER_TIME, FILTER_TIME, FILTER_TIME, 3))
+        live = self.model.live()
+        if filter_type == FILTER_TIME:
+            times = [r.time for r in live] or [seconds(self.clock.timetuple()[:6])]
+            a, b = self.rnd.choice(times), self.rnd.choice(times)
+            a += self.rnd.choice((0, 0, -1, 1, -3600))
+            b += self.rnd.choice((0, 0, -1, 1, 3600))
+            if self.rnd.random() < 0.9:
+                a, b = min(a, b), max(a, b)
+            a, b = max(a, 0), max(b, 0)
+            return operator, filter_type, a, b, Date(*self.date_of(a)), Date(*self.date_of(b))
+        seqs = [r.seq for r in live] or [self.model.next_seq]
+        a = max(0, self.rnd.choice(seqs) + self.rnd.choice((0, 0, -1, 1, -50)))
+        b = min(0xFFFF, max(0, self.rnd.choice(seqs) + self.rnd.choice((0, 0, -1, 1, 50))))
+        if self.rnd.random() < 0.9:
+            a, b = min(a, b), max(a, b)
+        return operator, filter_type, a, b, Date(), Date()
+
+    def request(self, op_code):
+        operator, filter_type, a, b, date_min, date_max = self.filter()
+        what = "op %d operator %d filter %d [%d, %d]" % (op_code, operator, filter_type, a, b)
+        expected = self.model.select(operator, filter_type, a, b)
+        seq_min = a if filter_type == FILTER_SEQ else 0
+        seq_max = b if filter_type == FILTER_SEQ else 0
+        reads = self.lib.flash_reads()
+        self.lib.racp(op_code, operator, filter_type, seq_min, seq_max, date_min, date_max)
+        self.stats["requests"] += 1
+
+        if op_code == REQ_REP and isinstance(expected, list) and expected:
+            self.report(expected, what)
+        else:
+            status = expected if not isinstance(expected, list) else RSP_SUCCESS
+            num = 0
+            if isinstance(expected, list):
+                if op_code == REQ_NUM:
+                    num = len(expected)
+                    self.stats["count_requests"] += 1
+                    self.stats["count_reads"] += self.lib.flash_reads() - reads
+                elif op_code not in (REQ_REP, REQ_DEL):
+                    status = RSP_OP_CODE_NOT_SUP
+                elif not expected:
+                    status = RSP_NO_RECS
+                elif op_code == REQ_DEL:
+                    self.model.delete(expected)
+                    self.stats["deleted"] += len(expected)
+            self.expect_rsp(op_code, status, num, what)
+        self.check_flash(what)
+
+    def expect_rsp(self, op_code, status, num, what):
+        nb, msg = self.take()
+        got = (nb, msg.id, msg.op_code, msg.status, msg.num_of_record)
+        if got != (1, self.ids[0], op_code, status, num):
+            self.fail("%s: response %s, expected op %d status %d num %d" % (what, got, op_code, status, num))
+
+    def report(self, expected, what):
+        abort = self.rnd.randrange(len(expected) + 1) if self.rnd.random() < 0.1 else None
+        error = self.rnd.randrange(len(expected) + 1) if abort is None and self.rnd.random() < 0.05 else None
+        for i, rec in enumerate(expected):
+            nb, msg = self.take()
+            with_ctx = rec.carbo_id != 0 and self.ctx_ntf
+            got = (nb, msg.id, msg.seq_num, msg.concentration, msg.ctx_follows, msg.carbo_id)
+            want = (1, self.ids[1 if with_ctx else 2], rec.seq, rec.concentration, int(with_ctx),
+                    rec.carbo_id if with_ctx else 0)
+            if got != want:
+                self.fail("%s: record %d %s, expected %s" % (what, i, got, want))
+                return
+            self.stats["reported"] += 1
+            if i == abort:
+                self.lib.racp(REQ_ABORT, 0, 0, 0, 0, Date(), Date())
+                self.expect_rsp(REQ_ABORT, RSP_SUCCESS, 0, what + " abort")
+                self.lib.app_glps_meas_sent(0, 0)
+                nb, _ = self.take()
+                if nb:
+                    self.fail("%s: %d messages after the abort" % (what, nb))
+                return
+            if i == error:
+                self.lib.app_glps_meas_sent(0, 0x44)
+                self.expect_rsp(REQ_REP, RSP_NOT_COMPLETED, 0, what + " error")
+                return
+            self.lib.app_glps_meas_sent(0, 0)
+        self.expect_rsp(REQ_REP, RSP_SUCCESS, 0, what)
+
+    def snapshot(self):
+        """Index of the sectors in use, the time range of each one apart."""
+        index, ranges = [self.lib.store_state(i) for i in range(3)], []
+        for order in range(index[0]):
+            out, live_map = (ctypes.c_uint32 * 7)(), (ctypes.c_uint8 * 32)()
+            self.lib.store_idx(order, out, live_map)
+            index.append((tuple(out[:5]), bytes(live_map)))
+            ranges.append((out[5], out[6]))
+        return index, ranges
+
+    def reset(self):
+        before = self.snapshot()
+        compare = self.model.reset()
+        self.lib.reset()
+        self.stats["resets"] += 1
+        self.set_cfg(self.rnd.random() < 0.5)
+        count = self.lib.app_glps_store_count()
+        self.check_flash("reset")
+        after = self.snapshot()
+        # Deleting records does not narrow the time range of their sector
+        if compare and (after[0] != before[0] or
+                        any(a[0] < b[0] or a[1] > b[1] for a, b in zip(after[1], before[1]))):
+            self.fail("index rebuilt from the flash differs from the one in retention memory")
+        if count != len(self.model.live()):
+            self.fail("reset: %d records, model %d" % (count, len(self.model.live())))
+
+    def power_cut(self):
+        if self.model.needs_sector():
+            cut = self.rnd.randrange(0, self.model.hdr_len + self.model.rec_len)
+        else:
+            cut = self.rnd.randrange(0, self.model.rec_len)
+        self.add(cut)
+        self.stats["cuts"] += 1
+        self.reset()
+
+    def write_error(self):
+        # The device goes on, the erase of a new sector is not failed as the sector
+        # dropped from memory would come back on the next reset
+        if self.model.needs_sector():
+            cut = self.rnd.randrange(self.model.hdr_len, self.model.hdr_len + self.model.rec_len)
+        else:
+            cut = self.rnd.choice((0, self.rnd.randrange(1, self.model.rec_len)))
+        self.add(cut)
+        self.lib.flash_set_cut(-1)
+        self.stats["errors"] += 1
+        if self.rnd.random() < 0.5:
+            # Check the index of the sector against the one rebuilt from the flash
+            for _ in range(self.rnd.randrange(0, 4)):
+                self.add()
+            self.reset()
+
+    def set_cfg(self, ctx_ntf):
+        self.ctx_ntf = ctx_ntf
+        self.lib.app_glps_cfg_ind(self.lib.ctx_ntf_cfg() if ctx_ntf else 0)
+
+    def run(self, records):
+        self.lib.flash_wipe()
+        self.lib.reset()
+        if self.lib.app_glps_store_count() != 0:
+            self.fail("blank flash holds records")
+        self.set_cfg(True)
+        while self.stats["records"] < records and not self.failures:
+            # Phases where the clock is set back more or less often, down to sorted sectors
+            if self.rnd.random() < 0.02:
+                self.clock_back = self.rnd.choice((0.0, 0.0, 0.002, 0.02, 0.2))
+            for _ in range(self.rnd.randrange(1, 60)):
+                self.add()
+            for _ in range(self.rnd.randrange(0, 4)):
+                op = self.rnd.choice((REQ_NUM, REQ_NUM, REQ_REP, REQ_REP, REQ_DEL, 9))
+                if op == REQ_DEL and self.rnd.random() < 0.7:
+                    continue
+                self.request(op if op != 9 else self.rnd.choice((0, 5, 7)))
+            state = (self.lib.app_glps_store_count(), self.lib.store_state(0), self.lib.store_state(1))
+            model = (len(self.model.live()), len(self.model.sectors), self.model.next_seq)
+            if state != model:
+                self.fail("records, sectors, next sequence number %s, model %s" % (state, model))
+            r = self.rnd.random()
+            if r < 0.05:
+                self.reset()
+            elif r < 0.10:
+                self.power_cut()
+            elif r < 0.13:
+                self.write_error()
+            elif r < 0.14:
+                self.set_cfg(not self.ctx_ntf)
+            elif r < 0.145:
+                self.lib.app_glps_store_clear()
+                self.model.sectors = []
+                self.model.new_sector()
+                self.check_flash("clear")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--records", type=int, default=20000, help="measurements stored")
+    parser.add_argument("--sectors", type=int, default=4, help="APP_GLPS_STORE_SECTORS")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    lib = build(args.sectors)
+    test = Test(lib, random.Random(args.seed), args.sectors)
+    test.run(args.records)
+
+    s = test.stats
+    print("%d sectors of %d records: %d stored, %d RACP requests, %d reported, %d deleted, "
+          "%d resets, %d power cuts, %d write errors"
+          % (args.sectors, lib.store_geometry(0), s["records"], s["requests"], s["reported"], s["deleted"],
+             s["resets"], s["cuts"], s["errors"]))
+    if s["count_requests"]:
+        print("count requests: %.0f flash bytes read on average"
+              % (float(s["count_reads"]) / s["count_requests"]))
+    print("sector erases: %s" % " ".join(str(lib.flash_sector_erases(i)) for i in range(args.sectors)))
+
+    return host_c.report(test.failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
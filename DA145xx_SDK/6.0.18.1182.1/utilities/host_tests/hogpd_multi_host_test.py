@@ -0,0 +1,583 @@
+#!/usr/bin/env python3
+"""
+Host test of the report routing and the per-link report FIFOs of the multi-host HID
+application, app_hogpd.c of the HID-Gamepad-Digitizer example.
+
+app_hogpd.c is built unmodified with the real HOGPD headers and stubbed kernel, profile
+and application layers. HOGPD is emulated as the profile task is: HOGPD_REPORT_UPD_REQ
+messages are served one at a time in the order they were sent, each one answered by
+app_hogpd_report_upd_rsp() on its link.
+
+Hosts connect and disconnect at random, change the notification configuration of their
+reports and are selected as the active host, while input reports are sent and served
+and message allocations fail now and then. Every build of APP_EASY_MAX_ACTIVE_CONNECTION
+1 to 3 runs the three routings. The checks:
+
+- a report goes to the hosts selected by the routing, the active host or every host
+  that enabled its notifications, and to no other host
+- a report is taken by all the selected hosts or by none, and only refused when no host
+  is selected or the FIFO of a selected host is full
+- every host receives the reports taken for it once, in order, until it disconnects
+- with several connections, a link never holds more than HID_REPORT_LINK_IN_FLIGHT_MAX
+  requests in HOGPD, even while it is the only one connected
+- the first report after a host switch has at most HID_REPORT_LINK_IN_FLIGHT_MAX
+  requests of each other host ahead of it in HOGPD
+- the protocol mode is kept per connection
+- a report for a selected host is reported to the connection parameter controller as
+  traffic
+
+    hogpd_multi_host_test.py
+    hogpd_multi_host_test.py --steps 200000 --seed 7
+"""
+
+import argparse
+import ctypes
+import os
+import random
+import sys
+
+import host_c
+
+HOGP = os.path.join(host_c.PROFILES, "hogp")
+
+ROUTINGS = ("broadcast", "active host", "hotkey")
+REPORT_NTF_EN = 0x40
+HOGPD_REPORT = 0
+HOGPD_BOOT_KEYBOARD_INPUT_REPORT = 2
+NB_REPORTS = 3
+
+STUBS = {
+    "rwip_config.h": """
+#ifndef RWIP_CONFIG_H_
+#define RWIP_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#define BLE_HID_DEVICE          1
+#define BLE_HID_BOOT_HOST       0
+#define BLE_HID_REPORT_HOST     0
+#define BLE_CONNECTION_MAX      3
+#define __SECTION_ZERO(name)
+#define __ARRAY_EMPTY
+#endif
+""",
+    "ke_task.h": """
+#ifndef KE_TASK_H_
+#define KE_TASK_H_
+#include <stdint.h>
+typedef uint16_t ke_task_id_t;
+typedef uint16_t ke_msg_id_t;
+typedef uint8_t ke_state_t;
+#define KE_FIRST_MSG(task)      ((ke_msg_id_t)((task) << 8))
+#define TASK_ID_HOGPD           (30)
+#define TASK_APP                (1)
+#define TASK_GAPM               (2)
+#endif
+""",
+    "prf.h": """
+#include "ke_task.h"
+typedef struct
+{
+    ke_task_id_t prf_task;
+} prf_env_t;
+struct prf_task_cbs;
+""",
+    "prf_types.h": "#include \"ke_task.h\"\n",
+    "attm_cfg.h": "",
+    "prf_utils.h": """
+#include "ke_task.h"
+void *harness_msg_alloc(ke_msg_id_t id, size_t size);
+void ke_msg_send(void const *param);
+#define KE_MSG_ALLOC(id, dest, src, type)   ((struct type *) harness_msg_alloc(id, sizeof(struct type)))
+#define KE_MSG_ALLOC_DYN(id, dest, src, type, len) \\
+    ((struct type *) harness_msg_alloc(id, sizeof(struct type) + (len)))
+#define prf_get_task_from_id(id)            (id)
+void *harness_prf_env(void);
+#define PRF_ENV_GET(prf, type)              ((struct type ## _env_tag *) harness_prf_env())
+""",
+    "app.h": """
+#include <stdint.h>
+#include <stdbool.h>
+#include "ke_task.h"
+#define GAP_INVALID_CONIDX      (0xFF)
+#define GAPM_PROFILE_TASK_ADD   (0x1B)
+struct app_env_tag
+{
+    bool connection_active;
+};
+extern struct app_env_tag app_env[];
+struct gapm_profile_task_add_cmd
+{
+    uint8_t operation;
+    uint8_t sec_lvl;
+    uint16_t prf_task_id;
+    uint16_t app_task;
+    uint16_t start_hdl;
+    uint32_t param[];
+};
+#define GAPM_PROFILE_TASK_ADD_CMD   (0x0D1B)
+uint8_t get_user_prf_srv_perm(uint16_t task_id);
+#define ASSERT_WARNING(cond)
+#define ASSERT_ERROR(cond)
+""",
+    "app_prf_perm_types.h": "",
+    "arch_console.h": "#define arch_printf(...)\n",
+    "user_trace.h": "#define user_trace_report_queued(queued)\n",
+    "user_heap_mon.h": "#define user_heap_mon_alloc_failed(site)\n",
+    "user_conn_ctrl.h": "extern int traffic_ind;\n#define user_conn_ctrl_traffic_ind() (traffic_ind++)\n",
+    "user_hogpd_config.h": """
+#include "app_hogpd_defs.h"
+#include "hogpd.h"
+#include "hogpd_task.h"
+#define HID_NUM_OF_REPORTS  3
+static const hogpd_reports_t hogpd_reports[HID_NUM_OF_REPORTS] =
+{
+    {.id = 1, .size = 8, .cfg = HOGPD_CFG_REPORT_IN | HOGPD_REPORT_NTF_CFG_MASK | HOGPD_CFG_REPORT_WR},
+    {.id = 2, .size = 8, .cfg = HOGPD_CFG_REPORT_IN | HOGPD_REPORT_NTF_CFG_MASK | HOGPD_CFG_REPORT_WR},
+    {.id = 3, .size = 2, .cfg = HOGPD_CFG_REPORT_IN | HOGPD_REPORT_NTF_CFG_MASK | HOGPD_CFG_REPORT_WR},
+};
+// Not const, the test changes the routing
+static hogpd_params_t hogpd_params = {
+    .boot_protocol_mode = true,
+    .host_routing       = APP_HOGPD_ROUTE_BROADCAST,
+};
+""",
+}
+
+HARNESS = r"""
+#include "app_hogpd.c"
+#include <stdlib.h>
+
+struct app_env_tag app_env[APP_EASY_MAX_ACTIVE_CONNECTION];
+
+struct msg_hdr
+{
+    ke_msg_id_t id;
+    size_t size;
+};
+
+// The HOGPD requests, served in order
+struct hogpd_req
+{
+    uint8_t conidx;
+    uint8_t idx;
+    uint8_t type;
+    uint8_t length;
+    uint8_t value[HID_REPORT_MAX_REPORT_SIZE];
+};
+
+#define QUEUE_SIZE  256
+static struct hogpd_req queue[QUEUE_SIZE];
+static int queue_head, queue_cnt;
+
+static struct hogpd_env_tag hogpd_env;
+
+int alloc_fail;
+int traffic_ind;
+int in_flight_violations;
+int in_flight_max;
+uint16_t enable_ntf[APP_EASY_MAX_ACTIVE_CONNECTION];
+
+void *harness_prf_env(void)
+{
+    return &hogpd_env;
+}
+
+uint8_t get_user_prf_srv_perm(uint16_t task_id)
+{
+    return 0;
+}
+
+uint16_t hogpd_get_att_handle(struct hogpd_env_tag *env, uint8_t svc_idx, uint8_t att_idx, uint8_t report_idx)
+{
+    return 0;
+}
+
+void *harness_msg_alloc(ke_msg_id_t id, size_t size)
+{
+    struct msg_hdr *hdr;
+
+    if (id == HOGPD_REPORT_UPD_REQ && alloc_fail)
+    {
+        alloc_fail--;
+        return NULL;
+    }
+    hdr = calloc(1, sizeof(struct msg_hdr) + size);
+    hdr->id = id;
+    hdr->size = size;
+    return hdr + 1;
+}
+
+static int queued_for(int conidx)
+{
+    int n = 0;
+    int i;
+
+    for (i = 0; i < queue_cnt; i++)
+    {
+        n += queue[(queue_head + i) % QUEUE_SIZE].conidx == conidx;
+    }
+    return n;
+}
+
+void ke_msg_send(void const *param)
+{
+    struct msg_hdr *hdr = (struct msg_hdr *) param - 1;
+
+    if (hdr->id == HOGPD_REPORT_UPD_REQ)
+    {
+        const struct hogpd_report_upd_req *req = param;
+        struct hogpd_req *q = &queue[(queue_head + queue_cnt) % QUEUE_SIZE];
+        int n = queued_for(req->conidx) + 1;
+
+        if (n > in_flight_max)
+        {
+            in_flight_max = n;
+        }
+        if (APP_EASY_MAX_ACTIVE_CONNECTION > 1 && n > HID_REPORT_LINK_IN_FLIGHT_MAX)
+        {
+            in_flight_violations++;
+        }
+        q->conidx = req->conidx;
+        q->idx = req->report.idx;
+        q->type = req->report.type;
+        q->length = req->report.length;
+        memcpy(q->value, req->report.value, req->report.length);
+        queue_cnt++;
+    }
+    else if (hdr->id == HOGPD_ENABLE_REQ)
+    {
+        const struct hogpd_enable_req *req = param;
+        enable_ntf[req->conidx] = req->ntf_cfg[0];
+    }
+    free(hdr);
+}
+
+void host_connect(uint8_t conidx)
+{
+    app_env[conidx].connection_active = true;
+    app_hogpd_enable(conidx);
+}
+
+// The requests of a link that disconnects are dropped by HOGPD without a response
+void host_disconnect(uint8_t conidx)
+{
+    int i, n = 0;
+
+    app_env[conidx].connection_active = false;
+    for (i = 0; i < queue_cnt; i++)
+    {
+        struct hogpd_req *q = &queue[(queue_head + i) % QUEUE_SIZE];
+        if (q->conidx != conidx)
+        {
+            queue[(queue_head + n++) % QUEUE_SIZE] = *q;
+        }
+    }
+    queue_cnt = n;
+}
+
+// Serves the oldest HOGPD request, returns its link and copies the report
+int hogpd_serve(uint8_t *idx, uint8_t *type, uint8_t *value, uint8_t *length)
+{
+    struct hogpd_req q;
+
+    if (queue_cnt == 0)
+    {
+        return -1;
+    }
+    q = queue[queue_head];
+    queue_head = (queue_head + 1) % QUEUE_SIZE;
+    queue_cnt--;
+    *idx = q.idx;
+    *type = q.type;
+    *length = q.length;
+    memcpy(value, q.value, q.length);
+    app_hogpd_report_upd_rsp(q.conidx);
+    return q.conidx;
+}
+
+int hogpd_queue_cnt(void)
+{
+    return queue_cnt;
+}
+
+// Requests of other links ahead of the last request of a link, -1 if it has none queued
+int hogpd_ahead_of_last(uint8_t conidx)
+{
+    int i, last = -1, ahead = 0;
+
+    for (i = 0; i < queue_cnt; i++)
+    {
+        if (queue[(queue_head + i) % QUEUE_SIZE].conidx == conidx)
+        {
+            last = i;
+        }
+    }
+    if (last < 0)
+    {
+        return -1;
+    }
+    for (i = 0; i < last; i++)
+    {
+        ahead += queue[(queue_head + i) % QUEUE_SIZE].conidx != conidx;
+    }
+    return ahead;
+}
+
+int link_fifo_cnt(uint8_t conidx)
+{
+    return app_hogpd_links[conidx].fifo_cnt;
+}
+
+void set_routing(uint8_t routing)
+{
+    hogpd_params.host_routing = routing;
+}
+
+void set_proto_mode(uint8_t conidx, uint8_t mode)
+{
+    hogpd_env.svcs[0].proto_mode[conidx] = mode;
+}
+
+int max_connections(void)
+{
+    return APP_EASY_MAX_ACTIVE_CONNECTION;
+}
+
+int fifo_size(void)
+{
+    return HID_REPORT_FIFO_SIZE;
+}
+
+int in_flight_limit(void)
+{
+    return HID_REPORT_LINK_IN_FLIGHT_MAX;
+}
+"""
+
+
+def build(conns):
+    # The quoted includes of app_hogpd.c must find the stubs before the example sources
+    lib = host_c.build("hogpd_multi_host_test", HARNESS, stubs=STUBS,
+                       copies=[os.path.join(host_c.HID_EXAMPLE, "app_hogpd.c")],
+                       defines={"APP_EASY_MAX_ACTIVE_CONNECTION": conns},
+                       includes=[host_c.HID_EXAMPLE, HOGP, os.path.join(HOGP, "hogpd", "api")])
+    lib.app_hogpd_send_report.argtypes = [ctypes.c_uint8, ctypes.c_char_p, ctypes.c_uint16, ctypes.c_int]
+    lib.app_hogpd_send_report.restype = ctypes.c_bool
+    lib.app_hogpd_set_active_host.restype = ctypes.c_bool
+    lib.app_hogpd_get_active_host.restype = ctypes.c_uint8
+    lib.app_hogpd_get_protocol_mode.restype = ctypes.c_uint8
+    lib.app_hogpd_set_report_ntf.argtypes = [ctypes.c_uint8, ctypes.c_uint16]
+    lib.app_hogpd_get_report_ntf.restype = ctypes.c_uint16
+    u8 = ctypes.POINTER(ctypes.c_uint8)
+    lib.hogpd_serve.argtypes = [u8, u8, ctypes.c_char_p, u8]
+    return lib
+
+
+class Test:
+    def __init__(self, lib, rnd, routing):
+        self.lib = lib
+        self.rnd = rnd
+        self.routing = routing
+        self.conns = lib.max_connections()
+        self.fifo_size = lib.fifo_size()
+        self.limit = lib.in_flight_limit()
+        self.up = [False] * self.conns
+        self.ntf = [0] * self.conns
+        self.active = 0
+        self.expected = [[] for _ in range(self.conns)]
+        self.switched = None
+        self.seq = 0
+        self.failures = []
+        self.stats = dict(sent=0, taken=0, no_host=0, full=0, delivered=0, lost=0, alloc_failures=0,
+                          switches=0, switch_ahead_max=0)
+        lib.set_routing(routing)
+
+    def fail(self, what):
+        if len(self.failures) < 100:
+            self.failures.append("%s: %s" % (ROUTINGS[self.routing], what))
+
+    def model_active(self):
+        if self.up[self.active]:
+            return self.active
+        for c in range(self.conns):
+            if self.up[c]:
+                self.active = c
+                return c
+        return None
+
+    def model_mask(self, idx, rtype):
+        if self.routing != 0:
+            c = self.model_active()
+            return set() if c is None else {c}
+        return {c for c in range(self.conns)
+                if self.up[c] and (rtype != HOGPD_REPORT or self.ntf[c] & (REPORT_NTF_EN << idx))}
+
+    def connect(self, c):
+        self.lib.host_connect(c)
+        self.up[c] = True
+        self.ntf[c] = sum(REPORT_NTF_EN << i for i in range(NB_REPORTS))
+        self.expected[c] = []
+        if self.routing == 1 or not self.up[self.active] or self.active == c:
+            self.active = c
+        enabled = (ctypes.c_uint16 * self.conns).in_dll(self.lib, "enable_ntf")[c]
+        if enabled != self.ntf[c] or self.lib.app_hogpd_get_report_ntf(c) != self.ntf[c]:
+            self.fail("host %d: notifications 0x%x enabled after the connection" % (c, enabled))
+
+    def disconnect(self, c):
+        self.lib.host_disconnect(c)
+        self.up[c] = False
+        self.stats["lost"] += len(self.expected[c])
+        self.expected[c] = []
+
+    def send(self):
+        rnd = self.rnd
+        if rnd.random() < 0.1:
+            idx, rtype = 0, HOGPD_BOOT_KEYBOARD_INPUT_REPORT
+        else:
+            idx, rtype = rnd.randrange(NB_REPORTS), HOGPD_REPORT
+        self.seq += 1
+        length = rnd.randint(4, 8)
+        data = (self.seq.to_bytes(4, "little") + bytes(rnd.randrange(256) for _ in range(4)))[:length]
+        if rnd.random() < 0.05:
+            ctypes.c_int.in_dll(self.lib, "alloc_fail").value = rnd.randint(1, 3)
+            self.stats["alloc_failures"] += 1
+        mask = self.model_mask(idx, rtype)
+        traffic = host_c.cint(self.lib, "traffic_ind")
+        traffic.value = 0
+        taken = self.lib.app_hogpd_send_report(idx, data, length, rtype)
+        if bool(mask) != (traffic.value != 0):
+            self.fail("report %d for hosts %s, %d traffic indications" % (self.seq, sorted(mask), traffic.value))
+        ctypes.c_int.in_dll(self.lib, "alloc_fail").value = 0
+        self.stats["sent"] += 1
+        if not mask:
+            self.stats["no_host"] += 1
+            if taken:
+                self.fail("report %d taken without a selected host" % self.seq)
+            return
+        if not taken:
+            self.stats["full"] += 1
+            if not any(self.lib.link_fifo_cnt(c) == self.fifo_size for c in mask):
+                self.fail("report %d refused for hosts %s, no FIFO is full" % (self.seq, sorted(mask)))
+            return
+        self.stats["taken"] += 1
+        for c in mask:
+            self.expected[c].append((idx, rtype, data))
+        if self.switched is not None and self.switched in mask:
+            ahead = self.lib.hogpd_ahead_of_last(self.switched)
+            others = sum(self.up) - 1
+            if ahead >= 0:
+                self.stats["switch_ahead_max"] = max(self.stats["switch_ahead_max"], ahead)
+                if ahead > self.limit * others:
+                    self.fail("first report after the switch to host %d behind %d requests"
+                              % (self.switched, ahead))
+            self.switched = None
+
+    def serve(self):
+        idx, rtype, length = ctypes.c_uint8(), ctypes.c_uint8(), ctypes.c_uint8()
+        value = ctypes.create_string_buffer(8)
+        c = self.lib.hogpd_serve(ctypes.byref(idx), ctypes.byref(rtype), value, ctypes.byref(length))
+        if c < 0:
+            return False
+        got = (idx.value, rtype.value, value.raw[:length.value])
+        if not self.expected[c]:
+            self.fail("host %d: unexpected report %r" % (c, got))
+        elif self.expected[c][0] != got:
+            self.fail("host %d: report %r instead of %r" % (c, got, self.expected[c][0]))
+            self.expected[c].pop(0)
+        else:
+            self.expected[c].pop(0)
+            self.stats["delivered"] += 1
+        return True
+
+    def select(self, c):
+        ok = self.lib.app_hogpd_set_active_host(c)
+        if ok != self.up[c]:
+            self.fail("host %d selected %s while %s" % (c, ok, "connected" if self.up[c] else "disconnected"))
+        if ok:
+            if self.routing != 0 and c != self.model_active():
+                self.stats["switches"] += 1
+                self.switched = c
+            self.active = c
+
+    def step(self):
+        rnd = self.rnd
+        r = rnd.random()
+        if r < 0.45:
+            self.send()
+        elif r < 0.85:
+            self.serve()
+        elif r < 0.88:
+            c = rnd.randrange(self.conns)
+            if self.up[c]:
+                self.disconnect(c)
+            else:
+                self.connect(c)
+        elif r < 0.90:
+            c = rnd.randrange(self.conns)
+            if self.up[c]:
+                ntf = sum(REPORT_NTF_EN << i for i in range(NB_REPORTS) if rnd.random() < 0.7)
+                self.lib.app_hogpd_set_report_ntf(c, ntf)
+                self.ntf[c] = ntf
+        elif r < 0.93:
+            self.select(rnd.randrange(self.conns))
+        active = self.lib.app_hogpd_get_active_host()
+        expected = self.model_active()
+        if active != (0xFF if expected is None else expected):
+            self.fail("active host %d instead of %s" % (active, expected))
+            self.active = active if active != 0xFF else 0
+
+    def flush(self):
+        # Reports left in a FIFO by an allocation failure go out with the next report
+        for _ in range(100):
+            while self.serve():
+                pass
+            if not any(self.expected[c] for c in range(self.conns) if self.up[c]):
+                break
+            self.send()
+        for c in range(self.conns):
+            if self.up[c] and self.expected[c]:
+                self.fail("host %d: %d reports never sent" % (c, len(self.expected[c])))
+
+    def run(self, steps):
+        self.connect(0)
+        for _ in range(steps):
+            self.step()
+        self.flush()
+        violations = ctypes.c_int.in_dll(self.lib, "in_flight_violations").value
+        if violations:
+            self.fail("%d requests beyond HID_REPORT_LINK_IN_FLIGHT_MAX" % violations)
+        for c in range(self.conns):
+            self.lib.set_proto_mode(c, c & 1)
+        for c in range(self.conns):
+            if self.lib.app_hogpd_get_protocol_mode(c) != c & 1:
+                self.fail("host %d: protocol mode of another host" % c)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--steps", type=int, default=30000, help="events per run")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    failures = []
+    for conns in (1, 2, 3):
+        for routing in range(len(ROUTINGS)):
+            lib = build(conns)
+            test = Test(lib, random.Random(args.seed * 10 + conns * 3 + routing), routing)
+            test.run(args.steps)
+            s = test.stats
+            print("%d host%s, %-11s: %6d reports, %6d taken, %5d without host, %4d on a full FIFO, "
+                  "%6d delivered, %4d lost on disconnection, %4d allocation failures, %4d switches "
+                  "(at most %d requests ahead), at most %d requests of a link in HOGPD"
+                  % (conns, "s" if conns > 1 else " ", ROUTINGS[routing], s["sent"], s["taken"], s["no_host"],
+                     s["full"], s["delivered"], s["lost"], s["alloc_failures"], s["switches"],
+                     s["switch_ahead_max"], ctypes.c_int.in_dll(lib, "in_flight_max").value))
+            failures += test.failures
+
+    return host_c.report(failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
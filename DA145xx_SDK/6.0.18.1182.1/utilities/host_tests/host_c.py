@@ -0,0 +1,190 @@
+"""
+Build of the SDK sources the host tests run.
+
+The sources under test are compiled unmodified with the host C compiler ($CC, gcc or cc)
+into a shared library loaded with ctypes. The stub headers of a test are written to a
+temporary directory that comes first in the include path, and the sources whose quoted
+includes must find the stubs before the SDK headers next to them are copied there too.
+A harness written in C by the test includes the sources, emulates what they call and
+exports what the test drives.
+"""
+
+import ctypes
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SDK = os.path.normpath(os.path.join(HERE, "..", ".."))
+SDK_SRC = os.path.join(SDK, "sdk")
+PROFILES = os.path.join(SDK_SRC, "ble_stack", "profiles")
+APP_MODULES = os.path.join(SDK_SRC, "app_modules")
+HID_EXAMPLE = os.path.join(SDK, "projects", "target_apps", "ble_examples", "HID-Gamepad-Digitizer", "src")
+
+# Configuration of the HID-Gamepad-Digitizer example, DA14531 build
+HID_INCLUDES = [
+    HID_EXAMPLE,
+    os.path.join(HID_EXAMPLE, "config"),
+    os.path.join(HID_EXAMPLE, "custom_profile"),
+    os.path.join(HID_EXAMPLE, "platform"),
+    os.path.join(SDK_SRC, "platform", "include", "CMSIS", "5.6.0", "Include"),
+    os.path.join(SDK, "third_party", "irng"),
+]
+
+# Headers of the BLE host layers, for the application modules
+_HOST = os.path.join(SDK_SRC, "ble_stack", "host")
+BLE_HOST_INCLUDES = [os.path.join(_HOST, *sub) for sub in (
+    ("gap",), ("gap", "gapc"), ("gap", "gapm"), ("smp",), ("smp", "smpc"), ("smp", "smpm"), ("l2c",),
+    ("l2c", "l2cc"), ("l2c", "l2cm"), ("att",), ("att", "attm"))] + [
+    os.path.join(SDK_SRC, "ble_stack", "rwble_hl"),
+    os.path.join(SDK_SRC, "platform", "core_modules", "common", "api"),
+]
+
+# The register accesses of the SDK headers go to host_reg_rd() and host_reg_wr() of the
+# harness, which REG_FILE, put before the harness, gives a register file
+DATASHEET_531 = """
+#ifndef _DATASHEET_H_
+#define _DATASHEET_H_
+#include <stdint.h>
+#include "da14531.h"
+#include "core_cm0plus.h"
+#include "system_DA14531.h"
+uint32_t host_reg_rd(uint32_t addr);
+void host_reg_wr(uint32_t addr, uint32_t value);
+#undef SetWord8
+#undef SetWord16
+#undef SetWord32
+#undef GetWord8
+#undef GetWord16
+#undef GetWord32
+#define SetWord8(a,d)   host_reg_wr((uint32_t)(a), (uint8_t)(d))
+#define SetWord16(a,d)  host_reg_wr((uint32_t)(a), (uint16_t)(d))
+#define SetWord32(a,d)  host_reg_wr((uint32_t)(a), (uint32_t)(d))
+#define GetWord8(a)     ((uint8_t)host_reg_rd((uint32_t)(a)))
+#define GetWord16(a)    ((uint16_t)host_reg_rd((uint32_t)(a)))
+#define GetWord32(a)    host_reg_rd((uint32_t)(a))
+#endif
+"""
+
+# The same for the BLE core registers and the exchange memory
+REG_ACCESS = """
+#ifndef REG_ACCESS_H_
+#define REG_ACCESS_H_
+#include <stdint.h>
+#include <string.h>
+#if defined(CFG_EMB)
+#include "co_utils.h"
+#include "em_map.h"
+#endif
+uint32_t host_reg_rd(uint32_t addr);
+void host_reg_wr(uint32_t addr, uint32_t value);
+#define REG_PL_RD(addr)             host_reg_rd((uint32_t)(addr))
+#define REG_PL_WR(addr, value)      host_reg_wr((uint32_t)(addr), (value))
+#define REG_BLE_RD(addr)            host_reg_rd((uint32_t)(addr))
+#define REG_BLE_WR(addr, value)     host_reg_wr((uint32_t)(addr), (value))
+#define EM_BLE_RD(addr)             ((uint16_t)host_reg_rd((uint32_t)(addr)))
+#define EM_BLE_WR(addr, value)      host_reg_wr((uint32_t)(addr), (uint16_t)(value))
+#endif
+"""
+
+REG_FILE = r"""
+#include <stdint.h>
+#include <stdlib.h>
+#ifndef REGS
+#define REGS 16
+#endif
+static uint32_t reg_addr[REGS], reg_val[REGS];
+static int reg_count;
+
+static uint32_t *reg(uint32_t addr)
+{
+    for (int i = 0; i < reg_count; i++)
+        if (reg_addr[i] == addr)
+            return &reg_val[i];
+    if (reg_count == REGS)
+        abort();
+    reg_addr[reg_count] = addr;
+    reg_val[reg_count] = 0;
+    return &reg_val[reg_count++];
+}
+"""
+
+
+def sdk_includes():
+    """Every directory of SDK headers, as the Keil projects list them, but for the other
+    compilers and CMSIS versions."""
+    dirs = []
+    for root, subdirs, files in os.walk(SDK_SRC):
+        subdirs.sort()
+        if os.sep + "CMSIS" in root or os.path.basename(root) in ("ARM", "ARM_clang", "GCC", "IAR"):
+            continue
+        if any(name.endswith(".h") for name in files):
+            dirs.append(root)
+    return dirs
+
+
+def stage(name, harness, stubs=None, empty=(), empty_text="", copies=()):
+    """Write the harness, the stubs and the empty headers to a new directory and copy the
+    files of copies there. Return the directory."""
+    tmp = tempfile.mkdtemp(prefix=name + "_")
+    for header, text in (stubs or {}).items():
+        with open(os.path.join(tmp, header), "w") as f:
+            f.write(text)
+    for header in empty:
+        with open(os.path.join(tmp, header), "w") as f:
+            f.write(empty_text)
+    for path in copies:
+        shutil.copy(path, tmp)
+    with open(os.path.join(tmp, "harness.c"), "w") as f:
+        f.write(harness)
+    return tmp
+
+
+def compile_lib(tmp, name, sources=(), includes=(), defines=None, flags=(), load=True):
+    """Compile harness.c and the sources of tmp (or other paths) into name.so.
+    Return the library, or its path without load."""
+    cc = os.environ.get("CC") or shutil.which("gcc") or shutil.which("cc")
+    if cc is None:
+        sys.exit("no host C compiler found, set CC")
+    out = os.path.join(tmp, name + ".so")
+    cmd = [cc, "-O2", "-shared", "-fPIC", "-w", "-Wl,-z,defs", "-std=gnu99"] + list(flags)
+    for macro, value in (defines or {}).items():
+        cmd.append("-D%s" % macro if value is None else "-D%s=%s" % (macro, value))
+    cmd += ["-I", tmp]
+    for inc in includes:
+        cmd += ["-I", inc]
+    cmd += [os.path.join(tmp, "harness.c")] + [os.path.join(tmp, src) for src in sources]
+    subprocess.check_call(cmd + ["-o", out])
+    return ctypes.CDLL(out) if load else out
+
+
+def build(name, harness, stubs=None, empty=(), empty_text="", copies=(), sources=(), includes=(),
+          defines=None, flags=()):
+    """stage() then compile_lib()."""
+    tmp = stage(name, harness, stubs, empty, empty_text, copies)
+    return compile_lib(tmp, name, sources, includes, defines, flags)
+
+
+def cint(lib, name):
+    """An int variable of the harness."""
+    return ctypes.c_int.in_dll(lib, name)
+
+
+def culong(lib, name):
+    """An unsigned long variable of the harness."""
+    return ctypes.c_ulong.in_dll(lib, name)
+
+
+def description(doc):
+    """First paragraph of the docstring of a test, for argparse."""
+    return doc.split("\n\n")[0].strip()
+
+
+def report(failures):
+    """Print the first failures and the verdict, return the exit status."""
+    for f in failures[:10]:
+        print("FAILED: " + f)
+    print("ok" if not failures else "FAILED")
+    return 1 if failures else 0
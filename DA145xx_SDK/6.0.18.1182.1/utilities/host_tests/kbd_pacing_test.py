@@ -0,0 +1,549 @@
+#!/usr/bin/env python3
+"""
+Host test of the keystroke pacing of the HID-Gamepad-Digitizer example, user_kbd.c
+(CFG_KBD_PACING) and the UART2 frame path of user_gamepad.c.
+
+user_kbd.c and user_gamepad.c are built unmodified against the SDK headers and the
+DA14531 configuration of the example. HOGPD, the event counter of the link and UART2,
+with its 16-byte receive FIFO, are emulated. The link is simulated event by event: the
+host takes up to --peer reports per connection event, the reports wait in a queue of
+HID_REPORT_FIFO_SIZE entries, and user_kbd_on_ble_powered() is called at the end of
+every event.
+
+The strings are queued with user_kbd_send_str() whenever user_kbd_has_room() allows,
+the whole text and then one character per string, and over UART2: a host sends the
+frames byte by byte at 115200 baud, starting a frame while fewer than --window frames
+are not echoed, and user_gamepad_update_joystick() runs every AXIS_UPDATE_PER ms. The
+reports received are decoded as a host does, once processing the modifier before the
+keys of a report and once after them. The checks:
+
+- the reports type the text exactly, and no more reports are sent than the text needs
+- a modifier never changes in the report that presses a key
+- every event but the last one takes as many reports as allowed while some are left
+- a string completes no later than user_kbd_eta() said when it was queued; the
+  estimate assumes the host takes USER_KBD_PKTS_PER_EVENT reports, it is not checked
+  with a smaller --peer
+- no UART2 byte is lost while a keyboard frame waits for room in the pacing buffer,
+  with two frames in flight, and every frame is echoed once, in order
+
+    kbd_pacing_test.py                         intervals from 7.5 to 50 ms
+    kbd_pacing_test.py --peer 2                a host that takes fewer reports than the credits
+    kbd_pacing_test.py --text "Hello, World" --interval 15
+"""
+
+import argparse
+import bisect
+import ctypes
+import math
+import os
+import random
+import sys
+from collections import deque
+
+import host_c
+
+CODE_SHIFT = 0x80
+MOD_LEFT_SHIFT = 0x02
+
+INTERVALS = (6, 8, 9, 12, 16, 24, 32, 36, 40)     # 1.25ms units, 7.5 to 50 ms
+
+BYTE_US = 87                                        # 10 bits at 115200 baud
+
+HARNESS = r"""
+#include "da1458x_config_basic.h"
+#include "da1458x_config_advanced.h"
+#include "user_config.h"
+#include "ll.h"
+
+// Paced keyboard, UART2 wakes the system up and the handlers are stubbed below
+#define CFG_KBD_PACING
+#define CFG_UART2_WAKEUP
+
+// The interrupts of the test run between its calls, a critical section is only counted
+int irq_lock;
+#undef GLOBAL_INT_DISABLE
+#undef GLOBAL_INT_RESTORE
+#define GLOBAL_INT_DISABLE()    do { irq_lock++;
+#define GLOBAL_INT_RESTORE()    irq_lock--; } while (0)
+
+#include "user_kbd.c"
+#include "user_gamepad.c"
+
+uint32_t host_reg_rd(uint32_t addr)
+{
+    // The echo is sent at once
+    if (addr == (uint32_t)(uintptr_t)&(UART2)->UART_LSR_REGF)
+        return UART_TEMT;
+    return *reg(addr);
+}
+
+void host_reg_wr(uint32_t addr, uint32_t value)
+{
+    *reg(addr) = value;
+}
+
+void __nop(void)
+{
+}
+
+/* Application */
+void app_easy_security_bdb_init(void) {}
+void app_set_prf_srv_perm(enum KE_API_ID task_id, app_prf_srv_perm_t srv_perm) {}
+timer_hnd app_easy_timer(const uint32_t delay, timer_callback fn) { return EASY_TIMER_INVALID_TIMER; }
+enum process_event_response app_hogpd_process_handler(ke_msg_id_t const msgid, void const *param,
+                                                      ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    return PR_EVENT_UNHANDLED;
+}
+void user_conn_ctrl_traffic_ind(void) {}
+void user_uart_wakeup_init(void) {}
+void user_uart_wakeup_keep_awake(void) {}
+bool user_uart_wakeup_awake(void) { return false; }
+void user_trace_rx_start(void) {}
+void user_trace_rx_end(void) {}
+void user_trace_frame_dispatch(void) {}
+void user_trace_frame_done(void) {}
+uint16_t user_stream_write(uint8_t conidx, const uint8_t *data, uint16_t len) { return len; }
+
+/* HOGPD, the reports go to the test with the count of user_kbd.c once taken */
+static bool (*report_cb)(const uint8_t *report, uint32_t seq);
+static uint8_t active_host;
+int bad_reports;
+
+bool app_hogpd_send_report(uint8_t report_idx, uint8_t *data, uint16_t length, enum hogpd_report_type type)
+{
+    if ((report_idx != HID_GAMEPAD_AXIS_REPORT_IDX) || (length != HID_GAMEPAD_AXIS_REPORT_SIZE) ||
+        (type != HOGPD_REPORT) || (irq_lock != 0))
+    {
+        bad_reports++;
+        return false;
+    }
+    return report_cb(data, kbd_env.sent + 1);
+}
+
+uint8_t app_hogpd_get_active_host(void)
+{
+    return active_host;
+}
+
+bool app_hogpd_set_active_host(uint8_t conidx)
+{
+    if (conidx >= APP_EASY_MAX_ACTIVE_CONNECTION)
+        return false;
+    active_host = conidx;
+    return true;
+}
+
+/* Link of host 0 */
+last_ble_evt arch_last_rwble_evt_get(void)
+{
+    return BLE_EVT_END;
+}
+
+uint16_t gapc_get_conhdl(uint8_t conidx)
+{
+    return (conidx == 0) ? 0 : GAP_INVALID_CONHDL;
+}
+
+struct llc_env_tag *llc_env[BLE_CONNECTION_MAX];
+static struct llc_env_tag llc_link;
+static uint64_t elt_mem[(sizeof(struct ea_elt_tag) + sizeof(struct lld_evt_tag)) / 8 + 1];
+
+/* Connection event counter of the link */
+void link_count(uint16_t count)
+{
+    LLD_EVT_ENV_ADDR_GET(llc_link.elt)->counter = count;
+}
+
+/* UART2 with its receive FIFO */
+#define RX_FIFO_SIZE 16
+static uart_cb_t uart_rx_cb;
+static uint8_t *uart_rx_data;
+static uint8_t rx_fifo[RX_FIFO_SIZE];
+static int rx_fifo_cnt;
+static void (*echo_cb)(const uint8_t *data, uint16_t len);
+int overruns;
+
+void uart_register_rx_cb(uart_t *uart_id, uart_cb_t cb)
+{
+    uart_rx_cb = cb;
+}
+
+void uart_receive(uart_t *uart_id, uint8_t *data, uint16_t len, UART_OP_CFG op)
+{
+    if ((uart_id != UART2) || (len != 1) || (op != UART_OP_INTR))
+        abort();
+    uart_rx_data = data;
+}
+
+void uart_send(uart_t *uart_id, const uint8_t *data, uint16_t len, UART_OP_CFG op)
+{
+    echo_cb(data, len);
+}
+
+/* RX interrupt, a byte to each uart_receive() */
+void uart_rx_isr(void)
+{
+    while ((uart_rx_data != NULL) && (rx_fifo_cnt != 0))
+    {
+        uint8_t *data = uart_rx_data;
+
+        uart_rx_data = NULL;
+        *data = rx_fifo[0];
+        memmove(rx_fifo, rx_fifo + 1, --rx_fifo_cnt);
+        uart_rx_cb(1);
+    }
+}
+
+/* A byte on the RX line, lost when the FIFO is full */
+void uart_rx_byte(uint8_t byte)
+{
+    if (rx_fifo_cnt == RX_FIFO_SIZE)
+        overruns++;
+    else
+        rx_fifo[rx_fifo_cnt++] = byte;
+    uart_rx_isr();
+}
+
+void start(uint16_t con_interval, bool (*report)(const uint8_t *, uint32_t),
+           void (*echo)(const uint8_t *, uint16_t))
+{
+    memset(&kbd_env, 0, sizeof(kbd_env));
+    memset(elt_mem, 0, sizeof(elt_mem));
+    llc_link.elt = (struct ea_elt_tag *)elt_mem;
+    llc_env[0] = &llc_link;
+    active_host = 0;
+    report_cb = report;
+    echo_cb = echo;
+    bad_reports = 0;
+    rx_cnt = 0;
+    rx_flag = 0;
+    rx_frame_len = 0;
+    rx_fifo_cnt = 0;
+    overruns = 0;
+    uart_rx_data = NULL;
+    user_kbd_connected(0, con_interval);
+    user_gamepad_uart_rx_resume();
+}
+
+/* Reports sent once the string is typed, in kbd_env.sent units */
+uint32_t end_seq(uint8_t id)
+{
+    for (int i = 0; i < kbd_env.str_cnt; i++)
+    {
+        struct kbd_string *str = &kbd_env.strings[(kbd_env.str_head + i) % USER_KBD_STRINGS_MAX];
+
+        if (str->id == id)
+            return str->end_seq;
+    }
+    return 0;
+}
+
+int strings_left(void)
+{
+    return kbd_env.str_cnt;
+}
+
+const int buf_size = USER_KBD_BUF_SIZE;
+const int pkts_per_event = USER_KBD_PKTS_PER_EVENT;
+const int report_fifo_size = HID_REPORT_FIFO_SIZE;
+const int report_size = HID_GAMEPAD_AXIS_REPORT_SIZE;
+const int poll_ms = AXIS_UPDATE_PER;
+"""
+
+REPORT_CB = ctypes.CFUNCTYPE(ctypes.c_bool, ctypes.POINTER(ctypes.c_uint8), ctypes.c_uint32)
+ECHO_CB = ctypes.CFUNCTYPE(None, ctypes.POINTER(ctypes.c_uint8), ctypes.c_uint16)
+
+
+def build():
+    # The quoted includes of the sources must find the stub of datasheet.h first
+    lib = host_c.build("kbd_pacing_test", host_c.REG_FILE + HARNESS,
+                       stubs={"datasheet.h": host_c.DATASHEET_531},
+                       copies=[os.path.join(host_c.HID_EXAMPLE, name) for name in ("user_kbd.c", "user_gamepad.c")],
+                       includes=host_c.HID_INCLUDES + host_c.sdk_includes(), defines={"__DA14531__": None})
+    lib.start.argtypes = [ctypes.c_uint16, REPORT_CB, ECHO_CB]
+    lib.link_count.argtypes = [ctypes.c_uint16]
+    lib.uart_rx_byte.argtypes = [ctypes.c_uint8]
+    lib.end_seq.argtypes = [ctypes.c_uint8]
+    lib.end_seq.restype = ctypes.c_uint32
+    lib.kbd_code.argtypes = [ctypes.c_uint8]
+    lib.kbd_code.restype = ctypes.c_uint8
+    lib.user_kbd_has_room.argtypes = [ctypes.c_uint16]
+    lib.user_kbd_has_room.restype = ctypes.c_bool
+    lib.user_kbd_send_str.argtypes = [ctypes.c_char_p]
+    lib.user_kbd_send_str.restype = ctypes.c_uint8
+    lib.user_kbd_eta.argtypes = [ctypes.c_uint8]
+    lib.user_kbd_eta.restype = ctypes.c_uint32
+    lib.user_kbd_per_event.restype = ctypes.c_uint8
+    return lib
+
+
+class Link:
+    """Connection events of host 0, the reports wait in the FIFO of app_hogpd."""
+
+    def __init__(self, lib, con_interval, peer, echo=None):
+        self.lib = lib
+        self.con_interval = con_interval
+        self.interval_ms = con_interval * 1.25
+        self.peer = peer
+        self.fifo_size = host_c.cint(lib, "report_fifo_size").value
+        self.report_size = host_c.cint(lib, "report_size").value
+        self.queue = deque()
+        self.reports = []           # (mod, key) in the order taken
+        self.seqs = []              # count of user_kbd.c once each report is taken
+        self.taken_at = []
+        self.takes = []
+        self.padded = 0
+        self.count = 0
+        self.report_cb = REPORT_CB(self.report)
+        self.echo_cb = ECHO_CB(echo or (lambda data, n: None))
+        lib.start(con_interval, self.report_cb, self.echo_cb)
+
+    def report(self, data, seq):
+        if len(self.queue) >= self.fifo_size:
+            return False
+        rpt = bytes(data[:self.report_size])
+        if any(rpt[1:2] + rpt[3:]):
+            self.padded += 1
+        self.queue.append(((rpt[0], rpt[2]), seq))
+        return True
+
+    def event(self, now, queue=None):
+        """A connection event at now ms: the host takes its reports, the strings received
+        meanwhile are queued, then the event ends."""
+        take = min(self.peer, len(self.queue))
+        self.takes.append(take)
+        for _ in range(take):
+            rpt, seq = self.queue.popleft()
+            self.reports.append(rpt)
+            self.seqs.append(seq)
+            self.taken_at.append(now)
+        self.count = (self.count + 1) & 0xFFFF
+        self.lib.link_count(self.count)
+        if queue:
+            queue(now)
+        self.lib.user_kbd_on_ble_powered()
+
+    def done_at(self, end_seq):
+        """When the last report of a string was taken, None if not yet."""
+        i = bisect.bisect_right(self.seqs, end_seq)
+        return self.taken_at[i - 1] if i else None
+
+    def starved(self):
+        """Events that took fewer reports than allowed while some were left."""
+        pe = min(self.lib.user_kbd_per_event(), self.peer)
+        last = max((i for i, t in enumerate(self.takes) if t), default=0)
+        return sum(1 for t in self.takes[:last] if t < pe)
+
+
+class Test:
+    def __init__(self, args):
+        self.args = args
+        self.lib = build()
+        self.codes = [self.lib.kbd_code(ch) for ch in range(256)]
+        self.reverse = {}
+        for ch in range(128):
+            code = self.codes[ch]
+            if code & ~CODE_SHIFT:
+                self.reverse.setdefault((code & ~CODE_SHIFT, bool(code & CODE_SHIFT)), chr(ch))
+
+    def typed(self, text):
+        return "".join(ch for ch in text if self.codes[ord(ch)] & ~CODE_SHIFT)
+
+    def decode(self, reports, mods_first):
+        """Characters a host types from the reports, ASCII by keycode and Shift."""
+        out = []
+        mod, key = 0, 0
+        for new_mod, new_key in reports:
+            if mods_first:
+                mod = new_mod
+            if new_key and new_key != key:
+                out.append(self.reverse[(new_key, bool(mod & MOD_LEFT_SHIFT))])
+            key = new_key
+            mod = new_mod
+        if key or mod:
+            out.append("<held>")
+        return "".join(out)
+
+    def min_reports(self, text):
+        """Fewest reports that type text: a press per character, a report per modifier change,
+        a release between two presses of the same key, a release at the end."""
+        n = 0
+        mod, key = 0, 0
+        for ch in text:
+            code = self.codes[ord(ch)]
+            if code & ~CODE_SHIFT == 0:
+                continue
+            k, m = code & ~CODE_SHIFT, bool(code & CODE_SHIFT)
+            if m != mod:
+                n += 1
+            elif k == key:
+                n += 1
+            n += 1
+            mod, key = m, k
+        return n + (1 if key or mod else 0)
+
+    def check_reports(self, link, text, full_events=True):
+        failures = []
+        typed = self.typed(text)
+        for mods_first in (True, False):
+            got = self.decode(link.reports, mods_first)
+            if got != typed:
+                failures.append("decoded %s the keys: %r, expected %r" %
+                                ("before" if mods_first else "after", got[:60], typed[:60]))
+        for (m0, k0), (m1, k1) in zip([(0, 0)] + link.reports, link.reports):
+            if k1 and k1 != k0 and m1 != m0:
+                failures.append("modifier changed with a key press")
+                break
+        need = self.min_reports(text)
+        if len(link.reports) != need:
+            failures.append("%d reports for %d needed" % (len(link.reports), need))
+        if link.padded or host_c.cint(self.lib, "bad_reports").value:
+            failures.append("%d reports with other bytes set, %d not keyboard reports"
+                            % (link.padded, host_c.cint(self.lib, "bad_reports").value))
+        if full_events and link.starved():
+            failures.append("%d events took fewer reports than available" % link.starved())
+        return failures
+
+    def pace(self, texts, con_interval, verbose=True):
+        """Strings queued with user_kbd_send_str() at the end of the events."""
+        lib = self.lib
+        peer = self.args.peer
+        link = Link(lib, con_interval, peer)
+        waiting = deque(texts)
+        strings = []                # [queued_at, eta, end_seq]
+
+        def offer(now):
+            while waiting and lib.user_kbd_has_room(len(waiting[0])):
+                sid = lib.user_kbd_send_str(waiting.popleft().encode("latin-1"))
+                strings.append([now, lib.user_kbd_eta(sid), lib.end_seq(sid)])
+
+        offer(0.0)
+        k = 0
+        while (waiting or lib.strings_left() or link.queue) and k < 100000:
+            k += 1
+            now = k * link.interval_ms
+            link.event(now, offer)
+
+        text = "".join(texts)
+        failures = self.check_reports(link, text)
+        late = []
+        slack = 0.0
+        for i, (queued_at, eta, seq) in enumerate(strings):
+            # 0 once handed to HOGPD, on the air in the next event
+            eta = eta or link.interval_ms
+            done = link.done_at(seq)
+            if done is None:
+                continue
+            slack = max(slack, queued_at + eta - done)
+            if peer >= host_c.cint(lib, "pkts_per_event").value and done > queued_at + eta + 1e-6:
+                late.append(i)
+        if late:
+            failures.append("strings %s later than their estimate" % late[:10])
+        if verbose:
+            typed = self.typed(text)
+            per_event = min(lib.user_kbd_per_event(), peer)
+            optimal = math.ceil(len(link.reports) / per_event)
+            ms = k * link.interval_ms
+            print("%7.2f %4d %4d %6d %6d %7d %7d %9.0f %9.0f %8.1f  %s" %
+                  (link.interval_ms, lib.user_kbd_per_event(), peer, len(typed), len(link.reports), k, optimal,
+                   ms, len(typed) * 1000.0 / ms, slack, "ok" if not failures else "FAILED"))
+        return failures
+
+    def uart(self, texts, con_interval, window):
+        """Frames sent on UART2 byte by byte, at most window frames not echoed."""
+        lib = self.lib
+        frames = [t.encode("latin-1") + b"!" for t in texts]
+        echoes = []
+        link = Link(lib, con_interval, self.args.peer,
+                    lambda data, n: echoes.append(bytes(data[:n])))
+        poll_us = host_c.cint(lib, "poll_ms").value * 1000
+        event_us = con_interval * 1250
+        sent = 0                    # frames started
+        pos = 0                     # next byte of the frame sent
+        t_byte, t_poll, t_event = 0, poll_us, event_us
+        limit = 600 * 1000 * 1000
+        while (sent < len(frames) or pos or len(echoes) < len(frames) or link.queue or lib.strings_left()) \
+                and min(t_byte, t_poll, t_event) < limit:
+            now = min(t_byte, t_poll, t_event)
+            if now == t_byte:
+                if pos or (sent < len(frames) and sent - len(echoes) < window):
+                    frame = frames[sent]
+                    lib.uart_rx_byte(frame[pos])
+                    pos += 1
+                    if pos == len(frame):
+                        sent += 1
+                        pos = 0
+                t_byte += BYTE_US
+            elif now == t_poll:
+                lib.user_gamepad_update_joystick()
+                # The interrupts taken while the application ran
+                lib.uart_rx_isr()
+                t_poll += poll_us
+            else:
+                link.event(now / 1000.0)
+                t_event += event_us
+
+        # The frames may arrive slower than the link takes the reports
+        failures = self.check_reports(link, "".join(texts), False)
+        overruns = host_c.cint(lib, "overruns").value
+        if overruns:
+            failures.append("%d bytes lost" % overruns)
+        if echoes != frames[:len(echoes)] or len(echoes) != len(frames):
+            failures.append("%d of %d frames echoed in order" %
+                            (sum(1 for a, b in zip(echoes, frames) if a == b), len(frames)))
+        return failures
+
+
+def corpus(seed, n):
+    rnd = random.Random(seed)
+    words = ["hello", "World", "AAA", "aA", "Zz", "bookkeeper", "HID", "Mississippi", "a\tb", "x\ny",
+             "~!@#$%^&*()_+", "1234567890", "{}|:\"<>?", "Keep  spaces", "\x01ctrl\x02"]
+    texts = []
+    for _ in range(n):
+        parts = [rnd.choice(words) for _ in range(rnd.randint(1, 6))]
+        texts.append(" ".join(parts)[:99])
+    return texts
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--interval", type=float, action="append", help="connection interval in ms")
+    parser.add_argument("--peer", type=int, default=None, help="reports the host takes per event")
+    parser.add_argument("--text", action="append", help="strings to type, a random corpus by default")
+    parser.add_argument("--strings", type=int, default=40, help="strings of the random corpus")
+    parser.add_argument("--window", type=int, default=2, help="UART2 frames the host sends before their echo")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    test = Test(args)
+    if args.peer is None:
+        args.peer = host_c.cint(test.lib, "pkts_per_event").value
+    intervals = [int(round(i / 1.25)) for i in args.interval] if args.interval else INTERVALS
+    texts = args.text if args.text else corpus(args.seed, args.strings)
+    naive = 2 * len(test.typed("".join(texts)))
+
+    print("%d strings, %d characters; sent at once they would be %d reports" %
+          (len(texts), len("".join(texts)), naive))
+    print()
+    print("%7s %4s %4s %6s %6s %7s %7s %9s %9s %8s" %
+          ("ms", "pace", "peer", "chars", "rpts", "events", "optimal", "total ms", "chars/s", "eta +ms"))
+    failures = []
+    # A frame ends at "!", and a frame starting with <ESC> or <STX> is not typed
+    frames = [t.replace("!", "") for t in texts]
+    frames = [t for t in frames if t and t[0] not in "\x1b\x02"]
+    for con_interval in intervals:
+        for f in test.pace(texts, con_interval):
+            failures.append("%.2f ms: %s" % (con_interval * 1.25, f))
+        # The same text one character per string
+        for f in test.pace([ch for ch in "".join(texts)[:300]], con_interval, verbose=False):
+            failures.append("%.2f ms, single characters: %s" % (con_interval * 1.25, f))
+        for f in test.uart(frames, con_interval, args.window):
+            failures.append("%.2f ms, UART2: %s" % (con_interval * 1.25, f))
+
+    print()
+    return host_c.report(failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
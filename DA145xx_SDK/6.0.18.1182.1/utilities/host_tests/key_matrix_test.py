@@ -0,0 +1,796 @@
+#!/usr/bin/env python3
+"""
+Host test of the key matrix scanner of app_key_matrix.c (CFG_APP_KEY_MATRIX).
+
+app_key_matrix.c is built unmodified against stubbed GPIO, wakeup controller, easy timer
+and kernel message layers, with a 1 ms clock. The GPIO stub emulates a matrix of switches
+without diodes: a row reads low when a chain of closed switches connects it to a column
+driven low, which is how ghost keys appear, and every contact bounces when it opens or
+closes. The wakeup controller stub fires on an edge of a selected row held for the
+debouncing time, and the GPIO configuration is lost in sleep and given back through
+app_key_matrix_set_pads(), as set_pad_functions() does. The checks:
+
+- rollover: keys pressed at once without a rectangle are all reported
+- ghosting: with three corners of a rectangle pressed, the fourth is never reported
+- burst end: a key pressed while the rows are armed, after the last scan, is reported
+- random typing, two keys overlapping at times: every press and release is reported
+  once, after the contact settles, and the scanner goes back to sleep with the rows
+  armed and the columns driven low after the burst
+
+    key_matrix_test.py                       4x4 matrix, 10 ms scans
+    key_matrix_test.py --rows 8 --cols 8 --debounce 3 --bounce-ms 8
+"""
+
+import argparse
+import ctypes
+import itertools
+import os
+import random
+import sys
+
+import host_c
+
+SOURCES = [
+    os.path.join(host_c.APP_MODULES, "src", "app_key_matrix", "app_key_matrix.c"),
+    os.path.join(host_c.APP_MODULES, "api", "app_key_matrix.h"),
+]
+
+SCAN_UNIT_MS = 10
+
+STUBS = {
+    "rwip_config.h": """
+#ifndef RWIP_CONFIG_H_
+#define RWIP_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#define __SECTION_ZERO(name)
+#endif
+""",
+    "gpio.h": """
+#ifndef GPIO_H_
+#define GPIO_H_
+#include <stdint.h>
+#include <stdbool.h>
+typedef enum { GPIO_PORT_0 = 0, GPIO_PORT_1 = 1 } GPIO_PORT;
+typedef enum { GPIO_PIN_0 = 0 } GPIO_PIN;
+typedef enum { INPUT = 0, INPUT_PULLUP = 0x100, INPUT_PULLDOWN = 0x200, OUTPUT = 0x300 } GPIO_PUPD;
+typedef enum { PID_GPIO = 0 } GPIO_FUNCTION;
+void GPIO_ConfigurePin(GPIO_PORT port, GPIO_PIN pin, GPIO_PUPD mode, GPIO_FUNCTION function, const bool high);
+bool GPIO_GetPinStatus(GPIO_PORT port, GPIO_PIN pin);
+#endif
+""",
+    "arch_api.h": """
+#ifndef ARCH_API_H_
+#define ARCH_API_H_
+extern int assert_warnings;
+#define ASSERT_WARNING(cond)    {if (!(cond)) assert_warnings++;}
+void arch_ble_force_wakeup(void);
+#endif
+""",
+    "ke_msg.h": """
+#ifndef KE_MSG_H_
+#define KE_MSG_H_
+#include <stdint.h>
+typedef uint16_t ke_msg_id_t;
+typedef uint16_t ke_task_id_t;
+#define TASK_APP                (1)
+void ke_msg_send_basic(ke_msg_id_t const id, ke_task_id_t const dest_id, ke_task_id_t const src_id);
+#endif
+""",
+    "app_easy_timer.h": """
+#ifndef APP_EASY_TIMER_H_
+#define APP_EASY_TIMER_H_
+#include <stdint.h>
+typedef uint8_t timer_hnd;
+typedef void (* timer_callback)(void);
+#define EASY_TIMER_INVALID_TIMER    (0x0)
+timer_hnd app_easy_timer(const uint32_t delay, timer_callback fn);
+void app_easy_timer_cancel(const timer_hnd timer_id);
+#endif
+""",
+    "app_easy_msg_utils.h": """
+#ifndef APP_EASY_MSG_UTILS_H_
+#define APP_EASY_MSG_UTILS_H_
+#include "ke_msg.h"
+ke_msg_id_t app_easy_msg_set(void (*fn)(void));
+#endif
+""",
+    "wkupct_quadec.h": """
+#ifndef WKUPCT_QUADEC_H_
+#define WKUPCT_QUADEC_H_
+#include <stdint.h>
+typedef enum { WKUPCT_QUADEC_ERR_OK = 0 } wkupct_quadec_error_t;
+typedef void (*wakeup_handler_function_t)(void);
+#define WKUPCT_PIN_POLARITY_HIGH    0
+#define WKUPCT_PIN_POLARITY_LOW     1
+#define WKUPCT_PIN_SELECT(port, pin)                ( 1U << ((port) * 16 + (pin)) )
+#define WKUPCT_PIN_POLARITY(port, pin, polarity)    ( (uint32_t) (polarity) << ((port) * 16 + (pin)) )
+void wkupct2_enable_irq(uint32_t sel_pins, uint32_t pol_pins, uint16_t events_num, uint16_t deb_time);
+wkupct_quadec_error_t wkupct2_disable_irq(void);
+void wkupct2_register_callback(wakeup_handler_function_t callback);
+#endif
+""",
+}
+
+HARNESS = r"""
+#include <stdlib.h>
+#include <string.h>
+#include "app_key_matrix.c"
+
+int assert_warnings;
+
+/* Matrix: rows on port 0, columns on port 1, both from pin 0 */
+
+static struct app_key_matrix_pin rows[APP_KEY_MATRIX_MAX_ROWS];
+static struct app_key_matrix_pin cols[APP_KEY_MATRIX_MAX_COLS];
+static struct app_key_matrix_cfg cfg;
+
+uint32_t now_ms;
+
+/* Key contacts: a change starts a bounce period during which the contact is drawn at
+   random every millisecond, a scan takes far less */
+
+static bool contact[APP_KEY_MATRIX_MAX_ROWS][APP_KEY_MATRIX_MAX_COLS];
+static bool bouncing[APP_KEY_MATRIX_MAX_ROWS][APP_KEY_MATRIX_MAX_COLS];
+static uint32_t bounce_end[APP_KEY_MATRIX_MAX_ROWS][APP_KEY_MATRIX_MAX_COLS];
+static uint32_t lfsr = 1;
+
+void set_key(int r, int c, int pressed, uint32_t bounce_ms)
+{
+    contact[r][c] = pressed;
+    bounce_end[r][c] = now_ms + bounce_ms;
+}
+
+/* A change in the middle of the millisecond, after a number of row reads */
+
+static int late_key = -1, late_pressed, late_reads;
+static int reads;
+
+void set_key_late(int r, int c, int pressed, int after_reads)
+{
+    late_key = r * APP_KEY_MATRIX_MAX_COLS + c;
+    late_pressed = pressed;
+    late_reads = after_reads;
+}
+
+static void apply_late(void)
+{
+    if (late_key >= 0)
+    {
+        set_key(late_key / APP_KEY_MATRIX_MAX_COLS, late_key % APP_KEY_MATRIX_MAX_COLS, late_pressed, 0);
+        late_key = -1;
+    }
+}
+
+void seed(uint32_t value)
+{
+    lfsr = value | 1;
+}
+
+static void bounce(void)
+{
+    int r, c;
+
+    for (r = 0; r < APP_KEY_MATRIX_MAX_ROWS; r++)
+    {
+        for (c = 0; c < APP_KEY_MATRIX_MAX_COLS; c++)
+        {
+            lfsr = lfsr * 1103515245 + 12345;
+            bouncing[r][c] = (lfsr >> 16) & 1;
+        }
+    }
+}
+
+static bool closed(int r, int c)
+{
+    return (now_ms < bounce_end[r][c]) ? bouncing[r][c] : contact[r][c];
+}
+
+/* Pins: a column configured as an output is driven low, a row reads low when closed
+   contacts connect it to such a column, through other rows and columns if needed */
+
+static int mode[2][16];
+int pad_errors;
+int scans;
+
+void GPIO_ConfigurePin(GPIO_PORT port, GPIO_PIN pin, GPIO_PUPD m, GPIO_FUNCTION function, const bool high)
+{
+    int c;
+
+    if ((m == OUTPUT) && high)
+    {
+        pad_errors++;
+    }
+    mode[port][pin] = m;
+
+    // A scan starts with the first column driven alone
+    if ((port == GPIO_PORT_1) && (pin == 0) && (m == OUTPUT))
+    {
+        for (c = 1; c < cfg.nb_cols; c++)
+        {
+            if (mode[GPIO_PORT_1][c] == OUTPUT)
+            {
+                return;
+            }
+        }
+        scans++;
+    }
+}
+
+static uint32_t low_rows(void)
+{
+    bool k[APP_KEY_MATRIX_MAX_ROWS][APP_KEY_MATRIX_MAX_COLS];
+    uint32_t lrows = 0, lcols = 0;
+    bool grew = true;
+    int r, c;
+
+    if (reads >= late_reads)
+    {
+        apply_late();
+    }
+    for (r = 0; r < cfg.nb_rows; r++)
+    {
+        for (c = 0; c < cfg.nb_cols; c++)
+        {
+            k[r][c] = closed(r, c);
+        }
+    }
+    for (c = 0; c < cfg.nb_cols; c++)
+    {
+        if (mode[GPIO_PORT_1][c] == OUTPUT)
+        {
+            lcols |= 1 << c;
+        }
+    }
+    while (grew)
+    {
+        grew = false;
+        for (r = 0; r < cfg.nb_rows; r++)
+        {
+            for (c = 0; c < cfg.nb_cols; c++)
+            {
+                if (!k[r][c] || (((lrows >> r) & 1) == ((lcols >> c) & 1)))
+                {
+                    continue;
+                }
+                lrows |= 1 << r;
+                lcols |= 1 << c;
+                grew = true;
+            }
+        }
+    }
+    // A row that is not an input with pull-up does not read high when it is open
+    for (r = 0; r < cfg.nb_rows; r++)
+    {
+        if (mode[GPIO_PORT_0][r] != INPUT_PULLUP)
+        {
+            pad_errors++;
+        }
+    }
+    return lrows;
+}
+
+bool GPIO_GetPinStatus(GPIO_PORT port, GPIO_PIN pin)
+{
+    if (port != GPIO_PORT_0)
+    {
+        pad_errors++;
+        return true;
+    }
+    reads++;
+    return !((low_rows() >> pin) & 1);
+}
+
+/* Wakeup controller: an edge of a selected pin to its polarity, held for the debouncing
+   time, disables the interrupt and calls the callback */
+
+static wakeup_handler_function_t wkup_cb;
+static uint32_t wkup_sel, wkup_pol;
+static uint16_t wkup_deb;
+int wkup_armed;
+static int wkup_active;
+static uint32_t wkup_since;
+int wakeups;
+
+static int wkup_level(void)
+{
+    uint32_t lrows = low_rows();
+    int r;
+
+    for (r = 0; r < cfg.nb_rows; r++)
+    {
+        uint32_t bit = WKUPCT_PIN_SELECT(GPIO_PORT_0, r);
+
+        if ((wkup_sel & bit) && (((lrows >> r) & 1) == ((wkup_pol & bit) != 0)))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void wkupct2_enable_irq(uint32_t sel_pins, uint32_t pol_pins, uint16_t events_num, uint16_t deb_time)
+{
+    wkup_sel = sel_pins;
+    wkup_pol = pol_pins;
+    wkup_deb = deb_time;
+    wkup_armed = 1;
+    // Level already active: no edge
+    wkup_active = wkup_level();
+    wkup_since = (uint32_t) -1;
+}
+
+wkupct_quadec_error_t wkupct2_disable_irq(void)
+{
+    wkup_armed = 0;
+    return WKUPCT_QUADEC_ERR_OK;
+}
+
+void wkupct2_register_callback(wakeup_handler_function_t callback)
+{
+    wkup_cb = callback;
+}
+
+void arch_ble_force_wakeup(void)
+{
+}
+
+/* Kernel messages of the application, run in order */
+
+#define MSG_MAX 8
+static void (*msg_fn[MSG_MAX])(void);
+static int nb_msg_fn;
+static ke_msg_id_t queue[16];
+static int queued;
+int stray_msgs;
+
+ke_msg_id_t app_easy_msg_set(void (*fn)(void))
+{
+    msg_fn[nb_msg_fn] = fn;
+    return 0x100 + nb_msg_fn++;
+}
+
+void ke_msg_send_basic(ke_msg_id_t const id, ke_task_id_t const dest_id, ke_task_id_t const src_id)
+{
+    if ((dest_id != TASK_APP) || (queued == 16))
+    {
+        stray_msgs++;
+        return;
+    }
+    queue[queued++] = id;
+}
+
+/* Easy timers, in 10 ms units */
+
+#define TIMER_MAX 4
+static timer_callback timer_fn[TIMER_MAX];
+static uint32_t timer_at[TIMER_MAX];
+int timer_errors;
+
+timer_hnd app_easy_timer(const uint32_t delay, timer_callback fn)
+{
+    int i;
+
+    for (i = 0; i < TIMER_MAX; i++)
+    {
+        if (timer_fn[i] == NULL)
+        {
+            timer_fn[i] = fn;
+            timer_at[i] = now_ms + delay * 10;
+            return i + 1;
+        }
+    }
+    timer_errors++;
+    return EASY_TIMER_INVALID_TIMER;
+}
+
+void app_easy_timer_cancel(const timer_hnd timer_id)
+{
+    if ((timer_id == EASY_TIMER_INVALID_TIMER) || (timer_fn[timer_id - 1] == NULL))
+    {
+        timer_errors++;
+        return;
+    }
+    timer_fn[timer_id - 1] = NULL;
+}
+
+int timers_pending(void)
+{
+    int i, n = 0;
+
+    for (i = 0; i < TIMER_MAX; i++)
+    {
+        n += timer_fn[i] != NULL;
+    }
+    return n;
+}
+
+/* Reported keys */
+
+#define EVENT_MAX 65536
+uint32_t ev_time[EVENT_MAX];
+uint8_t ev_key[EVENT_MAX];
+uint8_t ev_pressed[EVENT_MAX];
+int events;
+int scan_ends;
+int report_errors;
+
+static void on_key(uint8_t row, uint8_t col, bool pressed)
+{
+    if ((row >= cfg.nb_rows) || (col >= cfg.nb_cols) || (app_key_matrix_is_pressed(row, col) != pressed))
+    {
+        report_errors++;
+    }
+    if (events < EVENT_MAX)
+    {
+        ev_time[events] = now_ms;
+        ev_key[events] = row * APP_KEY_MATRIX_MAX_COLS + col;
+        ev_pressed[events] = pressed;
+        events++;
+    }
+}
+
+static void on_scan_end(void)
+{
+    scan_ends++;
+}
+
+void start(int nb_rows, int nb_cols)
+{
+    int i;
+
+    for (i = 0; i < APP_KEY_MATRIX_MAX_ROWS; i++)
+    {
+        rows[i].port = GPIO_PORT_0;
+        rows[i].pin = (GPIO_PIN) i;
+    }
+    for (i = 0; i < APP_KEY_MATRIX_MAX_COLS; i++)
+    {
+        cols[i].port = GPIO_PORT_1;
+        cols[i].pin = (GPIO_PIN) i;
+    }
+    cfg.rows = rows;
+    cfg.cols = cols;
+    cfg.nb_rows = nb_rows;
+    cfg.nb_cols = nb_cols;
+    cfg.on_key = on_key;
+    cfg.on_scan_end = on_scan_end;
+    // Power up: keys released, pads inputs without pull, nothing pending
+    now_ms = 0;
+    late_key = -1;
+    memset(contact, 0, sizeof(contact));
+    memset(bounce_end, 0, sizeof(bounce_end));
+    memset(mode, 0, sizeof(mode));
+    memset(timer_fn, 0, sizeof(timer_fn));
+    queued = 0;
+    wkup_armed = 0;
+    app_key_matrix_init(&cfg);
+}
+
+/* Pads in their idle state: rows inputs with pull-up, columns driven low */
+
+int pads_idle(void)
+{
+    int i;
+
+    for (i = 0; i < cfg.nb_rows; i++)
+    {
+        if (mode[GPIO_PORT_0][i] != INPUT_PULLUP)
+        {
+            return 0;
+        }
+    }
+    for (i = 0; i < cfg.nb_cols; i++)
+    {
+        if (mode[GPIO_PORT_1][i] != OUTPUT)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* One millisecond: the wakeup controller, the messages, then the timers due. While no
+   message or timer is pending the system sleeps, the pads are configured again on the
+   wakeup. */
+
+int sleeps;
+uint32_t burst_end_ms;
+
+void tick(void)
+{
+    int i, active;
+    bool was_scanning = app_key_matrix_is_scanning();
+
+    now_ms++;
+    reads = 0;
+    bounce();
+
+    // Asleep, the pads keep their state
+    if (!queued && !timers_pending())
+    {
+        sleeps++;
+    }
+
+    if (wkup_armed)
+    {
+        active = wkup_level();
+        if (active && !wkup_active)
+        {
+            wkup_since = now_ms;
+        }
+        else if (!active)
+        {
+            wkup_since = (uint32_t) -1;
+        }
+        wkup_active = active;
+        if ((wkup_since != (uint32_t) -1) && (now_ms - wkup_since >= wkup_deb))
+        {
+            wakeups++;
+            wkup_armed = 0;
+            // Wakeup from sleep: set_pad_functions()
+            memset(mode, 0, sizeof(mode));
+            app_key_matrix_set_pads();
+            wkup_cb();
+        }
+    }
+
+    while (queued)
+    {
+        ke_msg_id_t id = queue[0];
+
+        memmove(&queue[0], &queue[1], --queued * sizeof(queue[0]));
+        if ((id < 0x100) || (id >= 0x100 + nb_msg_fn))
+        {
+            stray_msgs++;
+            continue;
+        }
+        msg_fn[id - 0x100]();
+    }
+
+    for (i = 0; i < TIMER_MAX; i++)
+    {
+        if ((timer_fn[i] != NULL) && (timer_at[i] <= now_ms))
+        {
+            timer_callback fn = timer_fn[i];
+
+            timer_fn[i] = NULL;
+            fn();
+        }
+    }
+
+    apply_late();
+    if (was_scanning && !app_key_matrix_is_scanning())
+    {
+        burst_end_ms = now_ms;
+    }
+}
+
+int scanning(void)
+{
+    return app_key_matrix_is_scanning();
+}
+
+int constant(const char *name)
+{
+#define C(x)    if (strcmp(name, #x) == 0) return (x)
+    C(APP_KEY_MATRIX_MAX_ROWS); C(APP_KEY_MATRIX_MAX_COLS); C(APP_KEY_MATRIX_DEBOUNCE);
+    C(APP_KEY_MATRIX_SCAN_PERIOD); C(APP_KEY_MATRIX_WKUP_DEB_TIME);
+#undef C
+    return -1;
+}
+"""
+
+
+def build(args):
+    # The quoted includes of the sources must find the stubs before the SDK headers
+    lib = host_c.build("key_matrix_test", HARNESS, stubs=STUBS, copies=SOURCES,
+                       defines={"__DA14531__": None, "CFG_APP_KEY_MATRIX": None,
+                                "APP_KEY_MATRIX_DEBOUNCE": args.debounce, "APP_KEY_MATRIX_SCAN_PERIOD": args.period,
+                                "APP_KEY_MATRIX_WKUP_DEB_TIME": args.wkup_deb})
+    lib.constant.argtypes = [ctypes.c_char_p]
+    lib.set_key.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_uint32]
+    lib.seed.argtypes = [ctypes.c_uint32]
+    lib.set_key_late.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_int]
+    return lib
+
+
+class Test:
+    def __init__(self, args):
+        self.args = args
+        self.failures = []
+        self.lib = build(args)
+        self.max_cols = self.lib.constant(b"APP_KEY_MATRIX_MAX_COLS")
+
+    def fail(self, msg):
+        self.failures.append(msg)
+
+    def run(self, script, seed):
+        """Plays a list of (time_ms, key, pressed) on a fresh scanner, then checks that it
+        sleeps with the rows armed. Returns the reported (time_ms, key, pressed). A change
+        given as (time_ms, key, pressed, reads) lands without bouncing in the middle of
+        that millisecond, after that many row reads."""
+        args = self.args
+        lib = self.lib
+        rng = random.Random(seed)
+        lib.seed(seed)
+        for name in ("events", "scans", "wakeups", "scan_ends", "sleeps"):
+            host_c.cint(lib, name).value = 0
+        lib.start(args.rows, args.cols)
+        script = sorted(script)
+        end = (script[-1][0] if script else 0) + 500
+        i = 0
+        for now in range(1, end):
+            while i < len(script) and script[i][0] == now:
+                (r, c), pressed = script[i][1:3]
+                if len(script[i]) > 3:
+                    lib.set_key_late(r, c, pressed, script[i][3])
+                else:
+                    lib.set_key(r, c, pressed, int(rng.uniform(0, args.bounce_ms)))
+                i += 1
+            lib.tick()
+
+        if lib.scanning() or lib.timers_pending() or not host_c.cint(lib, "wkup_armed").value or not lib.pads_idle():
+            self.fail("scanner not asleep with the rows armed after the keys are released")
+        for name, what in (("assert_warnings", "assertions"), ("pad_errors", "pads misconfigured"),
+                           ("stray_msgs", "unexpected messages"), ("timer_errors", "timer errors"),
+                           ("report_errors", "reports out of the matrix or of the pressed state")):
+            if host_c.cint(lib, name).value:
+                self.fail("%d %s" % (host_c.cint(lib, name).value, what))
+                host_c.cint(lib, name).value = 0
+        n = host_c.cint(lib, "events").value
+        times = (ctypes.c_uint32 * n).in_dll(lib, "ev_time") if n else []
+        keys = (ctypes.c_uint8 * n).in_dll(lib, "ev_key") if n else []
+        pressed = (ctypes.c_uint8 * n).in_dll(lib, "ev_pressed") if n else []
+        return [(times[k], divmod(keys[k], self.max_cols), bool(pressed[k])) for k in range(n)]
+
+    def check_rollover(self):
+        args = self.args
+        # A diagonal never forms a rectangle
+        n = min(args.rows, args.cols)
+        keys = [(i, i) for i in range(n)]
+        script = [(10 + 3 * i, k, True) for i, k in enumerate(keys)] + [(300, k, False) for k in keys]
+        events = self.run(script, 1)
+        reported = set(k for _, k, p in events if p)
+        if reported != set(keys) or len(events) != 2 * n:
+            self.fail("rollover: %d keys pressed, %d reported, %d events" % (n, len(reported), len(events)))
+        print("rollover   %d keys at once: %d reported" % (n, len(reported)))
+
+    def check_ghosting(self):
+        args = self.args
+        ghosts = 0
+        blocked = 0
+        for trial in range(50):
+            rng = random.Random(trial)
+            r1, r2 = rng.sample(range(args.rows), 2)
+            c1, c2 = rng.sample(range(args.cols), 2)
+            corners = [(r1, c1), (r1, c2), (r2, c1)]
+            rng.shuffle(corners)
+            script = [(10 + 40 * i, k, True) for i, k in enumerate(corners)] + [(400, k, False) for k in corners]
+            events = self.run(script, trial + 2)
+            reported = set(k for _, k, p in events if p)
+            if (r2, c2) in reported:
+                ghosts += 1
+            blocked += len(set(corners) - reported)
+        if ghosts:
+            self.fail("ghosting: %d ghost keys reported" % ghosts)
+        print("ghosting   50 rectangles: %d ghost keys reported, %d real keys blocked" % (ghosts, blocked))
+
+    def check_burst_end(self):
+        """A key pressed between the last scan of a burst and the arming of the rows gives
+        no edge to the wakeup controller."""
+        args = self.args
+        lib = self.lib
+        missed = 0
+        for trial in range(20):
+            rng = random.Random(trial)
+            a, b = rng.sample(list(itertools.product(range(args.rows), range(args.cols))), 2)
+            script = [(10, a, True), (150, a, False)]
+            self.run(script, trial)
+            end = ctypes.c_uint32.in_dll(lib, "burst_end_ms").value
+            # After the reads of the last scan, before the check of arming
+            script += [(end, b, True, args.rows * args.cols), (end + 200, b, False)]
+            events = self.run(script, trial)
+            if (b, True) not in [(k, p) for _, k, p in events]:
+                missed += 1
+        if missed:
+            self.fail("burst end: %d of 20 presses at the end of a burst not reported" % missed)
+        print("burst end  20 presses while the rows are armed: %d missed" % missed)
+
+    def check_random(self):
+        args = self.args
+        rng = random.Random(args.seed)
+        keys = list(itertools.product(range(args.rows), range(args.cols)))
+        # The keys settle at most bounce_ms after their change, the report follows within
+        # the debouncing scans. Keys are held and released longer than that.
+        bound = args.wkup_deb + args.bounce_ms + (args.debounce + 1) * args.period * SCAN_UNIT_MS
+        script = []
+        now = 10
+        for k in range(args.keystrokes):
+            key = rng.choice(keys)
+            hold = rng.randint(bound, bound + 160)
+            script.append((now, key, True))
+            script.append((now + hold, key, False))
+            end = now + hold
+            if rng.random() < args.overlap:
+                # A second key pressed while the first one is held, never the same key
+                other = rng.choice([x for x in keys if x != key])
+                start = now + rng.randint(1, hold - 1)
+                script.append((start, other, True))
+                end = max(end, start + rng.randint(bound, bound + 160))
+                script.append((end, other, False))
+            now = end + rng.randint(bound, bound + 280)
+        events = self.run(script, args.seed)
+        lib = self.lib
+
+        press_lat = []
+        release_lat = []
+        pending = list(events)
+        script.sort()
+        for k, (t, key, pressed) in enumerate(script):
+            # The report comes after the change and, for a press, before the next change
+            limit = next((s[0] for s in script[k + 1:] if s[1] == key), None)
+            for i, (te, ke, pe) in enumerate(pending):
+                if ke == key and pe == pressed and te >= t and (limit is None or te <= limit):
+                    (press_lat if pressed else release_lat).append(te - t)
+                    del pending[i]
+                    break
+            else:
+                self.fail("%s of %s at %d ms not reported" % ("press" if pressed else "release", key, t))
+        for te, ke, pe in pending:
+            self.fail("%s of %s reported at %d ms, no matching change" % ("press" if pe else "release", ke, te))
+        late = [x for x in press_lat + release_lat if x > bound]
+        if late:
+            self.fail("%d reports later than %d ms, up to %d ms" % (len(late), bound, max(late)))
+        # A change is read by APP_KEY_MATRIX_DEBOUNCE scans before it is reported
+        early = [x for x in press_lat + release_lat if x < (args.debounce - 1) * args.period * SCAN_UNIT_MS]
+        if early:
+            self.fail("%d reports before %d scans, down to %d ms" % (len(early), args.debounce, min(early)))
+
+        def stats(values):
+            values = sorted(values)
+            if not values:
+                return "-"
+            return "mean %.1f ms, p99 %d ms, max %d ms" % (
+                sum(values) / float(len(values)), values[int(0.99 * (len(values) - 1))], values[-1])
+
+        n = len(script) // 2
+        print("random     %d keystrokes, %d wakeups, %d scans (%.1f per keystroke), asleep %.0f%% of the time"
+              % (n, host_c.cint(lib, "wakeups").value, host_c.cint(lib, "scans").value, host_c.cint(lib, "scans").value / float(n),
+                 100.0 * host_c.cint(lib, "sleeps").value / host_c.cint(lib, "now_ms").value))
+        print("           press latency   " + stats(press_lat))
+        print("           release latency " + stats(release_lat))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--rows", type=int, default=4)
+    parser.add_argument("--cols", type=int, default=4)
+    parser.add_argument("--debounce", type=int, default=2, help="APP_KEY_MATRIX_DEBOUNCE")
+    parser.add_argument("--period", type=int, default=1, help="APP_KEY_MATRIX_SCAN_PERIOD, 10 ms units")
+    parser.add_argument("--wkup-deb", type=int, default=2, help="APP_KEY_MATRIX_WKUP_DEB_TIME in ms")
+    parser.add_argument("--bounce-ms", type=int, default=5, help="longest contact bounce")
+    parser.add_argument("--keystrokes", type=int, default=500)
+    parser.add_argument("--overlap", type=float, default=0.2, help="share of keystrokes with a second key held")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+    if not (2 <= args.rows <= 8 and 2 <= args.cols <= 8):
+        sys.exit("--rows and --cols must be 2 to 8")
+    if args.bounce_ms >= (args.debounce - 1) * args.period * SCAN_UNIT_MS:
+        # More scans than the debounce count would fit in the bounce of one contact
+        sys.exit("--bounce-ms must be shorter than (--debounce - 1) scan periods")
+
+    test = Test(args)
+    print("%dx%d matrix, scan every %d ms, debounce %d scans, bounce up to %d ms"
+          % (args.rows, args.cols, args.period * SCAN_UNIT_MS, args.debounce, args.bounce_ms))
+    test.check_rollover()
+    test.check_ghosting()
+    test.check_burst_end()
+    test.check_random()
+
+    return host_c.report(test.failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,1173 @@
+#!/usr/bin/env python3
+"""
+Host test of the LE credit based channel module, app_lecb.c and app_lecb_task.c.
+
+The two files are built unmodified with the real GAPC and L2CC headers and stubbed
+kernel and application layers. The messages of the module are taken in order by an
+emulation of GAPC, L2CC and the peer. GAPC registers the LE_PSM, opens and closes the
+channel and applies the returned credits when it executes the command. L2CC
+reassembles the K-frames of the peer and segments the SDUs of the application in
+K-frames. The messages to the application go through one FIFO and are delivered later,
+like the kernel queue delivers them.
+
+On every connection the application listens on an LE_PSM or opens the channel itself.
+The peer streams SDUs of random length, and the application keeps each one for a random
+time. It also sends SDUs up to the MTU of the peer, and sometimes longer ones. The peer
+closes the channel, the application closes it, and the link drops and comes back, at
+random. The runs use three receive budgets, K-frame sizes and local MTUs. The checks:
+
+- the peer never holds more credits than APP_LECB_RX_CREDITS less the K-frames being
+  reassembled and the K-frames of the SDUs kept by the application
+- the stream never stalls: once the application releases its SDUs, all the credits
+  are back with the peer
+- every SDU reaches the other side once, intact and in order, while the channel is open
+- no more than APP_LECB_TX_PIPELINE SDUs of a channel are in L2CC, and an SDU is
+  refused exactly when the channel is closed, the SDU is longer than the peer MTU or
+  the pipeline is full
+- every opened channel is reported closed once, the GAP messages are passed on, and
+  no message is leaked
+
+    lecb_credit_test.py
+    lecb_credit_test.py --steps 200000 --seed 7
+"""
+
+import argparse
+import collections
+import ctypes
+import os
+import random
+import sys
+
+import host_c
+
+LECB_SRC = os.path.join(host_c.APP_MODULES, "src", "app_lecb")
+INCLUDES = [LECB_SRC, os.path.join(host_c.APP_MODULES, "api")] + host_c.BLE_HOST_INCLUDES
+
+# (APP_LECB_RX_CREDITS, MPS, local MTU)
+CONFIGS = ((8, 64, 250), (4, 100, 200), (16, 23, 300))
+CONNECTIONS = 2
+LE_PSM = 0x0080
+SDU_LEN_FIELD = 2
+
+STUBS = {
+    "rwip_config.h": """
+#ifndef RWIP_CONFIG_H_
+#define RWIP_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#define BLE_APP_PRESENT         1
+#define BLE_APP_LECB            1
+#define BLE_CENTRAL             0
+#define BLE_PERIPHERAL          1
+#define BLE_L2CC                1
+#define BLE_CONNECTION_MAX      3
+#define L2CC_IDX_MAX            BLE_CONNECTION_MAX
+#define __SECTION_ZERO(name)
+#define __ARRAY_EMPTY
+#include "rwble_hl_error.h"
+#endif
+""",
+    "ke_task.h": """
+#ifndef KE_TASK_H_
+#define KE_TASK_H_
+#include <stdint.h>
+typedef uint16_t ke_task_id_t;
+typedef uint16_t ke_msg_id_t;
+typedef uint8_t ke_state_t;
+#define KE_FIRST_MSG(task)      ((ke_msg_id_t)((task) << 8))
+#define KE_MEM_BLOCK_MAX        4
+enum
+{
+    TASK_ID_L2CC = 10,
+    TASK_ID_GAPC = 14,
+};
+#define TASK_APP                (1)
+#define TASK_L2CC               (TASK_ID_L2CC)
+#define TASK_GAPC               (TASK_ID_GAPC)
+typedef int (*ke_msg_func_t)(ke_msg_id_t const msgid, void const *param,
+                             ke_task_id_t const dest_id, ke_task_id_t const src_id);
+struct ke_msg_handler
+{
+    ke_msg_id_t id;
+    ke_msg_func_t func;
+};
+#endif
+""",
+    "ke_msg.h": """
+#ifndef KE_MSG_H_
+#define KE_MSG_H_
+#include "ke_task.h"
+#include <stddef.h>
+enum ke_msg_status_tag
+{
+    KE_MSG_CONSUMED = 0,
+    KE_MSG_NO_FREE,
+    KE_MSG_SAVED,
+};
+#define KE_BUILD_ID(type, index) ( (ke_task_id_t)(((index) << 8)|(type)) )
+#define KE_TYPE_GET(ke_task_id) ((ke_task_id) & 0xFF)
+#define KE_IDX_GET(ke_task_id) (((ke_task_id) >> 8) & 0xFF)
+struct ke_msg;
+void *ke_msg_alloc(ke_msg_id_t const id, ke_task_id_t const dest_id, ke_task_id_t const src_id,
+                   uint16_t const param_len);
+void ke_msg_send(void const *param_ptr);
+void ke_msg_free(struct ke_msg const *param);
+struct ke_msg *ke_param2msg(void const *param_ptr);
+#define KE_MSG_ALLOC(id, dest, src, param_str) \\
+    (struct param_str*) ke_msg_alloc(id, dest, src, sizeof(struct param_str))
+#define KE_MSG_ALLOC_DYN(id, dest, src, param_str, length) \\
+    (struct param_str*) ke_msg_alloc(id, dest, src, (sizeof(struct param_str) + length));
+#endif
+""",
+    "compiler.h": """
+#define __STATIC_FORCEINLINE    static inline
+#define __INLINE                inline
+""",
+    "gattm.h": """
+#include <stdint.h>
+uint16_t gattm_get_max_mtu(void);
+uint16_t gattm_get_max_mps(void);
+""",
+    "co_math.h": """
+#ifndef CO_MATH_H_
+#define CO_MATH_H_
+#define co_min(a, b)    ((a) < (b) ? (a) : (b))
+#define co_max(a, b)    ((a) > (b) ? (a) : (b))
+#endif
+""",
+    "app.h": """
+#ifndef APP_H_
+#define APP_H_
+#include "rwip_config.h"
+#include "ke_msg.h"
+#include "app_entry_point.h"
+extern int assert_warnings;
+#define ASSERT_WARNING(cond)    {if (!(cond)) assert_warnings++;}
+#define ASSERT_ERROR(cond)      ASSERT_WARNING(cond)
+#define CALLBACK_ARGS_2(cb, arg1, arg2)             {if (cb != NULL) cb(arg1, arg2);}
+#define CALLBACK_ARGS_3(cb, arg1, arg2, arg3)       {if (cb != NULL) cb(arg1, arg2, arg3);}
+#endif
+""",
+    "app_task.h": "",
+    "app_entry_point.h": """
+#ifndef APP_ENTRY_POINT_H_
+#define APP_ENTRY_POINT_H_
+#include "ke_msg.h"
+enum process_event_response
+{
+    PR_EVENT_HANDLED = 0,
+    PR_EVENT_UNHANDLED
+};
+enum process_event_response app_std_process_event(ke_msg_id_t const msgid,
+                                                  void const *param,
+                                                  ke_task_id_t const src_id,
+                                                  ke_task_id_t const dest_id,
+                                                  enum ke_msg_status_tag *msg_ret,
+                                                  const struct ke_msg_handler *handlers,
+                                                  const int handler_num);
+#endif
+""",
+    "user_callback_config.h": """
+#include "app_lecb.h"
+uint16_t harness_connect_req(uint8_t conidx, uint16_t le_psm, uint16_t peer_mtu);
+void harness_connected(uint8_t conidx, uint16_t le_psm, uint16_t peer_mtu);
+void harness_disconnected(uint8_t conidx, uint16_t le_psm, uint16_t reason);
+void harness_sdu_received(uint8_t conidx, const uint8_t *sdu, uint16_t len);
+void harness_sdu_sent(uint8_t conidx, uint8_t status);
+static const struct app_lecb_cb user_app_lecb_cb =
+{
+    .on_lecb_connect_req  = harness_connect_req,
+    .on_lecb_connected    = harness_connected,
+    .on_lecb_disconnected = harness_disconnected,
+    .on_lecb_sdu_received = harness_sdu_received,
+    .on_lecb_sdu_sent     = harness_sdu_sent,
+};
+""",
+}
+
+HARNESS = r"""
+#include "app_lecb.c"
+#include "app_lecb_task.c"
+#include <stdlib.h>
+
+int assert_warnings;
+int live_msgs;
+uint16_t max_mtu, max_mps;
+
+struct ke_msg
+{
+    ke_msg_id_t id;
+    ke_task_id_t dest_id;
+    uint16_t param_len;
+    uint32_t param[];
+};
+
+void *ke_msg_alloc(ke_msg_id_t const id, ke_task_id_t const dest_id, ke_task_id_t const src_id,
+                   uint16_t const param_len)
+{
+    struct ke_msg *msg = calloc(1, sizeof(struct ke_msg) + param_len);
+
+    msg->id = id;
+    msg->dest_id = dest_id;
+    msg->param_len = param_len;
+    live_msgs++;
+    return msg->param;
+}
+
+struct ke_msg *ke_param2msg(void const *param_ptr)
+{
+    return (struct ke_msg *)((uint8_t *)param_ptr - offsetof(struct ke_msg, param));
+}
+
+void ke_msg_free(struct ke_msg const *msg)
+{
+    live_msgs--;
+    free((void *)msg);
+}
+
+uint16_t gattm_get_max_mtu(void)
+{
+    return max_mtu;
+}
+
+uint16_t gattm_get_max_mps(void)
+{
+    return max_mps;
+}
+
+// Messages sent by the module, taken in order by the stack emulation
+#define OUT_SIZE    64
+static struct ke_msg *out[OUT_SIZE];
+static int out_head, out_cnt;
+int out_overflow;
+
+void ke_msg_send(void const *param_ptr)
+{
+    if (out_cnt == OUT_SIZE)
+    {
+        out_overflow++;
+        ke_msg_free(ke_param2msg(param_ptr));
+        return;
+    }
+    out[(out_head + out_cnt++) % OUT_SIZE] = ke_param2msg(param_ptr);
+}
+
+enum process_event_response app_std_process_event(ke_msg_id_t const msgid,
+                                                  void const *param,
+                                                  ke_task_id_t const src_id,
+                                                  ke_task_id_t const dest_id,
+                                                  enum ke_msg_status_tag *msg_ret,
+                                                  const struct ke_msg_handler *handlers,
+                                                  const int handler_num)
+{
+    int i;
+
+    for (i = 0; i < handler_num; i++)
+    {
+        if (handlers[i].id == msgid)
+        {
+            *msg_ret = (enum ke_msg_status_tag)handlers[i].func(msgid, param, dest_id, src_id);
+            return PR_EVENT_HANDLED;
+        }
+    }
+    return PR_EVENT_UNHANDLED;
+}
+
+// Flat view of a message of the module
+struct out_rec
+{
+    uint16_t id;
+    uint8_t conidx;
+    uint8_t operation;
+    uint16_t le_psm;
+    uint16_t credit;
+    uint16_t status;
+    uint16_t cid;
+    uint16_t len;
+    uint8_t data[512];
+};
+
+int out_take(struct out_rec *rec)
+{
+    struct ke_msg *msg;
+    void *p;
+
+    if (out_cnt == 0)
+    {
+        return 0;
+    }
+    msg = out[out_head];
+    out_head = (out_head + 1) % OUT_SIZE;
+    out_cnt--;
+    p = msg->param;
+    memset(rec, 0, sizeof(*rec));
+    rec->id = msg->id;
+    rec->conidx = KE_IDX_GET(msg->dest_id);
+
+    switch (msg->id)
+    {
+        case GAPC_LECB_CREATE_CMD:
+        {
+            struct gapc_lecb_create_cmd *cmd = p;
+            rec->operation = cmd->operation;
+            rec->le_psm = cmd->le_psm;
+            rec->credit = cmd->intial_credit;
+            rec->cid = cmd->cid;
+        } break;
+        case GAPC_LECB_DESTROY_CMD:
+        {
+            struct gapc_lecb_destroy_cmd *cmd = p;
+            rec->operation = cmd->operation;
+            rec->le_psm = cmd->le_psm;
+        } break;
+        case GAPC_LECB_CONNECT_CMD:
+        {
+            struct gapc_lecb_connect_cmd *cmd = p;
+            rec->operation = cmd->operation;
+            rec->le_psm = cmd->le_psm;
+            rec->credit = cmd->credit;
+        } break;
+        case GAPC_LECB_CONNECT_CFM:
+        {
+            struct gapc_lecb_connect_cfm *cfm = p;
+            rec->le_psm = cfm->le_psm;
+            rec->status = cfm->status;
+        } break;
+        case GAPC_LECB_DISCONNECT_CMD:
+        {
+            struct gapc_lecb_disconnect_cmd *cmd = p;
+            rec->operation = cmd->operation;
+            rec->le_psm = cmd->le_psm;
+        } break;
+        case GAPC_LECB_ADD_CMD:
+        {
+            struct gapc_lecb_add_cmd *cmd = p;
+            rec->operation = cmd->operation;
+            rec->le_psm = cmd->le_psm;
+            rec->credit = cmd->credit;
+        } break;
+        case L2CC_PDU_SEND_REQ:
+        {
+            struct l2cc_pdu_send_req *req = p;
+            rec->cid = req->pdu.chan_id;
+            rec->len = req->pdu.data.send_lecb_data_req.sdu_data_len;
+            rec->status = req->pdu.payld_len;
+            memcpy(rec->data, req->pdu.data.send_lecb_data_req.sdu_data, rec->len);
+        } break;
+        default:
+            break;
+    }
+    ke_msg_free(msg);
+    return 1;
+}
+
+// Delivers a message to the process handler, returns 1 if it handled it
+static int deliver(ke_msg_id_t id, ke_task_id_t src_id, void *param)
+{
+    enum ke_msg_status_tag ret = KE_MSG_CONSUMED;
+    enum process_event_response res = app_lecb_process_handler(id, param, TASK_APP, src_id, &ret);
+
+    if ((res == PR_EVENT_UNHANDLED) || (ret != KE_MSG_NO_FREE))
+    {
+        ke_msg_free(ke_param2msg(param));
+    }
+    return res == PR_EVENT_HANDLED;
+}
+
+int deliver_cmp_evt(uint8_t conidx, uint8_t operation, uint8_t status)
+{
+    struct gapc_cmp_evt *evt = KE_MSG_ALLOC(GAPC_CMP_EVT, TASK_APP, 0, gapc_cmp_evt);
+    evt->operation = operation;
+    evt->status = status;
+    return deliver(GAPC_CMP_EVT, KE_BUILD_ID(TASK_GAPC, conidx), evt);
+}
+
+int deliver_connect_req_ind(uint8_t conidx, uint16_t le_psm, uint16_t credit, uint16_t max_sdu, uint16_t cid)
+{
+    struct gapc_lecb_connect_req_ind *ind = KE_MSG_ALLOC(GAPC_LECB_CONNECT_REQ_IND, TASK_APP, 0,
+                                                         gapc_lecb_connect_req_ind);
+    ind->le_psm = le_psm;
+    ind->dest_credit = credit;
+    ind->max_sdu = max_sdu;
+    ind->dest_cid = cid;
+    return deliver(GAPC_LECB_CONNECT_REQ_IND, KE_BUILD_ID(TASK_GAPC, conidx), ind);
+}
+
+int deliver_connect_ind(uint8_t conidx, uint16_t le_psm, uint16_t credit, uint16_t max_sdu, uint16_t cid)
+{
+    struct gapc_lecb_connect_ind *ind = KE_MSG_ALLOC(GAPC_LECB_CONNECT_IND, TASK_APP, 0, gapc_lecb_connect_ind);
+    ind->le_psm = le_psm;
+    ind->dest_credit = credit;
+    ind->max_sdu = max_sdu;
+    ind->dest_cid = cid;
+    return deliver(GAPC_LECB_CONNECT_IND, KE_BUILD_ID(TASK_GAPC, conidx), ind);
+}
+
+int deliver_add_ind(uint8_t conidx, uint16_t le_psm, uint16_t src_credit, uint16_t dest_credit)
+{
+    struct gapc_lecb_add_ind *ind = KE_MSG_ALLOC(GAPC_LECB_ADD_IND, TASK_APP, 0, gapc_lecb_add_ind);
+    ind->le_psm = le_psm;
+    ind->src_credit = src_credit;
+    ind->dest_credit = dest_credit;
+    return deliver(GAPC_LECB_ADD_IND, KE_BUILD_ID(TASK_GAPC, conidx), ind);
+}
+
+int deliver_disconnect_ind(uint8_t conidx, uint16_t le_psm, uint16_t reason)
+{
+    struct gapc_lecb_disconnect_ind *ind = KE_MSG_ALLOC(GAPC_LECB_DISCONNECT_IND, TASK_APP, 0,
+                                                        gapc_lecb_disconnect_ind);
+    ind->le_psm = le_psm;
+    ind->reason = reason;
+    return deliver(GAPC_LECB_DISCONNECT_IND, KE_BUILD_ID(TASK_GAPC, conidx), ind);
+}
+
+int deliver_data_recv_ind(uint8_t conidx, uint16_t cid, uint16_t src_credit, const uint8_t *data, uint16_t len)
+{
+    struct l2cc_lecnx_data_recv_ind *ind = KE_MSG_ALLOC_DYN(L2CC_LECNX_DATA_RECV_IND, TASK_APP, 0,
+                                                            l2cc_lecnx_data_recv_ind, len);
+    ind->src_cid = cid;
+    ind->src_credit = src_credit;
+    ind->len = len;
+    memcpy(ind->data, data, len);
+    return deliver(L2CC_LECNX_DATA_RECV_IND, KE_BUILD_ID(TASK_L2CC, conidx), ind);
+}
+
+int deliver_pdu_send_rsp(uint8_t conidx, uint8_t status, uint16_t cid, uint16_t dest_credit)
+{
+    struct l2cc_data_send_rsp *rsp = KE_MSG_ALLOC(L2CC_PDU_SEND_RSP, TASK_APP, 0, l2cc_data_send_rsp);
+    rsp->status = status;
+    rsp->dest_cid = cid;
+    rsp->dest_credit = dest_credit;
+    return deliver(L2CC_PDU_SEND_RSP, KE_BUILD_ID(TASK_L2CC, conidx), rsp);
+}
+
+int deliver_link_disconnect_ind(uint8_t conidx, uint8_t reason)
+{
+    struct gapc_disconnect_ind *ind = KE_MSG_ALLOC(GAPC_DISCONNECT_IND, TASK_APP, 0, gapc_disconnect_ind);
+    ind->conhdl = conidx;
+    ind->reason = reason;
+    return deliver(GAPC_DISCONNECT_IND, KE_BUILD_ID(TASK_GAPC, conidx), ind);
+}
+
+// Application callbacks
+uint16_t accept_status = L2C_CB_CON_SUCCESS;
+
+#define HELD_MAX    32
+static const uint8_t *held[APP_EASY_MAX_ACTIVE_CONNECTION][HELD_MAX];
+static uint16_t held_len[APP_EASY_MAX_ACTIVE_CONNECTION][HELD_MAX];
+int held_cnt[APP_EASY_MAX_ACTIVE_CONNECTION];
+int held_overflow;
+
+// Callback log, read by the test: kind, conidx, le_psm, value, data
+struct cb_rec
+{
+    uint8_t kind;
+    uint8_t conidx;
+    uint16_t le_psm;
+    uint16_t value;
+    uint16_t len;
+    uint8_t data[512];
+};
+#define LOG_SIZE    64
+static struct cb_rec cb_log[LOG_SIZE];
+static int log_head, log_cnt;
+int log_overflow;
+
+static struct cb_rec *log_add(uint8_t kind, uint8_t conidx, uint16_t le_psm, uint16_t value)
+{
+    struct cb_rec *rec;
+
+    if (log_cnt == LOG_SIZE)
+    {
+        log_overflow++;
+        log_head = (log_head + 1) % LOG_SIZE;
+        log_cnt--;
+    }
+    rec = &cb_log[(log_head + log_cnt++) % LOG_SIZE];
+    rec->kind = kind;
+    rec->conidx = conidx;
+    rec->le_psm = le_psm;
+    rec->value = value;
+    rec->len = 0;
+    return rec;
+}
+
+int log_take(struct cb_rec *rec)
+{
+    if (log_cnt == 0)
+    {
+        return 0;
+    }
+    *rec = cb_log[log_head];
+    log_head = (log_head + 1) % LOG_SIZE;
+    log_cnt--;
+    return 1;
+}
+
+uint16_t harness_connect_req(uint8_t conidx, uint16_t le_psm, uint16_t peer_mtu)
+{
+    log_add('q', conidx, le_psm, peer_mtu);
+    return accept_status;
+}
+
+void harness_connected(uint8_t conidx, uint16_t le_psm, uint16_t peer_mtu)
+{
+    log_add('c', conidx, le_psm, peer_mtu);
+}
+
+void harness_disconnected(uint8_t conidx, uint16_t le_psm, uint16_t reason)
+{
+    log_add('d', conidx, le_psm, reason);
+}
+
+void harness_sdu_received(uint8_t conidx, const uint8_t *sdu, uint16_t len)
+{
+    struct cb_rec *rec = log_add('r', conidx, 0, 0);
+
+    rec->len = len;
+    memcpy(rec->data, sdu, len);
+    if (held_cnt[conidx] == HELD_MAX)
+    {
+        held_overflow++;
+        app_lecb_rx_release(conidx, sdu);
+        return;
+    }
+    held[conidx][held_cnt[conidx]] = sdu;
+    held_len[conidx][held_cnt[conidx]] = len;
+    held_cnt[conidx]++;
+}
+
+void harness_sdu_sent(uint8_t conidx, uint8_t status)
+{
+    log_add('s', conidx, 0, status);
+}
+
+// Releases the i-th SDU kept on a connection, returns its length
+int release(uint8_t conidx, int i)
+{
+    const uint8_t *sdu = held[conidx][i];
+    int len = held_len[conidx][i];
+
+    held_cnt[conidx]--;
+    held[conidx][i] = held[conidx][held_cnt[conidx]];
+    held_len[conidx][i] = held_len[conidx][held_cnt[conidx]];
+    app_lecb_rx_release(conidx, sdu);
+    return len;
+}
+
+// Allocates and sends an SDU, returns 0 if it is refused
+int send_sdu(uint8_t conidx, const uint8_t *data, uint16_t len)
+{
+    uint8_t *sdu = app_lecb_sdu_alloc(conidx, len);
+
+    if (sdu == NULL)
+    {
+        return 0;
+    }
+    memcpy(sdu, data, len);
+    app_lecb_sdu_send(conidx);
+    return 1;
+}
+
+uint8_t lecb_state(uint8_t conidx)
+{
+    return app_lecb_env[conidx].state;
+}
+
+int constant(const char *name)
+{
+#define C(x)    if (strcmp(name, #x) == 0) return (x)
+    C(APP_LECB_RX_CREDITS); C(APP_LECB_CREDIT_BATCH); C(APP_LECB_TX_PIPELINE);
+    C(APP_EASY_MAX_ACTIVE_CONNECTION);
+    C(APP_LECB_IDLE); C(APP_LECB_LISTENING); C(APP_LECB_CONNECTING); C(APP_LECB_CONNECTED);
+    C(APP_LECB_DISCONNECTING);
+    C(GAPC_LECB_CREATE_CMD); C(GAPC_LECB_DESTROY_CMD); C(GAPC_LECB_CONNECT_CMD); C(GAPC_LECB_CONNECT_CFM);
+    C(GAPC_LECB_DISCONNECT_CMD); C(GAPC_LECB_ADD_CMD); C(L2CC_PDU_SEND_REQ);
+    C(GAPC_LE_CB_CREATE); C(GAPC_LE_CB_DESTROY); C(GAPC_LE_CB_CONNECTION); C(GAPC_LE_CB_DISCONNECTION);
+    C(GAPC_LE_CB_ADDITION); C(GAPC_UPDATE_PARAMS);
+    C(L2C_CB_CON_SUCCESS); C(L2C_CB_CON_LEPSM_NOT_SUPP); C(L2C_CB_CON_INS_AUTH);
+    C(GAP_ERR_NO_ERROR); C(GAP_ERR_INVALID_PARAM);
+#undef C
+    return -1;
+}
+"""
+
+
+class Rec(ctypes.Structure):
+    _fields_ = [("id", ctypes.c_uint16), ("conidx", ctypes.c_uint8), ("operation", ctypes.c_uint8),
+                ("le_psm", ctypes.c_uint16), ("credit", ctypes.c_uint16), ("status", ctypes.c_uint16),
+                ("cid", ctypes.c_uint16), ("len", ctypes.c_uint16), ("data", ctypes.c_uint8 * 512)]
+
+
+class CbRec(ctypes.Structure):
+    _fields_ = [("kind", ctypes.c_uint8), ("conidx", ctypes.c_uint8), ("le_psm", ctypes.c_uint16),
+                ("value", ctypes.c_uint16), ("len", ctypes.c_uint16), ("data", ctypes.c_uint8 * 512)]
+
+
+def build(credits):
+    # The quoted includes of the module must find the stubs before the SDK headers
+    lib = host_c.build("lecb_credit_test", HARNESS, stubs=STUBS,
+                       copies=[os.path.join(LECB_SRC, name) for name in ("app_lecb.c", "app_lecb_task.c")],
+                       defines={"APP_EASY_MAX_ACTIVE_CONNECTION": CONNECTIONS, "APP_LECB_RX_CREDITS": credits},
+                       includes=INCLUDES)
+    lib.constant.argtypes = [ctypes.c_char_p]
+    lib.out_take.argtypes = [ctypes.POINTER(Rec)]
+    lib.log_take.argtypes = [ctypes.POINTER(CbRec)]
+    lib.send_sdu.argtypes = [ctypes.c_uint8, ctypes.c_char_p, ctypes.c_uint16]
+    lib.deliver_data_recv_ind.argtypes = [ctypes.c_uint8, ctypes.c_uint16, ctypes.c_uint16, ctypes.c_char_p,
+                                          ctypes.c_uint16]
+    lib.app_lecb_listen.restype = ctypes.c_bool
+    lib.app_lecb_connect.restype = ctypes.c_bool
+    lib.app_lecb_get_tx_credit.restype = ctypes.c_uint16
+    lib.app_lecb_sdu_credits.restype = ctypes.c_uint16
+    lib.lecb_state.restype = ctypes.c_uint8
+    return lib
+
+
+def sdu_credits(length, mps):
+    return (length + SDU_LEN_FIELD + mps - 1) // mps
+
+
+class Link:
+    """GAPC, L2CC and the peer of one connection."""
+
+    def __init__(self, conidx):
+        self.conidx = conidx
+        self.up = False
+        self.registered = None          # LE_PSM registered in GAPC
+        self.reg_credit = 0             # initial credits of the registration
+        self.open = False               # channel open in L2CC
+        self.cid = 0                    # channel identifier of the local side, seen by the peer
+        self.peer_mtu = 0
+        self.peer_credit = 0            # credits held by the peer (receive direction)
+        self.dest_credit = 0            # credits granted by the peer (transmit direction)
+        self.rx_frames = collections.deque()    # K-frames of the SDU the peer is sending
+        self.rx_reasm = 0               # K-frames of it already received
+        self.rx_next = None             # SDU the peer is sending
+        self.rx_expected = collections.deque()  # SDUs reassembled, not yet seen by the application
+        self.tx_queue = collections.deque()     # SDUs in L2CC: [data, frames left]
+        self.tx_expected = collections.deque()  # SDUs sent by the application, not yet at the peer
+        self.peer_consumed = 0          # K-frames received by the peer, credits not yet returned
+        self.requested = None           # MTU and credits of a channel request of the peer
+        self.app_open = False           # channel reported open to the application
+        self.app_closing = False        # channel closed by the application, not yet reported
+        self.closed_reported = False    # no channel since the last one was reported closed
+        self.cfm_status = None          # answer to the last channel request of the peer
+        self.tx_unanswered = 0          # SDUs taken by the module and not yet reported sent
+        self.app_listen = False         # the application listens (True) or connects (False)
+        self.held = []                  # channel and credits of the SDUs kept by the application
+        self.gen = 0                    # channels opened on the link
+        self.seq = 0
+
+
+class Test:
+    def __init__(self, lib, rnd, mps, mtu):
+        self.lib = lib
+        self.rnd = rnd
+        self.mps = mps
+        self.mtu = mtu
+        lib_c = lambda name: lib.constant(name.encode())
+        self.c = {name: lib_c(name) for name in (
+            "APP_LECB_RX_CREDITS", "APP_LECB_TX_PIPELINE", "APP_LECB_CONNECTED", "APP_LECB_IDLE",
+            "APP_LECB_LISTENING", "APP_LECB_DISCONNECTING", "APP_LECB_CONNECTING",
+            "GAPC_LECB_CREATE_CMD", "GAPC_LECB_DESTROY_CMD",
+            "GAPC_LECB_CONNECT_CMD", "GAPC_LECB_CONNECT_CFM", "GAPC_LECB_DISCONNECT_CMD", "GAPC_LECB_ADD_CMD",
+            "L2CC_PDU_SEND_REQ", "GAPC_LE_CB_CREATE", "GAPC_LE_CB_DESTROY", "GAPC_LE_CB_CONNECTION",
+            "GAPC_LE_CB_DISCONNECTION", "GAPC_LE_CB_ADDITION", "GAPC_UPDATE_PARAMS", "L2C_CB_CON_SUCCESS",
+            "L2C_CB_CON_LEPSM_NOT_SUPP", "L2C_CB_CON_INS_AUTH", "GAP_ERR_NO_ERROR", "GAP_ERR_INVALID_PARAM")}
+        self.budget = self.c["APP_LECB_RX_CREDITS"]
+        self.pipeline = self.c["APP_LECB_TX_PIPELINE"]
+        ctypes.c_uint16.in_dll(lib, "max_mtu").value = mtu
+        ctypes.c_uint16.in_dll(lib, "max_mps").value = mps
+        self.links = [Link(i) for i in range(CONNECTIONS)]
+        self.to_app = collections.deque()       # messages to the application, in order
+        self.failures = []
+        self.stats = collections.Counter()
+        self.worst = 0
+
+    def fail(self, what):
+        if len(self.failures) < 100:
+            self.failures.append("credits %d, mps %d: %s" % (self.budget, self.mps, what))
+
+    # Stack: messages of the module, executed in order
+
+    def stack_take(self):
+        rec = Rec()
+        while self.lib.out_take(ctypes.byref(rec)):
+            self.execute(rec)
+
+    def execute(self, rec):
+        c = self.c
+        link = self.links[rec.conidx]
+        post = self.to_app.append
+        if not link.up:
+            # The commands of a link that is gone are dropped
+            return
+        if rec.id == c["GAPC_LECB_CREATE_CMD"]:
+            if rec.credit != self.budget:
+                self.fail("link %d: registration with %d credits" % (link.conidx, rec.credit))
+            if link.registered is not None:
+                self.fail("link %d: LE_PSM 0x%x registered again" % (link.conidx, rec.le_psm))
+            if link.registered is not None or self.rnd.random() < 0.03:
+                post(("cmp", link.conidx, c["GAPC_LE_CB_CREATE"], c["GAP_ERR_INVALID_PARAM"]))
+            else:
+                link.registered = rec.le_psm
+                link.reg_credit = rec.credit
+                post(("cmp", link.conidx, c["GAPC_LE_CB_CREATE"], c["GAP_ERR_NO_ERROR"]))
+                self.stats["registrations"] += 1
+        elif rec.id == c["GAPC_LECB_DESTROY_CMD"]:
+            ok = link.registered == rec.le_psm and not link.open
+            if ok:
+                link.registered = None
+            post(("cmp", link.conidx, c["GAPC_LE_CB_DESTROY"],
+                  c["GAP_ERR_NO_ERROR"] if ok else c["GAP_ERR_INVALID_PARAM"]))
+        elif rec.id == c["GAPC_LECB_CONNECT_CMD"]:
+            if rec.credit != self.budget:
+                self.fail("link %d: connection with %d credits" % (link.conidx, rec.credit))
+            # The peer accepts the channel most of the time
+            if link.registered == rec.le_psm and not link.open and self.rnd.random() < 0.9:
+                self.channel_open(link, rec.credit, self.peer_params())
+                post(("cmp", link.conidx, c["GAPC_LE_CB_CONNECTION"], c["GAP_ERR_NO_ERROR"]))
+            else:
+                post(("cmp", link.conidx, c["GAPC_LE_CB_CONNECTION"], c["L2C_CB_CON_INS_AUTH"]))
+        elif rec.id == c["GAPC_LECB_CONNECT_CFM"]:
+            params, link.requested = link.requested, None
+            link.cfm_status = rec.status
+            if rec.status == c["L2C_CB_CON_SUCCESS"]:
+                if link.registered != rec.le_psm or link.open or params is None:
+                    self.fail("link %d: channel accepted on LE_PSM 0x%x" % (link.conidx, rec.le_psm))
+                else:
+                    self.channel_open(link, link.reg_credit, params)
+        elif rec.id == c["GAPC_LECB_DISCONNECT_CMD"]:
+            if link.open:
+                self.channel_close(link)
+                post(("disc", link.conidx, rec.le_psm, 0x13))
+            post(("cmp", link.conidx, c["GAPC_LE_CB_DISCONNECTION"], c["GAP_ERR_NO_ERROR"]))
+        elif rec.id == c["GAPC_LECB_ADD_CMD"]:
+            if not link.open:
+                post(("cmp", link.conidx, c["GAPC_LE_CB_ADDITION"], c["GAP_ERR_INVALID_PARAM"]))
+                return
+            # The credits are sent to the peer with the execution of the command
+            link.peer_credit += rec.credit
+            self.stats["credit_commands"] += 1
+            self.check_budget(link)
+            post(("cmp", link.conidx, c["GAPC_LE_CB_ADDITION"], c["GAP_ERR_NO_ERROR"]))
+        elif rec.id == c["L2CC_PDU_SEND_REQ"]:
+            data = bytes(rec.data[:rec.len])
+            if not link.open:
+                return
+            if rec.cid != link.cid or rec.status != rec.len:
+                self.fail("link %d: SDU on channel %d, payload %d" % (link.conidx, rec.cid, rec.status))
+            if rec.len > link.peer_mtu:
+                self.fail("link %d: SDU of %d bytes for a peer MTU of %d" % (link.conidx, rec.len, link.peer_mtu))
+            link.tx_queue.append([data, sdu_credits(rec.len, self.mps)])
+            if len(link.tx_queue) > self.pipeline:
+                self.fail("link %d: %d SDUs in L2CC" % (link.conidx, len(link.tx_queue)))
+
+    def peer_params(self):
+        # MTU and initial credits of the peer
+        return self.rnd.randint(23, 300), self.rnd.randint(1, 10)
+
+    def peer_request(self, link):
+        # The peer opens the channel to the LE_PSM registered by the application
+        if link.open or link.requested is not None or link.registered is None:
+            return
+        link.requested = self.peer_params()
+        self.to_app.append(("req", link.conidx, link.registered) + link.requested)
+
+    def channel_open(self, link, credit, params):
+        link.open = True
+        link.gen += 1
+        link.cid = 0x40 + link.conidx
+        link.peer_mtu, link.dest_credit = params
+        link.peer_credit = credit
+        link.rx_frames.clear()
+        link.rx_reasm = 0
+        link.rx_next = None
+        link.tx_queue.clear()
+        link.peer_consumed = 0
+        self.to_app.append(("open", link.conidx, link.registered, link.dest_credit, link.peer_mtu, link.cid))
+        self.stats["channels"] += 1
+
+    def channel_close(self, link):
+        link.open = False
+        link.rx_frames.clear()
+        link.rx_reasm = 0
+        link.rx_next = None
+        link.tx_queue.clear()
+
+    # Peer and L2CC
+
+    def peer_send_frame(self, link):
+        if not link.open:
+            return
+        if link.rx_next is None:
+            link.seq += 1
+            # SDUs of the local MTU need the whole receive budget
+            length = self.mtu if self.rnd.random() < 0.2 else self.rnd.randint(1, self.mtu)
+            sdu = (link.seq.to_bytes(4, "little") + bytes(self.rnd.getrandbits(8) for _ in range(length)))[:length]
+            data = len(sdu).to_bytes(2, "little") + sdu
+            link.rx_next = sdu
+            link.rx_frames = collections.deque(data[i:i + self.mps] for i in range(0, len(data), self.mps))
+        if link.peer_credit == 0:
+            return
+        link.rx_frames.popleft()
+        link.peer_credit -= 1
+        link.rx_reasm += 1
+        self.stats["rx_frames"] += 1
+        if not link.rx_frames:
+            self.to_app.append(("sdu", link.conidx, link.cid, link.peer_credit, link.rx_next, link.gen))
+            link.rx_reasm = 0
+            link.rx_next = None
+
+    def stack_send_frame(self, link):
+        if not link.open or not link.tx_queue or link.dest_credit == 0:
+            return
+        link.dest_credit -= 1
+        link.peer_consumed += 1
+        head = link.tx_queue[0]
+        head[1] -= 1
+        if head[1] == 0:
+            link.tx_queue.popleft()
+            if not link.tx_expected:
+                self.fail("link %d: unexpected SDU at the peer" % link.conidx)
+            elif link.tx_expected[0] != head[0]:
+                self.fail("link %d: SDU of %d bytes at the peer instead of %d"
+                          % (link.conidx, len(head[0]), len(link.tx_expected[0])))
+                link.tx_expected.popleft()
+            else:
+                link.tx_expected.popleft()
+                self.stats["tx_sdus"] += 1
+            self.to_app.append(("rsp", link.conidx, link.cid, link.dest_credit))
+
+    def peer_return_credits(self, link):
+        if not link.open or link.peer_consumed == 0:
+            return
+        link.dest_credit += link.peer_consumed
+        link.peer_consumed = 0
+        self.to_app.append(("add", link.conidx, link.registered, link.dest_credit))
+
+    # Application side
+
+    def deliver(self):
+        lib = self.lib
+        kind, conidx = self.to_app[0][:2]
+        msg = self.to_app.popleft()
+        link = self.links[conidx]
+        if not link.up:
+            return
+        if kind == "cmp":
+            if not lib.deliver_cmp_evt(conidx, msg[2], msg[3]):
+                self.fail("link %d: completion of operation %d not handled" % (conidx, msg[2]))
+        elif kind == "req":
+            _, _, psm, mtu, credit = msg
+            refuse = self.rnd.random() < 0.05
+            ctypes.c_uint16.in_dll(lib, "accept_status").value = \
+                self.c["L2C_CB_CON_INS_AUTH"] if refuse else self.c["L2C_CB_CON_SUCCESS"]
+            listening = lib.lecb_state(conidx) == self.c["APP_LECB_LISTENING"]
+            link.cfm_status = None
+            link.closed_reported = False
+            lib.deliver_connect_req_ind(conidx, psm, credit, mtu, 0x40 + conidx)
+            self.stack_take()
+            if link.cfm_status is None:
+                self.fail("link %d: channel request not answered" % conidx)
+            elif listening and (link.cfm_status == self.c["L2C_CB_CON_SUCCESS"]) == refuse:
+                self.fail("link %d: channel request answered with 0x%x" % (conidx, link.cfm_status))
+        elif kind == "open":
+            _, _, psm, credit, mtu, cid = msg
+            lib.deliver_connect_ind(conidx, psm, credit, mtu, cid)
+            # The credits of the peer are exchanged with the connection
+            if lib.app_lecb_get_tx_credit(conidx) != credit and lib.lecb_state(conidx) == self.c["APP_LECB_CONNECTED"]:
+                self.fail("link %d: %d credits of the peer instead of %d"
+                          % (conidx, lib.app_lecb_get_tx_credit(conidx), credit))
+        elif kind == "disc":
+            lib.deliver_disconnect_ind(conidx, msg[2], msg[3])
+        elif kind in ("add", "rsp"):
+            connected = lib.lecb_state(conidx) == self.c["APP_LECB_CONNECTED"]
+            if kind == "add":
+                lib.deliver_add_ind(conidx, msg[2], 0, msg[3])
+            else:
+                lib.deliver_pdu_send_rsp(conidx, 0, msg[2], msg[3])
+            if connected and lib.app_lecb_get_tx_credit(conidx) != msg[3]:
+                self.fail("link %d: %d credits of the peer instead of %d"
+                          % (conidx, lib.app_lecb_get_tx_credit(conidx), msg[3]))
+        elif kind == "sdu":
+            _, _, cid, src_credit, sdu, gen = msg
+            link.rx_expected.append((gen, sdu))
+            lib.deliver_data_recv_ind(conidx, cid, src_credit, sdu, len(sdu))
+        self.callbacks()
+        self.stack_take()
+
+    def callbacks(self):
+        rec = CbRec()
+        while self.lib.log_take(ctypes.byref(rec)):
+            link = self.links[rec.conidx]
+            if rec.kind == ord("c"):
+                if link.app_open:
+                    self.fail("link %d: channel reported open twice" % rec.conidx)
+                link.app_open = True
+                link.app_closing = False
+                link.closed_reported = False
+                link.rx_expected.clear()
+                link.tx_expected.clear()
+                link.tx_unanswered = 0
+                self.stats["opened"] += 1
+            elif rec.kind == ord("d"):
+                if link.app_open:
+                    self.stats["closed"] += 1
+                elif link.closed_reported:
+                    self.fail("link %d: channel reported closed twice" % rec.conidx)
+                link.closed_reported = True
+                link.app_open = False
+                link.rx_expected.clear()
+                link.tx_expected.clear()
+                link.tx_unanswered = 0
+            elif rec.kind == ord("s"):
+                link.tx_unanswered = max(link.tx_unanswered - 1, 0)
+            elif rec.kind == ord("r"):
+                sdu = bytes(rec.data[:rec.len])
+                gen = link.rx_expected[0][0] if link.rx_expected else link.gen
+                link.held.append((gen, sdu_credits(rec.len, self.mps)))
+                if not link.app_open:
+                    self.fail("link %d: SDU received on a closed channel" % rec.conidx)
+                elif not link.rx_expected or link.rx_expected[0][1] != sdu:
+                    self.fail("link %d: SDU of %d bytes received out of order or corrupted" % (rec.conidx, rec.len))
+                else:
+                    self.stats["rx_sdus"] += 1
+                if link.rx_expected:
+                    link.rx_expected.popleft()
+
+    def app_release(self, link, all_of_them=False):
+        lib = self.lib
+        cnt = (ctypes.c_int * CONNECTIONS).in_dll(lib, "held_cnt")
+        while cnt[link.conidx]:
+            i = self.rnd.randrange(cnt[link.conidx])
+            lib.release(link.conidx, i)
+            # The harness moves the last SDU to the released slot
+            link.held[i] = link.held[-1]
+            link.held.pop()
+            self.stack_take()
+            if not all_of_them:
+                break
+
+    def app_send(self, link):
+        lib = self.lib
+        length = self.rnd.randint(1, link.peer_mtu + 20 if link.peer_mtu else 40)
+        link.seq += 1
+        data = (link.seq.to_bytes(4, "little") + bytes(self.rnd.getrandbits(8) for _ in range(length)))[:length]
+        expected = link.app_open and not link.app_closing and length <= link.peer_mtu and link.tx_unanswered < self.pipeline
+        ok = lib.send_sdu(link.conidx, data, length)
+        if ok != expected:
+            self.fail("link %d: SDU of %d bytes %s, %d pending, peer MTU %d"
+                      % (link.conidx, length, "taken" if ok else "refused", link.tx_unanswered, link.peer_mtu))
+        if ok:
+            link.tx_expected.append(data)
+            link.tx_unanswered += 1
+            self.stats["tx_taken"] += 1
+        else:
+            self.stats["tx_refused"] += 1
+        self.stack_take()
+
+    def check_budget(self, link):
+        if not link.open:
+            return
+        # The SDUs of a previous channel do not use the credits of this one
+        total = link.peer_credit + link.rx_reasm + sum(c for gen, c in link.held if gen == link.gen)
+        total += sum(sdu_credits(len(m[4]), self.mps) for m in self.to_app if m[0] == "sdu" and m[1] == link.conidx)
+        self.worst = max(self.worst, total)
+        if total > self.budget:
+            self.fail("link %d: %d K-frames outstanding for a budget of %d" % (link.conidx, total, self.budget))
+        # The peer waits for credits while the application holds nothing and no message is
+        # on its way
+        if (link.peer_credit == 0 and link.app_open and not link.app_closing and
+                not any(gen == link.gen for gen, c in link.held) and
+                not any(m[1] == link.conidx for m in self.to_app)):
+            self.fail("link %d: stalled, no credit returned to the peer" % link.conidx)
+
+    # Links
+
+    def link_up(self, link):
+        link.up = True
+        link.registered = None
+        link.open = False
+        link.requested = None
+        link.app_open = False
+        link.tx_unanswered = 0
+        link.held = []
+        link.app_listen = self.rnd.random() < 0.7
+        link.peer_mtu = 0
+        self.app_start(link)
+
+    def app_start(self, link):
+        lib = self.lib
+        link.closed_reported = False
+        if link.app_listen:
+            ok = lib.app_lecb_listen(link.conidx, LE_PSM, 0)
+        else:
+            ok = lib.app_lecb_connect(link.conidx, LE_PSM, 0)
+        if not ok:
+            self.fail("link %d: channel refused in state %d" % (link.conidx, lib.lecb_state(link.conidx)))
+        self.stack_take()
+
+    def link_down(self, link):
+        lib = self.lib
+        was_open = link.app_open
+        self.channel_close(link)
+        link.registered = None
+        link.requested = None
+        link.up = False
+        # Messages of the link still queued are dropped by the kernel
+        self.to_app = collections.deque(m for m in self.to_app if m[1] != link.conidx)
+        if lib.deliver_link_disconnect_ind(link.conidx, 0x13):
+            self.fail("link %d: GAPC_DISCONNECT_IND not passed on" % link.conidx)
+        self.callbacks()
+        if was_open and link.app_open:
+            self.fail("link %d: channel not reported closed with the link" % link.conidx)
+        link.app_open = False
+        self.stack_take()
+        # SDUs kept by the application are released after the link is gone
+        self.app_release(link, all_of_them=True)
+        if lib.lecb_state(link.conidx) != self.c["APP_LECB_IDLE"]:
+            self.fail("link %d: state %d after the disconnection" % (link.conidx, lib.lecb_state(link.conidx)))
+        self.stats["link_drops"] += 1
+
+    def step(self):
+        rnd = self.rnd
+        link = self.links[rnd.randrange(CONNECTIONS)]
+        r = rnd.random()
+        if not link.up:
+            if r < 0.05:
+                self.link_up(link)
+            return
+        state = self.lib.lecb_state(link.conidx)
+        if r < 0.25:
+            self.peer_send_frame(link)
+        elif r < 0.40:
+            self.stack_send_frame(link)
+        elif r < 0.47:
+            self.peer_return_credits(link)
+        elif r < 0.70:
+            if self.to_app:
+                self.deliver()
+        elif r < 0.82:
+            if link.held and rnd.random() < 0.8:
+                self.app_release(link)
+        elif r < 0.90:
+            # Now and then on a channel that is not open
+            if link.app_open or rnd.random() < 0.1:
+                self.app_send(link)
+        elif r < 0.902:
+            # The peer closes the channel
+            if link.open:
+                self.channel_close(link)
+                self.to_app.append(("disc", link.conidx, link.registered, 0x13))
+                self.stats["peer_closes"] += 1
+        elif r < 0.904:
+            self.lib.app_lecb_disconnect(link.conidx)
+            link.app_closing = True
+            self.stack_take()
+            self.stats["app_closes"] += 1
+            # The link drops now and then while the channel is being closed
+            if rnd.random() < 0.3:
+                for _ in range(rnd.randrange(len(self.to_app) + 1)):
+                    self.deliver()
+                self.link_down(link)
+        elif r < 0.905:
+            self.link_down(link)
+        elif r < 0.91:
+            if link.app_listen:
+                self.peer_request(link)
+        elif r < 0.92:
+            # The application opens a new channel once the previous one is gone
+            if state == self.c["APP_LECB_IDLE"]:
+                self.app_start(link)
+        elif r < 0.925:
+            # The GAP operations are left to the GAP process handler
+            if self.lib.deliver_cmp_evt(link.conidx, self.c["GAPC_UPDATE_PARAMS"], 0):
+                self.fail("link %d: GAP completion handled" % link.conidx)
+        self.check_budget(link)
+
+    def drain(self):
+        """Releases every SDU and runs the stack until nothing moves."""
+        for _ in range(1000):
+            moved = bool(self.to_app)
+            # Messages the deliveries cause wait for the next round
+            for _ in range(len(self.to_app)):
+                self.deliver()
+            for link in self.links:
+                if not link.up:
+                    continue
+                if link.held:
+                    self.app_release(link, all_of_them=True)
+                    moved = True
+                before = (link.peer_credit, link.dest_credit, len(link.tx_queue), link.rx_reasm)
+                # The peer stops sending new SDUs, the one being sent is completed
+                if link.rx_next is not None:
+                    self.peer_send_frame(link)
+                self.stack_send_frame(link)
+                self.peer_return_credits(link)
+                if before != (link.peer_credit, link.dest_credit, len(link.tx_queue), link.rx_reasm):
+                    moved = True
+                self.check_budget(link)
+            if not moved:
+                break
+        for link in self.links:
+            if not link.up or not link.open:
+                continue
+            if link.rx_next is not None:
+                self.fail("link %d: SDU of the peer stalled with %d credits" % (link.conidx, link.peer_credit))
+            elif link.peer_credit != self.budget:
+                self.fail("link %d: %d of %d credits back with the peer" % (link.conidx, link.peer_credit, self.budget))
+            if link.tx_queue or link.tx_expected:
+                self.fail("link %d: %d SDUs not sent" % (link.conidx, len(link.tx_expected)))
+
+    def run(self, steps):
+        for link in self.links:
+            self.link_up(link)
+        for _ in range(steps):
+            self.step()
+        self.drain()
+        for link in self.links:
+            if link.up:
+                self.link_down(link)
+        while self.to_app:
+            self.deliver()
+        lib = self.lib
+        for name, what in (("live_msgs", "messages leaked"), ("assert_warnings", "assertions"),
+                           ("out_overflow", "messages beyond the output queue"),
+                           ("held_overflow", "SDUs beyond the harness"), ("log_overflow", "callbacks lost")):
+            value = ctypes.c_int.in_dll(lib, name).value
+            if value:
+                self.fail("%d %s" % (value, what))
+        if self.stats["opened"] != self.stats["closed"]:
+            self.fail("%d channels opened, %d reported closed" % (self.stats["opened"], self.stats["closed"]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--steps", type=int, default=100000, help="events per run")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    failures = []
+    for credits, mps, mtu in CONFIGS:
+        lib = build(credits)
+        test = Test(lib, random.Random(args.seed * 100 + credits), mps, mtu)
+        if lib.app_lecb_sdu_credits(mtu) > credits:
+            sys.exit("an SDU of %d bytes does not fit in %d credits of %d bytes" % (mtu, credits, mps))
+        test.run(args.steps)
+        s = test.stats
+        print("credits %2d, mps %3d, mtu %3d: %4d channels, %6d SDUs received, %6d sent (%d refused), "
+              "%.2f credit commands per SDU, at most %d K-frames outstanding, %d peer closes, %d link drops"
+              % (credits, mps, mtu, s["opened"], s["rx_sdus"], s["tx_sdus"], s["tx_refused"],
+                 s["credit_commands"] / float(max(s["rx_sdus"], 1)), test.worst, s["peer_closes"],
+                 s["link_drops"]))
+        failures += test.failures
+
+    return host_c.report(failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,426 @@
+#!/usr/bin/env python3
+"""
+Simulation of the advertising events of the non-connectable advertising example, with
+the payload rotation of user_noncon.c and with the SDK 6.0.18 code kept in
+noncon_legacy.c.
+
+Both sources are built unmodified against stub headers. The simulator plays the easy
+timer and the GAP manager: a start command puts the payload on air after a start
+latency, a stop command takes it off air at once and reports GAP_ERR_CANCELED after a
+stop latency, an advertising data update applies from the next advertising event. The
+events are spaced by the advertising interval plus the random advDelay of 0 to 10ms.
+
+Events are lost while advertising is stopped: the lost count is the time off air
+divided by the mean event spacing of the last interval on air, so it does not depend on the
+random delays. For the rotation the simulator also checks that each payload stays on
+air for its repeat count of update periods, in the order of adv_rotation[], that every
+advertising event carries one of the rotation payloads at the interval of user_adv_conf,
+and that advertising is restarted only where the advertising type changes. The rotation
+fails if it loses more advertising events than the legacy code.
+
+    noncon_adv_sim.py
+    noncon_adv_sim.py --hours 24 --start-latency-ms 10 --stop-latency-ms 5
+"""
+
+import argparse
+import ctypes
+import os
+import random
+import re
+import sys
+
+import host_c
+
+EXAMPLE = os.path.join(host_c.SDK, "projects", "target_apps", "misc", "ble_app_noncon", "src")
+
+STUBS = {
+    "rwip_config.h": """
+#ifndef RWIP_CONFIG_H_
+#define RWIP_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#define __SECTION_ZERO(sec)
+#endif
+""",
+    "app.h": """
+#ifndef APP_H_
+#define APP_H_
+#include "rwip_config.h"
+#define ADV_DATA_LEN                0x1F
+#define SCAN_RSP_DATA_LEN           0x1F
+#define GAP_ERR_CANCELED            0x44
+#define GAP_AD_TYPE_COMPLETE_NAME   0x09
+#define GAP_AD_TYPE_SERVICE_16_BIT_DATA 0x16
+#define GAP_AD_TYPE_MANU_SPECIFIC_DATA 0xFF
+#define MS_TO_BLESLOTS(x)           ((int) (((x) * 1000) / 625))
+typedef uint8_t timer_hnd;
+#define EASY_TIMER_INVALID_TIMER    0
+struct gapm_start_advertise_cmd
+{
+    uint16_t intv_min;
+    uint16_t intv_max;
+    struct
+    {
+        struct
+        {
+            uint8_t adv_data_len;
+            uint8_t adv_data[ADV_DATA_LEN];
+            uint8_t scan_rsp_data_len;
+            uint8_t scan_rsp_data[SCAN_RSP_DATA_LEN];
+        } host;
+    } info;
+};
+struct advertise_configuration { uint16_t intv_min; uint16_t intv_max; };
+static const struct advertise_configuration user_adv_conf = {ADV_INTV_MIN, ADV_INTV_MAX};
+struct gapm_start_advertise_cmd *app_easy_gap_non_connectable_advertise_get_active(void);
+void app_easy_gap_non_connectable_advertise_start(void);
+void app_easy_gap_advertise_stop(void);
+void app_easy_gap_update_adv_data(const uint8_t *update_adv_data, uint8_t update_adv_data_len,
+                                  const uint8_t *update_scan_rsp_data, uint8_t update_scan_rsp_data_len);
+timer_hnd app_easy_timer(uint32_t delay, void (*fn)(void));
+void app_easy_timer_cancel(timer_hnd timer);
+#endif
+""",
+}
+
+EMPTY = ("gap.h", "app_easy_timer.h", "co_bt.h", "gapc_task.h", "app_task.h", "app_callback.h")
+
+HARNESS = r"""
+#include SOURCE
+
+/* GAP commands of the example, read back by the simulator */
+enum { OP_START = 1, OP_STOP, OP_UPDATE, OP_TIMER, OP_CANCEL };
+
+struct op
+{
+    uint8_t kind;
+    uint32_t delay;
+    uint16_t intv_min;
+    uint16_t intv_max;
+    uint8_t adv_len;
+    uint8_t adv[ADV_DATA_LEN];
+    uint8_t scan_len;
+    uint8_t scan[SCAN_RSP_DATA_LEN];
+};
+
+static struct op ops[8];
+static int op_cnt;
+static struct gapm_start_advertise_cmd adv_cmd;
+static void (*timer_fn)(void);
+
+static struct op *op_add(uint8_t kind)
+{
+    struct op *op = &ops[op_cnt < 8 ? op_cnt++ : 7];
+
+    memset(op, 0, sizeof(*op));
+    op->kind = kind;
+    return op;
+}
+
+int op_take(struct op *out)
+{
+    int n = op_cnt;
+
+    memcpy(out, ops, n * sizeof(struct op));
+    op_cnt = 0;
+    return n;
+}
+
+void sim_init(const uint8_t *adv, uint8_t adv_len, const uint8_t *scan, uint8_t scan_len)
+{
+    memset(&adv_cmd, 0, sizeof(adv_cmd));
+    adv_cmd.intv_min = user_adv_conf.intv_min;
+    adv_cmd.intv_max = user_adv_conf.intv_max;
+    adv_cmd.info.host.adv_data_len = adv_len;
+    memcpy(adv_cmd.info.host.adv_data, adv, adv_len);
+    adv_cmd.info.host.scan_rsp_data_len = scan_len;
+    memcpy(adv_cmd.info.host.scan_rsp_data, scan, scan_len);
+}
+
+void timer_fire(void)
+{
+    void (*fn)(void) = timer_fn;
+
+    timer_fn = NULL;
+    fn();
+}
+
+struct gapm_start_advertise_cmd *app_easy_gap_non_connectable_advertise_get_active(void)
+{
+    return &adv_cmd;
+}
+
+void app_easy_gap_non_connectable_advertise_start(void)
+{
+    struct op *op = op_add(OP_START);
+
+    op->intv_min = adv_cmd.intv_min;
+    op->intv_max = adv_cmd.intv_max;
+    op->adv_len = adv_cmd.info.host.adv_data_len;
+    memcpy(op->adv, adv_cmd.info.host.adv_data, op->adv_len);
+    op->scan_len = adv_cmd.info.host.scan_rsp_data_len;
+    memcpy(op->scan, adv_cmd.info.host.scan_rsp_data, op->scan_len);
+}
+
+void app_easy_gap_advertise_stop(void)
+{
+    op_add(OP_STOP);
+}
+
+void app_easy_gap_update_adv_data(const uint8_t *update_adv_data, uint8_t update_adv_data_len,
+                                  const uint8_t *update_scan_rsp_data, uint8_t update_scan_rsp_data_len)
+{
+    struct op *op = op_add(OP_UPDATE);
+
+    op->adv_len = update_adv_data_len;
+    memcpy(op->adv, update_adv_data, update_adv_data_len);
+    op->scan_len = update_scan_rsp_data_len;
+    memcpy(op->scan, update_scan_rsp_data, update_scan_rsp_data_len);
+}
+
+timer_hnd app_easy_timer(uint32_t delay, void (*fn)(void))
+{
+    op_add(OP_TIMER)->delay = delay;
+    timer_fn = fn;
+    return 1;
+}
+
+void app_easy_timer_cancel(timer_hnd timer)
+{
+    op_add(OP_CANCEL);
+    timer_fn = NULL;
+}
+
+#ifdef ROTATION
+int rotation_entry(int i, uint8_t *adv, uint8_t *adv_len, uint8_t *scan, uint8_t *scan_len, uint8_t *repeat)
+{
+    const struct adv_rotation_entry *entry = &adv_rotation[i];
+
+    *adv_len = entry->adv_ad_len;
+    memcpy(adv, entry->adv_ad, entry->adv_ad_len);
+    *scan_len = entry->scan_rsp_ad_len;
+    if (entry->scan_rsp_ad_len)
+    {
+        memcpy(scan, entry->scan_rsp_ad, entry->scan_rsp_ad_len);
+    }
+    *repeat = entry->repeat;
+    return ADV_ROTATION_LEN;
+}
+#endif
+"""
+
+OP_START, OP_STOP, OP_UPDATE, OP_TIMER, OP_CANCEL = 1, 2, 3, 4, 5
+GAP_ERR_CANCELED = 0x44
+SLOT_US = 625
+TICK_US = 10000
+ADV_DELAY_US = 10000
+DATA_LEN = 31
+
+
+class Op(ctypes.Structure):
+    _fields_ = [("kind", ctypes.c_uint8), ("delay", ctypes.c_uint32), ("intv_min", ctypes.c_uint16),
+                ("intv_max", ctypes.c_uint16), ("adv_len", ctypes.c_uint8), ("adv", ctypes.c_uint8 * DATA_LEN),
+                ("scan_len", ctypes.c_uint8), ("scan", ctypes.c_uint8 * DATA_LEN)]
+
+
+def adv_config():
+    """Advertising interval of user_adv_conf and advertising data of user_config.h."""
+    with open(os.path.join(EXAMPLE, "config", "user_config.h")) as f:
+        text = f.read()
+    intv = [float(v) for v in re.findall(r"\.intv_(?:min|max) = MS_TO_BLESLOTS\(([\d.]+)\)", text)[:2]]
+    name = re.search(r'#define USER_DEVICE_NAME\s+"([^"]*)"', text).group(1).encode()
+    # The advertising data is empty and the device name is added by the SDK
+    adv = bytes([len(name) + 1, 0x09]) + name
+    return [int(v * 1000 / SLOT_US) for v in intv], adv, b""
+
+
+def build(source, rotation, intv):
+    defines = {"SOURCE": '"%s"' % source, "ADV_INTV_MIN": intv[0], "ADV_INTV_MAX": intv[1]}
+    if rotation:
+        defines["ROTATION"] = None
+    lib = host_c.build("noncon_adv_sim", HARNESS, stubs=STUBS, empty=EMPTY, empty_text="#include \"app.h\"\n",
+                       defines=defines, includes=[EXAMPLE])
+    lib.op_take.argtypes = [ctypes.POINTER(Op)]
+    lib.sim_init.argtypes = [ctypes.c_char_p, ctypes.c_uint8, ctypes.c_char_p, ctypes.c_uint8]
+    lib.user_app_adv_nonconn_complete.argtypes = [ctypes.c_uint8]
+    return lib
+
+
+def rotation(lib, adv, scan):
+    """Payloads of adv_rotation[] as put on air: data and repeat count."""
+    payloads = []
+    n = 1
+    i = 0
+    while i < n:
+        ad = (ctypes.c_uint8 * DATA_LEN)()
+        sd = (ctypes.c_uint8 * DATA_LEN)()
+        ad_len, sd_len, repeat = ctypes.c_uint8(), ctypes.c_uint8(), ctypes.c_uint8()
+        n = lib.rotation_entry(i, ad, ctypes.byref(ad_len), sd, ctypes.byref(sd_len), ctypes.byref(repeat))
+        a = adv + (bytes(ad[:ad_len.value]) if len(adv) + ad_len.value <= DATA_LEN else b"")
+        s = scan + (bytes(sd[:sd_len.value]) if len(scan) + sd_len.value <= DATA_LEN else b"")
+        payloads.append(((a, s), max(repeat.value, 1)))
+        i += 1
+    return payloads
+
+
+class Sim:
+    def __init__(self, lib, rnd, args, intv, adv, scan):
+        self.lib = lib
+        self.rnd = rnd
+        self.default_intv = intv
+        self.start_lat = int(args.start_latency_ms * 1000)
+        self.stop_lat = int(args.stop_latency_ms * 1000)
+        self.now = 0
+        self.timer = None
+        self.complete = None
+        self.start = None
+        self.next_event = None
+        self.on_air = None
+        self.pending_update = None
+        self.intv = intv
+        self.failures = []
+        # Payload commanded at each update period, and the payloads sent
+        self.ticks = []
+        self.commanded = None
+        self.sent = {}
+        self.stats = {"events": 0, "lost": 0.0, "off_air_us": 0, "starts": 0, "stops": 0, "updates": 0}
+        lib.sim_init(adv, len(adv), scan, len(scan))
+        self.call(lib.user_app_adv_start)
+
+    def fail(self, what):
+        self.failures.append("%.3fs: %s" % (self.now / 1e6, what))
+
+    def call(self, fn, *args):
+        fn(*args)
+        ops = (Op * 8)()
+        for i in range(self.lib.op_take(ops)):
+            op = ops[i]
+            data = (bytes(op.adv[:op.adv_len]), bytes(op.scan[:op.scan_len]))
+            if op.kind == OP_START:
+                if self.on_air is not None or self.start is not None:
+                    self.fail("advertising started twice")
+                if op.intv_min > op.intv_max:
+                    self.fail("advertising interval %d..%d" % (op.intv_min, op.intv_max))
+                    op.intv_max = op.intv_min
+                self.stats["starts"] += 1
+                self.start = (self.now + self.start_lat, data, self.rnd.randint(op.intv_min, op.intv_max))
+                self.commanded = (data, op.intv_min)
+            elif op.kind == OP_STOP:
+                if self.on_air is None:
+                    self.fail("advertising stopped while not on air")
+                self.stats["stops"] += 1
+                self.on_air = None
+                self.pending_update = None
+                self.next_event = None
+                self.complete = self.now + self.stop_lat
+            elif op.kind == OP_UPDATE:
+                if self.on_air is None:
+                    self.fail("advertising data updated while not on air")
+                elif (len(data[1]) == 0) != (len(self.on_air[1]) == 0):
+                    self.fail("advertising type changed by an advertising data update")
+                self.stats["updates"] += 1
+                self.pending_update = data
+                self.commanded = (data, self.commanded[1])
+            elif op.kind == OP_TIMER:
+                if self.timer is not None:
+                    self.fail("timer started twice")
+                self.timer = self.now + op.delay * TICK_US
+            elif op.kind == OP_CANCEL:
+                self.timer = None
+
+    def advance(self, t):
+        # Events lost off air, at the mean spacing of the last interval on air
+        if self.on_air is None:
+            self.stats["off_air_us"] += t - self.now
+            self.stats["lost"] += (t - self.now) / (self.intv * SLOT_US + ADV_DELAY_US / 2)
+        self.now = t
+
+    def run(self, duration):
+        while True:
+            t, what = min((v, k) for k, v in (("timer", self.timer), ("complete", self.complete),
+                                              ("start", self.start and self.start[0]),
+                                              ("event", self.next_event), ("end", duration))
+                          if v is not None)
+            self.advance(t)
+            if what == "end":
+                break
+            if what == "timer":
+                self.timer = None
+                self.ticks.append(self.commanded)
+                self.call(self.lib.timer_fire)
+            elif what == "complete":
+                self.complete = None
+                self.call(self.lib.user_app_adv_nonconn_complete, GAP_ERR_CANCELED)
+            elif what == "start":
+                _, data, intv = self.start
+                self.start = None
+                self.on_air = data
+                self.intv = intv
+                self.next_event = self.now
+            elif what == "event":
+                if self.pending_update is not None:
+                    self.on_air = self.pending_update
+                    self.pending_update = None
+                self.stats["events"] += 1
+                key = (self.on_air, self.intv)
+                self.sent[key] = self.sent.get(key, 0) + 1
+                self.next_event = self.now + self.intv * SLOT_US + self.rnd.randrange(ADV_DELAY_US + 1)
+
+    def check_rotation(self, payloads, intv):
+        expected = []
+        for data, repeat in payloads:
+            expected += [(data, intv)] * repeat
+        for i, tick in enumerate(self.ticks):
+            if tick != expected[i % len(expected)]:
+                self.fail("update period %d: payload %r on air, expected %r" % (i, tick, expected[i % len(expected)]))
+                break
+        allowed = set((data, intv) for data, _ in payloads)
+        for key in self.sent:
+            if key not in allowed:
+                self.fail("advertising events with payload %r not in the rotation" % (key,))
+        # Restarts where the type changes, once per rotation
+        needed = sum(1 for i in range(len(payloads))
+                     if (len(payloads[i][0][1]) == 0) != (len(payloads[i - 1][0][1]) == 0))
+        cycle = sum(p[1] for p in payloads)
+        cycles = len(self.ticks) // cycle
+        if not (needed * cycles <= self.stats["stops"] <= needed * (cycles + 1)):
+            self.fail("%d restarts in %d rotations, %d needed per rotation" % (self.stats["stops"], cycles, needed))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--hours", type=float, default=1.0, help="simulated time")
+    parser.add_argument("--start-latency-ms", type=float, default=5.0,
+                        help="from the start command to the first advertising event")
+    parser.add_argument("--stop-latency-ms", type=float, default=2.5,
+                        help="from the stop command to its completion")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    intv, adv, scan = adv_config()
+    duration = int(args.hours * 3600e6)
+    failures = []
+    lost = {}
+    print("%-9s %9s %8s %9s %8s %8s %12s" % ("", "events", "lost", "lost/h", "restarts", "updates", "off air (ms)"))
+    for name, source, rot in (("legacy", os.path.join(host_c.HERE, "noncon_legacy.c"), False),
+                              ("rotation", os.path.join(EXAMPLE, "user_noncon.c"), True)):
+        lib = build(source, rot, intv)
+        sim = Sim(lib, random.Random(args.seed), args, intv[0], adv, scan)
+        sim.run(duration)
+        if rot:
+            sim.check_rotation(rotation(lib, adv, scan), intv[0])
+        s = sim.stats
+        lost[name] = s["lost"]
+        print("%-9s %9d %8.1f %9.2f %8d %8d %12.1f" % (name, s["events"], s["lost"], s["lost"] / args.hours,
+                                                       s["stops"], s["updates"], s["off_air_us"] / 1000.0))
+        failures += ["%s: %s" % (name, f) for f in sim.failures]
+    if lost["rotation"] > lost["legacy"]:
+        failures.append("rotation: %.1f advertising events lost, legacy %.1f" % (lost["rotation"], lost["legacy"]))
+
+    return host_c.report(failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
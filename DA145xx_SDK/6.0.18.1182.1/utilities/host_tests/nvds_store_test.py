@@ -0,0 +1,742 @@
+#!/usr/bin/env python3
+"""
+Host test of the NVDS flash store, nvds.c built with CFG_NVDS_FLASH_STORE.
+
+nvds.c is built unmodified against stub headers and an emulated SPI NOR flash: 4KB
+sectors erased to 0xFF, programming only clears bits, the memory protection bits of the
+status register block every program and erase, and every access is checked to happen
+while the flash is out of power down. The power is cut after a given number of steps, a
+step being a byte programmed or a sector erase, and an erase cut midway leaves a part of
+the sector erased.
+
+The checks:
+
+- random puts, unchanged puts and deletes of a set of tags read back as a reference
+  model has them, also after resets, with the defaults of nvds_get() for the tags not
+  stored
+- the records written are parsed from the flash image, with the CRC-8 computed here
+- a corrupted last record is dropped at the next reset, the tag reads its previous value
+- sector images written here: the valid sector with the highest generation wins, also
+  across the wrap of the generation, a sector whose magic was cleared is ignored, and the
+  store keeps working through compactions from a generation close to the wrap
+- the power is cut at every step of a compaction, with and without the other sector
+  erased beforehand, and of the put that erases it: after the reset every tag reads its
+  value from before or after the put, a put that returned NVDS_OK reads its new value
+- the memory protection and the power state of the flash are what they were before each
+  access, an unchanged put and a get program and erase nothing
+- no put erases more than one sector
+
+    nvds_store_test.py
+    nvds_store_test.py --ops 100000 --seed 3
+"""
+
+import argparse
+import ctypes
+import os
+import random
+import sys
+
+import host_c
+
+STUBS = {
+    "rwip_config.h": """
+#ifndef RWIP_CONFIG_H_
+#define RWIP_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#define __SECTION_ZERO(sec)
+#endif
+""",
+    "arch.h": """
+#ifndef ARCH_H_
+#define ARCH_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#define DRIFT_500PPM                        (500)
+#define CFG_NVDS_TAG_BD_ADDRESS             {0x03, 0xAB, 0x70, 0xCA, 0xEA, 0x80}
+#define CFG_NVDS_TAG_LPCLK_DRIFT            DRIFT_500PPM
+#define CFG_NVDS_TAG_BLE_CA_TIMER_DUR       2000
+#define CFG_NVDS_TAG_BLE_CRA_TIMER_DUR      6
+#define CFG_NVDS_TAG_BLE_CA_MIN_RSSI        0x40
+#define CFG_NVDS_TAG_BLE_CA_NB_PKT          100
+#define CFG_NVDS_TAG_BLE_CA_NB_BAD_PKT      50
+#endif
+""",
+    "co_bt.h": """
+#ifndef CO_BT_H_
+#define CO_BT_H_
+#include <stdint.h>
+struct bd_addr
+{
+    uint8_t addr[6];
+};
+extern const struct bd_addr co_null_bdaddr;
+#endif
+""",
+    "co_math.h": """
+#ifndef CO_MATH_H_
+#define CO_MATH_H_
+#include <stdint.h>
+static inline uint32_t co_min(uint32_t a, uint32_t b)
+{
+    return (a < b) ? a : b;
+}
+#endif
+""",
+    "co_utils.h": """
+#ifndef CO_UTILS_H_
+#define CO_UTILS_H_
+#include <stdint.h>
+static inline uint32_t co_read32p(void const *ptr32)
+{
+    const uint8_t *p = (const uint8_t *)ptr32;
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+static inline void co_write32p(void const *ptr32, uint32_t value)
+{
+    uint8_t *p = (uint8_t *)ptr32;
+    p[0] = value;
+    p[1] = value >> 8;
+    p[2] = value >> 16;
+    p[3] = value >> 24;
+}
+#endif
+""",
+    "spi_flash.h": """
+#include <stdint.h>
+#include <stdbool.h>
+#define SPI_FLASH_SECTOR_SIZE           (4096)
+#define SPI_FLASH_MEM_PROT_NONE         (0)
+#define SPI_FLASH_MEM_PROT_MASK         (0x7C)
+#define SPI_FLASH_ERR_OK                (0)
+typedef enum
+{
+    SPI_FLASH_OP_SE = 0x20,
+} spi_flash_op_t;
+bool spi_flash_is_awake(void);
+int8_t spi_flash_wait_till_ready(void);
+uint16_t spi_flash_read_status_reg(void);
+int8_t spi_flash_auto_detect(uint8_t *dev_id);
+int8_t spi_flash_power_down(void);
+int8_t spi_flash_release_from_power_down(void);
+int8_t spi_flash_configure_memory_protection(uint8_t data);
+int8_t spi_flash_block_erase(uint32_t address, spi_flash_op_t erase_op);
+int8_t spi_flash_write_data(uint8_t *wr_data_ptr, uint32_t address, uint32_t size, uint32_t *actual_size);
+int8_t spi_flash_read_data(uint8_t *rd_data_ptr, uint32_t address, uint32_t size, uint32_t *actual_size);
+""",
+}
+
+HARNESS = """
+#include "nvds.c"
+
+const struct bd_addr co_null_bdaddr = {{0, 0, 0, 0, 0, 0}};
+struct bd_addr dev_bdaddr;
+
+/* SPI flash, the two sectors of the store */
+
+#define FLASH_SIZE      (CFG_NVDS_FLASH_OFFSET + 2 * SPI_FLASH_SECTOR_SIZE)
+
+static uint8_t flash[FLASH_SIZE];
+static bool flash_on;
+static int flash_misuse;
+static long flash_cut = -1;         /* steps before the power is cut, -1 never */
+static int flash_cut_erased;        /* bytes erased by an erase cut midway */
+unsigned long flash_steps;
+unsigned long flash_erases;
+int flash_prot;
+
+static bool flash_outside(uint32_t address, uint32_t size)
+{
+    return (address < CFG_NVDS_FLASH_OFFSET) || (address + size > FLASH_SIZE);
+}
+
+static bool flash_step(void)
+{
+    if (flash_cut == 0)
+    {
+        return false;
+    }
+    if (flash_cut > 0)
+    {
+        flash_cut--;
+    }
+    flash_steps++;
+    return true;
+}
+
+bool spi_flash_is_awake(void)
+{
+    return flash_on;
+}
+
+int8_t spi_flash_wait_till_ready(void)
+{
+    flash_misuse += !flash_on;
+    return SPI_FLASH_ERR_OK;
+}
+
+uint16_t spi_flash_read_status_reg(void)
+{
+    flash_misuse += !flash_on;
+    return flash_prot;
+}
+
+int8_t spi_flash_auto_detect(uint8_t *dev_id)
+{
+    *dev_id = 0;
+    flash_misuse += !flash_on;
+    return SPI_FLASH_ERR_OK;
+}
+
+int8_t spi_flash_power_down(void)
+{
+    flash_misuse += !flash_on;
+    flash_on = false;
+    return SPI_FLASH_ERR_OK;
+}
+
+int8_t spi_flash_release_from_power_down(void)
+{
+    flash_on = true;
+    return SPI_FLASH_ERR_OK;
+}
+
+int8_t spi_flash_configure_memory_protection(uint8_t data)
+{
+    flash_misuse += !flash_on;
+    flash_prot = data & SPI_FLASH_MEM_PROT_MASK;
+    return SPI_FLASH_ERR_OK;
+}
+
+int8_t spi_flash_block_erase(uint32_t address, spi_flash_op_t erase_op)
+{
+    flash_misuse += !flash_on || (address % SPI_FLASH_SECTOR_SIZE) || flash_outside(address, SPI_FLASH_SECTOR_SIZE) ||
+                    (flash_prot != 0);
+    if (flash_prot != 0)
+    {
+        /* Ignored by the flash */
+        return SPI_FLASH_ERR_OK;
+    }
+    if (!flash_step())
+    {
+        memset(&flash[address], 0xFF, flash_cut_erased);
+        flash_cut_erased = 0;
+        return -1;
+    }
+    memset(&flash[address], 0xFF, SPI_FLASH_SECTOR_SIZE);
+    flash_erases++;
+    return SPI_FLASH_ERR_OK;
+}
+
+int8_t spi_flash_write_data(uint8_t *wr_data_ptr, uint32_t address, uint32_t size, uint32_t *actual_size)
+{
+    uint32_t i;
+
+    flash_misuse += !flash_on || flash_outside(address, size) || (flash_prot != 0);
+    for (i = 0; (i < size) && (flash_prot == 0); i++)
+    {
+        if (!flash_step())
+        {
+            flash_cut_erased = 0;
+            *actual_size = i;
+            return -1;
+        }
+        flash[address + i] &= wr_data_ptr[i];
+    }
+    *actual_size = size;
+    return SPI_FLASH_ERR_OK;
+}
+
+int8_t spi_flash_read_data(uint8_t *rd_data_ptr, uint32_t address, uint32_t size, uint32_t *actual_size)
+{
+    flash_misuse += !flash_on || flash_outside(address, size);
+    memcpy(rd_data_ptr, &flash[address], size);
+    *actual_size = size;
+    return SPI_FLASH_ERR_OK;
+}
+
+/* Test interface */
+
+int flash_state(void)
+{
+    return flash_misuse | (flash_on << 8);
+}
+
+void flash_set_power(int on)
+{
+    flash_on = on;
+}
+
+void flash_set_cut(long steps, int erased)
+{
+    flash_cut = steps;
+    flash_cut_erased = erased;
+}
+
+uint8_t *flash_store(void)
+{
+    return &flash[CFG_NVDS_FLASH_OFFSET];
+}
+
+int store_geometry(int which)
+{
+    return (which == 0) ? CFG_NVDS_FLASH_OFFSET : (which == 1) ? NVDS_STORE_SECTOR_SIZE : NVDS_STORE_TAG_NB;
+}
+
+/* Active sector (0 or 1), generation, write offset, formatted, dirty, standby erased */
+unsigned long store_state(int which)
+{
+    return (which == 0) ? (nvds_store_env.sector != CFG_NVDS_FLASH_OFFSET) :
+           (which == 1) ? nvds_store_env.generation : (which == 2) ? nvds_store_env.write_off :
+           (which == 3) ? nvds_store_env.formatted : (which == 4) ? nvds_store_env.dirty :
+           nvds_store_env.standby_erased;
+}
+
+/* The retention memory, kept over a sleep, lost over a reset */
+void store_env_save(uint8_t *out)
+{
+    memcpy(out, &nvds_store_env, sizeof(nvds_store_env));
+}
+
+void store_env_load(const uint8_t *in)
+{
+    memcpy(&nvds_store_env, in, sizeof(nvds_store_env));
+}
+
+int store_env_size(void)
+{
+    return sizeof(nvds_store_env);
+}
+
+void reset(void)
+{
+    memset(&nvds_store_env, 0, sizeof(nvds_store_env));
+    flash_cut = -1;
+    flash_on = false;
+    nvds_init_func(NULL, 0);
+}
+"""
+
+# nvds.h
+NVDS_OK, NVDS_FAIL, NVDS_TAG_NOT_DEFINED, NVDS_NO_SPACE_AVAILABLE, NVDS_LENGTH_OUT_OF_RANGE = range(5)
+NVDS_TAG_LPCLK_DRIFT = 0x07
+NVDS_TAG_BLE_CA_TIMER_DUR, NVDS_TAG_BLE_CRA_TIMER_DUR, NVDS_TAG_BLE_CA_MIN_RSSI = 0x40, 0x41, 0x42
+NVDS_TAG_BLE_CA_NB_PKT, NVDS_TAG_BLE_CA_NB_BAD_PKT = 0x43, 0x44
+
+# Values of the arch.h stub
+DEFAULTS = {NVDS_TAG_LPCLK_DRIFT: (500).to_bytes(2, "little"), NVDS_TAG_BLE_CA_TIMER_DUR: (2000).to_bytes(2, "little"),
+            NVDS_TAG_BLE_CRA_TIMER_DUR: bytes((6,)), NVDS_TAG_BLE_CA_MIN_RSSI: bytes((0x40,)),
+            NVDS_TAG_BLE_CA_NB_PKT: bytes((100,)), NVDS_TAG_BLE_CA_NB_BAD_PKT: bytes((50,))}
+
+# Store layout, see nvds.c
+MAGIC = 0x5344564E
+HDR_LEN, REC_HDR_LEN = 8, 4
+REC_VALUE, REC_DELETED = 0xA5, 0x5A
+
+PROT = (0, 0, 0x0C, 0x7C)
+
+
+def crc8(data, crc=0):
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def record(tag, value):
+    """A record as nvds.c writes it, value None for a delete."""
+    data = value or b""
+    hdr = bytes((tag, len(data), REC_VALUE if value is not None else REC_DELETED))
+    return hdr + bytes((crc8(data, crc8(hdr)),)) + data
+
+
+def sector_image(size, generation, records, magic=MAGIC):
+    img = (magic.to_bytes(4, "little") + (generation & 0xFFFFFFFF).to_bytes(4, "little") +
+           b"".join(record(tag, value) for tag, value in records))
+    return img + b"\xFF" * (size - len(img))
+
+
+def build():
+    nvds = os.path.join(host_c.SDK_SRC, "platform", "core_modules", "nvds")
+    lib = host_c.build("nvds_store_test", HARNESS, stubs=STUBS, defines={"CFG_NVDS_FLASH_STORE": None},
+                       includes=[os.path.join(nvds, "src"), os.path.join(nvds, "api")])
+    lib.nvds_put_func.argtypes = [ctypes.c_uint8, ctypes.c_uint8, ctypes.c_char_p]
+    lib.nvds_get_func.argtypes = [ctypes.c_uint8, ctypes.POINTER(ctypes.c_uint8), ctypes.c_char_p]
+    lib.nvds_del_func.argtypes = [ctypes.c_uint8]
+    lib.flash_set_cut.argtypes = [ctypes.c_long, ctypes.c_int]
+    lib.flash_store.restype = ctypes.POINTER(ctypes.c_uint8)
+    lib.store_state.restype = ctypes.c_ulong
+    return lib
+
+
+class Test:
+    def __init__(self, lib, rnd):
+        self.lib = lib
+        self.rnd = rnd
+        self.offset, self.sector_size, self.tag_nb = (lib.store_geometry(i) for i in range(3))
+        self.store = lib.flash_store()
+        self.env_size = lib.store_env_size()
+        self.failures = []
+        # A few tags hold long values, the live data always fits a sector
+        self.tags = sorted(rnd.sample([t for t in range(0x20, self.tag_nb) if t not in DEFAULTS], 14)) + \
+            [NVDS_TAG_LPCLK_DRIFT, NVDS_TAG_BLE_CA_NB_PKT]
+        self.long_tags = set(self.tags[:3])
+        self.model = {}
+        self.prot = 0
+        self.awake = False
+        self.steps = host_c.culong(lib, "flash_steps")
+        self.erases = host_c.culong(lib, "flash_erases")
+        self.flash_prot = host_c.cint(lib, "flash_prot")
+        self.stats = {"puts": 0, "unchanged": 0, "dels": 0, "resets": 0, "cuts": 0, "corrupted": 0,
+                      "compactions": 0, "max_erases": 0}
+
+    def fail(self, what):
+        self.failures.append(what)
+
+    # Flash
+
+    def image(self):
+        return ctypes.string_at(self.store, 2 * self.sector_size)
+
+    def load(self, img):
+        ctypes.memmove(self.store, img, len(img))
+
+    def snapshot(self):
+        env = (ctypes.c_uint8 * self.env_size)()
+        self.lib.store_env_save(env)
+        return self.image(), bytes(env), dict(self.model)
+
+    def restore(self, snap):
+        self.load(snap[0])
+        self.lib.store_env_load((ctypes.c_uint8 * self.env_size).from_buffer_copy(snap[1]))
+        self.model = dict(snap[2])
+
+    def reset(self):
+        self.lib.reset()
+        self.awake = False
+        self.stats["resets"] += 1
+
+    def check_flash(self, what):
+        state = self.lib.flash_state()
+        if state & 0xFF:
+            self.fail("%s: %d flash accesses while powered down or protected" % (what, state & 0xFF))
+        if bool(state >> 8) != self.awake:
+            self.fail("%s: flash %s, was %s before" % (what, "awake" if state >> 8 else "powered down",
+                                                       "awake" if self.awake else "powered down"))
+        if self.flash_prot.value != self.prot:
+            self.fail("%s: memory protection 0x%02X, was 0x%02X before" % (what, self.flash_prot.value, self.prot))
+
+    def prepare(self):
+        # Whatever protection and power state the application left, unprotected for the
+        # erase of a sector whose magic is cleared
+        self.prot = self.rnd.choice(PROT)
+        self.flash_prot.value = self.prot
+        self.awake = self.rnd.random() < 0.2
+        self.lib.flash_set_power(self.awake)
+
+    # Store
+
+    def get(self, tag):
+        buf = ctypes.create_string_buffer(255)
+        length = ctypes.c_uint8(255)
+        status = self.lib.nvds_get_func(tag, ctypes.byref(length), buf)
+        return buf.raw[:length.value] if status == NVDS_OK else None
+
+    def expected(self, tag, model=None):
+        model = self.model if model is None else model
+        return model[tag] if tag in model else DEFAULTS.get(tag)
+
+    def check_all(self, what, model=None):
+        for tag in self.tags:
+            got = self.get(tag)
+            if got != self.expected(tag, model):
+                self.fail("%s: tag 0x%02X reads %s, expected %s"
+                          % (what, tag, got and got.hex(), self.expected(tag, model) and self.expected(tag, model).hex()))
+                return False
+        return True
+
+    def value(self, tag):
+        if tag in self.long_tags and self.rnd.random() < 0.5:
+            n = self.rnd.randrange(100, 256)
+        else:
+            n = self.rnd.randrange(1, 33)
+        return bytes(self.rnd.randrange(256) for _ in range(n))
+
+    def apply(self, tag, value, cut=None):
+        """Puts a value, or deletes the tag for None. Returns the status."""
+        if cut is not None:
+            self.lib.flash_set_cut(cut, self.rnd.randrange(self.sector_size + 1))
+        generation = self.lib.store_state(1)
+        if value is None:
+            status = self.lib.nvds_del_func(tag)
+        else:
+            status = self.lib.nvds_put_func(tag, len(value), value)
+        if cut is None and self.lib.store_state(1) != generation:
+            self.stats["compactions"] += 1
+        return status
+
+    def op(self, tag, value):
+        self.prepare()
+        erases, steps = self.erases.value, self.steps.value
+        unchanged = value is not None and self.model.get(tag) == value
+        status = self.apply(tag, value)
+        what = "%s tag 0x%02X" % ("del" if value is None else "put", tag)
+        self.check_flash(what)
+        erases = self.erases.value - erases
+        self.stats["max_erases"] = max(self.stats["max_erases"], erases)
+        if erases > 1:
+            self.fail("%s: %d sector erases" % (what, erases))
+        if value is None and tag not in self.model:
+            if status != NVDS_TAG_NOT_DEFINED:
+                self.fail("%s: status %d for a tag not stored" % (what, status))
+            return
+        if status != NVDS_OK:
+            self.fail("%s: status %d" % (what, status))
+            return
+        if unchanged:
+            self.stats["unchanged"] += 1
+            if self.steps.value != steps:
+                self.fail("%s: an unchanged value programmed the flash" % what)
+        self.stats["dels" if value is None else "puts"] += 1
+        if value is None:
+            del self.model[tag]
+        else:
+            self.model[tag] = value
+
+    def parse(self):
+        """Records of the active sector, checked with the CRC computed here."""
+        img = self.image()
+        start = self.lib.store_state(0) * self.sector_size
+        sector = img[start:start + self.sector_size]
+        if int.from_bytes(sector[:4], "little") != MAGIC or \
+                int.from_bytes(sector[4:8], "little") != self.lib.store_state(1):
+            self.fail("active sector header %s" % sector[:8].hex())
+            return
+        off, live = HDR_LEN, {}
+        while off < self.lib.store_state(2):
+            tag, length, typ, crc = sector[off:off + REC_HDR_LEN]
+            data = sector[off + REC_HDR_LEN:off + REC_HDR_LEN + length]
+            if typ not in (REC_VALUE, REC_DELETED) or crc8(data, crc8(sector[off:off + 3])) != crc:
+                self.fail("record at 0x%X: %s" % (off, sector[off:off + REC_HDR_LEN].hex()))
+                return
+            if typ == REC_VALUE:
+                live[tag] = data
+            else:
+                live.pop(tag, None)
+            off += REC_HDR_LEN + length
+        # A record cut by a reset stays until the next compaction
+        if not self.lib.store_state(4) and set(sector[off:]) - {0xFF}:
+            self.fail("data after the last record at 0x%X" % off)
+        if live != self.model:
+            self.fail("records of the flash image differ from the model")
+
+    def corrupt(self):
+        """Clears a bit of the last record, the tag must read its previous value after a reset."""
+        if not self.model:
+            return
+        tag = self.rnd.choice(sorted(self.model))
+        previous = dict(self.model)
+        self.op(tag, None if self.rnd.random() < 0.3 else self.value(tag))
+        if self.model == previous:
+            return
+        start = self.lib.store_state(0) * self.sector_size
+        end = start + self.lib.store_state(2)
+        img = bytearray(self.image())
+        off = start + HDR_LEN
+        while True:
+            n = REC_HDR_LEN + img[off + 1]
+            if off + n == end:
+                break
+            off += n
+        candidates = [i for i in range(off + 2, end) if img[i]]
+        pos = self.rnd.choice(candidates)
+        img[pos] &= img[pos] - 1
+        self.load(bytes(img))
+        self.reset()
+        self.model = previous
+        self.stats["corrupted"] += 1
+        if not self.lib.store_state(4):
+            self.fail("corrupted record not detected")
+        self.check_all("corrupted last record")
+
+    def cut(self, tag, value, snap=None, steps=None):
+        """Cuts the power during an operation from snap after steps of its steps, random
+        if None. Returns False if the check failed."""
+        snap = snap or self.snapshot()
+        if steps is None:
+            self.restore(snap)
+            before = self.steps.value
+            self.apply(tag, value)
+            total = self.steps.value - before
+            if total == 0:
+                self.restore(snap)
+                return True
+            steps = self.rnd.randrange(total)
+        self.restore(snap)
+        previous = dict(self.model)
+        status = self.apply(tag, value, steps)
+        self.reset()
+        self.stats["cuts"] += 1
+        after = dict(previous)
+        if value is None:
+            after.pop(tag, None)
+        else:
+            after[tag] = value
+        got = self.get(tag)
+        what = "power cut after %d steps of %s tag 0x%02X" % (steps, "del" if value is None else "put", tag)
+        if got == self.expected(tag, after):
+            self.model = after
+        elif status == NVDS_OK or got != self.expected(tag, previous):
+            self.fail("%s: %s, reads %s" % (what, "NVDS_OK" if status == NVDS_OK else "failed", got and got.hex()))
+            return False
+        return self.check_all(what)
+
+    def fill_to(self, predicate):
+        """Puts long values until predicate() holds, False if it never does."""
+        for _ in range(1000):
+            if predicate():
+                return True
+            tag = self.rnd.choice(sorted(self.long_tags))
+            self.op(tag, bytes(self.rnd.randrange(256) for _ in range(self.rnd.randrange(100, 256))))
+        return False
+
+    def sweep(self, what, tag, value):
+        """Cuts the power at every step of an operation. Returns its steps and sector erases."""
+        snap = self.snapshot()
+        before, erases = self.steps.value, self.erases.value
+        self.apply(tag, value)
+        total, erases = self.steps.value - before, self.erases.value - erases
+        for steps in range(total):
+            if not self.cut(tag, value, snap, steps):
+                self.fail("%s: power cut at step %d of %d" % (what, steps, total))
+                break
+        self.restore(snap)
+        self.op(tag, value)
+        return total, erases
+
+    def compaction_sweeps(self):
+        tag = sorted(self.long_tags)[0]
+        value = bytes(255)
+        fits = lambda: self.lib.store_state(2) + REC_HDR_LEN + len(value) > self.sector_size
+        half = lambda: self.lib.store_state(2) + REC_HDR_LEN + len(value) > self.sector_size // 2
+
+        # The put that erases the other sector
+        self.reset()
+        if not self.fill_to(half):
+            self.fail("store never half full")
+            return
+        if self.lib.store_state(5):
+            self.fail("other sector erased before the active one is half full")
+        self.sweep("erase of the other sector", tag, value)
+        if not self.lib.store_state(5):
+            self.fail("other sector not erased past half")
+
+        # The compaction once the other sector is erased, then after a reset that forgot it
+        for erased in (True, False):
+            if not self.fill_to(fits):
+                self.fail("store never full")
+                return
+            if not erased:
+                self.reset()
+            generation = self.lib.store_state(1)
+            total, erases = self.sweep("compaction", tag, bytes(self.rnd.randrange(256) for _ in range(255)))
+            if self.lib.store_state(1) != generation + 1:
+                self.fail("no compaction")
+            print("compaction %s: %d steps, %d sector erases"
+                  % ("with the other sector erased" if erased else "after a reset", total, erases))
+
+    def generations(self):
+        size = self.sector_size
+        tag = self.tags[0]
+        x, y = b"old", b"new"
+        cases = [
+            ("higher generation in the second sector", (7, [(tag, x)]), (8, [(tag, y)]), y),
+            ("higher generation in the first sector", (8, [(tag, y)]), (7, [(tag, x)]), y),
+            ("generation wrapped", (0xFFFFFFFF, [(tag, x)]), (0, [(tag, y)]), y),
+            ("magic cleared", (3, [(tag, x)]), (4, [(tag, y)], 0), x),
+            ("deleted", (3, [(tag, x), (tag, None)]), None, None),
+            ("blank", None, None, None),
+        ]
+        for what, a, b, want in cases:
+            img = b"".join(sector_image(size, s[0], s[1], *s[2:]) if s else b"\xFF" * size for s in (a, b))
+            self.load(img)
+            self.reset()
+            got = self.get(tag)
+            if got != want:
+                self.fail("%s: reads %s, expected %s" % (what, got, want))
+
+        # Compactions across the wrap of the generation
+        self.load(sector_image(size, 0xFFFFFFFE, []) + b"\xFF" * size)
+        self.reset()
+        self.model = {}
+        compactions = self.stats["compactions"]
+        while self.stats["compactions"] - compactions < 4 and not self.failures:
+            tag = self.rnd.choice(self.tags)
+            self.op(tag, self.value(tag))
+            if self.rnd.random() < 0.1:
+                self.reset()
+                self.check_all("reset across the generation wrap")
+        if self.lib.store_state(1) != 2:
+            self.fail("generation %d after 4 compactions from 0xFFFFFFFE" % self.lib.store_state(1))
+
+    def run(self, ops):
+        self.load(b"\xFF" * 2 * self.sector_size)
+        self.reset()
+        self.check_all("blank flash")
+        self.generations()
+        self.compaction_sweeps()
+        for i in range(ops):
+            if self.failures:
+                break
+            tag = self.rnd.choice(self.tags)
+            r = self.rnd.random()
+            if r < 0.55:
+                self.op(tag, self.value(tag))
+            elif r < 0.65:
+                self.op(tag, self.model.get(tag, self.value(tag)))
+            elif r < 0.75:
+                self.op(tag, None)
+            elif r < 0.80:
+                self.prepare()
+                got = self.get(tag)
+                self.check_flash("get")
+                if got != self.expected(tag):
+                    self.fail("get tag 0x%02X: %s" % (tag, got and got.hex()))
+            elif r < 0.85:
+                self.reset()
+                self.check_all("reset")
+            elif r < 0.95:
+                self.cut(tag, None if self.rnd.random() < 0.2 else self.value(tag))
+            elif r < 0.97:
+                self.corrupt()
+            else:
+                self.parse()
+        self.reset()
+        self.check_all("end")
+        self.parse()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--ops", type=int, default=20000, help="random operations")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    lib = build()
+    test = Test(lib, random.Random(args.seed))
+    test.run(args.ops)
+
+    s = test.stats
+    print("%d puts, %d unchanged, %d deletes, %d compactions, %d resets, %d power cuts, %d corrupted records"
+          % (s["puts"], s["unchanged"], s["dels"], s["compactions"], s["resets"], s["cuts"], s["corrupted"]))
+    print("sector erases per put: %d at most" % s["max_erases"])
+
+    return host_c.report(test.failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,221 @@
+/**
+ ****************************************************************************************
+ *
+ * @file prf_ntf_legacy.c
+ *
+ * @brief Notification split of the Cycling Power and Location and Navigation servers as
+ *        it was before prf_ntf_split(), for the comparison of prf_ntf_test.py.
+ *
+ * The bodies are the ones of cpps_split_meas_ntf() and lans_split_loc_speed_ntf() of
+ * SDK 6.0.18. The message allocation is replaced by a buffer given by the caller, the
+ * MTU is a parameter and the in-place shift uses memmove() as the host memcpy() may copy
+ * backwards.
+ *
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "rwip_config.h"
+#include "cpp_common.h"
+#include "lan_common.h"
+
+#define CPPS_IS_PRESENT(features, flag)     ((features & flag) == flag)
+#define LANS_IS_PRESENT(features, flag)     ((features & flag) == flag)
+
+/// Notification of the GATT send event command, value sized for the longest one
+struct legacy_ntf
+{
+    uint16_t length;
+    uint8_t value[64];
+};
+
+uint8_t legacy_cpps_split_meas_ntf(uint16_t mtu, struct legacy_ntf *meas_ntf1,
+                                   struct legacy_ntf *meas_ntf2)
+{
+    // Extract flags info
+    uint16_t flags = co_read16p(&meas_ntf1->value[0]);
+
+    meas_ntf2->length = CPP_CP_MEAS_NTF_MIN_LEN;
+
+    // Copy status flags
+    co_write16p(&meas_ntf2->value[0], (flags & (CPP_MEAS_PEDAL_POWER_BALANCE_REFERENCE |
+                                                CPP_MEAS_ACCUM_TORQUE_SOURCE |
+                                                CPP_MEAS_OFFSET_COMPENSATION_INDICATOR)));
+    // Copy Instantaneous power
+    memcpy(&meas_ntf2->value[2], &meas_ntf1->value[2], 2);
+
+    // Current position
+    uint8_t len = 0;
+
+    for (uint16_t feat = CPP_MEAS_PEDAL_POWER_BALANCE_PRESENT;
+            feat <= CPP_MEAS_OFFSET_COMPENSATION_INDICATOR;
+            feat <<= 1)
+    {
+        // First message fits within the MTU
+        if (meas_ntf1->length <= mtu - 3)
+        {
+            // Stop splitting
+            break;
+        }
+
+        if (CPPS_IS_PRESENT(flags, feat))
+        {
+            switch (feat)
+            {
+                case CPP_MEAS_PEDAL_POWER_BALANCE_PRESENT:
+                    // Copy uint8
+                    meas_ntf2->value[meas_ntf2->length] = meas_ntf1->value[CPP_CP_MEAS_NTF_MIN_LEN];
+                    len = 1;
+                    break;
+
+                case CPP_MEAS_ACCUM_TORQUE_PRESENT:
+                case CPP_MEAS_TOP_DEAD_SPOT_ANGLE_PRESENT:
+                case CPP_MEAS_ACCUM_ENERGY_PRESENT:
+                case CPP_MEAS_BOTTOM_DEAD_SPOT_ANGLE_PRESENT:
+                    // Copy uint16
+                    memcpy(&meas_ntf2->value[meas_ntf2->length], &meas_ntf1->value[CPP_CP_MEAS_NTF_MIN_LEN], 2);
+                    len = 2;
+                    break;
+
+                case CPP_MEAS_EXTREME_ANGLES_PRESENT:
+                    // Copy uint24
+                    memcpy(&meas_ntf2->value[meas_ntf2->length], &meas_ntf1->value[CPP_CP_MEAS_NTF_MIN_LEN], 3);
+                    len = 3;
+                    break;
+
+                case CPP_MEAS_CRANK_REV_DATA_PRESENT:
+                case CPP_MEAS_EXTREME_FORCE_MAGNITUDES_PRESENT:
+                case CPP_MEAS_EXTREME_TORQUE_MAGNITUDES_PRESENT:
+                    // Copy uint16 + uint16
+                    memcpy(&meas_ntf2->value[meas_ntf2->length], &meas_ntf1->value[CPP_CP_MEAS_NTF_MIN_LEN], 4);
+                    len = 4;
+                    break;
+
+                case CPP_MEAS_WHEEL_REV_DATA_PRESENT:
+                    // Copy uint32 + uint16
+                    memcpy(&meas_ntf2->value[meas_ntf2->length], &meas_ntf1->value[CPP_CP_MEAS_NTF_MIN_LEN], 6);
+                    len = 6;
+                    break;
+
+                default:
+                    len = 0;
+                    break;
+            }
+
+            if (len)
+            {
+                // Update values
+                meas_ntf2->length += len;
+                // Remove field and flags from the first ntf
+                meas_ntf1->length -= len;
+                memmove(&meas_ntf1->value[CPP_CP_MEAS_NTF_MIN_LEN],
+                        &meas_ntf1->value[CPP_CP_MEAS_NTF_MIN_LEN + len],
+                        meas_ntf1->length);
+                // Update flags
+                meas_ntf1->value[0] &= ~feat;
+                meas_ntf2->value[0] |= feat;
+            }
+        }
+    }
+
+    return meas_ntf2->length;
+}
+
+uint8_t legacy_lans_split_loc_speed_ntf(uint16_t mtu, struct legacy_ntf *loc_speed_ntf1,
+                                        struct legacy_ntf *loc_speed_ntf2)
+{
+    // Extract flags info
+    uint16_t flags = co_read16p(&loc_speed_ntf1->value[0]);
+
+    loc_speed_ntf2->length = LANP_LAN_LOC_SPEED_MIN_LEN;
+
+    // Copy status flags
+    co_write16p(&loc_speed_ntf2->value[0], (flags & (LANP_LSPEED_POSITION_STATUS_LSB |
+                                    LANP_LSPEED_POSITION_STATUS_MSB |
+                                    LANP_LSPEED_SPEED_AND_DISTANCE_FORMAT |
+                                    LANP_LSPEED_ELEVATION_SOURCE_LSB |
+                                    LANP_LSPEED_ELEVATION_SOURCE_MSB |
+                                    LANP_LSPEED_HEADING_SOURCE)));
+    // Current position
+    uint8_t len = 0;
+
+    for (uint16_t feat = LANP_LSPEED_INST_SPEED_PRESENT;
+            feat <= LANP_LSPEED_POSITION_STATUS_LSB;
+            feat <<= 1)
+    {
+        // First message fits within the MTU
+        if (loc_speed_ntf1->length <= mtu - 3)
+        {
+            // Stop splitting
+            break;
+        }
+
+        if (LANS_IS_PRESENT(flags, feat))
+        {
+            switch (feat)
+            {
+                case LANP_LSPEED_ROLLING_TIME_PRESENT:
+                    // Copy uint8
+                    loc_speed_ntf2->value[loc_speed_ntf2->length] =
+                            loc_speed_ntf1->value[LANP_LAN_LOC_SPEED_MIN_LEN];
+                    len = 1;
+                    break;
+
+                case LANP_LSPEED_INST_SPEED_PRESENT:
+                case LANP_LSPEED_HEADING_PRESENT:
+                    // Copy uint16
+                    memcpy(&loc_speed_ntf2->value[loc_speed_ntf2->length],
+                            &loc_speed_ntf1->value[LANP_LAN_LOC_SPEED_MIN_LEN],
+                            2);
+                    len = 2;
+                    break;
+
+                case LANP_LSPEED_TOTAL_DISTANCE_PRESENT:
+                case LANP_LSPEED_ELEVATION_PRESENT:
+                    // Copy uint24
+                    memcpy(&loc_speed_ntf2->value[loc_speed_ntf2->length],
+                            &loc_speed_ntf1->value[LANP_LAN_LOC_SPEED_MIN_LEN],
+                            3);
+                    len = 3;
+                    break;
+
+                case LANP_LSPEED_LOCATION_PRESENT:
+                    // Copy latitude and longitude
+                    memcpy(&loc_speed_ntf2->value[loc_speed_ntf2->length],
+                            &loc_speed_ntf1->value[LANP_LAN_LOC_SPEED_MIN_LEN],
+                            8);
+                    len = 8;
+                    break;
+
+                case LANP_LSPEED_UTC_TIME_PRESENT:
+                    // Copy time
+                    memcpy(&loc_speed_ntf2->value[loc_speed_ntf2->length],
+                            &loc_speed_ntf1->value[LANP_LAN_LOC_SPEED_MIN_LEN],
+                            7);
+                    len = 7;
+                    break;
+
+                default:
+                    len = 0;
+                    break;
+            }
+
+            if (len)
+            {
+                // Update values
+                loc_speed_ntf2->length += len;
+                // Remove field and flags from the first ntf
+                loc_speed_ntf1->length -= len;
+                memmove(&loc_speed_ntf1->value[LANP_LAN_LOC_SPEED_MIN_LEN],
+                        &loc_speed_ntf1->value[LANP_LAN_LOC_SPEED_MIN_LEN + len],
+                        loc_speed_ntf1->length);
+                // Update flags
+                loc_speed_ntf1->value[0] &= ~feat;
+                loc_speed_ntf2->value[0] |= feat;
+            }
+        }
+    }
+
+    return loc_speed_ntf2->length;
+}
@@ -0,0 +1,459 @@
+#!/usr/bin/env python3
+"""
+Host test of the notification split of the Cycling Power and Location and Navigation
+servers.
+
+prf_utils.c is built unmodified against stub headers, with the field tables and the
+packing functions of cpps.c and lans.c. prf_ntf_legacy.c holds the split functions
+prf_ntf_split() replaced. Both paths run the sequence of cpps_exe_operation() and
+lans_exe_operation(): mask the flags of the connection, pack into the notification,
+split when the value exceeds MTU - 3.
+
+For every combination of optional fields and status flags and every MTU from 23 to the
+first one that needs no split, the notifications must be equal byte for byte to the
+legacy ones, and prf_ntf_split() must not copy more bytes with memcpy() and memmove()
+than the legacy split. prf_ntf_split() writes the 16-bit flags where the legacy split
+wrote value[0] only; this makes no difference as the fields whose flag is in the second
+byte come last and are never moved at an MTU of 23 or more, which the comparison
+confirms.
+
+Measurements are then sent to populations of connections with random content masks and
+MTUs, each connection must get the legacy notifications.
+
+The benchmark times both paths on the host, copies done byte by byte as the host
+memcpy() costs more than these short copies: every field at the MTUs that split, where
+the split must not be slower than the legacy one by more than the margin, then one
+population. The bytes copied do not depend on
+the CPU; the time gives a ratio, not the Cortex-M0+ cycle count.
+
+    prf_ntf_test.py
+    prf_ntf_test.py --connections 8 --rounds 200000
+"""
+
+import argparse
+import ctypes
+import os
+import random
+import re
+import sys
+
+import host_c
+
+MTUS = (23, 27, 30, 40, 65, 247)
+PROFILE_NAMES = ("cpps", "lans")
+
+STUB_CONFIG = """
+#ifndef RWIP_CONFIG_H_
+#define RWIP_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#define BLE_SERVER_PRF          1
+#define BLE_CLIENT_PRF          0
+#define BLE_BATT_SERVER         0
+#define BLE_BATT_CLIENT         0
+#define BLE_TIP_SERVER          0
+#define BLE_AN_SERVER           0
+#define BLE_PAS_SERVER          0
+#define BLE_CP_SENSOR           1
+#define BLE_CP_COLLECTOR        0
+#define BLE_LN_SENSOR           1
+#define BLE_LN_COLLECTOR        0
+#define BLE_CONNECTION_MAX      8
+#define ARRAY_LEN(a)            (sizeof(a) / sizeof(a[0]))
+#define __ARRAY_EMPTY
+/* Byte copies, the call of the host memcpy() would dominate the short copies timed */
+#define memcpy(dst, src, len)   host_copy(dst, src, len)
+#define memmove(dst, src, len)  host_copy(dst, src, len)
+extern unsigned long host_copied;
+static inline void *host_copy(void *dst, const void *src, size_t len)
+{
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+    size_t i;
+    host_copied += len;
+    if (d < s)
+    {
+        for (i = 0; i < len; i++)
+        {
+            d[i] = s[i];
+        }
+    }
+    else
+    {
+        for (i = len; i > 0; i--)
+        {
+            d[i - 1] = s[i - 1];
+        }
+    }
+    return dst;
+}
+static inline uint16_t co_read16p(void const *ptr)
+{
+    const uint8_t *p = ptr;
+    return p[0] | (p[1] << 8);
+}
+static inline void co_write16p(void *ptr, uint16_t value)
+{
+    uint8_t *p = ptr;
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+}
+static inline void co_write24p(void *ptr, uint32_t value)
+{
+    uint8_t *p = ptr;
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+}
+static inline void co_write32p(void *ptr, uint32_t value)
+{
+    co_write16p(ptr, value & 0xFFFF);
+    co_write16p((uint8_t *)ptr + 2, value >> 16);
+}
+#endif
+"""
+
+STUBS = ("rwble_config.h", "ke_task.h", "ke_msg.h", "ke_mem.h", "co_error.h", "attm.h", "attm_db.h",
+         "gattc_task.h", "gap.h", "gapc.h", "gapc_task.h", "prf.h")
+
+HARNESS = """
+#include <time.h>
+#include "rwip_config.h"
+#include "prf_utils.h"
+#include "cpp_common.h"
+#include "lan_common.h"
+
+#define CPPS_IS_FEATURE_SUPPORTED(features, flag) ((features & flag) == flag)
+#define CPPS_IS_PRESENT(features, flag)           ((features & flag) == flag)
+#define CPPS_IS_SET(features, flag)               (features & flag)
+#define CPPS_IS_CLEAR(features, flag)             ((features & flag) == 0)
+#define LANS_IS_FEATURE_SUPPORTED(features, flag) ((features & flag) == flag)
+#define LANS_IS_PRESENT(features, flag)           ((features & flag) == flag)
+
+#undef PRF_ENV_GET
+#define PRF_ENV_GET(prf_id, type)   (&type##_env_data)
+
+struct cpps_env_tag
+{
+    uint32_t features;
+    uint32_t cumul_wheel_rev;
+};
+
+struct lans_env_tag
+{
+    uint32_t features;
+};
+
+static struct cpps_env_tag cpps_env_data = {CPP_FEAT_ALL_SUPP & ~CPP_FEAT_SENSOR_MEAS_CONTEXT, 0x12345678};
+static struct lans_env_tag lans_env_data = {LANP_FEAT_ALL_SUPP};
+
+%(source)s
+
+struct legacy_ntf
+{
+    uint16_t length;
+    uint8_t value[64];
+};
+
+uint8_t legacy_cpps_split_meas_ntf(uint16_t mtu, struct legacy_ntf *meas_ntf1, struct legacy_ntf *meas_ntf2);
+uint8_t legacy_lans_split_loc_speed_ntf(uint16_t mtu, struct legacy_ntf *ntf1, struct legacy_ntf *ntf2);
+
+static struct cpp_cp_meas cp_meas;
+static struct lanp_loc_speed loc_speed;
+
+/* Bytes copied with memcpy() and memmove() */
+unsigned long host_copied;
+
+/* New measurement: the values follow the seed, flags as given */
+void measurement(int prf, uint16_t flags, uint32_t seed)
+{
+    uint8_t *p = (prf == 0) ? (uint8_t *)&cp_meas : (uint8_t *)&loc_speed;
+    size_t size = (prf == 0) ? sizeof(cp_meas) : sizeof(loc_speed);
+    size_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        p[i] = seed >> 16;
+    }
+    if (prf == 0)
+    {
+        cp_meas.flags = flags;
+    }
+    else
+    {
+        loc_speed.flags = flags;
+    }
+}
+
+static uint8_t pack(int prf, uint16_t mask, uint8_t *value)
+{
+    uint16_t *flags = (prf == 0) ? &cp_meas.flags : &loc_speed.flags;
+    uint16_t saved = *flags;
+    uint8_t length;
+
+    *flags &= ~mask;
+    length = (prf == 0) ? cpps_pack_meas_ntf(&cp_meas, value) : lans_pack_loc_speed_ntf(&loc_speed, value);
+    *flags = saved;
+
+    return length;
+}
+
+/* Sequence of cpps_exe_operation() and lans_exe_operation() */
+void split_send(int prf, uint16_t mask, uint16_t mtu, struct legacy_ntf *ntf1, struct legacy_ntf *ntf2)
+{
+    static const struct prf_ntf_desc *const descs[2] = {&cpps_meas_ntf_desc, &lans_loc_speed_ntf_desc};
+
+    ntf1->length = pack(prf, mask, ntf1->value);
+    ntf2->length = 0;
+    if (ntf1->length > mtu - 3)
+    {
+        ntf1->length = prf_ntf_split(descs[prf], ntf1->value, ntf1->length, mtu - 3, ntf2->value,
+                                     &ntf2->length);
+    }
+}
+
+/* Same sequence with the split of SDK 6.0.18 */
+void legacy_send(int prf, uint16_t mask, uint16_t mtu, struct legacy_ntf *ntf1, struct legacy_ntf *ntf2)
+{
+    ntf1->length = pack(prf, mask, ntf1->value);
+    ntf2->length = 0;
+    if (ntf1->length > mtu - 3)
+    {
+        if (prf == 0)
+        {
+            legacy_cpps_split_meas_ntf(mtu, ntf1, ntf2);
+        }
+        else
+        {
+            legacy_lans_split_loc_speed_ntf(mtu, ntf1, ntf2);
+        }
+    }
+}
+
+/* Notifications of the benchmark, global so that the compiler keeps the stores */
+struct legacy_ntf bench_ntf1, bench_ntf2;
+
+/* Time to send a measurement to nb connections, in ns */
+double bench(int prf, int legacy, int nb, const uint16_t *masks, const uint16_t *mtus, uint16_t flags,
+             long rounds)
+{
+    struct timespec t0, t1;
+    long r;
+    int i;
+
+    measurement(prf, flags, 1);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (r = 0; r < rounds; r++)
+    {
+        for (i = 0; i < nb; i++)
+        {
+            if (legacy)
+            {
+                legacy_send(prf, masks[i], mtus[i], &bench_ntf1, &bench_ntf2);
+            }
+            else
+            {
+                split_send(prf, masks[i], mtus[i], &bench_ntf1, &bench_ntf2);
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / rounds;
+}
+"""
+
+
+class Ntf(ctypes.Structure):
+    _fields_ = [("length", ctypes.c_uint16), ("value", ctypes.c_uint8 * 64)]
+
+
+def source(path):
+    with open(path) as f:
+        return f.read()
+
+
+def extract(text, pattern, what):
+    m = re.search(pattern, text, re.S)
+    if m is None:
+        sys.exit("no %s found" % what)
+    return m.group(0)
+
+
+def profile_source(name):
+    """Field table, description and packing function of a profile, as written in its source."""
+    path = {"cpps": "cpp/cpps/src/cpps.c", "lans": "lan/lans/src/lans.c"}[name]
+    text = source(os.path.join(host_c.PROFILES, path))
+    tables = extract(text, r"static const struct prf_ntf_field \w+_fields\[\] =.*?\n};\n.*?"
+                           r"static const struct prf_ntf_desc \w+_desc =.*?\n};\n", name + " field table")
+    pack = extract(text, r"\nuint8_t %s_pack_\w+_ntf\(.*?\n}\n" % name, name + " packing function")
+    return tables + pack
+
+
+class Profile:
+    def __init__(self, index, name, text, consts):
+        self.index = index
+        self.name = name
+        self.present = [consts[f] for f, _ in re.findall(r"\{(\w+),\s*(\d+)\}", text)]
+        status = re.search(r"\.status_flags\s*=(.*?);", text, re.S).group(1)
+        self.status = [consts[f] for f in re.findall(r"\w+", status)]
+        self.all_present = sum(self.present)
+        self.all_status = sum(self.status)
+
+    def all_flags(self):
+        for p in range(1 << len(self.present)):
+            for s in range(1 << len(self.status)):
+                flags = 0
+                for i, flag in enumerate(self.present):
+                    if p & (1 << i):
+                        flags |= flag
+                for i, flag in enumerate(self.status):
+                    if s & (1 << i):
+                        flags |= flag
+                yield flags
+
+
+def profiles():
+    consts = {}
+    for path, prefix in (("cpp/cpp_common.h", "CPP_MEAS_"), ("lan/lan_common.h", "LANP_LSPEED_")):
+        text = source(os.path.join(host_c.PROFILES, path))
+        consts.update({k: int(v, 16) for k, v in re.findall(r"(%s\w+)\s*=\s*(0x[0-9A-Fa-f]+)" % prefix, text)})
+    return [Profile(i, name, profile_source(name), consts) for i, name in enumerate(PROFILE_NAMES)]
+
+
+def build():
+    # Built from the temporary directory so that prf_utils.h takes the stub of prf.h
+    harness = HARNESS % {"source": "".join(profile_source(name) for name in PROFILE_NAMES)}
+    tmp = host_c.stage("prf_ntf_test", harness, stubs={"rwip_config.h": STUB_CONFIG}, empty=STUBS,
+                       copies=[os.path.join(host_c.PROFILES, name) for name in ("prf_utils.c", "prf_utils.h")])
+    lib = host_c.compile_lib(tmp, "prf_ntf_test",
+                             sources=["prf_utils.c", os.path.join(host_c.HERE, "prf_ntf_legacy.c")],
+                             includes=[host_c.PROFILES, os.path.join(host_c.PROFILES, "cpp"),
+                                       os.path.join(host_c.PROFILES, "lan")],
+                             flags=["-fno-tree-loop-distribute-patterns"])
+    ntfp = ctypes.POINTER(Ntf)
+    lib.measurement.argtypes = [ctypes.c_int, ctypes.c_uint16, ctypes.c_uint32]
+    lib.split_send.argtypes = [ctypes.c_int, ctypes.c_uint16, ctypes.c_uint16, ntfp, ntfp]
+    lib.legacy_send.argtypes = [ctypes.c_int, ctypes.c_uint16, ctypes.c_uint16, ntfp, ntfp]
+    lib.bench.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.POINTER(ctypes.c_uint16),
+                          ctypes.POINTER(ctypes.c_uint16), ctypes.c_uint16, ctypes.c_long]
+    lib.bench.restype = ctypes.c_double
+    return lib
+
+
+class Connection:
+    def __init__(self):
+        self.ntf1, self.ntf2, self.old1, self.old2 = Ntf(), Ntf(), Ntf(), Ntf()
+
+    def send(self, lib, prof, mask, mtu, failures, what):
+        """Send with both paths, return the bytes copied by each."""
+        copied = host_c.culong(lib, "host_copied")
+        copied.value = 0
+        lib.split_send(prof.index, mask, mtu, self.ntf1, self.ntf2)
+        split = copied.value
+        copied.value = 0
+        lib.legacy_send(prof.index, mask, mtu, self.old1, self.old2)
+        legacy = copied.value
+        new = (bytes(self.ntf1.value[:self.ntf1.length]), bytes(self.ntf2.value[:self.ntf2.length]))
+        old = (bytes(self.old1.value[:self.old1.length]), bytes(self.old2.value[:self.old2.length]))
+        if new != old:
+            failures.append("%s %s: %s %s, legacy %s %s"
+                            % (prof.name, what, new[0].hex(), new[1].hex(), old[0].hex(), old[1].hex()))
+        elif split > legacy:
+            failures.append("%s %s: %d bytes copied, legacy %d" % (prof.name, what, split, legacy))
+        return split, legacy
+
+
+def check_all(lib, prof, failures):
+    con = Connection()
+    cases = split = 0
+    copied = [0, 0]
+    for flags in prof.all_flags():
+        for mtu in range(23, 64):
+            lib.measurement(prof.index, flags, flags)
+            new, old = con.send(lib, prof, 0, mtu, failures, "flags %04x MTU %d" % (flags, mtu))
+            cases += 1
+            if con.ntf2.length == 0:
+                break
+            split += 1
+            copied[0] += new
+            copied[1] += old
+        if failures:
+            return
+    print("%s: %d flags and MTU cases, %d split, %d bytes copied by the splits, legacy %d"
+          % (prof.name, cases, split, copied[0], copied[1]))
+
+
+def population(prof, rnd, nb):
+    masks = [0] + [rnd.randrange(1 << 16) & prof.all_present for _ in range(2)]
+    return [(rnd.choice(masks), rnd.choice(MTUS)) for _ in range(nb)]
+
+
+def check_connections(lib, prof, rnd, nb, failures):
+    con = Connection()
+    total = 0
+    for n in range(2000):
+        conns = population(prof, rnd, rnd.randrange(1, nb + 1))
+        lib.measurement(prof.index, rnd.randrange(1 << 16) & (prof.all_present | prof.all_status), n)
+        for mask, mtu in conns:
+            con.send(lib, prof, mask, mtu, failures, "mask %04x MTU %d" % (mask, mtu))
+        total += len(conns)
+        if failures:
+            return
+    print("%s: 2000 measurements, %d notifications" % (prof.name, total))
+
+
+def bench(lib, prof, legacy, conns, flags, rounds):
+    nb = len(conns)
+    masks = (ctypes.c_uint16 * nb)(*[m for m, _ in conns])
+    mtus = (ctypes.c_uint16 * nb)(*[m for _, m in conns])
+    # Best of three, the host schedules other work
+    return min(lib.bench(prof.index, legacy, nb, masks, mtus, flags, rounds) for _ in range(3))
+
+
+def bench(lib, prof, legacy, conns, flags, rounds):
+    nb = len(conns)
+    masks = (ctypes.c_uint16 * nb)(*[m for m, _ in conns])
+    mtus = (ctypes.c_uint16 * nb)(*[m for _, m in conns])
+    # Best of three, the host schedules other work
+    return min(lib.bench(prof.index, legacy, nb, masks, mtus, flags, rounds) for _ in range(3))
+
+
+def benchmark(lib, prof, rnd, nb, rounds, margin, failures):
+    flags = prof.all_present | prof.all_status
+    # Every field at the MTUs that split, then a population. The sends that need no split
+    # run the same code on both paths, so only the first is held to the margin.
+    runs = (("split", [(0, mtu) for mtu in MTUS[:3]]), ("%d connections" % nb, population(prof, rnd, nb)))
+    for n, (what, conns) in enumerate(runs):
+        legacy = bench(lib, prof, 1, conns, flags, rounds)
+        split = bench(lib, prof, 0, conns, flags, rounds)
+        print("%s: %s: legacy %.0f ns, split %.0f ns per measurement (x%.2f)"
+              % (prof.name, what, legacy, split, legacy / split))
+        if n == 0 and split > legacy * (1 + margin):
+            failures.append("%s: split %.0f ns, legacy %.0f ns" % (prof.name, split, legacy))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--connections", type=int, default=3, help="connections per measurement")
+    parser.add_argument("--rounds", type=int, default=100000, help="benchmark rounds")
+    parser.add_argument("--margin", type=float, default=0.1, help="benchmark slowdown allowed, 0.1 = 10%%")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    lib = build()
+    rnd = random.Random(args.seed)
+    failures = []
+    for prof in profiles():
+        check_all(lib, prof, failures)
+        check_connections(lib, prof, rnd, args.connections, failures)
+        if not failures:
+            benchmark(lib, prof, rnd, args.connections, args.rounds, args.margin, failures)
+
+    return host_c.report(failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,523 @@
+#!/usr/bin/env python3
+"""
+Host test of the DA14531 RF calibration scheduler of arch_system.c (CFG_RF_CAL_SCHED).
+
+arch_system.c is built unmodified against the SDK headers and the configuration of the
+HID-Gamepad-Digitizer example, once with CFG_RF_CAL_SCHED and once without it, for the
+default check of the DA14531. The register accesses go to an emulated register file,
+in which the BLE core base and fine time counters follow a microsecond clock. The
+exchange memory stub reports the time left to the next connection event, the GPADC stub
+returns the die temperature of a trace read through a noisy sensor with a 1 degree
+resolution, and rf_recalibration() takes the clock forward by the calibration time.
+
+A connection runs over each trace, mostly with short events and with bursts of long
+ones while data is streamed, and the base time counter wraps around after 10 minutes.
+conditionally_run_radio_cals() is called at the end of every event, as
+schedule_while_ble_on() does. The traces, or recorded ones given as CSV files of
+"seconds,celsius" lines:
+
+    office      a few degrees of slow drift around room temperature
+    ramp        a slow warm up by 40 degrees, then steady
+    outdoor     a device carried in and out every 10 minutes, 30 degree swings
+    heater      a fast thermal cycle, 40 degrees peak to peak every 2 minutes
+
+The drift is the true temperature minus the one of the last calibration. A calibration
+is late while the drift exceeds the threshold by more than the sensor resolution, and
+one overlaps an event when it does not end before the next event starts. The checks:
+
+- the scheduler may defer a calibration until the drift exceeds the threshold by
+  RF_CAL_SCHED_FORCE_DRIFT, past that it is not late for longer than the default check
+  is late at all
+- the scheduler keeps the drift of a fast ramp within the sensor resolution of the
+  threshold, by calibrating on the predicted crossing
+- the drift of a rise at RF_CAL_SCHED_MAX_SLOPE exceeds the threshold by a degree at
+  most, and a steady temperature is sampled every RF_CAL_SCHED_MAX_PERIOD
+- under a stream that leaves no gap long enough, the calibration runs once the drift
+  exceeds the threshold by RF_CAL_SCHED_FORCE_DRIFT
+- a calibration of the scheduler only overlaps an event when the drift exceeds the
+  threshold by RF_CAL_SCHED_FORCE_DRIFT
+- the temperature is only read in gaps of 4 slots, and the GPADC registers of the
+  application are given back
+- arch_rf_cal_get_stats() counts every sample and calibration, measures the time of the
+  calibrations to the microsecond, and covers the time of the samples across the wrap
+
+    rf_cal_sched_test.py                        7.5 ms interval, one hour per trace
+    rf_cal_sched_test.py --interval 30 --hours 4 --cal-us 2500
+    rf_cal_sched_test.py --trace bench_log.csv
+"""
+
+import argparse
+import ctypes
+import math
+import os
+import random
+import sys
+
+import host_c
+
+SLOT_US = 625
+SLOTS_PER_S = 1600
+BASETIMECNT_MASK = 0x07FFFFFF
+WRAP_S = 600
+
+# arch_system.h defaults
+THRESHOLD = 8
+MAX_PERIOD = 12800
+MAX_SLOPE = 1000
+FORCE_DRIFT = 2
+
+STUBS = {
+    "datasheet.h": host_c.DATASHEET_531,
+    "reg_access.h": host_c.REG_ACCESS,
+    # Only known through a declaration inside a function of arch_system.c
+    "lld_sleep_env.c": """
+unsigned char lld_sleep_env[64];
+""",
+}
+
+HARNESS = r"""
+#include "da1458x_config_basic.h"
+#include "da1458x_config_advanced.h"
+#include "user_config.h"
+#if (SCHED)
+#define CFG_RF_CAL_SCHED
+#endif
+#include "arch_system.c"
+
+/* Clock, in us since the start of the trace, and the next event */
+uint64_t now_us, next_us;
+static uint32_t slot_offset;
+
+/* Temperature of the sensor and time of the calibration, given by the test */
+static int (*read_temp_cb)(void);
+static int (*cal_time_cb)(void);
+
+int reads, short_reads, last_read, adc_clobbered;
+uint32_t first_read_slot, last_read_slot, max_read_gap;
+int cals, overlaps, unforced_overlaps, cal_max_us;
+uint64_t cal_total_us;
+
+static uint32_t base_slot(void)
+{
+    return (uint32_t)(now_us / SLOT_US + slot_offset) & BLE_BASETIMECNT_MASK;
+}
+
+uint32_t host_reg_rd(uint32_t addr)
+{
+    switch (addr)
+    {
+    case BLE_BASETIMECNT_ADDR:
+        return base_slot();
+    case BLE_FINETIMECNT_ADDR:
+        // Counts down the microseconds of the slot
+        return SLOT_US - 1 - now_us % SLOT_US;
+    case BLE_SAMPLECLK_ADDR:
+        // The base time counter is sampled at once
+        return 0;
+    }
+    return *reg(addr);
+}
+
+void host_reg_wr(uint32_t addr, uint32_t value)
+{
+    *reg(addr) = value;
+}
+
+unsigned int _ble_base;
+struct rwip_env_tag rwip_env;
+struct arch_sleep_env_tag sleep_env;
+
+void GPIO_init(void) {}
+void app_init(void) {}
+void arch_disable_sleep(void) {}
+void arch_rom_init(void) {}
+void ble_init(uint32_t base) {}
+void dia_srand(unsigned int seed) {}
+void hw_otpc_disable(void) {}
+void hw_otpc_enter_mode(hw_otpc_mode_t mode) {}
+void hw_otpc_init(void) {}
+void init_rand_seed_from_trng(void) {}
+uint16_t otp_cs_get_xtal32m_trim_value(void) { return 0; }
+uint16_t otp_cs_get_xtal_wait_trim(void) { return 0; }
+int8_t otp_cs_store(void) { return 0; }
+void otp_hdr_get_bd_address(uint8_t *bd_addr) {}
+void periph_init(void) {}
+void rwip_wakeup_delay_set(uint16_t wakeup_delay) {}
+void user_app_init(void) {}
+
+bool ea_sleep_check(uint32_t *sleep_duration, uint32_t wakeup_delay)
+{
+    return next_us >= now_us + (uint64_t)wakeup_delay * SLOT_US;
+}
+
+void adc_init(const adc_config_t *cfg)
+{
+    SetWord16(GP_ADC_CTRL_REG, 0);
+    SetWord16(GP_ADC_CTRL2_REG, 0);
+    SetWord16(GP_ADC_CTRL3_REG, 0);
+    SetWord16(GP_ADC_SEL_REG, 0);
+}
+
+int8_t adc_get_temp(void)
+{
+    if (next_us < now_us + 4 * SLOT_US)
+        short_reads++;
+    if (reads++ == 0)
+        first_read_slot = base_slot();
+    else if (((base_slot() - last_read_slot) & BLE_BASETIMECNT_MASK) > max_read_gap)
+        max_read_gap = (base_slot() - last_read_slot) & BLE_BASETIMECNT_MASK;
+    last_read_slot = base_slot();
+    last_read = read_temp_cb();
+    return last_read;
+}
+
+void rf_recalibration(void)
+{
+    int us = cal_time_cb();
+
+    cals++;
+    now_us += us;
+    cal_total_us += us;
+    if (us > cal_max_us)
+        cal_max_us = us;
+    if (now_us > next_us)
+    {
+        overlaps++;
+#if defined (CFG_RF_CAL_SCHED)
+        if (abs(last_read - last_temp) < RF_CAL_SCHED_THRESHOLD + RF_CAL_SCHED_FORCE_DRIFT)
+            unforced_overlaps++;
+#endif
+    }
+}
+
+void start(uint32_t offset, int (*read_temp)(void), int (*cal_time)(void))
+{
+    now_us = next_us = 0;
+    slot_offset = offset;
+    reg_count = 0;
+    read_temp_cb = read_temp;
+    cal_time_cb = cal_time;
+    reads = short_reads = adc_clobbered = 0;
+    max_read_gap = 0;
+    cals = overlaps = unforced_overlaps = cal_max_us = 0;
+    cal_total_us = 0;
+    // As system_init() leaves them
+    last_temp = 127;
+    last_temp_time = 0;
+    rfcal_count = 0;
+#if defined (CFG_RF_CAL_SCHED)
+    memset(&rf_cal_sched_env, 0, sizeof(rf_cal_sched_env));
+#endif
+}
+
+/* End of a connection event, as schedule_while_ble_on() runs it */
+void event(uint64_t end_us, uint64_t next_event_us)
+{
+    static const uint32_t adc[] = {GP_ADC_CTRL_REG, GP_ADC_CTRL2_REG, GP_ADC_CTRL3_REG, GP_ADC_SEL_REG};
+
+    now_us = end_us;
+    next_us = next_event_us;
+    // GPADC settings of the application
+    for (int i = 0; i < 4; i++)
+        SetWord16(adc[i], 0x5A00 + i);
+#if defined (CFG_RF_CAL_SCHED)
+    conditionally_run_radio_cals();
+#else
+    uint32_t sleep_duration = 0;
+    if (ea_sleep_check(&sleep_duration, 4))
+    {
+        conditionally_run_radio_cals();
+    }
+#endif
+    for (int i = 0; i < 4; i++)
+        if (GetWord16(adc[i]) != 0x5A00 + i)
+            adc_clobbered++;
+}
+
+long stat(const char *name)
+{
+#if defined (CFG_RF_CAL_SCHED)
+    const struct arch_rf_cal_stats *s = arch_rf_cal_get_stats();
+
+    if (!strcmp(name, "samples")) return s->samples;
+    if (!strcmp(name, "calibrations")) return s->calibrations;
+    if (!strcmp(name, "early")) return s->early;
+    if (!strcmp(name, "deferrals")) return s->deferrals;
+    if (!strcmp(name, "cal_time_us")) return s->cal_time_us;
+    if (!strcmp(name, "cal_max_us")) return s->cal_max_us;
+    if (!strcmp(name, "seconds")) return s->seconds;
+    if (!strcmp(name, "per_hour")) return s->per_hour;
+#endif
+    return -1;
+}
+"""
+
+
+def build(sched):
+    # The quoted includes of arch_system.c must find the stubs before the SDK headers
+    tmp = host_c.stage("rf_cal_sched_test", "#define REGS 64\n" + host_c.REG_FILE + HARNESS, stubs=STUBS,
+                       copies=[os.path.join(host_c.SDK_SRC, "platform", "arch", "main", "arch_system.c")])
+    lib = host_c.compile_lib(tmp, "rf_cal_sched_test", sources=["lld_sleep_env.c"],
+                             includes=host_c.HID_INCLUDES + host_c.sdk_includes(),
+                             defines={"__DA14531__": None, "SCHED": sched, "SLOT_US": SLOT_US})
+    lib.start.argtypes = [ctypes.c_uint32, CALLBACK, CALLBACK]
+    lib.event.argtypes = [ctypes.c_uint64, ctypes.c_uint64]
+    lib.stat.argtypes = [ctypes.c_char_p]
+    lib.stat.restype = ctypes.c_long
+    return lib
+
+
+CALLBACK = ctypes.CFUNCTYPE(ctypes.c_int)
+
+
+def synthetic(name, rng):
+    """Returns the temperature in degrees as a function of the time in s."""
+    if name == "office":
+        phase = rng.uniform(0, 2 * math.pi)
+        return lambda t: 24 + 2.5 * math.sin(2 * math.pi * t / 5400 + phase) + 0.8 * math.sin(2 * math.pi * t / 700)
+    if name == "ramp":
+        return lambda t: 20 + 40 * min(t / 1800.0, 1.0)
+    if name == "outdoor":
+        def outdoor(t):
+            # Exponential approach to the ambient of the current 10 minute period
+            temp = 25.0
+            n = int(t // 600)
+            for i in range(n + 1):
+                target = 25.0 if i % 2 == 0 else -5.0
+                span = min(600.0, t - 600 * i)
+                temp = target + (temp - target) * math.exp(-span / 90.0)
+            return temp
+        return outdoor
+    if name == "heater":
+        return lambda t: 40 + 20 * math.sin(2 * math.pi * t / 120)
+    raise ValueError(name)
+
+
+def recorded(path):
+    """Trace of "seconds,celsius" lines, interpolated linearly."""
+    points = []
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            try:
+                t, c = (float(v) for v in line.split(",")[:2])
+            except ValueError:
+                continue    # header
+            points.append((t, c))
+    points.sort()
+    if not points:
+        sys.exit("%s: no samples" % path)
+
+    def temp(t):
+        if t <= points[0][0]:
+            return points[0][1]
+        lo, hi = 0, len(points) - 1
+        if t >= points[hi][0]:
+            return points[hi][1]
+        while hi - lo > 1:
+            mid = (lo + hi) // 2
+            if points[mid][0] <= t:
+                lo = mid
+            else:
+                hi = mid
+        (t0, c0), (t1, c1) = points[lo], points[hi]
+        return c0 + (c1 - c0) * (t - t0) / (t1 - t0) if t1 > t0 else c1
+    return temp, points[-1][0]
+
+
+class Test:
+    def __init__(self, args):
+        self.args = args
+        self.failures = []
+        self.libs = {"fixed": build(0), "sched": build(1)}
+
+    def fail(self, msg):
+        self.failures.append(msg)
+
+    def run(self, policy, temp_at, seconds, seed, noise=None, gap=None):
+        """Runs a connection over a trace. The connection has mostly short events, with
+        bursts of long ones while data is streamed, during which the gaps are short. With
+        a gap given, every event leaves that many slots to the next one."""
+        args = self.args
+        lib = self.libs[policy]
+        rng = random.Random(seed)
+        noise = args.noise if noise is None else noise
+        now_us = ctypes.c_uint64.in_dll(lib, "now_us")
+        interval = int(round(args.interval * 1000 / SLOT_US))
+        end = int(seconds * SLOTS_PER_S)
+        ref = [None]       # true temperature at the last calibration
+
+        def read_temp():
+            t = now_us.value / 1e6
+            if ref[0] is None:
+                ref[0] = temp_at(t)
+            return int(round(temp_at(t) + rng.gauss(0, noise)))
+
+        def cal_time():
+            ref[0] = temp_at(now_us.value / 1e6)
+            return int(args.cal_us * rng.uniform(0.9, 1.1))
+
+        # The callbacks must live as long as the library can call them
+        callbacks = (CALLBACK(read_temp), CALLBACK(cal_time))
+        lib.start((BASETIMECNT_MASK + 1 - WRAP_S * SLOTS_PER_S) & BASETIMECNT_MASK, *callbacks)
+
+        result = {"max_drift": 0.0, "late_s": 0.0, "forced_late_s": 0.0}
+        burst_end = 0
+        start = 0
+        check = 0
+        while start < end:
+            if start >= burst_end and rng.random() < args.burst_rate * args.interval / 1000.0:
+                burst_end = start + int(rng.uniform(1, 10) * SLOTS_PER_S)
+            if gap is not None:
+                length = interval - gap
+            elif start < burst_end:
+                length = interval - rng.randint(1, 8)
+            else:
+                length = rng.choice([1, 1, 1, 1, 2, 2, 3])
+            lib.event((start + length) * SLOT_US, (start + interval) * SLOT_US)
+            # Drift of the true temperature, checked every 100 ms
+            while check <= start + length:
+                if ref[0] is not None:
+                    drift = abs(temp_at(check / float(SLOTS_PER_S)) - ref[0])
+                    result["max_drift"] = max(result["max_drift"], drift)
+                    if drift > THRESHOLD + 1:
+                        result["late_s"] += 0.1
+                    if drift > THRESHOLD + FORCE_DRIFT + 1:
+                        result["forced_late_s"] += 0.1
+                check += SLOTS_PER_S // 10
+            start += interval
+
+        for name in ("reads", "short_reads", "adc_clobbered", "cals", "overlaps", "unforced_overlaps",
+                     "cal_max_us"):
+            result[name] = host_c.cint(lib, name).value
+        result["cal_total_us"] = ctypes.c_uint64.in_dll(lib, "cal_total_us").value
+        result["first_read_slot"] = ctypes.c_uint32.in_dll(lib, "first_read_slot").value
+        result["last_read_slot"] = ctypes.c_uint32.in_dll(lib, "last_read_slot").value
+        result["max_read_gap"] = ctypes.c_uint32.in_dll(lib, "max_read_gap").value
+        if policy == "sched":
+            for name in ("samples", "calibrations", "early", "deferrals", "cal_time_us", "cal_max_us",
+                         "seconds", "per_hour"):
+                result["stats_" + name] = lib.stat(name.encode())
+        return result
+
+    def check_stats(self, name, r):
+        span = (r["last_read_slot"] - r["first_read_slot"]) & BASETIMECNT_MASK
+        expect = {
+            "samples": r["reads"],
+            "calibrations": r["cals"],
+            "cal_time_us": r["cal_total_us"],
+            "cal_max_us": r["cal_max_us"],
+            "seconds": span // SLOTS_PER_S,
+        }
+        expect["per_hour"] = r["cals"] * 3600 // expect["seconds"] if expect["seconds"] else 0
+        for key, value in expect.items():
+            if r["stats_" + key] != value:
+                self.fail("%s: arch_rf_cal_get_stats() %s %d, expected %d" % (name, key, r["stats_" + key], value))
+
+    def check_prediction(self):
+        """A ramp of 1.5 degrees per second, read without noise. The drift moves by more
+        than a degree between two samples a second apart, so the drift only stays within
+        the sensor resolution of the threshold when the calibrations run on the predicted
+        crossing."""
+        r = self.run("sched", lambda t: -20 + 1.5 * t, 60, self.args.seed, noise=0)
+        print("predict   %d calibrations, %d of them early, largest drift %.1f degrees"
+              % (r["cals"], r["stats_early"], r["max_drift"]))
+        if r["max_drift"] > THRESHOLD + 0.5:
+            self.fail("predict: drift of %.1f degrees with %d early calibrations" % (r["max_drift"], r["stats_early"]))
+
+    def check_max_slope(self):
+        """The temperature settles 5 degrees away from the one of the last calibration,
+        then rises at RF_CAL_SCHED_MAX_SLOPE from different times. The samples must be
+        close enough for the drift to stay within a degree and the sensor resolution of
+        the threshold, and the samples of a steady temperature at most
+        RF_CAL_SCHED_MAX_PERIOD apart."""
+        interval = int(round(self.args.interval * 1000 / SLOT_US))
+        worst = 0.0
+        for k in range(10):
+            rise = 100 + 0.8 * k
+
+            def temp(t, rise=rise):
+                return 20 + min(max(t - 30, 0), 5) + max(t - rise, 0) * MAX_SLOPE / 1000.0
+            r = self.run("sched", temp, rise + 30, self.args.seed + k, noise=0, gap=interval - 2)
+            worst = max(worst, r["max_drift"])
+            if r["max_read_gap"] > MAX_PERIOD + interval:
+                self.fail("max slope: samples %d slots apart" % r["max_read_gap"])
+        print("max slope largest drift %.1f degrees" % worst)
+        if worst > THRESHOLD + 1.5:
+            self.fail("max slope: drift of %.1f degrees" % worst)
+
+    def check_forced(self):
+        """A slow ramp under a stream that leaves gaps long enough for a sample, too short
+        for a calibration. The calibration must run once the drift exceeds the threshold by
+        RF_CAL_SCHED_FORCE_DRIFT."""
+        r = self.run("sched", lambda t: 20 + 0.2 * t, 120, self.args.seed, noise=0, gap=5)
+        print("forced    %d calibrations, %d deferrals, largest drift %.1f degrees"
+              % (r["cals"], r["stats_deferrals"], r["max_drift"]))
+        if not r["cals"] or r["max_drift"] > THRESHOLD + FORCE_DRIFT + 1.5:
+            self.fail("forced: drift of %.1f degrees with %d calibrations" % (r["max_drift"], r["cals"]))
+
+    def check_trace(self, name, temp_at, seconds, seed):
+        hours = seconds / 3600.0
+        results = {}
+        for policy in ("fixed", "sched"):
+            r = self.run(policy, temp_at, seconds, seed)
+            results[policy] = r
+            print("%-9s %-6s %7.1f %7.1f %9.2f %7.1f %7.1f %6s %6s %7d"
+                  % (name, policy, r["cals"] / hours, r["reads"] / hours, r["cal_total_us"] / 1000.0 / hours,
+                     r["max_drift"], r["late_s"], r.get("stats_early", "-"), r.get("stats_deferrals", "-"),
+                     r["overlaps"]))
+            if r["short_reads"]:
+                self.fail("%s: %s reads the temperature %d times less than 4 slots before an event"
+                          % (name, policy, r["short_reads"]))
+            if r["adc_clobbered"]:
+                self.fail("%s: %s leaves the GPADC registers changed %d times" % (name, policy, r["adc_clobbered"]))
+        sched = results["sched"]
+        if sched["unforced_overlaps"]:
+            self.fail("%s: %d calibrations overlap an event below the forced drift" % (name, sched["unforced_overlaps"]))
+        if sched["forced_late_s"] > results["fixed"]["late_s"]:
+            self.fail("%s: late past the forced drift for %.1f s, the default check late for %.1f s"
+                      % (name, sched["forced_late_s"], results["fixed"]["late_s"]))
+        self.check_stats(name, sched)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--interval", type=float, default=7.5, help="connection interval in ms")
+    parser.add_argument("--hours", type=float, default=1.0, help="length of the synthetic traces")
+    parser.add_argument("--cal-us", type=int, default=1500, help="time taken by rf_recalibration()")
+    parser.add_argument("--noise", type=float, default=0.4, help="sensor noise, standard deviation in degrees")
+    parser.add_argument("--burst-rate", type=float, default=0.02, help="streaming bursts per second")
+    parser.add_argument("--trace", action="append", default=[], help="recorded trace, CSV of seconds,celsius")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    traces = []
+    if args.trace:
+        for path in args.trace:
+            temp, seconds = recorded(path)
+            traces.append((os.path.basename(path), temp, seconds))
+    else:
+        for name in ("office", "ramp", "outdoor", "heater"):
+            traces.append((name, synthetic(name, rng), args.hours * 3600))
+
+    test = Test(args)
+    print("%g ms connection interval, calibration %d us, sensor noise %g degrees"
+          % (args.interval, args.cal_us, args.noise))
+    print()
+    print("%-9s %-6s %7s %7s %9s %7s %7s %6s %6s %7s"
+          % ("trace", "", "cals/h", "smpl/h", "cal ms/h", "drift", "late s", "early", "defer", "overlap"))
+    for i, (name, temp, seconds) in enumerate(traces):
+        test.check_trace(name, temp, seconds, args.seed + i)
+    print()
+    test.check_prediction()
+    test.check_max_slope()
+    test.check_forced()
+
+    return host_c.report(test.failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
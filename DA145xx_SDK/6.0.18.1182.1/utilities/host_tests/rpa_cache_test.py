@@ -0,0 +1,760 @@
+#!/usr/bin/env python3
+"""
+Host test of the RPA resolution cache of app_easy_security.c (CFG_APP_SEC_RPA_CACHE).
+
+app_easy_security.c, app_utils.c and aes_api.c are built unmodified against the real GAP
+headers and stubbed kernel and application layers. aes_api.c drives an emulated BLE core
+AES engine, which encrypts with sw_aes.c and counts the blocks. The bond database is
+emulated behind the bond database callbacks.
+
+The byte order of ah() is first checked with the sample data of the Bluetooth Core
+specification (Vol 3, Part H, D.7), through app_easy_security_rpa_prefetch() and
+app_easy_security_resolve_bdaddr(). Then bonded hosts, a few of them far more often than
+the others, reconnect with Resolvable Private Addresses renewed every few connections,
+mixed with unbonded hosts. Bonds are rewritten and removed, and the link layer sometimes
+holds the engine. The checks:
+
+- every connection from a bonded host is reported solved with its IRK, every other one
+  is reported failed, and a cached RPA never resolves to a rewritten or removed bond
+- when the engine is held, GAPM_RESOLV_ADDR_CMD carries every stored IRK once, and the
+  indication of GAPM is routed back to its connection
+- no more AES blocks over the run than GAPM would use, trying the IRKs in database
+  order
+
+    rpa_cache_test.py
+    rpa_cache_test.py --bonds 16 --renew 1 --reconnects 20000
+"""
+
+import argparse
+import ctypes
+import os
+import random
+import sys
+
+import host_c
+
+CRYPTO = os.path.join(host_c.SDK_SRC, "platform", "core_modules", "crypto")
+INCLUDES = [os.path.join(host_c.APP_MODULES, "api"), CRYPTO] + host_c.BLE_HOST_INCLUDES
+SOURCES = [
+    os.path.join(host_c.APP_MODULES, "src", "app_easy", "app_easy_security.c"),
+    os.path.join(host_c.APP_MODULES, "src", "app_common", "app_utils.c"),
+    os.path.join(CRYPTO, "aes_api.c"),
+    os.path.join(CRYPTO, "sw_aes.c"),
+]
+
+CONNECTIONS = 2
+BDB_MAX = 32
+
+STUBS = {
+    "rwip_config.h": """
+#ifndef RWIP_CONFIG_H_
+#define RWIP_CONFIG_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#define BLE_APP_PRESENT         1
+#define BLE_APP_SEC             1
+#define BLE_CENTRAL             0
+#define BLE_PERIPHERAL          1
+#define BLE_L2CC                1
+#define BLE_CONNECTION_MAX      3
+#define L2CC_IDX_MAX            BLE_CONNECTION_MAX
+#define ENABLE_SMP_SECURE       1
+#define __SECTION_ZERO(name)
+#define __ARRAY_EMPTY
+#include "compiler.h"
+#include "ke_task.h"
+#include "rwble_hl_error.h"
+#define SMPM_RAND_ADDR_PRAND_LEN    (3)
+#define CFG_MAX_CONNECTIONS         APP_EASY_MAX_ACTIVE_CONNECTION
+#define LLM_ADV_INTERVAL_MIN        (0x20)
+#define LLM_ADV_INTERVAL_MAX        (0x4000)
+#endif
+""",
+    "ke_timer.h": "",
+    "ke_mem.h": "",
+    "arch_api.h": "",
+    "app_task.h": "",
+    "ke_task.h": """
+#ifndef KE_TASK_H_
+#define KE_TASK_H_
+#include <stdint.h>
+typedef uint16_t ke_task_id_t;
+typedef uint16_t ke_msg_id_t;
+typedef uint8_t ke_state_t;
+#define KE_FIRST_MSG(task)      ((ke_msg_id_t)((task) << 8))
+#define KE_MEM_BLOCK_MAX        4
+enum
+{
+    TASK_ID_L2CC = 10,
+    TASK_ID_GAPM = 13,
+    TASK_ID_GAPC = 14,
+};
+#define TASK_APP                (1)
+#define TASK_GAPM               (TASK_ID_GAPM)
+#define TASK_GAPC               (TASK_ID_GAPC)
+typedef int (*ke_msg_func_t)(ke_msg_id_t const msgid, void const *param,
+                             ke_task_id_t const dest_id, ke_task_id_t const src_id);
+struct ke_msg_handler
+{
+    ke_msg_id_t id;
+    ke_msg_func_t func;
+};
+#endif
+""",
+    "ke_msg.h": """
+#ifndef KE_MSG_H_
+#define KE_MSG_H_
+#include "ke_task.h"
+#define KE_BUILD_ID(type, index) ( (ke_task_id_t)(((index) << 8)|(type)) )
+#define KE_IDX_GET(ke_task_id) (((ke_task_id) >> 8) & 0xFF)
+void *ke_msg_alloc(ke_msg_id_t const id, ke_task_id_t const dest_id, ke_task_id_t const src_id,
+                   uint16_t const param_len);
+void ke_msg_send(void const *param_ptr);
+#define KE_MSG_ALLOC(id, dest, src, param_str) \\
+    (struct param_str*) ke_msg_alloc(id, dest, src, sizeof(struct param_str))
+#define KE_MSG_ALLOC_DYN(id, dest, src, param_str, length) \\
+    (struct param_str*) ke_msg_alloc(id, dest, src, (sizeof(struct param_str) + length));
+#endif
+""",
+    "compiler.h": """
+#define __STATIC_FORCEINLINE    static inline
+#define __INLINE                inline
+#define __STATIC_INLINE         static inline
+""",
+    "arch.h": """
+#ifndef ARCH_H_
+#define ARCH_H_
+extern int assert_warnings;
+#define ASSERT_WARNING(cond)    {if (!(cond)) assert_warnings++;}
+#define ASSERT_ERROR(cond)      ASSERT_WARNING(cond)
+#endif
+""",
+    "co_math.h": """
+#include <stdint.h>
+uint32_t co_rand_word(void);
+""",
+    "app.h": """
+#ifndef _APP_H_
+#define _APP_H_
+#include "rwip_config.h"
+#include "co_bt.h"
+#include "ke_msg.h"
+#include "arch.h"
+struct app_env_tag
+{
+    uint16_t conhdl;
+    uint8_t conidx;
+    bool connection_active;
+    uint8_t peer_addr_type;
+    struct bd_addr peer_addr;
+    bool pairing_in_progress;
+};
+extern struct app_env_tag app_env[APP_EASY_MAX_ACTIVE_CONNECTION];
+#endif
+""",
+    "user_callback_config.h": """
+#include "app_callback.h"
+#include "app_user_config.h"
+extern const struct app_callbacks user_app_callbacks;
+extern const struct app_bond_db_callbacks user_app_bond_db_callbacks;
+extern const struct security_configuration user_security_conf;
+""",
+    "rwip.h": """
+void rwip_schedule(void);
+""",
+    "llm.h": """
+#ifndef LLM_H_
+#define LLM_H_
+#include <stdbool.h>
+struct llm_le_env_tag
+{
+    bool enc_pend;
+};
+extern struct llm_le_env_tag llm_le_env;
+#endif
+""",
+    "reg_blecore.h": """
+#ifndef REG_BLECORE_H_
+#define REG_BLECORE_H_
+#include <stdint.h>
+extern uint8_t em_mem[64];
+#define EM_BASE_ADDR                ((uintptr_t) em_mem)
+#define EM_BLE_ENC_PLAIN_OFFSET     (0)
+#define EM_BLE_ENC_CIPHER_OFFSET    (32)
+#define BLE_AES_START_BIT           (0x00000001)
+#define BLE_AESCNTL_REG             (0)
+#define GetWord32(a)                ble_aescntl_get()
+void em_rd(void *sys_addr, uint16_t em_addr, uint16_t size);
+void ble_aeskey31_0_set(uint32_t value);
+void ble_aeskey63_32_set(uint32_t value);
+void ble_aeskey95_64_set(uint32_t value);
+void ble_aeskey127_96_set(uint32_t value);
+void ble_aesptr_set(uint16_t value);
+void ble_aescntl_set(uint32_t value);
+uint32_t ble_aescntl_get(void);
+#endif
+""",
+}
+
+HARNESS = r"""
+// Ahead of the SDK headers, which include the real app.h from their own directory
+#include "app.h"
+#include "app_easy_security.c"
+#include "app_utils.c"
+#include "aes_api.c"
+
+int assert_warnings;
+struct app_env_tag app_env[APP_EASY_MAX_ACTIVE_CONNECTION];
+struct llm_le_env_tag llm_le_env;
+uint8_t IV[ENC_DATA_LEN];
+
+uint32_t co_rand_word(void)
+{
+    return 4;
+}
+
+void rwip_schedule(void)
+{
+}
+
+/* Pairing and encryption, not used by the resolution */
+
+struct app_sec_bond_data_env_tag app_sec_env[APP_EASY_MAX_ACTIVE_CONNECTION];
+const struct security_configuration user_security_conf;
+
+void app_sec_gen_csrk(uint8_t conidx)
+{
+}
+
+void app_easy_gap_confirm(uint8_t conidx, enum gap_auth auth, uint8_t authorize)
+{
+}
+
+void app_easy_gap_disconnect(uint8_t conidx)
+{
+}
+
+/* Emulated BLE core AES engine: the key registers and the reversed plaintext in the exchange
+   memory, as aes_enc_dec() writes them, the ciphertext most significant byte first */
+
+uint8_t em_mem[64];
+static uint32_t aes_key[4];
+static uint16_t aes_ptr;
+int aes_blocks;
+int engine_collisions;
+
+void ble_aeskey31_0_set(uint32_t value)     { aes_key[3] = value; }
+void ble_aeskey63_32_set(uint32_t value)    { aes_key[2] = value; }
+void ble_aeskey95_64_set(uint32_t value)    { aes_key[1] = value; }
+void ble_aeskey127_96_set(uint32_t value)   { aes_key[0] = value; }
+void ble_aesptr_set(uint16_t value)         { aes_ptr = value; }
+uint32_t ble_aescntl_get(void)              { return 0; }
+
+void em_rd(void *sys_addr, uint16_t em_addr, uint16_t size)
+{
+    memcpy(sys_addr, &em_mem[em_addr], size);
+}
+
+static void ref_encrypt(const uint8_t *key, const uint8_t *in, uint8_t *out)
+{
+    AES_CTX ctx;
+    uint32_t data[4];
+    uint8_t i;
+    static const uint8_t iv[16];
+
+    AES_set_key(&ctx, key, iv, AES_MODE_128);
+    for (i = 0; i < 4; i++)
+    {
+        data[i] = GETU32(&in[i * 4]);
+    }
+    AES_encrypt(&ctx, data);
+    for (i = 0; i < 4; i++)
+    {
+        PUTU32(&out[i * 4], data[i]);
+    }
+}
+
+void ble_aescntl_set(uint32_t value)
+{
+    uint8_t key[16], plain[16];
+    int i;
+
+    if (llm_le_env.enc_pend)
+    {
+        engine_collisions++;
+    }
+    for (i = 0; i < 4; i++)
+    {
+        PUTU32(&key[i * 4], aes_key[i]);
+    }
+    for (i = 0; i < 16; i++)
+    {
+        plain[i] = em_mem[aes_ptr + 15 - i];
+    }
+    ref_encrypt(key, plain, &em_mem[EM_BLE_ENC_CIPHER_OFFSET]);
+    aes_blocks++;
+}
+
+/* RPA of an IRK, both least significant byte first, computed on sw_aes only */
+
+void make_rpa(const uint8_t *irk, uint32_t prand, uint8_t *addr)
+{
+    uint8_t key[16], r[16], e[16];
+    int i;
+
+    prand = (prand & 0x3FFFFF) | 0x400000;
+    for (i = 0; i < 16; i++)
+    {
+        key[i] = irk[15 - i];
+    }
+    memset(r, 0, sizeof(r));
+    r[13] = prand >> 16;
+    r[14] = prand >> 8;
+    r[15] = prand;
+    ref_encrypt(key, r, e);
+    addr[0] = e[15];
+    addr[1] = e[14];
+    addr[2] = e[13];
+    addr[3] = prand;
+    addr[4] = prand >> 8;
+    addr[5] = prand >> 16;
+}
+
+/* Emulated bond database */
+
+struct bond_slot
+{
+    int valid;
+    uint8_t irk[KEY_LEN];
+};
+
+static struct bond_slot bdb[BDB_MAX];
+int bdb_size;
+
+static uint8_t bdb_get_size(void)
+{
+    return bdb_size;
+}
+
+static uint8_t bdb_get_number_of_stored_irks(void)
+{
+    uint8_t n = 0;
+    int i;
+
+    for (i = 0; i < bdb_size; i++)
+    {
+        n += bdb[i].valid;
+    }
+    return n;
+}
+
+static uint8_t bdb_get_stored_irks(struct gap_sec_key *irks)
+{
+    uint8_t n = 0;
+    int i;
+
+    for (i = 0; i < bdb_size; i++)
+    {
+        if (bdb[i].valid)
+        {
+            memcpy(irks[n++].key, bdb[i].irk, KEY_LEN);
+        }
+    }
+    return n;
+}
+
+static bool bdb_get_device_info_from_slot(uint8_t slot, struct gap_ral_dev_info *dev_info)
+{
+    if ((slot >= bdb_size) || !bdb[slot].valid)
+    {
+        return false;
+    }
+    memset(dev_info, 0, sizeof(*dev_info));
+    memcpy(dev_info->peer_irk, bdb[slot].irk, KEY_LEN);
+    return true;
+}
+
+static void bdb_add_entry(struct app_sec_bond_data_env_tag *data)
+{
+    bdb[data->bdb_slot].valid = 1;
+    memcpy(bdb[data->bdb_slot].irk, data->rirk.irk.key, KEY_LEN);
+}
+
+static void bdb_remove_entry(enum bdb_search_by_type search_type, enum bdb_remove_type remove_type,
+                             void *search_param, uint8_t search_param_length)
+{
+    if ((search_type == SEARCH_BY_SLOT_TYPE) && (remove_type == REMOVE_THIS_ENTRY))
+    {
+        bdb[*(uint8_t *) search_param].valid = 0;
+    }
+}
+
+const struct app_bond_db_callbacks user_app_bond_db_callbacks =
+{
+    .app_bdb_get_size                   = bdb_get_size,
+    .app_bdb_add_entry                  = bdb_add_entry,
+    .app_bdb_remove_entry               = bdb_remove_entry,
+    .app_bdb_get_number_of_stored_irks  = bdb_get_number_of_stored_irks,
+    .app_bdb_get_stored_irks            = bdb_get_stored_irks,
+    .app_bdb_get_device_info_from_slot  = bdb_get_device_info_from_slot,
+};
+
+void bond(uint8_t slot, const uint8_t *irk)
+{
+    struct app_sec_bond_data_env_tag data;
+
+    memset(&data, 0, sizeof(data));
+    data.bdb_slot = slot;
+    data.valid_keys = RIRK_PRESENT;
+    memcpy(data.rirk.irk.key, irk, KEY_LEN);
+    app_easy_security_bdb_add_entry(&data);
+}
+
+void unbond(uint8_t slot)
+{
+    app_easy_security_bdb_remove_entry(SEARCH_BY_SLOT_TYPE, REMOVE_THIS_ENTRY, &slot, sizeof(slot));
+}
+
+/* Resolution results: 'S' solved, 'F' failed, reported by the callbacks of the application */
+
+int result_kind;
+int result_conidx;
+uint8_t result_irk[KEY_LEN];
+int results;
+
+static void on_addr_solved_ind(const uint8_t conidx, struct gapm_addr_solved_ind const *param)
+{
+    results++;
+    result_kind = 'S';
+    result_conidx = conidx;
+    memcpy(result_irk, param->irk.key, KEY_LEN);
+}
+
+static void on_addr_resolve_failed(const uint8_t conidx)
+{
+    results++;
+    result_kind = 'F';
+    result_conidx = conidx;
+}
+
+const struct app_callbacks user_app_callbacks =
+{
+    .app_on_addr_solved_ind             = on_addr_solved_ind,
+    .app_on_addr_resolve_failed         = on_addr_resolve_failed,
+};
+
+/* GAPM_RESOLV_ADDR_CMD sent to GAPM */
+
+int gapm_cmds;
+int gapm_nb_key;
+uint8_t gapm_addr[BD_ADDR_LEN];
+uint8_t gapm_irks[BDB_MAX][KEY_LEN];
+int live_msgs;
+int stray_msgs;
+
+void *ke_msg_alloc(ke_msg_id_t const id, ke_task_id_t const dest_id, ke_task_id_t const src_id,
+                   uint16_t const param_len)
+{
+    uint16_t *msg = calloc(1, sizeof(uint16_t) * 2 + param_len);
+
+    live_msgs++;
+    msg[0] = id;
+    msg[1] = dest_id;
+    return &msg[2];
+}
+
+void ke_msg_send(void const *param_ptr)
+{
+    uint16_t *msg = (uint16_t *) param_ptr - 2;
+
+    if ((msg[0] == GAPM_RESOLV_ADDR_CMD) && (msg[1] == TASK_GAPM))
+    {
+        struct gapm_resolv_addr_cmd const *cmd = param_ptr;
+
+        gapm_cmds++;
+        gapm_nb_key = cmd->nb_key;
+        memcpy(gapm_addr, cmd->addr.addr, BD_ADDR_LEN);
+        memcpy(gapm_irks, cmd->irk, co_min(cmd->nb_key, BDB_MAX) * KEY_LEN);
+    }
+    else
+    {
+        stray_msgs++;
+    }
+    live_msgs--;
+    free(msg);
+}
+
+/* The connection of a host: prefetch at connection time, resolution on the encryption
+   request */
+
+void connect(uint8_t conidx, const uint8_t *addr, int engine_held)
+{
+    app_env[conidx].conidx = conidx;
+    app_env[conidx].connection_active = true;
+    app_env[conidx].peer_addr_type = ADDR_RAND;
+    memcpy(app_env[conidx].peer_addr.addr, addr, BD_ADDR_LEN);
+
+    llm_le_env.enc_pend = engine_held;
+    app_easy_security_rpa_prefetch(conidx);
+    llm_le_env.enc_pend = false;
+}
+
+int resolve(uint8_t conidx)
+{
+    return app_easy_security_resolve_bdaddr(conidx);
+}
+
+int gapm_solved(const uint8_t *addr, const uint8_t *irk)
+{
+    struct gapm_addr_solved_ind ind;
+
+    memcpy(ind.addr.addr, addr, BD_ADDR_LEN);
+    memcpy(ind.irk.key, irk, KEY_LEN);
+    return app_easy_security_rpa_solved(&ind);
+}
+
+int constant(const char *name)
+{
+#define C(x)    if (strcmp(name, #x) == 0) return (x)
+    C(APP_EASY_SECURITY_RPA_CACHE_SIZE); C(APP_EASY_SECURITY_MRU_SIZE);
+#undef C
+    return -1;
+}
+"""
+
+
+def build():
+    harness = ("#define BDB_MAX %d\n#include <stdlib.h>\n#include \"co_math.h\"\n" % BDB_MAX
+               + "#define co_min(a, b) ((a) < (b) ? (a) : (b))\n" + HARNESS)
+    # The quoted includes of the sources must find the stubs before the SDK headers
+    lib = host_c.build("rpa_cache_test", harness, stubs=STUBS, copies=SOURCES, sources=["sw_aes.c"],
+                       defines={"CFG_APP_SEC_RPA_CACHE": None, "APP_EASY_MAX_ACTIVE_CONNECTION": CONNECTIONS},
+                       includes=INCLUDES)
+    lib.constant.argtypes = [ctypes.c_char_p]
+    lib.make_rpa.argtypes = [ctypes.c_char_p, ctypes.c_uint32, ctypes.c_char_p]
+    lib.bond.argtypes = [ctypes.c_uint8, ctypes.c_char_p]
+    lib.connect.argtypes = [ctypes.c_uint8, ctypes.c_char_p, ctypes.c_int]
+    lib.gapm_solved.argtypes = [ctypes.c_char_p, ctypes.c_char_p]
+    return lib
+
+
+class Test:
+    def __init__(self, lib, rng):
+        self.lib = lib
+        self.rng = rng
+        self.failures = []
+        self.bonds = []                 # IRK per slot, None if empty
+
+    def fail(self, msg):
+        self.failures.append(msg)
+
+    def irk(self):
+        return bytes(self.rng.randrange(256) for _ in range(16))
+
+    def rpa(self, irk):
+        addr = ctypes.create_string_buffer(6)
+        self.lib.make_rpa(irk, self.rng.randrange(1 << 22), addr)
+        return addr.raw
+
+    def set_bonds(self, size):
+        host_c.cint(self.lib, "bdb_size").value = size
+        self.bonds = [None] * size
+
+    def bond(self, slot, irk):
+        self.lib.bond(slot, irk)
+        self.bonds[slot] = irk
+
+    def unbond(self, slot):
+        self.lib.unbond(slot)
+        self.bonds[slot] = None
+
+    def gapm_order_blocks(self, irk):
+        """AES blocks of GAPM_RESOLV_ADDR_CMD with the IRKs in database order."""
+        stored = [k for k in self.bonds if k is not None]
+        return stored.index(irk) + 1 if irk in stored else len(stored)
+
+    def reconnect(self, conidx, addr, irk, engine_held):
+        """Connects, resolves and checks; returns the AES blocks used and whether GAPM was asked."""
+        lib = self.lib
+        bonded = irk is not None and irk in self.bonds
+        stored = [k for k in self.bonds if k is not None]
+        host_c.cint(lib, "aes_blocks").value = 0
+        host_c.cint(lib, "results").value = 0
+        cmds = host_c.cint(lib, "gapm_cmds").value
+
+        lib.connect(conidx, addr, engine_held)
+        if engine_held and host_c.cint(lib, "aes_blocks").value:
+            self.fail("the engine held by the link layer was used")
+        nb_key = lib.resolve(conidx)
+        if nb_key != len(stored):
+            self.fail("%d IRKs reported, %d stored" % (nb_key, len(stored)))
+        blocks = host_c.cint(lib, "aes_blocks").value
+        if not stored:
+            if host_c.cint(lib, "results").value or host_c.cint(lib, "gapm_cmds").value != cmds:
+                self.fail("resolution attempted with no IRK stored")
+            return blocks, False
+
+        asked = host_c.cint(lib, "gapm_cmds").value != cmds
+        if asked:
+            if host_c.cint(lib, "results").value:
+                self.fail("resolution reported while GAPM was asked")
+            nb = host_c.cint(lib, "gapm_nb_key").value
+            irks = [bytes(r) for r in (ctypes.c_uint8 * 16 * 32).in_dll(lib, "gapm_irks")[:nb]]
+            if sorted(irks) != sorted(stored):
+                self.fail("GAPM_RESOLV_ADDR_CMD carries %d IRKs, not the %d stored ones" % (nb, len(stored)))
+            if bytes((ctypes.c_uint8 * 6).in_dll(lib, "gapm_addr")) != addr:
+                self.fail("GAPM_RESOLV_ADDR_CMD carries another address")
+            # GAPM tries the IRKs in the order given
+            blocks += irks.index(irk) + 1 if bonded and irk in irks else len(irks)
+            if bonded:
+                back = lib.gapm_solved(addr, irk)
+                if back != conidx:
+                    self.fail("GAPM indication routed to connection %d, not %d" % (back, conidx))
+            return blocks, True
+
+        if host_c.cint(lib, "results").value != 1:
+            self.fail("%d results reported for one connection" % host_c.cint(lib, "results").value)
+            return blocks, False
+        kind = host_c.cint(lib, "result_kind").value
+        if host_c.cint(lib, "result_conidx").value != conidx:
+            self.fail("result reported to connection %d, not %d" % (host_c.cint(lib, "result_conidx").value, conidx))
+        if bonded:
+            got = bytes((ctypes.c_uint8 * 16).in_dll(lib, "result_irk"))
+            if kind != ord("S") or got != irk:
+                self.fail("bonded host not solved with its IRK")
+        elif kind != ord("F"):
+            self.fail("unbonded host solved")
+        return blocks, False
+
+    def sample_data(self):
+        """Core specification Vol 3, Part H, D.7: IRK, prand and hash."""
+        irk = bytes(reversed(bytes.fromhex("ec0234a357c8ad05341010a60a397d9b")))
+        addr = bytes(reversed(bytes.fromhex("7081940dfbaa")))
+        made = ctypes.create_string_buffer(6)
+        self.lib.make_rpa(irk, 0x708194, made)
+        if made.raw != addr:
+            self.fail("reference ah() does not give the sample hash")
+        self.set_bonds(2)
+        self.bond(1, self.irk())
+        self.bond(0, irk)
+        blocks, asked = self.reconnect(0, addr, irk, False)
+        # No slot used yet, the IRKs are tried in database order
+        if asked or blocks != 1:
+            self.fail("sample RPA resolved with %d AES blocks, GAPM asked: %s" % (blocks, asked))
+        wrong = addr[:2] + bytes([addr[2] ^ 1]) + addr[3:]
+        self.reconnect(0, wrong, None, False)
+        if host_c.cint(self.lib, "result_kind").value != ord("F"):
+            self.fail("altered sample RPA solved")
+
+        # The most recently used slot is tried first, a known RPA costs no AES
+        other = self.rpa(self.bonds[1])
+        held = self.rpa(self.bonds[1])
+        for what, rpa, slot, expected in (("second slot", other, 1, 2),
+                                          ("second slot again", self.rpa(self.bonds[1]), 1, 1),
+                                          ("first slot", self.rpa(self.bonds[0]), 0, 2),
+                                          ("cached RPA", other, 1, 0),
+                                          ("second slot after its cached RPA", self.rpa(self.bonds[1]), 1, 1),
+                                          ("RPA solved by GAPM", held, 1, None),
+                                          ("RPA cached from GAPM", held, 1, 0)):
+            blocks, asked = self.reconnect(1, rpa, self.bonds[slot], expected is None)
+            if expected is not None and (asked or blocks != expected):
+                self.fail("%s resolved with %d AES blocks, not %d" % (what, blocks, expected))
+
+    def run(self, args):
+        rng = self.rng
+        lib = self.lib
+        self.set_bonds(args.bonds)
+        for slot in range(args.bonds):
+            self.bond(slot, self.irk())
+        active = rng.sample(range(args.bonds), min(args.active, args.bonds))
+        weights = [8 if s in active else 1 for s in range(args.bonds)]
+        rpas = [self.rpa(irk) for irk in self.bonds]
+        uses = [0] * args.bonds
+        former_next = None
+
+        self.stats = {"cache": 0, "gapm": 0, "blocks": 0, "order": 0, "zero": 0, "rebonds": 0}
+        for _ in range(args.reconnects):
+            r = rng.random()
+            if r < args.rebond:
+                slot = rng.randrange(args.bonds)
+                if rng.random() < 0.3:
+                    self.unbond(slot)
+                else:
+                    if (self.bonds[slot] is not None) and rng.random() < 0.5:
+                        former_next = rpas[slot]
+                    self.bond(slot, self.irk())
+                    rpas[slot] = self.rpa(self.bonds[slot])
+                self.stats["rebonds"] += 1
+
+            if former_next is not None:
+                # The host of a rewritten bond, with an RPA that may still be cached
+                irk = None
+                addr = former_next
+                former_next = None
+            elif rng.random() < args.strangers:
+                irk = None
+                addr = self.rpa(self.irk())
+            else:
+                slot = rng.choices(range(args.bonds), weights)[0]
+                if self.bonds[slot] is None:
+                    # A removed bond reconnects with its old RPA
+                    irk = None
+                    addr = rpas[slot]
+                else:
+                    irk = self.bonds[slot]
+                    uses[slot] += 1
+                    if uses[slot] % args.renew == 0:
+                        rpas[slot] = self.rpa(irk)
+                    addr = rpas[slot]
+
+            held = rng.random() < args.held
+            blocks, asked = self.reconnect(rng.randrange(CONNECTIONS), addr, irk, held)
+            order = self.gapm_order_blocks(irk)
+            self.stats["blocks"] += blocks
+            self.stats["order"] += order
+            self.stats["gapm"] += asked
+            self.stats["zero"] += blocks == 0
+
+        if self.stats["blocks"] > self.stats["order"]:
+            self.fail("%d AES blocks, %d in database order" % (self.stats["blocks"], self.stats["order"]))
+        for name, what in (("assert_warnings", "assertions"), ("live_msgs", "messages leaked"),
+                           ("stray_msgs", "unexpected messages"), ("engine_collisions", "engine collisions")):
+            if host_c.cint(lib, name).value:
+                self.fail("%d %s" % (host_c.cint(lib, name).value, what))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--bonds", type=int, default=8, help="bond database slots")
+    parser.add_argument("--active", type=int, default=4, help="hosts that reconnect often")
+    parser.add_argument("--renew", type=int, default=4, help="reconnections before a host renews its RPA")
+    parser.add_argument("--reconnects", type=int, default=5000)
+    parser.add_argument("--strangers", type=float, default=0.02, help="share of connections from unbonded hosts")
+    parser.add_argument("--rebond", type=float, default=0.005, help="share of connections that rewrite a bond")
+    parser.add_argument("--held", type=float, default=0.05, help="share of connections with the engine held")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+    if not 0 < args.bonds <= BDB_MAX:
+        sys.exit("--bonds must be 1 to %d" % BDB_MAX)
+
+    lib = build()
+    test = Test(lib, random.Random(args.seed))
+    test.sample_data()
+    test.run(args)
+    s = test.stats
+    n = float(args.reconnects)
+    print("%d bonds, %d active hosts, RPA renewed every %d connections, cache of %d RPAs, MRU of %d slots"
+          % (args.bonds, min(args.active, args.bonds), args.renew, lib.constant(b"APP_EASY_SECURITY_RPA_CACHE_SIZE"),
+             lib.constant(b"APP_EASY_SECURITY_MRU_SIZE")))
+    print("%d reconnections, %d bond changes, %d resolved by GAPM with the engine held"
+          % (args.reconnects, s["rebonds"], s["gapm"]))
+    print("AES blocks per reconnection: %.2f, %.2f in database order, %.0f%% with no AES"
+          % (s["blocks"] / n, s["order"] / n, 100.0 * s["zero"] / n))
+
+    return host_c.report(test.failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
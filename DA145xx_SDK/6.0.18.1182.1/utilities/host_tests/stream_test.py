@@ -0,0 +1,499 @@
+#!/usr/bin/env python3
+"""
+Host test of the custom service streaming of the HID-Gamepad-Digitizer example,
+user_stream.c (CFG_CUSTS1_STREAM).
+
+user_stream.c is built unmodified against the SDK headers and the DA14531 configuration
+of the example. GATTC, the kernel messages and the BLE time are emulated. A host
+subscribes to the Server TX characteristic, exchanges the ATT MTU and changes the LE Data
+Length at random times, and completes the notifications in order, some of them with an
+error. The application writes bytes of random lengths, some notifications cannot be
+allocated, and the host unsubscribes and the link drops now and then. The checks:
+
+- stream_payload_max(): the largest payload within the MTU and the characteristic that
+  fills one link layer packet or a whole number of them, for every MTU and Data Length
+- stream_send(): the bytes of a connection arrive intact and in order, notifications of
+  the full payload only but for a shorter one when none is in flight, never more than
+  USER_STREAM_NTF_QUEUED in flight, and no byte waits while a notification could go
+- the ring buffer wraps inside a notification, the bytes that do not fit are refused
+  and counted, nothing is sent to a host that is not subscribed
+- the exported statistics match the notifications, errors and pending time seen
+
+    stream_test.py
+    stream_test.py --steps 200000 --seed 7
+"""
+
+import argparse
+import ctypes
+import os
+import random
+import struct
+import sys
+
+import host_c
+
+MTUS = (23, 27, 65, 100, 158, 185, 247)
+TX_OCTETS = (27, 69, 100, 123, 185, 251)
+
+ATT_HDR_LEN = 3
+L2C_HDR_LEN = 4
+BASETIMECNT_MASK = 0x07FFFFFF
+
+HARNESS = r"""
+#include "da1458x_config_basic.h"
+#include "da1458x_config_advanced.h"
+#include "user_config.h"
+
+#define CFG_CUSTS1_STREAM
+
+#include "user_stream.c"
+
+/* BLE time in 625us slots */
+static uint32_t base_slot;
+
+uint32_t host_reg_rd(uint32_t addr)
+{
+    return (addr == BLE_BASETIMECNT_ADDR) ? (base_slot & BLE_BASETIMECNT_MASK) : 0;
+}
+
+void host_reg_wr(uint32_t addr, uint32_t value)
+{
+}
+
+void set_time(uint32_t slot)
+{
+    base_slot = slot;
+}
+
+/* Kernel messages, GATTC takes the notifications */
+static void (*ntf_cb)(uint8_t conidx, const uint8_t *data, uint16_t len);
+int alloc_fail;
+int live_msgs;
+int mtu_exch;
+int bad_msgs;
+
+void *ke_msg_alloc(ke_msg_id_t const id, ke_task_id_t const dest_id, ke_task_id_t const src_id,
+                   uint16_t const param_len)
+{
+    struct ke_msg *msg;
+
+    if ((id == GATTC_SEND_EVT_CMD) && alloc_fail)
+    {
+        alloc_fail--;
+        return NULL;
+    }
+    msg = calloc(1, sizeof(struct ke_msg) + param_len);
+    msg->id = id;
+    msg->dest_id = dest_id;
+    msg->src_id = src_id;
+    msg->param_len = param_len;
+    live_msgs++;
+    return msg->param;
+}
+
+void ke_msg_send(void const *param_ptr)
+{
+    struct ke_msg *msg = ke_param2msg(param_ptr);
+
+    if ((KE_TYPE_GET(msg->dest_id) != TASK_GATTC) || (msg->src_id != TASK_APP))
+        bad_msgs++;
+    else if (msg->id == GATTC_SEND_EVT_CMD)
+    {
+        const struct gattc_send_evt_cmd *cmd = param_ptr;
+
+        if ((cmd->operation != GATTC_NOTIFY) || (cmd->handle != custs1_get_att_handle(CUST1_IDX_SERVER_TX_VAL)) ||
+            (msg->param_len < sizeof(*cmd) + cmd->length))
+            bad_msgs++;
+        else
+            ntf_cb(KE_IDX_GET(msg->dest_id), cmd->value, cmd->length);
+    }
+    else if ((msg->id == GATTC_EXC_MTU_CMD) && (((const struct gattc_exc_mtu_cmd *)param_ptr)->operation == GATTC_MTU_EXCH))
+        mtu_exch++;
+    else
+        bad_msgs++;
+    live_msgs--;
+    free(msg);
+}
+
+/* GATTC and GAP */
+static uint16_t mtu;
+int dl_tx_octets;
+int dl_tx_time;
+
+void set_mtu(uint16_t value)
+{
+    mtu = value;
+}
+
+uint16_t gattc_get_mtu(uint8_t idx)
+{
+    return mtu;
+}
+
+uint16_t custs1_get_att_handle(uint8_t att_idx)
+{
+    return 0x20 + att_idx;
+}
+
+void app_easy_gap_set_data_packet_length(uint8_t conidx, uint16_t tx_octets, uint16_t tx_time)
+{
+    dl_tx_octets = tx_octets;
+    dl_tx_time = tx_time;
+}
+
+void data_length(uint8_t conidx, uint16_t tx_octets)
+{
+    struct gapc_le_pkt_size_ind ind = {.max_tx_octets = tx_octets, .max_tx_time = 2120,
+                                       .max_rx_octets = 251, .max_rx_time = 2120};
+
+    user_stream_data_length_changed(conidx, &ind);
+}
+
+int alloc_failed;
+
+void user_heap_mon_alloc_failed(enum user_heap_mon_site site)
+{
+    if (site == USER_HEAP_MON_SITE_STREAM_NTF)
+        alloc_failed++;
+    else
+        bad_msgs++;
+}
+
+void start(void (*ntf)(uint8_t, const uint8_t *, uint16_t))
+{
+    ntf_cb = ntf;
+}
+
+uint16_t payload_max(uint8_t conidx)
+{
+    return stream_payload_max(conidx);
+}
+
+int buffered(uint8_t conidx)
+{
+    return stream_env.links[conidx].count;
+}
+
+int in_flight(uint8_t conidx)
+{
+    return stream_env.links[conidx].in_flight;
+}
+
+const int buf_size = USER_STREAM_BUF_SIZE;
+const int ntf_queued = USER_STREAM_NTF_QUEUED;
+const int char_len = DEF_CUST1_SERVER_TX_CHAR_LEN;
+const int stream_tx_octets = USER_STREAM_TX_OCTETS;
+const int stream_tx_time = USER_STREAM_TX_TIME;
+const int def_tx_octets = STREAM_DEF_TX_OCTETS;
+const int stats_len = USER_STREAM_STATS_LEN;
+const int stats_version = USER_STREAM_STATS_VERSION;
+const int err_status = ATT_ERR_INSUFF_RESOURCE;
+"""
+
+NTF_CB = ctypes.CFUNCTYPE(None, ctypes.c_uint8, ctypes.POINTER(ctypes.c_uint8), ctypes.c_uint16)
+
+
+def build():
+    # The quoted includes of the sources must find the stubs of datasheet.h and reg_access.h first
+    lib = host_c.build("stream_test", HARNESS,
+                       stubs={"datasheet.h": host_c.DATASHEET_531, "reg_access.h": host_c.REG_ACCESS},
+                       copies=[os.path.join(host_c.HID_EXAMPLE, "user_stream.c")],
+                       includes=host_c.HID_INCLUDES + host_c.sdk_includes(), defines={"__DA14531__": None})
+    lib.start.argtypes = [NTF_CB]
+    lib.set_time.argtypes = [ctypes.c_uint32]
+    lib.set_mtu.argtypes = [ctypes.c_uint16]
+    lib.data_length.argtypes = [ctypes.c_uint8, ctypes.c_uint16]
+    lib.payload_max.argtypes = [ctypes.c_uint8]
+    lib.payload_max.restype = ctypes.c_uint16
+    lib.buffered.argtypes = [ctypes.c_uint8]
+    lib.in_flight.argtypes = [ctypes.c_uint8]
+    lib.user_stream_connected.argtypes = [ctypes.c_uint8, ctypes.c_uint16]
+    lib.user_stream_disconnected.argtypes = [ctypes.c_uint8]
+    lib.user_stream_param_updated.argtypes = [ctypes.c_uint8, ctypes.c_uint16]
+    lib.user_stream_ntf_cfg.argtypes = [ctypes.c_uint8, ctypes.c_bool]
+    lib.user_stream_ntf_cmp.argtypes = [ctypes.c_uint8, ctypes.c_uint8]
+    lib.user_stream_write.argtypes = [ctypes.c_uint8, ctypes.c_char_p, ctypes.c_uint16]
+    lib.user_stream_write.restype = ctypes.c_uint16
+    lib.user_stream_stats_pack.argtypes = [ctypes.POINTER(ctypes.c_uint8)]
+    lib.user_stream_stats_pack.restype = ctypes.c_uint16
+    return lib
+
+
+def reference_payload(mtu, tx_octets, char_len):
+    """Largest payload within the MTU and the characteristic whose L2CAP PDU fills one
+    link layer packet or a whole number of them, found by search."""
+    for payload in range(min(mtu - ATT_HDR_LEN, char_len), 0, -1):
+        pdu = payload + ATT_HDR_LEN + L2C_HDR_LEN
+        if pdu <= tx_octets or pdu % tx_octets == 0:
+            return payload
+    return 0
+
+
+class Test:
+    def __init__(self, args):
+        self.args = args
+        self.lib = build()
+        self.rnd = random.Random(args.seed)
+        self.failures = []
+        self.c = {name: host_c.cint(self.lib, name).value for name in
+                  ("buf_size", "ntf_queued", "char_len", "stream_tx_octets", "stream_tx_time", "def_tx_octets",
+                   "stats_len", "stats_version", "err_status")}
+        self.ntf_cb = NTF_CB(self.notified)
+        self.lib.start(self.ntf_cb)
+        self.slot = (BASETIMECNT_MASK + 1 - 100000) & BASETIMECNT_MASK     # wraps during the run
+        self.lib.set_time(self.slot)
+        self.reset_model()
+        self.stats = dict(bytes=0, ntf=0, dropped=0, full_ntf=0, ntf_errors=0, max_queued=0, active_slots=0)
+        self.pending_since = None
+        self.armed = 0
+        self.wraps = 0
+        self.sizes = set()
+
+    def fail(self, msg):
+        if len(self.failures) < 100:
+            self.failures.append(msg)
+
+    def reset_model(self):
+        self.enabled = False
+        self.mtu = 23
+        self.tx_octets = None
+        self.pending = bytearray()      # written, not yet notified
+        self.in_flight = []             # lengths of the notifications not completed
+        self.head = 0                   # ring position of the next notification
+        self.stalled = False            # a notification could not be allocated
+        self.lib.set_mtu(self.mtu)
+
+    def max_len(self):
+        return reference_payload(self.mtu, self.tx_octets, self.c["char_len"])
+
+    def notified(self, conidx, data, length):
+        got = bytes(data[:length])
+        max_len = self.max_len()
+        if conidx != 0 or not self.enabled:
+            self.fail("notification to connection %d, subscribed %s" % (conidx, self.enabled))
+        if length == 0 or length > max_len:
+            self.fail("notification of %d bytes, payload %d" % (length, max_len))
+        elif length < max_len and self.in_flight:
+            self.fail("short notification of %d bytes with %d in flight" % (length, len(self.in_flight)))
+        if got != bytes(self.pending[:length]):
+            self.fail("notification of %d bytes differs from the bytes written" % length)
+        if self.head + length > self.c["buf_size"]:
+            self.wraps += 1
+        self.head = (self.head + length) % self.c["buf_size"]
+        del self.pending[:length]
+        self.in_flight.append(length)
+        if len(self.in_flight) > self.c["ntf_queued"]:
+            self.fail("%d notifications in flight" % len(self.in_flight))
+        self.sizes.add((self.mtu, self.tx_octets, length))
+        self.stats["bytes"] += length
+        self.stats["ntf"] += 1
+        self.stats["full_ntf"] += length == max_len
+        self.stats["max_queued"] = max(self.stats["max_queued"], len(self.in_flight))
+
+    def activity(self):
+        """The pending time, accumulated by user_stream.c when bytes are written, notifications
+        complete and the link drops."""
+        pending = self.lib.buffered(0) != 0 or self.lib.in_flight(0) != 0
+        if pending and self.pending_since is None:
+            self.pending_since = self.slot
+        elif not pending and self.pending_since is not None:
+            self.stats["active_slots"] += (self.slot - self.pending_since) & BASETIMECNT_MASK
+            self.pending_since = None
+
+    def check_idle(self, what):
+        """Nothing waits while a notification could go."""
+        if self.lib.buffered(0) != len(self.pending) or self.lib.in_flight(0) != len(self.in_flight):
+            self.fail("%s: %d bytes buffered and %d in flight, %d and %d expected" %
+                      (what, self.lib.buffered(0), self.lib.in_flight(0), len(self.pending), len(self.in_flight)))
+        if not self.enabled or self.stalled or len(self.in_flight) >= self.c["ntf_queued"]:
+            return
+        if len(self.pending) >= self.max_len() or (self.pending and not self.in_flight):
+            self.fail("%s: %d bytes wait with %d in flight" % (what, len(self.pending), len(self.in_flight)))
+
+    def alloc_fails(self, n):
+        """The next n notifications cannot be allocated."""
+        host_c.cint(self.lib, "alloc_fail").value = n
+        self.armed = n
+
+    def took_failures(self):
+        """Counts the allocation failures of the last call. The bytes then wait for the next
+        write or completion."""
+        left = host_c.cint(self.lib, "alloc_fail").value
+        self.stats["ntf_errors"] += self.armed - left
+        self.stalled = left != self.armed
+        self.armed = left
+
+    def connect(self):
+        lib = self.lib
+        self.reset_model()
+        exch = host_c.cint(lib, "mtu_exch").value
+        interval = self.rnd.choice((6, 12, 24, 40))
+        lib.user_stream_connected(0, interval)
+        self.con_interval = interval
+        self.tx_octets = self.c["def_tx_octets"]
+        if host_c.cint(lib, "mtu_exch").value != exch + 1 or \
+                (host_c.cint(lib, "dl_tx_octets").value, host_c.cint(lib, "dl_tx_time").value) != \
+                (self.c["stream_tx_octets"], self.c["stream_tx_time"]):
+            self.fail("connection: MTU exchange or Data Length update not requested")
+        self.activity()
+
+    def disconnect(self):
+        self.lib.user_stream_disconnected(0)
+        self.pending.clear()
+        self.in_flight = []
+        self.head = 0
+        self.enabled = False
+        self.activity()
+
+    def write(self, n):
+        data = bytes(self.rnd.getrandbits(8) for _ in range(n))
+        room = self.c["buf_size"] - len(self.pending) if self.enabled else 0
+        expect = min(n, room)
+        self.pending += data[:expect]
+        self.stats["dropped"] += n - expect
+        took = self.lib.user_stream_write(0, data, n)
+        self.took_failures()
+        if took != expect:
+            self.fail("write of %d bytes took %d, %d expected" % (n, took, expect))
+        self.activity()
+
+    def complete(self, error=False):
+        self.in_flight.pop(0)
+        if error:
+            self.stats["ntf_errors"] += 1
+        self.lib.user_stream_ntf_cmp(0, self.c["err_status"] if error else 0)
+        self.took_failures()
+        self.activity()
+
+    def check_payload_max(self):
+        lib = self.lib
+        self.connect()
+        print("%5s %s" % ("MTU", " ".join("%4d" % tx for tx in TX_OCTETS)))
+        for mtu in MTUS:
+            row = []
+            for tx in TX_OCTETS:
+                self.mtu, self.tx_octets = mtu, tx
+                lib.set_mtu(mtu)
+                lib.data_length(0, tx)
+                got = lib.payload_max(0)
+                want = self.max_len()
+                if got != want:
+                    self.fail("MTU %d, Data Length %d: payload %d, %d expected" % (mtu, tx, got, want))
+                row.append(got)
+            print("%5d %s" % (mtu, " ".join("%4d" % p for p in row)))
+        print("notification payload per MTU and LE Data Length")
+        print()
+        self.disconnect()
+
+    def check_disabled(self):
+        lib = self.lib
+        self.connect()
+        before = host_c.cint(lib, "live_msgs").value
+        self.write(100)
+        if host_c.cint(lib, "live_msgs").value != before or self.stats["dropped"] < 100:
+            self.fail("bytes sent or kept for a host that is not subscribed")
+        self.disconnect()
+
+    def run(self, steps):
+        lib = self.lib
+        rnd = self.rnd
+        self.connect()
+        for step in range(steps):
+            self.slot = (self.slot + rnd.randint(0, 8)) & BASETIMECNT_MASK
+            lib.set_time(self.slot)
+            r = rnd.random()
+            if r < 0.001:
+                self.disconnect()
+                self.connect()
+                what = "connection"
+            elif r < 0.003:
+                self.enabled = not self.enabled
+                lib.user_stream_ntf_cfg(0, self.enabled)
+                self.took_failures()
+                what = "subscription"
+            elif r < 0.006:
+                # Taken at the next notification
+                self.mtu = rnd.choice(MTUS)
+                lib.set_mtu(self.mtu)
+                continue
+            elif r < 0.009:
+                self.tx_octets = rnd.choice(TX_OCTETS)
+                lib.data_length(0, self.tx_octets)
+                self.took_failures()
+                what = "Data Length"
+            elif r < 0.02:
+                self.alloc_fails(1)
+                continue
+            elif r < 0.03:
+                lib.user_stream_param_updated(0, 12)
+                self.con_interval = 12
+                continue
+            elif r < 0.55 or not self.in_flight:
+                self.write(rnd.choice((rnd.randint(1, 20), rnd.randint(1, 300))))
+                what = "write"
+            else:
+                self.complete(rnd.random() < 0.03)
+                what = "completion"
+            self.check_idle("step %d, %s" % (step, what))
+
+        # The host takes everything
+        self.alloc_fails(0)
+        if not self.enabled:
+            self.enabled = True
+            lib.user_stream_ntf_cfg(0, True)
+        self.write(1)
+        while self.in_flight:
+            self.complete()
+        if self.pending or lib.buffered(0) or lib.in_flight(0):
+            self.fail("%d bytes left at the end" % len(self.pending))
+        if not self.wraps:
+            self.fail("the ring buffer never wrapped inside a notification")
+        print("%d steps: %d notifications, %d bytes, %d across the end of the ring buffer, %d sizes"
+              % (steps, self.stats["ntf"], self.stats["bytes"], self.wraps, len(self.sizes)))
+
+    def check_stats(self):
+        lib = self.lib
+        buf = (ctypes.c_uint8 * self.c["stats_len"])()
+        n = lib.user_stream_stats_pack(buf)
+        if n != self.c["stats_len"]:
+            self.fail("statistics of %d bytes" % n)
+            return
+        (version, max_queued, mtu, tx_octets, con_interval, nbytes, ntf, active_slots, dropped, full_ntf,
+         ntf_errors) = struct.unpack("<BBHHHIIIIHH", bytes(buf))
+        got = dict(bytes=nbytes, ntf=ntf, dropped=dropped, full_ntf=full_ntf, ntf_errors=ntf_errors,
+                   max_queued=max_queued, active_slots=active_slots)
+        for key, want in self.stats.items():
+            if got[key] != want:
+                self.fail("statistics: %s %d, %d expected" % (key, got[key], want))
+        if (version, mtu, tx_octets, con_interval) != \
+                (self.c["stats_version"], self.mtu, self.tx_octets, self.con_interval):
+            self.fail("statistics: version %d, MTU %d, Data Length %d, interval %d" %
+                      (version, mtu, tx_octets, con_interval))
+        if host_c.cint(lib, "alloc_failed").value == 0:
+            self.fail("no allocation failure reported to user_heap_mon")
+        if host_c.cint(lib, "bad_msgs").value or host_c.cint(lib, "live_msgs").value:
+            self.fail("%d unexpected messages, %d leaked" %
+                      (host_c.cint(lib, "bad_msgs").value, host_c.cint(lib, "live_msgs").value))
+        lib.user_stream_reset()
+        lib.user_stream_stats_pack(buf)
+        if any(bytes(buf)[1:2] + bytes(buf)[12:]):
+            self.fail("statistics not cleared by user_stream_reset()")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--steps", type=int, default=50000)
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    test = Test(args)
+    test.check_payload_max()
+    test.check_disabled()
+    test.run(args.steps)
+    test.check_stats()
+
+    return host_c.report(test.failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,606 @@
+#!/usr/bin/env python3
+"""
+Host test of the drift compensated time of app_time.c (CFG_APP_TIME) and time_calc.c.
+
+app_time.c and time_calc.c are built unmodified against the SDK headers and the DA14531
+configuration of the HID-Gamepad-Digitizer example, with the low power clock taken from
+lp_clk_sel so that both the RCX20 and the XTAL32 can be run. The register accesses go to
+an emulated register file, and the RTC stub returns the time and calendar registers of a
+counter that runs from the low power clock, through the divider app_time_init() has
+written, encoded as rtc.c encodes them.
+
+The calendar functions are compared with the datetime module over every day and every
+second the clock can hold, and the drift function with exact arithmetic. The clock then
+runs from an RCX20 whose rate follows the temperature, or from an XTAL32 with a parabolic
+temperature curve. The RCX is calibrated with the 16 MHz crystal, whose own error biases
+the measured period, and the period is an integer of 1/1024 us. A Current Time Service
+client writes the time every few days with a jitter, through app_time_ctss_write(). The
+checks:
+
+- the corrected time is the most accurate of the RTC set at each write, the RTC
+  corrected by the RCX period only (writes marked as a time zone change, not learned
+  from) and the full correction, whose error beyond the jitter of the writes is at
+  least 5 times smaller than that of the RTC
+- app_time_get_stats() counts every read of the RTC, decoding of the calendar register,
+  synchronization, synchronization learned from and change of the RCX period
+- app_time_init() keeps PD_TIM up in sleep and divides the RTC clock for the frequency
+  the RCX period rounds to, or for 32768 Hz with the XTAL32
+- the Current Time and Reference Time Information characteristics read back the time
+  written, the weekday and the time since the write; a date out of range is rejected,
+  and a time zone change, a write within APP_TIME_LEARN_MIN of the previous one or a
+  step larger than the clock can drift is not learned from
+
+    time_test.py                                    RCX20, 90 days, sync every 3 days
+    time_test.py --clock xtal --days 365
+    time_test.py --sync-days 7 --jitter 1.0 --tempco 80
+"""
+
+import argparse
+import ctypes
+import datetime
+import math
+import os
+import random
+import sys
+
+import host_c
+
+TIME_SRC = os.path.join(host_c.APP_MODULES, "src", "app_time")
+
+CS_PER_DAY = 8640000
+PPB = 1000000000
+EPOCH = datetime.datetime(2000, 1, 1)
+
+# app_time.h defaults
+DRIFT_MAX_PPB = 500000
+RESIDUAL_PPB = 20000
+LEARN_MIN = 360000
+
+# cts_common.h
+REASON_CHG_TIME_ZONE = 0x04
+
+HARNESS = r"""
+#include "da1458x_config_basic.h"
+#define CFG_APP_TIME
+#define CFG_PRF_CTSS
+#include "da1458x_config_advanced.h"
+#include "user_config.h"
+// The low power clock of lp_clk_sel, set by the test
+#undef CFG_LP_CLK
+#define CFG_LP_CLK LP_CLK_FROM_OTP
+#include "app_time.c"
+#include "time_calc.c"
+
+uint32_t host_reg_rd(uint32_t addr)
+{
+    // PD_TIM is up, the test checks that it stays up in sleep
+    if (addr == SYS_STAT_REG)
+        return TIM_IS_UP;
+    return *reg(addr);
+}
+
+void host_reg_wr(uint32_t addr, uint32_t value)
+{
+    *reg(addr) = value;
+}
+
+uint32_t lp_clk_sel;
+rcx_time_data_t rcx_time_data;
+
+const int att_err_app_error = ATT_ERR_APP_ERROR;
+
+/* RTC of the test, read as the time and calendar registers */
+static void (*rtc_regs_cb)(uint32_t *time_bcd, uint32_t *clndr_bcd);
+int rtc_reads, rtc_inits, rtc_sets, rtc_set_epoch;
+
+void rtc_init(const rtc_config_t *cfg)
+{
+    rtc_inits++;
+}
+
+rtc_status_code_t rtc_set_time_clndr(const rtc_time_t *time, const rtc_calendar_t *clndr)
+{
+    rtc_sets++;
+    rtc_set_epoch = (time->hour_mode == RTC_HOUR_MODE_24H) && (time->hour == 0) && (time->minute == 0) &&
+                    (time->sec == 0) && (time->hsec == 0) && (clndr->year == 2000) && (clndr->month == 1) &&
+                    (clndr->mday == 1) && (clndr->wday == 6);
+    return RTC_STATUS_CODE_VALID_ENTRY;
+}
+
+void rtc_get_time_clndr_bcd(uint32_t *time_bcd, uint32_t *clndr_bcd)
+{
+    rtc_reads++;
+    rtc_regs_cb(time_bcd, clndr_bcd);
+}
+
+void start(int rcx, uint32_t period, void (*cb)(uint32_t *, uint32_t *))
+{
+    reg_count = 0;
+    // Out of reset PD_TIM sleeps with the system
+    SetBits16(PMU_CTRL_REG, TIM_SLEEP, 1);
+    lp_clk_sel = rcx ? LP_CLK_RCX20 : LP_CLK_XTAL32;
+    rcx_time_data.rcx_period = period;
+    rtc_regs_cb = cb;
+    rtc_reads = rtc_inits = rtc_sets = rtc_set_epoch = 0;
+    app_time_init();
+}
+
+/* Calibration of the RCX */
+void set_period(uint32_t period)
+{
+    rcx_time_data.rcx_period = period;
+}
+
+/* Frequency the RTC divider is set for, 0 if the RTC clock is off */
+uint32_t rtc_div_hz(void)
+{
+    if (!GetBits32(CLK_RTCDIV_REG, RTC_DIV_ENABLE) || (GetBits32(CLK_RTCDIV_REG, RTC_DIV_DENOM) != RTC_DIV_DENOM_1000))
+        return 0;
+    return GetBits32(CLK_RTCDIV_REG, RTC_DIV_INT) * 100 + GetBits32(CLK_RTCDIV_REG, RTC_DIV_FRAC) / 10;
+}
+
+int tim_sleep(void)
+{
+    return GetBits16(PMU_CTRL_REG, TIM_SLEEP);
+}
+
+uint8_t cts_write(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec,
+                  uint8_t frac, uint8_t reason)
+{
+    struct cts_curr_time ct;
+    struct prf_date_time *dt = &ct.exact_time_256.day_date_time.date_time;
+
+    memset(&ct, 0, sizeof(ct));
+    dt->year = year;
+    dt->month = month;
+    dt->day = day;
+    dt->hour = hour;
+    dt->min = min;
+    dt->sec = sec;
+    ct.exact_time_256.fraction_256 = frac;
+    ct.adjust_reason = reason;
+    return app_time_ctss_write(&ct);
+}
+
+/* year, month, day, hour, min, sec, weekday, fraction_256, adjust_reason */
+void cts_read(uint32_t *out)
+{
+    struct cts_curr_time ct;
+    struct prf_date_time *dt = &ct.exact_time_256.day_date_time.date_time;
+
+    memset(&ct, 0xA5, sizeof(ct));
+    app_time_ctss_read(&ct);
+    out[0] = dt->year;
+    out[1] = dt->month;
+    out[2] = dt->day;
+    out[3] = dt->hour;
+    out[4] = dt->min;
+    out[5] = dt->sec;
+    out[6] = ct.exact_time_256.day_date_time.day_of_week;
+    out[7] = ct.exact_time_256.fraction_256;
+    out[8] = ct.adjust_reason;
+}
+
+/* time_source, time_accuracy, days_update, hours_update */
+void cts_ref(uint32_t *out)
+{
+    struct cts_ref_time_info rt;
+
+    memset(&rt, 0xA5, sizeof(rt));
+    app_time_ctss_ref_info(&rt);
+    out[0] = rt.time_source;
+    out[1] = rt.time_accuracy;
+    out[2] = rt.days_update;
+    out[3] = rt.hours_update;
+}
+
+long stat(const char *name)
+{
+    const struct app_time_stats *s = app_time_get_stats();
+
+    if (!strcmp(name, "reads")) return s->reads;
+    if (!strcmp(name, "date_decodes")) return s->date_decodes;
+    if (!strcmp(name, "syncs")) return s->syncs;
+    if (!strcmp(name, "learned")) return s->learned;
+    if (!strcmp(name, "rcx_updates")) return s->rcx_updates;
+    if (!strcmp(name, "learned_ppb")) return s->learned_ppb;
+    if (!strcmp(name, "rcx_ppb")) return s->rcx_ppb;
+    return -1;
+}
+"""
+
+RTC_CB = ctypes.CFUNCTYPE(None, ctypes.POINTER(ctypes.c_uint32), ctypes.POINTER(ctypes.c_uint32))
+
+
+def build():
+    # The quoted includes of the sources must find the stub of datasheet.h first
+    lib = host_c.build("time_test", host_c.REG_FILE + HARNESS,
+                       stubs={"datasheet.h": host_c.DATASHEET_531},
+                       copies=[os.path.join(TIME_SRC, name) for name in ("app_time.c", "time_calc.c", "time_calc.h")],
+                       includes=host_c.HID_INCLUDES + host_c.sdk_includes(), defines={"__DA14531__": None})
+    u8p = ctypes.POINTER(ctypes.c_uint8)
+    u32p = ctypes.POINTER(ctypes.c_uint32)
+    lib.start.argtypes = [ctypes.c_int, ctypes.c_uint32, RTC_CB]
+    lib.set_period.argtypes = [ctypes.c_uint32]
+    lib.rtc_div_hz.restype = ctypes.c_uint32
+    lib.cts_write.argtypes = [ctypes.c_uint16] + [ctypes.c_uint8] * 7
+    lib.cts_write.restype = ctypes.c_uint8
+    lib.cts_read.argtypes = [u32p]
+    lib.cts_ref.argtypes = [u32p]
+    lib.stat.argtypes = [ctypes.c_char_p]
+    lib.stat.restype = ctypes.c_long
+    lib.app_time_now.argtypes = [u8p]
+    lib.app_time_now.restype = ctypes.c_uint32
+    lib.app_time_is_synced.restype = ctypes.c_bool
+    lib.time_calc_days.argtypes = [ctypes.c_uint16, ctypes.c_uint8, ctypes.c_uint8]
+    lib.time_calc_days.restype = ctypes.c_uint32
+    lib.time_calc_date.argtypes = [ctypes.c_uint32, ctypes.POINTER(ctypes.c_uint16), u8p, u8p]
+    lib.time_calc_date.restype = ctypes.c_uint8
+    lib.time_calc_clndr_bcd_to_days.argtypes = [ctypes.c_uint32]
+    lib.time_calc_clndr_bcd_to_days.restype = ctypes.c_uint32
+    lib.time_calc_time_bcd_to_cs.argtypes = [ctypes.c_uint32]
+    lib.time_calc_time_bcd_to_cs.restype = ctypes.c_uint32
+    lib.time_calc_drift.argtypes = [ctypes.c_uint64, ctypes.c_int32]
+    lib.time_calc_drift.restype = ctypes.c_int64
+    return lib
+
+
+def clndr_to_bcd(year, month, mday, wday):
+    """Calendar register, as calendar_to_bcd() of rtc.c writes it."""
+    return (((year // 1000) % 10) << 28 | ((year // 100) % 10) << 24 | ((year // 10) % 10) << 20 |
+            (year % 10) << 16 | (mday // 10) << 12 | (mday % 10) << 8 | (month // 10) << 7 |
+            (month % 10) << 3 | wday)
+
+
+def time_to_bcd(hour, minute, sec, hsec):
+    """Time register, as time_to_bcd() of rtc.c writes it in the 24-hour mode."""
+    return ((hour // 10) << 28 | (hour % 10) << 24 | (minute // 10) << 20 | (minute % 10) << 16 |
+            (sec // 10) << 12 | (sec % 10) << 8 | (hsec // 10) << 4 | hsec % 10)
+
+
+def fields(sec):
+    """Date and time of seconds since 2000-01-01."""
+    when = EPOCH + datetime.timedelta(seconds=sec)
+    return [when.year, when.month, when.day, when.hour, when.minute, when.second]
+
+
+class Rtc:
+    """The RTC counter in cs since 2000-01-01, read through its registers."""
+
+    def __init__(self):
+        self.cs = 0.0
+        self.clndr = 0
+        self.date_changes = 0
+        self.cb = RTC_CB(self.read)
+
+    def read(self, time_bcd, clndr_bcd):
+        cs = int(self.cs)
+        day = EPOCH + datetime.timedelta(days=cs // CS_PER_DAY)
+        sod = cs % CS_PER_DAY
+        clndr = clndr_to_bcd(day.year, day.month, day.day, day.isoweekday())
+        if clndr != self.clndr:
+            self.clndr = clndr
+            self.date_changes += 1
+        time_bcd[0] = time_to_bcd(sod // 360000, (sod // 6000) % 60, (sod // 100) % 60, sod % 100)
+        clndr_bcd[0] = clndr
+
+
+class Test:
+    def __init__(self, args):
+        self.args = args
+        self.lib = build()
+        self.failures = []
+
+    def fail(self, msg):
+        self.failures.append(msg)
+
+    def stat(self, name):
+        return self.lib.stat(name.encode())
+
+    def start(self, rtc, rcx, period):
+        self.lib.start(1 if rcx else 0, period, rtc.cb)
+        if self.lib.tim_sleep() != 0:
+            self.fail("PD_TIM is not kept up in sleep")
+        if ctypes.c_int.in_dll(self.lib, "rtc_sets").value != 1 or not ctypes.c_int.in_dll(self.lib, "rtc_set_epoch").value:
+            self.fail("the RTC is not started at 2000-01-01 00:00:00, a Saturday")
+        return self.lib.rtc_div_hz()
+
+    def now(self):
+        hsec = ctypes.c_uint8()
+        sec = self.lib.app_time_now(ctypes.byref(hsec))
+        return sec * 100 + hsec.value
+
+    def cts_write(self, sec, frac=0, reason=0):
+        """Writes the time, in seconds since 2000-01-01 and 1/256 s as the client sends it."""
+        when = EPOCH + datetime.timedelta(seconds=sec)
+        return self.lib.cts_write(when.year, when.month, when.day, when.hour, when.minute, when.second, frac, reason)
+
+    def cts_read(self):
+        out = (ctypes.c_uint32 * 9)()
+        self.lib.cts_read(out)
+        return list(out)
+
+    def cts_ref(self):
+        out = (ctypes.c_uint32 * 4)()
+        self.lib.cts_ref(out)
+        return list(out)
+
+    def check_calendar(self):
+        lib = self.lib
+        year = ctypes.c_uint16()
+        month = ctypes.c_uint8()
+        mday = ctypes.c_uint8()
+        day = EPOCH.date()
+        last = datetime.date(2135, 12, 31)
+        n = 0
+        while day <= last:
+            days = (day - EPOCH.date()).days
+            wday = lib.time_calc_date(days, ctypes.byref(year), ctypes.byref(month), ctypes.byref(mday))
+            if (year.value, month.value, mday.value, wday) != (day.year, day.month, day.day, day.isoweekday()):
+                return self.fail("time_calc_date(%d) is %d-%d-%d/%d, not %s"
+                                 % (days, year.value, month.value, mday.value, wday, day))
+            if lib.time_calc_days(day.year, day.month, day.day) != days:
+                return self.fail("time_calc_days(%s) is not %d" % (day, days))
+            if lib.time_calc_clndr_bcd_to_days(clndr_to_bcd(day.year, day.month, day.day, wday)) != days:
+                return self.fail("time_calc_clndr_bcd_to_days() of %s is not %d" % (day, days))
+            day += datetime.timedelta(days=1)
+            n += 1
+        print("calendar: %d days, %s to %s" % (n, EPOCH.date(), last))
+
+    def check_time_of_day(self):
+        for s in range(86400):
+            hsec = (s * 37) % 100
+            cs = s * 100 + hsec
+            got = self.lib.time_calc_time_bcd_to_cs(time_to_bcd(s // 3600, (s // 60) % 60, s % 60, hsec))
+            if got != cs:
+                return self.fail("time_calc_time_bcd_to_cs() of %d cs is %d" % (cs, got))
+        print("time of day: 86400 seconds")
+
+    def check_drift(self):
+        rnd = random.Random(self.args.seed)
+        for _ in range(20000):
+            elapsed = rnd.randrange(0, 400 * CS_PER_DAY)
+            ppb = rnd.randrange(-DRIFT_MAX_PPB, DRIFT_MAX_PPB + 1)
+            exact = elapsed * ppb
+            drift = abs(exact) // PPB * (1 if exact >= 0 else -1)
+            if self.lib.time_calc_drift(elapsed, ppb) != drift:
+                return self.fail("time_calc_drift(%d, %d) is not %d" % (elapsed, ppb, drift))
+        print("drift: 20000 random intervals")
+
+    def check_cts(self):
+        """The characteristics of the Current Time Service, on a nominal XTAL32."""
+        rtc = Rtc()
+        hz = self.start(rtc, False, 0)
+        if hz != 32768:
+            self.fail("RTC divided for %d Hz with the XTAL32" % hz)
+
+        rtc.cs = 5 * 3600 * 100
+        if self.lib.app_time_is_synced() or self.cts_ref() != [0, 255, 255, 255]:
+            self.fail("reference time %s before the first write" % self.cts_ref())
+        if self.cts_read()[:6] != [2000, 1, 1, 5, 0, 0]:
+            self.fail("time %s before the first write, not 5 h after the reset" % self.cts_read())
+
+        written = int((datetime.datetime(2024, 2, 29, 13, 45, 30) - EPOCH).total_seconds())
+        if self.cts_write(written, 128) != 0:
+            self.fail("write of 2024-02-29 13:45:30.5 rejected")
+        if self.cts_read() != [2024, 2, 29, 13, 45, 30, 4, 128, 0]:
+            self.fail("2024-02-29 13:45:30.5 written, %s read" % self.cts_read())
+        rtc.cs += (27 * 3600 + 60) * 100
+        if self.cts_read()[:7] != [2024, 3, 1, 16, 46, 30, 5]:
+            self.fail("27 h later, %s read" % self.cts_read()[:7])
+        # Not learned from yet: the drift of APP_TIME_DRIFT_MAX_PPB, in 1/8 s
+        acc = min(254, ((27 * 3600 + 60) * 100 * DRIFT_MAX_PPB // PPB) * 8 // 100)
+        if self.cts_ref() != [0, acc, 1, 3]:
+            self.fail("reference time %s 27 h after the write, not %s" % (self.cts_ref(), [0, acc, 1, 3]))
+
+        # A clock 100 ppm slow, written again after 2 days
+        rtc.cs += 2 * CS_PER_DAY * (1 - 100e-6)
+        written += 2 * 86400 + 27 * 3600 + 60
+        self.cts_write(written, 128)
+        if self.stat("learned") != 1 or not 0 < self.stat("learned_ppb") <= 100000:
+            self.fail("offset of 100 ppm learned as %d ppb, %d times" % (self.stat("learned_ppb"), self.stat("learned")))
+        rtc.cs += 10 * 3600 * 100
+        acc = ((10 * 3600) * 100 * RESIDUAL_PPB // PPB) * 8 // 100
+        if self.cts_ref() != [0, acc, 0, 10]:
+            self.fail("reference time %s 10 h after a learned write, not %s" % (self.cts_ref(), [0, acc, 0, 10]))
+
+        # A time zone change, a write half an hour later, within APP_TIME_LEARN_MIN, and a
+        # step of an hour a day later, applied but not learned from
+        learned = (self.stat("learned"), self.stat("learned_ppb"))
+        written += 10 * 3600 + 3600
+        self.cts_write(written, 128, REASON_CHG_TIME_ZONE)
+        if self.cts_read()[:6] != fields(written):
+            self.fail("time zone change to %s, %s read" % (fields(written), self.cts_read()[:6]))
+        rtc.cs += 30 * 60 * 100
+        written += 30 * 60
+        self.cts_write(written, 255)
+        if self.cts_read()[:6] != fields(written):
+            self.fail("write of %s, %s read" % (fields(written), self.cts_read()[:6]))
+        rtc.cs += CS_PER_DAY
+        written += 86400 + 3600
+        self.cts_write(written, 128)
+        if self.cts_read()[:6] != fields(written):
+            self.fail("step to %s, %s read" % (fields(written), self.cts_read()[:6]))
+        if (self.stat("learned"), self.stat("learned_ppb")) != learned:
+            self.fail("time zone change, short interval or step learned from, %d ppb" % self.stat("learned_ppb"))
+
+        syncs = self.stat("syncs")
+        for date in ((1999, 12, 31, 0, 0, 0), (2024, 13, 1, 0, 0, 0), (2024, 1, 0, 0, 0, 0),
+                     (2024, 1, 32, 0, 0, 0), (2024, 1, 1, 24, 0, 0), (2024, 1, 1, 0, 60, 0),
+                     (2024, 1, 1, 0, 0, 60), (2136, 1, 1, 0, 0, 0)):
+            if self.lib.cts_write(*date, 0, 0) != ctypes.c_int.in_dll(self.lib, "att_err_app_error").value:
+                self.fail("write of %s not rejected" % (date,))
+        if self.stat("syncs") != syncs:
+            self.fail("rejected writes counted as synchronizations")
+
+        # The RTC is divided for the RCX frequency the period rounds to
+        for period, expected in ((68267, 15000), (68266, 15000), (68300, 14993), (65536, 15625)):
+            hz = self.start(Rtc(), True, period)
+            if hz != expected:
+                self.fail("RTC divided for %d Hz with an RCX period of %d, not %d" % (hz, period, expected))
+        print("current time service: read, write, reference time and rejected dates")
+
+    def simulate(self, full):
+        """Runs the clock over the days, the writes are learned from with the full
+        correction, marked as time zone changes otherwise."""
+        args = self.args
+        rnd = random.Random(args.seed)
+        clock = Clock(args, rnd)
+        rtc = Rtc()
+        period = clock.period()
+        hz = self.start(rtc, clock.rcx, period if clock.rcx else 0)
+        expected_hz = (1024000000 + period // 2) // period if clock.rcx else 32768
+        if hz != expected_hz:
+            self.fail("RTC divided for %d Hz, not %d" % (hz, expected_hz))
+        clock.cfg_hz = hz or expected_hz
+
+        errors = []
+        raw = []
+        raw_ref = None
+        applied = period
+        rcx_updates = 0
+        syncs = 0
+        t = 0
+        next_sync = 0
+        next_cal = 0
+        start = int(args.start * 86400)
+        end = int(args.days * 86400)
+        while t <= end:
+            rtc.cs = clock.rtc
+            if clock.rcx and t >= next_cal:
+                period = clock.period(t)
+                self.lib.set_period(period)
+                next_cal += args.cal
+            # Every read of the RTC follows the last calibration
+            if clock.rcx and period != applied:
+                applied = period
+                rcx_updates += 1
+            if t >= next_sync:
+                # The client writes the true time to 1/256 s, off by the jitter
+                ticks = max(0, int((t + rnd.uniform(-args.jitter, args.jitter)) * 256))
+                self.cts_write(ticks // 256, ticks % 256, 0 if full else REASON_CHG_TIME_ZONE)
+                raw_ref = (int(rtc.cs), ticks // 256 * 100 + ticks % 256 * 100 // 256)
+                syncs += 1
+                next_sync += int(args.sync_days * 86400)
+            else:
+                now = self.now()
+                if t >= start:
+                    errors.append((now - t * 100) / 100.0)
+                    raw.append((raw_ref[1] + int(rtc.cs) - raw_ref[0] - t * 100) / 100.0)
+            clock.step(t, args.step)
+            t += args.step
+
+        stats = {name: self.stat(name) for name in ("reads", "date_decodes", "syncs", "learned", "rcx_updates",
+                                                     "learned_ppb", "rcx_ppb")}
+        reads = ctypes.c_int.in_dll(self.lib, "rtc_reads").value
+        if stats["reads"] != reads:
+            self.fail("%d reads of the RTC counted, %d made" % (stats["reads"], reads))
+        if stats["date_decodes"] != rtc.date_changes:
+            self.fail("%d calendar decodes counted, the date changed %d times" % (stats["date_decodes"], rtc.date_changes))
+        if stats["syncs"] != syncs:
+            self.fail("%d synchronizations counted, %d made" % (stats["syncs"], syncs))
+        if stats["rcx_updates"] != rcx_updates:
+            self.fail("%d changes of the RCX period counted, %d made" % (stats["rcx_updates"], rcx_updates))
+        learnable = syncs - 1 if args.sync_days * 86400 * 100 > LEARN_MIN else 0
+        if stats["learned"] != (learnable if full else 0):
+            self.fail("%d of %d synchronizations learned from%s"
+                      % (stats["learned"], syncs, "" if full else " while the time zone changed"))
+        return errors, raw, stats, clock
+
+    def check_accuracy(self):
+        args = self.args
+        rcx_err, raw_err, rcx_stats, clock = self.simulate(False)
+        full_err, _, full_stats, _ = self.simulate(True)
+        print("%.0f days, %s clock, RTC divided for %d Hz, sync every %.1f days +/- %.2f s"
+              % (args.days, args.clock.upper(), clock.cfg_hz, args.sync_days, args.jitter))
+        print()
+        print("%-6s %10s %10s %10s" % ("policy", "max err", "rms err", "rate"))
+        worst = {}
+        for name, errs, ppb in (("none", raw_err, 0),
+                                ("rcx", rcx_err, rcx_stats["rcx_ppb"]),
+                                ("full", full_err, full_stats["learned_ppb"] + full_stats["rcx_ppb"])):
+            worst[name] = max(abs(e) for e in errs)
+            rms = math.sqrt(sum(e * e for e in errs) / len(errs))
+            print("%-6s %8.2f s %8.2f s %7.1f ppm" % (name, worst[name], rms, ppb / 1000.0))
+        print()
+        print("learned from %d synchronizations, %.1f ppm, %d RTC reads, %d calendar decodes"
+              % (full_stats["learned"], full_stats["learned_ppb"] / 1000.0, full_stats["reads"],
+                 full_stats["date_decodes"]))
+        if worst["full"] > min(worst["none"], worst["rcx"]):
+            self.fail("the full correction is not the most accurate")
+        # The jitter of the writes is an error of the reference, no correction removes it
+        if (worst["full"] - args.jitter) * 5 > worst["none"] - args.jitter:
+            self.fail("the full correction is not 5 times better than none, beyond the jitter")
+
+
+class Clock:
+    """Low power clock and its RTC, rates relative to the true time."""
+
+    def __init__(self, args, rnd):
+        self.args = args
+        self.rnd = rnd
+        self.temp = 25.0
+        self.walk = 0.0
+        self.rcx = args.clock == "rcx"
+        self.f0 = 15000.0 if self.rcx else 32768.0
+        self.cfg_hz = 32768
+        self.rtc = 0.0
+
+    def error(self, t):
+        """Relative frequency error at t seconds."""
+        a = self.args
+        dt = self.temp - 25.0
+        if self.rcx:
+            return (a.offset + a.tempco * dt) * 1e-6
+        return (a.offset - 0.035 * dt * dt) * 1e-6
+
+    def freq(self, t):
+        return self.f0 * (1.0 + self.error(t))
+
+    def step(self, t, dt):
+        a = self.args
+        self.walk += self.rnd.gauss(0, a.walk * math.sqrt(dt / 86400.0))
+        self.walk *= 0.999
+        self.temp = 25.0 + a.swing * math.sin(2 * math.pi * t / 86400.0) + self.walk
+        self.rtc += dt * 100.0 * self.freq(t) / self.cfg_hz
+
+    def period(self, t=0.0):
+        """Calibration of the RCX against the 16 MHz crystal, rcx_time_data.rcx_period."""
+        f = self.freq(t) * (1.0 + self.args.xtal16 * 1e-6)
+        return int(round(1024e6 / f * (1.0 + self.rnd.gauss(0, self.args.cal_noise * 1e-6))))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--clock", choices=("rcx", "xtal"), default="rcx")
+    parser.add_argument("--days", type=float, default=90.0)
+    parser.add_argument("--start", type=float, default=15.0, help="days before the errors count")
+    parser.add_argument("--sync-days", type=float, default=3.0, help="interval of the CTS writes")
+    parser.add_argument("--jitter", type=float, default=0.5, help="error of the CTS writes (s)")
+    parser.add_argument("--offset", type=float, default=None,
+                        help="rate error at 25 C (ppm), default 0 for the RCX, 20 for the XTAL")
+    parser.add_argument("--tempco", type=float, default=50.0, help="RCX rate error per degree (ppm)")
+    parser.add_argument("--swing", type=float, default=4.0, help="daily temperature swing (C)")
+    parser.add_argument("--walk", type=float, default=2.0, help="slow temperature walk (C per sqrt day)")
+    parser.add_argument("--xtal16", type=float, default=15.0, help="error of the 16 MHz crystal (ppm)")
+    parser.add_argument("--cal", type=int, default=600, help="interval of the RCX calibrations (s)")
+    parser.add_argument("--cal-noise", type=float, default=3.0, help="noise of a calibration (ppm)")
+    parser.add_argument("--step", type=int, default=60, help="simulation step (s)")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+    if args.offset is None:
+        args.offset = 0.0 if args.clock == "rcx" else 20.0
+
+    test = Test(args)
+    test.check_calendar()
+    test.check_time_of_day()
+    test.check_drift()
+    test.check_cts()
+    print()
+    test.check_accuracy()
+
+    return host_c.report(test.failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,740 @@
+#!/usr/bin/env python3
+"""
+PTY loopback of the batched UART transport (uart_eif.c) of the hci project.
+
+uart_eif.c is built unmodified against stub headers which emulate UART1 and its receive
+and transmit DMA channels on the slave side of a Linux pseudo terminal, at the configured
+baud rate and with RTS flow control. A small H4 transport on top of it reads the packet
+type, the ACL header and the payload and echoes every packet back, as the H4TL would with
+a loopback command. The host writes ACL packets of random length on the master side with
+a window of outstanding packets, checks the echoes and reports packets per second,
+throughput and round trip latency. The host holds CTS from time to time, so that the
+device has to stop it with RTS before the ring buffer overflows.
+
+A second check queues transmissions, masks the interrupts and calls
+uart_eif_finish_transfers_func(), as done before sleep. It must return with every queued
+byte sent, and the transport callbacks must follow once the interrupts are unmasked.
+
+    uart_eif_loopback.py
+    uart_eif_loopback.py --baud 115200 --packets 500 --max-len 64 --window 4
+"""
+
+import argparse
+import ctypes
+import os
+import random
+import select
+import signal
+import sys
+import threading
+import time
+import tty
+
+import host_c
+
+DRIVER = os.path.join(host_c.SDK_SRC, "platform", "driver", "uart")
+UART_EIF_TX_BUF_SIZE = 264
+
+STUBS = {
+    "compiler.h": """
+#ifndef COMPILER_H_
+#define COMPILER_H_
+#define __SECTION_ZERO(sec)
+#endif
+""",
+    "ll.h": """
+#ifndef LL_H_
+#define LL_H_
+#include "uart.h"
+#define GLOBAL_INT_DISABLE()    do { irq_lock++;
+#define GLOBAL_INT_RESTORE()    irq_lock--; } while (0)
+#endif
+""",
+    "co_math.h": """
+#ifndef CO_MATH_H_
+#define CO_MATH_H_
+#define co_min(a, b)            (((a) < (b)) ? (a) : (b))
+#endif
+""",
+    "rwip.h": """
+#ifndef RWIP_H_
+#define RWIP_H_
+#include <stdint.h>
+typedef void (*rwip_eif_callback) (uint8_t);
+enum { RWIP_EIF_STATUS_OK, RWIP_EIF_STATUS_ERROR };
+#endif
+""",
+    "dma.h": """
+#ifndef DMA_H_
+#define DMA_H_
+#include <stdint.h>
+#include <stdbool.h>
+typedef enum { DMA_CHANNEL_0 = 0x00, DMA_CHANNEL_1 = 0x10, DMA_CHANNEL_2 = 0x20, DMA_CHANNEL_3 = 0x30 } DMA_ID;
+#define DMA_CH_GET(id)          ((id & 0x70) >> 4)
+enum { DMA_BW_BYTE, DMA_IRQ_STATE_DISABLED = 0, DMA_IRQ_STATE_ENABLED = 1, DMA_DREQ_TRIGGERED, DMA_INC_FALSE,
+       DMA_INC_TRUE, DMA_MODE_NORMAL = 0, DMA_MODE_CIRCULAR = 1, DMA_IDLE_BLOCKING_MODE, DMA_INIT_AX_BX_AY_BY,
+       DMA_SENSE_LEVEL_SENSITIVE, DMA_TRIG_UART_RXTX };
+typedef void (*dma_cb_t)(void *user_data, uint16_t len);
+typedef struct
+{
+    int bus_width, irq_enable, dreq_mode, src_inc, dst_inc, circular, dma_prio, dma_idle, dma_init,
+        dma_sense, dma_req_mux;
+    uint32_t src_address;
+    uintptr_t dst_address;
+    uint16_t length;
+    uint16_t irq_nr_of_trans;
+    dma_cb_t cb;
+    void *user_data;
+} dma_cfg_t;
+void dma_initialize(DMA_ID id, dma_cfg_t *dma_cfg);
+void dma_channel_start(DMA_ID id, int irq_en);
+void dma_channel_stop(DMA_ID id);
+void dma_set_int(DMA_ID id, uint16_t int_ix);
+uint16_t dma_get_idx(DMA_ID id);
+uint16_t dma_get_int_status(void);
+void dma_clear_int_reg(DMA_ID id);
+#endif
+""",
+    "uart.h": """
+#ifndef UART_H_
+#define UART_H_
+#include <stdint.h>
+#include <stdbool.h>
+typedef struct { uint16_t UART_RBR_THR_DLL_REGF; } uart_t;
+extern uart_t uart1_regs;
+extern int irq_lock;
+#define UART1                   (&uart1_regs)
+#define UART_IRQn               1
+#define UART_BIT_DIS            0
+#define UART_BIT_EN             1
+#define UART_INT_RECEIVE_LINE_STAT 6
+typedef enum { UART_OP_BLOCKING, UART_OP_INTR, UART_OP_DMA } UART_OP_CFG;
+enum { UART_DMA_CHANNEL_01 = 0, UART_DMA_CHANNEL_23 = 1 };
+typedef void (*uart_cb_t)(uint16_t length);
+typedef struct
+{
+    int uart_dma_channel;
+    int uart_dma_priority;
+    uint32_t intr_priority;
+} uart_cfg_t;
+void uart_initialize(uart_t *uart_id, const uart_cfg_t *uart_cfg);
+void uart_register_tx_cb(uart_t *uart_id, uart_cb_t cb);
+void uart_send(uart_t *uart_id, const uint8_t *data, uint16_t len, UART_OP_CFG op);
+void uart_wait_tx_finish(uart_t *uart_id);
+void uart_rtsn_setf(uart_t *uart_id, int en);
+void uart_dmasa_setf(uart_t *uart_id, int en);
+void uart_rls_intr_setf(uart_t *uart_id, int en);
+int uart_intr_id_getf(uart_t *uart_id);
+int uart_rls_error_getf(uart_t *uart_id);
+uint16_t uart_tx_empty_getf(uart_t *uart_id);
+void NVIC_SetPendingIRQ(int irq);
+void NVIC_SetPriority(int irq, uint32_t prio);
+void NVIC_EnableIRQ(int irq);
+#define ASSERT_ERROR(x)         do { if (!(x)) assert_errors++; } while (0)
+extern int assert_errors;
+#endif
+""",
+}
+
+HARNESS = r"""
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include "uart_eif.c"
+
+/* Emulated UART1 and DMA */
+
+uart_t uart1_regs;
+int irq_lock;
+int assert_errors;
+
+struct dma_ch
+{
+    bool on;
+    bool circular;
+    bool irq;
+    uint8_t *buf;
+    uint16_t len;
+    uint16_t idx;
+    uint16_t int_ix;
+    dma_cb_t cb;
+    void *user_data;
+};
+
+static struct dma_ch dma[4];
+static uint16_t dma_status;
+static uart_cb_t uart_tx_cb;
+static bool uart_pending;
+static bool rts;
+static int fd = -1;
+static double byte_time;
+static double rx_credit_t, tx_credit_t;
+static volatile int stop;
+
+/* CTS driven by the host, honoured by the UART auto flow control */
+volatile int cts = 1;
+
+/* Statistics, read by the host */
+struct stats
+{
+    uint32_t rx_bytes;
+    uint32_t tx_bytes;
+    uint32_t tx_transfers;
+    uint32_t handler_calls;
+    uint32_t rts_off;
+    uint32_t overruns;
+    uint32_t max_used;
+    uint32_t dma_irqs;
+};
+
+struct stats stats;
+int irq_masked;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void dma_initialize(DMA_ID id, dma_cfg_t *cfg)
+{
+    struct dma_ch *ch = &dma[DMA_CH_GET(id)];
+
+    memset(ch, 0, sizeof(*ch));
+    ch->circular = cfg->circular;
+    ch->len = cfg->length;
+    ch->int_ix = cfg->irq_nr_of_trans ? cfg->irq_nr_of_trans : cfg->length;
+    ch->cb = cfg->cb;
+    ch->user_data = cfg->user_data;
+}
+
+void dma_channel_start(DMA_ID id, int irq_en)
+{
+    dma[DMA_CH_GET(id)].irq = irq_en;
+    dma[DMA_CH_GET(id)].on = true;
+}
+
+void dma_channel_stop(DMA_ID id)
+{
+    dma[DMA_CH_GET(id)].on = false;
+    dma[DMA_CH_GET(id)].irq = false;
+}
+
+void dma_set_int(DMA_ID id, uint16_t int_ix)
+{
+    dma[DMA_CH_GET(id)].int_ix = int_ix;
+}
+
+uint16_t dma_get_idx(DMA_ID id)
+{
+    return dma[DMA_CH_GET(id)].idx;
+}
+
+void dma_clear_int_reg(DMA_ID id)
+{
+    dma_status &= ~(1 << DMA_CH_GET(id));
+}
+
+static void tx_dma_done(void *user_data, uint16_t len)
+{
+    if (uart_tx_cb != NULL)
+    {
+        uart_tx_cb(len);
+    }
+}
+
+void uart_initialize(uart_t *uart_id, const uart_cfg_t *uart_cfg)
+{
+    dma_cfg_t cfg = {0};
+
+    cfg.length = 1;
+    dma_initialize(uart_cfg->uart_dma_channel == UART_DMA_CHANNEL_01 ? DMA_CHANNEL_1 : DMA_CHANNEL_3, &cfg);
+}
+
+void uart_register_tx_cb(uart_t *uart_id, uart_cb_t cb)
+{
+    uart_tx_cb = cb;
+}
+
+void uart_send(uart_t *uart_id, const uint8_t *data, uint16_t len, UART_OP_CFG op)
+{
+    struct dma_ch *ch = &dma[1];
+
+    if (ch->on)
+    {
+        assert_errors++;
+    }
+    ch->buf = (uint8_t *) data;
+    ch->len = len;
+    ch->int_ix = len;
+    ch->idx = 0;
+    ch->cb = tx_dma_done;
+    ch->on = true;
+    ch->irq = true;
+    stats.tx_transfers++;
+}
+
+void uart_rtsn_setf(uart_t *uart_id, int en)
+{
+    if (rts && !en)
+    {
+        stats.rts_off++;
+    }
+    rts = en;
+}
+
+void uart_dmasa_setf(uart_t *uart_id, int en) {}
+void uart_rls_intr_setf(uart_t *uart_id, int en) {}
+int uart_intr_id_getf(uart_t *uart_id) { return 0; }
+int uart_rls_error_getf(uart_t *uart_id) { return 0; }
+void NVIC_SetPriority(int irq, uint32_t prio) {}
+void NVIC_EnableIRQ(int irq) {}
+
+void NVIC_SetPendingIRQ(int irq)
+{
+    uart_pending = true;
+}
+
+/* Move the bytes the line allows since the last step, 16 at most per direction as the
+   UART FIFOs. RTS is sampled before each byte received. */
+static void hw_step(void)
+{
+    double t = now();
+    struct dma_ch *rx = &dma[0];
+    struct dma_ch *tx = &dma[1];
+    uint8_t b[16];
+    int n;
+
+    if (rx_credit_t > t)
+    {
+        rx_credit_t = t;
+    }
+    if (rx->on && rts && (t - rx_credit_t) >= byte_time)
+    {
+        n = (int) ((t - rx_credit_t) / byte_time);
+        n = read(fd, b, n < 16 ? n : 16);
+        if (n > 0)
+        {
+            uint16_t used;
+
+            rx_credit_t += n * byte_time;
+            for (int i = 0; i < n; i++)
+            {
+                if (((rx->idx + 1 - uart_eif_env.rx_out) & (rx->len - 1)) == 0)
+                {
+                    stats.overruns++;
+                }
+                rx->buf[rx->idx++] = b[i];
+                if (rx->idx == rx->int_ix)
+                {
+                    dma_status |= 1;
+                }
+                if (rx->idx == rx->len)
+                {
+                    rx->idx = 0;
+                }
+            }
+            stats.rx_bytes += n;
+            used = (rx->idx - uart_eif_env.rx_out) & (rx->len - 1);
+            if (used > stats.max_used)
+            {
+                stats.max_used = used;
+            }
+        }
+        else
+        {
+            rx_credit_t = t;
+        }
+    }
+
+    if (tx_credit_t > t)
+    {
+        tx_credit_t = t;
+    }
+    if (!cts)
+    {
+        tx_credit_t = t;
+    }
+    else if (tx->on && (tx->idx < tx->len) && (t - tx_credit_t) >= byte_time)
+    {
+        n = (int) ((t - tx_credit_t) / byte_time);
+        n = n < 16 ? n : 16;
+        n = n < (tx->len - tx->idx) ? n : (tx->len - tx->idx);
+        n = write(fd, &tx->buf[tx->idx], n);
+        if (n > 0)
+        {
+            tx_credit_t += n * byte_time;
+            tx->idx += n;
+            stats.tx_bytes += n;
+            if (tx->idx == tx->int_ix)
+            {
+                dma_status |= 2;
+            }
+        }
+    }
+}
+
+uint16_t dma_get_int_status(void)
+{
+    hw_step();
+    return dma_status;
+}
+
+uint16_t uart_tx_empty_getf(uart_t *uart_id)
+{
+    hw_step();
+    return !dma[1].on || (dma[1].idx == dma[1].len);
+}
+
+void uart_wait_tx_finish(uart_t *uart_id)
+{
+    while (!uart_tx_empty_getf(uart_id));
+}
+
+/* Interrupt dispatch, as DMA_Handler() and the UART1 handler */
+static bool dispatch(void)
+{
+    bool busy = false;
+
+    if (irq_masked || irq_lock)
+    {
+        return false;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        struct dma_ch *ch = &dma[i];
+
+        if ((dma_status & (1 << i)) && ch->irq)
+        {
+            dma_status &= ~(1 << i);
+            if (!ch->circular && (ch->int_ix == ch->len))
+            {
+                ch->on = false;
+            }
+            stats.dma_irqs++;
+            ch->cb(ch->user_data, ch->int_ix);
+            busy = true;
+        }
+    }
+    if (uart_pending)
+    {
+        uart_pending = false;
+        stats.handler_calls++;
+        uart_eif_handler_func();
+        busy = true;
+    }
+    return busy;
+}
+
+/* H4 transport echoing ACL packets */
+
+#define PKT_MAX     (5 + 1024)
+#define QUEUE_LEN   8
+
+static uint8_t queue[QUEUE_LEN][PKT_MAX];
+static int q_in, q_out, q_cnt;
+static bool writing, rx_stalled;
+
+static void read_type(void);
+
+static void write_done(uint8_t status)
+{
+    writing = false;
+    q_out = (q_out + 1) % QUEUE_LEN;
+    q_cnt--;
+    if (q_cnt)
+    {
+        uint8_t *p = queue[q_out];
+
+        writing = true;
+        uart_eif_write_func(p, 5 + (p[3] | (p[4] << 8)), write_done);
+    }
+    if (rx_stalled)
+    {
+        rx_stalled = false;
+        read_type();
+    }
+}
+
+static void payload_done(uint8_t status)
+{
+    uint8_t *p = queue[q_in];
+
+    q_in = (q_in + 1) % QUEUE_LEN;
+    q_cnt++;
+    if (!writing)
+    {
+        writing = true;
+        uart_eif_write_func(p, 5 + (p[3] | (p[4] << 8)), write_done);
+    }
+    if (q_cnt < QUEUE_LEN)
+    {
+        read_type();
+    }
+    else
+    {
+        rx_stalled = true;
+    }
+}
+
+static void header_done(uint8_t status)
+{
+    uint16_t len = queue[q_in][3] | (queue[q_in][4] << 8);
+
+    if (len == 0)
+    {
+        payload_done(status);
+    }
+    else
+    {
+        uart_eif_read_func(&queue[q_in][5], len, payload_done);
+    }
+}
+
+static void type_done(uint8_t status)
+{
+    uart_eif_read_func(&queue[q_in][1], 4, header_done);
+}
+
+static void read_type(void)
+{
+    uart_eif_read_func(&queue[q_in][0], 1, type_done);
+}
+
+void start(int pty_fd, int baud, int dma_channel)
+{
+    uart_cfg_t cfg = {0};
+
+    fd = pty_fd;
+    byte_time = 10.0 / baud;
+    rx_credit_t = tx_credit_t = now();
+    cfg.uart_dma_channel = dma_channel;
+    uart_eif_init(&cfg);
+    // The 32-bit DMA address of the ring buffer is truncated on the host
+    dma[0].buf = uart_eif_rx_ring;
+}
+
+void echo(void)
+{
+    read_type();
+    while (!stop)
+    {
+        bool busy = dispatch();
+
+        hw_step();
+        if (!busy && !dispatch())
+        {
+            usleep(20);
+        }
+    }
+}
+
+void halt(void)
+{
+    stop = 1;
+}
+
+/* Queue writes, then finish the transfers with the interrupts masked */
+
+static int cb_calls;
+
+static void count_cb(uint8_t status)
+{
+    cb_calls++;
+}
+
+int finish_check(uint8_t *a, int a_len, uint8_t *b, int b_len)
+{
+    int calls;
+
+    // a is sent by the DMA, b is queued during the transmission of a
+    uart_eif_write_func(a, a_len, count_cb);
+    while (dispatch());
+    uart_eif_write_func(b, b_len, count_cb);
+    while (dispatch());
+
+    irq_masked = 1;
+    uart_eif_finish_transfers_func();
+    if (uart_eif_env.tx_busy || uart_eif_env.tx_fill_len || dma[1].on || (dma_status & 2))
+    {
+        return -1;
+    }
+    irq_masked = 0;
+
+    calls = cb_calls;
+    while (dispatch());
+    return calls * 10 + cb_calls;
+}
+"""
+
+
+class Stats(ctypes.Structure):
+    _fields_ = [(n, ctypes.c_uint32) for n in ("rx_bytes", "tx_bytes", "tx_transfers", "handler_calls", "rts_off",
+                                                "overruns", "max_used", "dma_irqs")]
+
+
+def build():
+    # Copied next to the stubs, so that uart_eif.h includes the stub uart.h
+    tmp = host_c.stage("uart_eif_loopback", HARNESS, stubs=STUBS,
+                       copies=[os.path.join(DRIVER, name) for name in ("uart_eif.c", "uart_eif.h")])
+    return host_c.compile_lib(tmp, "uart_eif", defines={"CFG_UART_BATCHED_EIF": None, "CFG_UART1_SDK": None,
+                                                        "CFG_UART_DMA_SUPPORT": None}, load=False)
+
+
+def open_pty():
+    master, slave = os.openpty()
+    tty.setraw(master)
+    tty.setraw(slave)
+    os.set_blocking(slave, False)
+    return master, slave
+
+
+def acl(rnd, seq, max_len):
+    n = rnd.randint(0, max_len)
+    payload = seq.to_bytes(4, "little")[:n] + bytes(rnd.getrandbits(8) for _ in range(max(n - 4, 0)))
+    return bytes([0x02, seq & 0xFF, (seq >> 8) & 0x0F]) + n.to_bytes(2, "little") + payload
+
+
+def loopback(so, args):
+    lib = ctypes.CDLL(so)
+    master, slave = open_pty()
+    lib.start(slave, args.baud, 0)
+    device = threading.Thread(target=lib.echo)
+    device.start()
+
+    cts = ctypes.c_int.in_dll(lib, "cts")
+    stall_end = None
+    next_stall = args.stall_every
+    rnd = random.Random(args.seed)
+    failures = []
+    sent = []
+    latencies = []
+    rx = b""
+    out = b""
+    next_pkt = 0
+    done = 0
+    t0 = time.monotonic()
+    deadline = t0 + args.timeout
+    while done < args.packets and time.monotonic() < deadline:
+        while next_pkt < args.packets and next_pkt - done < args.window:
+            pkt = acl(rnd, next_pkt, args.max_len)
+            sent.append((pkt, time.monotonic()))
+            out += pkt
+            next_pkt += 1
+        # The host stops the echoes with CTS from time to time, the device must then stop
+        # the host with RTS before its ring buffer overflows
+        if stall_end is None and args.stall_every and done >= next_stall:
+            cts.value = 0
+            stall_end = time.monotonic() + args.stall_ms / 1000.0
+            next_stall += args.stall_every
+        elif stall_end is not None and time.monotonic() >= stall_end:
+            cts.value = 1
+            stall_end = None
+        r, w, _ = select.select([master], [master] if out else [], [], 0.005)
+        if w:
+            out = out[os.write(master, out):]
+        if r:
+            rx += os.read(master, 65536)
+        while len(rx) >= 5 and len(rx) >= 5 + int.from_bytes(rx[3:5], "little"):
+            n = 5 + int.from_bytes(rx[3:5], "little")
+            pkt, t = sent[done]
+            if rx[:n] != pkt:
+                diff = next((i for i, (x, y) in enumerate(zip(rx[:n], pkt)) if x != y), min(n, len(pkt)))
+                failures.append("packet %d of %d bytes echoed with a difference at byte %d" % (done, len(pkt), diff))
+                deadline = 0
+                break
+            latencies.append(time.monotonic() - t)
+            rx = rx[n:]
+            done += 1
+    elapsed = time.monotonic() - t0
+    lib.halt()
+    device.join()
+    os.close(master)
+    os.close(slave)
+
+    stats = Stats.in_dll(lib, "stats")
+    if done < args.packets and not failures:
+        failures.append("%d of %d packets echoed in %.0fs" % (done, args.packets, args.timeout))
+    if stats.overruns:
+        failures.append("%d bytes overwritten in the ring buffer" % stats.overruns)
+    if ctypes.c_int.in_dll(lib, "assert_errors").value:
+        failures.append("assertion failed or DMA transfer started while busy")
+
+    latencies.sort()
+    if latencies:
+        line = 10.0 / args.baud
+        print("%d packets in %.2fs: %.0f packets/s, %.1f kB/s each way (line %.1f kB/s)"
+              % (done, elapsed, done / elapsed, stats.rx_bytes / elapsed / 1000, 1 / line / 1000))
+        print("round trip latency: median %.2fms, 99%% %.2fms, max %.2fms"
+              % (latencies[len(latencies) // 2] * 1e3, latencies[len(latencies) * 99 // 100] * 1e3,
+                 latencies[-1] * 1e3))
+        print("%.2f handler calls per packet, %d DMA transmissions, %d RTS deasserts, ring max %d bytes"
+              % (stats.handler_calls / done, stats.tx_transfers,
+                 stats.rts_off, stats.max_used))
+    return failures
+
+
+def finish_masked(so, args, a_len, b_len):
+    """Queue a and b and finish with the interrupts masked, in a child process as a busy
+    wait on the interrupts never returns."""
+    failures = []
+    master, slave = open_pty()
+    a = bytes(i & 0xFF for i in range(a_len))
+    b = bytes((i * 7) & 0xFF for i in range(b_len))
+    pid = os.fork()
+    if pid == 0:
+        signal.alarm(5)
+        lib = ctypes.CDLL(so)
+        lib.finish_check.argtypes = [ctypes.c_char_p, ctypes.c_int, ctypes.c_char_p, ctypes.c_int]
+        lib.start(slave, args.baud, 0)
+        os._exit(lib.finish_check(a, len(a), b, len(b)) & 0xFF)
+    _, status = os.waitpid(pid, 0)
+    os.set_blocking(master, False)
+    try:
+        data = os.read(master, 65536)
+    except BlockingIOError:
+        data = b""
+    os.close(master)
+    os.close(slave)
+
+    what = "%d+%d bytes: " % (a_len, b_len)
+    if os.WIFSIGNALED(status):
+        return [what + "uart_eif_finish_transfers_func() does not return with the interrupts masked"]
+    code = os.WEXITSTATUS(status)
+    if code == 0xFF:
+        failures.append(what + "transmission still ongoing after uart_eif_finish_transfers_func()")
+    # Writes longer than a transmit buffer are completed by the handler once sent
+    expected = (2 if a_len <= UART_EIF_TX_BUF_SIZE else 1) * 10 + 2
+    if code != 0xFF and code != expected:
+        failures.append(what + "%d write callbacks before and %d after unmasking the interrupts, expected %d and %d"
+                        % (code // 10, code % 10 - code // 10, expected // 10, expected % 10 - expected // 10))
+    if data != a + b:
+        failures.append(what + "%d of %d bytes sent before sleep" % (len(data), len(a + b)))
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=host_c.description(__doc__))
+    parser.add_argument("--baud", type=int, default=1000000)
+    parser.add_argument("--packets", type=int, default=2000)
+    parser.add_argument("--max-len", type=int, default=251, help="longest ACL payload")
+    parser.add_argument("--window", type=int, default=16, help="packets sent ahead of the echoes")
+    parser.add_argument("--stall-every", type=int, default=500, help="packets between host CTS stalls, 0 for none")
+    parser.add_argument("--stall-ms", type=float, default=50, help="CTS stall duration")
+    parser.add_argument("--timeout", type=float, default=60)
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    so = build()
+    failures = loopback(so, args)
+    for a_len, b_len in ((200, 60), (300, 150)):
+        failures += finish_masked(so, args, a_len, b_len)
+
+    return host_c.report(failures)
+
+
+if __name__ == "__main__":
+    sys.exit(main())